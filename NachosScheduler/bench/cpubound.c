@@ -0,0 +1,19 @@
+/* cpubound.c
+ *	A job for the scheduler benchmark (build.linux/bench.sh) that
+ *	only computes, in one long CPU burst.
+ */
+
+#include "syscall.h"
+
+#define WORK 4000
+
+int
+main()
+{
+    int i, sum;
+
+    sum = 0;
+    for (i = 0; i < WORK; i++)
+	sum += i;
+    PrintInt(sum);
+}
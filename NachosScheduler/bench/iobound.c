@@ -0,0 +1,23 @@
+/* iobound.c
+ *	A job for the scheduler benchmark (build.linux/bench.sh) that
+ *	mostly waits: short CPU bursts, each followed by console output
+ *	and a sleep, as a program doing I/O would.
+ */
+
+#include "syscall.h"
+
+#define ROUNDS 8
+#define WORK 50
+#define WAIT 300
+
+int
+main()
+{
+    int i, j;
+
+    for (i = 0; i < ROUNDS; i++) {
+	for (j = 0; j < WORK; j++);
+	PutString("io\n");
+	Sleep(WAIT);
+    }
+}
@@ -0,0 +1,23 @@
+/* nicer.c
+ *	A job for the scheduler benchmark (build.linux/bench.sh) that
+ *	keeps changing its own priority between bursts, moving it
+ *	between the scheduler's queues.
+ */
+
+#include "syscall.h"
+
+#define ROUNDS 10
+#define WORK 300
+
+int
+main()
+{
+    int i, j, priority;
+
+    priority = 30;
+    for (i = 0; i < ROUNDS; i++) {
+	Nice(priority);
+	for (j = 0; j < WORK; j++);
+	priority = (priority + 47) % 150;
+    }
+}
@@ -0,0 +1,205 @@
+#!/bin/bash
+#
+# bench.sh
+#	The scheduler benchmark.  Generates job lists (see
+#	threads/workload.h) of the programs in ../bench, runs each under
+#	nachos built with every scheduling policy named, and compares the
+#	runs with the ones recorded in ../bench/golden:
+#
+#	  - the schedule, every "Thread N ProcessXxx tick" line, must be
+#	    the same;
+#	  - the quality of the schedule -- jobs finished per simulated
+#	    second, and their average and 99th percentile turnaround --
+#	    must be no worse than QUALITY_SLACK percent;
+#	  - the host must take no more than SPEED_SLACK percent longer per
+#	    simulated second, over all the workloads of a policy (the
+#	    fastest of REPEATS runs of each counts).
+#
+#	Any of these failing fails the benchmark.  A simulated second is
+#	TICKS_PER_SECOND ticks, a user instruction a tick.  Host times
+#	only compare on the machine they were recorded on.
+#
+#	"make bench" builds nachos.<policy> for every policy and runs
+#	this; "make bench-update" runs it with -u, to record the results
+#	as the new golden ones, after a change that is meant to alter
+#	them.  The jobs are built in ../bench.
+#
+# Usage: ./bench.sh [-u] policy...
+#
+#	The workloads are made of JOBS jobs, arriving SPACING ticks
+#	apart on average, with random choices drawn from SEED; change
+#	any of these and the golden results must be recorded again.
+#
+#	    cpu		CPU-bound jobs, at one priority
+#	    io		I/O-bound jobs, at one priority
+#	    mixed	both kinds, at random priorities and arrivals
+#	    nice	jobs that keep changing their own priority
+
+JOBS=${JOBS:-8}
+SPACING=${SPACING:-100}
+SEED=${SEED:-1}
+REPEATS=${REPEATS:-5}
+QUALITY_SLACK=${QUALITY_SLACK:-5}
+SPEED_SLACK=${SPEED_SLACK:-25}
+TICKS_PER_SECOND=1000000
+
+BENCH=${BENCH:-../bench}
+GOLDEN=$BENCH/golden
+WORK=bench.out
+WORKLOADS="cpu io mixed nice"
+
+update=0
+if [ "$1" == "-u" ]; then
+    update=1
+    shift
+fi
+if [ $# -eq 0 ]; then
+    echo "Usage: $0 [-u] policy..."
+    exit 2
+fi
+mkdir -p $WORK $GOLDEN
+
+# generate workload name file
+#	Write the job list of a workload.  The random numbers are the
+#	Park-Miller generator's, so that every awk draws the same ones.
+generate() {
+    awk -v workload=$1 -v n=$JOBS -v gap=$SPACING -v seed=$SEED \
+        -v bench=$BENCH '
+    function random() { seed = (seed * 16807) % 2147483647; return seed / 2147483647 }
+    BEGIN {
+        tick = 0
+        for (i = 0; i < n; i++) {
+            if (workload == "cpu") {
+                job = "cpubound"; priority = 75; next_gap = gap
+            } else if (workload == "io") {
+                job = "iobound"; priority = 75; next_gap = gap
+            } else {
+                if (workload == "mixed") {
+                    job = (random() < 0.5) ? "cpubound" : "iobound"
+                } else {
+                    job = "nicer"
+                }
+                priority = int(random() * 150)
+                next_gap = int(random() * 2 * gap)
+            }
+            printf "%d,%s/%s,%d\n", tick, bench, job, priority
+            tick += next_gap
+        }
+    }' > $2
+}
+
+# measure output
+#	Print a run's jobs per simulated second, and their average and
+#	99th percentile turnaround.
+measure() {
+    awk -v second=$TICKS_PER_SECOND '
+    /^Ticks: total/ { ticks = $3 + 0 }
+    /^Thread [0-9]+ \(.*\): turnaround/ && $2 != "0" {
+        t = $5 + 0
+        for (i = n; i > 0 && turnaround[i - 1] > t; i--) {
+            turnaround[i] = turnaround[i - 1]
+        }
+        turnaround[i] = t; sum += t; n++
+    }
+    END {
+        if (n == 0 || ticks == 0) { print "0 0 0"; exit }
+        p99 = int(0.99 * n + 0.999999) - 1
+        printf "%.2f %.1f %d\n", n * second / ticks, sum / n,
+               turnaround[p99]
+    }' $1
+}
+
+# ticks output
+#	Print how many ticks a run simulated.
+ticks() {
+    awk '/^Ticks: total/ { print $3 + 0 }' $1
+}
+
+# compare old new
+#	Print what got worse from the old measurements to the new ones:
+#	the quality ones, or the host speed, if that is all there is.
+compare() {
+    echo "$1 $2" | awk -v quality=$QUALITY_SLACK -v speed=$SPEED_SLACK '
+    NF == 2 { if ($2 > $1 * (1 + speed / 100)) print " host-speed"; exit }
+    {
+        worse = ""
+        if ($4 < $1 * (1 - quality / 100)) worse = worse " throughput"
+        if ($5 > $2 * (1 + quality / 100)) worse = worse " average"
+        if ($6 > $3 * (1 + quality / 100)) worse = worse " p99"
+        print worse
+    }'
+}
+
+# check name
+#	Compare $WORK/name.* with the golden ones, or record them with
+#	-u, setting "result" to what was found and "failed" if it's bad.
+check() {
+    result=""
+    if [ $update -eq 1 ]; then
+        cp $WORK/$1.stats $GOLDEN/
+        if [ -f $WORK/$1.trace ]; then
+            cp $WORK/$1.trace $GOLDEN/
+        fi
+        result=recorded
+    elif [ ! -f $GOLDEN/$1.stats ]; then
+        result="no golden run; make bench-update"
+    else
+        worse=$(compare "$(cat $GOLDEN/$1.stats)" "$(cat $WORK/$1.stats)")
+        if [ -f $WORK/$1.trace ] &&
+           ! cmp -s $WORK/$1.trace $GOLDEN/$1.trace; then
+            result="schedule changed"
+            failed=1
+        fi
+        if [ -n "$worse" ]; then
+            result="${result:+$result; }worse:$worse"
+            failed=1
+        fi
+    fi
+    result=${result:-ok}
+}
+
+failed=0
+printf "%-10s %-6s %10s %10s %10s  %s\n" policy load "jobs/sim-s" \
+       avg-turn p99-turn result
+for workload in $WORKLOADS; do
+    generate $workload $WORK/$workload.jobs
+done
+for policy in "$@"; do
+    if [ ! -x ./nachos.$policy ]; then
+        echo "$0: no nachos.$policy; run \"make bench\""
+        exit 2
+    fi
+    totalWall=0
+    totalTicks=0
+    for workload in $WORKLOADS; do
+        run=$WORK/$policy-$workload
+        best=0
+        for ((r = 0; r < REPEATS; r++)); do
+            start=$(date +%s%N)
+            ./nachos.$policy --test $WORK/$workload.jobs > $run.out 2>&1
+            wall=$(($(date +%s%N) - start))
+            if [ $best -eq 0 ] || [ $wall -lt $best ]; then
+                best=$wall
+            fi
+        done
+        totalWall=$((totalWall + best))
+        totalTicks=$((totalTicks + $(ticks $run.out)))
+        grep -E $'^Thread [0-9]+\tProcess' $run.out > $run.trace
+        measure $run.out > $run.stats
+        check $policy-$workload
+        printf "%-10s %-6s %10s %10s %10s  %s\n" $policy $workload \
+               $(cat $run.stats) "$result"
+        if [ "$result" != "${result#schedule changed}" ]; then
+            diff $GOLDEN/$policy-$workload.trace $run.trace | head -5
+        fi
+    done
+
+    # the host's speed, in milliseconds per simulated second
+    echo $totalWall $totalTicks | awk -v second=$TICKS_PER_SECOND \
+        '{ printf "%.3f\n", ($1 / 1000000) / ($2 / second) }' \
+        > $WORK/$policy-speed.stats
+    check $policy-speed
+    printf "%-10s %-6s %10s %s  %s\n" $policy host "" \
+           "$(cat $WORK/$policy-speed.stats) ms per simulated second" "$result"
+done
+exit $failed
@@ -0,0 +1,135 @@
+#!/bin/bash
+#
+# sweep.sh
+#	Run nachos over a grid of tuning parameters (see -cf in
+#	threads/main.cc): once for every combination of the values
+#	given, as many runs at a time as the host has cores, and gather
+#	each run's statistics into one table of a line per run.
+#
+#	Each run is a separate nachos process, run in this directory
+#	with a configuration file of its own, so the runs must not share
+#	anything else: sweep runs of the stub file system without the
+#	network, or each would use the same DISK_0 and SOCKET_0.
+#
+# Usage: ./sweep.sh [-j runs] name=value[,value...]... -- nachos-args...
+#
+#	e.g.  ./sweep.sh AgingTicks=500,1500,4500 TimerTicks=100,500 \
+#		  -- --test bench.out/mixed.jobs
+#
+#	-j runs at most that many at once (by default, one per core).
+#	The table goes to the standard output and to $WORK/table; run
+#	N's configuration and output are left in $WORK/N.cf and N.out.
+#	Its columns, after the parameters, are
+#
+#	    ticks	total ticks simulated
+#	    idle	of which idle
+#	    jobs	threads finished, other than main
+#	    avg-turn	their average turnaround, in ticks,
+#	    p99-turn	and 99th percentile turnaround
+#	    avg-wait	their average time waiting for the CPU
+#	    switches	and the dispatches they took, in all
+#
+#	A run that didn't halt cleanly is shown as "failed", with its
+#	exit status.
+
+NACHOS=${NACHOS:-./nachos}
+WORK=${WORK:-sweep.out}
+
+runs=$(nproc 2> /dev/null || echo 1)
+if [ "$1" == "-j" ]; then
+    runs=$2
+    shift 2
+fi
+names=()
+values=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+    if [ "${1#*=}" == "$1" ]; then
+        break
+    fi
+    names+=("${1%%=*}")
+    values+=("${1#*=}")
+    shift
+done
+if [ "$1" != "--" ] || [ ${#names[@]} -eq 0 ]; then
+    echo "Usage: $0 [-j runs] name=value[,value...]... -- nachos-args..."
+    exit 2
+fi
+shift
+rm -rf $WORK
+mkdir -p $WORK
+
+# expand index prefix
+#	Write the configuration of every point of the grid from the
+#	index'th parameter on, each after the lines in "prefix", and
+#	list the points in $WORK/points.
+points=0
+expand() {
+    if [ $1 -eq ${#names[@]} ]; then
+        printf "%s" "$2" > $WORK/$points.cf
+        echo $points $(awk '{ print $2 }' $WORK/$points.cf) >> $WORK/points
+        points=$((points + 1))
+        return
+    fi
+    local value
+    for value in ${values[$1]//,/ }; do
+        expand $(($1 + 1)) "$2${names[$1]} $value"$'\n'
+    done
+}
+
+# measure output
+#	Print a run's statistics, the columns of the table.
+measure() {
+    awk '
+    /^Ticks: total/ { ticks = $3 + 0; idle = $5 + 0 }
+    /^Thread [0-9]+ \(.*\): turnaround/ && $2 != "0" {
+        for (i = 1; i < NF; i++) {
+            if ($i == "turnaround") t = $(i + 1) + 0
+            if ($i == "waited") { wait += $(i + 1); switches += $(i + 2) }
+        }
+        for (i = n; i > 0 && turnaround[i - 1] > t; i--) {
+            turnaround[i] = turnaround[i - 1]
+        }
+        turnaround[i] = t; sum += t; n++
+    }
+    END {
+        if (n == 0) { printf "%d %d 0 - - - 0\n", ticks, idle; exit }
+        p99 = int(0.99 * n + 0.999999) - 1
+        printf "%d %d %d %.1f %d %.1f %d\n", ticks, idle, n, sum / n,
+               turnaround[p99], wait / n, switches
+    }' $1
+}
+
+# run point
+#	Run nachos with the point's configuration.
+run() {
+    $NACHOS -cf $WORK/$1.cf "${args[@]}" > $WORK/$1.out 2>&1
+    echo $? > $WORK/$1.status
+}
+
+args=("$@")
+expand 0 ""
+for ((n = 0; n < points; n++)); do
+    while [ $(jobs -rp | wc -l) -ge $runs ]; do
+        wait -n
+    done
+    run $n &
+done
+wait
+
+{
+    for name in "${names[@]}"; do
+        printf "%-12s " $name
+    done
+    printf "%10s %10s %5s %10s %10s %10s %8s\n" ticks idle jobs \
+           avg-turn p99-turn avg-wait switches
+    while read n point; do
+        printf "%-12s " $point
+        status=$(cat $WORK/$n.status)
+        if [ "$status" != "0" ]; then
+            echo "failed ($status)"
+        else
+            printf "%10s %10s %5s %10s %10s %10s %8s\n" \
+                   $(measure $WORK/$n.out)
+        fi
+    done < $WORK/points
+} | tee $WORK/table
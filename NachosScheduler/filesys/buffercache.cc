@@ -0,0 +1,753 @@
+// buffercache.cc
+//	Routines to cache disk sectors in memory.  See buffercache.h.
+//
+//	A buffer is busy while a thread is copying to or from it, or
+//	while it is being read from or written to the disk; the latter
+//	is done without holding the cache's lock, so that others can use
+//	the rest of the cache in the meantime.  A thread that wants a
+//	busy buffer waits for it.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "buffercache.h"
+#include "synchdisk.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// BufferQueue::Prepend
+// 	Put "buffer" at the front of the queue, as the most recently used.
+//----------------------------------------------------------------------
+
+void
+BufferQueue::Prepend(CacheBuffer *buffer)
+{
+    buffer->prev = NULL;
+    buffer->next = first;
+    if (first != NULL) {
+        first->prev = buffer;
+    } else {
+        last = buffer;
+    }
+    first = buffer;
+    length++;
+}
+
+//----------------------------------------------------------------------
+// BufferQueue::Remove
+// 	Take "buffer", which is on the queue, off it.
+//----------------------------------------------------------------------
+
+void
+BufferQueue::Remove(CacheBuffer *buffer)
+{
+    if (buffer->prev != NULL) {
+        buffer->prev->next = buffer->next;
+    } else {
+        first = buffer->next;
+    }
+    if (buffer->next != NULL) {
+        buffer->next->prev = buffer->prev;
+    } else {
+        last = buffer->prev;
+    }
+    buffer->prev = buffer->next = NULL;
+    length--;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::BufferCache
+// 	Initialize a cache of "size" empty buffers, in front of
+//	"synchDisk", replacing them by "replacement".  Register how
+//	many of them are dirty.
+//----------------------------------------------------------------------
+
+BufferCache::BufferCache(SynchDisk *synchDisk, int size,
+                         CachePolicy replacement)
+{
+    ASSERT(size > 0);
+    disk = synchDisk;
+    policy = replacement;
+    numBuffers = size;
+    buffers = new CacheBuffer[numBuffers];
+    for (int i = 0; i < numBuffers; i++) {
+        buffers[i].sector = -1;
+        buffers[i].valid = buffers[i].dirty = FALSE;
+        buffers[i].busy = buffers[i].probation = FALSE;
+        buffers[i].readAhead = FALSE;
+        recent.Prepend(&buffers[i]);	// the empty ones go first
+    }
+    bySector = new CacheBuffer *[NumSectors];
+    for (int i = 0; i < NumSectors; i++) {
+        bySector[i] = NULL;
+    }
+    requests = new DiskRequest[numBuffers];
+    maxFifo = max(numBuffers / 4, 1);
+    numGhosts = max(numBuffers / 2, 1);
+    nextGhost = 0;
+    ghosts = new int[numGhosts];
+    for (int i = 0; i < numGhosts; i++) {
+        ghosts[i] = -1;
+    }
+    ghosted = new char[NumSectors];
+    for (int i = 0; i < NumSectors; i++) {
+        ghosted[i] = 0;
+    }
+    lock = new Lock("buffer cache");
+    released = new Condition("buffer released");
+    dirtied = new Condition("buffer dirtied");
+    flushTime = new Semaphore("buffer flush", 0);
+    numDirty = 0;
+    flusher = NULL;
+    firstAhead = numAhead = numUnused = 0;
+    aheadRequested = new Condition("buffer read ahead");
+    aheadThread = NULL;
+    kernel->registry->AddCounter("cache.dirty", &numDirty);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::~BufferCache
+// 	De-allocate the cache.  If there is a flusher, or a thread
+//	reading ahead, it is waiting, so, as with the postal worker (see
+//	PostOfficeInput), what it waits on is left allocated.
+//----------------------------------------------------------------------
+
+BufferCache::~BufferCache()
+{
+    if (numDirty > 0) {
+        DEBUG(dbgDisk, numDirty << " dirty buffers lost");
+    }
+    delete [] buffers;
+    delete [] bySector;
+    delete [] requests;
+    delete [] ghosts;
+    delete [] ghosted;
+    if (flusher == NULL && aheadThread == NULL) {
+        delete lock;
+        delete released;
+        delete dirtied;
+        delete flushTime;
+        delete aheadRequested;
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadSector
+// 	Copy the contents of sector "sectorNumber" into "data", reading
+//	it from the disk first if it isn't in the cache.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadSector(int sectorNumber, char *data)
+{
+    CacheBuffer *buffer;
+
+    lock->Acquire();
+    buffer = Acquire(sectorNumber);
+    if (buffer->valid) {
+        kernel->stats->numCacheHits++;
+        if (buffer->readAhead) {
+            kernel->stats->numReadAheadHits++;
+            buffer->readAhead = FALSE;
+            numUnused--;
+        }
+    } else {
+        kernel->stats->numCacheMisses++;
+        lock->Release();		// the buffer is ours, busy
+        disk->Transfer(sectorNumber, buffer->data, FALSE);
+        lock->Acquire();
+        buffer->valid = TRUE;
+    }
+    bcopy(buffer->data, data, SectorSize);
+    Release(buffer);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadSectors
+// 	Copy the "numSectors" sectors from "firstSector" on into data[0],
+//	data[1], ..., reading them in first if they aren't cached.  The
+//	misses one after another are read in one request, as many of
+//	them as there are clean buffers to take for them without waiting
+//	-- no more than a quarter of the buffers, as with read ahead.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadSectors(int firstSector, int numSectors, char **data)
+{
+    CacheBuffer **run = new CacheBuffer *[maxFifo];
+    char **parts = new char *[maxFifo];
+
+    lock->Acquire();
+    for (int i = 0; i < numSectors; ) {
+        CacheBuffer *buffer = Acquire(firstSector + i);
+        int n;
+
+        if (buffer->valid) {
+            kernel->stats->numCacheHits++;
+            if (buffer->readAhead) {
+                kernel->stats->numReadAheadHits++;
+                buffer->readAhead = FALSE;
+                numUnused--;
+            }
+            bcopy(buffer->data, data[i], SectorSize);
+            Release(buffer);
+            i++;
+            continue;
+        }
+        run[0] = buffer;
+        for (n = 1; n < maxFifo && i + n < numSectors
+                    && bySector[firstSector + i + n] == NULL; n++) {
+            CacheBuffer *victim = Victim();
+
+            if (victim == NULL || victim->dirty) {
+                break;			// Acquire would wait
+            }
+            run[n] = Acquire(firstSector + i + n);
+        }
+        for (int k = 0; k < n; k++) {
+            parts[k] = run[k]->data;
+        }
+        lock->Release();		// the buffers are ours, busy
+        disk->TransferRun(firstSector + i, n, parts, FALSE);
+        lock->Acquire();
+        for (int k = 0; k < n; k++) {
+            kernel->stats->numCacheMisses++;
+            run[k]->valid = TRUE;
+            bcopy(run[k]->data, data[i + k], SectorSize);
+            Release(run[k]);
+        }
+        i += n;
+    }
+    lock->Release();
+    delete [] run;
+    delete [] parts;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteSector
+// 	Make "data" the contents of sector "sectorNumber".  Only its
+//	buffer is changed; the disk is written later.
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteSector(int sectorNumber, char *data)
+{
+    CacheBuffer *buffer;
+
+    lock->Acquire();
+    buffer = Acquire(sectorNumber);	// the whole sector is written,
+    bcopy(data, buffer->data, SectorSize);	// so it needn't be read
+    buffer->valid = TRUE;
+    if (buffer->readAhead) {
+        buffer->readAhead = FALSE;
+        numUnused--;
+    }
+    kernel->stats->numCacheWrites++;
+    MarkDirty(buffer);
+    Release(buffer);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Flush
+// 	Write every dirty buffer to the disk, giving the disk all of them
+//	at once, in the order of their sectors, so that the head sweeps
+//	across the disk once -- those for sectors one after another in
+//	one request -- and return when they are all clean.
+//	Called by the flusher, and before Nachos is halted.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Flush()
+{
+    DiskCompletions written("buffer flush");
+
+    lock->Acquire();
+    for (;;) {
+        int numWriting = 0;
+        bool busyDirty = FALSE;
+
+        for (int s = 0; s < NumSectors; s++) {
+            CacheBuffer *buffer = bySector[s];
+            int n;
+
+            if (buffer == NULL || !buffer->dirty) {
+                continue;
+            }
+            if (buffer->busy) {
+                busyDirty = TRUE;	// being written to
+                continue;
+            }
+            for (n = 1; s + n < NumSectors && bySector[s + n] != NULL
+                        && bySector[s + n]->dirty && !bySector[s + n]->busy;
+                 n++)
+                ;
+            Start(buffer, n, TRUE, &written);	// the run from it
+            numWriting++;
+            s += n - 1;
+        }
+        if (numWriting > 0) {
+            for (; numWriting > 0; numWriting--) {
+                lock->Release();
+                DiskRequest *request = written.Get();
+                lock->Acquire();
+                Finish(request);
+            }
+        } else if (busyDirty) {
+            released->Wait(lock);
+        } else {
+            break;
+        }
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadAhead
+// 	Have sector "sectorNumber" read into a buffer, by the thread
+//	reading ahead, unless it is in one already; don't wait for it.
+//	If a quarter of the buffers' worth of sectors are waiting to be
+//	read ahead, or have been and are not used yet, refuse: more
+//	would push out those in use, or each other.  Return FALSE if
+//	refused.
+//----------------------------------------------------------------------
+
+bool
+BufferCache::ReadAhead(int sectorNumber)
+{
+    bool taken = TRUE;
+
+    lock->Acquire();
+    if (bySector[sectorNumber] == NULL) {
+        taken = (numAhead + numUnused < maxFifo);
+        if (taken) {
+            AskAhead(sectorNumber, FALSE);
+        }
+    }
+    lock->Release();
+    return taken;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteBehind
+// 	Have sector "sectorNumber" written to the disk now, by the thread
+//	reading ahead, if it is dirty, rather than when the flusher next
+//	runs; don't wait for it.
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteBehind(int sectorNumber)
+{
+    lock->Acquire();
+    if (bySector[sectorNumber] != NULL && bySector[sectorNumber]->dirty) {
+        AskAhead(sectorNumber, TRUE);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::CallBack
+// 	The flush interrupt: wake the flusher up.
+//----------------------------------------------------------------------
+
+void
+BufferCache::CallBack()
+{
+    flushTime->V();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Acquire
+// 	Return the buffer holding sector "sectorNumber", busy, for the
+//	current thread to use.  If no buffer holds it, take one for it
+//	(its contents not valid yet), writing out what it held if that
+//	was dirty.  Wait for a buffer to be released, if the one we want,
+//	or all of them, are busy.  The cache's lock is held.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Acquire(int sectorNumber)
+{
+    CacheBuffer *buffer;
+
+    ASSERT(sectorNumber >= 0 && sectorNumber < NumSectors);
+    for (;;) {
+        buffer = bySector[sectorNumber];
+        if (buffer != NULL) {
+            if (buffer->busy) {
+                released->Wait(lock);
+                continue;
+            }
+            buffer->busy = TRUE;
+            Used(buffer);
+            return buffer;
+        }
+        if ((buffer = Victim()) == NULL) {	// all busy
+            released->Wait(lock);
+            continue;
+        }
+        if (buffer->dirty) {		// the lock is let go meanwhile,
+            WriteBack(buffer);		// so look again
+            continue;
+        }
+
+        if (buffer->sector >= 0) {
+            bySector[buffer->sector] = NULL;
+            if (buffer->probation) {	// remember it left the FIFO
+                if (ghosts[nextGhost] >= 0) {
+                    ghosted[ghosts[nextGhost]]--;
+                }
+                ghosts[nextGhost] = buffer->sector;
+                ghosted[buffer->sector]++;
+                nextGhost = (nextGhost + 1) % numGhosts;
+            }
+        }
+        if (buffer->probation) {
+            fifo.Remove(buffer);
+        } else {
+            recent.Remove(buffer);
+        }
+        DEBUG(dbgDisk, "Buffer for sector " << sectorNumber << ", was "
+              << buffer->sector);
+        if (buffer->readAhead) {	// read ahead for nothing
+            buffer->readAhead = FALSE;
+            numUnused--;
+        }
+        buffer->sector = sectorNumber;
+        buffer->valid = FALSE;
+        buffer->busy = TRUE;
+        buffer->probation = (policy == Cache2Q && ghosted[sectorNumber] == 0);
+        if (buffer->probation) {
+            fifo.Prepend(buffer);
+        } else {
+            recent.Prepend(buffer);
+        }
+        bySector[sectorNumber] = buffer;
+        return buffer;
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Release
+// 	The current thread is done with "buffer"; wake up anyone waiting
+//	for it.  The cache's lock is held.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Release(CacheBuffer *buffer)
+{
+    ASSERT(buffer->busy);
+    buffer->busy = FALSE;
+    released->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Victim
+// 	Return the buffer to take for another sector, by the replacement
+//	policy, or NULL if they are all busy.  An empty buffer is taken
+//	first; with 2Q, the oldest in the FIFO if it is full, and then
+//	the least recently used of the rest.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Victim()
+{
+    CacheBuffer *buffer;
+
+    if (recent.last != NULL && recent.last->sector < 0) {
+        return recent.last;		// never busy
+    }
+    if (fifo.length >= maxFifo) {
+        for (buffer = fifo.last; buffer != NULL; buffer = buffer->prev) {
+            if (!buffer->busy) {
+                return buffer;
+            }
+        }
+    }
+    for (buffer = recent.last; buffer != NULL; buffer = buffer->prev) {
+        if (!buffer->busy) {
+            return buffer;
+        }
+    }
+    for (buffer = fifo.last; buffer != NULL; buffer = buffer->prev) {
+        if (!buffer->busy) {
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Used
+// 	"buffer" was just used: it is now the most recently used, unless
+//	it is in the FIFO, where it stays in the order it came in.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Used(CacheBuffer *buffer)
+{
+    if (!buffer->probation) {
+        recent.Remove(buffer);
+        recent.Prepend(buffer);
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteBack
+// 	Write the dirty, and not busy, "buffer" to the disk.  It is busy,
+//	and the cache's lock let go, while the disk is written.
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteBack(CacheBuffer *buffer)
+{
+    DiskCompletions written("buffer write back");
+    DiskRequest *request;
+
+    Start(buffer, 1, TRUE, &written);
+    lock->Release();
+    request = written.Get();
+    lock->Acquire();
+    Finish(request);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Start
+// 	Give the disk the request to write "buffer", which is dirty and
+//	not busy, and the "numSectors" - 1 buffers for the sectors after
+//	it, which are too -- or, if not "writing", to read "buffer", when
+//	it is ours, busy -- and return without waiting: the request is
+//	put in "completions" when it is done (see Finish).  A buffer
+//	written is busy, and clean as of what is written, until then.
+//	The cache's lock is held.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Start(CacheBuffer *buffer, int numSectors, bool writing,
+                   DiskCompletions *completions)
+{
+    DiskRequest *request = &requests[buffer - buffers];
+
+    request->vector = NULL;
+    if (writing) {
+        if (numSectors > 1) {
+            request->vector = new char *[numSectors];
+        }
+        for (int k = 0; k < numSectors; k++) {
+            CacheBuffer *next = bySector[buffer->sector + k];
+
+            ASSERT(next->dirty && !next->busy);
+            next->busy = TRUE;
+            next->dirty = FALSE;
+            numDirty--;
+            if (request->vector != NULL) {
+                request->vector[k] = next->data;
+            }
+        }
+        DEBUG(dbgDisk, "Writing back " << numSectors << " sectors from "
+              << buffer->sector);
+    } else {
+        ASSERT(numSectors == 1 && buffer->busy && !buffer->valid);
+    }
+    request->sector = buffer->sector;
+    request->data = buffer->data;
+    request->numSectors = numSectors;
+    request->writing = writing;
+    request->callWhenDone = NULL;
+    request->completions = completions;
+    disk->Submit(request);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Finish
+// 	Release the buffers "request", done, was started for; a buffer
+//	read is now valid.  The cache's lock is held.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Finish(DiskRequest *request)
+{
+    for (int k = 0; k < request->numSectors; k++) {
+        CacheBuffer *buffer = bySector[request->sector + k];
+
+        ASSERT(buffer->busy);
+        if (request->writing) {
+            kernel->stats->numCacheWriteBacks++;
+        } else {
+            buffer->valid = TRUE;
+        }
+        Release(buffer);
+    }
+    delete [] request->vector;
+    request->vector = NULL;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::MarkDirty
+// 	"buffer" has been changed, so it must be written to the disk.
+//	Start the flusher, the first time, or tell it if it is waiting
+//	for a buffer to be dirty.  The cache's lock is held.
+//----------------------------------------------------------------------
+
+void
+BufferCache::MarkDirty(CacheBuffer *buffer)
+{
+    if (buffer->dirty) {
+        return;				// already will be
+    }
+    buffer->dirty = TRUE;
+    if (numDirty++ == 0) {
+        dirtied->Signal(lock);
+    }
+    if (flusher == NULL) {
+        flusher = new Thread("buffer flusher", kernel->threads->NewID());
+        flusher->Fork((VoidFunctionPtr) &BufferCache::FlusherThread,
+                      (void *) this);
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::FlusherThread
+// 	The flusher thread starts here.
+//----------------------------------------------------------------------
+
+void
+BufferCache::FlusherThread(BufferCache *cache)
+{
+    cache->FlushForever();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::FlushForever
+// 	Wait until a buffer is dirty, then CacheFlushDelay ticks more, and
+//	write out every dirty buffer; and again.  No interrupt is pending
+//	for us while the cache is clean.
+//----------------------------------------------------------------------
+
+void
+BufferCache::FlushForever()
+{
+    for (;;) {
+        IntStatus oldLevel;
+
+        lock->Acquire();
+        while (numDirty == 0) {
+            dirtied->Wait(lock);
+        }
+        lock->Release();
+
+        oldLevel = kernel->interrupt->SetLevel(IntOff);
+        kernel->interrupt->Schedule(this, CacheFlushDelay, BufferFlushInt);
+        (void) kernel->interrupt->SetLevel(oldLevel);
+        flushTime->P();
+        Flush();
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::AskAhead
+// 	Put sector "sectorNumber" in the ring, to be read ahead, or if
+//	"writing", written behind.  Start the thread that does it, the
+//	first time.  The cache's lock is held.
+//----------------------------------------------------------------------
+
+void
+BufferCache::AskAhead(int sectorNumber, bool writing)
+{
+    int last;
+
+    if (numAhead == MaxAheadRequests) {
+        return;				// we're behind already
+    }
+    last = (firstAhead + numAhead) % MaxAheadRequests;
+    aheadSectors[last] = sectorNumber;
+    aheadWrites[last] = writing;
+    if (numAhead++ == 0) {
+        aheadRequested->Signal(lock);
+    }
+    if (aheadThread == NULL) {
+        aheadThread = new Thread("read ahead", kernel->threads->NewID());
+        aheadThread->Fork((VoidFunctionPtr) &BufferCache::AheadThread,
+                          (void *) this);
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::AheadThread
+// 	The thread reading ahead starts here.
+//----------------------------------------------------------------------
+
+void
+BufferCache::AheadThread(BufferCache *cache)
+{
+    cache->AheadForever();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::AheadForever
+// 	Take the sectors in the ring, in turn, and give the disk the
+//	request to read each into a buffer, unless one holds it by now,
+//	or to write it, if it is still dirty; then wait for one of them
+//	to be done, and again.  No more than
+//	a quarter of the buffers are ever busy with our requests, so
+//	taking another for the next doesn't wait for them alone.
+//----------------------------------------------------------------------
+
+void
+BufferCache::AheadForever()
+{
+    DiskCompletions done("buffer read ahead");
+    int numInFlight = 0;
+
+    lock->Acquire();
+    for (;;) {
+        CacheBuffer *buffer;
+        int sector;
+        bool writing;
+
+        while (numAhead == 0 && numInFlight == 0) {
+            aheadRequested->Wait(lock);
+        }
+        while (numAhead > 0 && numInFlight < maxFifo) {
+            sector = aheadSectors[firstAhead];
+            writing = aheadWrites[firstAhead];
+            firstAhead = (firstAhead + 1) % MaxAheadRequests;
+            numAhead--;
+
+            buffer = bySector[sector];
+            if (writing) {
+                if (buffer != NULL && buffer->dirty && !buffer->busy) {
+                    kernel->stats->numWriteBehinds++;
+                    Start(buffer, 1, TRUE, &done);
+                    numInFlight++;
+                }
+            } else if (buffer == NULL) {
+                buffer = Acquire(sector);
+                if (buffer->valid) {
+                    Release(buffer);	// written while we waited
+                } else {
+                    DEBUG(dbgDisk, "Reading ahead sector " << sector);
+                    buffer->readAhead = TRUE;
+                    numUnused++;
+                    Start(buffer, 1, FALSE, &done);
+                    numInFlight++;
+                }
+            }
+        }
+        if (numInFlight > 0) {
+            DiskRequest *request;
+
+            lock->Release();
+            request = done.Get();
+            lock->Acquire();
+            numInFlight--;
+            if (!request->writing) {
+                kernel->stats->numReadAheads++;
+            }
+            Finish(request);
+        }
+    }
+}
@@ -0,0 +1,177 @@
+// buffercache.h
+//	Data structures for a cache of disk sectors in memory, in front
+//	of the disk (see SynchDisk).
+//
+//	The file system reads the same few sectors over and over -- the
+//	free map, the directory, the file headers -- and every read or
+//	write of the disk waits for a seek and for the disk to turn.  So
+//	SynchDisk keeps the sectors used lately in "-bc <buffers>"
+//	buffers of a sector each (64 by default; 0 for none), and most
+//	reads and writes don't go to the disk at all:
+//
+//	A read of a sector in the cache (a hit) is copied from its
+//	buffer; a miss reads it into a buffer first.  A write changes
+//	only the buffer, which is then dirty: it is written to the disk
+//	later -- by the flusher thread, CacheFlushDelay ticks after a
+//	buffer was dirtied, or when the buffer is wanted for another
+//	sector, or when a user program halts Nachos (see SysHalt).  The
+//	flusher only waits for its interrupt while a buffer is dirty, so
+//	Nachos doesn't stop, for want of anything to do, before the
+//	cache is clean.
+//
+//	Which buffer to take for another sector is up to the policy,
+//	"-bc <buffers> <policy>":
+//
+//	"lru" -- the least recently used (the default)
+//	"2q" -- the simplified 2Q of Johnson and Shasha: a sector read
+//		in goes in a FIFO of a quarter of the buffers, and only
+//		goes in the LRU part -- the rest of them -- if it is
+//		used again after it has left the FIFO (the numbers of
+//		the last half a cache's worth of sectors to leave it are
+//		remembered).  So a sector used once, like those of a
+//		file read through, doesn't push out those used all the
+//		time.
+//
+//	A file read through from the start has the sectors after those it
+//	reads read ahead (see OpenFile::ReadAt), and one written through
+//	has the sectors it is done with written behind: a thread of the
+//	cache's, started the first time, reads or writes them while the
+//	reader or writer goes on, so that the sector it wants next is
+//	already in a buffer, and it doesn't wait for the disk.  It, and
+//	Flush, give the disk all the requests they have at once (see
+//	SynchDisk::Submit), and then wait for them.
+//
+//	The swap area (see pager.h) is not cached: the pager keeps the
+//	pages it wants in memory itself.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BUFFERCACHE_H
+#define BUFFERCACHE_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "callback.h"
+
+class SynchDisk;
+class DiskRequest;
+class DiskCompletions;
+class Lock;
+class Condition;
+class Semaphore;
+class Thread;
+
+// How to pick the buffer to take for another sector.
+
+enum CachePolicy { CacheLRU, Cache2Q };
+
+const int DefaultCacheSize = 64;	// buffers, unless -bc says otherwise
+const int CacheFlushDelay = 20000;	// ticks a buffer may stay dirty
+const int MaxAheadRequests = 32;	// sectors to read ahead or write
+					// behind that can wait at once
+
+// A buffer, and the sector it holds.
+
+class CacheBuffer {
+  public:
+    int sector;			// the sector it holds, or -1
+    char data[SectorSize];
+    bool valid;			// "data" has been read or written
+    bool dirty;			// changed since the disk last had it
+    bool busy;			// a thread is using it
+    bool probation;		// with 2Q, in the FIFO part
+    bool readAhead;		// read ahead, and not used since
+    CacheBuffer *prev;		// on its queue, the most recently
+    CacheBuffer *next;		// used first
+};
+
+// A queue of buffers.
+
+class BufferQueue {
+  public:
+    BufferQueue() { first = last = NULL; length = 0; }
+
+    void Prepend(CacheBuffer *buffer);	// put it at the front
+    void Remove(CacheBuffer *buffer);	// take it out
+
+    CacheBuffer *first;
+    CacheBuffer *last;
+    int length;
+};
+
+// The following class caches the sectors of the disk.
+
+class BufferCache : public CallBackObj {
+  public:
+    BufferCache(SynchDisk *synchDisk, int size, CachePolicy replacement);
+				// "size" empty buffers
+    ~BufferCache();
+
+    void ReadSector(int sectorNumber, char *data);
+    void WriteSector(int sectorNumber, char *data);
+    void ReadSectors(int firstSector, int numSectors, char **data);
+				// as SynchDisk's, only through the cache
+    void Flush();		// write every dirty buffer to the disk
+    bool ReadAhead(int sectorNumber);	// read it soon, without waiting
+    void WriteBehind(int sectorNumber);	// write it soon, if it is dirty
+
+    void CallBack();		// the flush interrupt: time to write
+
+  private:
+    SynchDisk *disk;		// where the sectors come from
+    CachePolicy policy;
+    int numBuffers;
+    CacheBuffer *buffers;
+    CacheBuffer **bySector;	// the buffer holding each sector, or NULL
+    DiskRequest *requests;	// for each buffer, the disk request reading
+				// or writing it (and those after it, in a
+				// run), while it is busy so
+    BufferQueue recent;		// the buffers, by LRU (with 2Q, those out
+				// of the FIFO)
+    BufferQueue fifo;		// with 2Q, those read in lately
+    int maxFifo;		// how many of them there can be
+    int *ghosts;		// with 2Q, the sectors to leave the FIFO
+    int numGhosts;		// last, in a ring of "numGhosts"
+    int nextGhost;		// where the next goes in the ring
+    char *ghosted;		// how often each sector is in the ring
+
+    Lock *lock;			// for all of the above
+    Condition *released;	// signalled when a buffer stops being busy
+    Condition *dirtied;		// and when one becomes dirty
+    Semaphore *flushTime;	// V'd by the flush interrupt
+    int numDirty;		// buffers dirty
+    Thread *flusher;		// started the first time one is
+
+    int aheadSectors[MaxAheadRequests];	// a ring of the sectors to read
+    bool aheadWrites[MaxAheadRequests];	// ahead or write behind, in the
+    int firstAhead;			// order they were asked for
+    int numAhead;
+    int numUnused;			// buffers read ahead, not used yet
+    Condition *aheadRequested;		// signalled when one is put there
+    Thread *aheadThread;		// started the first time one is
+
+    CacheBuffer *Acquire(int sectorNumber);
+				// the buffer for a sector, busy for us
+    void Release(CacheBuffer *buffer);	// don't need it any more
+    CacheBuffer *Victim();	// a buffer to take, by the policy
+    void Used(CacheBuffer *buffer);	// a buffer was used
+    void WriteBack(CacheBuffer *buffer);	// write it to the disk
+    void Start(CacheBuffer *buffer, int numSectors, bool writing,
+	       DiskCompletions *completions);
+				// read it or write it, and the run after
+				// it, without waiting
+    void Finish(DiskRequest *request);
+				// release the buffers a request was for
+    void MarkDirty(CacheBuffer *buffer);	// it has changed
+
+    static void FlusherThread(BufferCache *cache);
+    void FlushForever();	// what the flusher does
+    void AskAhead(int sectorNumber, bool writing);
+				// put a request in the ring
+    static void AheadThread(BufferCache *cache);
+    void AheadForever();	// what the thread reading ahead does
+};
+
+#endif // BUFFERCACHE_H
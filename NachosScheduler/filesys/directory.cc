@@ -11,9 +11,12 @@
 //	we use ReadFrom/WriteBack to fetch the contents of the directory
 //	from disk, and to write back any modifications back to disk.
 //
-//	Also, this implementation has the restriction that the size
-//	of the directory cannot expand.  In other words, once all the
-//	entries in the directory are used, no more files can be created.
+//	The table is hashed on the file names (see directory.h).  It
+//	doesn't grow by itself: the file system, which has to make the
+//	directory's file bigger too, resizes it when it is crowded.
+//
+//	Only the entries changed since the last WriteBack are written, so
+//	that adding a file writes a sector or two, not the whole table.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -21,6 +24,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "debug.h"
 #include "filehdr.h"
 #include "directory.h"
 
@@ -38,8 +42,13 @@ Directory::Directory(int size)
 {
     table = new DirectoryEntry[size];
     tableSize = size;
-    for (int i = 0; i < tableSize; i++)
+    for (int i = 0; i < tableSize; i++) {
 	table[i].inUse = FALSE;
+	table[i].removed = FALSE;
+    }
+    numInUse = numRemoved = 0;
+    firstChanged = 0;			// none of it is on the disk
+    lastChanged = tableSize - 1;
 }
 
 //----------------------------------------------------------------------
@@ -48,13 +57,14 @@ Directory::Directory(int size)
 //----------------------------------------------------------------------
 
 Directory::~Directory()
-{ 
+{
     delete [] table;
-} 
+}
 
 //----------------------------------------------------------------------
 // Directory::FetchFrom
-// 	Read the contents of the directory from disk.
+// 	Read the contents of the directory from disk.  The directory
+//	takes the size of the file.
 //
 //	"file" -- file containing the directory contents
 //----------------------------------------------------------------------
@@ -62,12 +72,23 @@ Directory::~Directory()
 void
 Directory::FetchFrom(OpenFile *file)
 {
+    int size = file->Length() / sizeof(DirectoryEntry);
+
+    if (size != tableSize) {
+	delete [] table;
+	table = new DirectoryEntry[size];
+	tableSize = size;
+    }
     (void) file->ReadAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    Count();
+    firstChanged = tableSize;		// it is all on the disk
+    lastChanged = -1;
 }
 
 //----------------------------------------------------------------------
 // Directory::WriteBack
-// 	Write any modifications to the directory back to disk
+// 	Write any modifications to the directory back to disk: the
+//	entries from the first changed to the last.
 //
 //	"file" -- file to contain the new directory contents
 //----------------------------------------------------------------------
@@ -75,13 +96,41 @@ Directory::FetchFrom(OpenFile *file)
 void
 Directory::WriteBack(OpenFile *file)
 {
-    (void) file->WriteAt((char *)table, tableSize * sizeof(DirectoryEntry), 0);
+    ASSERT(file->Length() >= (int) (tableSize * sizeof(DirectoryEntry)));
+    if (firstChanged <= lastChanged) {
+	(void) file->WriteAt((char *)&table[firstChanged],
+			     (lastChanged - firstChanged + 1)
+			     * sizeof(DirectoryEntry),
+			     firstChanged * sizeof(DirectoryEntry));
+    }
+    firstChanged = tableSize;
+    lastChanged = -1;
+}
+
+//----------------------------------------------------------------------
+// Directory::Hash
+// 	Return the entry where the search for "name" starts: a hash of
+//	the characters that are compared, modulo the size of the table.
+//
+//	"name" -- the file name to look up
+//----------------------------------------------------------------------
+
+int
+Directory::Hash(char *name)
+{
+    unsigned int hash = 0;
+
+    for (int i = 0; i < FileNameMaxLen && name[i] != '\0'; i++)
+	hash = hash * 31 + (unsigned char) name[i];
+    return hash % tableSize;
 }
 
 //----------------------------------------------------------------------
 // Directory::FindIndex
 // 	Look up file name in directory, and return its location in the table of
 //	directory entries.  Return -1 if the name isn't in the directory.
+//	The search starts where the name hashes to, and stops at an
+//	entry that has never been used.
 //
 //	"name" -- the file name to look up
 //----------------------------------------------------------------------
@@ -89,9 +138,17 @@ Directory::WriteBack(OpenFile *file)
 int
 Directory::FindIndex(char *name)
 {
-    for (int i = 0; i < tableSize; i++)
-        if (table[i].inUse && !strncmp(table[i].name, name, FileNameMaxLen))
-	    return i;
+    int start = Hash(name);
+
+    for (int n = 0; n < tableSize; n++) {
+	int i = (start + n) % tableSize;
+
+	if (table[i].inUse) {
+	    if (!strncmp(table[i].name, name, FileNameMaxLen))
+		return i;
+	} else if (!table[i].removed)
+	    break;
+    }
     return -1;		// name not in directory
 }
 
@@ -119,7 +176,8 @@ Directory::Find(char *name)
 // 	Add a file into the directory.  Return TRUE if successful;
 //	return FALSE if the file name is already in the directory, or if
 //	the directory is completely full, and has no more space for
-//	additional file names.
+//	additional file names.  The file goes in the first free entry
+//	from where its name hashes to.
 //
 //	"name" -- the name of the file being added
 //	"newSector" -- the disk sector containing the added file's header
@@ -127,39 +185,133 @@ Directory::Find(char *name)
 
 bool
 Directory::Add(char *name, int newSector)
-{ 
+{
+    int start;
+
     if (FindIndex(name) != -1)
 	return FALSE;
 
-    for (int i = 0; i < tableSize; i++)
+    start = Hash(name);
+    for (int n = 0; n < tableSize; n++) {
+	int i = (start + n) % tableSize;
+
         if (!table[i].inUse) {
+	    if (table[i].removed) {
+		numRemoved--;
+	    }
             table[i].inUse = TRUE;
+	    table[i].removed = FALSE;
             strncpy(table[i].name, name, FileNameMaxLen); 
+	    table[i].name[FileNameMaxLen] = '\0';
             table[i].sector = newSector;
+	    numInUse++;
+	    Changed(i, i);
         return TRUE;
 	}
-    return FALSE;	// no space.  Fix when we have extensible files.
+    }
+    return FALSE;	// no space; the file system should have resized us
 }
 
 //----------------------------------------------------------------------
 // Directory::Remove
 // 	Remove a file name from the directory.  Return TRUE if successful;
-//	return FALSE if the file isn't in the directory. 
+//	return FALSE if the file isn't in the directory.  The entry is
+//	marked, so that searches for other names go on past it.
 //
 //	"name" -- the file name to be removed
 //----------------------------------------------------------------------
 
 bool
 Directory::Remove(char *name)
-{ 
+{
     int i = FindIndex(name);
 
     if (i == -1)
 	return FALSE; 		// name not in directory
     table[i].inUse = FALSE;
+    table[i].removed = TRUE;
+    numInUse--;
+    numRemoved++;
+    Changed(i, i);
     return TRUE;	
 }
 
+//----------------------------------------------------------------------
+// Directory::IsCrowded
+// 	Return TRUE if, once another file is added, three quarters or
+//	more of the entries would be in use or marked removed, so that
+//	searches would get long: time to Resize.
+//----------------------------------------------------------------------
+
+bool
+Directory::IsCrowded()
+{
+    return (numInUse + numRemoved + 1) * 4 > tableSize * 3;
+}
+
+//----------------------------------------------------------------------
+// Directory::Resize
+// 	Rehash the files in the directory into a table of "size"
+//	entries, dropping the marks of those removed.  Its file has to
+//	be made to fit before the directory is written back.
+//
+//	"size" -- the number of entries, at least the files there are
+//----------------------------------------------------------------------
+
+void
+Directory::Resize(int size)
+{
+    DirectoryEntry *old = table;
+    int oldSize = tableSize;
+
+    ASSERT(size >= numInUse);
+    table = new DirectoryEntry[size];
+    tableSize = size;
+    for (int i = 0; i < tableSize; i++) {
+	table[i].inUse = FALSE;
+	table[i].removed = FALSE;
+    }
+    numInUse = numRemoved = 0;
+    for (int i = 0; i < oldSize; i++)
+	if (old[i].inUse) {
+	    bool added = Add(old[i].name, old[i].sector);
+
+	    ASSERT(added);
+	}
+    delete [] old;
+    Changed(0, tableSize - 1);
+}
+
+//----------------------------------------------------------------------
+// Directory::Count
+// 	Count the entries in use, and those marked removed.
+//----------------------------------------------------------------------
+
+void
+Directory::Count()
+{
+    numInUse = numRemoved = 0;
+    for (int i = 0; i < tableSize; i++) {
+	if (table[i].inUse)
+	    numInUse++;
+	else if (table[i].removed)
+	    numRemoved++;
+    }
+}
+
+//----------------------------------------------------------------------
+// Directory::Changed
+// 	Note that the entries from "first" to "last" have changed, and
+//	have to be written back.
+//----------------------------------------------------------------------
+
+void
+Directory::Changed(int first, int last)
+{
+    firstChanged = min(firstChanged, first);
+    lastChanged = max(lastChanged, last);
+}
+
 //----------------------------------------------------------------------
 // Directory::List
 // 	List all the file names in the directory. 
@@ -181,7 +333,7 @@ Directory::List()
 
 void
 Directory::Print()
-{ 
+{
     FileHeader *hdr = new FileHeader;
 
     printf("Directory contents:\n");
@@ -6,6 +6,16 @@
 //	where to find its file header (the data structure describing
 //	where to find the file's data blocks) on disk.
 //
+//	The table is a hash table, on disk as in memory: a name goes in
+//	the entry its hash picks, or, if that one is taken, in the next
+//	free one after it (linear probing), so that looking a name up
+//	reads a few entries, not the whole directory.  An entry whose
+//	file was removed is marked, so that a search for a name goes
+//	past it.  Once three quarters of the entries are in use (or were,
+//	and are marked), the directory needs more of them: it is
+//	rehashed into a bigger table (see Resize), and its file made to
+//	fit it (see FileSystem::Create).
+//
 //      We assume mutual exclusion is provided by the caller.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -32,6 +42,8 @@
 class DirectoryEntry {
   public:
     bool inUse;				// Is this directory entry in use?
+    bool removed;			// If not, was it, so a search has to
+					//   go on past it?
     int sector;				// Location on disk to find the 
 					//   FileHeader for this file 
     char name[FileNameMaxLen + 1];	// Text name for file, with +1 for 
@@ -55,8 +67,10 @@ class Directory {
     ~Directory();			// De-allocate the directory
 
     void FetchFrom(OpenFile *file);  	// Init directory contents from disk
+					// (as many entries as the file holds)
     void WriteBack(OpenFile *file);	// Write modifications to 
 					// directory contents back to disk
+					// (the entries that changed)
 
     int Find(char *name);		// Find the sector number of the 
 					// FileHeader for file: "name"
@@ -65,6 +79,11 @@ class Directory {
 
     bool Remove(char *name);		// Remove a file from the directory
 
+    int Size() { return tableSize; }	// how many entries there are
+    bool IsCrowded();			// should it be rehashed before
+					// another Add?
+    void Resize(int size);		// rehash into "size" entries
+
     void List();			// Print the names of all the files
 					//  in the directory
     void Print();			// Verbose print of the contents
@@ -75,9 +94,17 @@ class Directory {
     int tableSize;			// Number of directory entries
     DirectoryEntry *table;		// Table of pairs: 
 					// <file name, file header location> 
+    int numInUse;			// entries in use,
+    int numRemoved;			// and those marked removed
+    int firstChanged;			// the entries changed since the
+    int lastChanged;			// last WriteBack, if first <= last
 
     int FindIndex(char *name);		// Find the index into the directory 
 					//  table corresponding to "name"
+    int Hash(char *name);		// where a search for it starts
+    void Count();			// set numInUse and numRemoved
+    void Changed(int first, int last);	// entries "first" to "last" have
+					// to be written back
 };
 
 #endif // DIRECTORY_H
@@ -4,11 +4,13 @@
 //
 //	The file header is used to locate where on disk the 
 //	file's data is stored.  We implement this as a fixed size
-//	table of pointers -- each entry in the table points to the 
-//	disk sector containing that portion of the file data
-//	(in other words, there are no indirect or doubly indirect 
-//	blocks). The table size is chosen so that the file header
-//	will be just big enough to fit in one disk sector, 
+//	table of extents -- each entry in the table gives the first
+//	of a run of consecutive disk sectors holding that portion of
+//	the file data, and how many there are.  The table size is
+//	chosen so that the file header will be just big enough to fit
+//	in one disk sector.  A file is allocated in as few runs as
+//	the free space allows, so that reading it through seldom moves
+//	the disk head to another place.
 //
 //      Unlike in a real system, we do not keep track of file permissions, 
 //	ownership, last modification date, etc., in the file header. 
@@ -34,25 +36,47 @@
 // 	Initialize a fresh file header for a newly created file.
 //	Allocate data blocks for the file out of the map of free disk blocks.
 //	Return FALSE if there are not enough free blocks to accomodate
-//	the new file.
+//	the new file, or if they are in too many pieces.
+//
+//	The data blocks are taken a run at a time: the free run long
+//	enough for the rest of the file closest to "hint" (see
+//	PersistentBitmap::FindRun), if there is one; otherwise the
+//	longest free run, and so on, each near where the last one ends,
+//	so that the file is in as few extents as can be, and reading it
+//	through seldom moves the disk head far.
 //
 //	"freeMap" is the bit map of free disk sectors
-//	"fileSize" is the bit map of free disk sectors
+//	"fileSize" is the number of bytes in the file
+//	"hint" is the sector the data should start at, if it is free
 //----------------------------------------------------------------------
 
 bool
-FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
+FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize, int hint)
 { 
+    int left, e;
+
     numBytes = fileSize;
     numSectors  = divRoundUp(fileSize, SectorSize);
+    for (e = 0; e < NumExtents; e++) {
+	extents[e].start = -1;		// unused
+	extents[e].length = 0;
+    }
     if (freeMap->NumClear() < numSectors)
 	return FALSE;		// not enough space
 
-    for (int i = 0; i < numSectors; i++) {
-	dataSectors[i] = freeMap->FindAndSet();
+    for (e = 0, left = numSectors; left > 0; e++) {
+	if (e == NumExtents) {
+	    Deallocate(freeMap);	// too fragmented; give back what
+	    return FALSE;		// we took
+	}
+	extents[e].start = freeMap->FindRun(left, hint, &extents[e].length);
 	// since we checked that there was enough free space,
 	// we expect this to succeed
-	ASSERT(dataSectors[i] >= 0);
+	ASSERT(extents[e].length > 0);
+	for (int i = 0; i < extents[e].length; i++)
+	    freeMap->Mark(extents[e].start + i);
+	left -= extents[e].length;
+	hint = extents[e].start + extents[e].length;
     }
     return TRUE;
 }
@@ -67,9 +91,13 @@ FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
 void 
 FileHeader::Deallocate(PersistentBitmap *freeMap)
 {
-    for (int i = 0; i < numSectors; i++) {
-	ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
-	freeMap->Clear((int) dataSectors[i]);
+    for (int e = 0; e < NumExtents && extents[e].length > 0; e++) {
+	for (int i = 0; i < extents[e].length; i++) {
+	    int sector = extents[e].start + i;
+
+	    ASSERT(freeMap->Test(sector));  // ought to be marked!
+	    freeMap->Clear(sector);
+	}
     }
 }
 
@@ -106,13 +134,23 @@ FileHeader::WriteBack(int sector)
 //	offset in the file) to a physical address (the sector where the
 //	data at the offset is stored).
 //
+//	The extents are scanned in order; there are only a few.
+//
 //	"offset" is the location within the file of the byte in question
 //----------------------------------------------------------------------
 
 int
 FileHeader::ByteToSector(int offset)
 {
-    return(dataSectors[offset / SectorSize]);
+    int block = offset / SectorSize;
+
+    for (int e = 0; e < NumExtents && extents[e].length > 0; e++) {
+	if (block < extents[e].length)
+	    return extents[e].start + block;
+	block -= extents[e].length;
+    }
+    ASSERTNOTREACHED();			// past the end of the file
+    return -1;
 }
 
 //----------------------------------------------------------------------
@@ -139,11 +177,12 @@ FileHeader::Print()
     char *data = new char[SectorSize];
 
     printf("FileHeader contents.  File size: %d.  File blocks:\n", numBytes);
-    for (i = 0; i < numSectors; i++)
-	printf("%d ", dataSectors[i]);
+    for (i = 0; i < NumExtents && extents[i].length > 0; i++)
+	printf("%d-%d ", extents[i].start,
+	       extents[i].start + extents[i].length - 1);
     printf("\nFile contents:\n");
     for (i = k = 0; i < numSectors; i++) {
-	kernel->synchDisk->ReadSector(dataSectors[i], data);
+	kernel->synchDisk->ReadSector(ByteToSector(i * SectorSize), data);
         for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
 	    if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 		printf("%c", data[j]);
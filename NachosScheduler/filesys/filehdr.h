@@ -17,19 +17,28 @@
 #include "disk.h"
 #include "pbitmap.h"
 
-#define NumDirect 	((SectorSize - 2 * sizeof(int)) / sizeof(int))
-#define MaxFileSize 	(NumDirect * SectorSize)
+// A run of consecutive sectors holding part of a file.
+
+class Extent {
+  public:
+    int start;				// its first sector
+    int length;				// how many sectors, or 0 if unused
+};
+
+#define NumExtents 	((int) ((SectorSize - 2 * sizeof(int)) / sizeof(Extent)))
+#define MaxFileSize 	(NumSectors * SectorSize)
 
 // The following class defines the Nachos "file header" (in UNIX terms,  
 // the "i-node"), describing where on disk to find all of the data in the file.
-// The file header is organized as a simple table of pointers to
-// data blocks. 
+// The file header is organized as a table of extents -- runs of
+// consecutive data blocks -- in the order of the file.
 //
 // The file header data structure can be stored in memory or on disk.
 // When it is on disk, it is stored in a single sector -- this means
 // that we assume the size of this data structure to be the same
-// as one disk sector.  Without indirect addressing, this
-// limits the maximum file length to just under 4K bytes.
+// as one disk sector.  That leaves room for NumExtents extents, of any
+// length: a file can be as big as the free space on the disk, as long
+// as that space is in no more than NumExtents runs.
 //
 // There is no constructor; rather the file header can be initialized
 // by allocating blocks for the file (if it is a new file), or by
@@ -37,9 +46,11 @@
 
 class FileHeader {
   public:
-    bool Allocate(PersistentBitmap *bitMap, int fileSize);// Initialize a file header, 
+    bool Allocate(PersistentBitmap *bitMap, int fileSize, int hint);
+						// Initialize a file header, 
 						//  including allocating space 
-						//  on disk for the file data
+						//  on disk for the file data,
+						//  near sector "hint"
     void Deallocate(PersistentBitmap *bitMap);  // De-allocate this file's 
 						//  data blocks
 
@@ -59,8 +70,8 @@ class FileHeader {
   private:
     int numBytes;			// Number of bytes in the file
     int numSectors;			// Number of data sectors in the file
-    int dataSectors[NumDirect];		// Disk sector numbers for each data 
-					// block in the file
+    Extent extents[NumExtents];		// Where the data blocks are, in
+					// the order of the file
 };
 
 #endif // FILEHDR_H
@@ -21,20 +21,29 @@
 //	The file system assumes that the bitmap and directory files are
 //	kept "open" continuously while Nachos is running.
 //
-//	For those operations (such as Create, Remove) that modify the
-//	directory and/or bitmap, if the operation succeeds, the changes
-//	are written immediately back to disk (the two files are kept
-//	open during all this time).  If the operation fails, and we have
-//	modified part of the directory and/or bitmap, we simply discard
-//	the changed version, without writing it back to disk.
+//	The bitmap and the directory are read in once, when Nachos starts,
+//	and kept in memory, so that opening a file doesn't read the
+//	directory again.  For those operations (such as Create, Remove)
+//	that modify the directory and/or bitmap, if the operation
+//	succeeds, what changed is marked dirty, and written back to disk
+//	once the operation is done (see Sync) -- to the buffer cache, if
+//	there is one (see buffercache.h).  If the operation fails, we
+//	undo what we modified of the directory and/or bitmap, and write
+//	nothing.  A lock lets only one operation run at a time.
+//
+//	What an operation writes goes to the journal (see journal.h), and
+//	only from there to its place on the disk, so that if Nachos stops
+//	with the operation half done, it is either done or undone when
+//	Nachos starts again.  The journal has the last track before the
+//	swap area.
 //
 // 	Our implementation at this point has the following restrictions:
 //
-//	   there is no synchronization for concurrent accesses
 //	   files have a fixed size, set when the file is created
-//	   files cannot be bigger than about 3KB in size
-//	   there is no hierarchical directory structure, and only a limited
-//	     number of files can be added to the system
+//	   files cannot be bigger than the free space on the disk, in
+//	     no more than NumExtents pieces (see filehdr.h)
+//	   there is no hierarchical directory structure, and the directory
+//	     can only grow as big as a file can be (see MaxDirEntries)
 //	   there is no attempt to make the system robust to failures
 //	    (if Nachos exits in the middle of an operation that modifies
 //	    the file system, it may corrupt the disk)
@@ -51,6 +60,11 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "synchdisk.h"
+#include "journal.h"
+#include "filetable.h"
+#include "synch.h"
+#include "main.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -58,12 +72,24 @@
 #define FreeMapSector 		0
 #define DirectorySector 	1
 
-// Initial file sizes for the bitmap and directory; until the file system
-// supports extensible files, the directory size sets the maximum number 
-// of files that can be loaded onto the disk.
+// Initial file sizes for the bitmap and directory; the directory is
+// given a bigger file when it gets crowded (see MakeRoom), up to the
+// size of the biggest file, which sets the maximum number of files that
+// can be loaded onto the disk.
 #define FreeMapFileSize 	(NumSectors / BitsInByte)
 #define NumDirEntries 		10
 #define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
+#define MaxDirEntries 		((int) (MaxFileSize / sizeof(DirectoryEntry)))
+
+// The part of the disk the file system has is divided into groups of
+// tracks.  A new file goes in the first group, from the directory's,
+// with room for all of it, so that files are near the directory, and
+// their data is near their headers (see Group).
+#define SectorsPerGroup 	(4 * SectorsPerTrack)
+#define NumGroups 		(FirstSwapSector / SectorsPerGroup)
+
+// Where the journal is kept.
+#define JournalSector 		(FirstSwapSector - JournalSectors)
 
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
@@ -73,7 +99,8 @@
 //	not all of the sectors marked as free).  
 //
 //	If format = FALSE, we just have to open the files
-//	representing the bitmap and the directory.
+//	representing the bitmap and the directory, and read them in --
+//	once the journal has written home the operations committed to it.
 //
 //	"format" -- should we initialize the disk?
 //----------------------------------------------------------------------
@@ -81,9 +108,14 @@
 FileSystem::FileSystem(bool format)
 { 
     DEBUG(dbgFile, "Initializing the file system.");
+    lock = new Lock("file system");
+    freeMapDirty = directoryDirty = FALSE;
+    journal = new Journal(kernel->synchDisk, JournalSector, format);
+    kernel->synchDisk->UseJournal(journal);
+    openFiles = new OpenFileTable();
     if (format) {
-        PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
-        Directory *directory = new Directory(NumDirEntries);
+        freeMap = new PersistentBitmap(NumSectors);
+        directory = new Directory(NumDirEntries);
 	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
 
@@ -93,12 +125,15 @@ FileSystem::FileSystem(bool format)
     // (make sure no one else grabs these!)
 	freeMap->Mark(FreeMapSector);	    
 	freeMap->Mark(DirectorySector);
+	for (int i = JournalSector; i < NumSectors; i++) {
+	    freeMap->Mark(i);		// and the journal and the swap area
+	}
 
     // Second, allocate space for the data blocks containing the contents
     // of the directory and bitmap files.  There better be enough space!
 
-	ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize));
-	ASSERT(dirHdr->Allocate(freeMap, DirectoryFileSize));
+	ASSERT(mapHdr->Allocate(freeMap, FreeMapFileSize, FreeMapSector));
+	ASSERT(dirHdr->Allocate(freeMap, DirectoryFileSize, DirectorySector));
 
     // Flush the bitmap and directory FileHeaders back to disk
     // We need to do this before we can "Open" the file, since open
@@ -113,8 +148,8 @@ FileSystem::FileSystem(bool format)
     // The file system operations assume these two files are left open
     // while Nachos is running.
 
-        freeMapFile = new OpenFile(FreeMapSector);
-        directoryFile = new OpenFile(DirectorySector);
+        freeMapFile = openFiles->Open(FreeMapSector);
+        directoryFile = openFiles->Open(DirectorySector);
      
     // Once we have the files "open", we can write the initial version
     // of each file back to disk.  The directory at this point is completely
@@ -126,22 +161,41 @@ FileSystem::FileSystem(bool format)
 	freeMap->WriteBack(freeMapFile);	 // flush changes to disk
 	directory->WriteBack(directoryFile);
 
-	if (debug->IsEnabled('f')) {
+	if (DEBUG_ON(dbgFile)) {
 	    freeMap->Print();
 	    directory->Print();
         }
-        delete freeMap; 
-	delete directory; 
 	delete mapHdr; 
 	delete dirHdr;
     } else {
     // if we are not formatting the disk, just open the files representing
     // the bitmap and directory; these are left open while Nachos is running
-        freeMapFile = new OpenFile(FreeMapSector);
-        directoryFile = new OpenFile(DirectorySector);
+        freeMapFile = openFiles->Open(FreeMapSector);
+        directoryFile = openFiles->Open(DirectorySector);
+        freeMap = new PersistentBitmap(freeMapFile, NumSectors);
+        directory = new Directory(NumDirEntries);
+        directory->FetchFrom(directoryFile);
     }
 }
 
+//----------------------------------------------------------------------
+// FileSystem::~FileSystem
+// 	De-allocate the file system.  Every operation has written back
+//	what it changed, so there is nothing left to write.
+//----------------------------------------------------------------------
+
+FileSystem::~FileSystem()
+{
+    ASSERT(!freeMapDirty && !directoryDirty);
+    delete freeMap;
+    delete directory;
+    delete freeMapFile;
+    delete directoryFile;
+    delete openFiles;
+    delete lock;
+    delete journal;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::Create
 // 	Create a file in the Nachos file system (similar to UNIX create).
@@ -150,11 +204,13 @@ FileSystem::FileSystem(bool format)
 //
 //	The steps to create a file are:
 //	  Make sure the file doesn't already exist
+//	  Make the directory bigger, if it is crowded
 //        Allocate a sector for the file header
 // 	  Allocate space on disk for the data blocks for the file
 //	  Add the name to the directory
 //	  Store the new file header on disk 
 //	  Flush the changes to the bitmap and the directory back to disk
+//	    (see Sync)
 //
 //	Return TRUE if everything goes ok, otherwise, return FALSE.
 //
@@ -164,9 +220,6 @@ FileSystem::FileSystem(bool format)
 //	 	no free entry for file in directory
 //	 	no free space for data blocks for the file 
 //
-// 	Note that this implementation assumes there is no concurrent access
-//	to the file system!
-//
 //	"name" -- name of file to be created
 //	"initialSize" -- size of file to be created
 //----------------------------------------------------------------------
@@ -174,42 +227,49 @@ FileSystem::FileSystem(bool format)
 bool
 FileSystem::Create(char *name, int initialSize)
 {
-    Directory *directory;
-    PersistentBitmap *freeMap;
     FileHeader *hdr;
-    int sector;
+    int numSectors = divRoundUp(initialSize, SectorSize);
+    int sector, length;
     bool success;
 
     DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
 
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
-
+    lock->Acquire();
+    journal->Begin();
     if (directory->Find(name) != -1)
       success = FALSE;			// file is already in directory
     else {	
-        freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-        sector = freeMap->FindAndSet();	// find a sector to hold the file header
+        if (directory->IsCrowded())
+            MakeRoom();
+        // find a sector to hold the file header, with room for the
+        // data right after it
+        sector = freeMap->FindRun(1 + numSectors, Group(1 + numSectors),
+				  &length);
+        if (sector != -1)
+            freeMap->Mark(sector);
     	if (sector == -1) 		
             success = FALSE;		// no free block for file header 
-        else if (!directory->Add(name, sector))
+        else if (!directory->Add(name, sector)) {
             success = FALSE;	// no space in directory
-	else {
+            freeMap->Clear(sector);
+	} else {
     	    hdr = new FileHeader;
-	    if (!hdr->Allocate(freeMap, initialSize))
+	    if (!hdr->Allocate(freeMap, initialSize, sector + 1)) {
             	success = FALSE;	// no space on disk for data
-	    else {	
+		directory->Remove(name);	// (Allocate took none)
+		freeMap->Clear(sector);
+	    } else {	
 	    	success = TRUE;
 		// everthing worked, flush all changes back to disk
     	    	hdr->WriteBack(sector); 		
-    	    	directory->WriteBack(directoryFile);
-    	    	freeMap->WriteBack(freeMapFile);
+		freeMapDirty = directoryDirty = TRUE;
 	    }
             delete hdr;
 	}
-        delete freeMap;
     }
-    delete directory;
+    Sync();				// (MakeRoom may have changed them)
+    journal->End();
+    lock->Release();
     return success;
 }
 
@@ -218,7 +278,8 @@ FileSystem::Create(char *name, int initialSize)
 // 	Open a file for reading and writing.  
 //	To open a file:
 //	  Find the location of the file's header, using the directory 
-//	  Bring the header into memory
+//	  Bring the header into memory, unless the file is open already
+//	    (see OpenFileTable::Open)
 //
 //	"name" -- the text name of the file to be opened
 //----------------------------------------------------------------------
@@ -226,16 +287,15 @@ FileSystem::Create(char *name, int initialSize)
 OpenFile *
 FileSystem::Open(char *name)
 { 
-    Directory *directory = new Directory(NumDirEntries);
     OpenFile *openFile = NULL;
     int sector;
 
     DEBUG(dbgFile, "Opening file" << name);
-    directory->FetchFrom(directoryFile);
+    lock->Acquire();
     sector = directory->Find(name); 
     if (sector >= 0) 		
-	openFile = new OpenFile(sector);	// name was found in directory 
-    delete directory;
+	openFile = openFiles->Open(sector);	// name was found in directory
+    lock->Release();
     return openFile;				// return NULL if not found
 }
 
@@ -245,7 +305,7 @@ FileSystem::Open(char *name)
 //	    Remove it from the directory
 //	    Delete the space for its header
 //	    Delete the space for its data blocks
-//	    Write changes to directory, bitmap back to disk
+//	    Write changes to directory, bitmap back to disk (see Sync)
 //
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
 //	in the file system.
@@ -256,32 +316,29 @@ FileSystem::Open(char *name)
 bool
 FileSystem::Remove(char *name)
 { 
-    Directory *directory;
-    PersistentBitmap *freeMap;
     FileHeader *fileHdr;
     int sector;
     
-    directory = new Directory(NumDirEntries);
-    directory->FetchFrom(directoryFile);
+    lock->Acquire();
     sector = directory->Find(name);
     if (sector == -1) {
-       delete directory;
+       lock->Release();
        return FALSE;			 // file not found 
     }
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
-    freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
     directory->Remove(name);
+    openFiles->Forget(sector);		// if it is open, it stays so
 
-    freeMap->WriteBack(freeMapFile);		// flush to disk
-    directory->WriteBack(directoryFile);        // flush to disk
+    freeMapDirty = directoryDirty = TRUE;
+    journal->Begin();
+    Sync();					// flush to disk
+    journal->End();
+    lock->Release();
     delete fileHdr;
-    delete directory;
-    delete freeMap;
     return TRUE;
 } 
 
@@ -293,11 +350,9 @@ FileSystem::Remove(char *name)
 void
 FileSystem::List()
 {
-    Directory *directory = new Directory(NumDirEntries);
-
-    directory->FetchFrom(directoryFile);
+    lock->Acquire();
     directory->List();
-    delete directory;
+    lock->Release();
 }
 
 //----------------------------------------------------------------------
@@ -315,9 +370,8 @@ FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,NumSectors);
-    Directory *directory = new Directory(NumDirEntries);
 
+    lock->Acquire();
     printf("Bit map file header:\n");
     bitHdr->FetchFrom(FreeMapSector);
     bitHdr->Print();
@@ -328,13 +382,98 @@ FileSystem::Print()
 
     freeMap->Print();
 
-    directory->FetchFrom(directoryFile);
     directory->Print();
+    lock->Release();
 
     delete bitHdr;
     delete dirHdr;
-    delete freeMap;
-    delete directory;
 } 
 
+//----------------------------------------------------------------------
+// FileSystem::MakeRoom
+// 	Give the directory, which is crowded, twice as many entries, and
+//	a file to fit them: new data sectors, in place of the old ones.
+//	If the file is as big as a file can be, just rehash the
+//	directory, dropping the marks left by removed files; if the disk
+//	is too full for a bigger file, leave it as it is.  Called with
+//	the file system's lock held.
+//----------------------------------------------------------------------
+
+void
+FileSystem::MakeRoom()
+{
+    int size = min(directory->Size() * 2, MaxDirEntries);
+    FileHeader *oldHdr, *newHdr;
+
+    if (size == directory->Size()) {
+        directory->Resize(size);
+        directoryDirty = TRUE;
+        return;
+    }
+    newHdr = new FileHeader;
+    if (!newHdr->Allocate(freeMap, size * sizeof(DirectoryEntry),
+			  DirectorySector)) {
+        delete newHdr;
+        return;				// no room on the disk
+    }
+    DEBUG(dbgFile, "Growing the directory to " << size << " entries.");
+    oldHdr = new FileHeader;
+    oldHdr->FetchFrom(DirectorySector);
+    oldHdr->Deallocate(freeMap);
+    newHdr->WriteBack(DirectorySector);
+    delete directoryFile;
+    directoryFile = openFiles->Open(DirectorySector);
+    directory->Resize(size);
+    freeMapDirty = directoryDirty = TRUE;
+    delete oldHdr;
+    delete newHdr;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Group
+// 	Return the first sector of the group where a new file of
+//	"numSectors" sectors, its header included, should go: the first,
+//	from the directory's group on, with that many sectors free.  If
+//	no group has, the file goes near the directory, in as few runs
+//	as there can be.  Called with the file system's lock held.
+//----------------------------------------------------------------------
+
+int
+FileSystem::Group(int numSectors)
+{
+    int home = DirectorySector / SectorsPerGroup;
+
+    for (int n = 0; n < NumGroups; n++) {
+	int group = (home + n) % NumGroups;
+
+	if (freeMap->NumClear(group * SectorsPerGroup, SectorsPerGroup)
+	    >= numSectors)
+	    return group * SectorsPerGroup;
+    }
+    return DirectorySector;
+}
+
+//----------------------------------------------------------------------
+// FileSystem::Sync
+// 	Write the bitmap and the directory back to their files, if
+//	either has changed since it was last written.  Called with the
+//	file system's lock held.
+//----------------------------------------------------------------------
+
+void
+FileSystem::Sync()
+{
+    ASSERT(lock->IsHeldByCurrentThread());
+    if (freeMapDirty) {
+        DEBUG(dbgFile, "Writing the bitmap back to disk.");
+        freeMap->WriteBack(freeMapFile);
+        freeMapDirty = FALSE;
+    }
+    if (directoryDirty) {
+        DEBUG(dbgFile, "Writing the directory back to disk.");
+        directory->WriteBack(directoryFile);
+        directoryDirty = FALSE;
+    }
+}
+
 #endif // FILESYS_STUB
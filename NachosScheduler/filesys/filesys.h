@@ -56,7 +56,7 @@ class FileSystem {
 	  int fileDescriptor = OpenForReadWrite(name, FALSE);
 
 	  if (fileDescriptor == -1) return NULL;
-	  return new OpenFile(fileDescriptor);
+	  return new OpenFile(fileDescriptor, StubBufferSize);
       }
 
     bool Remove(char *name) { return Unlink(name) == 0; }
@@ -64,6 +64,12 @@ class FileSystem {
 };
 
 #else // FILESYS
+class Directory;
+class PersistentBitmap;
+class Journal;
+class OpenFileTable;
+class Lock;
+
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
@@ -72,6 +78,7 @@ class FileSystem {
     					// If "format", there is nothing on
 					// the disk, so initialize the directory
     					// and the bitmap of free blocks.
+    ~FileSystem();
 
     bool Create(char *name, int initialSize);  	
 					// Create a file (UNIX creat)
@@ -89,6 +96,19 @@ class FileSystem {
 					// represented as a file
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   PersistentBitmap *freeMap;		// the bitmap and the directory,
+   Directory *directory;		// kept in memory
+   bool freeMapDirty;			// changed since they were last
+   bool directoryDirty;			// written back
+   Lock *lock;				// one operation at a time
+   Journal *journal;			// what an operation writes goes here
+   OpenFileTable *openFiles;		// the files open, these two among
+					// them
+
+   void MakeRoom();			// Give the directory more entries
+   int Group(int numSectors);		// Where a new file should go
+   void Sync();				// Write the directory and the bitmap
+					// back, if they have changed
 };
 
 #endif // FILESYS
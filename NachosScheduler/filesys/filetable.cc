@@ -0,0 +1,125 @@
+// filetable.cc
+//	Routines to keep the table of the files that are open.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "filetable.h"
+#include "filehdr.h"
+#include "openfile.h"
+#include "synch.h"
+#include "debug.h"
+
+static int
+SharedFileSector(SharedFile *file)
+{
+    return file->sector;
+}
+
+static unsigned
+HashSector(int sector)
+{
+    return (unsigned) sector;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::OpenFileTable
+// 	Initialize an empty table of the files that are open.
+//----------------------------------------------------------------------
+
+OpenFileTable::OpenFileTable()
+{
+    files = new OpenHashTable<int, SharedFile *>(SharedFileSector,
+						    HashSector);
+    lock = new Lock("open file table");
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::~OpenFileTable
+// 	De-allocate the table.  The entries of files still open are left
+//	allocated: their OpenFiles still have them.
+//----------------------------------------------------------------------
+
+OpenFileTable::~OpenFileTable()
+{
+    delete files;
+    delete lock;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Open
+// 	Return a new OpenFile for the file whose header is at "sector".
+//	If the file is open already, the OpenFile shares its header;
+//	otherwise the header is read in first.
+//
+//	"sector" -- the location on disk of the file's header
+//----------------------------------------------------------------------
+
+OpenFile *
+OpenFileTable::Open(int sector)
+{
+    SharedFile *file;
+
+    lock->Acquire();
+    if (files->Find(sector, &file)) {
+        DEBUG(dbgFile, "Sharing the open header at sector " << sector);
+    } else {
+        file = new SharedFile;
+        file->sector = sector;
+        file->hdr = new FileHeader;
+        file->hdr->FetchFrom(sector);
+        file->lock = new Lock("open file");
+        file->numOpens = 0;
+        file->removed = FALSE;
+        files->Insert(file);
+    }
+    file->numOpens++;
+    lock->Release();
+    return new OpenFile(this, file);
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Close
+// 	Note that an OpenFile for "file" is closed, and, if it was the
+//	last, that the file isn't open any more.
+//----------------------------------------------------------------------
+
+void
+OpenFileTable::Close(SharedFile *file)
+{
+    lock->Acquire();
+    ASSERT(file->numOpens > 0);
+    if (--file->numOpens == 0) {
+        if (!file->removed) {
+            (void) files->Remove(file->sector);
+        }
+        delete file->hdr;
+        delete file->lock;
+        delete file;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Forget
+// 	The file whose header is at "sector" is being removed: if it is
+//	open, take it out of the table, so the sector can be reused.
+//----------------------------------------------------------------------
+
+void
+OpenFileTable::Forget(int sector)
+{
+    SharedFile *file;
+
+    lock->Acquire();
+    if (files->Find(sector, &file)) {
+        (void) files->Remove(sector);
+        file->removed = TRUE;
+    }
+    lock->Release();
+}
+
+#endif // FILESYS_STUB
@@ -0,0 +1,61 @@
+// filetable.h
+//	Data structures for the table of the files that are open, kept by
+//	the file system (see FileSystem::Open).
+//
+//	A file open several times at once -- by several threads, or by
+//	the same one twice -- has the one entry in the table: its header
+//	is read from the disk when the file is first opened, and the
+//	OpenFiles for it all share it, until the last of them is closed.
+//	Each OpenFile has a position of its own (see OpenFile::Seek), but
+//	reads and writes of the file take the entry's lock, so that two
+//	writes of the same sector don't lose one of them.
+//
+//	A file removed while it is open keeps its entry until it is
+//	closed, but is taken out of the table, so that a file created in
+//	its place later has an entry of its own.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include "copyright.h"
+#include "openhash.h"
+
+class FileHeader;
+class OpenFile;
+class Lock;
+
+// A file that is open, and what its OpenFiles share.
+
+class SharedFile {
+  public:
+    int sector;			// where its header is on the disk
+    FileHeader *hdr;		// the header, read in when it was opened
+    Lock *lock;			// held by a read or a write of it
+    int numOpens;		// OpenFiles for it not yet closed
+    bool removed;		// taken out of the table
+};
+
+// The following class keeps the files that are open, by the sectors
+// of their headers.
+
+class OpenFileTable {
+  public:
+    OpenFileTable();		// no file open
+    ~OpenFileTable();
+
+    OpenFile *Open(int sector);	// Open the file whose header is
+				// at "sector", sharing its entry if
+				// it is open already
+    void Close(SharedFile *file);	// an OpenFile for it is closed
+    void Forget(int sector);	// the file is being removed
+
+  private:
+    OpenHashTable<int, SharedFile *> *files;	// the files open, by sector
+    Lock *lock;			// for the table
+};
+
+#endif // FILETABLE_H
@@ -0,0 +1,415 @@
+// journal.cc
+//	Routines to log the writes of file system operations, commit them
+//	to the journal a batch at a time, and write them home.
+//
+//	The journal's first sector says which commit the log starts with;
+//	the log follows it.  A commit is a descriptor sector -- the magic
+//	number, the commit's number, the sectors it has, and the number
+//	of each -- their contents, then the descriptor again, with the
+//	commit magic number.  A commit counts only once that last sector
+//	is on the disk; recovery stops at the first that isn't.
+//
+//	The pending sectors are looked through one by one: a commit
+//	holds fewer than thirty of them.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "journal.h"
+#include "synchdisk.h"
+#include "bitmap.h"
+#include "synch.h"
+#include "main.h"
+
+// What the journal's sectors start with.
+const int JournalMagic = 0x4a524e4c;	// its first sector
+const int DescriptorMagic = 0x44455343;	// a commit's descriptor
+const int CommitMagic = 0x434f4d4d;	// and its last sector
+
+const int RecordWords = SectorSize / sizeof(int);
+
+//----------------------------------------------------------------------
+// Journal::Journal
+// 	Initialize the journal kept in the JournalSectors from
+//	"firstSector": empty, if the disk is being formatted, or else
+//	with whatever was committed to it since the last checkpoint
+//	written home.
+//
+//	"synchDisk" -- the disk the journal is on
+//	"firstSector" -- the first of its sectors
+//	"format" -- is there nothing on the disk yet?
+//----------------------------------------------------------------------
+
+Journal::Journal(SynchDisk *synchDisk, int firstSector, bool format)
+{
+    disk = synchDisk;
+    first = firstSector;
+    logged = new Bitmap(NumSectors);
+    numPending = numOperations = 0;
+    lock = new Lock("journal");
+    owner = NULL;
+    ended = new Condition("journal operation ended");
+    begun = new Condition("journal operation begun");
+    commitTime = new Semaphore("journal commit", 0);
+    committer = NULL;
+
+    lock->Acquire();
+    if (format) {
+        sequence = 1;
+        Checkpoint();			// (there is nothing to flush)
+    } else {
+        Recover();
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::~Journal
+// 	De-allocate the journal.  If there is a committer, it is waiting,
+//	so, as with the cache's flusher, what it waits on is left
+//	allocated.
+//----------------------------------------------------------------------
+
+Journal::~Journal()
+{
+    if (numPending > 0) {
+        DEBUG(dbgFile, numPending << " sectors of the journal lost");
+    }
+    delete logged;
+    if (committer == NULL) {
+        delete lock;
+        delete ended;
+        delete begun;
+        delete commitTime;
+    }
+}
+
+//----------------------------------------------------------------------
+// Journal::Begin
+// 	Start an operation of this thread's: what it writes until End is
+//	logged.  If what is pending might not leave room for it in one
+//	commit, commit that first.
+//----------------------------------------------------------------------
+
+void
+Journal::Begin()
+{
+    lock->Acquire();
+    while (owner != NULL) {
+        ended->Wait(lock);		// one operation at a time
+    }
+    if (numPending + OperationSectors > MaxLogged) {
+        CommitPending();
+    }
+    owner = kernel->currentThread;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::End
+// 	End this thread's operation.  What it wrote is committed with
+//	the operations that come after it; start the committer, the
+//	first time, or tell it if it is waiting for something to commit.
+//----------------------------------------------------------------------
+
+void
+Journal::End()
+{
+    lock->Acquire();
+    ASSERT(owner == kernel->currentThread);
+    owner = NULL;
+    ended->Broadcast(lock);
+    if (numPending > 0) {
+        if (numOperations++ == 0) {
+            begun->Signal(lock);
+        }
+        if (committer == NULL) {
+            committer = new Thread("journal committer",
+                                   kernel->threads->NewID());
+            committer->Fork((VoidFunctionPtr) &Journal::CommitterThread,
+                            (void *) this);
+        }
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::Write
+// 	Log the write of sector "sectorNumber", if this thread is doing
+//	an operation, and return TRUE.  Otherwise return FALSE: the
+//	caller writes it in place.  But if an older copy of it is pending,
+//	or in the log, it would be written over the new one later -- the
+//	sector was the file system's, and has been freed -- so first
+//	commit what is pending, and checkpoint.
+//
+//	"sectorNumber" -- the sector written
+//	"data" -- its new contents
+//----------------------------------------------------------------------
+
+bool
+Journal::Write(int sectorNumber, char *data)
+{
+    int i;
+
+    lock->Acquire();
+    if (owner != kernel->currentThread) {
+        if (Pending(sectorNumber) != -1 || logged->Test(sectorNumber)) {
+            while (owner != NULL) {
+                ended->Wait(lock);
+            }
+            CommitPending();
+            Checkpoint();
+        }
+        lock->Release();
+        return FALSE;
+    }
+    if ((i = Pending(sectorNumber)) == -1) {
+        if (numPending == MaxLogged) {
+            DEBUG(dbgFile, "Operation too big for one commit");
+            CommitPending();		// so it is not atomic
+        }
+        i = numPending++;
+        pendingSectors[i] = sectorNumber;
+    }
+    bcopy(data, pendingData[i], SectorSize);
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Journal::Read
+// 	Copy sector "sectorNumber" into "data", and return TRUE, if it is
+//	pending: the copy at home is older.  Otherwise return FALSE.
+//
+//	"sectorNumber" -- the sector read
+//	"data" -- where its contents go
+//----------------------------------------------------------------------
+
+bool
+Journal::Read(int sectorNumber, char *data)
+{
+    int i;
+
+    lock->Acquire();
+    if ((i = Pending(sectorNumber)) != -1) {
+        bcopy(pendingData[i], data, SectorSize);
+    }
+    lock->Release();
+    return i != -1;
+}
+
+//----------------------------------------------------------------------
+// Journal::Commit
+// 	Commit every operation that has ended, once the one going on,
+//	if any, has too, and return once they are in the log.
+//----------------------------------------------------------------------
+
+void
+Journal::Commit()
+{
+    lock->Acquire();
+    while (owner != NULL) {
+        ended->Wait(lock);
+    }
+    CommitPending();
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Journal::CommitPending
+// 	Write the pending sectors to the log in one run after the last
+//	commit, checkpointing first if they don't fit (or else flushing
+//	the cache, so that the data written in place is there first);
+//	then the commit sector, and once that is on the disk, write them
+//	home.  The descriptor and the sectors are written in one disk
+//	request, and the commit sector once they are there.  The lock is
+//	held.
+//----------------------------------------------------------------------
+
+void
+Journal::CommitPending()
+{
+    int record[RecordWords];
+    char *run[MaxLogged + 1];
+
+    ASSERT(lock->IsHeldByCurrentThread());
+    if (numPending == 0) {
+        return;
+    }
+    if (next + numPending + 2 > JournalSectors) {
+        Checkpoint();
+    } else if (disk->cache != NULL) {
+        disk->cache->Flush();
+    }
+    DEBUG(dbgFile, "Committing " << numPending << " sectors of "
+	  << numOperations << " operations as " << sequence);
+    bzero(record, sizeof(record));
+    record[0] = DescriptorMagic;
+    record[1] = sequence;
+    record[2] = numPending;
+    for (int i = 0; i < numPending; i++) {
+        record[3 + i] = pendingSectors[i];
+    }
+    run[0] = (char *) record;
+    for (int i = 0; i < numPending; i++) {
+        run[1 + i] = pendingData[i];
+    }
+    disk->TransferRun(first + next, numPending + 1, run, TRUE);
+    record[0] = CommitMagic;
+    disk->Transfer(first + next + 1 + numPending, (char *) record, TRUE);
+
+    for (int i = 0; i < numPending; i++) {	// committed: now home
+        disk->WriteHome(pendingSectors[i], pendingData[i]);
+        logged->Mark(pendingSectors[i]);
+    }
+    kernel->stats->numJournalCommits++;
+    kernel->stats->numJournalOperations += numOperations;
+    kernel->stats->numJournalSectors += numPending;
+    next += numPending + 2;
+    sequence++;
+    numPending = numOperations = 0;
+}
+
+//----------------------------------------------------------------------
+// Journal::Checkpoint
+// 	Make sure every sector in the log is home -- flushing the cache
+//	-- then start the log again from the beginning, with the next
+//	commit.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+Journal::Checkpoint()
+{
+    int record[RecordWords];
+
+    ASSERT(lock->IsHeldByCurrentThread());
+    if (disk->cache != NULL) {
+        disk->cache->Flush();
+    }
+    bzero(record, sizeof(record));
+    record[0] = JournalMagic;
+    record[1] = sequence;
+    disk->Transfer(first, (char *) record, TRUE);
+    next = 1;
+    for (int s = logged->NextSet(0); s < NumSectors;
+         s = logged->NextSet(s + 1)) {
+        logged->Clear(s);
+    }
+    kernel->stats->numJournalCheckpoints++;
+}
+
+//----------------------------------------------------------------------
+// Journal::Recover
+// 	Write home the sectors of every commit in the log, in order,
+//	up to the first that is not all there; then checkpoint.  The
+//	lock is held; nothing else has read the disk yet.
+//----------------------------------------------------------------------
+
+void
+Journal::Recover()
+{
+    int record[RecordWords];
+    int commit[RecordWords];
+    char data[SectorSize];
+
+    disk->Transfer(first, (char *) record, FALSE);
+    ASSERT(record[0] == JournalMagic);	// formatted with a journal (-f)
+    sequence = record[1];
+    for (next = 1; next + 2 <= JournalSectors; ) {
+        int count;
+
+        disk->Transfer(first + next, (char *) record, FALSE);
+        count = record[2];
+        if (record[0] != DescriptorMagic || record[1] != sequence
+            || count < 1 || count > MaxLogged
+            || next + count + 2 > JournalSectors) {
+            break;			// the end of the log
+        }
+        disk->Transfer(first + next + 1 + count, (char *) commit, FALSE);
+        if (commit[0] != CommitMagic || commit[1] != sequence
+            || commit[2] != count) {
+            break;			// never committed
+        }
+        DEBUG(dbgFile, "Recovering " << count << " sectors of "
+	      << sequence);
+        for (int i = 0; i < count; i++) {
+            disk->Transfer(first + next + 1 + i, data, FALSE);
+            disk->WriteHome(record[3 + i], data);
+        }
+        kernel->stats->numJournalRecovered += count;
+        next += count + 2;
+        sequence++;
+    }
+    if (next > 1) {
+        Checkpoint();
+    }
+}
+
+//----------------------------------------------------------------------
+// Journal::Pending
+// 	Return where, of the pending sectors, sector "sectorNumber" is,
+//	or -1 if it isn't.  The lock is held.
+//----------------------------------------------------------------------
+
+int
+Journal::Pending(int sectorNumber)
+{
+    for (int i = 0; i < numPending; i++) {
+        if (pendingSectors[i] == sectorNumber) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Journal::CallBack
+// 	The commit interrupt: wake the committer.
+//----------------------------------------------------------------------
+
+void
+Journal::CallBack()
+{
+    commitTime->V();
+}
+
+//----------------------------------------------------------------------
+// Journal::CommitterThread
+// 	The committer thread starts here.
+//----------------------------------------------------------------------
+
+void
+Journal::CommitterThread(Journal *journal)
+{
+    journal->CommitForever();
+}
+
+//----------------------------------------------------------------------
+// Journal::CommitForever
+// 	Wait until an operation has ended, then JournalCommitDelay ticks
+//	more, and commit it, with those that ended in the meantime; and
+//	again.  No interrupt is pending for us while nothing is.
+//----------------------------------------------------------------------
+
+void
+Journal::CommitForever()
+{
+    for (;;) {
+        IntStatus oldLevel;
+
+        lock->Acquire();
+        while (numOperations == 0) {
+            begun->Wait(lock);
+        }
+        lock->Release();
+
+        oldLevel = kernel->interrupt->SetLevel(IntOff);
+        kernel->interrupt->Schedule(this, JournalCommitDelay,
+                                    JournalCommitInt);
+        (void) kernel->interrupt->SetLevel(oldLevel);
+        commitTime->P();
+        Commit();
+    }
+}
@@ -0,0 +1,125 @@
+// journal.h
+//	Data structures for a write-ahead journal of the file system's
+//	metadata (see FileSystem).
+//
+//	Creating or removing a file changes several sectors -- the file
+//	header, the free map, the directory -- and if Nachos stopped in
+//	between writing one and the next, the disk would be left with,
+//	say, a directory entry for a file whose sectors are still free.
+//	So what a file system operation writes, between Begin and End
+//	(an operation, or transaction), is kept in memory rather than
+//	written home, and the writes of several operations are then
+//	committed together, to the journal -- the last track before the
+//	swap area -- in one sequential run: a descriptor sector with the
+//	numbers of the sectors written, their contents, then a commit
+//	sector.  Only once the commit sector is on the disk are the
+//	sectors written home, through the cache (see buffercache.h),
+//	whenever it gets round to it.  A sector written by several of
+//	the operations is logged, and written home, just once.
+//
+//	Operations are committed JournalCommitDelay ticks after the first
+//	of them that hasn't been, or as soon as the next might not fit,
+//	or when a user program halts Nachos (see SysHalt); as with the
+//	cache, the thread that commits them only waits for its interrupt
+//	while there is something to commit.  When the journal is full,
+//	the cache is flushed, so that every sector logged is home, and
+//	the journal starts again from its first sector (a checkpoint).
+//
+//	When Nachos starts, the operations committed since the last
+//	checkpoint are written home again (recovered), so that each of
+//	them is either all on the disk or not there at all.  Only the
+//	metadata is logged: a file's data is written in place, as before,
+//	but the cache is flushed before each commit, so that the data of
+//	a file an operation committed is on the disk too.  An operation
+//	writing more sectors than one commit holds (growing a big
+//	directory) is committed in pieces, and so is not atomic.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "callback.h"
+
+class SynchDisk;
+class Bitmap;
+class Lock;
+class Condition;
+class Semaphore;
+class Thread;
+
+const int JournalSectors = SectorsPerTrack;	// the journal's track
+const int JournalCommitDelay = 10000;	// ticks an operation may wait
+					// to be committed
+const int MaxLogged = SectorSize / sizeof(int) - 3;
+					// sectors one commit holds: as many
+					// numbers as fit in a descriptor
+const int OperationSectors = 8;		// sectors an operation is expected
+					// to write, at most
+
+// The following class logs the file system's writes, commits them in
+// batches, and recovers them.
+
+class Journal : public CallBackObj {
+  public:
+    Journal(SynchDisk *synchDisk, int firstSector, bool format);
+					// The journal in the JournalSectors
+					// from "firstSector": if "format",
+					// empty it, or else recover what was
+					// committed there
+    ~Journal();
+
+    void Begin();			// the writes that follow, by this
+					// thread, are an operation ...
+    void End();				// ... up to here
+    bool Write(int sectorNumber, char *data);
+					// Log the write of a sector, if the
+					// thread is in an operation; or else
+					// return FALSE, to have it written
+					// in place
+    bool Read(int sectorNumber, char *data);
+					// Copy the sector, if it was logged
+					// but hasn't been committed yet
+    void Commit();			// commit the operations ended
+
+    void CallBack();			// the commit interrupt: time to
+					// commit
+
+  private:
+    SynchDisk *disk;			// where the journal is kept
+    int first;				// its first sector, which says
+					// where the log starts
+    int sequence;			// the number of the next commit
+    int next;				// where it goes, of JournalSectors
+    Bitmap *logged;			// the sectors logged since the last
+					// checkpoint
+
+    int pendingSectors[MaxLogged];	// the sectors written by the
+    char pendingData[MaxLogged][SectorSize];	// operations not yet
+    int numPending;			// committed ...
+    int numOperations;			// ... and how many of them there are
+
+    Lock *lock;				// for all of the above
+    Thread *owner;			// the thread doing an operation
+    Condition *ended;			// signalled when it is done
+    Condition *begun;			// and when there is one to commit
+    Semaphore *commitTime;		// V'd by the commit interrupt
+    Thread *committer;			// started the first time it is
+
+    void CommitPending();		// write what is pending to the log,
+					// then home; the lock is held
+    void Checkpoint();			// flush the cache, and empty the
+					// log; the lock is held
+    void Recover();			// write home the sectors committed
+    int Pending(int sectorNumber);	// where, of the pending sectors,
+					// it is, or -1
+
+    static void CommitterThread(Journal *journal);
+    void CommitForever();		// what the committer does
+};
+
+#endif // JOURNAL_H
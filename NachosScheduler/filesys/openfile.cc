@@ -5,42 +5,129 @@
 //	the OpenFile data structure).
 //
 //	Also as in UNIX, for convenience, we keep the file header in
-//	memory while the file is open.
+//	memory while the file is open -- one copy of it, however many
+//	times the file is open (see filetable.h), each OpenFile with a
+//	position of its own.
+//
+//	We watch how the file is read and written.  While each read
+//	carries on where the last one stopped, we have the sectors after
+//	it read ahead (see SynchDisk::ReadAhead), more of them each time,
+//	up to MaxReadAhead; a read anywhere else stops that.  While each
+//	write carries on where the last one stopped, the sectors it is
+//	done with are written behind, WriteBehindBatch at a time.
+//
+//	The sectors of a read or write that are one after another on the
+//	disk are read or written together (see SynchDisk::ReadSectors).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
-#ifndef FILESYS_STUB
+#ifdef FILESYS_STUB
+
+#include "copyright.h"
+#include "openfile.h"
+
+//----------------------------------------------------------------------
+// OpenFile::Init
+// 	Open the UNIX file "f", with a buffer of "size" bytes, unless it
+//	is 0.
+//----------------------------------------------------------------------
+
+void
+OpenFile::Init(int f, int size)
+{
+    file = f;
+    currentOffset = 0;
+    length = FileSize(file);
+    bufferSize = size;
+    buffer = (size > 0) ? new char[size] : NULL;
+    bufferStart = bufferBytes = 0;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::ReadAt
+// 	Read "numBytes" bytes of the file from "position" into "into", or
+//	as many as there are, and return how many: copy them out of the
+//	buffer, if they fit in it, having filled it from "position"
+//	first if they aren't all there.
+//----------------------------------------------------------------------
+
+int
+OpenFile::ReadAt(char *into, int numBytes, int position)
+{
+    int numRead;
+
+    if (buffer == NULL || numBytes > bufferSize)
+	return ReadPartialAt(file, into, numBytes, position);
+    if (position < bufferStart
+	|| position + numBytes > bufferStart + bufferBytes) {
+	bufferStart = position;
+	bufferBytes = max(ReadPartialAt(file, buffer, bufferSize, position), 0);
+    }
+    numRead = max(min(numBytes, bufferStart + bufferBytes - position), 0);
+    bcopy(&buffer[position - bufferStart], into, numRead);
+    return numRead;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::WriteAt
+// 	Write "numBytes" bytes from "from" to the file at "position", and
+//	to the part of the buffer that has them, if any.
+//----------------------------------------------------------------------
+
+int
+OpenFile::WriteAt(char *from, int numBytes, int position)
+{
+    int first = max(position, bufferStart);
+    int last = min(position + numBytes, bufferStart + bufferBytes);
+
+    WriteFileAt(file, from, numBytes, position);
+    if (buffer != NULL && first < last)
+	bcopy(&from[first - position], &buffer[first - bufferStart],
+	      last - first);
+    length = max(length, position + numBytes);
+    return numBytes;
+}
+
+#else // FILESYS
 
 #include "copyright.h"
 #include "main.h"
 #include "filehdr.h"
 #include "openfile.h"
+#include "filetable.h"
 #include "synchdisk.h"
+#include "synch.h"
 
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
-// 	Open a Nachos file for reading and writing.  Bring the file header
-//	into memory while the file is open.
+// 	Open a Nachos file for reading and writing.  The file header is
+//	in memory, in the file's entry in the table of open files, while
+//	the file is open.
 //
-//	"sector" -- the location on disk of the file header for this file
+//	"table" -- the table of open files
+//	"sharedFile" -- the file's entry there, counting this open
 //----------------------------------------------------------------------
 
-OpenFile::OpenFile(int sector)
+OpenFile::OpenFile(OpenFileTable *table, SharedFile *sharedFile)
 { 
-    hdr = new FileHeader;
-    hdr->FetchFrom(sector);
+    openFiles = table;
+    file = sharedFile;
+    hdr = file->hdr;
     seekPosition = 0;
+    nextRead = nextWrite = 0;
+    readWindow = readAheadTo = writtenBehind = 0;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	The header goes once the file's last OpenFile is closed.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
-    delete hdr;
+    openFiles->Close(file);
 }
 
 //----------------------------------------------------------------------
@@ -98,12 +185,14 @@ OpenFile::Write(char *into, int numBytes)
 //
 //	For ReadAt:
 //	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   request, but we only copy the part we are interested in.  If
+//	   the read follows on from the last one, we read ahead.
 //	For WriteAt:
 //	   We must first read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
 //	   in the data that will be modified, and write back all the full
-//	   or partial sectors that are part of the request.
+//	   or partial sectors that are part of the request.  If the write
+//	   follows on from the last one, we write behind.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -116,7 +205,7 @@ int
 OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
+    int firstSector, lastSector, numSectors;
     char *buf;
 
     if ((numBytes <= 0) || (position >= fileLength))
@@ -129,11 +218,20 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
+    if (position == nextRead) {		// sequential: read further ahead
+	readWindow = min(max(readWindow * 2, MinReadAhead), MaxReadAhead);
+    } else {
+	readWindow = readAheadTo = 0;
+    }
+    nextRead = position + numBytes;
+
     // read in all the full and partial sectors that we need
     buf = new char[numSectors * SectorSize];
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
+    file->lock->Acquire();		// not in the middle of a write
+    Transfer(buf, firstSector, lastSector, FALSE);
+    file->lock->Release();
+
+    ReadAhead(lastSector + 1);
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
@@ -145,7 +243,7 @@ int
 OpenFile::WriteAt(char *from, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
-    int i, firstSector, lastSector, numSectors;
+    int firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
     char *buf;
 
@@ -165,23 +263,110 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     lastAligned = ((position + numBytes) == ((lastSector + 1) * SectorSize));
 
 // read in first and last sector, if they are to be partially modified
+// (not through ReadAt, which would take this for a read of the file);
+// another write of the file in between would be lost
+    file->lock->Acquire();
     if (!firstAligned)
-        ReadAt(buf, SectorSize, firstSector * SectorSize);	
+        kernel->synchDisk->ReadSector(hdr->ByteToSector(firstSector * SectorSize),
+				      buf);
     if (!lastAligned && ((firstSector != lastSector) || firstAligned))
-        ReadAt(&buf[(lastSector - firstSector) * SectorSize], 
-				SectorSize, lastSector * SectorSize);	
+        kernel->synchDisk->ReadSector(hdr->ByteToSector(lastSector * SectorSize),
+				&buf[(lastSector - firstSector) * SectorSize]);
 
 // copy in the bytes we want to change 
     bcopy(from, &buf[position - (firstSector * SectorSize)], numBytes);
 
 // write modified sectors back
-    for (i = firstSector; i <= lastSector; i++)	
-        kernel->synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
-					&buf[(i - firstSector) * SectorSize]);
+    Transfer(buf, firstSector, lastSector, TRUE);
+    file->lock->Release();
     delete [] buf;
+
+    if (position != nextWrite) {	// not sequential: start over
+	writtenBehind = firstSector;
+    }
+    nextWrite = position + numBytes;
+    if (nextWrite == fileLength) {
+	WriteBehind(lastSector + 1);	// the last is done too
+    } else {
+	WriteBehind(divRoundDown(nextWrite, SectorSize));
+    }
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::Transfer
+// 	Read the file's sectors "firstSector" to "lastSector" into "buf",
+//	or if "writing", write them from it, a run of them at a time: as
+//	many as are one after another on the disk.
+//----------------------------------------------------------------------
+
+void
+OpenFile::Transfer(char *buf, int firstSector, int lastSector, bool writing)
+{
+    int numSectors = 1 + lastSector - firstSector;
+    char **parts = new char *[numSectors];
+    int i, n;
+
+    for (i = 0; i < numSectors; i++)
+	parts[i] = &buf[i * SectorSize];
+    for (i = 0; i < numSectors; i += n) {
+	int sector = hdr->ByteToSector((firstSector + i) * SectorSize);
+
+	for (n = 1; i + n < numSectors
+		    && hdr->ByteToSector((firstSector + i + n) * SectorSize)
+		       == sector + n; n++)
+	    ;
+	if (writing)
+	    kernel->synchDisk->WriteSectors(sector, n, &parts[i]);
+	else
+	    kernel->synchDisk->ReadSectors(sector, n, &parts[i]);
+    }
+    delete [] parts;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::ReadAhead
+// 	Have the next "readWindow" sectors of the file from "sector" on
+//	read ahead, those of them that haven't been, as far as the cache
+//	takes them; the rest are asked for after the next read.
+//
+//	"sector" -- the sector of the file after those just read
+//----------------------------------------------------------------------
+
+void
+OpenFile::ReadAhead(int sector)
+{
+    int last = min(sector + readWindow,
+		   divRoundUp(hdr->FileLength(), SectorSize));
+
+    for (readAheadTo = max(sector, readAheadTo); readAheadTo < last;
+	 readAheadTo++)
+	if (!kernel->synchDisk->ReadAhead(hdr->ByteToSector(readAheadTo
+							    * SectorSize)))
+	    break;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::WriteBehind
+// 	The sequential writes are done with the sectors of the file
+//	before "sector": have those not yet written behind written to
+//	the disk, once there are WriteBehindBatch of them, or at the
+//	end of the file.
+//
+//	"sector" -- the first sector of the file still being written
+//----------------------------------------------------------------------
+
+void
+OpenFile::WriteBehind(int sector)
+{
+    if (sector - writtenBehind < WriteBehindBatch
+	&& sector * SectorSize < hdr->FileLength())
+	return;
+    for (int i = writtenBehind; i < sector; i++)
+	kernel->synchDisk->WriteBehind(hdr->ByteToSector(i * SectorSize));
+    writtenBehind = max(writtenBehind, sector);
+}
+
 //----------------------------------------------------------------------
 // OpenFile::Length
 // 	Return the number of bytes in the file.
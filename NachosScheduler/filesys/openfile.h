@@ -27,20 +27,27 @@
 #ifdef FILESYS_STUB			// Temporarily implement calls to 
 					// Nachos file system as calls to UNIX!
 					// See definitions listed under #else
+
+// Each read or write is one system call, at its position in the UNIX
+// file (pread, pwrite), and the file's length is found out once, when
+// it is opened, and kept up to date as it is written -- by this
+// OpenFile: one open at the same time doesn't see it grow.  A file
+// can also be given a buffer: a read that fits in it, but isn't in
+// it, fills it with the bytes of the file from there on, so that the
+// reads after it -- of a program being loaded, say -- are copies.
+// Writes go to the file at once, and to the buffer too.
+
+const int StubBufferSize = 8192;	// bytes, for FileSystem::Open
+
 class OpenFile {
   public:
-    OpenFile(int f) { file = f; currentOffset = 0; }	// open the file
-    ~OpenFile() { Close(file); }			// close the file
-
-    int ReadAt(char *into, int numBytes, int position) { 
-    		Lseek(file, position, 0); 
-		return ReadPartial(file, into, numBytes); 
-		}	
-    int WriteAt(char *from, int numBytes, int position) { 
-    		Lseek(file, position, 0); 
-		WriteFile(file, from, numBytes); 
-		return numBytes;
-		}	
+    OpenFile(int f) { Init(f, 0); }	// open the file
+    OpenFile(int f, int bufferSize) { Init(f, bufferSize); }
+					// with a buffer that big
+    ~OpenFile() { Close(file); delete [] buffer; }	// close the file
+
+    int ReadAt(char *into, int numBytes, int position);
+    int WriteAt(char *from, int numBytes, int position);
     int Read(char *into, int numBytes) {
 		int numRead = ReadAt(into, numBytes, currentOffset); 
 		currentOffset += numRead;
@@ -52,20 +59,37 @@ class OpenFile {
 		return numWritten;
 		}
 
-    int Length() { Lseek(file, 0, 2); return Tell(file); }
+    int Length() { return length; }
     
   private:
     int file;
     int currentOffset;
+    int length;				// of the file, as far as we know
+    char *buffer;			// "bufferBytes" of the file from
+    int bufferSize;			// "bufferStart", or NULL
+    int bufferStart;
+    int bufferBytes;
+
+    void Init(int f, int size);
 };
 
 #else // FILESYS
 class FileHeader;
+class SharedFile;
+class OpenFileTable;
+
+// How far ahead to read a file read through from the start, and how
+// many sectors written through to have written at once.
+
+const int MinReadAhead = 2;		// sectors, after the first read
+const int MaxReadAhead = 16;		// sectors, at most
+const int WriteBehindBatch = 4;		// sectors
 
 class OpenFile {
   public:
-    OpenFile(int sector);		// Open a file whose header is located
-					// at "sector" on the disk
+    OpenFile(OpenFileTable *table, SharedFile *sharedFile);
+					// Open a file in the table of open
+					// files (see OpenFileTable::Open)
     ~OpenFile();			// Close the file
 
     void Seek(int position); 		// Set the position from which to 
@@ -88,8 +112,23 @@ class OpenFile {
 					// end of file, tell, lseek back 
     
   private:
-    FileHeader *hdr;			// Header for this file 
+    OpenFileTable *openFiles;		// the table the file is open in
+    SharedFile *file;			// its entry there
+    FileHeader *hdr;			// Header for this file, shared
     int seekPosition;			// Current position within the file
+
+    int nextRead;			// where a read would carry on from
+    int readWindow;			// how many sectors to read ahead
+    int readAheadTo;			// sectors up to this one have been
+					// read ahead
+    int nextWrite;			// where a write would carry on from
+    int writtenBehind;			// sectors up to this one have been
+					// written behind
+
+    void Transfer(char *buf, int firstSector, int lastSector,
+		  bool writing);	// read or write these sectors
+    void ReadAhead(int sector);		// read ahead from this sector
+    void WriteBehind(int sector);	// write behind up to this one
 };
 
 #endif // FILESYS
@@ -8,6 +8,7 @@
 
 #include "copyright.h"
 #include "pbitmap.h"
+#include "disk.h"
 
 //----------------------------------------------------------------------
 // PersistentBitmap::PersistentBitmap(int)
@@ -77,3 +78,44 @@ PersistentBitmap::WriteBack(OpenFile *file)
 {
    file->WriteAt((char *)map, numWords * sizeof(unsigned), 0);
 }
+
+//----------------------------------------------------------------------
+// PersistentBitmap::FindRun
+// 	Find where to put "wanted" sectors: a run of that many clear bits,
+//	as close to "hint" as there is -- on its track if it can be, then
+//	on the tracks nearest it; or if there is no run that long, the
+//	longest there is, nearest "hint".  Of a run longer than needed,
+//	the part closest to "hint" is taken.  Nothing is set.
+//
+//	Return the first bit of the run, and set "length" to the number
+//	of bits, at most "wanted"; return -1 if every bit is set.
+//
+//	"wanted" is the number of bits wanted
+//	"hint" is the bit the run should be near
+//	"length" is set to the number of bits found
+//----------------------------------------------------------------------
+
+int
+PersistentBitmap::FindRun(int wanted, int hint, int *length)
+{
+    int best = -1, bestDistance = 0;
+
+    *length = 0;
+    for (int i = NextClear(0); i < numBits; ) {
+	int run = NextSet(i) - i;
+	int start, found, tracks, distance;
+
+	found = min(run, wanted);
+	start = max(i, min(hint, i + run - found));
+	tracks = start / SectorsPerTrack - hint / SectorsPerTrack;
+	distance = (tracks < 0 ? -tracks : tracks) * numBits
+		   + (start < hint ? hint - start : start - hint);
+	if (found > *length || (found == *length && distance < bestDistance)) {
+	    best = start;
+	    *length = found;
+	    bestDistance = distance;
+	}
+	i = NextClear(i + run);
+    }
+    return best;
+}
@@ -6,6 +6,10 @@
 //    when it is created, or it can be initialized later using
 //    the FetchFrom method
 //
+//    As the map of free disk sectors, it also finds where to put a
+//    run of sectors: as close to a given sector as it can, by tracks,
+//    since it is moving the head to another track that takes time.
+//
 // Copyright (c) 1992,1993,1995 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -30,6 +34,12 @@ class PersistentBitmap : public Bitmap {
 
     void FetchFrom(OpenFile *file);     // read bitmap from the disk
     void WriteBack(OpenFile *file); 	// write bitmap contents to disk 
+
+    int FindRun(int wanted, int hint, int *length);
+					// Return the first of a run of
+					// clear bits near "hint" -- as many
+					// as "wanted", or the most there are
+					// -- setting "length"; -1 if none
 };
 
 #endif // PBITMAP_H
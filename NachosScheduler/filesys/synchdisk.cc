@@ -6,9 +6,11 @@
 //	the request completes).
 //
 //	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	pending requests -- one of a queue of requests done (see
+//	DiskCompletions).  And, because the physical disk can only
+//	handle one operation at a time, keep the others waiting in a
+//	queue, which the interrupt handler takes the next from; so the
+//	queue is only touched with interrupts off.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,6 +18,19 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// DiskQueueLength
+// 	Return how many requests a SynchDisk has given the disk or has
+//	waiting; the gauge registered for it.
+//----------------------------------------------------------------------
+
+static int
+DiskQueueLength(void *synchDisk)
+{
+    return ((SynchDisk *) synchDisk)->NumRequests();
+}
 
 
 //----------------------------------------------------------------------
@@ -23,13 +38,44 @@
 // 	Initialize the synchronous interface to the physical disk, in turn
 //	initializing the physical disk.
 //
+//	"cacheSize" -- how many sectors to cache, 0 for no cache
+//	"cachePolicy" -- which sector the cache drops for another
+//	"diskSchedule" -- which waiting request the disk does next
+//
+//	The length of the request queue is registered, to be sampled.
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk()
+SynchDisk::SynchDisk(int cacheSize, CachePolicy cachePolicy,
+		     DiskSchedule diskSchedule)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
+    schedule = diskSchedule;
+    active = waiting = NULL;
+    head = 0;
+    goingUp = TRUE;
     disk = new Disk(this);
+    journal = NULL;
+    cache = NULL;
+    if (cacheSize > 0) {
+        cache = new BufferCache(this, cacheSize, cachePolicy);
+    }
+    kernel->registry->AddGauge("disk.queue", DiskQueueLength, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::NumRequests
+// 	Return how many requests there are: the one the disk is doing,
+//	if any, and those waiting for it.
+//----------------------------------------------------------------------
+
+int
+SynchDisk::NumRequests()
+{
+    int count = (active == NULL) ? 0 : 1;
+
+    for (DiskRequest *r = waiting; r != NULL; r = r->next) {
+        count++;
+    }
+    return count;
 }
 
 //----------------------------------------------------------------------
@@ -40,15 +86,16 @@ SynchDisk::SynchDisk()
 
 SynchDisk::~SynchDisk()
 {
+    delete cache;
     delete disk;
-    delete lock;
-    delete semaphore;
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::ReadSector
 // 	Read the contents of a disk sector into a buffer.  Return only
-//	after the data has been read.
+//	after the data has been read -- from the journal, if it was
+//	written in an operation not committed yet, or from the cache, if
+//	it is there.  The swap area isn't cached.
 //
 //	"sectorNumber" -- the disk sector to read
 //	"data" -- the buffer to hold the contents of the disk sector
@@ -57,16 +104,23 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    if (journal != NULL && sectorNumber < FirstSwapSector
+        && journal->Read(sectorNumber, data)) {
+        return;
+    }
+    if (cache != NULL && sectorNumber < FirstSwapSector) {
+        cache->ReadSector(sectorNumber, data);
+    } else {
+        Transfer(sectorNumber, data, FALSE);
+    }
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::WriteSector
 // 	Write the contents of a buffer into a disk sector.  Return only
-//	after the data has been written.
+//	after the data has been written -- to the journal, if the file
+//	system is in the middle of an operation, or to the cache, if there
+//	is one, which writes the disk later (see Flush).
 //
 //	"sectorNumber" -- the disk sector to be written
 //	"data" -- the new contents of the disk sector
@@ -75,20 +129,454 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    if (journal != NULL && sectorNumber < FirstSwapSector
+        && journal->Write(sectorNumber, data)) {
+        return;
+    }
+    WriteHome(sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	Read the "numSectors" disk sectors from "firstSector" on, the i'th
+//	into data[i], and return only after they have all been read.
+//	Those the journal has are copied from it, as with ReadSector; the
+//	runs of the others between them go to the cache, or the disk, all
+//	at once.
+//
+//	"firstSector" -- the first disk sector to read
+//	"numSectors" -- how many to read
+//	"data" -- the buffer to hold the contents of each
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int firstSector, int numSectors, char **data)
+{
+    for (int i = 0; i < numSectors; ) {
+        int sector = firstSector + i;
+        bool cached = (sector < FirstSwapSector);
+        bool logged = FALSE;
+        int n = 0;
+
+        while (i + n < numSectors
+               && (sector + n < FirstSwapSector) == cached
+               && !(logged = (cached && journal != NULL
+                              && journal->Read(sector + n, data[i + n])))) {
+            n++;
+        }
+        if (n > 0) {
+            ReadHome(sector, n, &data[i]);
+        }
+        i += logged ? n + 1 : n;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write data[i] into the i'th of the "numSectors" disk sectors from
+//	"firstSector" on, and return only after they have all been
+//	written -- to the journal, as with WriteSector, or else to the
+//	cache, or to the disk, the runs of them all at once.
+//
+//	"firstSector" -- the first disk sector to be written
+//	"numSectors" -- how many to write
+//	"data" -- the new contents of each
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int firstSector, int numSectors, char **data)
+{
+    for (int i = 0; i < numSectors; ) {
+        int sector = firstSector + i;
+        bool cached = (sector < FirstSwapSector);
+        bool logged = FALSE;
+        int n = 0;
+
+        while (i + n < numSectors
+               && (sector + n < FirstSwapSector) == cached
+               && !(logged = (cached && journal != NULL
+                              && journal->Write(sector + n, data[i + n])))) {
+            n++;
+        }
+        if (n > 0) {
+            WriteHome(sector, n, &data[i]);
+        }
+        i += logged ? n + 1 : n;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadHome
+// 	Read a run of sectors, all below FirstSwapSector or none, past
+//	the journal: from the cache, or if they aren't cached, from the
+//	disk, in one request.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadHome(int firstSector, int numSectors, char **data)
+{
+    if (cache != NULL && firstSector < FirstSwapSector) {
+        cache->ReadSectors(firstSector, numSectors, data);
+    } else {
+        TransferRun(firstSector, numSectors, data, FALSE);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteHome
+// 	Write a run of sectors, all below FirstSwapSector or none, past
+//	the journal: to the cache, or if they aren't cached, to the disk,
+//	in one request.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteHome(int firstSector, int numSectors, char **data)
+{
+    if (cache != NULL && firstSector < FirstSwapSector) {
+        for (int i = 0; i < numSectors; i++) {
+            cache->WriteSector(firstSector + i, data[i]);
+        }
+    } else {
+        TransferRun(firstSector, numSectors, data, TRUE);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteHome
+// 	Write the contents of a buffer into a disk sector, past the
+//	journal: to the cache, or if it isn't cached, to the disk.
+//
+//	"sectorNumber" -- the disk sector to be written
+//	"data" -- the new contents of the disk sector
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteHome(int sectorNumber, char* data)
+{
+    if (cache != NULL && sectorNumber < FirstSwapSector) {
+        cache->WriteSector(sectorNumber, data);
+    } else {
+        Transfer(sectorNumber, data, TRUE);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Flush
+// 	Write the sectors written only to the journal or the cache so far
+//	to the disk, and return once they are all there -- in its UNIX
+//	file, too, if that is mapped (-dm).
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Flush()
+{
+    if (journal != NULL) {
+        journal->Commit();
+    }
+    if (cache != NULL) {
+        cache->Flush();
+    }
+    disk->Sync();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::UseJournal
+// 	From now on, log the writes of the file system's operations in
+//	"fileSystemJournal" (see Journal::Write).
+//----------------------------------------------------------------------
+
+void
+SynchDisk::UseJournal(Journal *fileSystemJournal)
+{
+    journal = fileSystemJournal;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadAhead
+// 	Have sector "sectorNumber" read into the cache, if there is one,
+//	so that it is there when it is read; return without waiting.
+//	Return FALSE if it won't be, for now (see BufferCache::ReadAhead).
+//----------------------------------------------------------------------
+
+bool
+SynchDisk::ReadAhead(int sectorNumber)
+{
+    if (cache != NULL && sectorNumber < FirstSwapSector) {
+        return cache->ReadAhead(sectorNumber);
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteBehind
+// 	Have sector "sectorNumber", which was written to the cache, if
+//	there is one, written to the disk soon; return without waiting.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteBehind(int sectorNumber)
+{
+    if (cache != NULL && sectorNumber < FirstSwapSector) {
+        cache->WriteBehind(sectorNumber);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Transfer
+// 	Read the disk sector "sectorNumber" into "data", or if "writing",
+//	write "data" to it, and return only once the disk is done.  The
+//	request waits its turn, if the disk is busy.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Transfer(int sectorNumber, char* data, bool writing)
+{
+    DiskCompletions done("disk request");
+    DiskRequest request;
+
+    request.sector = sectorNumber;
+    request.data = data;
+    request.writing = writing;
+    request.completions = &done;
+    Submit(&request);
+    (void) done.Get();			// wait for interrupt
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::TransferRun
+// 	Read the "numSectors" disk sectors from "firstSector" on, the i'th
+//	into data[i], or if "writing", write them, in one request, and
+//	return only once the disk is done.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::TransferRun(int firstSector, int numSectors, char **data,
+                       bool writing)
+{
+    DiskCompletions done("disk run request");
+    DiskRequest request;
+
+    request.sector = firstSector;
+    request.numSectors = numSectors;
+    request.vector = data;
+    request.writing = writing;
+    request.completions = &done;
+    Submit(&request);
+    (void) done.Get();
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Submit
+// 	Put "request" at the end of the queue for the disk, giving it to
+//	the disk right away if it is idle, and return without waiting for
+//	it.  The request reads or writes the disk itself: the cache and
+//	the journal don't see it.
+//
+//	"request" -- what to read or write, and whom to tell when done
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Submit(DiskRequest *request)
+{
+    DiskRequest **last;
+    IntStatus oldLevel;
+
+    ASSERT(request->sector >= 0 && request->numSectors > 0
+           && request->sector + request->numSectors <= NumSectors);
+    ASSERT(request->numSectors == 1 || request->vector != NULL);
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    request->asked = kernel->stats->totalTicks;
+    request->next = NULL;
+    for (last = &waiting; *last != NULL; last = &(*last)->next)
+	;
+    *last = request;
+    if (active == NULL) {
+        StartNext();
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	Take the request to do next from the queue, by the scheduling
+//	policy, and give it to the disk.  Interrupts are off.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartNext()
+{
+    DiskRequest **prev;
+    int tracks;
+    char **vector;
+
+    ASSERT(active == NULL && waiting != NULL);
+    switch (schedule) {
+      case DiskFCFS:
+        active = waiting;
+        break;
+      case DiskSSTF: {
+        DiskRequest *up = Closest(head, TRUE);
+        DiskRequest *down = Closest(head, FALSE);
+
+        if (down == NULL
+            || (up != NULL && up->sector - head <= head - down->sector)) {
+            active = up;
+        } else {
+            active = down;
+        }
+        break;
+      }
+      case DiskSCAN:
+        if ((active = Closest(head, goingUp)) == NULL) {
+            goingUp = !goingUp;		// the last one that way: turn
+            active = Closest(head, goingUp);
+        }
+        break;
+      case DiskDeadline:
+        if (kernel->stats->totalTicks - waiting->asked > DeadlineTicks) {
+            active = waiting;		// it has waited long enough
+            break;
+        }
+        // fall through
+      case DiskCLOOK:
+        if ((active = Closest(head, TRUE)) == NULL) {
+            active = Closest(0, TRUE);	// back to the lowest
+        }
+        break;
+    }
+    for (prev = &waiting; *prev != active; prev = &(*prev)->next)
+	;
+    *prev = active->next;
+
+    tracks = active->sector / SectorsPerTrack - head / SectorsPerTrack;
+    kernel->stats->numSeekTracks += (tracks < 0) ? -tracks : tracks;
+    head = active->sector + active->numSectors - 1;
+    if (active->vector == NULL) {
+        vector = &active->data;
+    } else {
+        vector = active->vector;
+    }
+    if (active->writing) {
+        disk->WriteRun(active->sector, active->numSectors, vector);
+    } else {
+        disk->ReadRun(active->sector, active->numSectors, vector);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Closest
+// 	Return the waiting request for the sector closest to "from",
+//	which is at or above it, if "up", or at or below it; the first
+//	to come, of those for the same sector.  NULL if there is none.
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::Closest(int from, bool up)
+{
+    DiskRequest *closest = NULL;
+
+    for (DiskRequest *r = waiting; r != NULL; r = r->next) {
+        int distance = up ? r->sector - from : from - r->sector;
+
+        if (distance >= 0 && (closest == NULL || distance
+			      < (up ? closest->sector - from
+				    : from - closest->sector))) {
+            closest = r;
+        }
+    }
+    return closest;
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::CallBack
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Start the next request, if one is
+//	waiting, then tell whoever submitted the one finished.
 //----------------------------------------------------------------------
 
 void
 SynchDisk::CallBack()
 { 
-    semaphore->V();
+    DiskRequest *done = active;
+    CallBackObj *callWhenDone = done->callWhenDone;
+    DiskCompletions *completions = done->completions;
+    int wait = kernel->stats->totalTicks - done->asked;
+
+    kernel->stats->totalDiskWait += wait;
+    kernel->stats->maxDiskWait = max(kernel->stats->maxDiskWait, wait);
+    active = NULL;
+    if (waiting != NULL) {
+        StartNext();
+    }
+    if (completions != NULL) {
+        completions->Put(done);
+    }
+    if (callWhenDone != NULL) {
+        callWhenDone->CallBack();
+    }
+}
+
+//----------------------------------------------------------------------
+// DiskCompletions::DiskCompletions
+// 	Initialize an empty queue of requests done.
+//
+//	"debugName" -- a name, for debugging
+//----------------------------------------------------------------------
+
+DiskCompletions::DiskCompletions(char *debugName)
+{
+    numDone = new Semaphore(debugName, 0);
+    first = last = NULL;
+}
+
+//----------------------------------------------------------------------
+// DiskCompletions::~DiskCompletions
+// 	De-allocate the queue.
+//----------------------------------------------------------------------
+
+DiskCompletions::~DiskCompletions()
+{
+    delete numDone;
+}
+
+//----------------------------------------------------------------------
+// DiskCompletions::Put
+// 	Put "request", which the disk is done with, at the end of the
+//	queue, and wake a thread waiting for one.  Called by the disk
+//	interrupt handler.
+//----------------------------------------------------------------------
+
+void
+DiskCompletions::Put(DiskRequest *request)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    request->next = NULL;
+    if (last == NULL) {
+        first = request;
+    } else {
+        last->next = request;
+    }
+    last = request;
+    numDone->V();
+}
+
+//----------------------------------------------------------------------
+// DiskCompletions::Get
+// 	Wait until the queue has a request in it, and take it out.
+//----------------------------------------------------------------------
+
+DiskRequest *
+DiskCompletions::Get()
+{
+    DiskRequest *request;
+    IntStatus oldLevel;
+
+    numDone->P();
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    request = first;
+    first = request->next;
+    if (first == NULL) {
+        last = NULL;
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return request;
 }
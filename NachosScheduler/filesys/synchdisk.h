@@ -14,6 +14,64 @@
 #include "disk.h"
 #include "synch.h"
 #include "callback.h"
+#include "buffercache.h"
+#include "journal.h"
+
+// The last NumSwapSectors sectors of the disk hold the pages demand
+// paging has written out (see pager.h); the file system doesn't use them.
+
+const int NumSwapSectors = NumSectors / 2;
+const int FirstSwapSector = NumSectors - NumSwapSectors;
+
+class DiskCompletions;
+
+// A request to read or write a sector, given to SynchDisk::Submit, which
+// returns at once.  When the disk is done with it, the disk interrupt
+// handler calls "callWhenDone", if it is not NULL, and puts the request
+// in "completions", if that is not NULL.  The request must be left
+// alone until then.  A request can be for a run of sectors, from
+// "sector" on, each to or from a buffer of its own, in "vector".
+
+class DiskRequest {
+  public:
+    DiskRequest() { numSectors = 1; vector = NULL;
+		    callWhenDone = NULL; completions = NULL; }
+
+    int sector;				// the sector to read or write
+    char *data;				// or, if "vector" isn't NULL,
+    int numSectors;			// the first of a run of these,
+    char **vector;			// each to or from its own buffer
+    bool writing;
+    CallBackObj *callWhenDone;		// called once the disk has done it
+    DiskCompletions *completions;	// or where it goes then
+
+  private:
+    int asked;				// when it was submitted
+    DiskRequest *next;			// waiting, the one that came after
+					// it; done, the one done after it
+    friend class SynchDisk;
+    friend class DiskCompletions;
+};
+
+// The following class is a queue of the requests the disk is done with,
+// in the order they were done, for a thread with several of them in
+// flight to take them from, one by one.  The disk interrupt handler
+// puts them there, so the queue is only touched with interrupts off.
+
+class DiskCompletions {
+  public:
+    DiskCompletions(char *debugName);	// an empty queue
+    ~DiskCompletions();
+
+    void Put(DiskRequest *request);	// the disk is done with it
+    DiskRequest *Get();			// wait until a request is done,
+					// and return it
+
+  private:
+    Semaphore *numDone;			// requests put, not yet got
+    DiskRequest *first;			// the requests done, in the
+    DiskRequest *last;			// order they were
+};
 
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
@@ -25,11 +83,27 @@
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// The sectors the file system uses are read and written through a
+// cache (see buffercache.h), so that many requests don't wait at all;
+// and the file system's own, while it is changing them, through its
+// journal (see journal.h), which writes them in place later.
+//
+// Many threads may want the disk at once: their requests wait in a
+// queue, and when the disk is done with one, the next is picked by
+// the disk scheduling policy, and given to the disk right away.  A
+// thread can also have requests in the queue without waiting for
+// them (see Submit), so that one thread keeps the disk busy.
 
 class SynchDisk : public CallBackObj {
   public:
-    SynchDisk();    		        // Initialize a synchronous disk,
-					// by initializing the raw Disk.
+    SynchDisk(int cacheSize, CachePolicy cachePolicy,
+	      DiskSchedule schedule);
+					// Initialize a synchronous disk,
+					// by initializing the raw Disk, with
+					// a cache of "cacheSize" sectors (or
+					// none, if 0), and requests done in
+					// the order "schedule" picks
     ~SynchDisk();			// De-allocate the synch disk data
     
     void ReadSector(int sectorNumber, char* data);
@@ -39,6 +113,22 @@ class SynchDisk : public CallBackObj {
     					// Disk::ReadRequest/WriteRequest and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
+    void ReadSectors(int firstSector, int numSectors, char **data);
+    void WriteSectors(int firstSector, int numSectors, char **data);
+					// Read/write a run of sectors, the
+					// i'th to or from data[i], in as few
+					// disk requests as there can be
+    void Flush();			// write what only the journal or the
+					// cache has to the disk
+    void Submit(DiskRequest *request);	// Queue a request for the disk
+					// itself -- past the cache and the
+					// journal -- and return at once
+    void UseJournal(Journal *fileSystemJournal);
+					// have "fileSystemJournal" log the
+					// writes of operations
+    bool ReadAhead(int sectorNumber);	// have the cache read it, or write
+    void WriteBehind(int sectorNumber);	// it back, soon, if there is a cache
+    int NumRequests();			// being done or waiting to be
     
     void CallBack();			// Called by the disk device interrupt
 					// handler, to signal that the
@@ -46,10 +136,31 @@ class SynchDisk : public CallBackObj {
 
   private:
     Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    BufferCache *cache;			// the sectors used lately, or NULL
+    Journal *journal;			// the file system's, or NULL
+    DiskSchedule schedule;
+    DiskRequest *active;		// the request the disk is doing
+    DiskRequest *waiting;		// the others, in the order they came
+    int head;				// the sector the head was last at
+    bool goingUp;			// with SCAN, the way it is moving
+
+    void Transfer(int sectorNumber, char* data, bool writing);
+					// read or write the disk itself
+    void TransferRun(int firstSector, int numSectors, char **data,
+		     bool writing);	// and a run of sectors, at once
+    void WriteHome(int sectorNumber, char* data);
+					// write it past the journal
+    void ReadHome(int firstSector, int numSectors, char **data);
+    void WriteHome(int firstSector, int numSectors, char **data);
+					// a run of sectors, on one side of
+					// FirstSwapSector, past the journal
+    void StartNext();			// give the disk the next request
+    DiskRequest *Closest(int from, bool up);
+					// the waiting request closest to
+					// "from", at or above it (or below)
+
+    friend class BufferCache;
+    friend class Journal;
 };
 
 #endif // SYNCHDISK_H
@@ -10,6 +10,48 @@
 #include "debug.h"
 #include "bitmap.h"
 
+//----------------------------------------------------------------------
+// LowestBit
+//  Return the index of the least significant bit set in "word".
+//  "word" must not be zero.
+//----------------------------------------------------------------------
+
+static int
+LowestBit(unsigned int word)
+{
+    ASSERT(word != 0);
+#ifdef __GNUC__
+    return __builtin_ctz(word);
+#else
+    int bit = 0;
+    if (!(word & 0xffff)) { word >>= 16; bit += 16; }
+    if (!(word & 0xff)) { word >>= 8; bit += 8; }
+    if (!(word & 0xf)) { word >>= 4; bit += 4; }
+    if (!(word & 0x3)) { word >>= 2; bit += 2; }
+    if (!(word & 0x1)) { bit += 1; }
+    return bit;
+#endif
+}
+
+//----------------------------------------------------------------------
+// CountBits
+//  Return the number of bits set in "word".
+//----------------------------------------------------------------------
+
+static int
+CountBits(unsigned int word)
+{
+#ifdef __GNUC__
+    return __builtin_popcount(word);
+#else
+    int count = 0;
+    for (; word != 0; word &= word - 1) {
+        count++;                        // drops the lowest bit set
+    }
+    return count;
+#endif
+}
+
 //----------------------------------------------------------------------
 // BitMap::BitMap
 //  Initialize a bitmap with "numItems" bits, so that every bit is clear.
@@ -104,25 +146,30 @@ Bitmap::Test(int which) const
 //  As a side effect, set the bit (mark it as in use).
 //  (In other words, find and allocate a bit.)
 //
+//  Words with every bit set are skipped (see NextClear).
+//
 //  If no bits are clear, return -1.
 //----------------------------------------------------------------------
 
 int
 Bitmap::FindAndSet()
 {
-    for (int i = 0; i < numBits; i++) {
-        if (!Test(i)) {
-            Mark(i);
-            return i;
-        }
+    int i = NextClear(0);
+
+    if (i == numBits) {
+        return -1;
     }
-    return -1;
+    Mark(i);
+    return i;
 }
 
 //----------------------------------------------------------------------
 // Bitmap::NumClear
 //  Return the number of clear bits in the bitmap.
 //  (In other words, how many bits are unallocated?)
+//
+//  The bits set are counted a word at a time; those past "numBits"
+//  never are.
 //----------------------------------------------------------------------
 
 int
@@ -130,12 +177,119 @@ Bitmap::NumClear() const
 {
     int count = 0;
 
-    for (int i = 0; i < numBits; i++) {
-        if (!Test(i)) {
-            count++;
+    for (int w = 0; w < numWords; w++) {
+        count += CountBits(map[w]);
+    }
+    return numBits - count;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NumClear
+//  Return the number of clear bits of the "count" bits from "first"
+//  (those past the end of the bitmap are not counted).  The words in
+//  the middle are counted whole.
+//
+//  "first" is the number of the first bit to look at
+//  "count" is how many bits to look at
+//----------------------------------------------------------------------
+
+int
+Bitmap::NumClear(int first, int count) const
+{
+    int last = min(first + count, numBits);     // one past the end
+    int set = 0;
+
+    ASSERT(first >= 0 && count >= 0);
+    for (int i = first; i < last; ) {
+        int w = i / BitsInWord;
+        int bit = i % BitsInWord;
+        int bits = min(BitsInWord - bit, last - i);
+        unsigned int mask = (bits == BitsInWord) ? ~0U
+                                                 : ((1U << bits) - 1) << bit;
+
+        set += CountBits(map[w] & mask);
+        i += bits;
+    }
+    return max(last - first, 0) - set;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::FindClear
+//  Return the number of the first bit of a run of "length" clear bits,
+//  the first such run at or after "from"; or -1 if there is none.
+//  Runs are found a word at a time (see NextClear and NextSet).
+//
+//  "length" is how many clear bits in a row are wanted
+//  "from" is where to start looking
+//----------------------------------------------------------------------
+
+int
+Bitmap::FindClear(int length, int from) const
+{
+    ASSERT(length > 0);
+    for (int i = NextClear(from); i < numBits; ) {
+        int end = NextSet(i);
+
+        if (end - i >= length) {
+            return i;
         }
+        i = NextClear(end);
     }
-    return count;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NextClear
+//  Return the number of the first clear bit at or after "from", or
+//  "numBits" if there is none.  Full words are passed over at once.
+//
+//  "from" is where to start looking
+//----------------------------------------------------------------------
+
+int
+Bitmap::NextClear(int from) const
+{
+    int w = from / BitsInWord;
+    unsigned int clear;
+
+    if (from >= numBits) {
+        return numBits;
+    }
+    clear = ~map[w] & (~0U << (from % BitsInWord));
+    while (clear == 0) {
+        if (++w == numWords) {
+            return numBits;
+        }
+        clear = ~map[w];
+    }
+    return min(w * BitsInWord + LowestBit(clear), numBits);
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NextSet
+//  Return the number of the first set bit at or after "from", or
+//  "numBits" if there is none.  Empty words are passed over at once.
+//
+//  "from" is where to start looking
+//----------------------------------------------------------------------
+
+int
+Bitmap::NextSet(int from) const
+{
+    int w = from / BitsInWord;
+    unsigned int set;
+
+    if (from >= numBits) {
+        return numBits;
+    }
+    set = map[w] & (~0U << (from % BitsInWord));
+    while (set == 0) {
+        if (++w == numWords) {
+            return numBits;
+        }
+        set = map[w];
+    }
+    return w * BitsInWord + LowestBit(set);    // never past "numBits"
 }
 
 //----------------------------------------------------------------------
@@ -177,6 +331,10 @@ Bitmap::SelfTest()
     ASSERT(Test(0) && Test(31));
 
     ASSERT(FindAndSet() == 1);
+    ASSERT(NumClear() == numBits - 3);
+    ASSERT(NumClear(0, BitsInWord) == BitsInWord - 3);
+    ASSERT(FindClear(29, 0) == 2 && FindClear(29, 3) != 2);
+    ASSERT(NextSet(2) == 31 && NextClear(31) == 32);
     Clear(0);
     Clear(1);
     Clear(31);
@@ -8,6 +8,12 @@
 //  The bitmap can be parameterized with with the number of bits being
 //  managed.
 //
+//  Searching and counting go a word at a time: a word with every bit
+//  set (or clear) is passed over at once, and the first clear bit of
+//  a word, or the number of bits set in it, is found without looking
+//  at its bits one by one.  The bits past "numBits" in the last word
+//  are always clear.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
@@ -43,6 +49,15 @@ public:
                                 // effect, set the bit.
                                 // If no bits are clear, return -1.
     int NumClear() const;   // Return the number of clear bits
+    int NumClear(int first, int count) const;
+                            // Return the number of clear bits of
+                            // "count" from "first"
+    int FindClear(int length, int from) const;
+                            // Return the first of a run of "length"
+                            // clear bits at or after "from", or -1
+    int NextClear(int from) const;  // Return the # of the first clear
+    int NextSet(int from) const;    // (or set) bit at or after "from",
+                                    // or "numBits" if there is none
 
     void Print() const;     // Print contents of bitmap
     void SelfTest();        // Test whether bitmap is working
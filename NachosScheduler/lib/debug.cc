@@ -18,28 +18,44 @@
 //
 //  If the flag is "+", we enable all DEBUG messages.
 //
+//  The list is looked through once, here, so that IsEnabled only
+//  has to index a table.
+//
 //  "flagList" is a string of characters for whose DEBUG messages are
 //      to be enabled.
 //----------------------------------------------------------------------
 
 Debug::Debug(char *flagList)
 {
+    bool all = (flagList != NULL && strchr(flagList, dbgAll) != 0);
+
     enableFlags = flagList;
+    for (int i = 0; i < NumDebugFlags; i++) {
+        enabled[i] = all || (flagList != NULL && i != 0
+                             && strchr(flagList, (char) i) != 0);
+        hits[i] = 0;
+    }
 }
 
-
 //----------------------------------------------------------------------
-// Debug::IsEnabled
-//      Return TRUE if DEBUG messages with "flag" are to be printed.
+// Debug::Print
+//      Print how many times the DEBUG statements of each flag were
+//  reached, when they are being counted (DEBUG_COUNT).
 //----------------------------------------------------------------------
 
-bool
-Debug::IsEnabled(char flag)
+void
+Debug::Print()
 {
-    if (enableFlags != NULL) {
-        return ((strchr(enableFlags, flag) != 0)
-                || (strchr(enableFlags, '+') != 0));
-    } else {
-        return FALSE;
+    bool any = FALSE;
+
+    for (int i = 0; i < NumDebugFlags; i++) {
+        if (hits[i] == 0) {
+            continue;
+        }
+        if (!any) {
+            cout << "DEBUG statements reached, by flag:\n";
+            any = TRUE;
+        }
+        cout << "    " << (char) i << ": " << hits[i] << "\n";
     }
 }
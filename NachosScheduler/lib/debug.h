@@ -6,6 +6,19 @@
 //  passed to Nachos (-d).  You are encouraged to add your own
 //  debugging flags.  Please....
 //
+//  Which flags' messages can be turned on may also be chosen when
+//  Nachos is built, by defining DEBUG_CATEGORIES to the DebugBits
+//  of those flags, for instance
+//	-DDEBUG_CATEGORIES='(DebugBit(dbgThread)|DebugBit(dbgSynch))'
+//  or to 0 for none.  The DEBUG statements of the other flags then
+//  generate no code at all, so they cost nothing in the simulator's
+//  hottest paths.  By default every flag is built in.
+//
+//  If DEBUG_COUNT is defined as well, the DEBUG statements that are
+//  built in print nothing; instead, however -d is set, each counts
+//  how many times it is reached, per flag, and the counts are
+//  printed when Nachos halts.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
@@ -30,27 +43,67 @@ const char dbgAddr = 'a';       // address spaces
 const char dbgNet = 'n';        // network emulation
 const char dbgSys = 'u';                // systemcall
 
+// The bit of DEBUG_CATEGORIES for a flag.  Flags may share a bit:
+// that only builds in more than was asked for.
+#define DebugBit(flag)  (1u << ((flag) & 31))
+
+#ifdef DEBUG_CATEGORIES
+const unsigned dbgBuiltIn = DEBUG_CATEGORIES;
+#else
+const unsigned dbgBuiltIn = ~0u;
+#endif
+
+const int NumDebugFlags = 128;	// flags are ASCII characters
+
 class Debug {
 public:
     Debug(char *flagList);
 
-    bool IsEnabled(char flag);
+    bool IsEnabled(char flag) { return enabled[flag & (NumDebugFlags - 1)]; }
+				// was flag given to -d?
+    void Count(char flag) { hits[flag & (NumDebugFlags - 1)]++; }
+				// a DEBUG statement was reached
+    void Print();		// print the counts, if there are any
 
 private:
     char *enableFlags;      // controls which DEBUG messages are printed
+    bool enabled[NumDebugFlags];	// by flag, from enableFlags
+    int hits[NumDebugFlags];	// DEBUG statements reached, by flag
 };
 
 extern Debug *debug;
 
+//----------------------------------------------------------------------
+// DEBUG_ON
+//      Is flag built in and enabled?  For code that prints more than
+//  a DEBUG statement can, or works differently so that its messages
+//  come out step by step.  Never, when DEBUG statements are counted.
+//----------------------------------------------------------------------
+#ifdef DEBUG_COUNT
+#define DEBUG_ON(flag)  (FALSE)
+#else
+#define DEBUG_ON(flag)                                                  \
+    ((dbgBuiltIn & DebugBit(flag)) != 0 && ::debug->IsEnabled(flag))
+#endif
+
 
 //----------------------------------------------------------------------
 // DEBUG
-//      If flag is enabled, print a message.
+//      If flag is enabled, print a message; or, when DEBUG statements
+//  are counted, count it.  If flag isn't built in, the test is a
+//  constant, and the compiler drops the whole statement.
 //----------------------------------------------------------------------
+#ifdef DEBUG_COUNT
+#define DEBUG(flag,expr)                                                     \
+    if ((dbgBuiltIn & DebugBit(flag)) == 0) {} else {   \
+        ::debug->Count(flag);                           \
+    }
+#else
 #define DEBUG(flag,expr)                                                     \
-    if (!debug->IsEnabled(flag)) {} else {              \
+    if ((dbgBuiltIn & DebugBit(flag)) == 0 || !::debug->IsEnabled(flag)) {} else { \
         cerr << expr << "\n";                           \
     }
+#endif
 
 
 //----------------------------------------------------------------------
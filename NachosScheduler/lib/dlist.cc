@@ -0,0 +1,288 @@
+// dlist.cc
+//      Routines to manage an intrusive, doubly linked list of "things".
+//  As with List, DLists are templates, so that they are type safe;
+//  the member of the item they are linked through is a parameter of
+//  the template too.
+//
+//      NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// DList<T, link>::DList
+//  Initialize a list, empty to start with.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+DList<T, link>::DList()
+{
+    first = last = NULL;
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::~DList
+//  Take anything still on the list off it, so that it can go on
+//  another.  As with List, the items themselves are up to the caller.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+DList<T, link>::~DList()
+{
+    while (RemoveFront() != NULL) {
+        ;
+    }
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::Link
+//  Link "item" in between "before" and "after", which are next to
+//  each other on the list; either may be NULL, at an end.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Link(T *item, T *before, T *after)
+{
+    DLink<T> *l = &(item->*link);
+
+    ASSERT(!l->linked);
+    l->prev = before;
+    l->next = after;
+    l->linked = TRUE;
+    if (before == NULL) {
+        first = item;
+    } else {
+        (before->*link).next = item;
+    }
+    if (after == NULL) {
+        last = item;
+    } else {
+        (after->*link).prev = item;
+    }
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::Prepend, DList<T, link>::Append
+//  Put an item at the beginning, or the end, of the list.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Prepend(T *item)
+{
+    Link(item, NULL, first);
+}
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Append(T *item)
+{
+    Link(item, last, NULL);
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::InsertBefore
+//  Put "item" on the list just ahead of "before", which is on it.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::InsertBefore(T *item, T *before)
+{
+    ASSERT(IsLinked(before));
+    Link(item, Prev(before), before);
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::Insert
+//  Put "item" on the list ahead of the first item bigger than it,
+//  and so after any equal to it, keeping the list in the order
+//  "compare" gives (see SortedList).  Finding the place is linear;
+//  nothing is allocated.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Insert(T *item, int (*compare)(T *x, T *y))
+{
+    T *bigger = first;
+
+    while (bigger != NULL && (*compare)(item, bigger) >= 0) {
+        bigger = Next(bigger);
+    }
+    Link(item, (bigger == NULL) ? last : Prev(bigger), bigger);
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::Remove
+//  Take "item", which must be on this list, off it.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Remove(T *item)
+{
+    DLink<T> *l = &(item->*link);
+
+    ASSERT(l->linked && numInList > 0);
+    if (l->prev == NULL) {
+        ASSERT(first == item);
+        first = l->next;
+    } else {
+        (l->prev->*link).next = l->next;
+    }
+    if (l->next == NULL) {
+        ASSERT(last == item);
+        last = l->prev;
+    } else {
+        (l->next->*link).prev = l->prev;
+    }
+    l->next = l->prev = NULL;
+    l->linked = FALSE;
+    numInList--;
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::RemoveFront
+//  Take the first item off the list, and return it; or return NULL
+//  if the list is empty.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+T *
+DList<T, link>::RemoveFront()
+{
+    T *item = first;
+
+    if (item != NULL) {
+        Remove(item);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::Splice
+//  Move everything on "other" to the end of this list, in the order
+//  it was in there, leaving "other" empty.  Only the ends are
+//  touched, whatever the lengths.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Splice(DList<T, link> *other)
+{
+    ASSERT(other != this);
+    if (other->IsEmpty()) {
+        return;
+    }
+    if (last == NULL) {
+        first = other->first;
+    } else {
+        (last->*link).next = other->first;
+        (other->first->*link).prev = last;
+    }
+    last = other->last;
+    numInList += other->numInList;
+    other->first = other->last = NULL;
+    other->numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::Apply
+//  Apply a function to each item on the list, in order.  The next
+//  item is found before the function is called, so it may take the
+//  item it is given off the list.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::Apply(void (*func)(T *)) const
+{
+    T *item, *next;
+
+    for (item = first; item != NULL; item = next) {
+        next = Next(item);
+        (*func)(item);
+    }
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::SanityCheck
+//  Test whether this is still a legal list.
+//
+//  Tests: do the links agree, both ways?
+//         does the list have the right # of items?
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::SanityCheck() const
+{
+    T *prev = NULL;
+    int numFound = 0;
+
+    for (T *item = first; item != NULL; item = Next(item)) {
+        ASSERT(IsLinked(item) && Prev(item) == prev);
+        prev = item;
+        numFound++;
+        ASSERT(numFound <= numInList);  // prevent infinite loop
+    }
+    ASSERT(last == prev);
+    ASSERT(numFound == numInList);
+}
+
+//----------------------------------------------------------------------
+// DList<T, link>::SelfTest
+//  Test whether this module is working, with the "numEntries" items
+//  in "p", which must not be on a list.
+//----------------------------------------------------------------------
+
+template <class T, DLink<T> T::*link>
+void
+DList<T, link>::SelfTest(T *p, int numEntries)
+{
+    DList<T, link> other;
+    int i;
+
+    SanityCheck();
+    ASSERT(IsEmpty() && Front() == NULL);
+
+    for (i = 0; i < numEntries; i++) {
+        Append(&p[i]);
+        ASSERT(IsLinked(&p[i]) && Back() == &p[i]);
+    }
+    SanityCheck();
+
+    // take them off from the middle, while going through the list
+    i = 0;
+    for (DListIterator<T, link> iter(this); !iter.IsDone(); iter.Next()) {
+        if (i++ % 2 == 1) {
+            Remove(iter.Item());
+            ASSERT(!IsLinked(iter.Item()));
+        }
+    }
+    SanityCheck();
+    ASSERT(NumInList() == (numEntries + 1) / 2);
+
+    // put them back on another list, and move that onto the end
+    for (i = 1; i < numEntries; i += 2) {
+        other.Prepend(&p[i]);
+    }
+    Splice(&other);
+    SanityCheck();
+    other.SanityCheck();
+    ASSERT(other.IsEmpty() && NumInList() == numEntries);
+
+    while (!IsEmpty()) {
+        T *item = RemoveFront();
+
+        ASSERT(!IsLinked(item));
+    }
+    SanityCheck();
+}
@@ -0,0 +1,141 @@
+// dlist.h
+//	Data structures to manage intrusive, doubly linked lists.
+//
+//	A List (see list.h) allocates an element to point at each item
+//	it holds, and finds an item by searching for it.  A DList holds
+//	its items directly: each item has a DLink in it, for the list to
+//	link it through, so putting an item on a DList never allocates,
+//	and taking it off -- from anywhere in the list -- is constant
+//	time.  So is moving the whole of one DList onto the end of
+//	another (Splice).
+//
+//	Which DLink of an item a list uses is part of the list's type:
+//	DList<Thread, &Thread::readyLink> links threads through their
+//	readyLink.  An item can be on as many lists at once as it has
+//	DLinks, but on only one through each.
+//
+//	As with List, allocation and deallocation of the items on the
+//	list are to be done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DLIST_H
+#define DLIST_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines the links an item is put on a DList
+// by.  It is a member of the item; only DList touches it.
+
+template <class T>
+class DLink {
+  public:
+    DLink() { next = prev = NULL; linked = FALSE; }
+
+    bool IsLinked() const { return linked; }
+				// is the item on a list, by this link?
+
+    T *next;			// the next item on the list, or NULL
+    T *prev;			// and the one before
+    bool linked;
+};
+
+template <class T, DLink<T> T::*link> class DListIterator;
+
+// The following class defines a doubly linked list of items, linked
+// through their member "link".
+
+template <class T, DLink<T> T::*link>
+class DList {
+  public:
+    DList();			// initialize an empty list
+    ~DList();			// de-allocate the list; the items on it
+				// are taken off, but not touched otherwise
+
+    void Prepend(T *item);	// Put item at the beginning of the list
+    void Append(T *item);	// Put item at the end of the list
+    void InsertBefore(T *item, T *before);
+				// Put item just ahead of "before", which
+				// is on the list
+    void Insert(T *item, int (*compare)(T *x, T *y));
+				// Put item ahead of the first item that
+				// "compare" says is bigger, as a
+				// SortedList does
+    T *Front() const { return first; }
+				// First item on the list, or NULL
+    T *Back() const { return last; }
+				// Last item on the list, or NULL
+    T *RemoveFront();		// Take the first item off the list, or
+				// return NULL if it is empty
+    void Remove(T *item);	// Take a specific item off the list;
+				// it must be on it
+    void Splice(DList *other);	// Move every item on "other", in order,
+				// to the end of this list
+
+    static T *Next(T *item) { return (item->*link).next; }
+    static T *Prev(T *item) { return (item->*link).prev; }
+				// the item after, or before, "item" on
+				// its list, or NULL
+    static bool IsLinked(T *item) { return (item->*link).IsLinked(); }
+				// is the item on a list of this type?
+
+    int NumInList() const { return numInList; }
+    bool IsEmpty() const { return (numInList == 0); }
+
+    void Apply(void (*f)(T *)) const;
+				// apply function to all items in the
+				// list; "f" may take its item off
+    void SanityCheck() const;	// has this list been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    T *first;			// Head of the list, NULL if list is empty
+    T *last;			// Last item on the list
+    int numInList;		// number of items on the list
+
+    void Link(T *item, T *before, T *after);
+				// link item in between the two
+};
+
+// The following class can be used to step through a DList, as a
+// ListIterator does a List.  The item the iterator is at may be taken
+// off the list -- the iterator has already found the next one -- but
+// no other may.
+//
+//	DListIterator<T, link> iter(list);
+//
+//	for (; !iter.IsDone(); iter.Next()) {
+//	    Operation on iter.Item()
+//	}
+
+template <class T, DLink<T> T::*link>
+class DListIterator {
+  public:
+    DListIterator(DList<T, link> *list) { Start(list->Front()); }
+				// initialize an iterator
+
+    bool IsDone() { return current == NULL; }
+				// return TRUE if we are at the end of the list
+    T *Item() { ASSERT(!IsDone()); return current; }
+				// return the item we are at
+    void Next() { Start(following); }
+				// go on to the one after it
+
+  private:
+    T *current;			// where we are in the list
+    T *following;		// and the item after it, as it was
+
+    void Start(T *item) {
+	current = item;
+	following = (item == NULL) ? NULL : (item->*link).next;
+    }
+};
+
+#include "dlist.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // DLIST_H
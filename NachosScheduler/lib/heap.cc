@@ -0,0 +1,237 @@
+// heap.cc
+//      Routines to manage a binary min-heap of "things".  Heaps are
+//  implemented as templates, like lists, so that we can store
+//  anything in a heap in a type-safe manner.
+//
+//      NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+const int HeapInitialSize = 16;		// items a new heap has room for
+
+//----------------------------------------------------------------------
+// Heap<T>::Heap
+//  Initialize an empty heap.
+//
+//  "comp" is the function used to order the items.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::Heap(int (*comp)(T x, T y))
+{
+    items = new T[HeapInitialSize];
+    size = HeapInitialSize;
+    numInHeap = 0;
+    compare = comp;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::~Heap
+//  De-allocate the array.  The items themselves are not touched.
+//----------------------------------------------------------------------
+
+template <class T>
+Heap<T>::~Heap()
+{
+    delete [] items;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftUp
+//  Swap items[i] with its parent until the parent is no bigger.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftUp(int i)
+{
+    T item = items[i];
+
+    while (i > 0 && compare(item, items[(i - 1) / 2]) < 0) {
+        items[i] = items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    items[i] = item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SiftDown
+//  Swap items[i] with its smaller child until neither child is
+//  smaller.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SiftDown(int i)
+{
+    T item = items[i];
+    int child;
+
+    while ((child = 2 * i + 1) < numInHeap) {
+        if (child + 1 < numInHeap
+                && compare(items[child + 1], items[child]) < 0) {
+            child++;
+        }
+        if (compare(items[child], item) >= 0) {
+            break;
+        }
+        items[i] = items[child];
+        i = child;
+    }
+    items[i] = item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Insert
+//  Put "item" in the heap, growing the array if it is full.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Insert(T item)
+{
+    if (numInHeap == size) {
+        T *bigger = new T[2 * size];
+
+        for (int i = 0; i < numInHeap; i++) {
+            bigger[i] = items[i];
+        }
+        delete [] items;
+        items = bigger;
+        size *= 2;
+    }
+    items[numInHeap] = item;
+    SiftUp(numInHeap++);
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::RemoveMin
+//  Take the smallest item out of the heap, and return it.
+//  The heap must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+Heap<T>::RemoveMin()
+{
+    T item;
+
+    ASSERT(numInHeap > 0);
+    item = items[0];
+    items[0] = items[--numInHeap];
+    if (numInHeap > 0) {
+        SiftDown(0);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Find
+//  Return where "item" is in the array, or -1 if it isn't there.
+//----------------------------------------------------------------------
+
+template <class T>
+int
+Heap<T>::Find(T item) const
+{
+    for (int i = 0; i < numInHeap; i++) {
+        if (items[i] == item) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Remove
+//  Take "item" out of the heap.  The last item takes its place, and
+//  is moved up or down to where it belongs.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Remove(T item)
+{
+    int i = Find(item);
+
+    ASSERT(i >= 0);
+    items[i] = items[--numInHeap];
+    if (i < numInHeap) {
+        SiftUp(i);
+        SiftDown(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::Apply
+//  Apply "func" to every item in the heap, in array order.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::Apply(void (*func)(T)) const
+{
+    for (int i = 0; i < numInHeap; i++) {
+        (*func)(items[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SanityCheck
+//  Check that no item is smaller than its parent.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SanityCheck() const
+{
+    ASSERT(numInHeap >= 0 && numInHeap <= size);
+    for (int i = 1; i < numInHeap; i++) {
+        ASSERT(compare(items[(i - 1) / 2], items[i]) <= 0);
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap<T>::SelfTest
+//  Test whether this module is working.  The entries must be
+//  distinct.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+Heap<T>::SelfTest(T *p, int numEntries)
+{
+    int i;
+    T *q = new T[numEntries];
+
+    SanityCheck();
+    ASSERT(IsEmpty());
+
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+        ASSERT(IsInHeap(p[i]));
+        SanityCheck();
+    }
+
+    // remove every other item by value, the rest smallest first
+    for (i = 0; i < numEntries; i += 2) {
+        Remove(p[i]);
+        ASSERT(!IsInHeap(p[i]));
+        SanityCheck();
+    }
+    for (i = 0; !IsEmpty(); i++) {
+        q[i] = RemoveMin();
+        SanityCheck();
+    }
+    ASSERT(i == numEntries / 2);
+
+    // make sure everything came out in the right order
+    for (i = 0; i < (numEntries / 2) - 1; i++) {
+        ASSERT(compare(q[i], q[i + 1]) < 0);
+    }
+    delete [] q;
+}
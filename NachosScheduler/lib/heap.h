@@ -0,0 +1,71 @@
+// heap.h
+//	Data structures to manage a binary min-heap -- a priority queue
+//	ordered by a comparison function supplied by the caller.
+//	Insert and RemoveMin take O(log n) time; Min is O(1).  Removing
+//	an arbitrary item has to find it first, which is O(n).
+//
+//	The items are kept in an array, which doubles in size whenever
+//	it fills, so apart from that a heap never allocates.
+//
+//	As with lists, allocation and deallocation of the items in the
+//	heap are to be done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a min-heap of items.  All types to be
+// inserted must have a "Compare" function supplied:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+// Items that compare equal come out in no particular order.
+
+template <class T>
+class Heap {
+  public:
+    Heap(int (*comp)(T x, T y));	// initialize an empty heap
+    ~Heap();			// de-allocate the heap's array
+
+    void Insert(T item);	// put item in the heap
+    T Min() { ASSERT(numInHeap > 0); return items[0]; }
+				// smallest item, without removing it
+    T RemoveMin();		// take the smallest item out of the heap
+    void Remove(T item);	// take a specific item out of the heap;
+				// it must be there
+    bool IsInHeap(T item) const { return (Find(item) >= 0); }
+
+    bool IsEmpty() const { return (numInHeap == 0); }
+    int NumInHeap() const { return numInHeap; }
+
+    void Apply(void (*func)(T)) const;
+				// apply function to all items, in no
+				// particular order
+
+    void SanityCheck() const;	// has this heap been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    T *items;			// items[0] is the smallest; the children
+				// of items[i] are items[2i+1], items[2i+2]
+    int size;			// how many items fit in the array
+    int numInHeap;		// number of items in the heap
+    int (*compare)(T x, T y);	// function for ordering items
+
+    int Find(T item) const;	// index of item, or -1
+    void SiftUp(int i);		// move items[i] up to where it belongs
+    void SiftDown(int i);	// move items[i] down to where it belongs
+};
+
+#include "heap.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // HEAP_H
@@ -0,0 +1,27 @@
+// hosterrno.cc
+//	Routines that look at the host's errno, for sysdep.cc.
+//
+//	This file is compiled by itself, without the Nachos include
+//	path: there, userprog/errno.h (the error codes Nachos system
+//	calls return) would be read in place of the host's <errno.h>,
+//	and the codes compared would be Nachos's, not the host's.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "sysdep.h"
+#include <errno.h>
+
+//----------------------------------------------------------------------
+// InterruptedCall
+//  Return TRUE if the host system call that just failed was cut
+//  short by a signal, and may be tried again.
+//----------------------------------------------------------------------
+
+bool
+InterruptedCall()
+{
+    return (errno == EINTR);
+}
@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, intrusive lists,
+//	red-black trees, heaps, hash tables, and object pools.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -10,13 +11,18 @@
 #include "libtest.h"
 #include "bitmap.h"
 #include "list.h"
+#include "dlist.h"
 #include "hash.h"
+#include "openhash.h"
+#include "rbtree.h"
+#include "heap.h"
+#include "pool.h"
 #include "sysdep.h"
 
 //----------------------------------------------------------------------
 // IntCompare
 //	Compare two integers together.  Serves as the comparison
-//	function for testing SortedLists
+//	function for testing SortedLists, RBTrees and Heaps
 //----------------------------------------------------------------------
 
 static int 
@@ -29,7 +35,7 @@ IntCompare(int x, int y) {
 //----------------------------------------------------------------------
 // HashInt, HashKey
 //	Compute a hash function on an integer.  Serves as the
-//	hashing function for testing HashTables.
+//	hashing function for testing HashTables and OpenHashTables.
 //----------------------------------------------------------------------
 
 static unsigned int 
@@ -50,18 +56,27 @@ HashKey(char *str) {
     return atoi(str);
 }
 
-// Array of values to be inserted into a List or SortedList. 
+// Array of values to be inserted into a List, SortedList, RBTree or Heap.
 static int listTestVector[] = { 9, 5, 7 };
 
-// Array of values to be inserted into the HashTable
-// There are enough here to force a ReHash().
+// Items to be put on a DList, linked through their own DLink.
+class DListTestItem {
+  public:
+    int value;
+    DLink<DListTestItem> link;
+};
+static DListTestItem dlistTestVector[5];
+
+// Array of values to be inserted into the HashTable and OpenHashTable
+// There are enough here to force a ReHash(), and to grow an
+// OpenHashTable twice.
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 	 "7", "8", "9", "10", "11", "12", "13", "14"};
 
 //----------------------------------------------------------------------
 // LibSelfTest
-//	Run self tests on bitmaps, lists, sorted lists, and 
-//	hash tables.
+//	Run self tests on bitmaps, lists, sorted lists, intrusive lists,
+//	red-black trees, heaps, hash tables, and object pools.
 //----------------------------------------------------------------------
 
 void
@@ -69,17 +84,36 @@ LibSelfTest () {
     Bitmap *map = new Bitmap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    DList<DListTestItem, &DListTestItem::link> *dlist =
+	new DList<DListTestItem, &DListTestItem::link>;
+    RBTree<int> *tree = new RBTree<int>(IntCompare);
+    Heap<int> *heap = new Heap<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
+    OpenHashTable<int, char *> *openHashTable =
+	new OpenHashTable<int, char *>(HashKey, HashInt);
+    ObjectPool *pool = new ObjectPool(sizeof(int) * 3, 4);
 	
 		
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    dlist->SelfTest(dlistTestVector,
+		    sizeof(dlistTestVector)/sizeof(DListTestItem));
+    tree->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    heap->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
+    openHashTable->SelfTest(hashTestVector,
+			    sizeof(hashTestVector)/sizeof(char *));
+    pool->SelfTest();
 
     delete map;
     delete list;
     delete sortList;
+    delete dlist;
+    delete tree;
+    delete heap;
     delete hashTable;
+    delete openHashTable;
+    delete pool;
 }
@@ -6,7 +6,8 @@
 //  A "ListElement" is allocated for each item to be put on the
 //  list; it is de-allocated when the item is removed. This means
 //      we don't need to keep a "next" pointer in every object we
-//      want to put on a list.
+//      want to put on a list.  Elements are recycled, so after the
+//      first few, this doesn't cost a trip to the heap.
 //
 //      NOTE: Mutual exclusion must be provided by the caller.
 //      If you want a synchronized list, you must use the routines
@@ -32,6 +33,34 @@ ListElement<T>::ListElement(T itm)
     next = NULL;   // always initialize to something!
 }
 
+//----------------------------------------------------------------------
+// ListElement<T>::operator new, ListElement<T>::operator delete
+//  Elements are carved out of slabs of ListElementsPerSlab, and one
+//  that is freed is reused by the next item put on any list of the
+//  same type.
+//----------------------------------------------------------------------
+
+template <class T>
+ObjectPool *ListElement<T>::pool = NULL;
+
+template <class T>
+void *
+ListElement<T>::operator new(size_t size)
+{
+    ASSERT(size == sizeof(ListElement<T>));
+    if (pool == NULL) {
+        pool = new ObjectPool(sizeof(ListElement<T>), ListElementsPerSlab);
+    }
+    return pool->Alloc();
+}
+
+template <class T>
+void
+ListElement<T>::operator delete(void *element)
+{
+    pool->Free(element);
+}
+
 
 //----------------------------------------------------------------------
 // List<T>::List
@@ -68,7 +97,7 @@ List<T>::~List()
 }
 
 //----------------------------------------------------------------------
-// List<T>::Append
+// List<T>::Insert
 //      Append an "item" to the end of the list.
 //
 //  Allocate a ListElement to keep track of the item.
@@ -80,7 +109,7 @@ List<T>::~List()
 
 template <class T>
 void
-List<T>::Append(T item)
+List<T>::Insert(T item)
 {
     ListElement<T> *element = new ListElement<T>(item);
 
@@ -94,6 +123,18 @@ List<T>::Append(T item)
     }
     numInList++;
     ASSERT(IsInList(item));
+}
+
+//----------------------------------------------------------------------
+// List<T>::Append
+//      Same as Insert, but also print which queue the item went to.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+List<T>::Append(T item)
+{
+    Insert(item);
     cout << "move to " << name << " queue" << endl;
 }
 
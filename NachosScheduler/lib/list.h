@@ -15,6 +15,9 @@
 
 #include "copyright.h"
 #include "debug.h"
+#include "pool.h"
+
+const int ListElementsPerSlab = 128;	// list elements allocated at once
 
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
@@ -23,6 +26,10 @@
 //
 // This class is private to this module (and classes that inherit
 // from this module). Made public for notational convenience.
+//
+// Elements are put on lists and taken off them every time a thread
+// or an interrupt is queued, so rather than going to the heap for
+// each one, they are recycled through a pool, one per type of item.
 
 template <class T>
 class ListElement {
@@ -30,6 +37,12 @@ class ListElement {
     ListElement(T itm); 	// initialize a list element
     ListElement *next;	     	// next element on list, NULL if this is last
     T item; 	   	     	// item on the list
+
+    static void *operator new(size_t size);	// from the pool
+    static void operator delete(void *element);	// back to the pool
+
+  private:
+    static ObjectPool *pool;	// freed elements of this type
 };
 
 // The following class defines a "list" -- a singly linked list of
@@ -48,7 +61,9 @@ class List {
     virtual ~List();		// de-allocate the list
 
     virtual void Prepend(T item);// Put item at the beginning of the list
-    virtual void Append(T item); // Put item at the end of the list
+    virtual void Append(T item); // Put item at the end of the list,
+				// and note it in the scheduler trace
+    void Insert(T item);	// Put item at the end of the list
 
     T Front() { return first->item; }
     				// Return first item on list
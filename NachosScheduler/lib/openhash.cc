@@ -0,0 +1,501 @@
+// openhash.cc
+//     	Routines to manage an open addressing hash table of arbitrary
+//	things.  The hashing function is supplied by the objects being
+//	put into the table; conflicts are resolved by linear probing,
+//	with items kept in Robin Hood order.
+//
+//	Growing the table is spread out: the items in the old array are
+//	moved to the new one a few slots at a time, oldest slot first.
+//	A slot of the old array whose item has been moved, or removed,
+//	is marked deleted rather than emptied, so that searches for the
+//	items after it in the old array still find them.  Nothing is
+//	ever put into the old array, so the marks are only cleared when
+//	it is deallocated.
+//
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+const int InitialSlots = 8;	// how big a table do we start with; a
+const int InitialShift = 29;	// power of 2, and 32 - log2 of it
+const int MaxLoadPercent = 75;	// when do we grow the table?
+const int MoveStep = 4;		// old slots moved per Insert or Remove;
+				// enough to be done before the new
+				// array fills up in turn
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::OpenHashTable
+//	Initialize a hash table, empty to start with.
+//	Elements can now be added to the table.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+OpenHashTable<Key,T>::OpenHashTable(Key (*get)(T x), unsigned (*hFunc)(Key x))
+{
+    numItems = 0;
+    slots = NewSlots(InitialSlots);
+    numSlots = InitialSlots;
+    shift = InitialShift;
+    oldSlots = NULL;
+    numOldSlots = numMoved = 0;
+    oldShift = 0;
+    getKey = get;
+    hash = hFunc;
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::~OpenHashTable
+//	Prepare a hash table for deallocation.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+OpenHashTable<Key,T>::~OpenHashTable()
+{
+    ASSERT(IsEmpty());		// make sure table is empty
+    delete [] slots;
+    if (oldSlots != NULL) {
+	delete [] oldSlots;
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::NewSlots
+//	Allocate an array of "size" slots, with nothing in them.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+OpenHashSlot<T> *
+OpenHashTable<Key,T>::NewSlots(int size)
+{
+    Slot *table = new Slot[size];
+
+    for (int i = 0; i < size; i++) {
+	table[i].distance = EmptySlot;
+    }
+    return table;
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::Put
+//	Put an item, whose key hashes to "h", in the new array.  Starting
+//	from its home slot, wherever we come to an item closer to its own
+//	home than we are to ours, the item we're carrying takes its place,
+//	and we go on with that one instead, until we get to an empty slot.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashTable<Key,T>::Put(T item, unsigned h)
+{
+    Slot carrying, displaced;
+    int i = Home(h, shift);
+
+    carrying.item = item;
+    carrying.hash = h;
+    carrying.distance = 0;
+    for (;;) {
+	if (slots[i].distance == EmptySlot) {
+	    slots[i] = carrying;
+	    return;
+	}
+	if (slots[i].distance < carrying.distance) {
+	    displaced = slots[i];
+	    slots[i] = carrying;
+	    carrying = displaced;
+	}
+	i = (i + 1) & (numSlots - 1);
+	carrying.distance++;
+	ASSERT(carrying.distance < numSlots);
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::FindSlot
+//	Find the slot of an array an item is in, from its key.
+//
+//	The search can stop at an empty slot, or at an item closer to its
+//	home than the one we're after would be: had our item been here,
+//	Put would have put it in that one's place.  Deleted slots, in the
+//	old array, are stepped over.
+//
+//	"table", "size", "sh" -- the array, and its size and shift
+//	"key", "h" -- the key we're after, and its hash
+//
+// Returns:
+//	The slot, or -1 if the key is not in this array.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+int
+OpenHashTable<Key,T>::FindSlot(Slot *table, int size, int sh,
+				Key key, unsigned h) const
+{
+    int i = Home(h, sh);
+
+    for (int d = 0; d < size; d++, i = (i + 1) & (size - 1)) {
+	if (table[i].distance == EmptySlot) {
+	    return -1;
+	}
+	if (table[i].distance == DeletedSlot) {
+	    continue;
+	}
+	if (table[i].distance < d) {
+	    return -1;
+	}
+	if (table[i].hash == h && key == getKey(table[i].item)) { // found!
+	    return i;
+	}
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::Grow
+//	Start moving the table into an array twice the size.  If it is
+//	still being moved from an earlier one, finish that first.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashTable<Key,T>::Grow()
+{
+    if (oldSlots != NULL) {
+	MoveSome(numOldSlots);
+    }
+    oldSlots = slots;
+    numOldSlots = numSlots;
+    oldShift = shift;
+    numMoved = 0;
+
+    numSlots *= 2;
+    shift--;
+    slots = NewSlots(numSlots);
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::MoveSome
+//	Move the items in the next "count" slots of the old array to the
+//	new one.  Once the last is moved, the old array is deallocated.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashTable<Key,T>::MoveSome(int count)
+{
+    for (; count > 0 && numMoved < numOldSlots; count--, numMoved++) {
+	Slot *s = &oldSlots[numMoved];
+
+	if (s->distance >= 0) {
+	    Put(s->item, s->hash);
+	    s->distance = DeletedSlot;
+	}
+    }
+    if (numMoved == numOldSlots) {
+	delete [] oldSlots;
+	oldSlots = NULL;
+	numOldSlots = numMoved = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::Insert
+//      Put an item into the hashtable.
+//
+//	Start growing the table if it would be too full with the item in
+//	it, and move a few more of the old array's slots if it's being
+//	moved; then put the item in the new array.
+//
+//	"item" is the thing to put in the table.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashTable<Key,T>::Insert(T item)
+{
+    Key key = getKey(item);
+
+    ASSERT(!IsInTable(key));
+
+    if ((numItems + 1) * 100 > numSlots * MaxLoadPercent) {
+	Grow();
+    }
+    if (oldSlots != NULL) {
+	MoveSome(MoveStep);
+    }
+    Put(item, (*hash)(key));
+    numItems++;
+
+    ASSERT(IsInTable(key));
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::Find
+//      Find an item from the hash table, in the new array or, if it
+//	hasn't been moved yet, the old one.
+//
+// Returns:
+//	Whether item is found, and if found, the item.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+bool
+OpenHashTable<Key,T>::Find(Key key, T *itemPtr) const
+{
+    unsigned h = (*hash)(key);
+    int i = FindSlot(slots, numSlots, shift, key, h);
+
+    if (i >= 0) {
+	*itemPtr = slots[i].item;
+	return TRUE;
+    }
+    if (oldSlots != NULL) {
+	i = FindSlot(oldSlots, numOldSlots, oldShift, key, h);
+	if (i >= 0) {
+	    *itemPtr = oldSlots[i].item;
+	    return TRUE;
+	}
+    }
+    *itemPtr = NULL;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::Remove
+//      Remove an item from the hash table. The item must be in the table.
+//
+//	In the new array, the items after it that aren't at home move
+//	back a slot each, so that there is never a gap in the way of
+//	a search; in the old array, its slot is just marked deleted.
+//
+// Returns:
+//	The removed item.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+T
+OpenHashTable<Key,T>::Remove(Key key)
+{
+    unsigned h = (*hash)(key);
+    T item;
+    int i, next;
+
+    if (oldSlots != NULL) {
+	MoveSome(MoveStep);
+    }
+
+    i = FindSlot(slots, numSlots, shift, key, h);
+    if (i >= 0) {
+	item = slots[i].item;
+	for (;;) {
+	    next = (i + 1) & (numSlots - 1);
+	    if (slots[next].distance <= 0) {	// empty, or at home
+		break;
+	    }
+	    slots[i] = slots[next];
+	    slots[i].distance--;
+	    i = next;
+	}
+	slots[i].distance = EmptySlot;
+    } else {
+	ASSERT(oldSlots != NULL);	// item must be in table
+	i = FindSlot(oldSlots, numOldSlots, oldShift, key, h);
+	ASSERT(i >= 0);
+	item = oldSlots[i].item;
+	oldSlots[i].distance = DeletedSlot;
+    }
+    numItems--;
+
+    ASSERT(!IsInTable(key));
+    return item;
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::Apply
+//      Apply function to every item in the hash table.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class Key,class T>
+void
+OpenHashTable<Key,T>::Apply(void (*func)(T)) const
+{
+    for (int i = 0; i < numOldSlots; i++) {
+	if (oldSlots[i].distance >= 0) {
+	    (*func)(oldSlots[i].item);
+	}
+    }
+    for (int i = 0; i < numSlots; i++) {
+	if (slots[i].distance >= 0) {
+	    (*func)(slots[i].item);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::SanityCheck
+//      Test whether this is still a legal hash table.
+//
+//	Tests: is every item as far from home as it says, with the
+//		right hash, and findable?
+//	       are the new array's items in Robin Hood order?
+//	       is everything in the old array before "numMoved" gone?
+//	       does the table have the right # of elements?
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashTable<Key,T>::SanityCheck() const
+{
+    int numFound = 0;
+    Slot *s;
+
+    for (int i = 0; i < numSlots; i++) {
+	s = &slots[i];
+	ASSERT(s->distance >= EmptySlot);	// nothing deleted here
+	if (s->distance == EmptySlot) {
+	    continue;
+	}
+	numFound++;
+	ASSERT(s->hash == (*hash)(getKey(s->item)));
+	ASSERT(((i - Home(s->hash, shift)) & (numSlots - 1)) == s->distance);
+	ASSERT(s->distance == 0 ||
+		slots[(i - 1) & (numSlots - 1)].distance >= s->distance - 1);
+	ASSERT(FindSlot(slots, numSlots, shift, getKey(s->item), s->hash) == i);
+    }
+    for (int i = 0; i < numOldSlots; i++) {
+	s = &oldSlots[i];
+	ASSERT(i >= numMoved || s->distance < 0);
+	if (s->distance < 0) {
+	    continue;
+	}
+	numFound++;
+	ASSERT(s->hash == (*hash)(getKey(s->item)));
+	ASSERT(((i - Home(s->hash, oldShift)) & (numOldSlots - 1))
+		== s->distance);
+	ASSERT(FindSlot(oldSlots, numOldSlots, oldShift, getKey(s->item),
+			s->hash) == i);
+    }
+    ASSERT(numItems == numFound);
+}
+
+//----------------------------------------------------------------------
+// OpenHashTable<Key,T>::SelfTest
+//      Test whether this module is working, with "numEntries" items
+//	in "p" -- enough to make the table grow more than once.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashTable<Key,T>::SelfTest(T *p, int numEntries)
+{
+    OpenHashIterator<Key, T> *iterator = new OpenHashIterator<Key,T>(this);
+    int i, count;
+
+    SanityCheck();
+    ASSERT(IsEmpty());	// check that table is empty in various ways
+    for (; !iterator->IsDone(); iterator->Next()) {
+	ASSERTNOTREACHED();
+    }
+    delete iterator;
+
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+	SanityCheck();
+        ASSERT(IsInTable(getKey(p[i])));
+        ASSERT(!IsEmpty());
+    }
+
+    count = 0;
+    iterator = new OpenHashIterator<Key,T>(this);
+    for (; !iterator->IsDone(); iterator->Next()) {
+	ASSERT(IsInTable(getKey(iterator->Item())));
+	count++;
+    }
+    delete iterator;
+    ASSERT(count == numEntries);
+
+    // take every other one out, and put them back
+    for (i = 0; i < numEntries; i += 2) {
+        ASSERT(Remove(getKey(p[i])) == p[i]);
+	SanityCheck();
+    }
+    for (i = 0; i < numEntries; i++) {
+	ASSERT(IsInTable(getKey(p[i])) == (i % 2 == 1));
+    }
+    for (i = 0; i < numEntries; i += 2) {
+        Insert(p[i]);
+    }
+    SanityCheck();
+
+    // should be able to get out everything we put in
+    for (i = numEntries - 1; i >= 0; i--) {
+        ASSERT(Remove(getKey(p[i])) == p[i]);
+	SanityCheck();
+    }
+
+    ASSERT(IsEmpty());
+    SanityCheck();
+}
+
+//----------------------------------------------------------------------
+// OpenHashIterator<Key,T>::OpenHashIterator
+//      Initialize a data structure to allow us to step through
+//	every entry in a hash table: those in its old array, if it has
+//	one, then those in the new.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+OpenHashIterator<Key,T>::OpenHashIterator(OpenHashTable<Key,T> *tbl)
+{
+    table = tbl;
+    inOld = (table->oldSlots != NULL);
+    index = 0;
+    Skip();
+}
+
+//----------------------------------------------------------------------
+// OpenHashIterator<Key,T>::Skip
+//      Go on to the first slot with an item in it, starting from the
+//	one at "index".
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+OpenHashIterator<Key,T>::Skip()
+{
+    for (;;) {
+	OpenHashSlot<T> *slots = inOld ? table->oldSlots : table->slots;
+	int size = inOld ? table->numOldSlots : table->numSlots;
+
+	for (; index < size; index++) {
+	    if (slots[index].distance >= 0) {
+		slot = &slots[index];
+		return;
+	    }
+	}
+	if (!inOld) {
+	    slot = NULL;
+	    return;
+	}
+	inOld = FALSE;
+	index = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// OpenHashIterator<Key,T>::Next
+//      Update iterator to point to the next item in the table.
+//----------------------------------------------------------------------
+
+template <class Key,class T>
+void
+OpenHashIterator<Key,T>::Next()
+{
+    index++;
+    Skip();
+}
@@ -0,0 +1,153 @@
+// openhash.h
+//      Data structures to manage an open addressing hash table, relating
+//	keys to values as a HashTable (see hash.h) does, and with the
+//	same interface.
+//
+//	A HashTable keeps a List in each bucket, so finding an item
+//	means chasing pointers, and when it grows, every item is moved
+//	at once.  An OpenHashTable keeps its items in one flat array of
+//	slots, with no allocation per item: an item goes in the slot its
+//	key hashes to, or, if that is taken, in one of the slots after
+//	it (linear probing).  Items are kept in "Robin Hood" order -- an
+//	item that has come further from its home slot takes the place of
+//	one that has come less far -- so no item is ever very far from
+//	home, and a search for a key that isn't there stops early.
+//
+//	When the table gets too full it doubles, but the items are moved
+//	over a few slots at a time, on each later Insert and Remove,
+//	rather than all in one go; until they have all been moved, a
+//	search looks in the old array as well as the new one.
+//
+//	As with HashTable, the key must have a hash function, and the
+//	value must have a function defined to retrieve the key:
+//		unsigned Hash(Key k);
+//		Key GetKey(T x);
+//	and "==" must work for both keys and values.
+//
+//	Allocation and deallocation of the items in the table are to
+//	be done by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef OPENHASH_H
+#define OPENHASH_H
+
+#include "copyright.h"
+#include "debug.h"
+
+template <class Key, class T> class OpenHashIterator;
+
+// One slot of the array: an item, the hash of its key, and how far
+// the item is from the slot its key hashes to.
+
+const int EmptySlot = -1;	// "distance" of a slot with no item in it
+const int DeletedSlot = -2;	// and of one in the old array whose item
+				// was moved or removed
+
+template <class T>
+class OpenHashSlot {
+  public:
+    T item;
+    unsigned hash;		// (*hash)(getKey(item)), kept so that
+				// it needn't be recomputed
+    int distance;		// from the item's home slot, or one of
+				// the above
+};
+
+// The following class defines the hash table.
+
+template <class Key, class T>
+class OpenHashTable {
+  public:
+    OpenHashTable(Key (*get)(T x), unsigned (*hFunc)(Key x));
+				// initialize a hash table
+    ~OpenHashTable();		// deallocate a hash table
+
+    void Insert(T item);	// Put item into hash table
+    T Remove(Key key);		// Remove item from hash table.
+
+    bool Find(Key key, T *itemPtr) const;
+				// Find an item from its key
+    bool IsInTable(Key key) { T dummy; return Find(key, &dummy); }
+				// Is the item in the table?
+
+    bool IsEmpty() { return numItems == 0; }
+				// does the table have anything in it
+
+    void Apply(void (*f)(T)) const;
+				// apply function to all elements in table
+
+    void SanityCheck() const;	// is this still a legal hash table?
+    void SelfTest(T *p, int numItems);
+				// is the module working?
+
+  private:
+    typedef OpenHashSlot<T> Slot;
+
+    Slot *slots;		// the array items are put into
+    int numSlots;		// its size, a power of 2
+    int shift;			// 32 - log2(numSlots), to find a home slot
+    int numItems;		// the number of items in the table,
+				// in either array
+
+    Slot *oldSlots;		// the array being moved out of, or NULL
+    int numOldSlots;
+    int oldShift;
+    int numMoved;		// slots of it moved so far
+
+    Key (*getKey)(T x);		// get Key from value
+    unsigned (*hash)(Key x);	// the hash function
+
+    static Slot *NewSlots(int size);
+				// allocate an array, all empty
+    static int Home(unsigned h, int sh) { return (h * 2654435769u) >> sh; }
+				// the slot a hash belongs in
+
+    void Put(T item, unsigned h);
+				// put an item in the new array
+    int FindSlot(Slot *table, int size, int sh, Key key, unsigned h) const;
+				// where the key is in an array, or -1
+
+    void Grow();		// start moving into a bigger array
+    void MoveSome(int count);	// move "count" more of the old slots
+
+    friend class OpenHashIterator<Key,T>;
+};
+
+// The following class can be used to step through an OpenHashTable,
+// as a HashIterator does a HashTable:
+//	OpenHashIterator<Key, T> iter(table);
+//
+//	for (; !iter.IsDone(); iter.Next()) {
+//	    Operation on iter.Item()
+//	}
+//
+// The table must not be changed while it's being stepped through.
+
+template <class Key, class T>
+class OpenHashIterator {
+  public:
+    OpenHashIterator(OpenHashTable<Key,T> *table);
+				// initialize an iterator
+
+    bool IsDone() { return slot == NULL; }
+				// return TRUE if no more items in table
+    T Item() { ASSERT(!IsDone()); return slot->item; }
+				// return current item in table
+    void Next(); 		// update iterator to point to next
+
+  private:
+    OpenHashTable<Key,T> *table;// the hash table we're stepping through
+    bool inOld;			// are we in its old array?
+    int index;			// which slot we are at
+    OpenHashSlot<T> *slot;	// and that slot, or NULL when done
+
+    void Skip();		// go on to the next full slot, from index
+};
+
+#include "openhash.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // OPENHASH_H
@@ -0,0 +1,209 @@
+// pool.cc
+//	Routines to manage pools of fixed-size objects and of guarded
+//	thread stacks.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "pool.h"
+#include "sysdep.h"
+
+//----------------------------------------------------------------------
+// ObjectPool::ObjectPool
+// 	Initialize an empty pool; the first Alloc allocates a slab.
+//
+//	"objectSize" is how big each block must be.
+//	"objectsPerSlab" is how many blocks to allocate at a time.
+//----------------------------------------------------------------------
+
+ObjectPool::ObjectPool(int objectSize, int objectsPerSlab)
+{
+    int align = sizeof(double);
+
+    ASSERT(objectSize > 0 && objectsPerSlab > 0);
+    objectSize = max(objectSize, (int) sizeof(PoolLink));
+    size = (objectSize + align - 1) / align * align;
+    perSlab = objectsPerSlab;
+    freeList = NULL;
+    slabs = NULL;
+    numInUse = 0;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::~ObjectPool
+// 	Free all the slabs.  Every block must have been given back.
+//----------------------------------------------------------------------
+
+ObjectPool::~ObjectPool()
+{
+    ASSERT(numInUse == 0);
+    while (slabs != NULL) {
+        PoolLink *next = slabs->next;
+
+        delete [] (double *) slabs;
+        slabs = next;
+    }
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Grow
+// 	Allocate another slab.  Its first block holds the link to the
+//	other slabs; the rest go on the free list.
+//----------------------------------------------------------------------
+
+void
+ObjectPool::Grow()
+{
+    char *slab = (char *) new double[(perSlab + 1) * size / sizeof(double)];
+
+    ((PoolLink *) slab)->next = slabs;
+    slabs = (PoolLink *) slab;
+    for (int i = perSlab; i >= 1; i--) {
+        PoolLink *block = (PoolLink *) (slab + i * size);
+
+        block->next = freeList;
+        freeList = block;
+    }
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Alloc
+// 	Return a block from the free list, allocating a slab first if
+//	the list is empty.
+//----------------------------------------------------------------------
+
+void *
+ObjectPool::Alloc()
+{
+    PoolLink *block;
+
+    if (freeList == NULL) {
+        Grow();
+    }
+    block = freeList;
+    freeList = block->next;
+    numInUse++;
+    return (void *) block;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::Free
+// 	Put a block back on the free list.
+//
+//	"object" is a block returned by Alloc.
+//----------------------------------------------------------------------
+
+void
+ObjectPool::Free(void *object)
+{
+    PoolLink *block = (PoolLink *) object;
+
+    ASSERT(numInUse > 0);
+    block->next = freeList;
+    freeList = block;
+    numInUse--;
+}
+
+//----------------------------------------------------------------------
+// ObjectPool::SelfTest
+// 	Test whether this module is working.  The pool must be empty.
+//----------------------------------------------------------------------
+
+void
+ObjectPool::SelfTest()
+{
+    const int numBlocks = 3 * perSlab + 1;	// enough for four slabs
+    char **blocks = new char *[numBlocks];
+    PoolLink *firstSlab;
+    int i, j;
+
+    ASSERT(numInUse == 0);
+    for (i = 0; i < numBlocks; i++) {
+        blocks[i] = (char *) Alloc();
+        ASSERT(((unsigned long) blocks[i]) % sizeof(double) == 0);
+        memset(blocks[i], i, size);
+    }
+    for (i = 0; i < numBlocks; i++) {	// no two blocks overlap
+        for (j = 0; j < size; j++) {
+            ASSERT(blocks[i][j] == (char) i);
+        }
+    }
+    firstSlab = slabs;
+    for (i = 0; i < numBlocks; i += 2) {
+        Free(blocks[i]);
+    }
+    for (i = 0; i < numBlocks; i += 2) {	// freed blocks come back
+        blocks[i] = (char *) Alloc();	// before a new slab is made
+    }
+    ASSERT(slabs == firstSlab && numInUse == numBlocks);
+    for (i = 0; i < numBlocks; i++) {
+        Free(blocks[i]);
+    }
+    ASSERT(numInUse == 0);
+    delete [] blocks;
+}
+
+//----------------------------------------------------------------------
+// StackPool::StackPool
+// 	Initialize an empty pool of stacks.
+//
+//	"stackBytes" is the size of each stack.
+//	"maxFree" is how many freed stacks to keep; any more are
+//		given back to the system.
+//----------------------------------------------------------------------
+
+StackPool::StackPool(int stackBytes, int maxFree)
+{
+    size = stackBytes;
+    maxKept = maxFree;
+    numKept = 0;
+    kept = new char *[maxFree];
+}
+
+//----------------------------------------------------------------------
+// StackPool::~StackPool
+// 	Give back the stacks being kept.
+//----------------------------------------------------------------------
+
+StackPool::~StackPool()
+{
+    while (numKept > 0) {
+        DeallocBoundedArray(kept[--numKept], size);
+    }
+    delete [] kept;
+}
+
+//----------------------------------------------------------------------
+// StackPool::Get
+// 	Return a stack, with its guard pages, reusing one that was
+//	given back if there is one.
+//----------------------------------------------------------------------
+
+char *
+StackPool::Get()
+{
+    if (numKept > 0) {
+        return kept[--numKept];
+    }
+    return AllocBoundedArray(size);
+}
+
+//----------------------------------------------------------------------
+// StackPool::Put
+// 	Keep a stack for the next Get, or free it if we have enough.
+//
+//	"stack" is a stack returned by Get.
+//----------------------------------------------------------------------
+
+void
+StackPool::Put(char *stack)
+{
+    if (numKept < maxKept) {
+        kept[numKept++] = stack;
+    } else {
+        DeallocBoundedArray(stack, size);
+    }
+}
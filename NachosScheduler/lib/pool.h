@@ -0,0 +1,79 @@
+// pool.h
+//	Data structures to recycle memory that is allocated and freed
+//	over and over, such as Thread objects and their stacks.
+//
+//	An ObjectPool hands out fixed-size blocks, carved out of "slabs"
+//	of many blocks at a time; a freed block goes on a free list, to
+//	be handed out again before any new slab is allocated.  Slabs are
+//	only given back when the pool is deleted.
+//
+//	A StackPool keeps a number of freed thread stacks, each with the
+//	guard pages that AllocBoundedArray put around it, so the pages
+//	only have to be protected once per stack, not once per thread.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// A block on the free list, or the header of a slab.  The link is
+// kept in the block itself, which nobody is using.
+
+class PoolLink {
+  public:
+    PoolLink *next;
+};
+
+// The following class defines a pool of fixed-size blocks.
+
+class ObjectPool {
+  public:
+    ObjectPool(int objectSize, int objectsPerSlab);
+				// blocks of "objectSize" bytes, allocated
+				// "objectsPerSlab" at a time
+    ~ObjectPool();		// free every slab; all blocks must have
+				// been freed
+
+    void *Alloc();		// a block, recycled if possible
+    void Free(void *object);	// done with a block from Alloc
+
+    int NumInUse() { return numInUse; }
+    void SelfTest();		// test whether the pool is working
+
+  private:
+    int size;			// bytes per block, rounded up so that
+				// every block is aligned for a double
+    int perSlab;		// blocks per slab
+    PoolLink *freeList;		// blocks not in use
+    PoolLink *slabs;		// every slab, to free them at the end
+    int numInUse;
+
+    void Grow();		// allocate a slab, and put its blocks
+				// on the free list
+};
+
+// The following class defines a pool of guarded stacks.
+
+class StackPool {
+  public:
+    StackPool(int stackBytes, int maxFree);
+				// stacks of "stackBytes", keeping up to
+				// "maxFree" of them for reuse
+    ~StackPool();		// free the stacks being kept
+
+    char *Get();		// a stack, recycled if possible
+    void Put(char *stack);	// done with a stack from Get
+
+  private:
+    int size;			// bytes per stack
+    int maxKept;		// most stacks kept for reuse
+    int numKept;
+    char **kept;		// the stacks kept for reuse
+};
+
+#endif // POOL_H
@@ -0,0 +1,498 @@
+// rbtree.cc
+//      Routines to manage a red-black tree of "things".  Trees are
+//  implemented as templates, like lists, so that we can store
+//  anything in a tree in a type-safe manner.
+//
+//  An "RBNode" is allocated for each item put in the tree; it is
+//  de-allocated when the item is removed.
+//
+//  The balancing follows Cormen, Leiserson and Rivest, with NULL
+//  standing in for the black leaves.
+//
+//      NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+
+//----------------------------------------------------------------------
+// RBNode<T>::RBNode
+//  Initialize a tree node, so it can be added to a tree.  New
+//  nodes are red.
+//
+//  "itm" is the thing to be put in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+RBNode<T>::RBNode(T itm)
+{
+    item = itm;
+    left = right = parent = NULL;
+    red = TRUE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RBTree
+//  Initialize an empty tree.
+//
+//  "comp" orders the items in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+RBTree<T>::RBTree(int (*comp)(T x, T y))
+{
+    root = leftmost = NULL;
+    numInTree = 0;
+    compare = comp;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::~RBTree
+//  Prepare a tree for deallocation.  Frees the tree nodes, but
+//  *NOT* the items they point to.
+//----------------------------------------------------------------------
+
+template <class T>
+RBTree<T>::~RBTree()
+{
+    DeleteSubtree(root);
+}
+
+template <class T>
+void
+RBTree<T>::DeleteSubtree(RBNode<T> *node)
+{
+    if (node != NULL) {
+        DeleteSubtree(node->left);
+        DeleteSubtree(node->right);
+        delete node;
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Find
+//  Return the node holding "item", or NULL if it isn't in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+RBNode<T> *
+RBTree<T>::Find(T item) const
+{
+    RBNode<T> *node = root;
+
+    while (node != NULL) {
+        int c = compare(item, node->item);
+        if (c == 0) {
+            return node;
+        }
+        node = (c < 0) ? node->left : node->right;
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RotateLeft, RBTree<T>::RotateRight
+//  Rotate the subtree at "x", keeping the tree ordered.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::RotateLeft(RBNode<T> *x)
+{
+    RBNode<T> *y = x->right;
+
+    x->right = y->left;
+    if (y->left != NULL) {
+        y->left->parent = x;
+    }
+    Replace(x, y);
+    y->left = x;
+    x->parent = y;
+}
+
+template <class T>
+void
+RBTree<T>::RotateRight(RBNode<T> *x)
+{
+    RBNode<T> *y = x->left;
+
+    x->left = y->right;
+    if (y->right != NULL) {
+        y->right->parent = x;
+    }
+    Replace(x, y);
+    y->right = x;
+    x->parent = y;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Replace
+//  Make "v" take the place of "u" under u's parent.  "v" may be NULL.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Replace(RBNode<T> *u, RBNode<T> *v)
+{
+    if (u->parent == NULL) {
+        root = v;
+    } else if (u == u->parent->left) {
+        u->parent->left = v;
+    } else {
+        u->parent->right = v;
+    }
+    if (v != NULL) {
+        v->parent = u->parent;
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Insert
+//  Put "item" into the tree, then rebalance.
+//
+//  "item" is the thing to put in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Insert(T item)
+{
+    RBNode<T> *node = new RBNode<T>(item);
+    RBNode<T> *parent = NULL;
+    RBNode<T> *ptr = root;
+    bool isLeftmost = TRUE;
+    int c = 0;
+
+    while (ptr != NULL) {
+        parent = ptr;
+        c = compare(item, ptr->item);
+        ASSERT(c != 0);             // items must be distinct
+        if (c < 0) {
+            ptr = ptr->left;
+        } else {
+            ptr = ptr->right;
+            isLeftmost = FALSE;
+        }
+    }
+    node->parent = parent;
+    if (parent == NULL) {
+        root = node;
+    } else if (c < 0) {
+        parent->left = node;
+    } else {
+        parent->right = node;
+    }
+    if (isLeftmost) {
+        leftmost = node;
+    }
+    numInTree++;
+    InsertFixup(node);
+}
+
+template <class T>
+void
+RBTree<T>::InsertFixup(RBNode<T> *z)
+{
+    while (z->parent != NULL && z->parent->red) {
+        RBNode<T> *gp = z->parent->parent;      // exists: root is black
+        if (z->parent == gp->left) {
+            RBNode<T> *uncle = gp->right;
+            if (uncle != NULL && uncle->red) {
+                z->parent->red = FALSE;
+                uncle->red = FALSE;
+                gp->red = TRUE;
+                z = gp;
+            } else {
+                if (z == z->parent->right) {
+                    z = z->parent;
+                    RotateLeft(z);
+                }
+                z->parent->red = FALSE;
+                gp->red = TRUE;
+                RotateRight(gp);
+            }
+        } else {
+            RBNode<T> *uncle = gp->left;
+            if (uncle != NULL && uncle->red) {
+                z->parent->red = FALSE;
+                uncle->red = FALSE;
+                gp->red = TRUE;
+                z = gp;
+            } else {
+                if (z == z->parent->left) {
+                    z = z->parent;
+                    RotateRight(z);
+                }
+                z->parent->red = FALSE;
+                gp->red = TRUE;
+                RotateLeft(gp);
+            }
+        }
+    }
+    root->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Remove
+//  Take "item" out of the tree, then rebalance.  The item must be
+//  in the tree.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Remove(T item)
+{
+    RBNode<T> *z = Find(item);
+    RBNode<T> *x, *xParent;
+    bool removedRed;
+
+    ASSERT(z != NULL);
+
+    if (z == leftmost) {            // in-order successor is new leftmost
+        if (z->right != NULL) {
+            for (leftmost = z->right; leftmost->left != NULL;
+                                        leftmost = leftmost->left)
+                ;
+        } else {
+            leftmost = z->parent;
+        }
+    }
+
+    removedRed = z->red;
+    if (z->left == NULL) {
+        x = z->right;
+        xParent = z->parent;
+        Replace(z, z->right);
+    } else if (z->right == NULL) {
+        x = z->left;
+        xParent = z->parent;
+        Replace(z, z->left);
+    } else {                        // splice out z's successor, y
+        RBNode<T> *y = z->right;
+        while (y->left != NULL) {
+            y = y->left;
+        }
+        removedRed = y->red;
+        x = y->right;
+        if (y->parent == z) {
+            xParent = y;
+        } else {
+            xParent = y->parent;
+            Replace(y, y->right);
+            y->right = z->right;
+            y->right->parent = y;
+        }
+        Replace(z, y);
+        y->left = z->left;
+        y->left->parent = y;
+        y->red = z->red;
+    }
+    delete z;
+    numInTree--;
+    if (!removedRed) {
+        RemoveFixup(x, xParent);
+    }
+}
+
+template <class T>
+void
+RBTree<T>::RemoveFixup(RBNode<T> *x, RBNode<T> *xParent)
+{
+    while (x != root && (x == NULL || !x->red)) {
+        if (x == xParent->left) {
+            RBNode<T> *w = xParent->right;
+            if (w->red) {
+                w->red = FALSE;
+                xParent->red = TRUE;
+                RotateLeft(xParent);
+                w = xParent->right;
+            }
+            if ((w->left == NULL || !w->left->red) &&
+                    (w->right == NULL || !w->right->red)) {
+                w->red = TRUE;
+                x = xParent;
+                xParent = x->parent;
+            } else {
+                if (w->right == NULL || !w->right->red) {
+                    w->left->red = FALSE;
+                    w->red = TRUE;
+                    RotateRight(w);
+                    w = xParent->right;
+                }
+                w->red = xParent->red;
+                xParent->red = FALSE;
+                w->right->red = FALSE;
+                RotateLeft(xParent);
+                x = root;
+            }
+        } else {
+            RBNode<T> *w = xParent->left;
+            if (w->red) {
+                w->red = FALSE;
+                xParent->red = TRUE;
+                RotateRight(xParent);
+                w = xParent->left;
+            }
+            if ((w->left == NULL || !w->left->red) &&
+                    (w->right == NULL || !w->right->red)) {
+                w->red = TRUE;
+                x = xParent;
+                xParent = x->parent;
+            } else {
+                if (w->left == NULL || !w->left->red) {
+                    w->right->red = FALSE;
+                    w->red = TRUE;
+                    RotateLeft(w);
+                    w = xParent->left;
+                }
+                w->red = xParent->red;
+                xParent->red = FALSE;
+                w->left->red = FALSE;
+                RotateRight(xParent);
+                x = root;
+            }
+        }
+    }
+    if (x != NULL) {
+        x->red = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::RemoveFirst
+//  Remove the smallest item from the tree and return it.  The
+//  tree must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+RBTree<T>::RemoveFirst()
+{
+    T item = First();
+
+    Remove(item);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::Apply
+//  Apply "func" to every item in the tree, smallest first.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::Apply(void (*func)(T)) const
+{
+    ApplySubtree(root, func);
+}
+
+template <class T>
+void
+RBTree<T>::ApplySubtree(RBNode<T> *node, void (*func)(T)) const
+{
+    if (node != NULL) {
+        ApplySubtree(node->left, func);
+        (*func)(node->item);
+        ApplySubtree(node->right, func);
+    }
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::SanityCheck
+//  Test whether this is still a legal red-black tree.
+//
+//  Tests: is the tree ordered?
+//         does every path have the same number of black nodes?
+//         does any red node have a red child?
+//         is the item count and the cached leftmost node right?
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::SanityCheck() const
+{
+    int count = 0;
+
+    if (root == NULL) {
+        ASSERT(numInTree == 0 && leftmost == NULL);
+        return;
+    }
+    ASSERT(!root->red && root->parent == NULL);
+    (void) CheckSubtree(root, &count);
+    ASSERT(count == numInTree);
+
+    RBNode<T> *node = root;
+    while (node->left != NULL) {
+        node = node->left;
+    }
+    ASSERT(node == leftmost);
+}
+
+template <class T>
+int
+RBTree<T>::CheckSubtree(RBNode<T> *node, int *count) const
+{
+    int leftBlack, rightBlack;
+
+    if (node == NULL) {
+        return 1;
+    }
+    (*count)++;
+    if (node->left != NULL) {
+        ASSERT(node->left->parent == node);
+        ASSERT(compare(node->left->item, node->item) < 0);
+        ASSERT(!(node->red && node->left->red));
+    }
+    if (node->right != NULL) {
+        ASSERT(node->right->parent == node);
+        ASSERT(compare(node->item, node->right->item) < 0);
+        ASSERT(!(node->red && node->right->red));
+    }
+    leftBlack = CheckSubtree(node->left, count);
+    rightBlack = CheckSubtree(node->right, count);
+    ASSERT(leftBlack == rightBlack);
+    return leftBlack + (node->red ? 0 : 1);
+}
+
+//----------------------------------------------------------------------
+// RBTree<T>::SelfTest
+//  Test whether this module is working.  The entries must be
+//  distinct.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+RBTree<T>::SelfTest(T *p, int numEntries)
+{
+    int i;
+    T *q = new T[numEntries];
+
+    SanityCheck();
+    ASSERT(IsEmpty());
+
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+        ASSERT(IsInTree(p[i]));
+        SanityCheck();
+    }
+
+    // remove every other item by value, the rest in order
+    for (i = 0; i < numEntries; i += 2) {
+        Remove(p[i]);
+        ASSERT(!IsInTree(p[i]));
+        SanityCheck();
+    }
+    for (i = 0; !IsEmpty(); i++) {
+        q[i] = RemoveFirst();
+        SanityCheck();
+    }
+    ASSERT(i == numEntries / 2);
+
+    // make sure everything came out in the right order
+    for (i = 0; i < (numEntries / 2) - 1; i++) {
+        ASSERT(compare(q[i], q[i + 1]) < 0);
+    }
+    delete [] q;
+}
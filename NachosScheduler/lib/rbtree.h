@@ -0,0 +1,90 @@
+// rbtree.h
+//	Data structures to manage a red-black tree -- a balanced binary
+//	search tree, ordered by a comparison function supplied by the
+//	caller.  Insert, Remove and RemoveFirst take O(log n) time;
+//	First is O(1), because the leftmost node is cached.
+//
+//	As with lists, allocation and deallocation of the items in the
+//	tree are to be done by the caller.
+//
+//	The comparison function must be a total order on the items
+//	that are in the tree at the same time: Remove finds an item by
+//	searching for it, so two different items must never compare
+//	equal.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "copyright.h"
+#include "debug.h"
+
+// The following class defines a tree node.  It is private to this
+// module; made public for notational convenience.
+
+template <class T>
+class RBNode {
+  public:
+    RBNode(T itm);		// initialize a tree node
+    RBNode *left;		// smaller items
+    RBNode *right;		// larger items
+    RBNode *parent;		// NULL for the root
+    bool red;			// colour of the node
+    T item;			// item in the tree
+};
+
+// The following class defines a red-black tree of items.  All types
+// to be inserted must have a "Compare" function supplied:
+//	   int Compare(T x, T y)
+//		returns -1 if x < y
+//		returns 0 if x == y
+//		returns 1 if x > y
+
+template <class T>
+class RBTree {
+  public:
+    RBTree(int (*comp)(T x, T y));	// initialize an empty tree
+    ~RBTree();			// de-allocate the tree's nodes
+
+    void Insert(T item);	// put item in the tree
+    void Remove(T item);	// take item out of the tree; it must
+				// be there
+    T First() { ASSERT(leftmost != NULL); return leftmost->item; }
+				// smallest item, without removing it
+    T RemoveFirst();		// take the smallest item out of the tree
+    bool IsInTree(T item) const { return (Find(item) != NULL); }
+
+    bool IsEmpty() const { return (numInTree == 0); }
+    int NumInTree() const { return numInTree; }
+
+    void Apply(void (*func)(T)) const;
+				// apply function to all items, in order
+
+    void SanityCheck() const;	// has this tree been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    RBNode<T> *root;		// NULL if the tree is empty
+    RBNode<T> *leftmost;	// node holding the smallest item
+    int numInTree;		// number of items in the tree
+    int (*compare)(T x, T y);	// function for ordering items
+
+    RBNode<T> *Find(T item) const;
+    void RotateLeft(RBNode<T> *x);
+    void RotateRight(RBNode<T> *x);
+    void InsertFixup(RBNode<T> *z);
+    void RemoveFixup(RBNode<T> *x, RBNode<T> *xParent);
+    void Replace(RBNode<T> *u, RBNode<T> *v);
+    void DeleteSubtree(RBNode<T> *node);
+    void ApplySubtree(RBNode<T> *node, void (*func)(T)) const;
+    int CheckSubtree(RBNode<T> *node, int *count) const;
+};
+
+#include "rbtree.cc"		// templates are really like macros
+				// so needs to be included in every
+				// file that uses the template
+#endif // RBTREE_H
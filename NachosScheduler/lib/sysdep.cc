@@ -29,10 +29,16 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <cerrno>
+#include <pthread.h>
+#ifndef DOS
+#include <sys/mman.h>
+#endif
 
 #ifdef SOLARIS
 // KMS
@@ -119,6 +125,159 @@ CallOnUserAbort(void (*func)(int))
     (void)signal(SIGINT, func);
 }
 
+//----------------------------------------------------------------------
+// CallOnProfileTick
+//  Arrange that "func" be called, as a signal handler, after every
+//  "micros" microseconds of CPU time the host gives Nachos; or, if
+//  "micros" is 0, no longer.  Return FALSE if the host can't do that.
+//
+//  "func" runs at any time, and so must do no more than count.
+//  Interrupted system calls are restarted, where they can be.
+//----------------------------------------------------------------------
+
+bool
+CallOnProfileTick(int micros, void (*func)(int))
+{
+#if defined(ITIMER_PROF) && defined(SA_RESTART)
+    struct sigaction action;
+    struct itimerval timer;
+
+    bzero(&timer, sizeof(timer));
+    timer.it_interval.tv_sec = micros / 1000000;
+    timer.it_interval.tv_usec = micros % 1000000;
+    timer.it_value = timer.it_interval;
+    if (micros == 0) {
+        (void) setitimer(ITIMER_PROF, &timer, NULL);
+        (void) signal(SIGPROF, SIG_DFL);
+        return TRUE;
+    }
+    bzero(&action, sizeof(action));
+    action.sa_handler = func;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(SIGPROF, &action, NULL) < 0
+        || setitimer(ITIMER_PROF, &timer, NULL) < 0) {
+        (void) signal(SIGPROF, SIG_DFL);
+        return FALSE;
+    }
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// StartHostThread
+//  Start a host thread running "func(arg)", with every signal blocked,
+//  and return it, to be joined.  Abort if the host can't.
+//
+//  The thread runs at the same time as Nachos, so it must touch only
+//  what it is given, and its own host I/O.
+//----------------------------------------------------------------------
+
+struct HostThreadStart {
+    void (*func)(void *);
+    void *arg;
+};
+
+static void *
+HostThreadRoot(void *p)
+{
+    HostThreadStart start = *(HostThreadStart *) p;
+
+    delete (HostThreadStart *) p;
+    (*start.func)(start.arg);
+    return NULL;
+}
+
+void *
+StartHostThread(void (*func)(void *), void *arg)
+{
+    pthread_t *thread = new pthread_t;
+    HostThreadStart *start = new HostThreadStart;
+    sigset_t all, saved;
+    int retVal;
+
+    start->func = func;
+    start->arg = arg;
+    sigfillset(&all);			// the new thread inherits the mask
+    pthread_sigmask(SIG_SETMASK, &all, &saved);
+    retVal = pthread_create(thread, NULL, HostThreadRoot, start);
+    pthread_sigmask(SIG_SETMASK, &saved, NULL);
+    ASSERT(retVal == 0);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// JoinHostThread
+//  Wait for a host thread to return, and forget it.
+//----------------------------------------------------------------------
+
+void
+JoinHostThread(void *thread)
+{
+    pthread_join(*(pthread_t *) thread, NULL);
+    delete (pthread_t *) thread;
+}
+
+//----------------------------------------------------------------------
+// NewHostSemaphore, DeleteHostSemaphore, HostSemaphoreP, HostSemaphoreV
+//  A counting semaphore, initially 0, for host threads.  Built of a
+//  mutex and a condition, which every host has (unnamed POSIX
+//  semaphores some don't).
+//----------------------------------------------------------------------
+
+struct HostSemaphore {
+    pthread_mutex_t mutex;
+    pthread_cond_t nonZero;
+    int value;
+};
+
+void *
+NewHostSemaphore()
+{
+    HostSemaphore *sem = new HostSemaphore;
+
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->nonZero, NULL);
+    sem->value = 0;
+    return sem;
+}
+
+void
+DeleteHostSemaphore(void *p)
+{
+    HostSemaphore *sem = (HostSemaphore *) p;
+
+    pthread_cond_destroy(&sem->nonZero);
+    pthread_mutex_destroy(&sem->mutex);
+    delete sem;
+}
+
+void
+HostSemaphoreP(void *p)
+{
+    HostSemaphore *sem = (HostSemaphore *) p;
+
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->value == 0) {
+        pthread_cond_wait(&sem->nonZero, &sem->mutex);
+    }
+    sem->value--;
+    pthread_mutex_unlock(&sem->mutex);
+}
+
+void
+HostSemaphoreV(void *p)
+{
+    HostSemaphore *sem = (HostSemaphore *) p;
+
+    pthread_mutex_lock(&sem->mutex);
+    sem->value++;
+    pthread_cond_signal(&sem->nonZero);
+    pthread_mutex_unlock(&sem->mutex);
+}
+
 //----------------------------------------------------------------------
 // Delay
 //  Put the UNIX process running Nachos to sleep for x seconds,
@@ -149,6 +308,37 @@ UDelay(unsigned int useconds)
 
 }
 
+//----------------------------------------------------------------------
+// HostTime
+//  Return the time on the host, in seconds (to the microsecond), since
+//  some time in the past.
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval now;
+
+    (void) gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1.0e6;
+}
+
+//----------------------------------------------------------------------
+// HostCPUTime
+//  Return the CPU time the host has given Nachos, in user mode and in
+//  the host's kernel, in seconds since Nachos started.
+//----------------------------------------------------------------------
+
+double
+HostCPUTime()
+{
+    struct rusage usage;
+
+    (void) getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1.0e6
+	+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1.0e6;
+}
+
 //----------------------------------------------------------------------
 // Abort
 //  Quit and drop core.
@@ -280,15 +470,18 @@ PollFile(int fd)
     pollTime.tv_sec = 0;
     pollTime.tv_usec = 0;
 
-    // poll file or socket
+    // poll file or socket; a signal (see CallOnSocketInput) may cut
+    // it short
+    do {
 #if defined(BSD)
-    retVal = select(32, (fd_set *)&rfd, (fd_set *)&wfd, (fd_set *)&xfd, &pollTime);
+        retVal = select(32, (fd_set *)&rfd, (fd_set *)&wfd, (fd_set *)&xfd, &pollTime);
 #elif defined(SOLARIS) || defined(LINUX)
-    // KMS
-    retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
+        // KMS
+        retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
 #else
-    retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
+        retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
 #endif
+    } while (retVal < 0 && InterruptedCall());
 
     ASSERT((retVal == 0) || (retVal == 1));
     if (retVal == 0)
@@ -379,6 +572,71 @@ Lseek(int fd, int offset, int whence)
     ASSERT(retVal >= 0);
 }
 
+//----------------------------------------------------------------------
+// ReadPartialAt
+//  Read characters from an open file, from "offset" on, returning as
+//  many as are available.  The file's own position is not used, nor
+//  changed.
+//----------------------------------------------------------------------
+
+int
+ReadPartialAt(int fd, char *buffer, int nBytes, int offset)
+{
+#ifdef DOS
+    Lseek(fd, offset, 0);
+    return read(fd, buffer, nBytes);
+#else
+    return pread(fd, buffer, nBytes, offset);
+#endif
+}
+
+//----------------------------------------------------------------------
+// WriteFileAt
+//  Write characters to an open file, from "offset" on.  Abort if the
+//  write fails.  The file's own position is not used, nor changed.
+//----------------------------------------------------------------------
+
+void
+WriteFileAt(int fd, char *buffer, int nBytes, int offset)
+{
+#ifdef DOS
+    Lseek(fd, offset, 0);
+    WriteFile(fd, buffer, nBytes);
+#else
+    int retVal = pwrite(fd, buffer, nBytes, offset);
+    ASSERT(retVal == nBytes);
+#endif
+}
+
+//----------------------------------------------------------------------
+// FileSize
+//  Report how many bytes an open file has.
+//----------------------------------------------------------------------
+
+int
+FileSize(int fd)
+{
+    struct stat status;
+    int retVal = fstat(fd, &status);
+
+    ASSERT(retVal == 0);
+    return (int) status.st_size;
+}
+
+//----------------------------------------------------------------------
+// IsPlainFile
+//  Report whether an open file is an ordinary file: one that is
+//  always ready to be read, to its end, without waiting.
+//----------------------------------------------------------------------
+
+bool
+IsPlainFile(int fd)
+{
+    struct stat status;
+
+    return fstat(fd, &status) == 0 && S_ISREG(status.st_mode);
+}
+
 //----------------------------------------------------------------------
 // Tell
 //  Report the current location within an open file.
@@ -420,6 +678,75 @@ Unlink(char *name)
     return unlink(name);
 }
 
+//----------------------------------------------------------------------
+// StatFile
+//  Find out when a file was last changed, and how long it is.  Return
+//  FALSE if there is no such file.
+//----------------------------------------------------------------------
+
+bool
+StatFile(char *name, long *modified, int *length)
+{
+    struct stat status;
+
+    if (stat(name, &status) < 0) {
+	return FALSE;
+    }
+    *modified = (long) status.st_mtime;
+    *length = (int) status.st_size;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// MapFile
+//  Map "size" bytes of an open file, from "offset", into memory.  If
+//  "shared", writes to the mapping go to the file (in the host's own
+//  time; see SyncFile); otherwise it is private, and they don't.  The
+//  mapping lasts after the file is closed.  Returns NULL if it can't
+//  be done.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int offset, int size, bool shared)
+{
+#ifdef DOS
+    return NULL;
+#else
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                   shared ? MAP_SHARED : MAP_PRIVATE, fd, offset);
+
+    return (p == MAP_FAILED) ? NULL : (char *) p;
+#endif
+}
+
+//----------------------------------------------------------------------
+// SyncFile
+//  Wait until the file mapped, shared, at "p" has every change made
+//  through the "size" bytes of the mapping.
+//----------------------------------------------------------------------
+
+void
+SyncFile(char *p, int size)
+{
+#ifndef DOS
+    int retVal = msync(p, size, MS_SYNC);
+    ASSERT(retVal == 0);
+#endif
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+//  Undo MapFile.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *p, int size)
+{
+#ifndef DOS
+    munmap(p, size);
+#endif
+}
+
 //----------------------------------------------------------------------
 // OpenSocket
 //  Open an interprocess communication (IPC) connection.  For now,
@@ -502,6 +829,65 @@ PollSocket(int sockID)
     return PollFile(sockID);    // on UNIX, socket ID's are just file ID's
 }
 
+//----------------------------------------------------------------------
+// WaitForSocket
+//  Wait up to "micros" microseconds (forever, if it is negative) for a
+//  message to arrive on the IPC port, and return TRUE if one has.  A
+//  signal cuts the wait short, and may be for a message: we return
+//  TRUE then too, and the caller polls to see.
+//----------------------------------------------------------------------
+bool
+WaitForSocket(int sockID, int micros)
+{
+    fd_set rfd;
+    struct timeval waitTime;
+    int retVal;
+
+    FD_ZERO(&rfd);
+    FD_SET(sockID, &rfd);
+    waitTime.tv_sec = micros / 1000000;
+    waitTime.tv_usec = micros % 1000000;
+
+    retVal = select(sockID + 1, &rfd, NULL, NULL,
+                    (micros < 0) ? NULL : &waitTime);
+    if (retVal < 0) {
+        ASSERT(InterruptedCall());
+        return TRUE;
+    }
+    return (retVal > 0);
+}
+
+//----------------------------------------------------------------------
+// CallOnSocketInput
+//  Arrange that "func" be called, as a signal handler, whenever a
+//  message arrives on the IPC port, so that it needn't be polled.
+//  Return FALSE if the host can't do that: the caller must poll.
+//
+//  "func" runs at any time, and so must do no more than set a flag.
+//  Interrupted system calls are restarted, where they can be.
+//----------------------------------------------------------------------
+bool
+CallOnSocketInput(int sockID, void (*func)(int))
+{
+#if defined(O_ASYNC) && defined(F_SETOWN) && defined(SA_RESTART)
+    struct sigaction action;
+
+    bzero(&action, sizeof(action));
+    action.sa_handler = func;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    if (sigaction(SIGIO, &action, NULL) < 0
+        || fcntl(sockID, F_SETOWN, getpid()) < 0
+        || fcntl(sockID, F_SETFL, fcntl(sockID, F_GETFL) | O_ASYNC) < 0) {
+        (void) signal(SIGIO, SIG_DFL);
+        return FALSE;
+    }
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
 //----------------------------------------------------------------------
 // ReadFromSocket
 //  Read a fixed size packet off the IPC port.  Abort on error.
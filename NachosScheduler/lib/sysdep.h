@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 
 using namespace std;
 
@@ -25,9 +26,28 @@ extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);// rcgood - to avoid spinners.
 
+// The time on the host, in seconds since some time in the past: for
+// measuring how long Nachos takes to do something
+extern double HostTime();
+extern double HostCPUTime();		// and the CPU time it has used
+
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
 
+// Call a routine every so many microseconds of the host's CPU time:
+// for sampling what Nachos is doing
+extern bool CallOnProfileTick(int micros, void (*func)(int));
+
+// Host threads, to do the devices' host I/O alongside the simulation
+// (see hostio.h), and counting semaphores for them to wait on.  A host
+// thread takes no signals; they all go to the simulation.
+extern void *StartHostThread(void (*func)(void *), void *arg);
+extern void JoinHostThread(void *thread);
+extern void *NewHostSemaphore();
+extern void DeleteHostSemaphore(void *sem);
+extern void HostSemaphoreP(void *sem);
+extern void HostSemaphoreV(void *sem);
+
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
 extern unsigned int RandomNumber();
@@ -41,6 +61,10 @@ extern void DeallocBoundedArray(char *p, int size);
 // If no characters in the file, return without waiting.
 extern bool PollFile(int fd);
 
+// Did the host system call that just failed stop for a signal?
+// (It's in hosterrno.cc, which sees the host's errno.)
+extern bool InterruptedCall();
+
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
 extern int OpenForWrite(char *name);
@@ -50,8 +74,23 @@ extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
 extern int Tell(int fd);
+extern int ReadPartialAt(int fd, char *buffer, int nBytes, int offset);
+extern void WriteFileAt(int fd, char *buffer, int nBytes, int offset);
+					// at "offset", in one call, leaving
+					// the file's position as it was
+extern int FileSize(int fd);		// how long an open file is
+extern bool IsPlainFile(int fd);	// not a terminal, pipe or socket
 extern int Close(int fd);
 extern bool Unlink(char *name);
+extern bool StatFile(char *name, long *modified, int *length);
+
+// Map part of a file into memory -- copy-on-write, or, if "shared", so
+// that writes to it go to the file -- or return NULL if the host can't;
+// make sure the file has what was written; and unmap it.  "offset" must
+// be page aligned.
+extern char *MapFile(int fd, int offset, int size, bool shared);
+extern void SyncFile(char *p, int size);
+extern void UnmapFile(char *p, int size);
 
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
@@ -69,6 +108,8 @@ extern void CloseSocket(int sockID);
 extern void AssignNameToSocket(char *socketName, int sockID);
 extern void DeAssignNameToSocket(char *socketName);
 extern bool PollSocket(int sockID);
+extern bool WaitForSocket(int sockID, int micros);
+extern bool CallOnSocketInput(int sockID, void (*func)(int));
 extern void ReadFromSocket(int sockID, char *buffer, int packetSize);
 extern void SendToSocket(int sockID, char *buffer, int packetSize, char *toName);
 
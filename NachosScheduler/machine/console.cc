@@ -34,10 +34,20 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
 
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
-    incoming = EOF;
+    first = numIncoming = 0;
+    ended = FALSE;
 
-    // start polling for incoming keystrokes
+    // an ordinary file is always ready to be read, so it can be read
+    // ahead, by a host thread
+    io = NULL;
+    if (kernel->hostIO && IsPlainFile(readFileNo)) {
+	io = new HostIOQueue();
+	pending = io->Read(readFileNo, ahead, ConsoleInputSize, -1);
+    }
+
+    // polling for incoming keystrokes starts when someone wants them
     //kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    polling = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -47,6 +57,7 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
 
 ConsoleInput::~ConsoleInput()
 {
+    delete io;
     if (readFileNo != 0)
 	Close(readFileNo);
 }
@@ -57,36 +68,47 @@ ConsoleInput::~ConsoleInput()
 // 	Simulator calls this when a character may be available to be
 //	read in from the simulated keyboard (eg, the user typed something).
 //
-//	First check to make sure character is available.
-//	Then invoke the "callBack" registered by whoever wants the character.
+//	First check to make sure characters are available, and read
+//	all of them there are (that fit) at once.
+//	Then invoke the "callBack" registered by whoever wants them.
 //----------------------------------------------------------------------
 
 void
 ConsoleInput::CallBack()
 {
-  char c;
   int readCount;
+  HostPhase phase(HostIO);
 
-    ASSERT(incoming == EOF);
-    if (!PollFile(readFileNo)) { // nothing to be read
+    ASSERT(numIncoming == 0);
+    if (io == NULL && !PollFile(readFileNo)) { // nothing to be read
         // schedule the next time to poll for a packet
         kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
     } else { 
-    	// otherwise, try to read a character
-    	readCount = ReadPartial(readFileNo, &c, sizeof(char));
-	if (readCount == 0) {
+    	// otherwise, read what there is, or take what was read
+	// ahead, and have the next read
+	polling = FALSE;
+	if (io == NULL) {
+	    readCount = ReadPartial(readFileNo, incoming, ConsoleInputSize);
+	} else {
+	    readCount = io->Wait(pending);
+	    if (readCount > 0) {
+		bcopy(ahead, incoming, readCount);
+		pending = io->Read(readFileNo, ahead, ConsoleInputSize, -1);
+	    }
+	}
+	if (readCount <= 0) {
 	   // this seems to happen at end of file, when the
 	   // console input is a regular file
 	   // don't schedule an interrupt, since there will never
 	   // be any more input
-	   // just do nothing....
+	   ended = TRUE;
 	}
 	else {
-	  // save the character and notify the OS that
-	  // it is available
-	  ASSERT(readCount == sizeof(char));
-	  incoming = c;
-	  kernel->stats->numConsoleCharsRead++;
+	  // save the characters and notify the OS that
+	  // they are available
+	  first = 0;
+	  numIncoming = readCount;
+	  kernel->stats->numConsoleCharsRead += readCount;
 	}
 	callWhenAvail->CallBack();
     }
@@ -101,15 +123,48 @@ ConsoleInput::CallBack()
 char
 ConsoleInput::GetChar()
 {
-   char ch = incoming;
+   char ch;
 
-   if (incoming != EOF) {	// schedule when next char will arrive
-       kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+   if (GetString(&ch, 1) == 0) {
+       return EOF;
    }
-   incoming = EOF;
    return ch;
 }
 
+//----------------------------------------------------------------------
+// ConsoleInput::GetString()
+// 	Take up to "length" of the characters that have arrived, into
+//	"into", and return how many.  The keyboard isn't polled for more
+//	until someone asks, with Poll.
+//----------------------------------------------------------------------
+
+int
+ConsoleInput::GetString(char *into, int length)
+{
+    int taken = (length < numIncoming) ? length : numIncoming;
+
+    bcopy(&incoming[first], into, taken);
+    first += taken;
+    numIncoming -= taken;
+    return taken;
+}
+
+//----------------------------------------------------------------------
+// ConsoleInput::Poll()
+// 	Start looking for input, if nothing is waiting to be taken and
+//	we aren't already looking, and there may be more to come.  Each
+//	poll ends in one call of "callWhenAvail".
+//----------------------------------------------------------------------
+
+void
+ConsoleInput::Poll()
+{
+    if (numIncoming == 0 && !polling && !ended) {
+	kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+	polling = TRUE;
+    }
+}
+
 
 
 //----------------------------------------------------------------------
@@ -130,6 +185,12 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
 
     callWhenDone = toCall;
     putBusy = FALSE;
+    putCount = 0;
+    io = NULL;
+    if (kernel->hostIO && writeFileNo != 1) {
+	io = new HostIOQueue();
+    }
+    lastRequest = -1;
 }
 
 //----------------------------------------------------------------------
@@ -139,6 +200,7 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
 
 ConsoleOutput::~ConsoleOutput()
 {
+    delete io;
     if (writeFileNo != 1)
 	Close(writeFileNo);
 }
@@ -152,8 +214,11 @@ ConsoleOutput::~ConsoleOutput()
 void
 ConsoleOutput::CallBack()
 {
+    if (io != NULL) {			// it's out by now
+	(void) io->Wait(lastRequest);
+    }
     putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
+    kernel->stats->numConsoleCharsWritten += putCount;
     callWhenDone->CallBack();
 }
 
@@ -166,19 +231,61 @@ ConsoleOutput::CallBack()
 void
 ConsoleOutput::PutChar(char ch)
 {
+    HostPhase phase(HostIO);
+
     ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
+    Write(&ch, sizeof(char));
     putBusy = TRUE;
+    putCount = 1;
+    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
+}
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutString()
+// 	Write "length" characters from "data" to the simulated display in
+//	one write, schedule one interrupt for all of them, and return.
+//----------------------------------------------------------------------
+
+void
+ConsoleOutput::PutString(char *data, int length)
+{
+    HostPhase phase(HostIO);
+
+    ASSERT(putBusy == FALSE);
+    ASSERT(length > 0);
+    Write(data, length);
+    putBusy = TRUE;
+    putCount = length;
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
 }
 void
 ConsoleOutput::PutInt(int number)
 {
+    HostPhase phase(HostIO);
+
     ASSERT(putBusy == FALSE);
     char temp[10];
     sprintf(temp,"%d\n",number);
-    WriteFile(writeFileNo, (char*)&temp, sizeof(char)*strlen(temp));
+    Write((char*)&temp, sizeof(char)*strlen(temp));
     putBusy = TRUE;
+    putCount = strlen(temp);
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
    
 }
+
+//----------------------------------------------------------------------
+// ConsoleOutput::Write()
+// 	Write "length" characters to the display's file: now, or, if a
+//	host thread writes for us, from a copy it is handed, so that the
+//	caller's buffer is free at once, as it is without one.
+//----------------------------------------------------------------------
+
+void
+ConsoleOutput::Write(char *data, int length)
+{
+    if (io != NULL) {
+	lastRequest = io->Write(writeFileNo, data, length, -1, TRUE);
+    } else {
+	WriteFile(writeFileNo, data, length);
+    }
+}
@@ -30,6 +30,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "hostio.h"
 
 // The following two classes define the input (and output) side of a 
 // hardware console device.  Input (and output) to the device is simulated 
@@ -43,6 +44,20 @@
 // In practice, usually a single hardware thing that does both
 // serial input and serial output.  But conceptually simpler to
 // use two objects.
+//
+// Input arrives in batches: each time the keyboard is polled and has
+// something, everything there is to read (up to ConsoleInputSize
+// characters) comes in with one read, and one interrupt.  The keyboard
+// is only polled when asked to, by Poll, so that an idle keyboard
+// doesn't keep Nachos running.
+//
+// With "-aio", a host thread (see hostio.h) reads input that comes
+// from an ordinary file, a batch ahead, and writes output that goes
+// to a file (-co) rather than to the standard output, where it would
+// have to stay in step with what Nachos prints itself.  Either way
+// each character is in, or out, when its interrupt goes off.
+
+const int ConsoleInputSize = 256;	// most characters one read brings in
 
 class ConsoleInput : public CallBackObj {
   public:
@@ -54,6 +69,14 @@ class ConsoleInput : public CallBackObj {
 				// available, return it.  Otherwise, return EOF.
     				// "callWhenAvail" is called whenever there is 
 				// a char to be gotten
+    int GetString(char *into, int length);
+				// take up to "length" of the characters
+				// that have arrived, and return how many
+    void Poll();		// look for more input, unless already
+				// looking; "callWhenAvail" is called
+				// once some has arrived, or at the end
+    bool AtEnd() { return ended; }
+				// there will be no more input
 
     void CallBack();		// Invoked when a character arrives
 				// from the keyboard.
@@ -62,9 +85,14 @@ class ConsoleInput : public CallBackObj {
     int readFileNo;			// UNIX file emulating the keyboard 
     CallBackObj *callWhenAvail;		// Interrupt handler to call when 
 					// there is a char to be read
-    char incoming;    			// Contains the character to be read,
-					// if there is one available. 
-					// Otherwise contains EOF.
+    char incoming[ConsoleInputSize];	// the characters that have arrived,
+    int first;				// the first not yet taken,
+    int numIncoming;			// and how many are left
+    bool polling;			// is a poll scheduled?
+    bool ended;				// has the input come to an end?
+    HostIOQueue *io;			// what reads ahead for us, or NULL
+    int pending;			// its read of the next batch,
+    char ahead[ConsoleInputSize];	// into here
 };
 
 class ConsoleOutput : public CallBackObj {
@@ -76,15 +104,23 @@ class ConsoleOutput : public CallBackObj {
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "callWhenDone" 
 				// will called when the I/O completes. 
+    void PutString(char *data, int length);
+				// the same, for "length" characters at
+				// once: one write, and one interrupt
     void CallBack();		// Invoked when next character can be put
 				// out to the display.
 
   private:
+    void Write(char *data, int length);	// write to the display's file
+
     int writeFileNo;			// UNIX file emulating the display
     CallBackObj *callWhenDone;		// Interrupt handler to call when 
 					// the next char can be put 
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// the characters it is writing
+    HostIOQueue *io;			// what writes for us, or NULL
+    int lastRequest;			// the write it is doing
 };
 
 #endif // CONSOLE_H
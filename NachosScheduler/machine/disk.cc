@@ -32,7 +32,8 @@ const int DiskSize = (MagicSize + (NumSectors * SectorSize));
 // Disk::Disk()
 // 	Initialize a simulated disk.  Open the UNIX file (creating it
 //	if it doesn't exist), and check the magic number to make sure it's 
-// 	ok to treat it as Nachos disk storage.
+// 	ok to treat it as Nachos disk storage.  With -dm, map it into
+//	memory, if the host can.
 //
 //	"toCall" -- object to call when disk read/write request completes
 //----------------------------------------------------------------------
@@ -61,20 +62,56 @@ Disk::Disk(CallBackObj *toCall)
         Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
+    image = NULL;
+    if (kernel->diskMapped) {
+	image = MapFile(fileno, 0, DiskSize, TRUE);
+	if (image == NULL) {
+	    DEBUG(dbgDisk, "Can't map the disk; reading and writing it.");
+	}
+    }
+    io = NULL;
+    if (kernel->hostIO && image == NULL) {
+	io = new HostIOQueue();
+    }
+    lastRequest = -1;
     active = FALSE;
 }
 
 //----------------------------------------------------------------------
 // Disk::~Disk()
 // 	Clean up disk simulation, by closing the UNIX file representing the
-//	disk.
+//	disk (syncing and unmapping it first, if it is mapped; finishing
+//	what a host thread is writing to it, if one is).
 //----------------------------------------------------------------------
 
 Disk::~Disk()
 {
+    delete io;
+    if (image != NULL) {
+	SyncFile(image, DiskSize);
+	UnmapFile(image, DiskSize);
+    }
     Close(fileno);
 }
 
+//----------------------------------------------------------------------
+// Disk::Sync()
+// 	If the UNIX file is mapped, wait until it has everything written
+//	to the disk so far, as it does once a host thread writing it has
+//	caught up; otherwise it already has.
+//----------------------------------------------------------------------
+
+void
+Disk::Sync()
+{
+    if (io != NULL && lastRequest >= 0) {
+	(void) io->Wait(lastRequest);
+    }
+    if (image != NULL) {
+	SyncFile(image, DiskSize);
+    }
+}
+
 //----------------------------------------------------------------------
 // Disk::PrintSector()
 // 	Dump the data in a disk read/write request, for debugging.
@@ -113,40 +150,104 @@ PrintSector (bool writing, int sector, char *data)
 void
 Disk::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
-
-    ASSERT(!active);				// only one request at a time
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
-    
-    DEBUG(dbgDisk, "Reading from sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
-    if (debug->IsEnabled('d'))
-	PrintSector(FALSE, sectorNumber, data);
-    
-    active = TRUE;
-    UpdateLast(sectorNumber);
-    kernel->stats->numDiskReads++;
-    kernel->interrupt->Schedule(this, ticks, DiskInt);
+    Run(sectorNumber, 1, &data, FALSE);
 }
 
 void
 Disk::WriteRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    Run(sectorNumber, 1, &data, TRUE);
+}
 
-    ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
-    
-    DEBUG(dbgDisk, "Writing to sector " << sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
-    if (debug->IsEnabled('d'))
-	PrintSector(TRUE, sectorNumber, data);
+//----------------------------------------------------------------------
+// Disk::ReadRun/WriteRun
+// 	Simulate a request to read/write the "numSectors" sectors from
+//	"firstSector" on, gathering what is written from, or scattering
+//	what is read to, a buffer for each.
+//
+//	"firstSector" -- the first of the sectors
+//	"numSectors" -- how many of them
+//	"data" -- the buffer for each sector
+//----------------------------------------------------------------------
+
+void
+Disk::ReadRun(int firstSector, int numSectors, char **data)
+{
+    Run(firstSector, numSectors, data, FALSE);
+}
+
+void
+Disk::WriteRun(int firstSector, int numSectors, char **data)
+{
+    Run(firstSector, numSectors, data, TRUE);
+}
+
+//----------------------------------------------------------------------
+// Disk::Run
+// 	Do a request to read/write a run of sectors: each of them is
+//	read/written immediately, and the interrupt is scheduled for when
+//	the last is done.
+//
+//	With a host thread, each is only handed to it, to be done by
+//	then.  Reads are still done at once when the disk is being
+//	debugged, so that what was read can be printed.
+//----------------------------------------------------------------------
+
+void
+Disk::Run(int firstSector, int numSectors, char **data, bool writing)
+{
+    int endSector = firstSector + numSectors - 1;
+    int lastTrackAt;
+    int ticks = RunLatency(firstSector, numSectors, writing, &lastTrackAt);
+    HostPhase phase(HostIO);
+
+    ASSERT(!active);				// only one request at a time
+    ASSERT((firstSector >= 0) && (numSectors > 0)
+	   && (endSector < NumSectors));
+
+    bool offload = io != NULL && (writing || !DEBUG_ON(dbgDisk));
+
+    if (image == NULL && !offload) {
+	Lseek(fileno, SectorSize * firstSector + MagicSize, 0);
+    }
+    for (int i = 0; i < numSectors; i++) {
+	int at = SectorSize * (firstSector + i) + MagicSize;
+
+	if (writing) {
+	    DEBUG(dbgDisk, "Writing to sector " << firstSector + i);
+	    if (offload) {
+		lastRequest = io->Write(fileno, data[i], SectorSize, at,
+					FALSE);
+	    } else if (image != NULL) {
+		bcopy(data[i], image + at, SectorSize);
+	    } else {
+		WriteFile(fileno, data[i], SectorSize);
+	    }
+	} else {
+	    DEBUG(dbgDisk, "Reading from sector " << firstSector + i);
+	    if (offload) {
+		lastRequest = io->Read(fileno, data[i], SectorSize, at);
+	    } else if (image != NULL) {
+		bcopy(image + at, data[i], SectorSize);
+	    } else {
+		Read(fileno, data[i], SectorSize);
+	    }
+	}
+	if (DEBUG_ON(dbgDisk))
+	    PrintSector(writing, firstSector + i, data[i]);
+    }
     
     active = TRUE;
-    UpdateLast(sectorNumber);
-    kernel->stats->numDiskWrites++;
+    UpdateLast(firstSector);
+    if (endSector / SectorsPerTrack != firstSector / SectorsPerTrack) {
+	bufferInit = lastTrackAt;	// the track buffer has the last one's
+    }
+    lastSector = endSector;
+    if (writing) {
+	kernel->stats->numDiskWrites += numSectors;
+    } else {
+	kernel->stats->numDiskReads += numSectors;
+    }
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
@@ -158,6 +259,9 @@ Disk::WriteRequest(int sectorNumber, char* data)
 void
 Disk::CallBack ()
 { 
+    if (io != NULL && lastRequest >= 0) {	// done by now
+	(void) io->Wait(lastRequest);
+    }
     active = FALSE;
     callWhenDone->CallBack();
 }
@@ -249,6 +353,42 @@ Disk::ComputeLatency(int newSector, bool writing)
     return(seek + rotation + RotationTime);
 }
 
+//----------------------------------------------------------------------
+// Disk::RunLatency()
+// 	Return how long it will take to read/write the "numSectors"
+//	sectors from "firstSector" on, in one request: the latency of the
+//	first, then a sector's transfer time for each of the others on
+//	the same track.  Each next track takes a seek of one track, and
+//	the wait for its first sector to come round; "*lastTrackAt" is
+//	set to when the head gets to the last, if it is another track.
+//----------------------------------------------------------------------
+
+int
+Disk::RunLatency(int firstSector, int numSectors, bool writing,
+		 int *lastTrackAt)
+{
+    int ticks = ComputeLatency(firstSector, writing);
+
+    *lastTrackAt = -1;
+    for (int sector = firstSector + 1; sector < firstSector + numSectors;
+	 sector++) {
+	int when, rotation;
+
+	if (sector % SectorsPerTrack != 0) {	// streams past the head
+	    ticks += RotationTime;
+	    continue;
+	}
+	when = kernel->stats->totalTicks + ticks + SeekTime;
+	rotation = (RotationTime - when % RotationTime) % RotationTime;
+	*lastTrackAt = when + rotation;
+	rotation += ModuloDiff(sector, *lastTrackAt / RotationTime)
+		    * RotationTime;
+	ticks += SeekTime + rotation + RotationTime;
+    }
+    DEBUG(dbgDisk, "Run of " << numSectors << " latency = " << ticks);
+    return ticks;
+}
+
 //----------------------------------------------------------------------
 // Disk::UpdateLast
 //   	Keep track of the most recently requested sector.  So we can know
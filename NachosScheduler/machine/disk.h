@@ -20,6 +20,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "hostio.h"
 
 // The following class defines a physical disk I/O device.  The disk
 // has a single surface, split up into "tracks", and each track split
@@ -32,8 +33,19 @@
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
 // and an interrupt is invoked later to signal that the operation completed.
+// A request can be for a run of sectors one after another, each to or
+// from a buffer of its own: it takes one seek, and then each sector
+// streams past the head in turn, with one more seek to each next track.
 //
 // The physical disk is in fact simulated via operations on a UNIX file.
+// With "-dm", the file is mapped into memory instead, so that a request
+// is a copy, not a system call, and the host keeps the file's pages
+// in its own cache from one run to the next; the file is made to have
+// every write when the disk is synced (see SynchDisk::Flush), and when
+// the disk is deleted.  With "-aio" (and not -dm), the file is read and
+// written by a host thread (see hostio.h), while the request is
+// simulated: the sectors have been read, or written, when its
+// interrupt goes off.
 //
 // To make life a little more realistic, the simulated time for
 // each operation reflects a "track buffer" -- RAM to store the contents
@@ -53,6 +65,19 @@ const int NumTracks = 32;		// number of tracks per disk
 const int NumSectors = (SectorsPerTrack * NumTracks);
 					// total # of sectors per disk
 
+// The disk does one request at a time; SynchDisk keeps the others
+// waiting, and picks which of them goes next, "-ds <policy>":
+// the first to come (the default); the one closest to the head; the
+// closest in the direction the head is going, turning at the last one
+// (SCAN, as LOOK); the closest at or past the head, going back to the
+// lowest after the last (C-LOOK); or by C-LOOK unless one has waited
+// DeadlineTicks ticks (deadline).
+
+enum DiskSchedule { DiskFCFS, DiskSSTF, DiskSCAN, DiskCLOOK, DiskDeadline };
+
+const int DeadlineTicks = 50000;	// ticks a request may wait, at most,
+					// with "deadline"
+
 class Disk : public CallBackObj {
   public:
     Disk(CallBackObj *toCall);          // Create a simulated disk.  
@@ -66,24 +91,41 @@ class Disk : public CallBackObj {
     					// the disk and return immediately.
     					// Only one request allowed at a time!
     void WriteRequest(int sectorNumber, char* data);
+    void ReadRun(int firstSector, int numSectors, char **data);
+    void WriteRun(int firstSector, int numSectors, char **data);
+					// Read/write "numSectors" sectors
+					// from "firstSector" on, the i'th
+					// to or from data[i], in one request
 
     void CallBack();			// Invoked when disk request 
 					// finishes. In turn calls, callWhenDone.
+    void Sync();			// Make sure the UNIX file has
+					// what was written, if it is mapped
 
     int ComputeLatency(int newSector, bool writing);	
     					// Return how long a request to 
 					// newSector will take: 
 					// (seek + rotational delay + transfer)
+    int RunLatency(int firstSector, int numSectors, bool writing,
+		   int *lastTrackAt);
+					// And a request for a run of them,
+					// noting when the head gets to the
+					// last track, if it is another
 
   private:
     int fileno;				// UNIX file number for simulated disk 
     char diskname[32];			// name of simulated disk's file
+    char *image;			// the file, mapped, or NULL (-dm)
+    HostIOQueue *io;			// what does our host I/O, or NULL
+    int lastRequest;			// the last host request we made
     CallBackObj *callWhenDone;		// Invoke when any disk request finishes
     bool active;     			// Is a disk operation in progress?
     int lastSector;			// The previous disk request 
     int bufferInit;			// When the track buffer started 
 					// being loaded
 
+    void Run(int firstSector, int numSectors, char **data, bool writing);
+					// do a request
     int TimeToSeek(int newSector, int *rotate); // time to get to the new track
     int ModuloDiff(int to, int from);        // # sectors between to and from
     void UpdateLast(int newSector);
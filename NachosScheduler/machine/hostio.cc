@@ -0,0 +1,241 @@
+// hostio.cc
+//	Routines to do host I/O on a host thread, for the simulated
+//	devices.  See hostio.h.
+//
+//	The ring's two counts are each written by one side and read by
+//	the other, with the host's atomic loads and stores, which also
+//	order the request's fields around them: a request is filled in
+//	before "submitted" counts it, its result before "completed" does.
+//	A side that has nothing to do says so in its flag, looks again,
+//	and only then waits; the other side, having changed a count,
+//	wakes it if the flag was set.  Either the waker sees the flag, or
+//	the waiter sees the new count.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "hostio.h"
+#include "hostprofile.h"
+#include "main.h"
+
+static int numHostRequests;	// requests made, by all the queues,
+static int numHostWaits;	// and how often one wasn't done in time
+
+static inline int
+Load(volatile int *p)
+{
+    return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+}
+
+static inline void
+Store(volatile int *p, int value)
+{
+    __atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+}
+
+static inline int
+Take(volatile int *p)
+{
+    return __atomic_exchange_n(p, 0, __ATOMIC_SEQ_CST);
+}
+
+//----------------------------------------------------------------------
+// HostIOQueue::HostIOQueue
+// 	Start a host thread, with nothing to do yet.
+//----------------------------------------------------------------------
+
+HostIOQueue::HostIOQueue()
+{
+    for (int i = 0; i < HostIOSlots; i++) {
+        ring[i].copied = FALSE;
+    }
+    submitted = completed = 0;
+    threadIdle = simWaiting = 0;
+    work = NewHostSemaphore();
+    done = NewHostSemaphore();
+    kernel->registry->AddCounter("hostio.requests", &numHostRequests);
+    kernel->registry->AddCounter("hostio.waits", &numHostWaits);
+    thread = StartHostThread(ServeQueue, this);
+}
+
+//----------------------------------------------------------------------
+// HostIOQueue::~HostIOQueue
+// 	Have the host thread do what is queued and stop; then let go of
+//	the copies it worked from.
+//----------------------------------------------------------------------
+
+HostIOQueue::~HostIOQueue()
+{
+    Wait(Submit(HostIOStop, -1, NULL, 0, -1, FALSE));
+    JoinHostThread(thread);
+    for (int i = 0; i < HostIOSlots; i++) {
+        if (ring[i].copied) {
+            delete [] ring[i].buffer;
+        }
+    }
+    DeleteHostSemaphore(work);
+    DeleteHostSemaphore(done);
+}
+
+//----------------------------------------------------------------------
+// HostIOQueue::Read, Write, Send
+// 	Queue a request for the host thread, and return its ticket.
+//
+//	"offset" -- where in the file, or -1 to read or write from where
+//		the file is, and move it on
+//----------------------------------------------------------------------
+
+int
+HostIOQueue::Read(int fd, char *buffer, int length, int offset)
+{
+    return Submit(HostIORead, fd, buffer, length, offset, FALSE);
+}
+
+int
+HostIOQueue::Write(int fd, char *buffer, int length, int offset, bool copy)
+{
+    return Submit(HostIOWrite, fd, buffer, length, offset, copy);
+}
+
+int
+HostIOQueue::Send(int sock, char *packet, int length, char *toName)
+{
+    int ticket = submitted;
+
+    ASSERT(strlen(toName) < sizeof(ring[0].to));
+    if (ticket >= HostIOSlots) {		// the slot must be free to
+        (void) Wait(ticket - HostIOSlots);	// name it
+    }
+    strcpy(ring[ticket % HostIOSlots].to, toName);
+    return Submit(HostIOSend, sock, packet, length, -1, TRUE);
+}
+
+//----------------------------------------------------------------------
+// HostIOQueue::Submit
+// 	Fill in the next slot of the ring -- once the request that had it
+//	is done -- count it, and wake the host thread if it's waiting.
+//----------------------------------------------------------------------
+
+int
+HostIOQueue::Submit(HostIOKind kind, int fd, char *buffer, int length,
+		    int offset, bool copy)
+{
+    int ticket = submitted;
+    HostIORequest *request = &ring[ticket % HostIOSlots];
+
+    if (ticket >= HostIOSlots) {
+        (void) Wait(ticket - HostIOSlots);
+    }
+    if (request->copied) {
+        delete [] request->buffer;
+    }
+    request->kind = kind;
+    request->fd = fd;
+    request->length = length;
+    request->offset = offset;
+    request->copied = copy;
+    if (copy) {
+        request->buffer = new char[length];
+        bcopy(buffer, request->buffer, length);
+    } else {
+        request->buffer = buffer;
+    }
+    numHostRequests++;
+    Store(&submitted, ticket + 1);
+    if (Take(&threadIdle)) {
+        HostSemaphoreV(work);
+    }
+    return ticket;
+}
+
+//----------------------------------------------------------------------
+// HostIOQueue::Wait
+// 	Wait until request "ticket" is done, and return how many bytes it
+//	read.  Only the last HostIOSlots requests are still in the ring.
+//----------------------------------------------------------------------
+
+int
+HostIOQueue::Wait(int ticket)
+{
+    HostPhase phase(HostIO);
+
+    ASSERT(ticket < submitted);
+    if (ticket < submitted - HostIOSlots) {
+        return 0;			// long done, and its slot reused
+    }
+    if (Load(&completed) <= ticket) {
+        numHostWaits++;
+        while (Load(&completed) <= ticket) {
+            Store(&simWaiting, 1);
+            if (Load(&completed) <= ticket) {
+                HostSemaphoreP(done);
+            }
+            Store(&simWaiting, 0);
+        }
+    }
+    return ring[ticket % HostIOSlots].result;
+}
+
+//----------------------------------------------------------------------
+// HostIOQueue::Serve
+// 	The host thread: do each request as it comes, until told to
+//	stop.  Only the host's I/O is done here, nothing of Nachos'.
+//----------------------------------------------------------------------
+
+void
+HostIOQueue::Serve()
+{
+    for (int next = 0; ; next++) {
+        HostIORequest *request = &ring[next % HostIOSlots];
+
+        while (Load(&submitted) == next) {	// nothing to do
+            Store(&threadIdle, 1);
+            if (Load(&submitted) == next) {
+                HostSemaphoreP(work);
+            }
+            Store(&threadIdle, 0);
+        }
+        request->result = 0;
+        switch (request->kind) {
+          case HostIORead:
+            if (request->offset < 0) {
+                request->result = ReadPartial(request->fd, request->buffer,
+                                              request->length);
+            } else {
+                request->result = ReadPartialAt(request->fd, request->buffer,
+                                                request->length,
+                                                request->offset);
+            }
+            break;
+          case HostIOWrite:
+            if (request->offset < 0) {
+                WriteFile(request->fd, request->buffer, request->length);
+            } else {
+                WriteFileAt(request->fd, request->buffer, request->length,
+                            request->offset);
+            }
+            break;
+          case HostIOSend:
+            SendToSocket(request->fd, request->buffer, request->length,
+                         request->to);
+            break;
+          case HostIOStop:
+            break;
+        }
+        Store(&completed, next + 1);
+        if (Take(&simWaiting)) {
+            HostSemaphoreV(done);
+        }
+        if (request->kind == HostIOStop) {
+            return;
+        }
+    }
+}
+
+void
+HostIOQueue::ServeQueue(void *queue)
+{
+    ((HostIOQueue *) queue)->Serve();
+}
@@ -0,0 +1,90 @@
+// hostio.h
+//	Data structures to do the simulated devices' host I/O on host
+//	threads of their own, for "-aio", so that the simulation doesn't
+//	stop while the host reads or writes the disk's UNIX file, the
+//	console's files, or a socket.
+//
+//	Each device that can has a HostIOQueue, and the queue a host
+//	thread that does its requests, one after another, in the order
+//	they were made.  The simulation puts a request in the queue's
+//	ring and goes on; the thread takes it out, does it, and says it
+//	is done.  Neither takes a lock to do that: the simulation is the
+//	only one to add requests, the thread the only one to finish
+//	them, and each only waits on a semaphore when there is nothing
+//	to do -- the thread when the ring is empty, the simulation when
+//	it needs a request done that isn't yet.
+//
+//	What is simulated doesn't change.  A device makes its requests
+//	when it always did, and waits for them when its interrupt goes
+//	off, at the same tick as without -aio; only then is what a read
+//	brought in looked at, or a buffer that was written handed back.
+//	The host does the work in the time between.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HOSTIO_H
+#define HOSTIO_H
+
+#include "copyright.h"
+
+enum HostIOKind { HostIORead, HostIOWrite, HostIOSend, HostIOStop };
+
+// One request, in a queue's ring.
+
+class HostIORequest {
+  public:
+    HostIOKind kind;
+    int fd;			// the file, or socket, to use
+    char *buffer;		// what to write, or where to read to
+    int length;			// how many bytes
+    int offset;			// where in the file, or -1 for where
+				// the file is
+    char to[32];		// a send's socket name
+    bool copied;		// the buffer is a copy, to be deleted
+    int result;			// once done, how many bytes were read
+};
+
+const int HostIOSlots = 64;	// requests a queue can hold
+
+// The following class defines a queue of host I/O requests, and the
+// host thread that does them.
+
+class HostIOQueue {
+  public:
+    HostIOQueue();		// start the host thread
+    ~HostIOQueue();		// do what is queued, and stop it
+
+    int Read(int fd, char *buffer, int length, int offset);
+				// read up to "length" bytes
+    int Write(int fd, char *buffer, int length, int offset, bool copy);
+				// write them; with "copy", from a copy,
+				// so the buffer can be used again now
+    int Send(int sock, char *packet, int length, char *toName);
+				// send a copy of a packet to a socket
+				// Each returns the request's ticket
+
+    int Wait(int ticket);	// wait until the request is done, and
+				// return the bytes it read (0, if it
+				// was done so long ago its slot is
+				// taken)
+
+  private:
+    HostIORequest ring[HostIOSlots];	// request "ticket" is in
+					// ring[ticket % HostIOSlots]
+    volatile int submitted;	// requests made, by the simulation
+    volatile int completed;	// and done, by the host thread
+    volatile int threadIdle;	// the host thread is waiting for work
+    volatile int simWaiting;	// the simulation is waiting on us
+    void *work;			// semaphores for those to wait on
+    void *done;
+    void *thread;
+
+    int Submit(HostIOKind kind, int fd, char *buffer, int length,
+	       int offset, bool copy);
+    void Serve();		// the host thread: do requests
+    static void ServeQueue(void *queue);
+};
+
+#endif // HOSTIO_H
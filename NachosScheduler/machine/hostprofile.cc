@@ -0,0 +1,99 @@
+// hostprofile.cc
+//	Routines to sample where the host's time goes.  See
+//	hostprofile.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "hostprofile.h"
+#include "main.h"
+
+volatile HostActivity hostActivity = HostKernel;
+
+// The samples, by activity; only the signal handler changes them.
+
+static volatile int hostSamples[NumHostActivities];
+
+static char *hostActivityNames[] = { "kernel", "interpret", "translate",
+    "interrupts", "switch", "I/O" };
+
+//----------------------------------------------------------------------
+// HostProfile::HostProfile
+// 	Start sampling hostActivity, and timing the run.
+//----------------------------------------------------------------------
+
+HostProfile::HostProfile()
+{
+    for (int i = 0; i < NumHostActivities; i++) {
+        hostSamples[i] = 0;
+    }
+    sampling = CallOnProfileTick(HostSampleMicros, Sample);
+    startTime = HostTime();
+    startCPUTime = HostCPUTime();
+}
+
+//----------------------------------------------------------------------
+// HostProfile::~HostProfile
+// 	Stop sampling.
+//----------------------------------------------------------------------
+
+HostProfile::~HostProfile()
+{
+    if (sampling) {
+        (void) CallOnProfileTick(0, NULL);
+    }
+}
+
+//----------------------------------------------------------------------
+// HostProfile::Sample
+// 	The profiling signal went off: count what the host was doing.
+//----------------------------------------------------------------------
+
+void
+HostProfile::Sample(int sig)
+{
+    hostSamples[hostActivity]++;
+}
+
+//----------------------------------------------------------------------
+// HostProfile::Print
+// 	Print how many instructions and ticks were simulated per second
+//	on the host, and how the host's CPU time was split up: each
+//	activity is given the share of it that it had of the samples.
+//----------------------------------------------------------------------
+
+void
+HostProfile::Print()
+{
+    Statistics *stats = kernel->stats;
+    double seconds = HostTime() - startTime;
+    double cpuSeconds = HostCPUTime() - startCPUTime;
+    int total = 0;
+
+    if (seconds <= 0) {
+        seconds = 1.0e-6;		// less than the clock can tell
+    }
+    cout << "Benchmark: " << stats->userTicks / UserTick << " instructions, "
+	 << stats->totalTicks << " ticks in " << seconds
+	 << " s on the host\n";
+    cout << "    " << stats->userTicks / UserTick / seconds / 1.0e6
+	 << " million instructions, " << stats->totalTicks / seconds / 1.0e6
+	 << " million ticks per second\n";
+    if (!sampling) {
+        cout << "    (the host can't sample where its time goes)\n";
+        return;
+    }
+    for (int i = 0; i < NumHostActivities; i++) {
+        total += hostSamples[i];
+    }
+    cout << "    host CPU time " << cpuSeconds << " s, split by "
+	 << total << " samples:\n";
+    for (int i = 0; i < NumHostActivities; i++) {
+        double share = (total == 0) ? 0.0 : (double) hostSamples[i] / total;
+
+        cout << "        " << hostActivityNames[i] << " "
+	     << cpuSeconds * share << " s (" << 100 * share << "%)\n";
+    }
+}
@@ -0,0 +1,72 @@
+// hostprofile.h
+//	Data structures to find out where the host's time goes, for
+//	"-bench": how fast the simulator runs, and which parts of it are
+//	the slow ones.
+//
+//	The parts of the simulator say which of them is running by
+//	setting hostActivity (with a HostPhase, which sets it back when
+//	the part returns): interpreting instructions, translating
+//	addresses, checking for and taking interrupts, switching
+//	threads, or emulating the console, the disk and the network.
+//	The rest of the time is the Nachos kernel's.  That costs a store
+//	or two, so it is done whether or not Nachos is being benchmarked.
+//
+//	A HostProfile samples hostActivity from a signal, after every
+//	HostSampleMicros of CPU time on the host (or as often as the host
+//	can manage), and so finds out roughly how that time is split up
+//	-- without reading the clock at every step, which would take
+//	longer than most of the steps.  At halt it prints the split, and
+//	how many instructions and ticks were simulated per second of
+//	host (wall clock) time.  The more samples, the better the split;
+//	a run of a second or more gives hundreds.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HOSTPROFILE_H
+#define HOSTPROFILE_H
+
+#include "copyright.h"
+
+// The parts of the simulator host time is charged to.
+
+enum HostActivity { HostKernel, HostInterpret, HostTranslate,
+    HostInterrupt, HostSwitch, HostIO, NumHostActivities };
+
+extern volatile HostActivity hostActivity;	// what the host is doing
+
+// For the length of a routine (or any block), charge the host's time
+// to "activity"; then back to whatever it was charged to before.
+
+class HostPhase {
+  public:
+    HostPhase(HostActivity activity)
+	{ saved = hostActivity; hostActivity = activity; }
+    ~HostPhase() { hostActivity = saved; }
+
+  private:
+    HostActivity saved;
+};
+
+const int HostSampleMicros = 1000;	// CPU time between samples
+
+// The following class samples hostActivity, for "-bench".
+
+class HostProfile {
+  public:
+    HostProfile();		// start sampling
+    ~HostProfile();		// stop
+
+    void Print();		// print the simulator's speed, and
+				// where its time went
+
+  private:
+    double startTime;		// HostTime when sampling started,
+    double startCPUTime;	// and HostCPUTime
+    bool sampling;		// could the host sample at all?
+
+    static void Sample(int sig);	// the signal handler
+};
+
+#endif // HOSTPROFILE_H
@@ -23,13 +23,19 @@
 #include "copyright.h"
 #include "interrupt.h"
 #include "main.h"
+#include "synchprofile.h"
+#include "replay.h"
+#include "transport.h"
+#include "network.h"
 
 // String definitions for debugging messages
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
 			"console read", "network send", 
-			"network recv"};
+			"network recv", "job arrival", "buffer flush",
+			"journal commit", "alarm", "transport timeout",
+			"network deliver", "stats sample"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -39,27 +45,165 @@ static char *intTypeNames[] = { "timer", "disk", "console write",
 //	"callOnInt" is the object to call when the interrupt occurs
 //	"time" is when (in simulated time) the interrupt is to occur
 //	"kind" is the hardware device that generated the interrupt
+//	"target" is the CPU to deliver it to
 //----------------------------------------------------------------------
 
 PendingInterrupt::PendingInterrupt(CallBackObj *callOnInt, 
-					int time, IntType kind)
+					int time, IntType kind, int target)
 {
     callOnInterrupt = callOnInt;
     when = time;
     type = kind;
+    cpu = target;
 }
 
 //----------------------------------------------------------------------
-// PendingCompare
-//	Compare to interrupts based on which should occur first.
+// PendingInterrupt::operator new, PendingInterrupt::operator delete
+// 	PendingInterrupts are carved out of slabs of InterruptsPerSlab,
+//	and one that has gone off is reused by the next to be scheduled.
 //----------------------------------------------------------------------
 
-static int
-PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
+ObjectPool *PendingInterrupt::pool = NULL;
+
+void *
+PendingInterrupt::operator new(size_t size)
 {
-    if (x->when < y->when) { return -1; }
-    else if (x->when > y->when) { return 1; }
-    else { return 0; }
+    ASSERT(size == sizeof(PendingInterrupt));
+    if (pool == NULL) {
+        pool = new ObjectPool(sizeof(PendingInterrupt), InterruptsPerSlab);
+    }
+    return pool->Alloc();
+}
+
+void
+PendingInterrupt::operator delete(void *pending)
+{
+    pool->Free(pending);
+}
+
+//----------------------------------------------------------------------
+// Earlier
+//	Return whether interrupt "x" should occur before "y": it is due
+//	sooner, or at the same time but was scheduled first.
+//----------------------------------------------------------------------
+
+static bool
+Earlier(PendingInterrupt *x, PendingInterrupt *y)
+{
+    if (x->when != y->when) {
+        return x->when < y->when;
+    }
+    return x->order - y->order < 0;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::PendingQueue
+// 	Initialize an empty queue of pending interrupts.
+//----------------------------------------------------------------------
+
+const int InitialPending = 16;		// heap slots to start with
+
+PendingQueue::PendingQueue()
+{
+    heap = new PendingInterrupt *[InitialPending];
+    size = InitialPending;
+    numPending = 0;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::~PendingQueue
+// 	Delete the interrupts that never went off.
+//----------------------------------------------------------------------
+
+PendingQueue::~PendingQueue()
+{
+    for (int i = 0; i < numPending; i++) {
+        delete heap[i];
+    }
+    delete [] heap;
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Insert
+// 	Add an interrupt to the heap, doubling it first if it is full.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Insert(PendingInterrupt *toOccur)
+{
+    if (numPending == size) {
+        PendingInterrupt **bigger = new PendingInterrupt *[2 * size];
+
+        memcpy(bigger, heap, numPending * sizeof(PendingInterrupt *));
+        delete [] heap;
+        heap = bigger;
+        size *= 2;
+    }
+    Put(toOccur, numPending++);
+    SiftUp(numPending - 1);
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::Remove
+// 	Take an interrupt out of the heap, wherever it is: the last one
+//	takes its place, and is moved up or down to where it belongs.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::Remove(PendingInterrupt *toRemove)
+{
+    int i = toRemove->index;
+
+    ASSERT(i >= 0 && i < numPending && heap[i] == toRemove);
+    toRemove->index = -1;
+    numPending--;
+    if (i < numPending) {
+        Put(heap[numPending], i);
+        SiftUp(i);
+        SiftDown(heap[i]->index);
+    }
+}
+
+//----------------------------------------------------------------------
+// PendingQueue::SiftUp, PendingQueue::SiftDown
+// 	Restore the heap order after heap[i] has changed, by swapping it
+//	with its parent while it is earlier, or with its earlier child
+//	while that is earlier than it.
+//----------------------------------------------------------------------
+
+void
+PendingQueue::SiftUp(int i)
+{
+    PendingInterrupt *p = heap[i];
+
+    while (i > 0 && Earlier(p, heap[(i - 1) / 2])) {
+        Put(heap[(i - 1) / 2], i);
+        i = (i - 1) / 2;
+    }
+    Put(p, i);
+}
+
+void
+PendingQueue::SiftDown(int i)
+{
+    PendingInterrupt *p = heap[i];
+
+    for (;;) {
+        int child = 2 * i + 1;
+
+        if (child >= numPending) {
+            break;
+        }
+        if (child + 1 < numPending && Earlier(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!Earlier(heap[child], p)) {
+            break;
+        }
+        Put(heap[child], i);
+        i = child;
+    }
+    Put(p, i);
 }
 
 //----------------------------------------------------------------------
@@ -72,10 +216,13 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    numCPUs = kernel->numCPUs;
+    pending = new PendingQueue[numCPUs];
+    numScheduled = 0;
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
+    network = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -85,10 +232,7 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty()) {
-	delete pending->RemoveFront();
-    }
-    delete pending;
+    delete [] pending;		// and whatever is still pending
 }
 
 //----------------------------------------------------------------------
@@ -149,18 +293,17 @@ Interrupt::OneTick()
 {
     MachineStatus oldStatus = status;
     Statistics *stats = kernel->stats;
+    HostPhase phase(HostInterrupt);
 
 // advance simulated time
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
 	stats->systemTicks += SystemTick;
+	kernel->currentCPU->busyTicks += SystemTick;
     } else {
 	stats->totalTicks += UserTick;
 	stats->userTicks += UserTick;
-    }
-    while (kernel->initTime[kernel->listCounter] < stats->totalTicks && kernel->listCounter < kernel->totalList) {
-        kernel->listCounter++;
-        kernel->Exec(kernel->jobName[kernel->listCounter-1]);
+	kernel->currentCPU->busyTicks += UserTick;
     }
     DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
@@ -172,11 +315,76 @@ Interrupt::OneTick()
     ChangeLevel(IntOff, IntOn);	// re-enable interrupts
     if (yieldOnReturn) {	// if the timer device handler asked 
     				// for a context switch, ok to do it now
+	HostPhase yieldPhase(HostKernel);
+
 	yieldOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
 	kernel->currentThread->Yield();
 	status = oldStatus;
     }
+    if (kernel->numCPUs > 1) {	// let the CPU that is furthest behind
+    				// catch up
+	HostPhase balancePhase(HostKernel);
+
+	ChangeLevel(IntOn, IntOff);
+	kernel->scheduler->Balance();
+	ChangeLevel(IntOff, IntOn);
+    }
+}
+
+//----------------------------------------------------------------------
+// Interrupt::QuietUntil
+// 	Return the tick at which OneTick, called for a user instruction,
+//	would next have more to do than advance the clock: the tick the
+//	next interrupt the current CPU could take is due.  Machine::Run
+//	counts the ticks of instructions before then itself, rather than
+//	calling OneTick for each.
+//
+//	It is only worth knowing in user mode on one CPU, with nobody
+//	waiting to yield and nobody watching every tick (dbgInt); in any
+//	other case, return the current tick, so that OneTick is called
+//	every time.
+//
+//	Nothing but OneTick and the kernel (entered through an exception)
+//	can change the answer -- except a packet arriving on the network,
+//	which is then noticed at the next interrupt, rather than the
+//	next tick.
+//----------------------------------------------------------------------
+
+int
+Interrupt::QuietUntil()
+{
+    PendingInterrupt *next;
+
+    if (numCPUs > 1 || status != UserMode || yieldOnReturn
+          || DEBUG_ON(dbgInt)
+          || (network != NULL && network->Signalled())) {
+	return kernel->stats->totalTicks;
+    }
+    if (kernel->replay->IsReplaying()) {	// as the log says
+	ReplayRecord *logged = kernel->replay->NextInterrupt();
+
+	return (logged == NULL) ? kernel->stats->totalTicks : logged->tick;
+    }
+    next = pending[0].Front();
+    return (next == NULL) ? INT_MAX : next->when;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NumPending
+// 	Return how many interrupts are scheduled and yet to go off, for
+//	every CPU.
+//----------------------------------------------------------------------
+
+int
+Interrupt::NumPending()
+{
+    int count = 0;
+
+    for (int i = 0; i < numCPUs; i++) {
+	count += pending[i].NumPending();
+    }
+    return count;
 }
 
 //----------------------------------------------------------------------
@@ -197,6 +405,21 @@ Interrupt::YieldOnReturn()
     yieldOnReturn = TRUE; 
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Preempt
+// 	Like YieldOnReturn, but also usable outside of an interrupt
+//	handler, for instance when a thread wakes up a more urgent one.
+//	The current thread yields at the next OneTick, which is when
+//	interrupts are re-enabled, or at once when the handler returns.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Preempt()
+{
+    ASSERT(level == IntOff);
+    yieldOnReturn = TRUE;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Idle
 // 	Routine called when there is nothing in the ready queue.
@@ -207,12 +430,21 @@ Interrupt::YieldOnReturn()
 //
 //	If there are no pending interrupts, stop.  There's nothing
 //	more for us to do.
+//
+//	With the network up, a packet could arrive from another machine
+//	at any time; rather than jump ahead, we wait for one in host
+//	time first (see WaitForNetwork).
 //----------------------------------------------------------------------
 void
 Interrupt::Idle()
 {
+    HostPhase phase(HostInterrupt);
+
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
+    if (network != NULL && !kernel->replay->IsReplaying()) {
+	WaitForNetwork();
+    }
     if (CheckIfDue(TRUE)) {	// check for any pending interrupts
 	status = SystemMode;
 	return;			// return in case there's now
@@ -230,6 +462,45 @@ Interrupt::Idle()
     Halt();
 }
 
+//----------------------------------------------------------------------
+// Interrupt::WaitForNetwork
+// 	The machine is idle: wait in host time, IdleTickMicros a tick,
+//	until either the next interrupt is due or a packet arrives --
+//	for ever, if nothing else is pending.  If one does, advance the
+//	clock by the ticks that went by, and have the network look at
+//	it; otherwise CheckIfDue goes on to the interrupt.
+//
+//	This is what keeps separate machines' clocks roughly in step,
+//	so that a packet sent at one's tick t arrives at around the
+//	other's t, however many machines there are; a machine that has
+//	work to do runs as fast as it can, as before.
+//----------------------------------------------------------------------
+
+void
+Interrupt::WaitForNetwork()
+{
+    PendingInterrupt *next = NextDeliverable();
+    Statistics *stats = kernel->stats;
+    int gap = (next == NULL) ? -1 : (next->when - stats->totalTicks);
+    double start;
+    int ticks;
+
+    if (gap == 0 || network->Signalled()) {
+	return;				// something to do already
+    }
+    start = HostTime();
+    if (!network->WaitForPacket(gap)) {
+	return;
+    }
+    ticks = (int) ((HostTime() - start) * 1000000 / IdleTickMicros);
+    if (gap > 0 && ticks > gap) {
+	ticks = gap;
+    }
+    stats->idleTicks += ticks;
+    stats->totalTicks += ticks;
+    network->Notice();
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Halt
 // 	Shut down Nachos cleanly, printing out performance statistics.
@@ -239,6 +510,25 @@ Interrupt::Halt()
 {
     cout << "Machine halting!\n\n";
     kernel->stats->Print();
+    PrintSyscalls();
+    if (kernel->numCPUs > 1) {
+	for (int i = 0; i < kernel->numCPUs; i++) {
+	    kernel->cpus[i]->Print();
+	}
+    }
+    if (kernel->synchProfiler != NULL) {
+	kernel->synchProfiler->Print();
+    }
+    if (kernel->pager != NULL) {
+	kernel->pager->Print();
+    }
+    if (kernel->transport != NULL) {
+	kernel->transport->Print();
+    }
+    if (kernel->hostProfile != NULL) {
+	kernel->hostProfile->Print();
+    }
+    debug->Print();
     delete kernel;	// Never returns.
 }
 
@@ -259,7 +549,9 @@ Interrupt::Nice(int priority)
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: put it on the heap of interrupts pending for
+//	the CPU that scheduled it.  That's where it is delivered, so for
+//	instance each CPU's timer keeps interrupting that CPU.
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
@@ -268,16 +560,63 @@ Interrupt::Nice(int priority)
 //	"fromNow" is how far in the future (in simulated time) the 
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
+//
+// Returns:
+//	The interrupt, to Cancel if need be before it goes off.
 //----------------------------------------------------------------------
-void
+PendingInterrupt *
 Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
 {
     int when = kernel->stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type);
+    int cpu = (kernel->currentCPU == NULL) ? 0 : kernel->currentCPU->getID();
+    PendingInterrupt *toOccur = new PendingInterrupt(toCall, when, type, cpu);
 
     DEBUG(dbgInt, "Scheduling interrupt handler the " << intTypeNames[type] << " at time = " << when);
     ASSERT(fromNow > 0);
-    pending->Insert(toOccur);
+    toOccur->order = numScheduled++;
+    pending[cpu].Insert(toOccur);
+    return toOccur;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Forget an interrupt that hasn't gone off yet, as when a device
+//	that is being reprogrammed drops what it had scheduled.
+//
+//	NOTE: like Schedule, this is for the hardware device simulators.
+//
+//	"toCancel" is what Schedule returned.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Cancel(PendingInterrupt *toCancel)
+{
+    pending[toCancel->cpu].Remove(toCancel);
+    delete toCancel;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Forget any pending interrupts that would call "toCall".  This
+//	has to look at every pending interrupt; a device that can keep
+//	what Schedule returned should cancel that instead.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Cancel(CallBackObj *toCall)
+{
+    for (int c = 0; c < numCPUs; c++) {
+        for (int i = 0; i < pending[c].NumPending(); ) {
+            PendingInterrupt *p = pending[c].Item(i);
+
+            if (p->callOnInterrupt == toCall) {
+                Cancel(p);
+                i = 0;			// the heap has been rearranged
+            } else {
+                i++;
+            }
+        }
+    }
 }
 
 //----------------------------------------------------------------------
@@ -285,6 +624,10 @@ Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
 // 	Check if any interrupts are scheduled to occur, and if so, 
 //	fire them off.
 //
+//	On a multiprocessor, an interrupt meant for another CPU waits
+//	until that CPU is being simulated -- unless the CPU is idle, in
+//	which case there's no one to wait for, and it is delivered now.
+//
 // Returns:
 //	TRUE, if we fired off any interrupt handlers
 // Params:
@@ -300,13 +643,23 @@ Interrupt::CheckIfDue(bool advanceClock)
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
 					// to invoke an interrupt handler
-    if (debug->IsEnabled(dbgInt)) {
+    if (DEBUG_ON(dbgInt)) {
 	DumpState();
     }
-    if (pending->IsEmpty()) {   	// no pending interrupts
+    if (network != NULL && network->Signalled()) {
+	network->Notice();		// a packet has come in
+    }
+    if (kernel->replay->IsReplaying()) {
+	bool fired = ReplayIfDue(advanceClock);
+
+	if (fired || kernel->replay->IsReplaying()) {
+	    return fired;
+	}
+    }
+    next = NextDeliverable();
+    if (next == NULL) {   		// no pending interrupts
 	return FALSE;	
     }		
-    next = pending->Front();
     
     if (next->when > stats->totalTicks) {
         if (!advanceClock) {		// not time yet
@@ -328,15 +681,143 @@ Interrupt::CheckIfDue(bool advanceClock)
 
     inHandler = TRUE;
     do {
-        next = pending->RemoveFront();    // pull interrupt off list
-        next->callOnInterrupt->CallBack();// call the interrupt handler
+        pending[next->cpu].Remove(next);	// pull interrupt off list
+        Deliver(next);			// call the interrupt handler
 	delete next;
-    } while (!pending->IsEmpty() 
-    		&& (pending->Front()->when <= stats->totalTicks));
+	next = NextDeliverable();
+    } while (next != NULL && (next->when <= stats->totalTicks));
     inHandler = FALSE;
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Interrupt::ReplayIfDue
+// 	CheckIfDue, when replaying a log (see replay.h): fire off the
+//	interrupts the log says went off by now, whenever they were
+//	scheduled for.  As usual, an interrupt for another CPU waits
+//	until that CPU is being simulated, or is idle.  If one of them
+//	isn't pending, or it should have gone off already, the run has
+//	strayed from the log; we stop replaying, and CheckIfDue carries
+//	on as usual.
+//
+// Returns:
+//	TRUE, if we fired off any interrupt handlers
+// Params:
+//	"advanceClock" -- as for CheckIfDue: if TRUE, advance the clock
+//		to the next interrupt in the log.
+//----------------------------------------------------------------------
+
+bool
+Interrupt::ReplayIfDue(bool advanceClock)
+{
+    Statistics *stats = kernel->stats;
+    ReplayLog *replay = kernel->replay;
+    ReplayRecord *logged;
+    bool fired = FALSE;
+
+    while ((logged = replay->NextInterrupt()) != NULL) {
+	PendingInterrupt *next = NULL;
+
+	if (numCPUs > 1 && logged->cpu != kernel->currentCPU->getID()
+	      && !kernel->cpus[logged->cpu]->IsIdle()) {
+	    return fired;		// wait until that CPU is simulated
+	}
+	if (logged->tick > stats->totalTicks) {
+	    if (fired || !advanceClock) {	// not time yet
+		return fired;
+	    }
+	    stats->idleTicks += (logged->tick - stats->totalTicks);
+	    stats->totalTicks = logged->tick;
+	} else if (logged->tick < stats->totalTicks) {
+	    replay->Diverged("an interrupt in the log went by");
+	    return fired;
+	}
+	for (int i = 0; i < pending[logged->cpu].NumPending(); i++) {
+	    PendingInterrupt *p = pending[logged->cpu].Item(i);
+
+	    if (p->type == logged->value && (next == NULL || Earlier(p, next))) {
+		next = p;
+	    }
+	}
+	if (next == NULL) {
+	    replay->Diverged("the interrupt next in the log isn't pending");
+	    return fired;
+	}
+
+	DEBUG(dbgInt, "Replaying interrupt handler for the ");
+	DEBUG(dbgInt, intTypeNames[next->type] << " at time " << stats->totalTicks);
+	if (!fired && kernel->machine != NULL) {
+	    kernel->machine->DelayedLoad(0, 0);
+	}
+	inHandler = TRUE;
+	pending[next->cpu].Remove(next);
+	Deliver(next);			// which moves on in the log
+	delete next;
+	inHandler = FALSE;
+	fired = TRUE;
+    }
+
+    // the log has no more interrupts, so one going off now is new
+    PendingInterrupt *next = NextDeliverable();
+    if (next != NULL && (advanceClock || next->when <= stats->totalTicks)) {
+	replay->Diverged("the log has no more interrupts");
+    }
+    return fired;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NextDeliverable
+// 	Return the earliest pending interrupt that may be delivered
+//	right now: one for the current CPU, or for an idle CPU.  Return
+//	NULL if there isn't one.  Each CPU's earliest is at the front of
+//	its queue, so we need only compare those.
+//----------------------------------------------------------------------
+
+PendingInterrupt *
+Interrupt::NextDeliverable()
+{
+    PendingInterrupt *next = NULL;
+
+    if (numCPUs == 1) {
+	return pending[0].Front();
+    }
+    for (int c = 0; c < numCPUs; c++) {
+	PendingInterrupt *p = pending[c].Front();
+
+	if (p != NULL && (c == kernel->currentCPU->getID()
+			  || kernel->cpus[c]->IsIdle())
+	      && (next == NULL || Earlier(p, next))) {
+	    next = p;
+	}
+    }
+    return next;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Deliver
+// 	Call the handler for "toCall".  If it was meant for another
+//	(idle) CPU, make that the current CPU while the handler runs,
+//	so that, for instance, its timer sees it is idle.
+//----------------------------------------------------------------------
+
+void
+Interrupt::Deliver(PendingInterrupt *toCall)
+{
+    CPU *cpu = kernel->currentCPU;
+    MachineStatus oldStatus = status;
+
+    kernel->replay->Fired(toCall);
+    if (cpu == NULL || toCall->cpu == cpu->getID()) {
+	toCall->callOnInterrupt->CallBack();
+	return;
+    }
+    kernel->currentCPU = kernel->cpus[toCall->cpu];
+    status = IdleMode;
+    toCall->callOnInterrupt->CallBack();
+    status = oldStatus;
+    kernel->currentCPU = cpu;
+}
+
 //----------------------------------------------------------------------
 // PrintPending
 // 	Print information about an interrupt that is scheduled to occur.
@@ -348,6 +829,9 @@ PrintPending (PendingInterrupt *pending)
 {
     cout << "Interrupt handler "<< intTypeNames[pending->type];
     cout << ", scheduled at " << pending->when;
+    if (kernel->numCPUs > 1) {
+	cout << " on CPU " << pending->cpu;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -361,7 +845,12 @@ Interrupt::DumpState()
 {
     cout << "Time: " << kernel->stats->totalTicks;
     cout << ", interrupts " << intLevelNames[level] << "\n";
-    cout << "Pending interrupts:\n";
-    pending->Apply(PrintPending);
-    cout << "\nEnd of pending interrupts\n";
+    cout << "Pending interrupts (in no particular order):\n";
+    for (int c = 0; c < numCPUs; c++) {
+        for (int i = 0; i < pending[c].NumPending(); i++) {
+            PrintPending(pending[c].Item(i));
+            cout << "\n";
+        }
+    }
+    cout << "End of pending interrupts\n";
 }
@@ -37,6 +37,8 @@
 #include "list.h"
 #include "callback.h"
 
+class NetworkInput;
+
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
 
@@ -49,15 +51,26 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 // In Nachos, we support a hardware timer device, a disk, a console
 // display and keyboard, and a network.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-    NetworkSendInt, NetworkRecvInt};
+    NetworkSendInt, NetworkRecvInt, JobArrivalInt, BufferFlushInt,
+    JournalCommitInt, AlarmInt, TransportInt, NetworkDeliverInt,
+    StatsSampleInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
+//
+// A timer interrupt is scheduled on every time slice, so these are
+// recycled through a pool rather than allocated each time.
+//
+// Schedule returns the PendingInterrupt, which can be passed to Cancel
+// until the interrupt goes off; then it is deleted.
+
+const int InterruptsPerSlab = 64;	// PendingInterrupts allocated at once
 
 class PendingInterrupt {
     public:
-        PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind);
+        PendingInterrupt(CallBackObj *callOnInt, int time, IntType kind,
+                int target);
         // initialize an interrupt that will
         // occur in the future
 
@@ -66,6 +79,48 @@ class PendingInterrupt {
 
         int when;			// When the interrupt is supposed to fire
         IntType type;		// for debugging
+        int cpu;			// which CPU it is delivered to
+        int order;			// when it was scheduled, to keep
+        // interrupts due at the same time in order
+        int index;			// where it is in its PendingQueue
+
+        static void *operator new(size_t size);	// from the pool
+        static void operator delete(void *pending);	// back to it
+
+    private:
+        static ObjectPool *pool;	// freed PendingInterrupts
+};
+
+// The following class defines the interrupts pending for one CPU: a
+// binary heap, earliest first, so that scheduling or cancelling an
+// interrupt is O(log n) however many are pending, and finding the
+// next one to go off is O(1).
+
+class PendingQueue {
+    public:
+        PendingQueue();
+        ~PendingQueue();		// delete anything still pending
+
+        bool IsEmpty() { return numPending == 0; }
+        int NumPending() { return numPending; }
+        PendingInterrupt *Front()	// the earliest, or NULL
+        { return (numPending == 0) ? NULL : heap[0]; }
+        PendingInterrupt *Item(int i) { return heap[i]; }
+        // the "i"th, in no particular order
+
+        void Insert(PendingInterrupt *toOccur);
+        void Remove(PendingInterrupt *toRemove);
+
+    private:
+        PendingInterrupt **heap;	// heap[i] is due no later than
+        // heap[2i+1] and heap[2i+2]
+        int numPending;
+        int size;			// room in heap, doubled as needed
+
+        void Put(PendingInterrupt *p, int i)	// put "p" at heap[i]
+        { heap[i] = p; p->index = i; }
+        void SiftUp(int i);		// move heap[i] up to its place
+        void SiftDown(int i);	// ... or down
 };
 
 // The following class defines the data structures for the simulation
@@ -99,6 +154,8 @@ class Interrupt {
 
         void YieldOnReturn();	// cause a context switch on return 
         // from an interrupt handler
+        void Preempt();		// same, but may be called anywhere
+        // with interrupts off; the switch happens when they go back on
 
         MachineStatus getStatus() { return status; } 
         void setStatus(MachineStatus st) { status = st; }
@@ -112,22 +169,37 @@ class Interrupt {
         // but they need to be public since they are called by the
         // hardware device simulators.
 
-        void Schedule(CallBackObj *callTo, int when, IntType type);
+        PendingInterrupt *Schedule(CallBackObj *callTo, int when,
+                IntType type);
         // Schedule an interrupt to occur
         // at time "when".  This is called
         // by the hardware device simulators.
+        void Cancel(PendingInterrupt *toCancel);
+        // Take an interrupt that hasn't gone
+        // off yet off the pending list
+        void Cancel(CallBackObj *callTo);
+        // Take any interrupts scheduled for
+        // "callTo" off the pending list
 
         void OneTick();       	// Advance simulated time
+        int QuietUntil();		// Until what tick OneTick will do
+        // nothing but advance simulated time
+        int NumPending();		// interrupts pending, on all CPUs
+        void WatchNetwork(NetworkInput *net) { network = net; }
+        // Look for the host's signal that packets
+        // have arrived, and wait for them in Idle
 
     private:
         IntStatus level;		// are interrupts enabled or disabled?
-        SortedList<PendingInterrupt *> *pending;		
-        // the list of interrupts scheduled
-        // to occur in the future
+        PendingQueue *pending;	// the interrupts scheduled to occur
+        // in the future, for each CPU
+        int numCPUs;		// how many queues there are
+        int numScheduled;		// interrupts ever scheduled
         bool inHandler;		// TRUE if we are running an interrupt handler
         bool yieldOnReturn; 	// TRUE if we are to context switch
         // on return from the interrupt handler
         MachineStatus status;	// idle, kernel mode, user mode
+        NetworkInput *network;	// the network being watched, or NULL
 
         // these functions are internal to the interrupt simulation code
 
@@ -135,8 +207,22 @@ class Interrupt {
         // Check if any interrupts are supposed
         // to occur now, and if so, do them
 
+        bool ReplayIfDue(bool advanceClock);
+        // The same, when replaying a log
+
+        PendingInterrupt *NextDeliverable();
+        // The first pending interrupt that can
+        // be delivered on the current CPU
+        void Deliver(PendingInterrupt *toCall);
+        // Call an interrupt handler, on the
+        // CPU the interrupt was meant for
+
         void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
                 IntStatus now); // simulated time
+
+        void WaitForNetwork();	// Let host time go by, in Idle, until
+        // a packet arrives or the next interrupt
+        // is due
 };
 
 #endif // INTERRRUPT_H
@@ -11,6 +11,11 @@
 #include "machine.h"
 #include "main.h"
 
+// The shape of main memory (see machine.h).
+int PageSize = DefaultPageSize;
+int NumPhysPages = DefaultNumPhysPages;
+int MemorySize = DefaultNumPhysPages * DefaultPageSize;
+
 // Textual names of the exceptions that can be generated by user program
 // execution, for debugging.
 static char* exceptionNames[] = { "no exception", "syscall", 
@@ -50,28 +55,51 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"blocks" -- if TRUE, run straight-line code a basic block at a
+//		time (see Machine::RunBlock), unless there is a TLB.
+//	"useTLB" -- if not NULL, translate through this TLB, rather than
+//		a page table.  The TLB belongs to the CPU being simulated,
+//		which puts its own in "tlb" when it runs (see cpu.h).
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, bool blocks, TLB *useTLB)
 {
     int i;
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
     mainMemory = new char[MemorySize];
+    memoryMapped = FALSE;
     for (i = 0; i < MemorySize; i++)
       	mainMemory[i] = 0;
-#ifdef USE_TLB
-    tlb = new TranslationEntry[TLBSize];
-    for (i = 0; i < TLBSize; i++)
-	tlb[i].valid = FALSE;
-    pageTable = NULL;
-#else	// use linear page table
-    tlb = NULL;
+    decodeCache = new Instruction[MemorySize / 4];
+    blockAt = NULL;
+    InvalidateDecoded(0, MemorySize);
+    useBlocks = blocks && (useTLB == NULL);	// a block's fetches don't
+						// go through the TLB
+    pageBlocks = NULL;
+    blockOps = NULL;
+    retired = NULL;
+    numFlushes = 0;
+    if (useBlocks) {
+	blockAt = new Block *[MemorySize / 4];
+	for (i = 0; i < MemorySize / 4; i++)
+	    blockAt[i] = NULL;
+	pageBlocks = new Block *[NumPhysPages];
+	for (i = 0; i < NumPhysPages; i++)
+	    pageBlocks[i] = NULL;
+	blockOps = new BlockOp[PageSize / 4];
+    }
+    tlb = useTLB;		// if there is one, there is no page table
     pageTable = NULL;
-#endif
+
+    cacheTranslations = (tlb == NULL) && !DEBUG_ON(dbgAddr);
+    FlushTranslations();
 
     singleStep = debug;
+    profile = NULL;
+    numExceptions = 0;
+    unchargedTicks = 0;
     CheckEndian();
 }
 
@@ -82,9 +110,69 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
-    delete [] mainMemory;
-    if (tlb != NULL)
-        delete [] tlb;
+    if (memoryMapped) {
+	UnmapFile(mainMemory, MemorySize);
+    } else {
+	delete [] mainMemory;
+    }
+    delete [] decodeCache;
+    if (useBlocks) {
+	FlushBlocks(0, MemorySize);
+	FreeRetired();
+	delete [] blockAt;
+	delete [] pageBlocks;
+	delete [] blockOps;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::InvalidateDecoded
+// 	Forget the instructions decoded from "size" bytes of main memory
+//	starting at "physAddr", because they are about to change: they
+//	will be decoded again the next time they are run, and any block
+//	built from them will be built again.
+//----------------------------------------------------------------------
+
+void
+Machine::InvalidateDecoded(int physAddr, int size)
+{
+    ASSERT(physAddr >= 0 && size >= 0 && physAddr + size <= MemorySize);
+    for (int word = physAddr / 4; word < (physAddr + size + 3) / 4; word++) {
+	decodeCache[word].opCode = 0;
+    }
+    if (blockAt != NULL) {
+	FlushBlocks(physAddr, size);
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::LoadMemory
+// 	Make main memory what "MemorySize" bytes of the file "fd" hold,
+//	starting at "offset".  If the host can, the file is mapped
+//	copy-on-write, so only the pages the programs touch are ever
+//	read, and the file is not changed; otherwise it is read in.
+//	Nothing decoded or translated from the old contents is kept.
+//----------------------------------------------------------------------
+
+void
+Machine::LoadMemory(int fd, int offset)
+{
+    char *mapped = MapFile(fd, offset, MemorySize, FALSE);
+
+    InvalidateDecoded(0, MemorySize);
+    FlushTranslations();
+    if (mapped == NULL) {
+	Lseek(fd, offset, 0);
+	Read(fd, mainMemory, MemorySize);
+	return;
+    }
+    if (memoryMapped) {
+	UnmapFile(mainMemory, MemorySize);
+    } else {
+	delete [] mainMemory;
+    }
+    mainMemory = mapped;
+    memoryMapped = TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -100,7 +188,11 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    HostPhase phase(HostKernel);
+
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
+    ChargeTicks();			// the kernel may look at them
+    numExceptions++;
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
     kernel->interrupt->setStatus(SystemMode);
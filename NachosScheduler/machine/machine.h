@@ -24,21 +24,27 @@
 #include "copyright.h"
 #include "utility.h"
 #include "translate.h"
+#include "tlb.h"
 
 // Definitions related to the size, and format of user memory
 
-const int PageSize = 128; 		// set the page size equal to
+const int DefaultPageSize = 128; 	// set the page size equal to
 					// the disk sector size, for simplicity
+const int DefaultNumPhysPages = 128;
 
-//
-// You are allowed to change this value.
-// Doing so will change the number of pages of physical memory
-// available on the simulated machine.
-//
-const int NumPhysPages = 128;
+// The size of a page, and the number of pages of physical memory
+// available on the simulated machine.  These are the defaults unless
+// "-ps <bytes>" or "-mem <pages>" says otherwise; the kernel sets them
+// before the machine is created, and they don't change after that.
+
+extern int PageSize;
+extern int NumPhysPages;
+extern int MemorySize;			// NumPhysPages * PageSize
 
-const int MemorySize = (NumPhysPages * PageSize);
 const int TLBSize = 4;			// if there is a TLB, make it small
+					// (unless -tlb says otherwise)
+const int TranslationCacheSize = 32;	// recent translations kept by the
+					// simulator (see Machine::ReadMem)
 
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
@@ -88,13 +94,96 @@ enum ExceptionType { NoException,           // Everything ok!
 // The procedures in this class are defined in machine.cc, mipssim.cc, and
 // translate.cc.
 
-class Instruction;
+// The following class defines an instruction, represented in both
+// 	undecoded binary form
+//      decoded to identify
+//	    operation to do
+//	    registers to act on
+//	    any immediate operand value
+//
+// The machine keeps every instruction it has decoded, by physical
+// address, until that word of memory is written (see
+// Machine::InvalidateDecoded); opCode 0 means not decoded.
+
+class Instruction {
+  public:
+    void Decode();	// decode the binary representation of the instruction
+
+    unsigned int value; // binary representation of the instruction
+
+    char opCode;     // Type of instruction.  This is NOT the same as the
+    		     // opcode field from the instruction: see defs in mips.h
+    char rs, rt, rd; // Three registers from instruction.
+    int extra;       // Immediate or target or shamt field or offset.
+                     // Immediates are sign-extended.
+};
+
+// The following classes define a basic block, as run by the block
+// engine (-bb): the straight-line instructions from one word of main
+// memory up to a branch and its delay slot, each bound ahead of time
+// to the routine that executes it, and to the registers it uses.
+// A block never crosses a page, so one translation of its first
+// address is good for all of it.  See Machine::RunBlock.
+
+class Machine;
+class BlockOp;
+
+class OpResult {		// what an instruction leaves for the
+  public:			// block engine to do afterwards
+    int pcAfter;		// the next NextPCReg
+    int loadReg;		// delayed load, as in OneInstruction
+    int loadValue;
+};
+
+typedef bool (*OpHandler)(Machine *machine, BlockOp *op, OpResult *result);
+				// execute one instruction; FALSE if
+				// it trapped to the kernel
+
+class BlockOp {
+  public:
+    OpHandler handler;		// the routine for this opcode
+    int *rs, *rt, *rd;		// the registers the fields name
+    int rtNum;			// the register the rt field names
+    int extra;			// as in Instruction
+};
+
+class Block {
+  public:
+    int start;			// physical address of the first op
+    int size;			// bytes of memory the block was built
+				// from (at least one word)
+    int numOps;			// 0 if the first instruction must be
+				// left to OneInstruction
+    BlockOp *ops;
+    Block *next;		// the other blocks in its page, or the
+				// next block waiting to be freed
+};
+
+// The following class defines a translation the simulator has kept,
+// so ReadMem and WriteMem can skip Machine::Translate.  The cache is
+// direct-mapped on the virtual page number.  A translation is only
+// used while the page table or TLB entry it came from still says the
+// same (which the kernel may change at any time); the kernel must
+// flush the cache if it switches page tables.
+
+class CachedTranslation {
+  public:
+    int virtualPage;		// -1 if the slot is empty
+    TranslationEntry *entry;	// the entry it was translated by
+    int physicalPage;		// entry->physicalPage at the time
+    char *memory;		// that page of main memory
+};
+
 class Interrupt;
+class ProgramProfile;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, bool blocks, TLB *useTLB);
+				// Initialize the simulation of the hardware
+				// for running user programs; "blocks" runs
+				// them with the block engine, and "useTLB"
+				// (which may be NULL) translates for them
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
@@ -105,6 +194,19 @@ class Machine {
     void WriteRegister(int num, int value);
 				// store a value into a CPU register
 
+    void InvalidateDecoded(int physAddr, int size);
+				// forget the decoded instructions in
+				// "size" bytes of main memory, which
+				// are being changed (or given to a new
+				// program)
+
+    void FlushTranslations();	// forget the cached translations, because
+				// the page table is being switched
+
+    void LoadMemory(int fd, int offset);
+				// replace main memory with "MemorySize"
+				// bytes of a file (see checkpoint.h)
+
 // Data structures accessible to the Nachos kernel -- main memory and the
 // page table/TLB.
 //
@@ -125,6 +227,7 @@ class Machine {
 // If "tlb" is non-NULL, the Nachos kernel is responsible for managing
 //	the contents of the TLB.  But the kernel can use any data structure
 //	it wants (eg, segmented paging) for handling TLB cache misses.
+//	(See tlb.h for how the TLB is organized.)
 // 
 // For simplicity, both the page table pointer and the TLB pointer are
 // public.  However, while there can be multiple page tables (one per address
@@ -132,7 +235,7 @@ class Machine {
 // Thus the TLB pointer should be considered as *read-only*, although 
 // the contents of the TLB are free to be modified by the kernel software.
 
-    TranslationEntry *tlb;		// this pointer should be considered 
+    TLB *tlb;				// this pointer should be considered 
 					// "read-only" to Nachos kernel code
 
     TranslationEntry *pageTable;
@@ -149,10 +252,27 @@ class Machine {
     void DelayedLoad(int nextReg, int nextVal);  	
 				// Do a pending delayed load (modifying a reg)
 
-    void OneInstruction(Instruction *instr); 	
-    				// Run one instruction of a user program.
-    
+    void OneInstruction(); 	// Run one instruction of a user program.
+    void ChargeTicks();		// add the user ticks Run has counted
+				// itself to the statistics
+    Instruction *Decoded(int physAddr);
+				// the decoded instruction at "physAddr"
+
+    Block *FindBlock();		// the block at the PC, if it can be run
+    Block *BuildBlock(int physAddr);
+				// bind the instructions from "physAddr"
+    void RunBlock(Block *block, int maxOps);
+				// run up to "maxOps" ops of a block
+    void FlushBlocks(int physAddr, int size);
+				// retire the blocks built from memory
+				// that is changing
+    void FreeRetired();		// free the retired blocks
+
+
 
+    char *CachedAddress(int virtAddr, bool writing);
+				// where "virtAddr" is in main memory, if
+				// its translation is cached; else NULL
 
     ExceptionType Translate(int virtAddr, int* physAddr, int size,bool writing);
     				// Translate an address, and check for 
@@ -172,24 +292,56 @@ class Machine {
 // Internal data structures
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
+    bool memoryMapped;		// mainMemory was mapped by LoadMemory
+    Instruction *decodeCache;	// the instruction decoded from each word
+				// of main memory, if it has been
 
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
 				// time reaches this value
 
-    friend class Interrupt;		// calls DelayedLoad()    
+    int numExceptions;		// traps to the kernel so far (which may
+				// have scheduled interrupts)
+    int unchargedTicks;		// user ticks not yet in the statistics
+
+    CachedTranslation translationCache[TranslationCacheSize];
+    bool cacheTranslations;	// fill the cache (not with a TLB, nor
+				// while address debugging is on, since
+				// a cached translation is not printed)
+
+    bool useBlocks;		// run with the block engine (-bb)
+    Block **blockAt;		// the block starting at each word of main
+				// memory, if one has been built
+    Block **pageBlocks;		// every block built from each page
+    BlockOp *blockOps;		// room for the ops of a page, while
+				// a block is built
+    Block *retired;		// blocks flushed, to free between blocks
+    int numFlushes;		// blocks retired so far
+
+    ProgramProfile *profile;	// of the program running (-pp), or NULL
+
+    friend class Interrupt;		// calls DelayedLoad()
+    friend class ThreadedCode;		// the ops of a block
 };
 
 extern void ExceptionHandler(ExceptionType which);
 				// Entry point into Nachos for handling
 				// user system calls and exceptions
 				// Defined in exception.cc
+extern void PrintSyscalls();	// what the system calls have cost,
+				// at halt; also in exception.cc
+extern int RingSyscall(int code, int arg1, int arg2, int arg3);
+				// make a call queued in a ring (see
+				// syscallring.h); exception.cc too
 
 
 // Routines for converting Words and Short Words to and from the
 // simulated machine's format of little endian.  If the host machine
-// is little endian (DEC and Intel), these end up being NOPs.
+// is little endian (DEC, Intel and most ARM), these are NOPs; they are
+// inline, so that every load and store ReadMem and WriteMem simulate
+// (and every instruction fetched) compiles to a plain access.  Only a
+// host built with HOST_IS_BIG_ENDIAN swaps bytes.
 //
 // What is stored in each format:
 //	host byte ordering:
@@ -198,9 +350,27 @@ extern void ExceptionHandler(ExceptionType which);
 //	simulated machine byte ordering:
 //	   contents of main memory
 
-unsigned int WordToHost(unsigned int word);
-unsigned short ShortToHost(unsigned short shortword);
-unsigned int WordToMachine(unsigned int word);
-unsigned short ShortToMachine(unsigned short shortword);
+#ifdef HOST_IS_BIG_ENDIAN
+inline unsigned int
+WordToHost(unsigned int word)
+{
+    return ((word >> 24) & 0x000000ff) | ((word >> 8) & 0x0000ff00)
+	 | ((word << 8) & 0x00ff0000) | ((word << 24) & 0xff000000);
+}
+
+inline unsigned short
+ShortToHost(unsigned short shortword)
+{
+    return ((shortword << 8) & 0xff00) | ((shortword >> 8) & 0x00ff);
+}
+#else
+inline unsigned int WordToHost(unsigned int word) { return word; }
+inline unsigned short ShortToHost(unsigned short shortword) { return shortword; }
+#endif // HOST_IS_BIG_ENDIAN
+
+inline unsigned int WordToMachine(unsigned int word)
+	{ return WordToHost(word); }
+inline unsigned short ShortToMachine(unsigned short shortword)
+	{ return ShortToHost(shortword); }
 
 #endif // MACHINE_H
@@ -24,26 +24,6 @@
 
 static void Mult(int a, int b, bool signedArith, int* hiPtr, int* loPtr);
 
-// The following class defines an instruction, represented in both
-// 	undecoded binary form
-//      decoded to identify
-//	    operation to do
-//	    registers to act on
-//	    any immediate operand value
-
-class Instruction {
-  public:
-    void Decode();	// decode the binary representation of the instruction
-
-    unsigned int value; // binary representation of the instruction
-
-    char opCode;     // Type of instruction.  This is NOT the same as the
-    		     // opcode field from the instruction: see defs in mips.h
-    char rs, rt, rd; // Three registers from instruction.
-    int extra;       // Immediate or target or shamt field or offset.
-                     // Immediates are sign-extended.
-};
-
 //----------------------------------------------------------------------
 // Machine::Run
 // 	Simulate the execution of a user-level program on Nachos.
@@ -51,27 +31,115 @@ class Instruction {
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
+//
+//	Calling Interrupt::OneTick after every instruction is much of
+//	the cost of simulating it, and usually all it does is advance
+//	the clock.  So we ask the interrupt simulation until when that
+//	will be so, and until then only advance stats->totalTicks
+//	ourselves, charging the user ticks to the statistics in bulk
+//	(before an exception, or when we next call OneTick).  Any
+//	exception may have scheduled interrupts, so after one we always
+//	call OneTick and ask again.  The simulation runs exactly as if
+//	OneTick had been called every time.
+//
+//	With the block engine, we run as much of a block at a time as
+//	will finish before then; the last instruction we run is then
+//	accounted for here, as if OneInstruction had run it.  The engine
+//	is not used while machine or address debugging is on, since
+//	it does not print what OneInstruction would, nor for a program
+//	being profiled, since it does not count instructions.
+//
+//	"profile" is the profile of the program this call runs, if any;
+//	when we get the CPU back from another thread, its Run may have
+//	installed another one.  A checkpoint (-ckpt) is taken between
+//	instructions, after an interrupt.
 //----------------------------------------------------------------------
 
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;  // storage for decoded instruction
+    Statistics *stats = kernel->stats;
+    Interrupt *interrupt = kernel->interrupt;
+    int quietUntil, exceptionsBefore;
+    Thread *thread = kernel->currentThread;	// the one running the program
+    ProgramProfile *ourProfile = thread->profile;
+    bool blocks = useBlocks && !DEBUG_ON(dbgMach)
+				&& !DEBUG_ON(dbgAddr)
+				&& ourProfile == NULL;
+    Block *block;
 
-    if (debug->IsEnabled('m')) {
+    if (DEBUG_ON(dbgMach)) {
         cout << "Starting program in thread: " << kernel->currentThread->getName();
 		cout << ", at time: " << kernel->stats->totalTicks << "\n";
     }
-    kernel->interrupt->setStatus(UserMode);
+    interrupt->setStatus(UserMode);
+    profile = ourProfile;
+    quietUntil = interrupt->QuietUntil();
+    exceptionsBefore = numExceptions;
+    hostActivity = HostInterpret;
     for (;;) {
-        OneInstruction(instr);
-		kernel->interrupt->OneTick();
+	if (blocks && !singleStep && (block = FindBlock()) != NULL) {
+	    RunBlock(block, max(1, (quietUntil - stats->totalTicks - 1)
+					/ UserTick + 1));
+	} else {
+	    OneInstruction();
+	}
+	if (numExceptions == exceptionsBefore && !singleStep
+	      && stats->totalTicks + UserTick < quietUntil) {
+	    stats->totalTicks += UserTick;	// nothing else to do
+	    unchargedTicks += UserTick;
+	    continue;
+	}
+	ChargeTicks();
+	thread->betweenInstructions = TRUE;	// for a checkpoint
+		interrupt->OneTick();
+	thread->betweenInstructions = FALSE;
 		if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
 	  		Debugger();
+	profile = ourProfile;
+	if (kernel->checkpoint != NULL) {
+	    kernel->checkpoint->Poll();
+	}
+	quietUntil = interrupt->QuietUntil();
+	exceptionsBefore = numExceptions;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::ChargeTicks
+// 	Add the ticks of the user instructions Run has counted itself
+//	(without calling OneTick) to the user and CPU busy time.
+//----------------------------------------------------------------------
+
+void
+Machine::ChargeTicks()
+{
+    if (unchargedTicks > 0) {
+	kernel->stats->userTicks += unchargedTicks;
+	kernel->currentCPU->busyTicks += unchargedTicks;
+	unchargedTicks = 0;
     }
 }
 
 
+//----------------------------------------------------------------------
+// Machine::Decoded
+// 	Return the instruction at "physAddr", decoding it unless it has
+//	been decoded since that word of memory was written.
+//----------------------------------------------------------------------
+
+Instruction *
+Machine::Decoded(int physAddr)
+{
+    Instruction *instr = &decodeCache[physAddr / 4];
+
+    if (instr->opCode == 0) {
+	instr->value = WordToHost(*(unsigned int *) &mainMemory[physAddr]);
+	instr->Decode();
+    }
+    return instr;
+}
+
 //----------------------------------------------------------------------
 // TypeToReg
 // 	Retrieve the register # referred to in an instruction. 
@@ -108,7 +176,8 @@ TypeToReg(RegType reg, Instruction *instr)
 //
 //	This routine is re-entrant, in that it can be called multiple
 //	times concurrently -- one for each thread executing user code.
-//	We get re-entrancy by never caching any data -- we always re-start the
+//	We get re-entrancy by never caching any data (other than decoded
+//	instructions, which depend only on memory) -- we always re-start the
 //	simulation from scratch each time we are called (or after trapping
 //	back to the Nachos kernel on an exception or interrupt), and we always
 //	store all data back to the machine registers and memory before
@@ -118,24 +187,37 @@ TypeToReg(RegType reg, Instruction *instr)
 //----------------------------------------------------------------------
 
 void
-Machine::OneInstruction(Instruction *instr)
+Machine::OneInstruction()
 {
 #ifdef SIM_FIX
     int byte;       // described in Kane for LWL,LWR,...
 #endif
 
-    int raw;
+    Instruction *instr;
+    ExceptionType exception;
+    int physAddr;
+    char *cached;
     int nextLoadReg = 0; 	
     int nextLoadValue = 0; 	// record delayed load operation, to apply
 				// in the future
 
-    // Fetch instruction 
-    if (!ReadMem(registers[PCReg], 4, &raw))
-	return;			// exception occurred
-    instr->value = raw;
-    instr->Decode();
+    // Fetch instruction, as ReadMem would, but only decode it if it
+    // hasn't been decoded since that word of memory was written
+    if (!(registers[PCReg] & 0x3)
+	  && (cached = CachedAddress(registers[PCReg], FALSE)) != NULL) {
+	physAddr = cached - mainMemory;
+    } else {
+	DEBUG(dbgAddr, "Reading VA " << registers[PCReg] << ", size 4");
+	exception = Translate(registers[PCReg], &physAddr, 4, FALSE);
+	if (exception != NoException) {
+	    RaiseException(exception, registers[PCReg]);
+	    return;			// exception occurred
+	}
+    }
+    instr = Decoded(physAddr);
+    DEBUG(dbgAddr, "\tvalue read = " << (int) instr->value);
 
-    if (debug->IsEnabled('m')) {
+    if (DEBUG_ON(dbgMach)) {
         struct OpString *str = &opStrings[instr->opCode];
 	char buf[80];
 
@@ -668,6 +750,9 @@ Machine::OneInstruction(Instruction *instr)
 	break;
     	
       case OP_SYSCALL:
+	if (profile != NULL) {		// it never gets to the end
+	    profile->Executed(registers[PCReg], OP_SYSCALL, FALSE);
+	}
 	RaiseException(SyscallException, 0);
 	return; 
 	
@@ -690,6 +775,11 @@ Machine::OneInstruction(Instruction *instr)
     
     // Now we have successfully executed the instruction.
     
+    if (profile != NULL) {
+	profile->Executed(registers[PCReg], instr->opCode,
+			  pcAfter != registers[NextPCReg] + 4);
+    }
+
     // Do any delayed load operation
     DelayedLoad(nextLoadReg, nextLoadValue);
     
@@ -717,6 +807,783 @@ Machine::DelayedLoad(int nextReg, int nextValue)
     registers[0] = 0; 	// and always make sure R0 stays zero.
 }
 
+//----------------------------------------------------------------------
+// ThreadedCode
+// 	The routines the ops of a block are bound to, one per opcode:
+//	each does what the case for that opcode in OneInstruction does,
+//	with the registers it uses looked up when the block was built.
+//	Instructions with no routine here (syscalls, unaligned loads and
+//	stores, and illegal instructions) end a block, to be run by
+//	OneInstruction.
+//----------------------------------------------------------------------
+
+class ThreadedCode {
+  public:
+    static bool Bind(Machine *machine, Instruction *instr, BlockOp *op);
+				// bind "op" to the routine for "instr",
+				// or return FALSE if there is none
+    static bool IsBranch(int opCode);
+				// does "opCode" have a delay slot?
+
+  private:
+    static bool Add(Machine *m, BlockOp *op, OpResult *result);
+    static bool Addi(Machine *m, BlockOp *op, OpResult *result);
+    static bool Addiu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Addu(Machine *m, BlockOp *op, OpResult *result);
+    static bool And(Machine *m, BlockOp *op, OpResult *result);
+    static bool Andi(Machine *m, BlockOp *op, OpResult *result);
+    static bool Beq(Machine *m, BlockOp *op, OpResult *result);
+    static bool Bgez(Machine *m, BlockOp *op, OpResult *result);
+    static bool Bgezal(Machine *m, BlockOp *op, OpResult *result);
+    static bool Bgtz(Machine *m, BlockOp *op, OpResult *result);
+    static bool Blez(Machine *m, BlockOp *op, OpResult *result);
+    static bool Bltz(Machine *m, BlockOp *op, OpResult *result);
+    static bool Bltzal(Machine *m, BlockOp *op, OpResult *result);
+    static bool Bne(Machine *m, BlockOp *op, OpResult *result);
+    static bool Div(Machine *m, BlockOp *op, OpResult *result);
+    static bool Divu(Machine *m, BlockOp *op, OpResult *result);
+    static bool J(Machine *m, BlockOp *op, OpResult *result);
+    static bool Jal(Machine *m, BlockOp *op, OpResult *result);
+    static bool Jalr(Machine *m, BlockOp *op, OpResult *result);
+    static bool Jr(Machine *m, BlockOp *op, OpResult *result);
+    static bool Lb(Machine *m, BlockOp *op, OpResult *result);
+    static bool Lbu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Lh(Machine *m, BlockOp *op, OpResult *result);
+    static bool Lhu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Lui(Machine *m, BlockOp *op, OpResult *result);
+    static bool Lw(Machine *m, BlockOp *op, OpResult *result);
+    static bool Mfhi(Machine *m, BlockOp *op, OpResult *result);
+    static bool Mflo(Machine *m, BlockOp *op, OpResult *result);
+    static bool Mthi(Machine *m, BlockOp *op, OpResult *result);
+    static bool Mtlo(Machine *m, BlockOp *op, OpResult *result);
+    static bool Mult(Machine *m, BlockOp *op, OpResult *result);
+    static bool Multu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Nor(Machine *m, BlockOp *op, OpResult *result);
+    static bool Or(Machine *m, BlockOp *op, OpResult *result);
+    static bool Ori(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sb(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sh(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sll(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sllv(Machine *m, BlockOp *op, OpResult *result);
+    static bool Slt(Machine *m, BlockOp *op, OpResult *result);
+    static bool Slti(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sltiu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sltu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sra(Machine *m, BlockOp *op, OpResult *result);
+    static bool Srav(Machine *m, BlockOp *op, OpResult *result);
+    static bool Srl(Machine *m, BlockOp *op, OpResult *result);
+    static bool Srlv(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sub(Machine *m, BlockOp *op, OpResult *result);
+    static bool Subu(Machine *m, BlockOp *op, OpResult *result);
+    static bool Sw(Machine *m, BlockOp *op, OpResult *result);
+    static bool Xor(Machine *m, BlockOp *op, OpResult *result);
+    static bool Xori(Machine *m, BlockOp *op, OpResult *result);
+};
+
+bool
+ThreadedCode::Bind(Machine *machine, Instruction *instr, BlockOp *op)
+{
+    switch (instr->opCode) {
+      case OP_ADD:	op->handler = Add; break;
+      case OP_ADDI:	op->handler = Addi; break;
+      case OP_ADDIU:	op->handler = Addiu; break;
+      case OP_ADDU:	op->handler = Addu; break;
+      case OP_AND:	op->handler = And; break;
+      case OP_ANDI:	op->handler = Andi; break;
+      case OP_BEQ:	op->handler = Beq; break;
+      case OP_BGEZ:	op->handler = Bgez; break;
+      case OP_BGEZAL:	op->handler = Bgezal; break;
+      case OP_BGTZ:	op->handler = Bgtz; break;
+      case OP_BLEZ:	op->handler = Blez; break;
+      case OP_BLTZ:	op->handler = Bltz; break;
+      case OP_BLTZAL:	op->handler = Bltzal; break;
+      case OP_BNE:	op->handler = Bne; break;
+      case OP_DIV:	op->handler = Div; break;
+      case OP_DIVU:	op->handler = Divu; break;
+      case OP_J:	op->handler = J; break;
+      case OP_JAL:	op->handler = Jal; break;
+      case OP_JALR:	op->handler = Jalr; break;
+      case OP_JR:	op->handler = Jr; break;
+      case OP_LB:	op->handler = Lb; break;
+      case OP_LBU:	op->handler = Lbu; break;
+      case OP_LH:	op->handler = Lh; break;
+      case OP_LHU:	op->handler = Lhu; break;
+      case OP_LUI:	op->handler = Lui; break;
+      case OP_LW:	op->handler = Lw; break;
+      case OP_MFHI:	op->handler = Mfhi; break;
+      case OP_MFLO:	op->handler = Mflo; break;
+      case OP_MTHI:	op->handler = Mthi; break;
+      case OP_MTLO:	op->handler = Mtlo; break;
+      case OP_MULT:	op->handler = Mult; break;
+      case OP_MULTU:	op->handler = Multu; break;
+      case OP_NOR:	op->handler = Nor; break;
+      case OP_OR:	op->handler = Or; break;
+      case OP_ORI:	op->handler = Ori; break;
+      case OP_SB:	op->handler = Sb; break;
+      case OP_SH:	op->handler = Sh; break;
+      case OP_SLL:	op->handler = Sll; break;
+      case OP_SLLV:	op->handler = Sllv; break;
+      case OP_SLT:	op->handler = Slt; break;
+      case OP_SLTI:	op->handler = Slti; break;
+      case OP_SLTIU:	op->handler = Sltiu; break;
+      case OP_SLTU:	op->handler = Sltu; break;
+      case OP_SRA:	op->handler = Sra; break;
+      case OP_SRAV:	op->handler = Srav; break;
+      case OP_SRL:	op->handler = Srl; break;
+      case OP_SRLV:	op->handler = Srlv; break;
+      case OP_SUB:	op->handler = Sub; break;
+      case OP_SUBU:	op->handler = Subu; break;
+      case OP_SW:	op->handler = Sw; break;
+      case OP_XOR:	op->handler = Xor; break;
+      case OP_XORI:	op->handler = Xori; break;
+      default:		return FALSE;	// left to OneInstruction
+    }
+    op->rs = &machine->registers[(int) instr->rs];
+    op->rt = &machine->registers[(int) instr->rt];
+    op->rd = &machine->registers[(int) instr->rd];
+    op->rtNum = instr->rt;
+    op->extra = instr->extra;
+    return TRUE;
+}
+
+bool
+ThreadedCode::IsBranch(int opCode)
+{
+    switch (opCode) {
+      case OP_BEQ: case OP_BGEZ: case OP_BGEZAL: case OP_BGTZ:
+      case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL: case OP_BNE:
+      case OP_J: case OP_JAL: case OP_JALR: case OP_JR:
+	return TRUE;
+      default:
+	return FALSE;
+    }
+}
+
+bool
+ThreadedCode::Add(Machine *m, BlockOp *op, OpResult *result)
+{
+    int sum = *op->rs + *op->rt;
+
+    if (!((*op->rs ^ *op->rt) & SIGN_BIT) && ((*op->rs ^ sum) & SIGN_BIT)) {
+	m->RaiseException(OverflowException, 0);
+	return FALSE;
+    }
+    *op->rd = sum;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Addi(Machine *m, BlockOp *op, OpResult *result)
+{
+    int sum = *op->rs + op->extra;
+
+    if (!((*op->rs ^ op->extra) & SIGN_BIT) && ((op->extra ^ sum) & SIGN_BIT)) {
+	m->RaiseException(OverflowException, 0);
+	return FALSE;
+    }
+    *op->rt = sum;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Addiu(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = *op->rs + op->extra;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Addu(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rs + *op->rt;
+    return TRUE;
+}
+
+bool
+ThreadedCode::And(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rs & *op->rt;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Andi(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = *op->rs & (op->extra & 0xffff);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Beq(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (*op->rs == *op->rt)
+	result->pcAfter = m->registers[NextPCReg] + IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Bgez(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (!(*op->rs & SIGN_BIT))
+	result->pcAfter = m->registers[NextPCReg] + IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Bgezal(Machine *m, BlockOp *op, OpResult *result)
+{
+    m->registers[R31] = m->registers[NextPCReg] + 4;
+    return Bgez(m, op, result);
+}
+
+bool
+ThreadedCode::Bgtz(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (*op->rs > 0)
+	result->pcAfter = m->registers[NextPCReg] + IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Blez(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (*op->rs <= 0)
+	result->pcAfter = m->registers[NextPCReg] + IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Bltz(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (*op->rs & SIGN_BIT)
+	result->pcAfter = m->registers[NextPCReg] + IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Bltzal(Machine *m, BlockOp *op, OpResult *result)
+{
+    m->registers[R31] = m->registers[NextPCReg] + 4;
+    return Bltz(m, op, result);
+}
+
+bool
+ThreadedCode::Bne(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (*op->rs != *op->rt)
+	result->pcAfter = m->registers[NextPCReg] + IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Div(Machine *m, BlockOp *op, OpResult *result)
+{
+    if (*op->rt == 0) {
+	m->registers[LoReg] = 0;
+	m->registers[HiReg] = 0;
+    } else {
+	m->registers[LoReg] = *op->rs / *op->rt;
+	m->registers[HiReg] = *op->rs % *op->rt;
+    }
+    return TRUE;
+}
+
+bool
+ThreadedCode::Divu(Machine *m, BlockOp *op, OpResult *result)
+{
+    unsigned int rs = (unsigned int) *op->rs;
+    unsigned int rt = (unsigned int) *op->rt;
+
+    if (rt == 0) {
+	m->registers[LoReg] = 0;
+	m->registers[HiReg] = 0;
+    } else {
+	m->registers[LoReg] = (int) (rs / rt);
+	m->registers[HiReg] = (int) (rs % rt);
+    }
+    return TRUE;
+}
+
+bool
+ThreadedCode::J(Machine *m, BlockOp *op, OpResult *result)
+{
+    result->pcAfter = (result->pcAfter & 0xf0000000) | IndexToAddr(op->extra);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Jal(Machine *m, BlockOp *op, OpResult *result)
+{
+    m->registers[R31] = m->registers[NextPCReg] + 4;
+    return J(m, op, result);
+}
+
+bool
+ThreadedCode::Jalr(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = m->registers[NextPCReg] + 4;
+    return Jr(m, op, result);
+}
+
+bool
+ThreadedCode::Jr(Machine *m, BlockOp *op, OpResult *result)
+{
+    result->pcAfter = *op->rs;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Lb(Machine *m, BlockOp *op, OpResult *result)
+{
+    int value;
+
+    if (!m->ReadMem(*op->rs + op->extra, 1, &value))
+	return FALSE;
+    result->loadReg = op->rtNum;
+    result->loadValue = (value & 0x80) ? (value | 0xffffff00) : (value & 0xff);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Lbu(Machine *m, BlockOp *op, OpResult *result)
+{
+    int value;
+
+    if (!m->ReadMem(*op->rs + op->extra, 1, &value))
+	return FALSE;
+    result->loadReg = op->rtNum;
+    result->loadValue = value & 0xff;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Lh(Machine *m, BlockOp *op, OpResult *result)
+{
+    int addr = *op->rs + op->extra;
+    int value;
+
+    if (addr & 0x1) {
+	m->RaiseException(AddressErrorException, addr);
+	return FALSE;
+    }
+    if (!m->ReadMem(addr, 2, &value))
+	return FALSE;
+    result->loadReg = op->rtNum;
+    result->loadValue = (value & 0x8000) ? (value | 0xffff0000)
+					  : (value & 0xffff);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Lhu(Machine *m, BlockOp *op, OpResult *result)
+{
+    int addr = *op->rs + op->extra;
+    int value;
+
+    if (addr & 0x1) {
+	m->RaiseException(AddressErrorException, addr);
+	return FALSE;
+    }
+    if (!m->ReadMem(addr, 2, &value))
+	return FALSE;
+    result->loadReg = op->rtNum;
+    result->loadValue = value & 0xffff;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Lui(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = op->extra << 16;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Lw(Machine *m, BlockOp *op, OpResult *result)
+{
+    int addr = *op->rs + op->extra;
+    int value;
+
+    if (addr & 0x3) {
+	m->RaiseException(AddressErrorException, addr);
+	return FALSE;
+    }
+    if (!m->ReadMem(addr, 4, &value))
+	return FALSE;
+    result->loadReg = op->rtNum;
+    result->loadValue = value;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Mfhi(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = m->registers[HiReg];
+    return TRUE;
+}
+
+bool
+ThreadedCode::Mflo(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = m->registers[LoReg];
+    return TRUE;
+}
+
+bool
+ThreadedCode::Mthi(Machine *m, BlockOp *op, OpResult *result)
+{
+    m->registers[HiReg] = *op->rs;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Mtlo(Machine *m, BlockOp *op, OpResult *result)
+{
+    m->registers[LoReg] = *op->rs;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Mult(Machine *m, BlockOp *op, OpResult *result)
+{
+    ::Mult(*op->rs, *op->rt, TRUE, &m->registers[HiReg], &m->registers[LoReg]);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Multu(Machine *m, BlockOp *op, OpResult *result)
+{
+    ::Mult(*op->rs, *op->rt, FALSE, &m->registers[HiReg], &m->registers[LoReg]);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Nor(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = ~(*op->rs | *op->rt);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Or(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rs | *op->rt;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Ori(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = *op->rs | (op->extra & 0xffff);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sb(Machine *m, BlockOp *op, OpResult *result)
+{
+    return m->WriteMem((unsigned) (*op->rs + op->extra), 1, *op->rt);
+}
+
+bool
+ThreadedCode::Sh(Machine *m, BlockOp *op, OpResult *result)
+{
+    return m->WriteMem((unsigned) (*op->rs + op->extra), 2, *op->rt);
+}
+
+bool
+ThreadedCode::Sll(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rt << op->extra;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sllv(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rt << (*op->rs & 0x1f);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Slt(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = (*op->rs < *op->rt) ? 1 : 0;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Slti(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = (*op->rs < op->extra) ? 1 : 0;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sltiu(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = ((unsigned int) *op->rs < (unsigned int) op->extra) ? 1 : 0;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sltu(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = ((unsigned int) *op->rs < (unsigned int) *op->rt) ? 1 : 0;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sra(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rt >> op->extra;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Srav(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rt >> (*op->rs & 0x1f);
+    return TRUE;
+}
+
+// Like OneInstruction, these shift a signed int, so the sign is copied.
+
+bool
+ThreadedCode::Srl(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rt >> op->extra;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Srlv(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rt >> (*op->rs & 0x1f);
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sub(Machine *m, BlockOp *op, OpResult *result)
+{
+    int diff = *op->rs - *op->rt;
+
+    if (((*op->rs ^ *op->rt) & SIGN_BIT) && ((*op->rs ^ diff) & SIGN_BIT)) {
+	m->RaiseException(OverflowException, 0);
+	return FALSE;
+    }
+    *op->rd = diff;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Subu(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rs - *op->rt;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Sw(Machine *m, BlockOp *op, OpResult *result)
+{
+    return m->WriteMem((unsigned) (*op->rs + op->extra), 4, *op->rt);
+}
+
+bool
+ThreadedCode::Xor(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rd = *op->rs ^ *op->rt;
+    return TRUE;
+}
+
+bool
+ThreadedCode::Xori(Machine *m, BlockOp *op, OpResult *result)
+{
+    *op->rt = *op->rs ^ (op->extra & 0xffff);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Machine::FindBlock
+// 	Return the block starting at the PC, building it if need be.
+//	Return NULL if the next instruction should be left to
+//	OneInstruction: if we are in a delay slot (a block must start
+//	at its first instruction), if fetching it would trap, or if it
+//	is one the block engine does not run.
+//
+//	This is also where blocks flushed since the last one ran are
+//	freed, since none of them can be running.
+//----------------------------------------------------------------------
+
+Block *
+Machine::FindBlock()
+{
+    int physAddr;
+    char *cached;
+    Block *block;
+
+    FreeRetired();
+    if (registers[NextPCReg] != registers[PCReg] + 4)
+	return NULL;
+    if (!(registers[PCReg] & 0x3)
+	  && (cached = CachedAddress(registers[PCReg], FALSE)) != NULL)
+	physAddr = cached - mainMemory;
+    else if (Translate(registers[PCReg], &physAddr, 4, FALSE) != NoException)
+	return NULL;
+    block = blockAt[physAddr / 4];
+    if (block == NULL)
+	block = BuildBlock(physAddr);
+    return (block->numOps > 0) ? block : NULL;
+}
+
+//----------------------------------------------------------------------
+// Machine::BuildBlock
+// 	Bind the instructions starting at "physAddr" into a block, up to
+//	and including the first branch or jump and its delay slot, and
+//	no further than the end of the page.  A block stops short of an
+//	instruction the block engine does not run; if the delay slot of
+//	a branch is such an instruction, is in the next page, or is a
+//	branch itself, the block stops short of the branch too.
+//----------------------------------------------------------------------
+
+Block *
+Machine::BuildBlock(int physAddr)
+{
+    int pageEnd = (physAddr / PageSize + 1) * PageSize;
+    BlockOp *ops = blockOps;
+    int numOps = 0;
+    Block *block;
+
+    for (int addr = physAddr; addr < pageEnd; addr += 4) {
+	Instruction *instr = Decoded(addr);
+
+	if (!ThreadedCode::Bind(this, instr, &ops[numOps]))
+	    break;
+	numOps++;
+	if (ThreadedCode::IsBranch(instr->opCode)) {
+	    if (addr + 4 < pageEnd
+		  && !ThreadedCode::IsBranch(Decoded(addr + 4)->opCode)
+		  && ThreadedCode::Bind(this, Decoded(addr + 4),
+					&ops[numOps])) {
+		numOps++;		// with its delay slot
+	    } else {
+		numOps--;
+	    }
+	    break;
+	}
+    }
+
+    block = new Block;
+    block->start = physAddr;
+    block->size = max(numOps, 1) * 4;
+    block->numOps = numOps;
+    block->ops = new BlockOp[max(numOps, 1)];
+    for (int i = 0; i < numOps; i++)
+	block->ops[i] = ops[i];
+    block->next = pageBlocks[physAddr / PageSize];
+    pageBlocks[physAddr / PageSize] = block;
+    blockAt[physAddr / 4] = block;
+    DEBUG(dbgMach, "Built a block of " << numOps << " at " << physAddr);
+    return block;
+}
+
+//----------------------------------------------------------------------
+// Machine::RunBlock
+// 	Run the ops of a block, no more than "maxOps" of them, stopping
+//	early on an exception, or if they have changed memory that some
+//	block was built from (which may be this one).
+//
+//	Each op does exactly what OneInstruction would, including the
+//	delayed load and the update of the program counters, so the
+//	machine is as OneInstruction would leave it after every op, and
+//	a delay slot, which is always in the same block as its branch,
+//	sees the branch's NextPCReg.  Since the fetch of each
+//	instruction is only a new offset in the same page as the first,
+//	we skip it.
+//
+//	Every op but the last one we run advances the clock, as Run
+//	would; Run decides what to do about the last.  Run gives us no
+//	more ops than will finish before the next interrupt is due.
+//----------------------------------------------------------------------
+
+void
+Machine::RunBlock(Block *block, int maxOps)
+{
+    Statistics *stats = kernel->stats;
+    int flushesBefore = numFlushes;
+    BlockOp *op = block->ops;
+    BlockOp *last = op + min(block->numOps, maxOps) - 1;
+    OpResult result;
+
+    for (;;) {
+	result.pcAfter = registers[NextPCReg] + 4;
+	result.loadReg = 0;
+	result.loadValue = 0;
+	if (!(*op->handler)(this, op, &result))
+	    return;			// trapped to the kernel
+
+	DelayedLoad(result.loadReg, result.loadValue);
+	registers[PrevPCReg] = registers[PCReg];
+	registers[PCReg] = registers[NextPCReg];
+	registers[NextPCReg] = result.pcAfter;
+
+	if (op == last || numFlushes != flushesBefore)
+	    return;
+	stats->totalTicks += UserTick;
+	unchargedTicks += UserTick;
+	op++;
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushBlocks
+// 	Retire every block built from any of the "size" bytes of main
+//	memory at "physAddr", because they are changing.  A retired
+//	block may still be running, so it is only freed by FreeRetired.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushBlocks(int physAddr, int size)
+{
+    if (size <= 0)
+	return;
+    for (int page = physAddr / PageSize; page <= (physAddr + size - 1) / PageSize;
+	 page++) {
+	Block **ptr = &pageBlocks[page];
+
+	while (*ptr != NULL) {
+	    Block *block = *ptr;
+
+	    if (block->start < physAddr + size
+		  && physAddr < block->start + block->size) {
+		*ptr = block->next;
+		blockAt[block->start / 4] = NULL;
+		block->next = retired;
+		retired = block;
+		numFlushes++;
+	    } else {
+		ptr = &block->next;
+	    }
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// Machine::FreeRetired
+// 	Free the blocks FlushBlocks has retired.
+//----------------------------------------------------------------------
+
+void
+Machine::FreeRetired()
+{
+    while (retired != NULL) {
+	Block *block = retired;
+
+	retired = block->next;
+	delete [] block->ops;
+	delete block;
+    }
+}
+
 //----------------------------------------------------------------------
 // Instruction::Decode
 // 	Decode a MIPS instruction 
@@ -12,6 +12,8 @@
 #include "network.h"
 #include "main.h"
 
+volatile int NetworkInput::signalled = 0;
+
 //-----------------------------------------------------------------------
 // NetworkInput::NetworkInput
 // 	Initialize the simulation for the network input
@@ -25,14 +27,19 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
     callWhenAvail = toCall;
     packetAvail = FALSE;
     inHdr.length = 0;
+    wire = inbox;
     
     sock = OpenSocket();
     sprintf(sockName, "SOCKET_%d", kernel->hostName);
     AssignNameToSocket(sockName, sock);		 // Bind socket to a filename 
 						 // in the current directory.
 
-    // start polling for incoming packets
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    // have the host tell us when packets arrive, or poll for them;
+    // and look for any that already have
+    polling = !CallOnSocketInput(sock, Signal);
+    checkPending = FALSE;
+    kernel->interrupt->WatchNetwork(this);
+    Notice();
 }
 
 //-----------------------------------------------------------------------
@@ -43,10 +50,54 @@ NetworkInput::NetworkInput(CallBackObj *toCall)
 
 NetworkInput::~NetworkInput()
 {
+    kernel->interrupt->WatchNetwork(NULL);
     CloseSocket(sock);
     DeAssignNameToSocket(sockName);
 }
 
+//-----------------------------------------------------------------------
+// NetworkInput::Signal
+// 	The host's signal handler, for when a packet arrives.  It may
+//	run at any time, so it only notes that one has: the interrupt
+//	simulation looks (see Interrupt::CheckIfDue).
+//-----------------------------------------------------------------------
+
+void
+NetworkInput::Signal(int sig)
+{
+    signalled = 1;
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::Notice
+// 	A packet may have arrived: have the receive interrupt, if it
+//	isn't already due, go off on the next tick.
+//-----------------------------------------------------------------------
+
+void
+NetworkInput::Notice()
+{
+    signalled = 0;
+    if (!checkPending) {
+	checkPending = TRUE;
+	kernel->interrupt->Schedule(this, 1, NetworkRecvInt);
+    }
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::WaitForPacket
+// 	Wait, in host time, for a packet to arrive: up to "ticks" times
+//	IdleTickMicros, or for ever if "ticks" is negative.  Return TRUE
+//	if one may have.  Only the interrupt simulation calls this, when
+//	the machine is idle.
+//-----------------------------------------------------------------------
+
+bool
+NetworkInput::WaitForPacket(int ticks)
+{
+    return WaitForSocket(sock, (ticks < 0) ? -1 : ticks * IdleTickMicros);
+}
+
 //-----------------------------------------------------------------------
 // NetworkInput::CallBack
 //	Simulator calls this when a packet may be available to
@@ -55,34 +106,44 @@ NetworkInput::~NetworkInput()
 //      First check to make sure packet is available & there's space to
 //	pull it in.  Then invoke the "callBack" registered by whoever 
 //	wants the packet.
+//
+//	We look again after NetworkTime only if there may be something
+//	to read then: a packet still buffered, or more waiting behind
+//	the one read.  Otherwise we wait for the host's signal.
 //-----------------------------------------------------------------------
 
 void
 NetworkInput::CallBack()
 {
-    // schedule the next time to poll for a packet
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    HostPhase phase(HostIO);
+
+    checkPending = FALSE;
+    if (polling || packetAvail) {	// schedule the next time to poll
+	checkPending = TRUE;
+	kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    }
 
-    if (inHdr.length != 0) 	// do nothing if packet is already buffered
+    if (packetAvail) 		// do nothing if packet is already buffered
 	return;		
     if (!PollSocket(sock)) 	// do nothing if no packet to be read
 	return;
 
-    // otherwise, read packet in
-    char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
-
-    // divide packet into header and data
-    inHdr = *(PacketHeader *)buffer;
+    // otherwise, read packet in, header and data where they will stay
+    ReadFromSocket(sock, wire, MaxWireSize);
+    inHdr = *(PacketHeader *)wire;
     ASSERT((inHdr.to == kernel->hostName) && (inHdr.length <= MaxPacketSize));
-    bcopy(buffer + sizeof(PacketHeader), inbox, inHdr.length);
-    delete [] buffer ;
+    packetAvail = TRUE;
 
     DEBUG(dbgNet, "Network received packet from " << inHdr.from << ", length " << inHdr.length);
     kernel->stats->numPacketsRecvd++;
 
     // tell post office that the packet has arrived
     callWhenAvail->CallBack();
+
+    if (!checkPending && PollSocket(sock)) {	// another is behind it
+	checkPending = TRUE;
+	kernel->interrupt->Schedule(this, NetworkTime, NetworkRecvInt);
+    }
 }
 
 //-----------------------------------------------------------------------
@@ -96,21 +157,59 @@ NetworkInput::Receive(char* data)
     PacketHeader hdr = inHdr;
 
     inHdr.length = 0;
-    if (hdr.length != 0) {
-    	bcopy(inbox, data, hdr.length);
+    if (packetAvail) {
+    	bcopy(wire + sizeof(PacketHeader), data, hdr.length);
+	packetAvail = FALSE;
     }
     return hdr;
 }
 
+//-----------------------------------------------------------------------
+// NetworkInput::Post
+// 	Have the next packet read straight into "buffer", which has room
+//	for MaxWireSize bytes, rather than into our inbox, so that it
+//	needn't be copied out of it.  Nothing must be waiting in the
+//	inbox.
+//-----------------------------------------------------------------------
+
+void
+NetworkInput::Post(char *buffer)
+{
+    ASSERT(!packetAvail);
+    wire = buffer;
+}
+
+//-----------------------------------------------------------------------
+// NetworkInput::Take
+// 	Return the posted buffer, with the packet that arrived in it:
+//	its PacketHeader, then its data.  Until another buffer is
+//	posted, packets are read into our inbox.
+//-----------------------------------------------------------------------
+
+char *
+NetworkInput::Take()
+{
+    char *full = wire;
+
+    ASSERT(packetAvail && wire != inbox);
+    packetAvail = FALSE;
+    inHdr.length = 0;
+    wire = inbox;
+    return full;
+}
+
 //-----------------------------------------------------------------------
 // NetworkOutput::NetworkOutput
 // 	Initialize the simulation for sending network packets
 //
 //   	"reliability" says whether we drop packets to emulate unreliable links
 //   	"toCall" is the interrupt handler to call when next packet can be sent
+//	"linkFile" is where the latency and bandwidth of each link are
+//		given, or NULL if they are all the default
 //-----------------------------------------------------------------------
 
-NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
+NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall,
+			     char *linkFile)
 {
     if (reliability < 0) chanceToWork = 0;
     else if (reliability > 1) chanceToWork = 1;
@@ -120,6 +219,86 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
     callWhenDone = toCall;
     sendBusy = FALSE;
     sock = OpenSocket();
+    io = NULL;
+    if (kernel->hostIO) {
+	io = new HostIOQueue();
+    }
+
+    for (int i = 0; i < MaxNetworkHosts; i++) {
+	latency[i] = bandwidth[i] = 0;
+    }
+    if (linkFile != NULL) {
+	ReadLinks(linkFile);
+    }
+}
+
+//-----------------------------------------------------------------------
+// IsHost
+// 	Return TRUE if "name", from a link file, is machine "host": its
+//	number, or "*".
+//-----------------------------------------------------------------------
+
+static bool
+IsHost(char *name, int host)
+{
+    return strcmp(name, "*") == 0 || atoi(name) == host;
+}
+
+//-----------------------------------------------------------------------
+// NetworkOutput::ReadLinks
+// 	Read the latency and bandwidth of our links from "linkFile".
+//	Each line is
+//
+//		<machine> <machine> <latency> <bandwidth>
+//
+//	for the link between two machines, either way; "*" for a machine
+//	is any machine, and a later line overrides an earlier one.  The
+//	latency is in ticks, the bandwidth in bytes per 1000 ticks (0 for
+//	the default, NetworkTime per packet).  A "#" starts a comment.
+//
+//	Every machine of a run reads the same file, and keeps the links
+//	it sends on; so each sees the same link to another as the other
+//	does to it.
+//-----------------------------------------------------------------------
+
+void
+NetworkOutput::ReadLinks(char *linkFile)
+{
+    FILE *fp;
+    char line[256], a[16], b[16], *comment;
+    int lat, bw, me = kernel->hostName;
+
+    if ((fp = fopen(linkFile, "r")) == NULL) {
+	cerr << "Can't open link file " << linkFile << "\n";
+	Abort();
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	if ((comment = strchr(line, '#')) != NULL) {
+	    *comment = '\0';
+	}
+	if (sscanf(line, "%15s", a) != 1) {
+	    continue;			// blank, or only a comment
+	}
+	if (sscanf(line, "%15s %15s %d %d", a, b, &lat, &bw) != 4
+		|| lat < 0 || bw < 0) {
+	    cerr << "Bad link in " << linkFile << ": " << line << "\n";
+	    Abort();
+	}
+	for (int other = 0; other < MaxNetworkHosts; other++) {
+	    if ((IsHost(a, me) && IsHost(b, other))
+		    || (IsHost(b, me) && IsHost(a, other))) {
+		latency[other] = lat;
+		bandwidth[other] = bw;
+	    }
+	}
+    }
+    fclose(fp);
+    for (int other = 0; other < MaxNetworkHosts; other++) {
+	if (latency[other] != 0 || bandwidth[other] != 0) {
+	    DEBUG(dbgNet, "Link to " << other << ": latency " << latency[other]
+		  << ", bandwidth " << bandwidth[other]);
+	}
+    }
 }
 
 //-----------------------------------------------------------------------
@@ -129,6 +308,7 @@ NetworkOutput::NetworkOutput(double reliability, CallBackObj *toCall)
 
 NetworkOutput::~NetworkOutput()
 {
+    delete io;				// after the last is sent
     CloseSocket(sock);
 }
 
@@ -158,25 +338,95 @@ NetworkOutput::CallBack()
 void
 NetworkOutput::Send(PacketHeader hdr, char* data)
 {
-    char toName[32];
+    char buffer[MaxWireSize];
+
+    // concatenate hdr and data into a single buffer, and send it out
+    *(PacketHeader *)buffer = hdr;
+    bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
+    Send(buffer);
+}
+
+//-----------------------------------------------------------------------
+// NetworkOutput::Send
+// 	Send a packet that is laid out as it goes on the wire: a
+//	PacketHeader, then the data, padded out to MaxWireSize.  The
+//	sender builds it in place, so it isn't copied again.
+//
+//	Sending takes NetworkTime, or as long as the link's bandwidth
+//	needs for the packet's bytes; it arrives the link's latency
+//	after that.  Until then it is kept in an InFlight -- and only
+//	then, if there is a latency, copied.
+//-----------------------------------------------------------------------
+
+void
+NetworkOutput::Send(char *packet)
+{
+    PacketHeader hdr = *(PacketHeader *)packet;
+    int sendTime = NetworkTime;
 
-    sprintf(toName, "SOCKET_%d", (int)hdr.to);
-    
     ASSERT((sendBusy == FALSE) && (hdr.length > 0) && 
-	(hdr.length <= MaxPacketSize) && (hdr.from == kernel->hostName));
+	(hdr.length <= MaxPacketSize) && (hdr.from == kernel->hostName)
+	&& (hdr.to < MaxNetworkHosts));
     DEBUG(dbgNet, "Sending to addr " << hdr.to << ", length " << hdr.length);
 
-    kernel->interrupt->Schedule(this, NetworkTime, NetworkSendInt);
+    if (bandwidth[hdr.to] > 0) {
+	sendTime = max(1, (int) ((sizeof(PacketHeader) + hdr.length) * 1000
+				 / bandwidth[hdr.to]));
+    }
+    kernel->interrupt->Schedule(this, sendTime, NetworkSendInt);
 
-    if (RandomNumber() % 100 >= chanceToWork * 100) { // emulate a lost packet
+    if (kernel->replay->Random(ReplayNetwork) % 100 >= chanceToWork * 100) { // emulate a lost packet
 	DEBUG(dbgNet, "oops, lost it!");
 	return;
     }
+    if (latency[hdr.to] > 0) {
+	kernel->interrupt->Schedule(new InFlight(this, packet),
+				    sendTime + latency[hdr.to],
+				    NetworkDeliverInt);
+    } else {
+	Put(packet);
+    }
+}
 
-    // concatenate hdr and data into a single buffer, and send it out
-    char *buffer = new char[MaxWireSize];
-    *(PacketHeader *)buffer = hdr;
-    bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
-    delete [] buffer;
+//-----------------------------------------------------------------------
+// NetworkOutput::Put
+// 	Write a packet into the socket of the machine it is to.
+//-----------------------------------------------------------------------
+
+void
+NetworkOutput::Put(char *packet)
+{
+    char toName[32];
+    HostPhase phase(HostIO);
+
+    sprintf(toName, "SOCKET_%d", (int)((PacketHeader *)packet)->to);
+    if (io != NULL) {
+	(void) io->Send(sock, packet, MaxWireSize, toName);
+    } else {
+	SendToSocket(sock, packet, MaxWireSize, toName);
+    }
+}
+
+//-----------------------------------------------------------------------
+// InFlight::InFlight
+// 	Keep a copy of a packet "net" is sending, until it arrives.
+//-----------------------------------------------------------------------
+
+InFlight::InFlight(NetworkOutput *net, char *packet)
+{
+    network = net;
+    bcopy(packet, wire, MaxWireSize);
+}
+
+//-----------------------------------------------------------------------
+// InFlight::CallBack
+// 	The packet arrives: write it into the receiver's socket, and
+//	we are done with it.
+//-----------------------------------------------------------------------
+
+void
+InFlight::CallBack()
+{
+    network->Put(wire);
+    delete this;
 }
@@ -18,6 +18,7 @@
 #include "copyright.h"
 #include "utility.h"
 #include "callback.h"
+#include "hostio.h"
 
 // Network address -- uniquely identifies a machine.  This machine's ID 
 //  is given on the command line.
@@ -43,6 +44,10 @@ class PacketHeader {
 				// data "payload" of the largest packet
 
 
+const int MaxNetworkHosts = 64;	// machines a run can have: 0 and up
+const int IdleTickMicros = 10;	// host time an idle machine lets go by
+				// per tick, while the network is up
+
 // The following two classes defines a physical network device.  The network
 // is capable of delivering fixed sized packets, in order but unreliably, 
 // to other machines connected to the network.
@@ -52,6 +57,25 @@ class PacketHeader {
 // a packet.  Note that you can change the seed for the random number 
 // generator, by changing the arguments to RandomInit() in Initialize().
 // The random number generator is used to choose which packets to drop.
+//
+// Arriving packets aren't polled for on every NetworkTime: the host
+// signals us when one comes (see CallOnSocketInput), and only then is
+// the receive interrupt scheduled.  While nothing is ready to run, the
+// machine waits for a packet in host time (see Interrupt::Idle), so
+// that the machines of a run -- any number of them, each a Nachos
+// process with its own -m -- keep roughly in step.  Where the host
+// can't signal, we poll as before.
+//
+// Each link, from us to another machine, has a latency and a bandwidth
+// (see NetworkOutput::ReadLinks); by default a packet takes NetworkTime
+// to send, and arrives as soon as it is sent.
+//
+// With "-aio", packets are written into the sockets by a host thread
+// (see hostio.h), from copies, so that the machine doesn't wait while
+// the host sends one -- or tries again and again to, if the machine it
+// is to isn't up yet.  A send isn't waited for: once handed over, the
+// packet is on the wire.  Arriving packets are read as before; the
+// host has them ready by the time we read them.
 
 class NetworkInput : public CallBackObj{
   public:
@@ -66,10 +90,30 @@ class NetworkInput : public CallBackObj{
 				// If no packet is waiting, return a header 
 				// with length 0.
 
+    void Post(char *buffer);	// Read the next packet straight into
+				// "buffer", MaxWireSize bytes, header
+				// and all, instead of our own
+    char *Take();		// Hand back the posted buffer, with the
+				// packet that has arrived in it; the
+				// next is read into our own, until
+				// another buffer is posted
+
     void CallBack();		// A packet may have arrived.
 
+    bool Signalled() { return signalled != 0; }
+				// The host says a packet has arrived
+    void Notice();		// So look for it soon
+    bool WaitForPacket(int ticks);
+				// Wait up to "ticks" worth of host time
+				// (forever, if < 0) for a packet
+
   private:
     int sock;                   // UNIX socket number for incoming packets
+    bool polling;		// The host can't signal us: poll every
+				//   NetworkTime
+    bool checkPending;		// The receive interrupt is scheduled
+    static volatile int signalled;	// Set by the host's signal
+    static void Signal(int sig);	// Its handler
     char sockName[32];          // File name corresponding to UNIX socket
 
     CallBackObj *callWhenAvail; // Interrupt handler, signalling packet has 
@@ -77,12 +121,16 @@ class NetworkInput : public CallBackObj{
     bool packetAvail;		// Packet has arrived, can be pulled off of
 				//   network
     PacketHeader inHdr;		// Information about arrived packet
-    char inbox[MaxPacketSize];  // Data for arrived packet
+    char inbox[MaxWireSize];	// Arrived packet, as it was on the wire,
+				//   unless a buffer is posted
+    char *wire;			// Where the next packet goes: inbox, or
+				//   the posted buffer
 };
 
 class NetworkOutput : public CallBackObj {
   public:
-    NetworkOutput(double reliability, CallBackObj *toCall);
+    NetworkOutput(double reliability, CallBackObj *toCall,
+		  char *linkFile);
 				// Allocate and initialize network output driver
     ~NetworkOutput();		// De-allocate the network input driver data
     
@@ -96,15 +144,47 @@ class NetworkOutput : public CallBackObj {
 				// the PacketHeader is filled in automatically 
 				// by Send().
 
+    void Send(char *packet);	// Send a packet that is already as it
+				// goes on the wire: MaxWireSize bytes,
+				// starting with its PacketHeader, which
+				// is as Send would fill it in
+
+    void ReadLinks(char *linkFile);
+				// Set the latency and bandwidth of our
+				// links from a file
+
     void CallBack();		// Interrupt handler, called when message is 
 				// sent
 
   private:
+    void Put(char *packet);	// Put a packet on the wire, now
+
+    int latency[MaxNetworkHosts];	// ticks from when a packet to each
+				//   machine is sent until it arrives
+    int bandwidth[MaxNetworkHosts];	// bytes per 1000 ticks, or 0 to
+				//   take NetworkTime per packet
     int sock;                   // UNIX socket number for outgoing packets
     double chanceToWork;	// Likelihood packet will be dropped
     CallBackObj *callWhenDone;  // Interrupt handler, signalling next packet 
 				//      can be sent.  
     bool sendBusy;		// Packet is being sent.
+    HostIOQueue *io;		// what puts them on the wire, or NULL
+
+    friend class InFlight;
+};
+
+// A packet on its way over a link with latency: it is put on the wire
+// when it would arrive.
+
+class InFlight : public CallBackObj {
+  public:
+    InFlight(NetworkOutput *net, char *packet);
+
+    void CallBack();		// It has arrived: send it, and delete it
+
+  private:
+    NetworkOutput *network;
+    char wire[MaxWireSize];
 };
 
 #endif // NETWORK_H
@@ -0,0 +1,288 @@
+// profdump.cc
+//	Program to print the user program profiles written by
+//	"nachos -pp <file>".
+//
+//	Usage: profdump [-n <count>] <profile file> [<symbol file>]
+//
+//	For each program, prints how many instructions it executed, the
+//	share of loads, stores and branches, how often its conditional
+//	branches were taken, its opcode mix, and its <count> (by default
+//	20) most executed instructions.
+//
+//	The symbol file is what "nm -n" prints for the COFF file the
+//	program was made from (in test/, for example,
+//	"decstation-ultrix-nm -n sort.coff > sort.sym"): an address, a
+//	type and a name on each line.  Given one, each
+//	address is printed as routine+offset, and the instructions each
+//	routine executed are totalled too.  Nachos loads the NOFF file
+//	at the addresses COFF gives it, so they are the same.
+//
+//	This runs on the host, outside of Nachos; see profile.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "utility.h"
+#include "profile.h"
+#include "mipssim.h"
+
+const int MaxSymbols = 4096;		// routines kept from a symbol file
+
+class Symbol {
+  public:
+    int address;
+    char name[ProfileNameSize];
+    int count;			// instructions executed in this routine,
+				// for the profile being printed
+};
+
+static Symbol symbols[MaxSymbols];	// in address order
+static int numSymbols = 0;
+
+//----------------------------------------------------------------------
+// ReadSymbols
+// 	Read the text symbols from an "nm -n" listing.  Other symbols
+//	(data, bss, undefined) are skipped.
+//----------------------------------------------------------------------
+
+static void
+ReadSymbols(char *fileName)
+{
+    FILE *fp;
+    char line[256], type;
+    unsigned int address;
+
+    if ((fp = fopen(fileName, "r")) == NULL) {
+        cerr << "profdump: can't open " << fileName << "\n";
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), fp) != NULL && numSymbols < MaxSymbols) {
+        Symbol *s = &symbols[numSymbols];
+
+        if (sscanf(line, "%x %c %63s", &address, &type, s->name) == 3
+                && (type == 'T' || type == 't')) {
+            s->address = address;
+            if (numSymbols == 0 || s->address >= symbols[numSymbols - 1].address) {
+                numSymbols++;
+            }				// -n sorts them; if not, keep what's
+        }				// in order
+    }
+    fclose(fp);
+}
+
+//----------------------------------------------------------------------
+// SymbolFor
+// 	Return the routine "pc" is in: the last symbol at or below it,
+//	or NULL if there is none.
+//----------------------------------------------------------------------
+
+static Symbol *
+SymbolFor(int pc)
+{
+    int low = 0, high = numSymbols - 1;
+
+    if (numSymbols == 0 || pc < symbols[0].address) {
+        return NULL;
+    }
+    while (low < high) {		// the last address <= pc
+        int middle = (low + high + 1) / 2;
+
+        if (symbols[middle].address <= pc) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return &symbols[low];
+}
+
+//----------------------------------------------------------------------
+// OpName
+// 	Return the name of an opcode: the first word of the format
+//	Nachos prints it with under "-d m".
+//----------------------------------------------------------------------
+
+static const char *
+OpName(int opCode)
+{
+    static char name[16];
+
+    if (opCode < 0 || opCode > MaxOpcode) {
+        return "?";
+    }
+    sscanf(opStrings[opCode].format, "%15s", name);
+    return name;
+}
+
+//----------------------------------------------------------------------
+// Percent
+// 	Print "part" as a percentage of "whole".
+//----------------------------------------------------------------------
+
+static void
+Percent(int part, int whole)
+{
+    char buf[16];
+
+    sprintf(buf, "%5.1f%%", (whole > 0) ? 100.0 * part / whole : 0.0);
+    cout << buf;
+}
+
+//----------------------------------------------------------------------
+// PrintProfile
+// 	Print a program's profile, and its "top" most executed
+//	instructions.
+//----------------------------------------------------------------------
+
+static void
+PrintProfile(ProfileHeader *h, ProfileSite *sites, int top)
+{
+    int loads, stores, branches, taken = 0;
+    int order[ProfileNumOpCodes];
+    char buf[160];
+    int i, j;
+
+    loads = h->opCounts[OP_LB] + h->opCounts[OP_LBU] + h->opCounts[OP_LH]
+        + h->opCounts[OP_LHU] + h->opCounts[OP_LW] + h->opCounts[OP_LWL]
+        + h->opCounts[OP_LWR];
+    stores = h->opCounts[OP_SB] + h->opCounts[OP_SH] + h->opCounts[OP_SW]
+        + h->opCounts[OP_SWL] + h->opCounts[OP_SWR];
+    branches = h->opCounts[OP_BEQ] + h->opCounts[OP_BNE]
+        + h->opCounts[OP_BGEZ] + h->opCounts[OP_BGEZAL]
+        + h->opCounts[OP_BGTZ] + h->opCounts[OP_BLEZ]
+        + h->opCounts[OP_BLTZ] + h->opCounts[OP_BLTZAL];
+    for (i = 0; i < h->numSites; i++) {
+        switch (sites[i].opCode) {
+          case OP_BEQ: case OP_BNE: case OP_BGEZ: case OP_BGEZAL:
+          case OP_BGTZ: case OP_BLEZ: case OP_BLTZ: case OP_BLTZAL:
+            taken += sites[i].taken;
+            break;
+        }
+    }
+
+    cout << "Program " << h->name << ", thread " << h->threadID << ": "
+         << h->numInstructions << " instructions, at " << h->numSites
+         << " addresses\n";
+    cout << "  loads " << loads << " (";
+    Percent(loads, h->numInstructions);
+    cout << "), stores " << stores << " (";
+    Percent(stores, h->numInstructions);
+    cout << "), branches " << branches << " (";
+    Percent(branches, h->numInstructions);
+    cout << "), taken " << taken << " (";
+    Percent(taken, branches);
+    cout << ")\n";
+
+    cout << "Opcodes:\n";
+    for (i = 0; i < ProfileNumOpCodes; i++) {	// by count, most first
+        for (j = i; j > 0 && h->opCounts[order[j - 1]] < h->opCounts[i]; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = i;
+    }
+    for (i = 0; i < ProfileNumOpCodes && h->opCounts[order[i]] > 0; i++) {
+        sprintf(buf, "  %-8s %10d  ", OpName(order[i]), h->opCounts[order[i]]);
+        cout << buf;
+        Percent(h->opCounts[order[i]], h->numInstructions);
+        cout << "\n";
+    }
+
+    if (numSymbols > 0) {
+        cout << "Routines:\n";
+        for (i = 0; i < numSymbols; i++) {
+            symbols[i].count = 0;
+        }
+        for (i = 0; i < h->numSites; i++) {
+            Symbol *s = SymbolFor(sites[i].pc);
+
+            if (s != NULL) {
+                s->count += sites[i].count;
+            }
+        }
+        for (i = 0; i < numSymbols; i++) {
+            if (symbols[i].count > 0) {
+                sprintf(buf, "  %-24s %10d  ", symbols[i].name,
+                        symbols[i].count);
+                cout << buf;
+                Percent(symbols[i].count, h->numInstructions);
+                cout << "\n";
+            }
+        }
+    }
+
+    cout << "Hot spots:\n";
+    for (i = 0; i < min(top, h->numSites); i++) {	// the top ones
+        for (j = i + 1; j < h->numSites; j++) {		// to the front
+            if (sites[j].count > sites[i].count) {
+                ProfileSite tmp = sites[i];
+
+                sites[i] = sites[j];
+                sites[j] = tmp;
+            }
+        }
+        Symbol *s = SymbolFor(sites[i].pc);
+        char where[ProfileNameSize + 16];
+
+        if (s != NULL) {
+            sprintf(where, "%s+0x%x", s->name, sites[i].pc - s->address);
+        } else {
+            where[0] = '\0';
+        }
+        sprintf(buf, "  0x%06x %-28s %-8s %10d  ", sites[i].pc, where,
+                OpName(sites[i].opCode), sites[i].count);
+        cout << buf;
+        Percent(sites[i].count, h->numInstructions);
+        if (sites[i].taken > 0) {
+            cout << "  taken ";
+            Percent(sites[i].taken, sites[i].count);
+        }
+        cout << "\n";
+    }
+    cout << "\n";
+}
+
+int
+main(int argc, char **argv)
+{
+    int top = 20;
+    int arg = 1;
+    FILE *fp;
+    ProfileHeader header;
+    ProfileSite *sites;
+
+    if (arg + 1 < argc && strcmp(argv[arg], "-n") == 0) {
+        top = atoi(argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg < 1 || argc - arg > 2) {
+        cerr << "Usage: profdump [-n <count>] <profile file> [<symbol file>]\n";
+        exit(1);
+    }
+    if ((fp = fopen(argv[arg], "rb")) == NULL) {
+        cerr << "profdump: can't open " << argv[arg] << "\n";
+        exit(1);
+    }
+    if (argc - arg == 2) {
+        ReadSymbols(argv[arg + 1]);
+    }
+
+    while (fread(&header, sizeof(header), 1, fp) == 1) {
+        if (header.magic != ProfileMagic || header.numSites < 0) {
+            cerr << "profdump: " << argv[arg] << " is not a Nachos profile\n";
+            exit(1);
+        }
+        header.name[ProfileNameSize - 1] = '\0';
+        sites = new ProfileSite[max(header.numSites, 1)];
+        if (fread(sites, sizeof(ProfileSite), header.numSites, fp)
+                != (size_t) header.numSites) {
+            cerr << "profdump: " << argv[arg] << " is cut short\n";
+            exit(1);
+        }
+        PrintProfile(&header, sites, top);
+        delete [] sites;
+    }
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,141 @@
+// profile.cc
+//	Routines to collect the profile of each user program, and write
+//	it out for profdump.  See profile.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "profile.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// ProgramProfile::ProgramProfile
+// 	Initialize the profile of a program about to run, with nothing
+//	executed yet.
+//
+//	"threadID" is the thread running it.
+//	"programName" is the file it was loaded from.
+//	"size" is the bytes of its address space.
+//----------------------------------------------------------------------
+
+ProgramProfile::ProgramProfile(int threadID, char *programName, int size)
+{
+    header.magic = ProfileMagic;
+    header.threadID = threadID;
+    strncpy(header.name, programName, ProfileNameSize - 1);
+    header.name[ProfileNameSize - 1] = '\0';
+    header.numInstructions = 0;
+    header.numSites = 0;
+    for (int i = 0; i < ProfileNumOpCodes; i++) {
+	header.opCounts[i] = 0;
+    }
+    numWords = size / 4;
+    counts = new int[numWords];
+    takenCounts = new int[numWords];
+    opCodes = new char[numWords];
+    for (unsigned int i = 0; i < numWords; i++) {
+	counts[i] = 0;
+	takenCounts[i] = 0;
+	opCodes[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// ProgramProfile::~ProgramProfile
+// 	De-allocate the profile.
+//----------------------------------------------------------------------
+
+ProgramProfile::~ProgramProfile()
+{
+    delete [] counts;
+    delete [] takenCounts;
+    delete [] opCodes;
+}
+
+//----------------------------------------------------------------------
+// ProgramProfile::Write
+// 	Append the profile to the file "fd": the header, with the
+//	totals filled in, then a record for each instruction that was
+//	executed.
+//----------------------------------------------------------------------
+
+void
+ProgramProfile::Write(int fd)
+{
+    ProfileSite *sites;
+    int n = 0;
+
+    header.numInstructions = 0;
+    for (int i = 0; i < ProfileNumOpCodes; i++) {
+	header.numInstructions += header.opCounts[i];
+    }
+    header.numSites = 0;
+    for (unsigned int i = 0; i < numWords; i++) {
+	if (counts[i] > 0) {
+	    header.numSites++;
+	}
+    }
+    sites = new ProfileSite[max(header.numSites, 1)];
+    for (unsigned int i = 0; i < numWords; i++) {
+	if (counts[i] > 0) {
+	    sites[n].pc = i * 4;
+	    sites[n].opCode = opCodes[i];
+	    sites[n].count = counts[i];
+	    sites[n].taken = takenCounts[i];
+	    n++;
+	}
+    }
+    WriteFile(fd, (char *) &header, sizeof(header));
+    WriteFile(fd, (char *) sites, header.numSites * sizeof(ProfileSite));
+    delete [] sites;
+}
+
+//----------------------------------------------------------------------
+// Profiler::Profiler
+// 	Create the profile file; the profiles are appended as the
+//	programs finish.
+//----------------------------------------------------------------------
+
+Profiler::Profiler(char *profileFile)
+{
+    fd = OpenForWrite(profileFile);
+}
+
+//----------------------------------------------------------------------
+// Profiler::~Profiler
+// 	Nachos is halting; close the file.
+//----------------------------------------------------------------------
+
+Profiler::~Profiler()
+{
+    Close(fd);
+}
+
+//----------------------------------------------------------------------
+// Profiler::Start
+// 	Return a new profile for a program that is starting to run.
+//
+//	"threadID" is the thread running it.
+//	"programName" is the file it was loaded from.
+//	"size" is the bytes of its address space.
+//----------------------------------------------------------------------
+
+ProgramProfile *
+Profiler::Start(int threadID, char *programName, int size)
+{
+    return new ProgramProfile(threadID, programName, size);
+}
+
+//----------------------------------------------------------------------
+// Profiler::Finish
+// 	A program has finished; write out its profile, and delete it.
+//----------------------------------------------------------------------
+
+void
+Profiler::Finish(ProgramProfile *profile)
+{
+    profile->Write(fd);
+    delete profile;
+}
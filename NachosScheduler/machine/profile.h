@@ -0,0 +1,119 @@
+// profile.h
+//	Data structures for the user program profiler.
+//
+//	With "-pp <file>", the simulator counts every instruction each
+//	user program executes: how many of each opcode (and so how many
+//	loads, stores and branches), how many times each instruction was
+//	executed, and how many times each branch or jump was taken.  When
+//	the program's thread finishes, its counts are appended to the
+//	file; so the file holds one profile per program, in the order
+//	they finished.  A program still running when Nachos halts is
+//	not written.
+//
+//	Each profile is a ProfileHeader, followed by a ProfileSite for
+//	every instruction that was executed at least once, in address
+//	order; instructions never executed take no room.
+//
+//	profdump (machine/profdump.cc, "make profdump") prints the
+//	profiles; given the symbols of the program (what the cross
+//	compiler's nm prints for its COFF file), it also maps each
+//	address back to the routine it is in.
+//
+//	The block engine (-bb) does not count instructions, so it is not
+//	used for a program being profiled.
+//
+//	This header is shared with profdump, so it must not depend on
+//	the rest of Nachos.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "copyright.h"
+#include "sysdep.h"
+
+const int ProfileMagic = 0x4e505031;	// "NPP1", at the start of each
+					// profile
+const int ProfileNameSize = 64;		// room for the program name
+const int ProfileNumOpCodes = 64;	// more than MaxOpcode (mipssim.h),
+					// which this doesn't include, since
+					// that defines tables
+
+// The start of one program's profile, as it appears in the file.
+
+class ProfileHeader {
+  public:
+    int magic;
+    int threadID;		// the thread that ran it
+    char name[ProfileNameSize];	// its file name, cut short if need be
+    int numInstructions;	// executed in all
+    int numSites;		// ProfileSites that follow
+    int opCounts[ProfileNumOpCodes];	// executed, by opCode
+};
+
+// One instruction of the program, as it appears in the file.
+
+class ProfileSite {
+  public:
+    int pc;			// its virtual address
+    int opCode;
+    int count;			// times executed
+    int taken;			// times it went somewhere other than
+				// the next instruction (branches and
+				// jumps only)
+};
+
+// The following class collects the profile of one user program, as
+// it runs.
+
+class ProgramProfile {
+  public:
+    ProgramProfile(int threadID, char *programName, int size);
+				// "size" bytes of address space
+    ~ProgramProfile();
+
+    void Executed(int pc, int opCode, bool taken) {
+	unsigned int word = (unsigned) pc / 4;
+
+	header.opCounts[(int) opCode]++;
+	if (word < numWords) {		// PCs outside the address space
+	    counts[word]++;		// fault before they get here, but
+	    if (taken) {		// don't count on it
+		takenCounts[word]++;
+	    }
+	    opCodes[word] = opCode;
+	}
+    }				// the instruction at "pc" was executed
+
+    void Write(int fd);		// append the profile to a file
+
+  private:
+    ProfileHeader header;
+    unsigned int numWords;	// instructions the address space holds
+    int *counts;		// times each was executed
+    int *takenCounts;		// and taken
+    char *opCodes;		// the opCode of each, as last executed
+};
+
+// The following class writes the profiles of all the programs to the
+// "-pp" file.
+
+class Profiler {
+  public:
+    Profiler(char *profileFile);	// create the file
+    ~Profiler();			// close it
+
+    ProgramProfile *Start(int threadID, char *programName, int size);
+					// a program is starting to run
+    void Finish(ProgramProfile *profile);
+					// write out and delete the profile
+					// of a program that has finished
+
+  private:
+    int fd;			// the profile file
+};
+
+#endif // PROFILE_H
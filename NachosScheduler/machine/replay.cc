@@ -0,0 +1,218 @@
+// replay.cc
+//	Routines to record the random numbers and interrupts of a run of
+//	Nachos, and to replay them.  See replay.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "replay.h"
+#include "interrupt.h"
+#include "main.h"
+
+static char *replaySourceNames[NumReplaySources] =
+    { "timer", "network", "lottery" };
+
+//----------------------------------------------------------------------
+// ReplayLog::ReplayLog
+// 	Get ready to record a run, or to replay one.
+//
+//	"recordFile" is the log to create, or NULL.
+//	"replayFile" is the log to replay, or NULL.
+//----------------------------------------------------------------------
+
+ReplayLog::ReplayLog(char *recordFile, char *replayFile)
+{
+    ASSERT(recordFile == NULL || replayFile == NULL);
+    replaying = FALSE;
+    fd = -1;
+    buffer = NULL;
+    numBuffered = 0;
+    for (int k = 0; k <= NumReplaySources; k++) {
+        streams[k] = NULL;
+        streamLength[k] = streamNext[k] = 0;
+    }
+
+    if (recordFile != NULL) {
+        int magic = ReplayMagic;
+
+        fd = OpenForWrite(recordFile);
+        WriteFile(fd, (char *) &magic, sizeof(magic));
+        buffer = new ReplayRecord[ReplayBufferSize];
+    } else if (replayFile != NULL) {
+        Load(replayFile);
+    }
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::~ReplayLog
+// 	Nachos is halting; finish the log we are recording.
+//----------------------------------------------------------------------
+
+ReplayLog::~ReplayLog()
+{
+    if (fd >= 0) {
+        Dump();
+        Close(fd);
+    }
+    delete [] buffer;
+    for (int k = 0; k <= NumReplaySources; k++) {
+        delete [] streams[k];
+    }
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::Load
+// 	Read in the log to replay, sorting the records by kind, so that
+//	each random source and the interrupts can be replayed in order
+//	independently of each other.
+//----------------------------------------------------------------------
+
+void
+ReplayLog::Load(char *replayFile)
+{
+    int logFd = OpenForReadWrite(replayFile, TRUE);
+    int magic = 0, fileSize, numRecords;
+    ReplayRecord *records;
+
+    Lseek(logFd, 0, 2);
+    fileSize = Tell(logFd);
+    Lseek(logFd, 0, 0);
+    numRecords = (fileSize - (int) sizeof(magic)) / (int) sizeof(ReplayRecord);
+    if (fileSize < (int) sizeof(magic) ||
+          ReadPartial(logFd, (char *) &magic, sizeof(magic)) != sizeof(magic)
+          || magic != ReplayMagic) {
+        cout << "Replay: " << replayFile << " is not a replay log\n";
+        Close(logFd);
+        return;
+    }
+    records = new ReplayRecord[numRecords];
+    Read(logFd, (char *) records, numRecords * sizeof(ReplayRecord));
+    Close(logFd);
+
+    for (int i = 0; i < numRecords; i++) {
+        ASSERT(records[i].kind <= NumReplaySources);
+        streamLength[records[i].kind]++;
+    }
+    for (int k = 0; k <= NumReplaySources; k++) {
+        streams[k] = new ReplayRecord[streamLength[k]];
+    }
+    for (int i = 0; i < numRecords; i++) {
+        int k = records[i].kind;
+
+        streams[k][streamNext[k]++] = records[i];
+    }
+    for (int k = 0; k <= NumReplaySources; k++) {
+        streamNext[k] = 0;
+    }
+    delete [] records;
+    replaying = TRUE;
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::Random
+// 	Return a pseudo-random number: when replaying, the next one this
+//	source drew when the log was recorded; otherwise a new one, which
+//	is logged if we are recording.
+//
+//	"source" is who wants it.
+//----------------------------------------------------------------------
+
+unsigned int
+ReplayLog::Random(ReplaySource source)
+{
+    unsigned int number;
+
+    if (replaying) {
+        if (streamNext[source] < streamLength[source]) {
+            return streams[source][streamNext[source]++].value;
+        }
+        cout << "Replay: the " << replaySourceNames[source]
+             << " has drawn all its logged numbers\n";
+        Diverged("out of numbers");
+    }
+    number = RandomNumber();
+    if (fd >= 0) {
+        Log(source, number, 0);
+    }
+    return number;
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::Fired
+// 	Log an interrupt that has just gone off, or when replaying, move
+//	on to the next interrupt in the log.
+//----------------------------------------------------------------------
+
+void
+ReplayLog::Fired(PendingInterrupt *interrupt)
+{
+    if (replaying) {
+        streamNext[ReplayInterrupt]++;
+    } else if (fd >= 0) {
+        Log(ReplayInterrupt, interrupt->type, interrupt->cpu);
+    }
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::NextInterrupt
+// 	Return the next interrupt to go off according to the log, NULL
+//	if the log has no more.
+//----------------------------------------------------------------------
+
+ReplayRecord *
+ReplayLog::NextInterrupt()
+{
+    if (streamNext[ReplayInterrupt] == streamLength[ReplayInterrupt]) {
+        return NULL;
+    }
+    return &streams[ReplayInterrupt][streamNext[ReplayInterrupt]];
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::Diverged
+// 	Report that the run no longer follows the log, and let it go on
+//	by itself.
+//----------------------------------------------------------------------
+
+void
+ReplayLog::Diverged(char *why)
+{
+    cout << "Replay diverges from the log at tick "
+         << kernel->stats->totalTicks << ": " << why << "\n";
+    replaying = FALSE;
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::Log
+// 	Add a record to the log, writing the buffer out if it is full.
+//----------------------------------------------------------------------
+
+void
+ReplayLog::Log(int kind, int value, int cpu)
+{
+    ReplayRecord *record = &buffer[numBuffered++];
+
+    record->tick = kernel->stats->totalTicks;
+    record->value = value;
+    record->kind = kind;
+    record->cpu = cpu;
+    if (numBuffered == ReplayBufferSize) {
+        Dump();
+    }
+}
+
+//----------------------------------------------------------------------
+// ReplayLog::Dump
+// 	Write the buffered records to the log.
+//----------------------------------------------------------------------
+
+void
+ReplayLog::Dump()
+{
+    if (numBuffered > 0) {
+        WriteFile(fd, (char *) buffer, numBuffered * sizeof(ReplayRecord));
+        numBuffered = 0;
+    }
+}
@@ -0,0 +1,96 @@
+// replay.h
+//	Data structures to record a run of Nachos, and replay it exactly.
+//
+//	The simulation is deterministic except for the pseudo-random
+//	numbers drawn by the timer (with -rs), the network (to drop
+//	packets, with -n) and the lottery scheduler, and for polling the
+//	outside world.  Even the random numbers are only repeatable if
+//	every build draws the same ones in the same order, which stops
+//	being true as soon as the code changes.
+//
+//	With "-rec <file>", every random number drawn and every interrupt
+//	that goes off is logged to <file>, twelve bytes each.  With
+//	"-replay <file>", each source draws the numbers it drew when the
+//	log was recorded, in the same order, and Interrupt::CheckIfDue
+//	delivers interrupts at the ticks in the log rather than when
+//	they were scheduled for.  If the run strays from the log -- the
+//	interrupt logged next isn't pending, or its tick has passed, or
+//	a source wants more numbers than it drew -- that is reported
+//	once, and the rest of the run goes its own way.
+//
+//	The log doesn't hold what was read from the console or the
+//	network, only when the interrupts to read them went off.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "copyright.h"
+#include "utility.h"
+
+const int ReplayMagic = 0x4e525031;	// "NRP1", at the start of the log
+const int ReplayBufferSize = 4096;	// records written at once
+
+// What a record is about: a number drawn by one of the random
+// sources, or an interrupt.
+
+enum ReplaySource { ReplayTimer, ReplayNetwork, ReplayLottery,
+                    NumReplaySources };
+const int ReplayInterrupt = NumReplaySources;
+
+// One record in the log.
+
+class ReplayRecord {
+  public:
+    int tick;			// stats->totalTicks when it happened
+    int value;			// the number drawn, or the IntType
+    unsigned char kind;		// a ReplaySource, or ReplayInterrupt
+    unsigned char cpu;		// the CPU an interrupt went to
+};
+
+class PendingInterrupt;
+
+// The following class records a run, or replays one.
+
+class ReplayLog {
+  public:
+    ReplayLog(char *recordFile, char *replayFile);
+				// record to "recordFile", or replay
+				// "replayFile", or neither if both
+				// are NULL
+    ~ReplayLog();		// write out the rest of the log
+
+    unsigned int Random(ReplaySource source);
+				// a pseudo-random number for "source"
+    void Fired(PendingInterrupt *interrupt);
+				// "interrupt" has just gone off
+
+    bool IsReplaying() { return replaying; }
+    ReplayRecord *NextInterrupt();
+				// the next interrupt in the log, or NULL
+    void Diverged(char *why);	// the run has strayed from the log;
+				// stop replaying
+
+  private:
+    bool replaying;		// drawing numbers and delivering
+				// interrupts from the log?
+    int fd;			// log being recorded, or -1
+    ReplayRecord *buffer;	// records not yet written
+    int numBuffered;
+
+    ReplayRecord *streams[NumReplaySources + 1];
+				// when replaying, the records of each
+				// kind, in order
+    int streamLength[NumReplaySources + 1];
+    int streamNext[NumReplaySources + 1];
+				// the next one of each kind to use
+
+    void Log(int kind, int value, int cpu);	// add a record
+    void Dump();		// write out the buffered records
+    void Load(char *replayFile);	// read in a log to replay
+};
+
+#endif // REPLAY_H
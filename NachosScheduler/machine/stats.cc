@@ -10,18 +10,234 @@
 #include "copyright.h"
 #include "debug.h"
 #include "stats.h"
+#include "main.h"
+
+int RotationTime = 500;
+int SeekTime = 500;
+int ConsoleTime = 100;
+int NetworkTime = 100;
+int TimerTicks = 500;
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize an empty histogram.
+//----------------------------------------------------------------------
+
+Histogram::Histogram()
+{
+    numSamples = 0;
+    for (int i = 0; i < HistogramBuckets; i++) {
+        buckets[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// Histogram::BucketOf
+// 	Return the bucket "value" is counted in.  The top three bits
+//	below the leading one pick the bucket within its power of two.
+//----------------------------------------------------------------------
+
+int
+Histogram::BucketOf(int value)
+{
+    int shift = 0;
+
+    if (value < HistogramSubBuckets) {
+        return (value < 0) ? 0 : value;
+    }
+    while ((value >> shift) >= 2 * HistogramSubBuckets) {
+        shift++;
+    }
+    return HistogramSubBuckets * (shift + 1) + (value >> shift)
+           - HistogramSubBuckets;
+}
+
+//----------------------------------------------------------------------
+// Histogram::BucketTop
+// 	Return the largest value that goes in "bucket".
+//----------------------------------------------------------------------
+
+int
+Histogram::BucketTop(int bucket)
+{
+    if (bucket < HistogramSubBuckets) {
+        return bucket;
+    }
+    int shift = bucket / HistogramSubBuckets - 1;
+    int low = (HistogramSubBuckets + bucket % HistogramSubBuckets) << shift;
+
+    return low + (1 << shift) - 1;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Add
+// 	Count one sample; negative values count as 0.
+//----------------------------------------------------------------------
+
+void
+Histogram::Add(int value)
+{
+    buckets[BucketOf(value)]++;
+    numSamples++;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Percentile
+// 	Return the top of the first bucket by which at least "fraction"
+//	of the samples have been counted, so the result is at most 1/8
+//	bigger than the true percentile.  0 if there are no samples.
+//----------------------------------------------------------------------
+
+int
+Histogram::Percentile(double fraction)
+{
+    int wanted = (int) (fraction * numSamples + 0.999999);
+    int seen = 0;
+
+    if (wanted < 1) {
+        wanted = 1;
+    }
+    for (int i = 0; i < HistogramBuckets; i++) {
+        seen += buckets[i];
+        if (seen >= wanted) {
+            return BucketTop(i);
+        }
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadStats::ThreadStats
+// 	Start keeping track of a thread created at "now".
+//----------------------------------------------------------------------
+
+ThreadStats::ThreadStats(int id, char *name, int now)
+{
+    threadID = id;
+    threadName = name;
+    tier = -1;
+    created = readySince = now;
+    firstRun = finished = -1;
+    totalWait = numSwitches = 0;
+    lastCPU = -1;
+    lastRan = 0;
+    migrated = FALSE;
+    tlbMisses = 0;
+    numBursts = 0;
+    totalPredictionError = 0;
+    numPages = -1;
+    numFaults = peakResident = 0;
+    peakWorkingSet = totalWorkingSet = numSamples = 0;
+    next = NULL;
+}
 
 //----------------------------------------------------------------------
 // Statistics::Statistics
-// 	Initialize performance metrics to zero, at system startup.
+// 	Initialize performance metrics to zero, at system startup, and
+//	register the counters worth watching over time.
 //----------------------------------------------------------------------
 
 Statistics::Statistics()
 {
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    totalDiskWait = maxDiskWait = numSeekTracks = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numTLBHits = numTLBMisses = numTLBFlushes = 0;
+    numFramesAllocated = numFramesFreed = maxFramesInUse = 0;
+    numFramesShared = numPagesCopied = 0;
+    numExecsRead = numExecsCached = 0;
+    numCacheHits = numCacheMisses = numCacheWrites = numCacheWriteBacks = 0;
+    numReadAheads = numReadAheadHits = numWriteBehinds = 0;
+    numJournalOperations = numJournalCommits = numJournalSectors = 0;
+    numJournalCheckpoints = numJournalRecovered = 0;
+    numPageOuts = 0;
+    numBurstPredictions = 0;
+    totalPredictionError = 0;
+    firstFinished = lastFinished = NULL;
+
+    StatsRegistry *registry = kernel->registry;
+
+    registry->AddCounter("ticks.idle", &idleTicks);
+    registry->AddCounter("ticks.system", &systemTicks);
+    registry->AddCounter("ticks.user", &userTicks);
+    registry->AddCounter("disk.reads", &numDiskReads);
+    registry->AddCounter("disk.writes", &numDiskWrites);
+    registry->AddCounter("disk.waitTicks", &totalDiskWait);
+    registry->AddCounter("disk.seekTracks", &numSeekTracks);
+    registry->AddCounter("console.read", &numConsoleCharsRead);
+    registry->AddCounter("console.written", &numConsoleCharsWritten);
+    registry->AddCounter("vm.faults", &numPageFaults);
+    registry->AddCounter("vm.pageOuts", &numPageOuts);
+    registry->AddCounter("frames.allocated", &numFramesAllocated);
+    registry->AddCounter("frames.freed", &numFramesFreed);
+    registry->AddCounter("cache.hits", &numCacheHits);
+    registry->AddCounter("cache.misses", &numCacheMisses);
+    registry->AddCounter("cache.writes", &numCacheWrites);
+    registry->AddCounter("cache.writeBacks", &numCacheWriteBacks);
+    registry->AddCounter("journal.commits", &numJournalCommits);
+    registry->AddCounter("tlb.hits", &numTLBHits);
+    registry->AddCounter("tlb.misses", &numTLBMisses);
+    registry->AddCounter("tlb.flushes", &numTLBFlushes);
+    registry->AddCounter("net.sent", &numPacketsSent);
+    registry->AddCounter("net.received", &numPacketsRecvd);
+}
+
+//----------------------------------------------------------------------
+// Statistics::~Statistics
+// 	De-allocate the per-thread records.
+//----------------------------------------------------------------------
+
+Statistics::~Statistics()
+{
+    while (firstFinished != NULL) {
+        ThreadStats *record = firstFinished;
+
+        firstFinished = record->next;
+        delete record;
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::ThreadFinished
+// 	Keep a copy of the statistics of a thread that is finishing,
+//	to be printed at shutdown, and count it in the histograms of
+//	the ready queue it last used.
+//----------------------------------------------------------------------
+
+void
+Statistics::ThreadFinished(ThreadStats *threadStats)
+{
+    ThreadStats *record = new ThreadStats(*threadStats);
+
+    record->next = NULL;
+    if (firstFinished == NULL) {
+        firstFinished = record;
+    } else {
+        lastFinished->next = record;
+    }
+    lastFinished = record;
+
+    if (record->tier >= 0) {
+        if (record->firstRun >= 0) {
+            responseTime[record->tier].Add(record->firstRun - record->created);
+        }
+        turnaroundTime[record->tier].Add(record->finished - record->created);
+        contextSwitches[record->tier].Add(record->numSwitches);
+    }
+}
+
+//----------------------------------------------------------------------
+// Statistics::PrintHistogram
+// 	Print the 50th, 95th and 99th percentiles of a histogram.
+//----------------------------------------------------------------------
+
+void
+Statistics::PrintHistogram(char *what, Histogram *histogram)
+{
+    cout << what << " " << histogram->Percentile(0.50) << "/"
+         << histogram->Percentile(0.95) << "/" << histogram->Percentile(0.99);
 }
 
 //----------------------------------------------------------------------
@@ -37,9 +253,111 @@ Statistics::Print()
 		cout << ", system " << systemTicks << ", user " << userTicks <<"\n";
     cout << "Disk I/O: reads " << numDiskReads;
 		cout << ", writes " << numDiskWrites << "\n";
+    if (numDiskReads + numDiskWrites > 0) {
+	cout << "Disk requests: latency average "
+	     << totalDiskWait / (numDiskReads + numDiskWrites) << ", at most "
+	     << maxDiskWait << " ticks; seeks across " << numSeekTracks
+	     << " tracks\n";
+    }
+    if (numCacheHits + numCacheMisses + numCacheWrites > 0) {
+	cout << "Buffer cache: read hits " << numCacheHits << ", misses "
+	     << numCacheMisses << "; sectors written " << numCacheWrites
+	     << ", written back " << numCacheWriteBacks << "\n";
+    }
+    if (numReadAheads + numWriteBehinds > 0) {
+	cout << "Read ahead: sectors " << numReadAheads << ", then read "
+	     << numReadAheadHits << "; written behind " << numWriteBehinds
+	     << "\n";
+    }
+    if (numJournalCommits + numJournalRecovered > 0) {
+	cout << "Journal: operations " << numJournalOperations << " in "
+	     << numJournalCommits << " commits, sectors logged "
+	     << numJournalSectors << "; checkpoints " << numJournalCheckpoints
+	     << ", sectors recovered " << numJournalRecovered << "\n";
+    }
 		cout << "Console I/O: reads " << numConsoleCharsRead;
     cout << ", writes " << numConsoleCharsWritten << "\n";
-    cout << "Paging: faults " << numPageFaults << "\n";
+    cout << "Paging: faults " << numPageFaults;
+    if (numPageOuts > 0) {
+	cout << ", pages written to swap " << numPageOuts;
+    }
+    cout << "\n";
+    if (numFramesAllocated > 0) {
+	cout << "Memory: frames allocated " << numFramesAllocated;
+	cout << ", freed " << numFramesFreed << ", at most " << maxFramesInUse
+	     << " in use";
+	if (numFramesShared > 0) {
+	    cout << ", shared " << numFramesShared << ", copied on write "
+		 << numPagesCopied;
+	}
+	cout << "\n";
+    }
+    if (numExecsRead + numExecsCached > 0) {
+	cout << "Programs: read from their files " << numExecsRead
+	     << ", from the cache " << numExecsCached << "\n";
+    }
+    if (numTLBHits + numTLBMisses > 0) {
+	cout << "TLB: hits " << numTLBHits << ", misses " << numTLBMisses;
+	cout << ", flushes " << numTLBFlushes << "\n";
+    }
     cout << "Network I/O: packets received " << numPacketsRecvd;
 		cout << ", sent " << numPacketsSent << "\n";
+    if (numBurstPredictions > 0) {
+	cout << "Burst prediction: " << numBurstPredictions << " bursts";
+	cout << ", mean error " << totalPredictionError / numBurstPredictions
+	     << " ticks\n";
+    }
+
+    bool header = FALSE;
+    for (int q = 0; q < NumTraceQueues; q++) {
+	if (waitTime[q].NumSamples() == 0
+		&& turnaroundTime[q].NumSamples() == 0) {
+	    continue;
+	}
+	if (!header) {
+	    cout << "Scheduling latency, ticks (p50/p95/p99):\n";
+	    header = TRUE;
+	}
+	cout << "    " << traceQueueNames[q] << " queue: ";
+	PrintHistogram("wait", &waitTime[q]);
+	cout << " over " << waitTime[q].NumSamples() << " dispatches\n";
+	if (turnaroundTime[q].NumSamples() > 0) {
+	    cout << "    " << traceQueueNames[q] << " queue: ";
+	    PrintHistogram("response", &responseTime[q]);
+	    cout << ", ";
+	    PrintHistogram("turnaround", &turnaroundTime[q]);
+	    cout << ", ";
+	    PrintHistogram("dispatches", &contextSwitches[q]);
+	    cout << " over " << turnaroundTime[q].NumSamples()
+		 << " threads\n";
+	}
+    }
+
+    for (ThreadStats *record = firstFinished; record != NULL;
+	 record = record->next) {
+	cout << "Thread " << record->threadID << " (" << record->threadName
+	     << "): turnaround " << record->finished - record->created;
+	if (record->firstRun >= 0) {
+	    cout << ", response " << record->firstRun - record->created;
+	}
+	cout << ", waited " << record->totalWait << ", "
+	     << record->numSwitches << " dispatches";
+	if (record->numBursts > 0) {
+	    cout << ", burst prediction error "
+		 << record->totalPredictionError / record->numBursts;
+	}
+	cout << "\n";
+	if (record->numPages >= 0) {
+	    cout << "    memory: " << record->numPages << " pages, at most "
+		 << record->peakResident << " in memory, "
+		 << record->numFaults << " faults, working set ";
+	    if (record->numSamples > 0) {
+		cout << (double) record->totalWorkingSet / record->numSamples
+		     << " pages on average, at most " << record->peakWorkingSet;
+	    } else {
+		cout << "not sampled";
+	    }
+	    cout << "\n";
+	}
+    }
 }
@@ -12,6 +12,70 @@
 #define STATS_H
 
 #include "copyright.h"
+#include "schedtrace.h"
+
+// Number of histogram buckets.  Values below HistogramSubBuckets get
+// a bucket each; above that, every power of two is split into
+// HistogramSubBuckets buckets, so a bucket is never wider than 1/8
+// of the values in it.
+
+const int HistogramSubBuckets = 8;
+const int HistogramBuckets = HistogramSubBuckets * 29;
+
+// The following class counts samples (of a time, in ticks) in
+// logarithmically sized buckets, so percentiles can be read off
+// without keeping every sample.
+
+class Histogram {
+  public:
+    Histogram();		// no samples yet
+
+    void Add(int value);	// count one sample
+    int NumSamples() { return numSamples; }
+    int Percentile(double fraction);
+				// a value that at least "fraction" of
+				// the samples are no bigger than
+
+  private:
+    int numSamples;
+    int buckets[HistogramBuckets];
+
+    static int BucketOf(int value);	// which bucket value goes in
+    static int BucketTop(int bucket);	// largest value in the bucket
+};
+
+// Scheduling statistics about one thread.  The Thread keeps these up
+// to date while it exists; when it finishes, Statistics files a copy.
+
+class ThreadStats {
+  public:
+    ThreadStats(int id, char *name, int now);
+
+    int threadID;
+    char *threadName;
+    int tier;			// ready queue it last went on, a TraceQueue;
+				// -1 if it was never made ready
+    int created;		// when it was created
+    int firstRun;		// when it first got a CPU, -1 if not yet
+    int readySince;		// when it last became ready
+    int totalWait;		// ticks spent waiting on ready queues
+    int numSwitches;		// how often it was given a CPU
+    int lastCPU;		// the CPU it last ran on, -1 if none yet,
+    int lastRan;		// and when it last left it
+    bool migrated;		// it is running on another CPU since
+    int tlbMisses;		// the misses its CPU's TLB had had when
+				// it got the CPU
+    int finished;		// when it finished, -1 if not yet
+    int numBursts;		// CPU bursts that were predicted ...
+    double totalPredictionError; // ... and the sum of |predicted - actual|
+    int numPages;		// of its address space, -1 if it had none
+    int numFaults;		// page faults it took
+    int peakResident;		// the most of its pages in memory at once
+    int peakWorkingSet;		// the largest working set sampled ...
+    int totalWorkingSet;	// ... the sum of them ...
+    int numSamples;		// ... and how many were
+    ThreadStats *next;		// the thread that finished after it
+};
 
 // The following class defines the statistics that are to be kept
 // about Nachos behavior -- how much time (ticks) elapsed, how
@@ -30,15 +94,63 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int totalDiskWait;		// ticks from disk requests to their end ...
+    int maxDiskWait;		// ... and the most for any
+    int numSeekTracks;		// tracks the disk head moved across
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
+    int numPageOuts;		// pages written to the swap area
+    int numFramesAllocated;	// page frames given to address spaces ...
+    int numFramesFreed;		// ... and given back by them
+    int maxFramesInUse;		// the most in use at any one time
+    int numFramesShared;	// pages given a frame another had
+    int numPagesCopied;		// copied, when one of them wrote to it
+    int numExecsRead;		// programs run read from their files ...
+    int numExecsCached;		// ... and found in the cache
+    int numCacheHits;		// disk sectors read from the cache ...
+    int numCacheMisses;		// ... and from the disk
+    int numCacheWrites;		// sectors written to the cache ...
+    int numCacheWriteBacks;	// ... and from it to the disk
+    int numReadAheads;		// sectors read before they were asked for ...
+    int numReadAheadHits;	// ... and those then read
+    int numWriteBehinds;	// sectors written back as a file was written
+    int numJournalOperations;	// file system operations committed ...
+    int numJournalCommits;	// ... in this many commits
+    int numJournalSectors;	// sectors written to the journal for them
+    int numJournalCheckpoints;	// times the journal started again
+    int numJournalRecovered;	// sectors written home when Nachos started
+    int numTLBHits;		// translations found in the TLB ...
+    int numTLBMisses;		// ... and not found, if there is one
+    int numTLBFlushes;		// context switches that emptied it
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numBurstPredictions;	// CPU bursts whose length was predicted
+    double totalPredictionError; // sum of |predicted - actual| over them
 
     Statistics(); 		// initialize everything to zero
+    ~Statistics();
+
+    // Per ready queue (indexed by TraceQueue), how long threads
+    // waited to be dispatched, how long from creation to the first
+    // dispatch, from creation to finishing, and how many times each
+    // was dispatched.
+    Histogram waitTime[NumTraceQueues];
+    Histogram responseTime[NumTraceQueues];
+    Histogram turnaroundTime[NumTraceQueues];
+    Histogram contextSwitches[NumTraceQueues];
+
+    void ThreadFinished(ThreadStats *threadStats);
+				// keep a copy of a finished thread's
+				// statistics
 
     void Print();		// print collected statistics
+
+  private:
+    ThreadStats *firstFinished;	// per finished thread, in the
+    ThreadStats *lastFinished;	// order they finished
+
+    void PrintHistogram(char *what, Histogram *histogram);
 };
 
 // Constants used to reflect the relative time an operation would
@@ -48,13 +160,17 @@ class Statistics {
 // Since Nachos kernel code is directly executed, and the time spent
 // in the kernel measured by the number of calls to enable interrupts,
 // these time constants are none too exact.
+//
+// The device latencies and the time slice can be changed without a
+// rebuild, by a "-cf" configuration file (see Kernel::ReadConfig);
+// the values here are their defaults.
 
 const int UserTick = 	   1;	// advance for each user-level instruction 
 const int SystemTick =	  10; 	// advance each time interrupts are enabled
-const int RotationTime = 500; 	// time disk takes to rotate one sector
-const int SeekTime =	 500;  	// time disk takes to seek past one track
-const int ConsoleTime =	 100;	// time to read or write one character
-const int NetworkTime =	 100;  	// time to send or receive one packet
-const int TimerTicks = 	 500;  	// (average) time between timer interrupts
+extern int RotationTime; 	// time disk takes to rotate one sector (500)
+extern int SeekTime;  		// time disk takes to seek past one track (500)
+extern int ConsoleTime;		// time to read or write one character (100)
+extern int NetworkTime;  	// time to send or receive one packet (100)
+extern int TimerTicks;  	// (average) time between timer interrupts (500)
 
 #endif // STATS_H
@@ -0,0 +1,294 @@
+// statsregistry.cc
+//	Routines to register statistics, and to sample them every so
+//	many ticks.  See statsregistry.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "statsregistry.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// StatEntry::StatEntry
+// 	Initialize a statistic of kind "entryKind", keeping a copy of
+//	its name.  The caller fills in where its value comes from.
+//----------------------------------------------------------------------
+
+StatEntry::StatEntry(char *entryName, StatKind entryKind)
+{
+    name = new char[strlen(entryName) + 1];
+    strcpy(name, entryName);
+    kind = entryKind;
+    counter = NULL;
+    gauge = NULL;
+    gaugeArg = NULL;
+    histogram = NULL;
+}
+
+StatEntry::~StatEntry()
+{
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::StatsRegistry
+// 	Initialize an empty registry, not sampling.
+//----------------------------------------------------------------------
+
+StatsRegistry::StatsRegistry()
+{
+    entries = new List<StatEntry *>;
+    fd = -1;
+    json = FALSE;
+    period = 0;
+    numSamples = 0;
+    buffer = NULL;
+    numBuffered = 0;
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::~StatsRegistry
+// 	Nachos is halting.  If we are sampling, take the last sample,
+//	and write out whatever is still buffered.
+//----------------------------------------------------------------------
+
+StatsRegistry::~StatsRegistry()
+{
+    if (fd >= 0) {
+        Sample();
+        Flush();
+        Close(fd);
+        delete [] buffer;
+    }
+    while (!entries->IsEmpty()) {
+        delete entries->RemoveFront();
+    }
+    delete entries;
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::IsRegistered
+// 	Return TRUE if a statistic is registered as "name" already.
+//----------------------------------------------------------------------
+
+bool
+StatsRegistry::IsRegistered(char *name)
+{
+    ListIterator<StatEntry *> iter(entries);
+
+    for (; !iter.IsDone(); iter.Next()) {
+        if (strcmp(iter.Item()->name, name) == 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::AddCounter, AddGauge, AddHistogram
+// 	Register a statistic as "name", unless one is already.  Once
+//	sampling has started, the columns are fixed, so no more can be.
+//
+//	"counter" is where a counter is kept.
+//	"gauge" reads a gauge's value, from "arg".
+//	"histogram" is the histogram.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::AddCounter(char *name, int *counter)
+{
+    StatEntry *entry;
+
+    ASSERT(numSamples == 0);
+    if (!IsRegistered(name)) {
+        entry = new StatEntry(name, StatCounter);
+        entry->counter = counter;
+        entries->Append(entry);
+    }
+}
+
+void
+StatsRegistry::AddGauge(char *name, GaugeFunction gauge, void *arg)
+{
+    StatEntry *entry;
+
+    ASSERT(numSamples == 0);
+    if (!IsRegistered(name)) {
+        entry = new StatEntry(name, StatGauge);
+        entry->gauge = gauge;
+        entry->gaugeArg = arg;
+        entries->Append(entry);
+    }
+}
+
+void
+StatsRegistry::AddHistogram(char *name, Histogram *histogram)
+{
+    StatEntry *entry;
+
+    ASSERT(numSamples == 0);
+    if (!IsRegistered(name)) {
+        entry = new StatEntry(name, StatHistogram);
+        entry->histogram = histogram;
+        entries->Append(entry);
+    }
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::Start
+// 	Start sampling: take the first sample now, and one every "ticks"
+//	ticks from then on.
+//
+//	"fileName" is the file to write the samples to; JSON if its name
+//		ends in ".json", CSV otherwise.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::Start(char *fileName, int ticks)
+{
+    int length = strlen(fileName);
+
+    ASSERT(fd < 0 && ticks > 0);
+    fd = OpenForWrite(fileName);
+    json = (length >= 5 && strcmp(fileName + length - 5, ".json") == 0);
+    period = ticks;
+    buffer = new char[StatsBufferSize];
+    numBuffered = 0;
+
+    Sample();
+    kernel->interrupt->Schedule(this, period, StatsSampleInt);
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::CallBack
+// 	Time for the next sample.  Take it, and schedule the one after,
+//	unless the machine is idle with nothing else pending: then Nachos
+//	is about to halt, and would otherwise wait for ever.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::CallBack()
+{
+    Interrupt *interrupt = kernel->interrupt;
+
+    Sample();
+    if (interrupt->getStatus() != IdleMode || interrupt->NumPending() > 0) {
+        interrupt->Schedule(this, period, StatsSampleInt);
+    }
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::Sample
+// 	Write out the value of every statistic, now.  A CSV file gets
+//	its header line before the first sample.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::Sample()
+{
+    ListIterator<StatEntry *> names(entries), values(entries);
+    char field[32];
+    StatEntry *entry;
+
+    if (fd < 0) {
+        return;
+    }
+    if (!json && numSamples == 0) {
+        Put("tick");
+        for (; !names.IsDone(); names.Next()) {
+            entry = names.Item();
+            Put(",");
+            Put(entry->name);
+            if (entry->kind == StatHistogram) {
+                Put(".n,");
+                Put(entry->name);
+                Put(".p50,");
+                Put(entry->name);
+                Put(".p99");
+            }
+        }
+        Put("\n");
+    }
+
+    sprintf(field, json ? "{\"tick\": %d" : "%d", kernel->stats->totalTicks);
+    Put(field);
+    for (; !values.IsDone(); values.Next()) {
+        entry = values.Item();
+        switch (entry->kind) {
+          case StatCounter:
+            PutValue(entry->name, "", *entry->counter);
+            break;
+          case StatGauge:
+            PutValue(entry->name, "", (*entry->gauge)(entry->gaugeArg));
+            break;
+          case StatHistogram:
+            PutValue(entry->name, ".n", entry->histogram->NumSamples());
+            PutValue(entry->name, ".p50", entry->histogram->Percentile(0.50));
+            PutValue(entry->name, ".p99", entry->histogram->Percentile(0.99));
+            break;
+        }
+    }
+    Put(json ? "}\n" : "\n");
+    numSamples++;
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::PutValue
+// 	Add a column to the sample being written: for JSON, with its
+//	name, and "suffix" after it, for a histogram's columns.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::PutValue(const char *name, const char *suffix, int value)
+{
+    char field[32];
+
+    if (json) {
+        Put(", \"");
+        Put(name);
+        Put(suffix);
+        Put("\": ");
+    } else {
+        Put(",");
+    }
+    sprintf(field, "%d", value);
+    Put(field);
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::Put
+// 	Add "text" to the output, writing the buffer out first if it
+//	wouldn't fit.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::Put(const char *text)
+{
+    int length = strlen(text);
+
+    if (numBuffered + length > StatsBufferSize) {
+        Flush();
+    }
+    if (length > StatsBufferSize) {		// too long to buffer at all
+        WriteFile(fd, (char *) text, length);
+        return;
+    }
+    memcpy(buffer + numBuffered, text, length);
+    numBuffered += length;
+}
+
+//----------------------------------------------------------------------
+// StatsRegistry::Flush
+// 	Write out whatever is buffered.
+//----------------------------------------------------------------------
+
+void
+StatsRegistry::Flush()
+{
+    if (numBuffered > 0) {
+        WriteFile(fd, buffer, numBuffered);
+        numBuffered = 0;
+    }
+}
@@ -0,0 +1,98 @@
+// statsregistry.h
+//	Data structures for sampling Nachos statistics over time.
+//
+//	Statistics (stats.h) prints totals once, when Nachos halts.  The
+//	registry instead lets any part of Nachos name the numbers it
+//	keeps -- counters, kept up to date in place (most only go up),
+//	gauges, worked out when asked (a queue's length, say), and
+//	histograms -- and, with "-ts", takes a sample of all of them
+//	every so many ticks, from an interrupt, and writes it to a file
+//	as it goes; one last sample is taken when Nachos halts.
+//
+//	The file is CSV, a header line of the names and then a line per
+//	sample, unless its name ends in ".json": then each sample is a
+//	JSON object on a line of its own.  Either way the first column
+//	is the tick the sample was taken at.  A histogram gives three
+//	columns: how many samples it has ("name.n") and its median and
+//	99th percentile ("name.p50", "name.p99").
+//
+//	Names are registered as the parts of Nachos are initialized; a
+//	name registered again is ignored, so that, say, every CPU's run
+//	queue can register the histogram they share.  Everything is
+//	registered before the first sample, so the CSV columns never
+//	change.
+//
+//	Without "-ts", names are still registered, but nothing is read.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STATSREGISTRY_H
+#define STATSREGISTRY_H
+
+#include "copyright.h"
+#include "list.h"
+#include "callback.h"
+#include "stats.h"
+
+// Reads a gauge's value, given the object it was registered with.
+
+typedef int (*GaugeFunction)(void *arg);
+
+enum StatKind { StatCounter, StatGauge, StatHistogram };
+
+// One registered statistic.
+
+class StatEntry {
+  public:
+    StatEntry(char *entryName, StatKind entryKind);
+    ~StatEntry();
+
+    char *name;			// a copy of the name it was registered by
+    StatKind kind;
+    int *counter;		// for a counter, where it is kept
+    GaugeFunction gauge;	// for a gauge, what reads it,
+    void *gaugeArg;		// and what to read it from
+    Histogram *histogram;	// for a histogram, the histogram
+};
+
+const int StatsBufferSize = 4096;	// bytes of output written at once
+
+// The following class defines the registry, and the sampler.
+
+class StatsRegistry : public CallBackObj {
+  public:
+    StatsRegistry();
+    ~StatsRegistry();		// take the last sample, if sampling,
+				// and write out the rest of the file
+
+    void AddCounter(char *name, int *counter);
+    void AddGauge(char *name, GaugeFunction gauge, void *arg);
+    void AddHistogram(char *name, Histogram *histogram);
+				// register a statistic, unless one of
+				// that name already is
+
+    void Start(char *fileName, int ticks);
+				// sample every "ticks" ticks, to the file
+    void Sample();		// write out a sample now
+
+    void CallBack();		// the sampling interrupt went off
+
+  private:
+    List<StatEntry *> *entries;	// in the order they were registered
+    int fd;			// the file samples go to, or -1
+    bool json;			// JSON lines, rather than CSV
+    int period;			// ticks between samples
+    int numSamples;
+    char *buffer;		// output not written out yet
+    int numBuffered;
+
+    bool IsRegistered(char *name);
+    void Put(const char *text);	// add text to the output
+    void PutValue(const char *name, const char *suffix, int value);
+				// and a column of a sample
+    void Flush();		// write what is buffered to the file
+};
+
+#endif // STATSREGISTRY_H
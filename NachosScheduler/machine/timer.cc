@@ -40,6 +40,9 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
     randomize = doRandom;
     callPeriodically = toCall;
     disable = FALSE;
+    armed = FALSE;
+    scheduled = NULL;
+    period = TimerTicks;
     SetInterrupt();
 }
 
@@ -52,11 +55,15 @@ Timer::Timer(bool doRandom, CallBackObj *toCall)
 void 
 Timer::CallBack() 
 {
+    armed = FALSE;		// "scheduled" has gone off
+    scheduled = NULL;
     // invoke the Nachos interrupt handler for this device
     callPeriodically->CallBack();
     
-    SetInterrupt();	// do last, to let software interrupt handler
+    if (!armed) {	// unless the handler reprogrammed us
+        SetInterrupt();	// do last, to let software interrupt handler
     			// decide if it wants to disable future interrupts
+    }
 }
 
 //----------------------------------------------------------------------
@@ -70,12 +77,67 @@ void
 Timer::SetInterrupt() 
 {
     if (!disable) {
-       int delay = TimerTicks;
+       int delay = period;
 
        if (randomize) {
-	     delay = 1 + (RandomNumber() % (TimerTicks * 2));
+	     delay = 1 + (kernel->replay->Random(ReplayTimer) % (period * 2));
         }
        // schedule the next timer device interrupt
-       kernel->interrupt->Schedule(this, delay, TimerInt);
+       scheduled = kernel->interrupt->Schedule(this, delay, TimerInt);
+       armed = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Enable
+//      Undo a Disable.  If the timer has already stopped -- the
+//	interrupt that saw it disabled has come and gone -- start it
+//	up again.
+//----------------------------------------------------------------------
+
+void
+Timer::Enable()
+{
+    disable = FALSE;
+    if (!armed) {
+        SetInterrupt();
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Reprogram
+//      Cancel the interrupt we were waiting for, and interrupt after
+//	"delay" ticks instead (or a random delay averaging that), and
+//	every "delay" ticks from then on.  If the timer was disabled,
+//	it is enabled again.
+//----------------------------------------------------------------------
+
+void
+Timer::Reprogram(int delay)
+{
+    ASSERT(delay > 0);
+    if (armed) {
+        kernel->interrupt->Cancel(scheduled);
+    }
+    period = delay;
+    disable = FALSE;
+    SetInterrupt();
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Disable the timer, and cancel the interrupt it was waiting for,
+//	rather than letting it arrive to find the timer disabled.
+//	Enable or Reprogram start it again.
+//----------------------------------------------------------------------
+
+void
+Timer::Stop()
+{
+    if (armed) {
+        kernel->interrupt->Cancel(scheduled);
+        scheduled = NULL;
+        armed = FALSE;
     }
+    disable = TRUE;
 }
@@ -6,7 +6,10 @@
 //	having a thread go to sleep for a specific period of time. 
 //
 //	We emulate a hardware timer by scheduling an interrupt to occur
-//	every time stats->totalTicks has increased by TimerTicks.
+//	every time stats->totalTicks has increased by TimerTicks.  Like a
+//	real one-shot timer, it can be reprogrammed for a different
+//	delay, or stopped at once; the interrupt it was waiting for is
+//	then cancelled.
 //
 //	In order to introduce some randomness into time-slicing, if "doRandom"
 //	is set, then the interrupt comes after a random number of ticks.
@@ -24,6 +27,8 @@
 #include "utility.h"
 #include "callback.h"
 
+class PendingInterrupt;
+
 // The following class defines a hardware timer. 
 class Timer : public CallBackObj {
   public:
@@ -35,12 +40,24 @@ class Timer : public CallBackObj {
     void Disable() { disable = TRUE; }
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
+    void Stop();		// Turn it off now, cancelling the
+				// interrupt it was waiting for
+    bool IsArmed() { return armed; }
+				// Is an interrupt on its way?
+    void Enable();		// Turn it back on after Disable
+    void Reprogram(int delay);	// Interrupt "delay" ticks from now, and
+				// every "delay" ticks after that,
+				// instead of as before; also turns the
+				// timer back on
 
   private:
     bool randomize;		// set if we need to use a random timeout delay
     CallBackObj *callPeriodically; // call this every TimerTicks time units 
     bool disable;		// turn off the timer device after next
     				// interrupt.
+    bool armed;			// is an interrupt scheduled?
+    PendingInterrupt *scheduled;	// if so, the one to cancel
+    int period;			// ticks between interrupts
     
     void CallBack();		// called internally when the hardware
 				// timer generates an interrupt
@@ -0,0 +1,296 @@
+// tlb.cc
+//	Routines to simulate a set-associative translation lookaside
+//	buffer.  See tlb.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "tlb.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// TLB::TLB
+// 	Initialize an empty TLB.
+//
+//	"numEntries" is how many translations it holds.
+//	"numWays" is how many of them are in each set; it must divide
+//		"numEntries".
+//	"replacement" is which entry of a set a new one replaces.
+//	"tagged" is TRUE if entries are tagged with their address
+//		space, FALSE if the TLB is flushed on a context switch.
+//----------------------------------------------------------------------
+
+TLB::TLB(int numEntries, int numWays, TLBPolicy replacement, bool tagged)
+{
+    ASSERT(numEntries > 0 && numWays > 0 && numEntries % numWays == 0);
+    size = numEntries;
+    ways = numWays;
+    numSets = numEntries / numWays;
+    policy = replacement;
+    useASIDs = tagged;
+    entries = new TranslationEntry[size];
+    source = new TranslationEntry *[size];
+    asid = new int[size];
+    lastUsed = new int[size];
+    for (int i = 0; i < size; i++) {
+	entries[i].valid = FALSE;
+	source[i] = NULL;
+	asid[i] = 0;
+	lastUsed[i] = 0;
+    }
+    clock = 0;
+    numMisses = 0;
+    currentASID = 0;
+    randomState = 1;
+}
+
+//----------------------------------------------------------------------
+// TLB::~TLB
+// 	De-allocate the TLB.
+//----------------------------------------------------------------------
+
+TLB::~TLB()
+{
+    delete [] entries;
+    delete [] source;
+    delete [] asid;
+    delete [] lastUsed;
+}
+
+//----------------------------------------------------------------------
+// TLB::Lookup
+// 	Return the TLB entry translating "virtualPage", for the address
+//	space that is running, or NULL if there is none.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+TLB::Lookup(int virtualPage)
+{
+    int first = (virtualPage % numSets) * ways;
+
+    clock++;
+    for (int i = first; i < first + ways; i++) {
+	if (entries[i].valid && entries[i].virtualPage == virtualPage
+	      && asid[i] == currentASID) {
+	    if (policy == TLBLeastRecentlyUsed) {
+		lastUsed[i] = clock;
+	    }
+	    return &entries[i];
+	}
+    }
+    numMisses++;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// TLB::Load
+// 	Load the translation in a page table entry into the TLB, for
+//	the address space that is running, replacing an empty entry
+//	of its set if there is one.
+//
+//	"pageTableEntry" is where the use and dirty bits go back to,
+//		when the translation leaves the TLB.
+//----------------------------------------------------------------------
+
+void
+TLB::Load(TranslationEntry *pageTableEntry)
+{
+    int set = pageTableEntry->virtualPage % numSets;
+    int slot = Victim(set);
+
+    Evict(slot);
+    entries[slot] = *pageTableEntry;
+    entries[slot].use = FALSE;		// those are for the page table
+    entries[slot].dirty = FALSE;
+    source[slot] = pageTableEntry;
+    asid[slot] = currentASID;
+    lastUsed[slot] = ++clock;
+}
+
+//----------------------------------------------------------------------
+// TLB::Victim
+// 	Return the slot of "set" a new translation should go in: an
+//	empty one, or else the one the replacement policy picks.
+//----------------------------------------------------------------------
+
+int
+TLB::Victim(int set)
+{
+    int first = set * ways;
+    int victim = first;
+
+    for (int i = first; i < first + ways; i++) {
+	if (!entries[i].valid) {
+	    return i;
+	}
+    }
+    if (policy == TLBRandom) {
+	randomState = randomState * 1103515245 + 12345;
+	return first + (randomState >> 16) % ways;
+    }
+    for (int i = first + 1; i < first + ways; i++) {	// LRU or FIFO
+	if (lastUsed[i] < lastUsed[victim]) {
+	    victim = i;
+	}
+    }
+    return victim;
+}
+
+//----------------------------------------------------------------------
+// TLB::Evict
+// 	Empty a slot, copying the use and dirty bits of the translation
+//	in it back to the page table entry it came from.
+//----------------------------------------------------------------------
+
+void
+TLB::Evict(int slot)
+{
+    if (entries[slot].valid) {
+	source[slot]->use |= entries[slot].use;
+	source[slot]->dirty |= entries[slot].dirty;
+	entries[slot].valid = FALSE;
+    }
+    source[slot] = NULL;
+}
+
+//----------------------------------------------------------------------
+// TLB::Switch
+// 	Address space "asid" is about to run.  Without tags, the
+//	translations of the last one must be flushed.
+//----------------------------------------------------------------------
+
+void
+TLB::Switch(int newASID)
+{
+    if (newASID != currentASID) {
+	if (!useASIDs) {
+	    Flush();
+	    kernel->stats->numTLBFlushes++;
+	}
+	currentASID = newASID;
+    }
+}
+
+//----------------------------------------------------------------------
+// TLB::Purge
+// 	Address space "asid" is being deleted, with its page table;
+//	take its translations out of the TLB.
+//----------------------------------------------------------------------
+
+void
+TLB::Purge(int oldASID)
+{
+    for (int i = 0; i < size; i++) {
+	if (asid[i] == oldASID) {
+	    Evict(i);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// TLB::Invalidate
+// 	The page "pageTableEntry" translates is leaving memory; take its
+//	translation out of the TLB, so that its use and dirty bits are
+//	back in the page table entry, and it can't be used any more.
+//----------------------------------------------------------------------
+
+void
+TLB::Invalidate(TranslationEntry *pageTableEntry)
+{
+    for (int i = 0; i < size; i++) {
+	if (source[i] == pageTableEntry) {
+	    Evict(i);
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// TLB::WriteBack
+// 	Copy the use and dirty bits of every translation back to its
+//	page table entry, as if it had left the TLB, and clear them
+//	here, so that they are set again by the next reference.
+//----------------------------------------------------------------------
+
+void
+TLB::WriteBack()
+{
+    for (int i = 0; i < size; i++) {
+	if (entries[i].valid) {
+	    source[i]->use |= entries[i].use;
+	    source[i]->dirty |= entries[i].dirty;
+	    entries[i].use = FALSE;
+	    entries[i].dirty = FALSE;
+	}
+    }
+}
+
+//----------------------------------------------------------------------
+// TLB::Flush
+// 	Take every translation out of the TLB.
+//----------------------------------------------------------------------
+
+void
+TLB::Flush()
+{
+    for (int i = 0; i < size; i++) {
+	Evict(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// TLB::SelfTest
+// 	Test whether this module is working, with a page table of our
+//	own.  The TLB must be empty, tagged, and have two sets of two
+//	ways.
+//----------------------------------------------------------------------
+
+void
+TLB::SelfTest()
+{
+    TranslationEntry pageTable[5];
+    TranslationEntry *entry;
+    int i;
+
+    ASSERT(numSets == 2 && ways == 2 && useASIDs);
+    for (i = 0; i < 5; i++) {
+	pageTable[i].virtualPage = i;
+	pageTable[i].physicalPage = 10 + i;
+	pageTable[i].valid = TRUE;
+	pageTable[i].readOnly = FALSE;
+	pageTable[i].use = FALSE;
+	pageTable[i].dirty = FALSE;
+    }
+    Switch(1);
+    ASSERT(Lookup(0) == NULL);
+    Load(&pageTable[0]);		// 0, 2 and 4 share a set
+    Load(&pageTable[2]);
+    Load(&pageTable[1]);
+    entry = Lookup(0);
+    ASSERT(entry != NULL && entry->physicalPage == 10);
+    entry->dirty = TRUE;
+    ASSERT(Lookup(2) != NULL && Lookup(1) != NULL);
+    Lookup(0);				// 0 is used last, but was loaded
+    Load(&pageTable[4]);		// first
+    ASSERT(Lookup(4) != NULL && Lookup(1) != NULL);
+    if (policy == TLBLeastRecentlyUsed) {
+	ASSERT(Lookup(0) != NULL && Lookup(2) == NULL);
+    } else if (policy == TLBFirstInFirstOut) {
+	ASSERT(Lookup(0) == NULL && Lookup(2) != NULL);
+    }
+
+    Switch(2);				// another address space
+    ASSERT(Lookup(1) == NULL);
+    Load(&pageTable[3]);
+    Switch(1);
+    ASSERT(Lookup(1) != NULL && Lookup(3) == NULL);
+
+    Purge(1);
+    Purge(2);
+    ASSERT(pageTable[0].dirty && !pageTable[1].dirty);
+    for (i = 0; i < size; i++) {
+	ASSERT(!entries[i].valid);
+    }
+    Switch(0);
+}
@@ -0,0 +1,90 @@
+// tlb.h
+//	Data structures to simulate a translation lookaside buffer.
+//
+//	With "-tlb <entries> <ways> <policy>", the machine translates
+//	through a TLB instead of the page table: <entries> translations,
+//	in sets of <ways> (so <ways> equal to <entries> is fully
+//	associative), replacing the least recently used ("lru"), the
+//	least recently loaded ("fifo") or a random ("random") entry of
+//	a set when a new one is loaded.  A virtual page not in the TLB
+//	raises a PageFaultException, and the kernel loads it from the
+//	page table of the current address space (AddrSpace::RefillTLB).
+//
+//	On a context switch the TLB is flushed, unless "-asid" is
+//	given: then each entry is tagged with the address space it
+//	belongs to, and only entries of the current one match.  The hits,
+//	misses and flushes are counted in the statistics.
+//
+//	The use and dirty bits the hardware sets are copied back to the
+//	page table entry a translation was loaded from when it leaves
+//	the TLB, so the page table must outlive its entries (see Purge).
+//	Each simulated CPU has a TLB of its own (see cpu.h).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TLB_H_
+#define TLB_H_
+
+#include "copyright.h"
+#include "utility.h"
+#include "translate.h"
+
+// Which entry of a full set a new translation replaces.
+
+enum TLBPolicy { TLBLeastRecentlyUsed, TLBFirstInFirstOut, TLBRandom };
+
+// The following class defines a set-associative TLB.
+
+class TLB {
+  public:
+    TLB(int numEntries, int numWays, TLBPolicy replacement, bool tagged);
+				// an empty TLB; with "tagged", entries
+				// carry the address space they are for
+    ~TLB();
+
+    TranslationEntry *Lookup(int virtualPage);
+				// the entry for "virtualPage" in the
+				// current address space, or NULL
+    void Load(TranslationEntry *pageTableEntry);
+				// load a translation from a page table
+    void Switch(int asid);	// address space "asid" is about to run
+    void Purge(int asid);	// address space "asid" is going away
+    void Invalidate(TranslationEntry *pageTableEntry);
+				// a page is going away; take out any
+				// translation loaded from its entry
+    void WriteBack();		// copy the use and dirty bits to the
+				// page table now, for page replacement
+    void Flush();		// empty the TLB
+
+    int CurrentASID() { return currentASID; }
+    int NumMisses() { return numMisses; }
+				// lookups that found nothing, so far
+    void SelfTest();		// test whether the TLB is working
+
+  private:
+    int size;			// entries in all
+    int ways;			// entries per set
+    int numSets;
+    TLBPolicy policy;
+    bool useASIDs;		// tag entries, rather than flushing
+
+    TranslationEntry *entries;	// the translations, set by set
+    TranslationEntry **source;	// the page table entry each came from
+    int *asid;			// the address space each belongs to
+    int *lastUsed;		// when each was last used, or loaded
+				// (for FIFO)
+    int clock;			// counts lookups and loads
+    int numMisses;		// this TLB's share of stats->numTLBMisses
+    int currentASID;
+    unsigned int randomState;	// for TLBRandom; not the random
+				// numbers Nachos draws elsewhere, so
+				// a run with -rs is the same with or
+				// without a TLB
+
+    void Evict(int slot);	// the entry in "slot" leaves the TLB
+    int Victim(int set);	// which slot of "set" to replace
+};
+
+#endif // TLB_H_
@@ -32,42 +32,8 @@
 #include "copyright.h"
 #include "main.h"
 
-// Routines for converting Words and Short Words to and from the
-// simulated machine's format of little endian.  These end up
-// being NOPs when the host machine is also little endian (DEC and Intel).
-
-unsigned int
-WordToHost(unsigned int word) {
-#ifdef HOST_IS_BIG_ENDIAN
-	 register unsigned long result;
-	 result = (word >> 24) & 0x000000ff;
-	 result |= (word >> 8) & 0x0000ff00;
-	 result |= (word << 8) & 0x00ff0000;
-	 result |= (word << 24) & 0xff000000;
-	 return result;
-#else 
-	 return word;
-#endif /* HOST_IS_BIG_ENDIAN */
-}
-
-unsigned short
-ShortToHost(unsigned short shortword) {
-#ifdef HOST_IS_BIG_ENDIAN
-	 register unsigned short result;
-	 result = (shortword << 8) & 0xff00;
-	 result |= (shortword >> 8) & 0x00ff;
-	 return result;
-#else 
-	 return shortword;
-#endif /* HOST_IS_BIG_ENDIAN */
-}
-
-unsigned int
-WordToMachine(unsigned int word) { return WordToHost(word); }
-
-unsigned short
-ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
-
+// The routines for converting Words and Short Words to and from the
+// simulated machine's format of little endian are in machine.h.
 
 //----------------------------------------------------------------------
 // Machine::ReadMem
@@ -80,6 +46,11 @@ ShortToMachine(unsigned short shortword) { return ShortToHost(shortword); }
 //	"addr" -- the virtual address to read from
 //	"size" -- the number of bytes to read (1, 2, or 4)
 //	"value" -- the place to write the result
+//
+//	Most references are to a page that was translated recently, so
+//	if an aligned reference is to a page in the translation cache,
+//	we go straight to main memory, with the same effect (on the use
+//	and dirty bits too) as Translate would have.
 //----------------------------------------------------------------------
 
 bool
@@ -89,6 +60,21 @@ Machine::ReadMem(int addr, int size, int *value)
     ExceptionType exception;
     int physicalAddress;
     
+    char *cached;
+
+    if ((addr & (size - 1)) == 0
+	  && (cached = CachedAddress(addr, FALSE)) != NULL) {
+	if (size == 4) {			// the usual case
+	    *value = WordToHost(*(unsigned int *) cached);
+	} else if (size == 1) {
+	    *value = *cached;
+	} else {
+	    ASSERT(size == 2);
+	    *value = ShortToHost(*(unsigned short *) cached);
+	}
+	return TRUE;
+    }
+
     DEBUG(dbgAddr, "Reading VA " << addr << ", size " << size);
     
     exception = Translate(addr, &physicalAddress, size, FALSE);
@@ -138,6 +124,23 @@ Machine::WriteMem(int addr, int size, int value)
     ExceptionType exception;
     int physicalAddress;
      
+    char *cached;
+
+    if ((addr & (size - 1)) == 0
+	  && (cached = CachedAddress(addr, TRUE)) != NULL) {
+	InvalidateDecoded(cached - mainMemory, size);	// in case it's code
+	if (size == 4) {			// the usual case
+	    *(unsigned int *) cached = WordToMachine((unsigned int) value);
+	} else if (size == 1) {
+	    *cached = (unsigned char) (value & 0xff);
+	} else {
+	    ASSERT(size == 2);
+	    *(unsigned short *) cached
+		= ShortToMachine((unsigned short) (value & 0xffff));
+	}
+	return TRUE;
+    }
+
     DEBUG(dbgAddr, "Writing VA " << addr << ", size " << size << ", value " << value);
 
     exception = Translate(addr, &physicalAddress, size, TRUE);
@@ -145,6 +148,7 @@ Machine::WriteMem(int addr, int size, int value)
 	RaiseException(exception, addr);
 	return FALSE;
     }
+    InvalidateDecoded(physicalAddress, size);	// in case it's code
     switch (size) {
       case 1:
 	mainMemory[physicalAddress] = (unsigned char) (value & 0xff);
@@ -166,6 +170,50 @@ Machine::WriteMem(int addr, int size, int value)
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Machine::CachedAddress
+// 	Return where the virtual address "virtAddr" is in main memory,
+//	if its page is in the translation cache, and the entry it was
+//	translated by would still translate it to the same page.
+//	Otherwise return NULL, and Translate must be called.  "virtAddr"
+//	must be aligned for the reference.
+//
+//	"writing" -- if TRUE, check the "read-only" bit, and set the
+//		dirty bit, as Translate would
+//----------------------------------------------------------------------
+
+char *
+Machine::CachedAddress(int virtAddr, bool writing)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    CachedTranslation *cached = &translationCache[vpn % TranslationCacheSize];
+    TranslationEntry *entry = cached->entry;
+
+    if (cached->virtualPage != (int) vpn || !entry->valid
+	  || entry->physicalPage != cached->physicalPage
+	  || (writing && entry->readOnly))
+	return NULL;
+    entry->use = TRUE;
+    if (writing)
+	entry->dirty = TRUE;
+    return cached->memory + (unsigned) virtAddr % PageSize;
+}
+
+//----------------------------------------------------------------------
+// Machine::FlushTranslations
+// 	Empty the translation cache.  Called whenever the kernel gives
+//	the machine another page table, or frees the one it has.
+//----------------------------------------------------------------------
+
+void
+Machine::FlushTranslations()
+{
+    for (int i = 0; i < TranslationCacheSize; i++) {
+	translationCache[i].virtualPage = -1;
+	translationCache[i].entry = NULL;
+    }
+}
+
 //----------------------------------------------------------------------
 // Machine::Translate
 // 	Translate a virtual address into a physical address, using 
@@ -184,10 +232,10 @@ Machine::WriteMem(int addr, int size, int value)
 ExceptionType
 Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 {
-    int i;
     unsigned int vpn, offset;
     TranslationEntry *entry;
     unsigned int pageFrame;
+    HostPhase phase(HostTranslate);
 
     DEBUG(dbgAddr, "\tTranslate " << virtAddr << (writing ? " , write" : " , read"));
 
@@ -215,17 +263,15 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 	}
 	entry = &pageTable[vpn];
     } else {
-        for (entry = NULL, i = 0; i < TLBSize; i++)
-    	    if (tlb[i].valid && (tlb[i].virtualPage == ((int)vpn))) {
-		entry = &tlb[i];			// FOUND!
-		break;
-	    }
+	entry = tlb->Lookup(vpn);
 	if (entry == NULL) {				// not found
+	    kernel->stats->numTLBMisses++;
     	    DEBUG(dbgAddr, "Invalid TLB entry for this virtual page!");
     	    return PageFaultException;		// really, this is a TLB fault,
 						// the page may be in memory,
 						// but not in the TLB
 	}
+	kernel->stats->numTLBHits++;
     }
 
     if (entry->readOnly && writing) {	// trying to write to a read-only page
@@ -236,13 +282,23 @@ Machine::Translate(int virtAddr, int* physAddr, int size, bool writing)
 
     // if the pageFrame is too big, there is something really wrong! 
     // An invalid translation was loaded into the page table or TLB. 
-    if (pageFrame >= NumPhysPages) { 
+    if (pageFrame >= (unsigned) NumPhysPages) { 
 	DEBUG(dbgAddr, "Illegal pageframe " << pageFrame);
 	return BusErrorException;
     }
     entry->use = TRUE;		// set the use, dirty bits
     if (writing)
 	entry->dirty = TRUE;
+    if (cacheTranslations) {	// so ReadMem and WriteMem can skip this
+				// (never with a TLB, whose hits are
+				// counted)
+	CachedTranslation *cached = &translationCache[vpn % TranslationCacheSize];
+
+	cached->virtualPage = vpn;
+	cached->entry = entry;
+	cached->physicalPage = pageFrame;
+	cached->memory = &mainMemory[pageFrame * PageSize];
+    }
     *physAddr = pageFrame * PageSize + offset;
     ASSERT((*physAddr >= 0) && ((*physAddr + size) <= MemorySize));
     DEBUG(dbgAddr, "phys addr = " << *physAddr);
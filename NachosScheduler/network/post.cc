@@ -36,6 +36,62 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
     pktHdr = pktH;
     mailHdr = mailH;
     bcopy(msgData, data, mailHdr.length);
+    refs = 1;
+}
+
+//----------------------------------------------------------------------
+// Mail::Mail
+//      Initialize an empty mail message, for the network to read a
+//	packet into, or a sender to fill in.  Its headers are where they
+//	are on the wire.
+//----------------------------------------------------------------------
+
+Mail::Mail()
+{
+    ASSERT(Wire() + sizeof(PacketHeader) == (char *) &mailHdr
+           && (char *) &mailHdr + sizeof(MailHeader) == data);
+    pktHdr.length = 0;
+    mailHdr.length = 0;
+    refs = 1;
+}
+
+//----------------------------------------------------------------------
+// Mail::operator new, Mail::operator delete
+// 	Mail is carved out of slabs of MailsPerSlab, and a message that
+//	has been received is reused by the next to arrive.
+//----------------------------------------------------------------------
+
+ObjectPool *Mail::pool = NULL;
+
+void *
+Mail::operator new(size_t size)
+{
+    ASSERT(size == sizeof(Mail));
+    if (pool == NULL) {
+        pool = new ObjectPool(sizeof(Mail), MailsPerSlab);
+    }
+    return pool->Alloc();
+}
+
+void
+Mail::operator delete(void *mail)
+{
+    pool->Free(mail);
+}
+
+//----------------------------------------------------------------------
+// Mail::Release
+// 	Drop a reference to a message, and delete it if it was the last.
+//	Only a message from "new" can be released.
+//----------------------------------------------------------------------
+
+void
+Mail::Release()
+{
+    ASSERT(refs > 0);
+    if (--refs == 0) {
+        delete this;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -60,8 +116,15 @@ MailBox::MailBox()
 //	in the mailbox.
 //----------------------------------------------------------------------
 
+static void
+ReleaseMail(Mail *mail)
+{
+    mail->Release();
+}
+
 MailBox::~MailBox()
 { 
+    messages->Apply(ReleaseMail);
     delete messages; 
 }
 
@@ -97,8 +160,18 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 void 
 MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 { 
-    Mail *mail = new Mail(pktHdr, mailHdr, data); 
+    Put(new Mail(pktHdr, mailHdr, data));
+}
 
+//----------------------------------------------------------------------
+// MailBox::Put
+// 	Add a message to the mailbox as it is, without copying it.  The
+//	caller's reference to it goes with it.
+//----------------------------------------------------------------------
+
+void 
+MailBox::Put(Mail *mail)
+{ 
     messages->Append(mail);		// put on the end of the list of 
 					// arrived messages, and wake up 
 					// any waiters
@@ -119,23 +192,38 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 void 
 MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
 { 
-    DEBUG(dbgNet, "Waiting for mail in mailbox");
-    Mail *mail = messages->RemoveFront();	// remove message from list;
-						// will wait if list is empty
+    Mail *mail = Get();
 
     *pktHdr = mail->pktHdr;
     *mailHdr = mail->mailHdr;
-    if (debug->IsEnabled('n')) {
-	cout << "Got mail from mailbox: ";
-	PrintHeader(*pktHdr, *mailHdr);
-    }
     bcopy(mail->data, data, mail->mailHdr.length);
 					// copy the message data into
 					// the caller's buffer
-    delete mail;			// we've copied out the stuff we
+    mail->Release();			// we've copied out the stuff we
 					// need, we can now discard the message
 }
 
+//----------------------------------------------------------------------
+// MailBox::Get
+// 	Get a message from a mailbox, as it is, waiting if there are no
+//	messages.  The caller has its reference, and releases it when it
+//	is done with the message.
+//----------------------------------------------------------------------
+
+Mail *
+MailBox::Get() 
+{ 
+    DEBUG(dbgNet, "Waiting for mail in mailbox");
+    Mail *mail = messages->RemoveFront();	// remove message from list;
+						// will wait if list is empty
+
+    if (DEBUG_ON(dbgNet)) {
+	cout << "Got mail from mailbox: ";
+	PrintHeader(mail->pktHdr, mail->mailHdr);
+    }
+    return mail;
+}
+
 //----------------------------------------------------------------------
 // PostOfficeInput::PostOfficeInput
 // 	Initialize the post office input queues as a collection of mailboxes.
@@ -158,8 +246,10 @@ PostOfficeInput::PostOfficeInput(int nBoxes)
     boxes = new MailBox[nBoxes];
 
     network = new NetworkInput(this);
+    posted = new Mail;			// before the first packet can
+    network->Post(posted->Wire());	// come in
 
-    Thread *t = new Thread("postal worker", 1);
+    Thread *t = new Thread("postal worker", kernel->threads->NewID());
 
     t->Fork(PostOfficeInput::PostalDelivery, this);
 }
@@ -177,41 +267,43 @@ PostOfficeInput::~PostOfficeInput()
 {
     delete network;
     delete [] boxes;
+    posted->Release();
 }
 
 //----------------------------------------------------------------------
 // PostOffice::PostalDelivery
 // 	Wait for incoming messages, and put them in the right mailbox.
 //
-//      Incoming messages have had the PacketHeader stripped off,
-//	but the MailHeader is still tacked on the front of the data.
+//      Each incoming message has been read straight into the Mail
+//	posted for it, headers and all, so it goes into the mailbox as
+//	it is; another is posted for the next before it does.
 //----------------------------------------------------------------------
 
 void
 PostOfficeInput::PostalDelivery(void* data)
 {
     PostOfficeInput* _this = (PostOfficeInput*)data;
-    PacketHeader pktHdr;
-    MailHeader mailHdr;
-    char *buffer = new char[MaxPacketSize];
+    Mail *mail;
 
     for (;;) {
         // first, wait for a message
         _this->messageAvailable->P();	
-        pktHdr = _this->network->Receive(buffer);
+        (void) _this->network->Take();
+        mail = _this->posted;
+        _this->posted = new Mail;
+        _this->network->Post(_this->posted->Wire());
 
-        mailHdr = *(MailHeader *)buffer;
-        if (debug->IsEnabled('n')) {
+        if (DEBUG_ON(dbgNet)) {
 	    cout << "Putting mail into mailbox: ";
-	    PrintHeader(pktHdr, mailHdr);
+	    PrintHeader(mail->pktHdr, mail->mailHdr);
         }
 
 	// check that arriving message is legal!
-	ASSERT(0 <= mailHdr.to && mailHdr.to < _this->numBoxes);
-	ASSERT(mailHdr.length <= MaxMailSize);
+	ASSERT(0 <= mail->mailHdr.to && mail->mailHdr.to < _this->numBoxes);
+	ASSERT(mail->mailHdr.length <= MaxMailSize);
 
 	// put into mailbox
-        _this->boxes[mailHdr.to].Put(pktHdr, mailHdr, buffer + sizeof(MailHeader));
+        _this->boxes[mail->mailHdr.to].Put(mail);
     }
 }
 
@@ -240,6 +332,23 @@ PostOfficeInput::Receive(int box, PacketHeader *pktHdr,
     ASSERT(mailHdr->length <= MaxMailSize);
 }
 
+//----------------------------------------------------------------------
+// PostOfficeInput::Receive
+// 	Retrieve a message from a specific box, waiting for one if there
+//	is none, and hand it over as it came off the network, without
+//	copying it.  The caller releases it when it is done with it.
+//
+//	"box" -- mailbox ID in which to look for message
+//----------------------------------------------------------------------
+
+Mail *
+PostOfficeInput::Receive(int box)
+{
+    ASSERT((box >= 0) && (box < numBoxes));
+
+    return boxes[box].Get();
+}
+
 //----------------------------------------------------------------------
 // PostOffice::CallBack
 // 	Interrupt handler, called when a packet arrives from the network.
@@ -261,14 +370,15 @@ PostOfficeInput::CallBack()
 //	  be delivered (e.g., reliability = 1 means the network never
 //	  drops any packets; reliability = 0 means the network never
 //	  delivers any packets)
+//	"linkFile" is as for NetworkOutput
 //----------------------------------------------------------------------
 
-PostOfficeOutput::PostOfficeOutput(double reliability)
+PostOfficeOutput::PostOfficeOutput(double reliability, char *linkFile)
 {
     messageSent = new Semaphore("message sent", 0);
     sendLock = new Lock("message send lock");
 
-    network = new NetworkOutput(reliability, this);
+    network = new NetworkOutput(reliability, this, linkFile);
 }
 
 //----------------------------------------------------------------------
@@ -287,6 +397,7 @@ PostOfficeOutput::~PostOfficeOutput()
 // PostOfficeOutput::Send
 // 	Concatenate the MailHeader to the front of the data, and pass 
 //	the result to the Network for delivery to the destination machine.
+//	They are put together once, in a Mail that is sent from in place.
 //
 //	Note that the MailHeader + data looks just like normal payload
 //	data to the Network.
@@ -299,33 +410,44 @@ PostOfficeOutput::~PostOfficeOutput()
 void
 PostOfficeOutput::Send(PacketHeader pktHdr, MailHeader mailHdr, char* data)
 {
-    char* buffer = new char[MaxPacketSize];	// space to hold concatenated
-						// mailHdr + data
-
-    if (debug->IsEnabled('n')) {
-	cout << "Post send: ";
-	PrintHeader(pktHdr, mailHdr);
-    }
     ASSERT(mailHdr.length <= MaxMailSize);
-    ASSERT(0 <= mailHdr.to);
+
+    Mail mail(pktHdr, mailHdr, data);	// the packet, built where it
+					// is sent from
+
+    Send(&mail);
+}
+
+//----------------------------------------------------------------------
+// PostOfficeOutput::Send
+// 	Send a message that is already in a Mail, to the machine and
+//	mailbox in its headers, straight from where it is.  We fill in
+//	the rest of its PacketHeader; the caller still has its reference
+//	when we return.
+//
+//	"mail" -- the message, with its destination and length
+//----------------------------------------------------------------------
+
+void
+PostOfficeOutput::Send(Mail *mail)
+{
+    ASSERT(mail->mailHdr.length <= MaxMailSize);
+    ASSERT(0 <= mail->mailHdr.to);
     
     // fill in pktHdr, for the Network layer
-    pktHdr.from = kernel->hostName;
-    pktHdr.length = mailHdr.length + sizeof(MailHeader);
-
-    // concatenate MailHeader and data
-    bcopy((char *)&mailHdr, buffer, sizeof(MailHeader));
-    bcopy(data, buffer + sizeof(MailHeader), mailHdr.length);
+    mail->pktHdr.from = kernel->hostName;
+    mail->pktHdr.length = mail->mailHdr.length + sizeof(MailHeader);
+    if (DEBUG_ON(dbgNet)) {
+	cout << "Post send: ";
+	PrintHeader(mail->pktHdr, mail->mailHdr);
+    }
 
     sendLock->Acquire();   		// only one message can be sent
 					// to the network at any one time
-    network->Send(pktHdr, buffer);
+    network->Send(mail->Wire());
     messageSent->P();			// wait for interrupt to tell us
 					// ok to send the next message
     sendLock->Release();
-
-    delete [] buffer;			// we've sent the message, so
-					// we can delete our buffer
 }
 
 //----------------------------------------------------------------------
@@ -33,6 +33,7 @@
 #include "network.h"
 #include "synchlist.h"
 #include "synch.h"
+#include "pool.h"
 
 // Mailbox address -- uniquely identifies a mailbox on a given machine.
 // A mailbox is just a place for temporary storage for messages.
@@ -61,16 +62,41 @@ class MailHeader {
 //	network header (PacketHeader) 
 //	post office header (MailHeader) 
 //	data
+//
+// That is just how a packet is on the wire, so the network reads an
+// incoming packet straight into a Mail (see NetworkInput::Post), and
+// sends an outgoing one straight from it: the message stays where it
+// is from the socket to whoever receives it.
+//
+// Mail is counted: each holder of a reference calls Release when it
+// is done, and the last one deletes it -- back to a pool, so the
+// next packet reuses it.
+
+const int MailsPerSlab = 16;	// Mail allocated at a time
 
 class Mail {
   public:
      Mail(PacketHeader pktH, MailHeader mailH, char *msgData);
 				// Initialize a mail message by
 				// concatenating the headers to the data
+     Mail();			// Or an empty one, to be filled in place
+
+     static void *operator new(size_t size);	// from the pool
+     static void operator delete(void *mail);	// back to it
+
+     void Hold() { refs++; }	// Another reference to it
+     void Release();		// Done with one; delete it after the last
+     char *Wire() { return (char *) &pktHdr; }
+				// The packet, as it goes on the wire
 
      PacketHeader pktHdr;	// Header appended by Network
      MailHeader mailHdr;	// Header appended by PostOffice
      char data[MaxMailSize];	// Payload -- message data
+
+  private:
+     int refs;			// References still held
+
+     static ObjectPool *pool;	// Freed Mail
 };
 
 // The following class defines a single mailbox, or temporary storage
@@ -85,10 +111,12 @@ class MailBox {
 
     void Put(PacketHeader pktHdr, MailHeader mailHdr, char *data);
    				// Atomically put a message into the mailbox
+    void Put(Mail *mail);	// Or the mail itself, and our reference
     void Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data); 
    				// Atomically get a message out of the 
 				// mailbox (and wait if there is no message 
 				// to get!)
+    Mail *Get();		// Or the mail itself, and its reference
   private:
     SynchList<Mail *> *messages; // A mailbox is just a list of arrived messages
 };
@@ -111,6 +139,8 @@ class PostOfficeInput : public CallBackObj {
 		MailHeader *mailHdr, char *data);
     				// Retrieve a message from "box".  Wait if
 				// there is no message in the box.
+    Mail *Receive(int box);	// Or hand over the mail itself, without
+				// copying it; the caller Releases it
 
     static void PostalDelivery(void* data);
 				// Wait for incoming messages, 
@@ -125,20 +155,26 @@ class PostOfficeInput : public CallBackObj {
     MailBox *boxes;		// Table of mail boxes to hold incoming mail
     int numBoxes;		// Number of mail boxes
     Semaphore *messageAvailable;// V'ed when message has arrived from network
+    Mail *posted;		// The next packet is read into this
 };
 
 class PostOfficeOutput : public CallBackObj {
   public:
-    PostOfficeOutput(double reliability);
+    PostOfficeOutput(double reliability, char *linkFile);
 				// Allocate and initialize output
 				//   "reliability" is how many packets
 				//   get dropped by the underlying network
+				//   "linkFile" gives the latency and
+				//   bandwidth of its links, or is NULL
     ~PostOfficeOutput();	// De-allocate Post Office data
 
     void Send(PacketHeader pktHdr, MailHeader mailHdr, char *data);
     				// Send a message to a mailbox on a remote 
 				// machine.  The fromBox in the MailHeader is 
 				// the return box for ack's.
+    void Send(Mail *mail);	// Or mail already filled in, without
+				// copying it; the caller still holds it,
+				// and can send it again
 
     void CallBack();		// Called when outgoing packet has been 
 				// put on network; next packet can now be sent
@@ -0,0 +1,749 @@
+// transport.cc
+//	Routines to deliver messages reliably, over the post office: to
+//	cut them into segments, keep a window of those in flight, and
+//	send again those that aren't acknowledged in time.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "transport.h"
+#include "synch.h"
+#include "main.h"
+
+// The retransmission timeout, in ticks: before there is a round trip
+// time to go by, and the least and the most there can be.  NetworkTime
+// is only known once the configuration has been read.
+#define InitialTimeout (20 * NetworkTime)
+#define MinTimeout (4 * NetworkTime)
+#define MaxTimeout (640 * NetworkTime)
+
+//----------------------------------------------------------------------
+// Message::Message
+// 	Keep a copy of a message that has arrived.
+//----------------------------------------------------------------------
+
+Message::Message(PacketHeader pktH, MailHeader mailH, char *msgData)
+{
+    pktHdr = pktH;
+    mailHdr = mailH;
+    data = new char[mailHdr.length + 1];
+    bcopy(msgData, data, mailHdr.length);
+}
+
+//----------------------------------------------------------------------
+// Connection::Connection
+// 	Initialize what we know of a machine we haven't talked to yet:
+//	no segments either way.
+//----------------------------------------------------------------------
+
+Connection::Connection()
+{
+    base = nextSeq = 0;
+    expected = 0;
+    numDuplicates = 0;
+    for (int i = 0; i < MaxWindow; i++) {
+        unacked[i] = NULL;
+        early[i] = NULL;
+    }
+    partialHdr.length = 0;
+    finished = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Connection::~Connection
+// 	De-allocate a connection, and the segments it still has.
+//----------------------------------------------------------------------
+
+Connection::~Connection()
+{
+    for (int i = 0; i < MaxWindow; i++) {
+        delete unacked[i];
+        delete early[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// Transport::Transport
+// 	Initialize the transport, over the post office "in" and "out",
+//	with nothing sent or received, and start its threads: one to take
+//	what arrives at TransportBox, and one to retransmit.  Register
+//	the counters of segments sent and acknowledged.
+//
+//	"window" is how many segments can be out at once, per machine.
+//----------------------------------------------------------------------
+
+Transport::Transport(PostOfficeInput *in, PostOfficeOutput *out, int window)
+{
+    Thread *thread;
+
+    ASSERT(window >= 1 && window <= MaxWindow);
+    postIn = in;
+    postOut = out;
+    windowSize = window;
+    for (int i = 0; i < MaxHosts; i++) {
+        connections[i] = NULL;
+    }
+    for (int i = 0; i < NumTransportBoxes; i++) {
+        boxes[i] = new List<Message *>;
+    }
+    lock = new Lock("transport");
+    sendLock = new Lock("transport send");
+    windowOpen = new Condition("transport window open");
+    arrived = new Condition("transport message arrived");
+    timeout = new Semaphore("transport timeout", 0);
+    timer = NULL;
+    rtt = rttDeviation = 0;
+    rto = InitialTimeout;
+    numMessagesSent = numBytesSent = 0;
+    numMessagesReceived = numBytesReceived = 0;
+    numSegments = numRetransmits = numFastRetransmits = 0;
+    numAcksSent = numDuplicatesReceived = 0;
+    numDropped = 0;
+    firstSend = lastAck = -1;
+    kernel->registry->AddCounter("transport.segments", &numSegments);
+    kernel->registry->AddCounter("transport.retransmits", &numRetransmits);
+    kernel->registry->AddCounter("transport.acks", &numAcksSent);
+    kernel->registry->AddCounter("transport.duplicates",
+                                 &numDuplicatesReceived);
+
+    thread = new Thread("transport receiver", kernel->threads->NewID());
+    thread->Fork((VoidFunctionPtr) &Transport::ReceiverThread, (void *) this);
+    thread = new Thread("transport retransmitter", kernel->threads->NewID());
+    thread->Fork((VoidFunctionPtr) &Transport::RetransmitterThread,
+                 (void *) this);
+}
+
+//----------------------------------------------------------------------
+// Transport::~Transport
+// 	De-allocate the transport.  Its threads are waiting, so, as with
+//	the post office's, what they wait on is left allocated.
+//----------------------------------------------------------------------
+
+Transport::~Transport()
+{
+    for (int i = 0; i < MaxHosts; i++) {
+        delete connections[i];
+    }
+    for (int i = 0; i < NumTransportBoxes; i++) {
+        while (!boxes[i]->IsEmpty()) {
+            delete boxes[i]->RemoveFront();
+        }
+        delete boxes[i];
+    }
+    delete sendLock;
+}
+
+//----------------------------------------------------------------------
+// Transport::Send
+// 	Send a message to a mailbox of the transport on another machine,
+//	a segment at a time, waiting only while the window to it is full.
+//	It gets there, in order, unless the machine is gone.
+//
+//	"pktHdr" -- the destination machine
+//	"mailHdr" -- the destination mailbox, the one to reply to, and
+//		the length of the message, up to MaxMessageSize
+//	"data" -- the message
+//----------------------------------------------------------------------
+
+void
+Transport::Send(PacketHeader pktHdr, MailHeader mailHdr, char *data)
+{
+    int host = pktHdr.to;
+    int length = mailHdr.length;
+    int done = 0;
+    Connection *connection;
+
+    ASSERT(0 <= host && host < MaxHosts);
+    ASSERT(0 <= mailHdr.to && mailHdr.to < NumTransportBoxes);
+    ASSERT(0 <= mailHdr.from && mailHdr.from < NumTransportBoxes);
+    ASSERT(length <= MaxMessageSize);
+
+    sendLock->Acquire();
+    lock->Acquire();
+    connection = ConnectionTo(host);
+    if (firstSend < 0) {
+        firstSend = kernel->stats->totalTicks;
+    }
+    do {
+        int size = min(length - done, MaxSegmentData);
+
+        Queue(host, connection, (done + size == length) ? SegmentLast : 0,
+              mailHdr.to, mailHdr.from, data + done, size);
+        done += size;
+    } while (done < length);
+    numMessagesSent++;
+    numBytesSent += length;
+    DEBUG(dbgNet, "Transport sent " << length << " bytes to " << host
+          << ", box " << mailHdr.to);
+    lock->Release();
+    sendLock->Release();
+}
+
+//----------------------------------------------------------------------
+// Transport::Receive
+// 	Wait for a message in one of our mailboxes, and copy it out, as
+//	PostOfficeInput::Receive does.
+//
+//	"box" -- the mailbox to take it from
+//	"pktHdr" -- where to put: the machine it came from
+//	"mailHdr" -- and the box to reply to, and its length
+//	"data" -- and the message, which has room for MaxMessageSize bytes
+//----------------------------------------------------------------------
+
+void
+Transport::Receive(int box, PacketHeader *pktHdr, MailHeader *mailHdr,
+                   char *data)
+{
+    Message *message;
+
+    ASSERT(0 <= box && box < NumTransportBoxes);
+    lock->Acquire();
+    while (boxes[box]->IsEmpty()) {
+        arrived->Wait(lock);
+    }
+    message = boxes[box]->RemoveFront();
+    lock->Release();
+
+    *pktHdr = message->pktHdr;
+    *mailHdr = message->mailHdr;
+    bcopy(message->data, data, message->mailHdr.length);
+    delete message;
+}
+
+//----------------------------------------------------------------------
+// Transport::Drain
+// 	We have nothing more to send: say so to every machine we talked
+//	to, with a SegmentFin after whatever is still out to it, then wait
+//	until all of it is acknowledged, and each of them has said the
+//	same to us.  Once it has, it has had everything from us, and we
+//	from it.
+//
+//	Our acknowledgement of its SegmentFin may be lost, though, so we
+//	stay a while longer -- two retransmission timeouts, as TCP's
+//	TIME_WAIT does -- to acknowledge it again if it comes back.
+//----------------------------------------------------------------------
+
+void
+Transport::Drain()
+{
+    bool pending;
+
+    sendLock->Acquire();
+    lock->Acquire();
+    for (int host = 0; host < MaxHosts; host++) {
+        if (connections[host] != NULL) {
+            Queue(host, connections[host], SegmentFin, 0, 0, NULL, 0);
+        }
+    }
+    do {
+        pending = FALSE;
+        for (int host = 0; host < MaxHosts; host++) {
+            Connection *connection = connections[host];
+
+            if (connection != NULL && (connection->base < connection->nextSeq
+                                         || !connection->finished)) {
+                pending = TRUE;
+            }
+        }
+        if (pending) {
+            windowOpen->Wait(lock);
+        }
+    } while (pending);
+    lock->Release();
+    sendLock->Release();
+
+    kernel->currentCPU->alarm->WaitUntil(2 * rto);
+}
+
+//----------------------------------------------------------------------
+// Transport::ConnectionTo
+// 	Return what we know of machine "host", starting afresh if we
+//	haven't talked to it yet.  The lock is held.
+//----------------------------------------------------------------------
+
+Connection *
+Transport::ConnectionTo(int host)
+{
+    ASSERT(0 <= host && host < MaxHosts);
+    if (connections[host] == NULL) {
+        connections[host] = new Connection;
+    }
+    return connections[host];
+}
+
+//----------------------------------------------------------------------
+// Transport::Queue
+// 	Wait until there is room in the window to machine "host", then
+//	number a segment of "size" bytes of "data", for our mailbox "to"
+//	on it, keep it until it is acknowledged, and send it.  The data
+//	is copied once, into the Mail the segment goes in.  The lock is
+//	held.
+//
+//	"flags" -- SegmentLast, if it ends a message, or SegmentFin
+//	"from" -- the mailbox to reply to
+//----------------------------------------------------------------------
+
+void
+Transport::Queue(int host, Connection *connection, int flags, int to,
+                 int from, char *data, int size)
+{
+    DataSegment *segment;
+    Mail *mail;
+
+    while (connection->nextSeq - connection->base >= windowSize) {
+        windowOpen->Wait(lock);
+    }
+    mail = new Mail;
+    mail->pktHdr.to = host;
+    mail->mailHdr.to = TransportBox;
+    mail->mailHdr.from = TransportBox;
+    mail->mailHdr.length = sizeof(SegmentHeader) + size;
+    segment = new DataSegment(mail);
+    segment->hdr->seq = connection->nextSeq++;
+    segment->hdr->ack = 0;
+    segment->hdr->sack = 0;
+    segment->hdr->flags = SegmentData | flags;
+    segment->hdr->to = to;
+    segment->hdr->from = from;
+    segment->hdr->length = size;
+    bcopy(data, segment->Data(), size);
+    connection->unacked[segment->hdr->seq % MaxWindow] = segment;
+    numSegments++;
+    Transmit(host, segment);
+}
+
+//----------------------------------------------------------------------
+// Transport::Transmit
+// 	Send "segment" to machine "host", the first time or again, and
+//	make sure a timeout is on its way.  It goes from its Mail as it
+//	is.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+Transport::Transmit(int host, DataSegment *segment)
+{
+    ASSERT(segment->mail->pktHdr.to == host);
+    if (segment->numSends++ > 0) {
+        DEBUG(dbgNet, "Transport resending segment " << segment->hdr->seq
+              << " to " << host);
+        numRetransmits++;
+    }
+    segment->sentAt = kernel->stats->totalTicks;
+    postOut->Send(segment->mail);
+    if (timer == NULL) {
+        SetTimer();
+    }
+}
+
+//----------------------------------------------------------------------
+// Transport::SendAck
+// 	Tell machine "host" which of its segments we have: all those
+//	before the one we expect next, and those after it that came
+//	early.  The ack is built in the Mail it is sent from.  The lock
+//	is held.
+//----------------------------------------------------------------------
+
+void
+Transport::SendAck(int host, Connection *connection)
+{
+    Mail ack;
+    SegmentHeader *hdr = (SegmentHeader *) ack.data;
+
+    hdr->seq = 0;
+    hdr->ack = connection->expected;
+    hdr->sack = 0;
+    for (int i = 0; i < MaxWindow - 1; i++) {
+        if (connection->early[(hdr->ack + 1 + i) % MaxWindow] != NULL) {
+            hdr->sack |= 1u << i;
+        }
+    }
+    hdr->flags = SegmentAck;
+    hdr->to = hdr->from = 0;
+    hdr->length = 0;
+    ack.pktHdr.to = host;
+    ack.mailHdr.to = TransportBox;
+    ack.mailHdr.from = TransportBox;
+    ack.mailHdr.length = sizeof(SegmentHeader);
+    numAcksSent++;
+    postOut->Send(&ack);
+}
+
+//----------------------------------------------------------------------
+// Transport::Acknowledged
+// 	An ack came from machine "host": forget the segments it has, and
+//	open the window past the ones it has in order.  If it is the
+//	third in a row still waiting for the first segment in the window,
+//	that one was probably lost: send it again now, rather than when
+//	it times out.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+Transport::Acknowledged(int host, SegmentHeader *hdr)
+{
+    Connection *connection = ConnectionTo(host);
+    int now = kernel->stats->totalTicks;
+
+    if (hdr->ack > connection->nextSeq) {
+        return;				// not for anything we sent
+    }
+    if (hdr->ack > connection->base) {
+        for (int seq = connection->base; seq < hdr->ack; seq++) {
+            DataSegment *segment = connection->unacked[seq % MaxWindow];
+
+            if (segment != NULL) {
+                if (segment->numSends == 1) {	// only then is it clear
+                    Sample(now - segment->sentAt);	// which one was
+                }					// acknowledged
+                delete segment;
+                connection->unacked[seq % MaxWindow] = NULL;
+            }
+        }
+        connection->base = hdr->ack;
+        connection->numDuplicates = 0;
+        lastAck = now;
+        windowOpen->Broadcast(lock);
+    } else if (hdr->ack == connection->base
+               && connection->base < connection->nextSeq) {
+        numDuplicatesReceived++;
+        if (++connection->numDuplicates == 3
+              && connection->unacked[connection->base % MaxWindow] != NULL) {
+            numFastRetransmits++;
+            Transmit(host, connection->unacked[connection->base % MaxWindow]);
+        }
+    }
+    for (int i = 0; i < MaxWindow - 1; i++) {
+        int seq = hdr->ack + 1 + i;
+        DataSegment *segment;
+
+        if (!(hdr->sack & (1u << i)) || seq < connection->base
+              || seq >= connection->nextSeq) {
+            continue;
+        }
+        segment = connection->unacked[seq % MaxWindow];
+        if (segment != NULL) {		// it needn't be sent again
+            if (segment->numSends == 1) {
+                Sample(now - segment->sentAt);
+            }
+            delete segment;
+            connection->unacked[seq % MaxWindow] = NULL;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Transport::Arrived
+// 	A data segment came: keep it, if it is one we haven't got, then
+//	pass on the segments we now have in order, and acknowledge.  A
+//	segment we already have is acknowledged again: our ack was lost.
+//	The lock is held.
+//
+//	"mail" -- the segment, as it came off the network; a segment
+//		we keep is kept in it, and our reference goes with it
+//----------------------------------------------------------------------
+
+void
+Transport::Arrived(Mail *mail)
+{
+    SegmentHeader *hdr = (SegmentHeader *) mail->data;
+    int host = mail->pktHdr.from;
+    Connection *connection = ConnectionTo(host);
+    int seq = hdr->seq;
+
+    if (seq >= connection->expected
+          && seq < connection->expected + MaxWindow
+          && connection->early[seq % MaxWindow] == NULL) {
+        DataSegment *segment = new DataSegment(mail);
+
+        ASSERT(hdr->length <= MaxSegmentData && hdr->to < NumTransportBoxes);
+        connection->early[seq % MaxWindow] = segment;
+        while ((segment = connection->early[connection->expected % MaxWindow])
+                   != NULL) {
+            connection->early[connection->expected % MaxWindow] = NULL;
+            connection->expected++;
+            Deliver(host, connection, segment);
+            delete segment;
+        }
+    } else {
+        mail->Release();
+    }
+    SendAck(host, connection);
+}
+
+//----------------------------------------------------------------------
+// Transport::Deliver
+// 	Add the next segment from machine "host" to the message it is
+//	part of, and if it is the last, put the message in its mailbox.
+//	If it is a SegmentFin, the machine is done: wake Drain.  The lock
+//	is held.
+//----------------------------------------------------------------------
+
+void
+Transport::Deliver(int host, Connection *connection, DataSegment *segment)
+{
+    MailHeader *mailHdr = &connection->partialHdr;
+    PacketHeader pktHdr;
+
+    if (segment->hdr->flags & SegmentFin) {
+        DEBUG(dbgNet, "Transport: " << host << " is done");
+        connection->finished = TRUE;
+        windowOpen->Broadcast(lock);
+        return;
+    }
+    ASSERT(mailHdr->length + segment->hdr->length <= MaxMessageSize);
+    mailHdr->to = segment->hdr->to;
+    mailHdr->from = segment->hdr->from;
+    bcopy(segment->Data(), connection->partial + mailHdr->length,
+          segment->hdr->length);
+    mailHdr->length += segment->hdr->length;
+    if (segment->hdr->flags & SegmentLast) {
+        pktHdr.from = host;
+        pktHdr.to = kernel->hostName;
+        pktHdr.length = mailHdr->length;
+        DEBUG(dbgNet, "Transport received " << mailHdr->length
+              << " bytes from " << host << ", box " << mailHdr->to);
+        boxes[mailHdr->to]->Append(new Message(pktHdr, *mailHdr,
+                                               connection->partial));
+        numMessagesReceived++;
+        numBytesReceived += mailHdr->length;
+        mailHdr->length = 0;
+        arrived->Broadcast(lock);
+    }
+}
+
+//----------------------------------------------------------------------
+// Transport::Sample
+// 	A segment sent once was acknowledged "ticks" after: update the
+//	smoothed round trip time and its deviation, and the timeout
+//	from them, as Jacobson's algorithm has it.
+//----------------------------------------------------------------------
+
+void
+Transport::Sample(int ticks)
+{
+    if (rtt == 0) {			// the first
+        rtt = ticks;
+        rttDeviation = ticks / 2;
+    } else {
+        int error = ticks - rtt;
+
+        rtt += error / 8;
+        rttDeviation += (((error < 0) ? -error : error) - rttDeviation) / 4;
+    }
+    rto = max(MinTimeout, min(MaxTimeout, rtt + 4 * rttDeviation));
+}
+
+//----------------------------------------------------------------------
+// Transport::SetTimer
+// 	Have the timeout interrupt go off when the segment due first is,
+//	instead of when it was going to; or not at all, if every segment
+//	is acknowledged.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+Transport::SetTimer()
+{
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    int due = -1;
+
+    if (timer != NULL) {
+        kernel->interrupt->Cancel(timer);
+        timer = NULL;
+    }
+    for (int host = 0; host < MaxHosts; host++) {
+        Connection *connection = connections[host];
+
+        if (connection == NULL) {
+            continue;
+        }
+        for (int seq = connection->base; seq < connection->nextSeq; seq++) {
+            DataSegment *segment = connection->unacked[seq % MaxWindow];
+
+            if (segment != NULL && (due < 0 || segment->sentAt + rto < due)) {
+                due = segment->sentAt + rto;
+            }
+        }
+    }
+    if (due >= 0) {
+        timer = kernel->interrupt->Schedule(this,
+                    max(due - kernel->stats->totalTicks, 1), TransportInt);
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Transport::Retransmit
+// 	Send again every segment that has timed out, and back off: the
+//	network may be busier than the round trip time says.  A machine
+//	that hasn't acknowledged a segment sent to it MaxSends times is
+//	given up on.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+Transport::Retransmit()
+{
+    bool any = FALSE;
+
+    for (int host = 0; host < MaxHosts; host++) {
+        Connection *connection = connections[host];
+
+        if (connection == NULL) {
+            continue;
+        }
+        for (int seq = connection->base; seq < connection->nextSeq; seq++) {
+            DataSegment *segment = connection->unacked[seq % MaxWindow];
+
+            if (segment != NULL
+                  && segment->sentAt + rto <= kernel->stats->totalTicks) {
+                if (segment->numSends >= MaxSends) {
+                    GiveUp(host, connection);
+                    break;
+                }
+                Transmit(host, segment);
+                any = TRUE;
+            }
+        }
+    }
+    if (any) {
+        rto = min(2 * rto, MaxTimeout);
+    }
+    SetTimer();
+}
+
+//----------------------------------------------------------------------
+// Transport::GiveUp
+// 	Machine "host" has stopped acknowledging what we send it, most
+//	likely because it has halted: drop the segments still out to it,
+//	as if it had them, so that those sending to it, or draining, wait
+//	no more.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+Transport::GiveUp(int host, Connection *connection)
+{
+    DEBUG(dbgNet, "Transport giving up on " << host << ", segments "
+          << connection->base << " to " << connection->nextSeq - 1);
+    for (int seq = connection->base; seq < connection->nextSeq; seq++) {
+        DataSegment *segment = connection->unacked[seq % MaxWindow];
+
+        if (segment != NULL) {
+            numDropped++;
+            delete segment;
+            connection->unacked[seq % MaxWindow] = NULL;
+        }
+    }
+    connection->base = connection->nextSeq;
+    connection->numDuplicates = 0;
+    connection->finished = TRUE;	// nor will it say it is done
+    windowOpen->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// Transport::CallBack
+// 	The timeout interrupt: wake the retransmitter.
+//----------------------------------------------------------------------
+
+void
+Transport::CallBack()
+{
+    timer = NULL;			// it is deleted after this
+    timeout->V();
+}
+
+//----------------------------------------------------------------------
+// Transport::Print
+// 	Print, when Nachos halts, what went each way, what had to be
+//	sent again, and the rate data was acknowledged at.
+//----------------------------------------------------------------------
+
+void
+Transport::Print()
+{
+    cout << "Transport: messages sent " << numMessagesSent << " ("
+         << numBytesSent << " bytes), received " << numMessagesReceived
+         << " (" << numBytesReceived << " bytes)\n";
+    cout << "Transport: segments sent " << numSegments << ", retransmitted "
+         << numRetransmits << " (" << numFastRetransmits << " fast), "
+         << numDuplicatesReceived << " duplicate acks; acks sent "
+         << numAcksSent << "; window " << windowSize << ", timeout "
+         << rto << " ticks\n";
+    if (numDropped > 0) {
+        cout << "Transport: segments dropped " << numDropped
+             << ", their machine gone\n";
+    }
+    if (lastAck > firstSend) {
+        char rate[32];
+
+        sprintf(rate, "%.2f", 1000.0 * numBytesSent / (lastAck - firstSend));
+        cout << "Transport: throughput " << rate << " bytes per 1000 ticks\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// Transport::ReceiverThread
+// 	The receiver thread starts here.
+//----------------------------------------------------------------------
+
+void
+Transport::ReceiverThread(Transport *transport)
+{
+    transport->ReceiveForever();
+}
+
+//----------------------------------------------------------------------
+// Transport::ReceiveForever
+// 	Take each segment that arrives at TransportBox, as it came off
+//	the network, and see to it.
+//----------------------------------------------------------------------
+
+void
+Transport::ReceiveForever()
+{
+    Mail *mail;
+    SegmentHeader *hdr;
+
+    for (;;) {
+        mail = postIn->Receive(TransportBox);
+        hdr = (SegmentHeader *) mail->data;
+        ASSERT(mail->mailHdr.length == sizeof(SegmentHeader) + hdr->length);
+
+        lock->Acquire();
+        if (hdr->flags & SegmentAck) {
+            Acknowledged(mail->pktHdr.from, hdr);
+        }
+        if (hdr->flags & SegmentData) {
+            Arrived(mail);		// which keeps it, or releases it
+        } else {
+            mail->Release();
+        }
+        lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// Transport::RetransmitterThread
+// 	The retransmitter thread starts here.
+//----------------------------------------------------------------------
+
+void
+Transport::RetransmitterThread(Transport *transport)
+{
+    transport->RetransmitForever();
+}
+
+//----------------------------------------------------------------------
+// Transport::RetransmitForever
+// 	Wait for a timeout, then send again what is due; and again.
+//----------------------------------------------------------------------
+
+void
+Transport::RetransmitForever()
+{
+    for (;;) {
+        timeout->P();
+        lock->Acquire();
+        Retransmit();
+        lock->Release();
+    }
+}
@@ -0,0 +1,209 @@
+// transport.h
+//	Data structures for reliable, ordered delivery of messages of
+//	any size, up to MaxMessageSize, to mailboxes on other machines,
+//	on top of the post office (see post.h), which can lose them.
+//
+//	With "-N", the kernel has one (kernel->transport).  It has the
+//	same interface as the post office -- Send a message to a (machine,
+//	mailbox), Receive one from a mailbox -- but the mailboxes are its
+//	own, and all its traffic goes through post office box
+//	TransportBox.
+//
+//	A message is cut into segments of MaxSegmentData bytes, each of
+//	which goes as one piece of mail, with a SegmentHeader in front.
+//	Each machine we talk to has a Connection, and each segment sent
+//	on it a sequence number: as many as "-tw <segments>" (the window,
+//	8 by default) can be out at once, un-acknowledged.  Only when
+//	the window is full does Send wait.
+//
+//	The receiver acknowledges each segment it gets with the number
+//	of the first it has not (everything before it has arrived), and
+//	a bit for each of the segments after that which came early: they
+//	are kept, and need not be sent again.  The sender keeps each
+//	segment until it is acknowledged, and sends it again if it isn't
+//	within a retransmission timeout -- estimated from the round trip
+//	times of the segments acknowledged the first time round, as TCP
+//	does, and doubled on every timeout -- or at once, after three
+//	acknowledgements in a row that say it is still missing.  After
+//	MaxSends tries, the machine is taken to be gone, and what is
+//	still out to it dropped.
+//
+//	Drain ends a run: it sends each machine we talked to a last,
+//	empty segment marked SegmentFin, and returns once each of those
+//	has been acknowledged and each machine has sent us its own.  A
+//	machine that has our SegmentFin and has acknowledged it needs
+//	nothing more from us, so both can halt.
+//
+//	Timeouts are a single interrupt (see Interrupt::Schedule), for the
+//	segment due first; the interrupt handler can't send, so a thread
+//	of ours does.  Another takes what arrives at TransportBox.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "callback.h"
+#include "post.h"
+#include "list.h"
+#include "stats.h"
+
+class Lock;
+class Condition;
+class Semaphore;
+class PendingInterrupt;
+
+const int TransportBox = 9;		// the post office box we use
+const int NumTransportBoxes = 8;	// mailboxes of our own
+const int MaxMessageSize = 1024;	// bytes Send takes at once
+const int MaxWindow = 32;		// segments out at once, at most
+const int DefaultWindow = 8;		// unless -tw says otherwise
+const int MaxHosts = MaxNetworkHosts;	// machines we can talk to
+const int MaxSends = 30;		// times a segment is sent before
+					// we give up on its machine
+
+// What is in front of the data of each segment.
+
+enum SegmentFlags { SegmentData = 1, SegmentLast = 2, SegmentAck = 4,
+		   SegmentFin = 8 };
+
+class SegmentHeader {
+  public:
+    int seq;			// a data segment's number
+    int ack;			// an ack's: the first segment not in
+    unsigned sack;		// bit i: segment ack + 1 + i came early
+    unsigned char flags;	// SegmentFlags
+    unsigned char to;		// our mailbox the message is for
+    unsigned char from;		// and the one to reply to
+    unsigned char length;	// bytes of data after the header
+};
+
+#define MaxSegmentData	((int) (MaxMailSize - sizeof(SegmentHeader)))
+
+// A data segment, sent and not yet acknowledged, or arrived early.
+// It is kept as the Mail it goes in, so it is sent again, or passed
+// on, from where it is.
+
+class DataSegment {
+  public:
+    DataSegment(Mail *m) { mail = m; hdr = (SegmentHeader *) m->data;
+			   sentAt = numSends = 0; }
+				// takes the reference to "m"
+    ~DataSegment() { mail->Release(); }
+
+    char *Data() { return mail->data + sizeof(SegmentHeader); }
+
+    Mail *mail;			// as it is on the wire
+    SegmentHeader *hdr;		// at the front of its data
+    int sentAt;			// the tick it was last sent
+    int numSends;		// how often it has been
+};
+
+// A message that has arrived, waiting in one of our mailboxes.
+
+class Message {
+  public:
+    Message(PacketHeader pktH, MailHeader mailH, char *msgData);
+    ~Message() { delete [] data; }
+
+    PacketHeader pktHdr;
+    MailHeader mailHdr;		// its length is the message's
+    char *data;
+};
+
+// What we know of the segments to and from one machine.
+
+class Connection {
+  public:
+    Connection();
+    ~Connection();
+
+    int base;			// the first segment not acknowledged
+    int nextSeq;		// the next to send
+    DataSegment *unacked[MaxWindow];	// by number, mod MaxWindow; NULL
+				// once acknowledged
+    int numDuplicates;		// acks in a row for "base"
+
+    int expected;		// the first segment not yet arrived
+    DataSegment *early[MaxWindow];	// those after it that have, or NULL
+    MailHeader partialHdr;	// the message they are part of, so far
+    char partial[MaxMessageSize];
+    bool finished;		// its SegmentFin has arrived
+};
+
+// The following class delivers messages reliably, over the post office.
+
+class Transport : public CallBackObj {
+  public:
+    Transport(PostOfficeInput *in, PostOfficeOutput *out, int window);
+				// start the threads that receive
+				// and retransmit
+    ~Transport();
+
+    void Send(PacketHeader pktHdr, MailHeader mailHdr, char *data);
+				// as PostOfficeOutput, but for a
+				// message of up to MaxMessageSize bytes,
+				// which does get there
+    void Receive(int box, PacketHeader *pktHdr, MailHeader *mailHdr,
+		 char *data);	// as PostOfficeInput, for our boxes
+    void Drain();		// tell the other machines we are done,
+				// and wait until they are too
+
+    void CallBack();		// the retransmission timeout
+    void Print();		// throughput and retransmissions
+
+  private:
+    PostOfficeInput *postIn;
+    PostOfficeOutput *postOut;
+    int windowSize;		// segments out at once, per machine
+    Connection *connections[MaxHosts];	// made as they are needed
+    List<Message *> *boxes[NumTransportBoxes];	// arrived messages
+
+    Lock *lock;			// for all of the above, and below
+    Lock *sendLock;		// one message sent at a time, so that
+				// its segments are consecutive
+    Condition *windowOpen;	// signalled when segments are acked
+    Condition *arrived;		// and when a message comes in
+    Semaphore *timeout;		// V'd by the interrupt
+    PendingInterrupt *timer;	// the interrupt, or NULL
+
+    int rtt;			// the smoothed round trip time, its
+    int rttDeviation;		// mean deviation, and the timeout
+    int rto;			// from them, in ticks
+
+    int numMessagesSent, numBytesSent;
+    int numMessagesReceived, numBytesReceived;
+    int numSegments, numRetransmits, numFastRetransmits;
+    int numAcksSent, numDuplicatesReceived;
+    int numDropped;		// segments to machines that were gone
+    int firstSend;		// when the first data went out, and
+    int lastAck;		// the last was acknowledged
+
+    Connection *ConnectionTo(int host);
+    void Queue(int host, Connection *connection, int flags, int to,
+	       int from, char *data, int size);
+				// send a segment, once the window is open
+    void Transmit(int host, DataSegment *segment);	// send, or send again
+    void SendAck(int host, Connection *connection);
+    void Acknowledged(int host, SegmentHeader *hdr);
+				// an ack came from "host"
+    void Arrived(Mail *mail);	// and a data segment
+    void Deliver(int host, Connection *connection, DataSegment *segment);
+				// the next segment in order
+    void Sample(int ticks);	// a round trip time
+    void SetTimer();		// for the segment due first
+    void Retransmit();		// those due by now
+    void GiveUp(int host, Connection *connection);
+				// on a machine that doesn't answer
+
+    static void ReceiverThread(Transport *transport);
+    void ReceiveForever();	// what the receiver thread does
+    static void RetransmitterThread(Transport *transport);
+    void RetransmitForever();	// and the retransmitter
+};
+
+#endif // TRANSPORT_H
@@ -1,8 +1,7 @@
 // alarm.cc
 //	Routines to use a hardware timer device to provide a
-//	software alarm clock.  For now, we just provide time-slicing.
-//
-//	Not completely implemented.
+//	software alarm clock: time-slicing, and threads that wait
+//	until a tick to come.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -20,17 +19,45 @@
 //		occur at random, instead of fixed, intervals.
 //----------------------------------------------------------------------
 
+static int
+SleeperCompare(Sleeper *x, Sleeper *y)
+{
+    if (x->wakeTime < y->wakeTime) { return -1; }
+    if (x->wakeTime > y->wakeTime) { return 1; }
+    return 0;				// after those already there
+}
+
 Alarm::Alarm(bool doRandom)
 {
     timer = new Timer(doRandom, this);
+    sleepers = new SortedList<Sleeper *>(SleeperCompare);
+    wakeup = new AlarmWakeup(this);
+    wakeupPending = NULL;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+//	De-allocate the alarm.  Threads still sleeping are never woken.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    while (!sleepers->IsEmpty()) {
+	delete sleepers->RemoveFront();
+    }
+    delete sleepers;
+    delete wakeup;
+    delete timer;
 }
 
 //----------------------------------------------------------------------
 // Alarm::CallBack
 //	Software interrupt handler for the timer device. The timer device is
-//	set up to interrupt the CPU periodically (once every TimerTicks).
-//	This routine is called each time there is a timer interrupt,
-//	with interrupts disabled.
+//	programmed to interrupt the CPU when the running thread's time
+//	slice ends; how long that is is up to the scheduling policy, and
+//	it is reprogrammed on every context switch.  This routine is
+//	called each time there is a timer interrupt, with interrupts
+//	disabled.
 //
 //	Note that instead of calling Yield() directly (which would
 //	suspend the interrupt handler, not the interrupted thread
@@ -39,8 +66,10 @@ Alarm::Alarm(bool doRandom)
 //	if the interrupted thread called Yield at the point it is 
 //	was interrupted.
 //
-//	For now, just provide time-slicing.  Only need to time slice 
-//      if we're currently running something (in other words, not idle).
+//	Time-slice only if the scheduling policy asks for it, and
+//      only if we're currently running something (in other words, not idle).
+//	If the thread carries on, its next slice is the policy's call too
+//	(see Scheduler::SetTimer).
 //----------------------------------------------------------------------
 
 void 
@@ -49,9 +78,109 @@ Alarm::CallBack()
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
     
+    if (status != IdleMode && kernel->currentThread->space != NULL) {
+	kernel->currentThread->space->SampleWorkingSet();
+    }					// the program's working set,
+    if (kernel->pager != NULL) {	// and which pages were used
+	kernel->pager->Tick();
+    }
     if (status != IdleMode) {
-	interrupt->YieldOnReturn();
+	if (kernel->scheduler->Tick()) {	// policy wants to preempt
+	    interrupt->YieldOnReturn();
+	}
+	kernel->scheduler->SetTimer(kernel->currentCPU);
     }else{
         this->timer->Disable();
     }
 }
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+//	Block the current thread until "x" ticks from now, or return at
+//	once if "x" isn't positive.  The thread goes on the queue of
+//	sleepers in the order it is to wake; if it is first, the wakeup
+//	interrupt is moved up for it.
+//
+//	This must be the alarm of the CPU being simulated: the wakeup
+//	interrupt goes to that CPU.
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int x)
+{
+    IntStatus oldLevel;
+    Sleeper sleeper;
+
+    if (x <= 0) {
+	return;
+    }
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    sleeper.thread = kernel->currentThread;
+    sleeper.wakeTime = kernel->stats->totalTicks + x;
+    DEBUG(dbgThread, "Thread " << sleeper.thread->getName()
+	  << " sleeping until " << sleeper.wakeTime);
+    sleepers->Insert(&sleeper);
+    if (sleepers->Front() == &sleeper) {
+	ScheduleWakeup();
+    }
+    sleeper.thread->Sleep(FALSE);
+    (void) kernel->interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::WakeSleepers
+//	Put every sleeper whose time has come on the ready queue, and
+//	arrange to wake the next.  Called by the wakeup interrupt, which
+//	has gone off, so there is none pending.
+//----------------------------------------------------------------------
+
+void
+Alarm::WakeSleepers()
+{
+    int now = kernel->stats->totalTicks;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    wakeupPending = NULL;
+    while (!sleepers->IsEmpty() && sleepers->Front()->wakeTime <= now) {
+	Sleeper *sleeper = sleepers->RemoveFront();
+
+	DEBUG(dbgThread, "Waking thread " << sleeper->thread->getName()
+	      << ", " << (now - sleeper->wakeTime) << " ticks late");
+	kernel->scheduler->ReadyToRun(sleeper->thread);
+    }
+    ScheduleWakeup();
+}
+
+//----------------------------------------------------------------------
+// Alarm::ScheduleWakeup
+//	Have the wakeup interrupt go off when the first sleeper is to
+//	wake, instead of when it was going to.  If nobody is sleeping,
+//	there is none: an idle CPU with nothing else pending stops.
+//----------------------------------------------------------------------
+
+void
+Alarm::ScheduleWakeup()
+{
+    if (wakeupPending != NULL) {
+	kernel->interrupt->Cancel(wakeupPending);
+	wakeupPending = NULL;
+    }
+    if (!sleepers->IsEmpty()) {
+	int delay = sleepers->Front()->wakeTime - kernel->stats->totalTicks;
+
+	wakeupPending = kernel->interrupt->Schedule(wakeup, max(delay, 1),
+						    AlarmInt);
+    }
+}
+
+//----------------------------------------------------------------------
+// AlarmWakeup::CallBack
+//	The wakeup interrupt: the first sleeper's time has come.  The
+//	interrupt is deleted once this returns.
+//----------------------------------------------------------------------
+
+void
+AlarmWakeup::CallBack()
+{
+    alarm->WakeSleepers();
+}
@@ -8,7 +8,13 @@
 //	From this, we provide the ability for a thread to be
 //	woken up after a delay; we also provide time-slicing.
 //
-//	NOTE: this abstraction is not completely implemented.
+//	A thread that waits (WaitUntil, or the Sleep system call) goes
+//	on its CPU's queue of sleepers, soonest first, and blocks; the
+//	alarm has an interrupt of its own pending for the first of them,
+//	apart from the time slice timer, which, with dynamic ticks, may
+//	be stopped.  So while everyone sleeps, the CPU is idle, and the
+//	clock goes straight on to the first wakeup (see Interrupt::Idle),
+//	as it would to a disk interrupt.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -21,20 +27,62 @@
 #include "utility.h"
 #include "callback.h"
 #include "timer.h"
+#include "list.h"
+
+class Thread;
+class PendingInterrupt;
+class Alarm;
+
+// A thread waiting on the alarm, and when it is to be woken.
+
+class Sleeper {
+  public:
+    Thread *thread;
+    int wakeTime;		// the tick it wakes at
+};
+
+// The interrupt that wakes the sleepers: the timer already calls
+// Alarm::CallBack.
+
+class AlarmWakeup : public CallBackObj {
+  public:
+    AlarmWakeup(Alarm *owner) { alarm = owner; }
+
+    void CallBack();		// wake those whose time has come
+
+  private:
+    Alarm *alarm;
+};
 
 // The following class defines a software alarm clock. 
 class Alarm : public CallBackObj {
   public:
     Alarm(bool doRandomYield);	// Initialize the timer, and callback 
 				// to "toCall" every time slice.
-    ~Alarm() { delete timer; }
+    ~Alarm();
     
+    void Resume() { timer->Enable(); }
+				// restart time slicing after the CPU
+				// has been idle
+    void SetQuantum(int ticks) { timer->Reprogram(ticks); }
+				// end the current time slice "ticks"
+				// from now; also restarts time slicing
+    void Stop() { timer->Stop(); }
+				// no time slicing until SetQuantum
+    bool IsSlicing() { return timer->IsArmed(); }
+				// is a time slice going to end?
     void WaitUntil(int x);	// suspend execution until time > now + x
-                                // this method is not yet implemented
+    void WakeSleepers();	// the wakeup interrupt: ready those
+				// whose time has come
 
   private:
     Timer *timer;		// the hardware timer device
+    SortedList<Sleeper *> *sleepers;	// soonest first
+    AlarmWakeup *wakeup;	// the interrupt handler for them
+    PendingInterrupt *wakeupPending;	// its interrupt, for the
+				// first of them, or NULL
 
+    void ScheduleWakeup();	// arrange to wake the first
     void CallBack();		// called when the hardware
 				// timer generates an interrupt
 };
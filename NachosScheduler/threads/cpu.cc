@@ -0,0 +1,202 @@
+// cpu.cc
+//	Routines to keep the state of a simulated processor while
+//	another one is using the Machine.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// ReadyThreads
+// 	Return how many threads are waiting on a CPU's run queue; the
+//	gauge registered for it.
+//----------------------------------------------------------------------
+
+static int
+ReadyThreads(void *cpu)
+{
+    return ((CPU *) cpu)->readyQueue->NumReady();
+}
+
+//----------------------------------------------------------------------
+// CPU::CPU
+// 	Initialize an idle CPU with an empty run queue.  The timer is
+//	started separately, by the kernel, since it has to be started
+//	on this CPU.  Register the length of the run queue, and the
+//	time the CPU has been busy.
+//
+//	"cpuID" is the CPU's index in kernel->cpus.
+//	"cpuTLB" is the TLB the CPU translates user addresses with, if
+//		there is one; the CPU deletes it.
+//----------------------------------------------------------------------
+
+CPU::CPU(int cpuID, TLB *cpuTLB)
+{
+    id = cpuID;
+    currentThread = NULL;
+    readyQueue = new SchedulerPolicy();
+    alarm = NULL;
+    userThread = NULL;
+    clock = 0;
+    busyTicks = 0;
+    numSteals = 0;
+    numMigrations = numHotMigrations = 0;
+    migratedMisses = migratedRuns = stayedMisses = stayedRuns = 0;
+    for (int i = 0; i < NumTotalRegs; i++) {
+        registers[i] = 0;
+    }
+    pageTable = NULL;
+    pageTableSize = 0;
+    tlb = cpuTLB;
+    status = IdleMode;
+
+    char name[32];
+
+    sprintf(name, "cpu%d.ready", id);
+    kernel->registry->AddGauge(name, ReadyThreads, (void *) this);
+    sprintf(name, "cpu%d.busyTicks", id);
+    kernel->registry->AddCounter(name, &busyTicks);
+    sprintf(name, "cpu%d.migrations", id);
+    kernel->registry->AddCounter(name, &numMigrations);
+}
+
+//----------------------------------------------------------------------
+// CPU::~CPU
+// 	De-allocate the run queue, the timer and the TLB.  The threads
+//	are not touched.
+//----------------------------------------------------------------------
+
+CPU::~CPU()
+{
+    delete readyQueue;
+    delete alarm;
+    delete tlb;
+}
+
+//----------------------------------------------------------------------
+// CPU::SaveState
+// 	This CPU is about to stop being simulated; copy its registers,
+//	page table, machine status and clock out of the Machine.
+//----------------------------------------------------------------------
+
+void
+CPU::SaveState()
+{
+    Machine *machine = kernel->machine;
+
+    if (machine != NULL) {
+        if (userThread != NULL) {	// otherwise they're nobody's
+            for (int i = 0; i < NumTotalRegs; i++) {
+                registers[i] = machine->ReadRegister(i);
+            }
+        }
+        pageTable = machine->pageTable;
+        pageTableSize = machine->pageTableSize;
+    }
+    status = kernel->interrupt->getStatus();
+    clock = kernel->stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// CPU::RestoreState
+// 	This CPU is about to be simulated again; put back the state
+//	saved by SaveState.
+//----------------------------------------------------------------------
+
+void
+CPU::RestoreState()
+{
+    Machine *machine = kernel->machine;
+
+    if (machine != NULL) {
+        if (userThread != NULL) {
+            for (int i = 0; i < NumTotalRegs; i++) {
+                machine->WriteRegister(i, registers[i]);
+            }
+        }
+        if (machine->pageTable != pageTable) {
+            machine->pageTable = pageTable;
+            machine->FlushTranslations();
+        }
+        machine->pageTableSize = pageTableSize;
+        machine->tlb = tlb;
+    }
+    kernel->interrupt->setStatus(status);
+    kernel->stats->totalTicks = clock;
+}
+
+//----------------------------------------------------------------------
+// CPU::LoadUserState
+// 	"thread", a user program, is about to go back to running on
+//	this CPU, which is the one being simulated; put its registers
+//	in the Machine.
+//
+//	If it was the last user thread to run here, they are still
+//	there.  Otherwise, whoever's registers are there are saved in
+//	their thread first, and if this thread last ran on another CPU,
+//	its registers are fetched from that CPU's register set.
+//----------------------------------------------------------------------
+
+void
+CPU::LoadUserState(Thread *thread)
+{
+    ASSERT(this == kernel->currentCPU);
+    if (userThread == thread) {
+        return;
+    }
+    ReleaseUserState();
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        if (kernel->cpus[i]->userThread == thread) {
+            kernel->cpus[i]->ReleaseUserState();
+        }
+    }
+    thread->RestoreUserState();
+    userThread = thread;
+}
+
+//----------------------------------------------------------------------
+// CPU::ReleaseUserState
+// 	Copy the user registers in this CPU's register set -- in the
+//	Machine, if this is the CPU being simulated -- back into the
+//	thread they belong to.  After this, the register set is free.
+//----------------------------------------------------------------------
+
+void
+CPU::ReleaseUserState()
+{
+    if (userThread == NULL) {
+        return;
+    }
+    if (this == kernel->currentCPU) {
+        userThread->SaveUserState();
+    } else {
+        for (int i = 0; i < NumTotalRegs; i++) {
+            userThread->userRegisters[i] = registers[i];
+        }
+    }
+    userThread = NULL;
+}
+
+//----------------------------------------------------------------------
+// CPU::Print
+// 	Print how much this CPU did, when Nachos halts, and what the
+//	threads that migrated here paid in TLB misses.
+//----------------------------------------------------------------------
+
+void
+CPU::Print()
+{
+    cout << "CPU " << id << ": busy " << busyTicks << " ticks, ";
+    cout << numSteals << " threads stolen, " << numMigrations
+	 << " migrated in (" << numHotMigrations << " of them hot)\n";
+    if (tlb != NULL && migratedRuns > 0 && stayedRuns > 0) {
+	cout << "    TLB misses per run: " << (double) migratedMisses
+	     / migratedRuns << " after migrating, " << (double) stayedMisses
+	     / stayedRuns << " otherwise\n";
+    }
+    readyQueue->PrintStats();
+}
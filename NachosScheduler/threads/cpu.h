@@ -0,0 +1,96 @@
+// cpu.h
+//	Data structures for the simulated processors of a multiprocessor
+//	Nachos (run with "-smp N").
+//
+//	There is still only one Machine, and only one host thread, so
+//	the CPUs take turns.  Each CPU keeps its own clock; at the end
+//	of every Interrupt::OneTick, Nachos goes on simulating whichever
+//	busy CPU has the clock furthest behind.  The clocks therefore
+//	stay within one tick step of each other, and stats->totalTicks
+//	is always the clock of the CPU being simulated.
+//
+//	While a CPU is not being simulated, its register set, page table
+//	and machine status are kept here, and its current thread stays
+//	RUNNING, parked inside Scheduler::SwitchCPU.  Disabling
+//	interrupts still gives mutual exclusion: CPUs only change hands
+//	when interrupts are enabled, or when a thread gives up its CPU.
+//
+//	With one CPU, nothing here changes how Nachos behaves.
+//
+//	A user thread's registers are only copied out of a CPU's
+//	register set when another user thread needs it, or when the
+//	thread goes on to run somewhere else.  A switch to a kernel
+//	thread and back, or a thread being given its CPU again, copies
+//	nothing; nor does a CPU change hands while no user registers
+//	are in its register set.
+//
+//	With -tlb, each CPU has a TLB of its own, which is put in the
+//	Machine along with the page table.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "machine.h"
+#include "interrupt.h"
+#include "alarm.h"
+#include "thread.h"
+#include "schedpolicy.h"
+
+class CPU {
+  public:
+    CPU(int cpuID, TLB *cpuTLB);	// initialize an idle CPU, with its
+				// TLB, or NULL
+    ~CPU();			// de-allocate its run queue and timer
+
+    int getID() { return id; }
+    bool IsIdle() { return (currentThread == NULL); }
+
+    void SaveState();		// take the CPU's state out of the Machine
+    void RestoreState();	// and put it back
+
+    void LoadUserState(Thread *thread);
+				// put thread's user registers in the
+				// Machine, unless they are there already
+    void ReleaseUserState();	// give the user registers in this
+				// CPU's register set back to their thread
+
+    void Print();		// print per-CPU statistics
+
+    // These are public for notational convenience, like the
+    // globals in Kernel.
+
+    Thread *currentThread;	// the thread holding this CPU, or
+				// NULL if the CPU is idle
+    SchedulerPolicy *readyQueue;	// threads waiting for this CPU
+    Alarm *alarm;		// this CPU's time slice timer
+    TLB *tlb;			// its TLB, if user programs are
+				// translated by one (-tlb)
+    Thread *userThread;		// whose user registers are in the
+				// register set, or NULL if nobody's
+    int clock;			// local time, while some other CPU
+				// is being simulated
+
+    int busyTicks;		// ticks spent running threads
+    int numSteals;		// threads taken from other run queues
+    int numMigrations;		// threads run here that last ran on
+    int numHotMigrations;	// another CPU, and of them, those that
+				// had run there lately (see scheduler.h)
+    int migratedMisses;		// TLB misses of the runs of threads
+    int migratedRuns;		// that had just migrated here, and how
+    int stayedMisses;		// many there were; and of the rest
+    int stayedRuns;
+
+  private:
+    int id;			// index in kernel->cpus
+    int registers[NumTotalRegs];	// the CPU's register set
+    TranslationEntry *pageTable;	// and its MMU state
+    unsigned int pageTableSize;
+    MachineStatus status;	// idle, kernel or user mode
+};
+
+#endif // CPU_H
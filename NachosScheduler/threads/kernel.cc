@@ -18,7 +18,45 @@
 #include "string.h"
 #include "synchdisk.h"
 #include "post.h"
+#include "transport.h"
 #include "synchconsole.h"
+#include "workload.h"
+#include "synchprofile.h"
+#include "frames.h"
+#include "pager.h"
+#include "execcache.h"
+
+const int InitialThreads = 64;	// thread table slots to start with;
+				// it grows as needed
+
+// The user programs -bench runs, unless others are named with -e or
+// -ep: the scheduler benchmark's jobs, and a matrix multiply.
+
+static char *benchPrograms[] = { "../bench/cpubound", "../bench/iobound",
+    "../bench/nicer", "../test/matmult", NULL };
+
+// The tuning a -cf configuration file can change, by name, and the
+// least value each can take.
+
+struct ConfigParameter {
+    char *name;
+    int *value;
+    int minimum;
+};
+
+static ConfigParameter configParameters[] = {
+    { "AgingTicks", &AgingTicks, 1 },
+    { "PriorityAging", &PriorityAging, 0 },
+    { "PriSchdThreshold", &PriSchdThreshold, 0 },
+    { "SJFSchdThreshold", &SJFSchdThreshold, 0 },
+    { "TimerTicks", &TimerTicks, 1 },
+    { "AffinityTicks", &AffinityTicks, 1 },
+    { "MigrationTicks", &MigrationTicks, 0 },
+    { "RotationTime", &RotationTime, 1 },
+    { "SeekTime", &SeekTime, 0 },
+    { "ConsoleTime", &ConsoleTime, 1 },
+    { "NetworkTime", &NetworkTime, 1 },
+    { NULL, NULL, 0 } };
 
 //----------------------------------------------------------------------
 // Kernel::Kernel
@@ -29,14 +67,67 @@
 Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
+    preemptive = FALSE;
+    dynamicTicks = FALSE;
     debugUserProg = FALSE;
+    blockEngine = FALSE;
+#ifdef USE_TLB
+    tlbSize = tlbWays = TLBSize;	// a small, fully associative TLB
+#else
+    tlbSize = tlbWays = 0;		// or the page table
+#endif
+    tlbPolicy = TLBLeastRecentlyUsed;
+    tlbTagged = FALSE;
+    demandPaging = FALSE;
+    pagePolicy = PageFIFO;
+    pager = NULL;
+    execCacheSize = DefaultExecCacheSize;
+    execCache = NULL;
+    diskCacheSize = DefaultCacheSize;
+    diskCachePolicy = CacheLRU;
+    diskSchedule = DiskFCFS;
+    diskMapped = FALSE;
+    hostIO = FALSE;
+    profileSynch = FALSE;
+    synchProfiler = NULL;
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
+    traceFile = NULL;          // default is to print the trace
+    profileFile = NULL;        // and not to profile user programs
+    statsFile = NULL;          // nor to sample statistics
+    statsTicks = 0;
+    benchmark = FALSE;         // nor to time the simulator
+    hostProfile = NULL;
+    profiler = NULL;
+    checkpointFile = NULL;     // nor to take or restore a checkpoint
+    checkpointTick = 0;
+    checkpoint = NULL;
+    restoreFile = NULL;
+    restorer = NULL;
+    jobFile = NULL;            // and to replay no jobs
+    recordFile = NULL;         // nor record or replay a run
+    replayFile = NULL;
+    workload = NULL;
+    threads = NULL;
+    programs = new List<Program *>;
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
 #endif
     reliability = 1;            // network reliability, default is 1.0
     hostName = 0;               // machine id, also UNIX socket name
+    networked = FALSE;          // no network unless -N is given
+    numHosts = 2;
+    linkFile = NULL;
+    transportWindow = DefaultWindow;
+    postOfficeIn = NULL;
+    postOfficeOut = NULL;
+    transport = NULL;
+    numCPUs = 1;                // uniprocessor unless -smp is given
+    cpus = NULL;
+    currentCPU = NULL;
+    predictorKind = PredictEWMA;	// average of the last burst and
+    predictorAlpha = 0.5;		// the previous prediction
+    predictorWindow = 4;
     // 0 is the default machine id
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-rs") == 0) {
@@ -47,34 +138,102 @@ Kernel::Kernel(int argc, char **argv)
             i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
-        } else if (strcmp(argv[i], "-e") == 0) {
-            execfile[++execfileNum]= argv[++i];
-            cout << execfile[execfileNum] << "\n";
-            priority[execfileNum] = 75;
-        } else if (strcmp(argv[i], "-ep") == 0) {
-            execfile[++execfileNum]= argv[++i];
-            cout << execfile[execfileNum] << "\n";
-            priority[execfileNum] = atoi(argv[++i]);
-        } else if (strcmp(argv[i], "--test") ==0 ) {
-            fstream fp;
-            fp.open("JobList", ios::in);
-            if (!fp) {
-                cout << "Fail to open file JobList" << endl;
+        } else if (strcmp(argv[i], "-bb") == 0) {
+            blockEngine = TRUE;
+        } else if (strcmp(argv[i], "-tlb") == 0) {
+            ASSERT(i + 3 < argc);   // entries, ways and policy
+            tlbSize = atoi(argv[i + 1]);
+            tlbWays = atoi(argv[i + 2]);
+            ASSERT(tlbSize > 0 && tlbWays > 0 && tlbSize % tlbWays == 0);
+            if (strcmp(argv[i + 3], "lru") == 0) {
+                tlbPolicy = TLBLeastRecentlyUsed;
+            } else if (strcmp(argv[i + 3], "fifo") == 0) {
+                tlbPolicy = TLBFirstInFirstOut;
             } else {
-                if (!fp.eof()) {
-                    fp >> totalList;
+                ASSERT(strcmp(argv[i + 3], "random") == 0);
+                tlbPolicy = TLBRandom;
+            }
+            i += 3;
+        } else if (strcmp(argv[i], "-asid") == 0) {
+            tlbTagged = TRUE;
+        } else if (strcmp(argv[i], "-vm") == 0) {
+            demandPaging = TRUE;	// FIFO, unless a policy is named
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                i++;
+                if (strcmp(argv[i], "fifo") == 0) {
+                    pagePolicy = PageFIFO;
+                } else if (strcmp(argv[i], "clock") == 0) {
+                    pagePolicy = PageClock;
+                } else if (strcmp(argv[i], "enhanced") == 0) {
+                    pagePolicy = PageEnhancedClock;
+                } else {
+                    ASSERT(strcmp(argv[i], "aging") == 0);
+                    pagePolicy = PageAging;
                 }
-                for (int i=0;i<totalList;i++) {
-                    char line[100];
-                    fp >> line;
-                    char *substring;
-                    char *delim=",";
-                    substring = strtok(line, delim);
-                    initTime[i] = atoi(substring);
-                    substring = strtok(NULL, delim);
-                    strcpy(jobName[i],substring);
+            }
+        } else if (strcmp(argv[i], "-mem") == 0) {
+            ASSERT(i + 1 < argc);	// in pages
+            NumPhysPages = atoi(argv[++i]);
+            ASSERT(NumPhysPages > 0);
+        } else if (strcmp(argv[i], "-ps") == 0) {
+            ASSERT(i + 1 < argc);	// in bytes, a whole number of words
+            PageSize = atoi(argv[++i]);
+            ASSERT(PageSize > 0 && PageSize % 4 == 0);
+        } else if (strcmp(argv[i], "-xc") == 0) {
+            ASSERT(i + 1 < argc);	// in kilobytes
+            execCacheSize = atoi(argv[++i]) * 1024;
+            ASSERT(execCacheSize >= 0);
+        } else if (strcmp(argv[i], "-bc") == 0) {
+            ASSERT(i + 1 < argc);	// buffers, and maybe the policy
+            diskCacheSize = atoi(argv[++i]);
+            ASSERT(diskCacheSize >= 0);
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                i++;
+                if (strcmp(argv[i], "lru") == 0) {
+                    diskCachePolicy = CacheLRU;
+                } else {
+                    ASSERT(strcmp(argv[i], "2q") == 0);
+                    diskCachePolicy = Cache2Q;
                 }
-                fp.close();
+            }
+        } else if (strcmp(argv[i], "-ds") == 0) {
+            ASSERT(i + 1 < argc);
+            i++;
+            if (strcmp(argv[i], "fcfs") == 0) {
+                diskSchedule = DiskFCFS;
+            } else if (strcmp(argv[i], "sstf") == 0) {
+                diskSchedule = DiskSSTF;
+            } else if (strcmp(argv[i], "scan") == 0) {
+                diskSchedule = DiskSCAN;
+            } else if (strcmp(argv[i], "clook") == 0) {
+                diskSchedule = DiskCLOOK;
+            } else {
+                ASSERT(strcmp(argv[i], "deadline") == 0);
+                diskSchedule = DiskDeadline;
+            }
+        } else if (strcmp(argv[i], "-dm") == 0) {
+            diskMapped = TRUE;
+        } else if (strcmp(argv[i], "-preempt") == 0) {
+            preemptive = TRUE;
+        } else if (strcmp(argv[i], "-dt") == 0) {
+            dynamicTicks = TRUE;
+        } else if (strcmp(argv[i], "-aio") == 0) {
+            hostIO = TRUE;
+        } else if (strcmp(argv[i], "-lp") == 0) {
+            profileSynch = TRUE;
+        } else if (strcmp(argv[i], "-e") == 0) {
+            ASSERT(i + 1 < argc);
+            programs->Insert(new Program(argv[++i], 75));
+            cout << argv[i] << "\n";
+        } else if (strcmp(argv[i], "-ep") == 0) {
+            ASSERT(i + 2 < argc);
+            programs->Insert(new Program(argv[i + 1], atoi(argv[i + 2])));
+            cout << argv[i + 1] << "\n";
+            i += 2;
+        } else if (strcmp(argv[i], "--test") ==0 ) {
+            jobFile = "JobList";		// unless another is named
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                jobFile = argv[++i];
             }
         } else if (strcmp(argv[i], "-ci") == 0) {
             ASSERT(i + 1 < argc);
@@ -84,6 +243,39 @@ Kernel::Kernel(int argc, char **argv)
             ASSERT(i + 1 < argc);
             consoleOut = argv[i + 1];
             i++;
+        } else if (strcmp(argv[i], "-rec") == 0) {
+            ASSERT(i + 1 < argc && replayFile == NULL);
+            recordFile = argv[++i];
+        } else if (strcmp(argv[i], "-replay") == 0) {
+            ASSERT(i + 1 < argc && recordFile == NULL);
+            replayFile = argv[++i];
+        } else if (strcmp(argv[i], "-tr") == 0) {
+            ASSERT(i + 1 < argc);
+            traceFile = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-ckpt") == 0) {
+            ASSERT(i + 2 < argc);   // file and tick
+            checkpointFile = argv[i + 1];
+            checkpointTick = atoi(argv[i + 2]);
+            i += 2;
+        } else if (strcmp(argv[i], "-restore") == 0) {
+            ASSERT(i + 1 < argc);
+            restoreFile = argv[++i];
+        } else if (strcmp(argv[i], "-pp") == 0) {
+            ASSERT(i + 1 < argc);
+            profileFile = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-ts") == 0) {
+            ASSERT(i + 2 < argc);   // ticks and file
+            statsTicks = atoi(argv[i + 1]);
+            ASSERT(statsTicks > 0);
+            statsFile = argv[i + 2];
+            i += 2;
+        } else if (strcmp(argv[i], "-bench") == 0) {
+            benchmark = TRUE;
+        } else if (strcmp(argv[i], "-cf") == 0) {
+            ASSERT(i + 1 < argc);
+            ReadConfig(argv[++i]);
 #ifndef FILESYS_STUB
         } else if (strcmp(argv[i], "-f") == 0) {
             formatFlag = TRUE;
@@ -96,16 +288,137 @@ Kernel::Kernel(int argc, char **argv)
             ASSERT(i + 1 < argc);   // next argument is int
             hostName = atoi(argv[i + 1]);
             i++;
+        } else if (strcmp(argv[i], "-N") == 0) {
+            networked = TRUE;	// main runs the test
+        } else if (strcmp(argv[i], "-tw") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            transportWindow = atoi(argv[i + 1]);
+            ASSERT(transportWindow >= 1 && transportWindow <= MaxWindow);
+            i++;
+        } else if (strcmp(argv[i], "-nh") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            numHosts = atoi(argv[i + 1]);
+            ASSERT(numHosts >= 2 && numHosts <= MaxNetworkHosts);
+            i++;
+        } else if (strcmp(argv[i], "-nl") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is the link file
+            linkFile = argv[i + 1];
+            i++;
+        } else if (strcmp(argv[i], "-smp") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is int
+            numCPUs = atoi(argv[i + 1]);
+            ASSERT(numCPUs >= 1);
+            i++;
+        } else if (strcmp(argv[i], "-bp") == 0) {
+            ASSERT(i + 1 < argc);   // next argument is the strategy
+            if (strcmp(argv[i + 1], "ewma") == 0) {
+                ASSERT(i + 2 < argc);   // then alpha, a float
+                predictorKind = PredictEWMA;
+                predictorAlpha = atof(argv[i + 2]);
+                i += 2;
+            } else if (strcmp(argv[i + 1], "lastn") == 0) {
+                ASSERT(i + 2 < argc);   // then how many bursts
+                predictorKind = PredictLastN;
+                predictorWindow = atoi(argv[i + 2]);
+                i += 2;
+            } else {
+                ASSERT(strcmp(argv[i + 1], "history") == 0);
+                predictorKind = PredictHistory;
+                i++;
+            }
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
-            cout << "Partial usage: nachos [-s]\n";
+            cout << "Partial usage: nachos [-s] [-bb]\n";
+            cout << "Partial usage: nachos [-tlb entries ways lru|fifo|random] [-asid]\n";
+            cout << "Partial usage: nachos [-vm [fifo|clock|enhanced|aging]]\n";
+            cout << "Partial usage: nachos [-mem pages] [-ps bytes]\n";
+            cout << "Partial usage: nachos [-xc kilobytes]\n";
+            cout << "Partial usage: nachos [-preempt]\n";
+            cout << "Partial usage: nachos [-dt]\n";
+            cout << "Partial usage: nachos [-aio]\n";
+            cout << "Partial usage: nachos [-lp]\n";
             cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
+            cout << "Partial usage: nachos [-tr traceFile]\n";
+            cout << "Partial usage: nachos [-pp profileFile]\n";
+            cout << "Partial usage: nachos [-ts ticks statsFile]\n";
+            cout << "Partial usage: nachos [-bench]\n";
+            cout << "Partial usage: nachos [-cf configFile]\n";
+            cout << "Partial usage: nachos [-ckpt file tick] [-restore file]\n";
+            cout << "Partial usage: nachos [-rec log | -replay log]\n";
+            cout << "Partial usage: nachos [--test [jobList]]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-nf]\n";
 #endif
+            cout << "Partial usage: nachos [-bc buffers [lru|2q]]\n";
+            cout << "Partial usage: nachos [-ds fcfs|sstf|scan|clook|deadline]\n";
+            cout << "Partial usage: nachos [-dm]\n";
             cout << "Partial usage: nachos [-n #] [-m #]\n";
+            cout << "Partial usage: nachos [-tw segments]\n";
+            cout << "Partial usage: nachos [-nh hosts] [-nl linkFile]\n";
+            cout << "Partial usage: nachos [-smp #]\n";
+            cout << "Partial usage: nachos [-bp ewma alpha | -bp lastn # | -bp history]\n";
         }
     }
+    if (benchmark && programs->IsEmpty()) {
+        for (int i = 0; benchPrograms[i] != NULL; i++) {
+            programs->Insert(new Program(benchPrograms[i], 75));
+            cout << benchPrograms[i] << "\n";
+        }
+    }
+    MemorySize = NumPhysPages * PageSize;	// before the machine is made
+    ASSERT(!demandPaging || PageSize == SectorSize);	// a page per
+							// swap sector
+}
+
+//----------------------------------------------------------------------
+// Kernel::ReadConfig
+// 	Set the tuning parameters named in "configFile".  Each line is
+//
+//		<name> <value>
+//
+//	where the name is one of configParameters' -- the scheduler's
+//	aging and tier thresholds, the time slice, the device latencies
+//	-- and the value a whole number of ticks (or of priority).  A
+//	later line overrides an earlier one; a "#" starts a comment.
+//	Anything not named keeps its default.
+//
+//	This is read while the flags are, before anything is made that
+//	reads the parameters.
+//----------------------------------------------------------------------
+
+void
+Kernel::ReadConfig(char *configFile)
+{
+    FILE *fp;
+    char line[256], name[64], *comment;
+    int value;
+    ConfigParameter *p;
+
+    if ((fp = fopen(configFile, "r")) == NULL) {
+	cerr << "Can't open configuration file " << configFile << "\n";
+	Abort();
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+	if ((comment = strchr(line, '#')) != NULL) {
+	    *comment = '\0';
+	}
+	if (sscanf(line, "%63s", name) != 1) {
+	    continue;			// blank, or only a comment
+	}
+	for (p = configParameters; p->name != NULL; p++) {
+	    if (strcmp(p->name, name) == 0) {
+		break;
+	    }
+	}
+	if (p->name == NULL || sscanf(line, "%63s %d", name, &value) != 2
+		|| value < p->minimum) {
+	    cerr << "Bad parameter in " << configFile << ": " << line << "\n";
+	    Abort();
+	}
+	*p->value = value;
+	DEBUG(dbgThread, "Parameter " << name << " = " << value);
+    }
+    fclose(fp);
 }
 
 //----------------------------------------------------------------------
@@ -123,24 +436,81 @@ Kernel::Initialize()
     // object to save its state. 
 
 
-    stats = new Statistics();		// collect statistics
+    registry = new StatsRegistry();	// the statistics to sample,
+    stats = new Statistics();		// which start with these
+    if (restoreFile != NULL) {		// from where a checkpoint left off,
+        ASSERT(numCPUs == 1);		// before anything is scheduled
+        ASSERT(!demandPaging);		// memory is all a checkpoint has
+        restorer = new CheckpointReader(restoreFile);
+        restorer->RestoreTime(stats);
+    }
+    if (checkpointFile != NULL) {
+        ASSERT(numCPUs == 1 && !demandPaging);
+        checkpoint = new CheckpointWriter(checkpointFile, checkpointTick);
+    }
+    trace = new SchedTrace(traceFile);	// and the scheduler trace
+    replay = new ReplayLog(recordFile, replayFile);	// before any
+							// random draws
+    if (profileSynch) {			// and lock contention
+        synchProfiler = new SynchProfiler();
+    }
+    if (profileFile != NULL) {		// and what user programs execute
+        profiler = new Profiler(profileFile);
+    }
+    predictor = new BurstPredictor(predictorKind, predictorAlpha,
+                                   predictorWindow);
     interrupt = new Interrupt;		// start up interrupt handling
-    scheduler = new Scheduler();	// initialize the ready queue
-    alarm = new Alarm(randomSlice);	// start up time slicing
-    machine = new Machine(debugUserProg);
+    cpus = new CPU *[numCPUs];		// with a run queue per CPU
+    for (int i = 0; i < numCPUs; i++) {
+        cpus[i] = new CPU(i, (tlbSize > 0) ? new TLB(tlbSize, tlbWays,
+                                                     tlbPolicy, tlbTagged)
+                                           : NULL);
+    }
+    scheduler = new Scheduler(preemptive, dynamicTicks);	// initialize the ready queue
+    for (int i = numCPUs - 1; i >= 0; i--) {	// start up time slicing,
+        currentCPU = cpus[i];			// with interrupts for
+        cpus[i]->alarm = new Alarm(randomSlice); // each CPU
+    }
+    alarm = cpus[0]->alarm;
+    threads = new ThreadTable(InitialThreads);
+    // main gets ID 0; it isn't entered in the table, so the ID stays
+    // reserved and no program is ever given it; it exists before the
+    // devices, since formatting the disk waits on a lock
+    currentThread = new Thread("main", threads->NewID());
+    currentThread->setStatus(RUNNING);
+    currentThread->getSchedStats()->firstRun = stats->totalTicks;
+    currentThread->setCPU(0);
+    cpus[0]->currentThread = currentThread;
+    machine = new Machine(debugUserProg, blockEngine, currentCPU->tlb);
+    frames = new FrameAllocator(NumPhysPages);
+    execCache = new ExecCache(execCacheSize);
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
     synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
-    synchDisk = new SynchDisk();    //
+    synchDisk = new SynchDisk(diskCacheSize, diskCachePolicy, diskSchedule);
+    if (demandPaging) {
+        pager = new Pager(pagePolicy);	// swapping to it
+    }
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
     fileSystem = new FileSystem(formatFlag);
 #endif // FILESYS_STUB
-    //postOfficeIn = new PostOfficeInput(10);
-    //postOfficeOut = new PostOfficeOutput(reliability);
+    if (networked) {			// the network waits for packets
+        postOfficeIn = new PostOfficeInput(10);	// for as long as it
+        postOfficeOut = new PostOfficeOutput(reliability, linkFile);	// exists
+        transport = new Transport(postOfficeIn, postOfficeOut,
+                                  transportWindow);
+    }
 
-    currentThread = new Thread("main", threadNum++);		
-    currentThread->setStatus(RUNNING);
+    if (jobFile != NULL) {
+        workload = new Workload(jobFile);	// the first job arrives
+    }						// by interrupt
+    if (statsFile != NULL) {		// everything is registered
+        registry->Start(statsFile, statsTicks);
+    }
+    if (benchmark) {			// time what is left
+        hostProfile = new HostProfile();
+    }
     interrupt->Enable();
 }
 
@@ -151,30 +521,57 @@ Kernel::Initialize()
 
 Kernel::~Kernel()
 {
+    delete hostProfile;			// stops sampling
+    delete registry;			// takes its last sample, while
+					// everything is still there
+    delete trace;			// writes out the rest of it
+    delete profiler;
+    delete checkpoint;
     delete stats;
+    delete workload;
+    delete predictor;
     delete interrupt;
     delete scheduler;
-    delete alarm;
+    for (int i = 0; i < numCPUs; i++) {
+        delete cpus[i];		// and its alarm
+    }
+    delete [] cpus;
     delete machine;
+    delete frames;
+    delete execCache;
     delete synchConsoleIn;
     delete synchConsoleOut;
+    delete pager;
     delete synchDisk;
     delete fileSystem;
-    delete postOfficeIn;
+    delete transport;		// its receiver waits in a box of
+					// postOfficeIn, which is left, as
+					// the postal worker's semaphore is
     delete postOfficeOut;
+    delete threads;
+    delete programs;
+    delete synchProfiler;		// after every profiled object
+    delete replay;			// writes out the rest of the log
 
     Exit(0);
 }
 
 //----------------------------------------------------------------------
 // Kernel::ThreadSelfTest
-//      Test threads, semaphores, synchlists
+//      Test threads, semaphores, synchlists, synchrings
 //----------------------------------------------------------------------
 
 void
 Kernel::ThreadSelfTest() {
     Semaphore *semaphore;
     SynchList<int> *synchList;
+    SynchRing<int> *synchRing;
+    RWLock *rwLock;
+    RWLockMode modes[] = { RWReaderPreference, RWWriterPreference,
+                           RWPhaseFair };
+    TLBPolicy policies[] = { TLBLeastRecentlyUsed, TLBFirstInFirstOut,
+                             TLBRandom };
+    TLB *tlb;
 
     LibSelfTest();		// test library routines
 
@@ -191,6 +588,25 @@ Kernel::ThreadSelfTest() {
     synchList->SelfTest(9);
     delete synchList;
 
+    // and bounded synchronized rings
+    synchRing = new SynchRing<int>(2);
+    synchRing->SelfTest(9);
+    delete synchRing;
+
+    // test reader-writer locks, in each mode
+    for (int i = 0; i < 3; i++) {
+        rwLock = new RWLock("test", modes[i]);
+        rwLock->SelfTest();
+        rwLock->Print();
+        delete rwLock;
+    }
+
+    // and the TLB the kernel refills, under each replacement policy
+    for (int i = 0; i < 3; i++) {
+        tlb = new TLB(4, 2, policies[i], TRUE);
+        tlb->SelfTest();
+        delete tlb;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -200,17 +616,19 @@ Kernel::ThreadSelfTest() {
 
 void
 Kernel::ConsoleTest() {
-    char ch;
+    char buffer[ConsoleInputSize];
+    int numRead;
 
     cout << "Testing the console device.\n" 
         << "Typed characters will be echoed, until ^D is typed.\n"
         << "Note newlines are needed to flush input through UNIX.\n";
     cout.flush();
 
-    do {
-        ch = synchConsoleIn->GetChar();
-        if(ch != EOF) synchConsoleOut->PutChar(ch);   // echo it!
-    } while (ch != EOF);
+    // echo what arrives, a batch at a time
+    while ((numRead = synchConsoleIn->GetString(buffer, ConsoleInputSize)) > 0) {
+        synchConsoleOut->PutString(buffer, numRead);   // echo it!
+    }
+    synchConsoleOut->Flush();		// the last line, if it has no newline
 
     cout << "\n";
 
@@ -218,61 +636,120 @@ Kernel::ConsoleTest() {
 
 //----------------------------------------------------------------------
 // Kernel::NetworkTest
-//      Test whether the post office is working. On machines #0 and #1, do:
+//      Test whether the transport is working. On machines #0 and #1, do:
 //
 //      1. send a message to the other machine at mail box #0
 //      2. wait for the other machine's message to arrive (in our mailbox #0)
 //      3. send an acknowledgment for the other machine's message
 //      4. wait for an acknowledgement from the other machine to our 
 //          original message
+//      5. send NumBulkMessages messages of BulkSize bytes each to mail
+//          box #2, while the other machine sends as many to ours, and
+//          check that they all arrive, in order
+//
+//  With "-nh" more than two machines, steps 1-4 are with each of the
+//  others, and the messages of step 5 go round a ring: to the next
+//  machine, from the one before.  Each is a Nachos of its own, with
+//  its own -m, from 0 up.
+//
+//  Anything the post office loses (-n) is sent again, so the test
+//  passes unless the other machine isn't there.  Then Nachos halts,
+//  once the other machine has everything it was sent: the network
+//  would keep it going otherwise.
 //
 //  This test works best if each Nachos machine has its own window
 //----------------------------------------------------------------------
 
+static const int NumBulkMessages = 20;
+static const int BulkSize = 200;
+
 void
 Kernel::NetworkTest() {
 
-    if (hostName == 0 || hostName == 1) {
-        // if we're machine 1, send to 0 and vice versa
-        int farHost = (hostName == 0 ? 1 : 0); 
+    if (hostName < numHosts) {
+        // the bulk messages go to the next machine, and come from the
+        // one before: with two, each is the other
+        int toHost = (hostName + 1) % numHosts;
+        int farHost = (hostName + numHosts - 1) % numHosts;
         PacketHeader outPktHdr, inPktHdr;
         MailHeader outMailHdr, inMailHdr;
         char *data = "Hello there!";
         char *ack = "Got it!";
-        char buffer[MaxMailSize];
+        char buffer[MaxMessageSize];
+        int numBad = 0;
 
         // construct packet, mail header for original message
         // To: destination machine, mailbox 0
         // From: our machine, reply to: mailbox 1
-        outPktHdr.to = farHost;         
         outMailHdr.to = 0;
         outMailHdr.from = 1;
         outMailHdr.length = strlen(data) + 1;
 
-        // Send the first message
-        postOfficeOut->Send(outPktHdr, outMailHdr, data); 
+        // Send the first message, to each of the others
+        for (int h = 0; h < numHosts; h++) {
+            if (h != hostName) {
+                outPktHdr.to = h;
+                transport->Send(outPktHdr, outMailHdr, data); 
+            }
+        }
 
-        // Wait for the first message from the other machine
-        postOfficeIn->Receive(0, &inPktHdr, &inMailHdr, buffer);
-        cout << "Got: " << buffer << " : from " << inPktHdr.from << ", box " 
-            << inMailHdr.from << "\n";
-        cout.flush();
+        // Wait for the first message from each other machine
+        for (int h = 1; h < numHosts; h++) {
+            transport->Receive(0, &inPktHdr, &inMailHdr, buffer);
+            cout << "Got: " << buffer << " : from " << inPktHdr.from
+                << ", box " << inMailHdr.from << "\n";
+            cout.flush();
+
+            // Send acknowledgement to the other machine (using "reply
+            // to" mailbox in the message that just arrived
+            outPktHdr.to = inPktHdr.from;
+            outMailHdr.to = inMailHdr.from;
+            outMailHdr.length = strlen(ack) + 1;
+            transport->Send(outPktHdr, outMailHdr, ack); 
+        }
+
+        // Wait for the acks from the other machines to the first
+        // message we sent
+        for (int h = 1; h < numHosts; h++) {
+            transport->Receive(1, &inPktHdr, &inMailHdr, buffer);
+            cout << "Got: " << buffer << " : from " << inPktHdr.from
+                << ", box " << inMailHdr.from << "\n";
+            cout.flush();
+        }
 
-        // Send acknowledgement to the other machine (using "reply to" mailbox
-        // in the message that just arrived
-        outPktHdr.to = inPktHdr.from;
-        outMailHdr.to = inMailHdr.from;
-        outMailHdr.length = strlen(ack) + 1;
-        postOfficeOut->Send(outPktHdr, outMailHdr, ack); 
-
-        // Wait for the ack from the other machine to the first message we sent
-        postOfficeIn->Receive(1, &inPktHdr, &inMailHdr, buffer);
-        cout << "Got: " << buffer << " : from " << inPktHdr.from << ", box " 
-            << inMailHdr.from << "\n";
+        // Send ours, then take theirs: each side's go out while the
+        // other's are still arriving, so both windows fill
+        outPktHdr.to = toHost;
+        outMailHdr.to = 2;
+        outMailHdr.from = 2;
+        outMailHdr.length = BulkSize;
+        for (int i = 0; i < NumBulkMessages; i++) {
+            for (int j = 0; j < BulkSize; j++) {
+                buffer[j] = (char) (hostName + i + j);
+            }
+            transport->Send(outPktHdr, outMailHdr, buffer);
+        }
+        for (int i = 0; i < NumBulkMessages; i++) {
+            transport->Receive(2, &inPktHdr, &inMailHdr, buffer);
+            if (inMailHdr.length != BulkSize) {
+                numBad++;
+                continue;
+            }
+            for (int j = 0; j < BulkSize; j++) {
+                if (buffer[j] != (char) (farHost + i + j)) {
+                    numBad++;
+                    break;
+                }
+            }
+        }
+        cout << "Got " << NumBulkMessages << " messages of " << BulkSize
+             << " bytes from " << farHost << ", " << numBad << " wrong\n";
         cout.flush();
     }
 
     // Then we're done!
+    transport->Drain();
+    interrupt->Halt();
 }
 
 void ForkExecute(Thread *t)
@@ -287,24 +764,43 @@ void ForkExecute(Thread *t)
 
 void Kernel::ExecAll()
 {
-    for (int i=1;i<=execfileNum;i++) {
-        int a = Exec(execfile[i]);
+    if (restorer != NULL) {		// the checkpointed programs first
+        restorer->RestorePrograms();
+        delete restorer;
+        restorer = NULL;
+    }
+    while (!programs->IsEmpty()) {
+        Program *program = programs->RemoveFront();
+
+        Exec(program->name, program->priority);
+        delete program;
     }
     currentThread->Finish();
     //Kernel::Exec();	
 }
 
-
-int Kernel::Exec(char* name)
+int Kernel::Exec(char* name, int pri, double burst, JoinRecord *record)
 {
-    cout << "Thread " << threadNum << "\t" << name << "\t\t(Pri: " << priority[threadNum] << ")" <<endl;
+    Thread *thread;
+    int id = threads->NewID();
+
+    cout << "Thread " << id << "\t" << name << "\t\t(Pri: " << pri << ")" <<endl;
     fflush(stdout);
-    t[threadNum] = new Thread(name, threadNum, priority[threadNum]);
-    t[threadNum]->space = new AddrSpace();
-    t[threadNum]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[threadNum]);
-    threadNum++;
+    thread = new Thread(name, id, pri);
+    threads->Enter(id, thread);
+    thread->space = new AddrSpace();
+    predictor->ThreadStart(thread);
+    if (burst >= 0) {
+        thread->setBurstTime(burst);
+    }
+    if (record != NULL) {		// before it can run, and finish
+        record->id = id;
+        thread->joinRecord = record;
+        thread->space->InheritPipes(currentThread->space);
+    }
+    thread->Fork((VoidFunctionPtr) &ForkExecute, (void *)thread);
 
-    return threadNum - 1;
+    return id;
 }
 
 void Kernel::PrintInt(int number)
@@ -18,21 +18,42 @@
 #include "alarm.h"
 #include "filesys.h"
 #include "machine.h"
+#include "cpu.h"
+#include "schedtrace.h"
+#include "profile.h"
+#include "checkpoint.h"
+#include "pager.h"
+#include "buffercache.h"
+#include "replay.h"
+#include "threadtable.h"
+#include "statsregistry.h"
+#include "hostprofile.h"
 
 class PostOfficeInput;
 class PostOfficeOutput;
+class Transport;
 class SynchConsoleInput;
 class SynchConsoleOutput;
 class SynchDisk;
+class FrameAllocator;
+class ExecCache;
+class SynchProfiler;
+class Workload;
 
+// A user program named on the command line with -e or -ep, for
+// ExecAll to start.
 
+class Program {
+  public:
+    Program(char *programName, int programPriority)
+        { name = programName; priority = programPriority; }
+
+    char *name;
+    int priority;
+};
 
 class Kernel {
     public:
-        char jobName[1000][100];
-        int initTime[1000];
-        int listCounter;
-        int totalList;
         Kernel(int argc, char **argv);
         // Interpret command line arguments
         ~Kernel();		        // deallocate the kernel
@@ -41,44 +62,108 @@ class Kernel {
         // from constructor because 
         // refers to "kernel" as a global
         void ExecAll();
-        int Exec(char* name);
+        int Exec(char* name, int priority = 75, double burst = -1,
+                 JoinRecord *record = NULL);
+        // start a user program, and return its
+        // thread's ID; "burst" is its first SJF
+        // burst prediction, if given; "record",
+        // if given, is for the program that
+        // started it (see SysExec), whose pipe
+        // ends it gets
         void ThreadSelfTest();	// self test of threads and synchronization
 
         void ConsoleTest();         // interactive console self test
         void NetworkTest();         // interactive 2-machine network test
         void PrintInt(int number);
         void Nice(int priority);
-        Thread* getThread(int threadID){return t[threadID];}    
+        Thread* getThread(int threadID){return threads->Lookup(threadID);}
         // These are public for notational convenience; really, 
         // they're global variables used everywhere.
 
         Thread *currentThread;	// the thread holding the CPU
+        ThreadTable *threads;	// the threads started by Exec, by ID
+        CPU *currentCPU;		// the CPU being simulated
+        CPU **cpus;			// all the CPUs
+        int numCPUs;		// how many there are (-smp)
         Scheduler *scheduler;	// the ready list
+        BurstPredictor *predictor;	// guesses CPU bursts for SJF
+        SchedTrace *trace;		// scheduler events (see -tr)
+        SynchProfiler *synchProfiler;	// lock contention (-lp), or NULL
+        Profiler *profiler;		// user program hotspots (-pp), or NULL
+        CheckpointWriter *checkpoint;	// to take (-ckpt), or NULL
+        ReplayLog *replay;		// random numbers and interrupts,
+        // recorded (-rec) or replayed (-replay)
         Interrupt *interrupt;	// interrupt status
         Statistics *stats;		// performance metrics
+        StatsRegistry *registry;	// named statistics, sampled
+					// over time (-ts)
+        HostProfile *hostProfile;	// where the host's time goes
+					// (-bench), or NULL
         Alarm *alarm;		// the software alarm clock    
+        Workload *workload;		// jobs to start (--test), or NULL
         Machine *machine;           // the simulated CPU
+        FrameAllocator *frames;     // its free page frames
+        ExecCache *execCache;	// user programs read in already
         SynchConsoleInput *synchConsoleIn;
         SynchConsoleOutput *synchConsoleOut;
         SynchDisk *synchDisk;
+        Pager *pager;		// demand paging to it (-vm), or NULL
         FileSystem *fileSystem;     
         PostOfficeInput *postOfficeIn;
         PostOfficeOutput *postOfficeOut;
+        Transport *transport;	// reliable delivery over them (-N),
+					// or NULL
 
         int hostName;               // machine identifier
+        bool diskMapped;		// map the disk's UNIX file (-dm)
+        bool hostIO;			// do the devices' host I/O on
+					// host threads (-aio)
 
     private:
+        void ReadConfig(char *configFile);	// set tuning parameters (-cf)
 
-        Thread* t[1000];
-        char*   execfile[1000];
-        int priority[1000];
-        int execfileNum;
-        int threadNum;
+        List<Program *> *programs;	// to start with ExecAll (-e, -ep)
         bool randomSlice;		// enable pseudo-random time slicing
+        bool preemptive;		// threads made ready may preempt
+        bool dynamicTicks;		// stop the timer when not needed
         bool debugUserProg;         // single step user program
+        bool blockEngine;		// run user programs a basic block
+					// at a time (-bb)
+        int tlbSize, tlbWays;		// the TLB, if tlbSize > 0 (-tlb)
+        TLBPolicy tlbPolicy;
+        bool tlbTagged;			// with ASIDs, not flushes (-asid)
+        bool demandPaging;		// page user programs in (-vm)
+        PagePolicy pagePolicy;		// and out
+        int execCacheSize;		// bytes of programs to keep (-xc)
+        int diskCacheSize;		// disk sectors to cache (-bc)
+        CachePolicy diskCachePolicy;
+        DiskSchedule diskSchedule;	// which disk request goes next (-ds)
+        bool profileSynch;		// profile synchronization (-lp)
+        PredictorKind predictorKind;	// how to predict bursts (-bp)
+        double predictorAlpha;	// for -bp ewma
+        int predictorWindow;	// for -bp lastn
         double reliability;         // likelihood messages are dropped
+        bool networked;			// start the post office (-N)
+        int numHosts;			// machines NetworkTest runs on (-nh)
+        char *linkFile;			// their links' latency and
+					// bandwidth (-nl), or NULL
+        int transportWindow;		// segments out at once (-tw)
         char *consoleIn;            // file to read console input from
         char *consoleOut;           // file to send console output to
+        char *traceFile;            // file to write the binary
+                                    // scheduler trace to, if any
+        char *profileFile;          // file to write the profile of each
+                                    // user program to, if any
+        char *statsFile;            // file to write samples of the
+        int statsTicks;             // registry to, every so many ticks
+        bool benchmark;             // time the simulator (-bench)
+        char *checkpointFile;       // file to write a checkpoint to,
+        int checkpointTick;         // at this tick, if any
+        char *restoreFile;          // checkpoint to start from, if any
+        CheckpointReader *restorer; // reading it, until ExecAll
+        char *jobFile;              // job list to replay, if any
+        char *recordFile;           // log to record the run to, if any
+        char *replayFile;           // log to replay the run from, if any
 #ifndef FILESYS_STUB
         bool formatFlag;          // format the disk if this is true
 #endif
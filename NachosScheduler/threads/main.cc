@@ -3,24 +3,98 @@
 //	operating system kernel.  
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
-//              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
-//              -f -cp <unix file> <nachos file>
+//              -s -bb -preempt -dt -aio -x <nachos file> -ci <consoleIn> -co <consoleOut>
+//              -tlb <entries> <ways> <policy> -asid -vm [<policy>]
+//              -mem <pages> -ps <bytes> -xc <kilobytes>
+//              -tr <trace file> -pp <profile file> --test [<job list>] -lp
+//              -ts <ticks> <stats file> -bench -cf <config file>
+//              -rec <log> -replay <log> -ckpt <file> <tick> -restore <file>
+//              -f -cp <unix file> <nachos file> -bc <buffers> [<policy>]
+//              -ds <disk schedule> -dm
 //              -p <nachos file> -r <nachos file> -l -D
-//              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -n <network reliability> -m <machine id> -tw <segments>
+//              -nh <hosts> -nl <link file>
+//              -smp <number of CPUs> -bp <burst predictor> -z -K -C -N
 //
-//    -d causes certain debugging messages to be printed (see debug.h)
+//    -d causes certain debugging messages to be printed (see debug.h);
+//	only those of the flags built in (DEBUG_CATEGORIES) can be
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -bb runs user programs with the block engine, which binds each
+//	basic block to the routines that run it (see machine.h); the
+//	results are the same as without it
+//    -tlb translates user addresses through a TLB of that many entries,
+//	in sets of that many ways, replacing the "lru", "fifo" or "random"
+//	entry of a set, and -asid tags its entries with their address
+//	space instead of flushing it on a context switch (see tlb.h)
+//    -vm pages user programs in from their files as they are used,
+//	and out to a swap area on the disk when memory is full, so
+//	programs need not fit in memory; the page to replace is picked
+//	"fifo" (the default), by "clock", by "enhanced" clock (clean
+//	pages first) or by "aging" (see pager.h)
+//    -mem gives the machine that many pages of physical memory (128 by
+//	default), and -ps makes a page that many bytes (128, the disk
+//	sector size, by default; it must stay so with -vm)
+//    -xc keeps up to that many kilobytes of the user programs that
+//	have run in memory (256 by default), so that running one again
+//	doesn't read its file (see execcache.h)
+//    -preempt lets a thread that is made ready take the CPU at once,
+//	if the scheduling policy says it should (see schedpolicy.h)
+//    -dt runs the timer only while a thread is waiting for the CPU,
+//	rather than interrupting every time slice regardless
+//    -aio has host threads read and write the disk's UNIX file, the
+//	console's files and the network's sockets, so that the
+//	simulation goes on meanwhile; what is simulated is the same
+//	(see hostio.h)
 //    -x runs a user program
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
+//    -tr writes the scheduler trace to a binary file instead of
+//	printing it; read it with tracedump (see schedtrace.h)
+//    -pp counts the instructions each user program executes, by
+//	opcode and by address, and writes them to a file as it
+//	finishes; read it with profdump (see profile.h)
+//    -ts samples every statistic registered (see statsregistry.h)
+//	every so many ticks, and writes the samples to a file: CSV, or
+//	JSON lines if its name ends in ".json"
+//    -bench times the simulator: at halt it prints how many
+//	instructions and ticks it simulated per second on the host, and
+//	how the host's time was split between interpreting instructions,
+//	translating addresses, interrupts, context switches, device I/O
+//	and the kernel (see hostprofile.h); unless -e or -ep name
+//	others, it runs the benchmark's jobs in ../bench and ../test/matmult
+//    -cf sets tuning parameters from a file of "name value" lines: the
+//	multilevel scheduler's AgingTicks, PriorityAging, PriSchdThreshold
+//	and SJFSchdThreshold (see schedpolicy.h), the multiprocessor's
+//	AffinityTicks and MigrationTicks (see scheduler.h), and TimerTicks,
+//	RotationTime, SeekTime, ConsoleTime and NetworkTime (see stats.h);
+//	build.linux/sweep.sh runs nachos over a grid of them
+//    --test starts the jobs in a job list ("JobList" by default), each
+//	at its arrival tick (see workload.h)
+//    -rec logs the random numbers drawn and the interrupts that go off
+//	to a file, and -replay makes a later run follow such a log
+//	(see replay.h)
+//    -ckpt writes the user programs, their memory and their registers
+//	to a file, as soon after that tick as it can, and -restore starts
+//	a later run from such a file (see checkpoint.h)
+//    -lp prints, at halt, how long threads waited for each semaphore,
+//	lock and condition variable (see synchprofile.h)
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
+//    -tw sets how many segments the transport sends to a machine before
+//	waiting for it to acknowledge them (8 by default; see transport.h)
+//    -nh sets how many machines the network test runs on (2 by default),
+//	each a Nachos with its own -m
+//    -nl reads the latency and bandwidth of each pair of machines'
+//	links from a file (see NetworkOutput::ReadLinks)
+//    -smp simulates a multiprocessor with that many CPUs (see cpu.h)
+//    -bp picks how SJF predicts CPU bursts: "ewma <alpha>", "lastn <n>"
+//	or "history" (see predictor.h)
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
-//    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -N starts the network, and runs a -nh machine test of it (see
+//	Kernel::NetworkTest), after which Nachos halts
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
@@ -29,6 +103,14 @@
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system 
+//    -bc caches that many disk sectors in memory (64 by default, 0 for
+//	none), dropping the "lru" one (the default) or going by "2q"
+//	(see buffercache.h)
+//    -ds picks which of the requests waiting for the disk goes next:
+//	"fcfs" (the default), "sstf", "scan", "clook" or "deadline" (see
+//	synchdisk.h); the swap area of -vm is scheduled so too
+//    -dm maps the disk's UNIX file into memory, rather than reading and
+//	writing it (see disk.h)
 //
 //  Note: the file system flags are not used if the stub filesystem
 //        is being used
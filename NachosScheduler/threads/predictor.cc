@@ -0,0 +1,194 @@
+// predictor.cc
+//	Routines to predict the CPU bursts of threads, and to keep
+//	track of how good the predictions were.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "predictor.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// BurstHistory::BurstHistory
+// 	Initialize the history of a thread that hasn't run yet.
+//----------------------------------------------------------------------
+
+BurstHistory::BurstHistory()
+{
+    numBursts = 0;
+    totalError = 0;
+    for (int i = 0; i < MaxBurstWindow; i++) {
+        recent[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// BurstHistory::Add
+// 	Remember that a burst of "burst" ticks just ended, forgetting
+//	the oldest one if the buffer is full.
+//----------------------------------------------------------------------
+
+void
+BurstHistory::Add(int burst)
+{
+    recent[numBursts % MaxBurstWindow] = burst;
+    numBursts++;
+}
+
+//----------------------------------------------------------------------
+// BurstHistory::Mean
+// 	Return the mean of the last "n" bursts, or of all of them if
+//	there have been fewer; 0 if there have been none.
+//----------------------------------------------------------------------
+
+double
+BurstHistory::Mean(int n)
+{
+    if (n > numBursts) {
+        n = numBursts;
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    double sum = 0;
+    for (int i = 1; i <= n; i++) {
+        sum += recent[(numBursts - i) % MaxBurstWindow];
+    }
+    return sum / n;
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::BurstPredictor
+// 	Initialize a predictor.
+//
+//	"how" is the strategy to use.
+//	"ewmaAlpha" is the weight of the last burst, for PredictEWMA.
+//	"lastN" is how many bursts to average, for PredictLastN.
+//----------------------------------------------------------------------
+
+BurstPredictor::BurstPredictor(PredictorKind how, double ewmaAlpha, int lastN)
+{
+    ASSERT(ewmaAlpha >= 0 && ewmaAlpha <= 1);
+    ASSERT(lastN >= 1 && lastN <= MaxBurstWindow);
+
+    kind = how;
+    alpha = ewmaAlpha;
+    window = lastN;
+    history = NULL;
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::~BurstPredictor
+// 	De-allocate the per-executable histories.
+//----------------------------------------------------------------------
+
+BurstPredictor::~BurstPredictor()
+{
+    while (history != NULL) {
+        ExecHistory *exec = history;
+
+        history = exec->next;
+        delete exec;
+    }
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::Lookup
+// 	Return what we know about executable "name", making an empty
+//	record the first time it is asked for.
+//----------------------------------------------------------------------
+
+ExecHistory *
+BurstPredictor::Lookup(char *name)
+{
+    ExecHistory *exec;
+
+    for (exec = history; exec != NULL; exec = exec->next) {
+        if (strcmp(exec->name, name) == 0) {
+            return exec;
+        }
+    }
+
+    history = new ExecHistory(name, history);
+    return history;
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::ThreadStart
+// 	Make the first prediction for a new thread.  Only -bp history
+//	knows anything about it yet; the other strategies start from 0.
+//----------------------------------------------------------------------
+
+void
+BurstPredictor::ThreadStart(Thread *thread)
+{
+    if (kind == PredictHistory) {
+        ExecHistory *exec = Lookup(thread->getName());
+
+        if (exec->numBursts > 0) {
+            thread->setBurstTime(exec->mean);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::BurstDone
+// 	A burst of "thread" just ended after "actual" ticks.  Charge
+//	the error of the prediction it was scheduled by, then set its
+//	burst time to the prediction for its next burst.
+//----------------------------------------------------------------------
+
+void
+BurstPredictor::BurstDone(Thread *thread, int actual)
+{
+    BurstHistory *bursts = thread->getBurstHistory();
+    double error = thread->getBurstTime() - actual;
+    double predicted;
+
+    if (error < 0) {
+        error = -error;
+    }
+    bursts->totalError += error;
+    bursts->Add(actual);
+    kernel->stats->numBurstPredictions++;
+    kernel->stats->totalPredictionError += error;
+
+    switch (kind) {
+      case PredictEWMA:
+        predicted = alpha * actual + (1 - alpha) * thread->getBurstTime();
+        break;
+      case PredictLastN:
+        predicted = bursts->Mean(window);
+        break;
+      case PredictHistory: {
+        ExecHistory *exec = Lookup(thread->getName());
+
+        exec->numBursts++;
+        exec->mean += (actual - exec->mean) / exec->numBursts;
+        predicted = exec->mean;
+        break;
+      }
+      default:
+        ASSERTNOTREACHED();
+    }
+    thread->setBurstTime(predicted);
+}
+
+//----------------------------------------------------------------------
+// BurstPredictor::ThreadDone
+// 	"thread" is finishing; copy its prediction error into its
+//	scheduling statistics.
+//----------------------------------------------------------------------
+
+void
+BurstPredictor::ThreadDone(Thread *thread)
+{
+    BurstHistory *bursts = thread->getBurstHistory();
+    ThreadStats *threadStats = thread->getSchedStats();
+
+    threadStats->numBursts = bursts->numBursts;
+    threadStats->totalPredictionError = bursts->totalError;
+}
@@ -0,0 +1,91 @@
+// predictor.h
+//	Data structures to predict how long a thread will run before it
+//	next gives up the CPU, for the shortest-job-first tier.
+//
+//	Every time a CPU burst ends -- the thread is switched out, or
+//	calls Nice -- the scheduler tells the BurstPredictor how long the
+//	burst was, and the predictor sets the thread's burst time to its
+//	guess for the next one.  How it guesses is chosen with -bp:
+//
+//	    -bp ewma <alpha>	alpha * last burst + (1 - alpha) * previous
+//				prediction (the default, with alpha 0.5)
+//	    -bp lastn <n>	mean of the thread's last n bursts
+//	    -bp history		mean of every burst seen so far from the
+//				same executable, by any of its threads;
+//				a new thread starts from that mean
+//
+//	The predictor also measures how far off each prediction was;
+//	the errors are kept in Statistics and printed when Nachos halts.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include "copyright.h"
+
+class Thread;
+
+const int MaxBurstWindow = 16;	// most bursts -bp lastn can average
+
+enum PredictorKind { PredictEWMA, PredictLastN, PredictHistory };
+
+// The following class remembers the recent bursts of one thread,
+// and how accurately they were predicted.
+
+class BurstHistory {
+  public:
+    BurstHistory();
+
+    void Add(int burst);	// a burst of "burst" ticks just ended
+    double Mean(int n);		// mean of the last n bursts, at most
+				// MaxBurstWindow
+
+    int numBursts;		// bursts recorded so far
+    double totalError;		// sum of |predicted - actual| over them
+
+  private:
+    int recent[MaxBurstWindow];	// circular buffer of the last bursts
+};
+
+// What has been learned about one executable under -bp history.
+
+class ExecHistory {
+  public:
+    ExecHistory(char *execName, ExecHistory *nextExec) {
+	name = execName; mean = 0; numBursts = 0; next = nextExec;
+    }
+
+    char *name;
+    double mean;		// mean burst of all its threads
+    int numBursts;		// how many bursts that is over
+    ExecHistory *next;
+};
+
+// The following class turns finished bursts into predictions.
+
+class BurstPredictor {
+  public:
+    BurstPredictor(PredictorKind how, double ewmaAlpha, int lastN);
+    ~BurstPredictor();
+
+    void ThreadStart(Thread *thread);	// make a first guess for a new
+					// thread
+    void BurstDone(Thread *thread, int actual);
+					// thread's burst of "actual" ticks
+					// ended; predict the next one
+    void ThreadDone(Thread *thread);	// thread is finishing; note
+					// its prediction error
+
+  private:
+    PredictorKind kind;
+    double alpha;		// weight of the last burst, for PredictEWMA
+    int window;			// bursts averaged, for PredictLastN
+    ExecHistory *history;	// per executable, for PredictHistory
+
+    ExecHistory *Lookup(char *name);	// find or make name's history
+};
+
+#endif // PREDICTOR_H
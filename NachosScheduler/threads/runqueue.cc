@@ -0,0 +1,354 @@
+// runqueue.cc
+//	Routines to manage a priority-indexed queue of ready threads.
+//
+//	All operations are constant time: the bucket for a level is
+//	found by indexing, and the highest non-empty level is found
+//	by looking for the highest set bit, first in the summary word
+//	and then in the level word it points to.
+//
+//	AgingWheel is here too; it tracks deadlines for threads that
+//	are sitting in a RunQueue.
+//
+//	NOTE: Mutual exclusion must be provided by the caller (the
+//	scheduler runs with interrupts disabled).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "runqueue.h"
+
+//----------------------------------------------------------------------
+// HighestBit
+//	Return the index of the most significant bit set in "word".
+//	"word" must not be zero.
+//----------------------------------------------------------------------
+
+static int
+HighestBit(unsigned int word)
+{
+    ASSERT(word != 0);
+#ifdef __GNUC__
+    return 31 - __builtin_clz(word);
+#else
+    int bit = 0;
+    if (word & 0xffff0000) { word >>= 16; bit += 16; }
+    if (word & 0xff00) { word >>= 8; bit += 8; }
+    if (word & 0xf0) { word >>= 4; bit += 4; }
+    if (word & 0xc) { word >>= 2; bit += 2; }
+    if (word & 0x2) { bit += 1; }
+    return bit;
+#endif
+}
+
+//----------------------------------------------------------------------
+// RunQueue::RunQueue
+//	Initialize a run queue, with every bucket empty.
+//
+//	"queueName" is printed in the scheduler trace when a thread
+//	is put on the queue.
+//----------------------------------------------------------------------
+
+RunQueue::RunQueue(char *queueName)
+{
+    ASSERT(LevelWords <= 32);
+    name = queueName;
+    for (int i = 0; i < LevelWords; i++) {
+        levelMap[i] = 0;
+    }
+    summaryMap = 0;
+    numInQueue = 0;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::~RunQueue
+//	De-allocate a run queue.  Like List, this does *NOT* touch
+//	the threads that are still queued, except to unlink them.
+//----------------------------------------------------------------------
+
+RunQueue::~RunQueue()
+{
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Insert
+//	Put "thread" at the back of the bucket for its current priority.
+//	The level is remembered in the thread, so that a later change
+//	of priority does not confuse Remove.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Insert(Thread *thread)
+{
+    int level = thread->getPriority();
+
+    ASSERT(!IsInQueue(thread));
+    ASSERT(level >= 0 && level < NumPriorityLevels);
+
+    thread->readyLevel = level;
+    if (buckets[level].IsEmpty()) {     // bucket was empty
+        levelMap[level / 32] |= 1 << (level % 32);
+        summaryMap |= 1 << (level / 32);
+    }
+    buckets[level].Append(thread);
+    numInQueue++;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Append
+//	Same as Insert, but also print which queue the thread went to,
+//	like List::Append does for the other ready queues.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Append(Thread *thread)
+{
+    Insert(thread);
+    cout << "move to " << name << " queue" << endl;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Remove
+//	Unlink "thread" from its bucket, clearing the bucket's bit
+//	if it becomes empty.  The thread must be on this queue.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Remove(Thread *thread)
+{
+    int level = thread->readyLevel;
+
+    ASSERT(level >= 0 && level < NumPriorityLevels);
+
+    buckets[level].Remove(thread);
+    if (buckets[level].IsEmpty()) {     // bucket is now empty
+        levelMap[level / 32] &= ~(1 << (level % 32));
+        if (levelMap[level / 32] == 0) {
+            summaryMap &= ~(1 << (level / 32));
+        }
+    }
+    thread->readyLevel = -1;
+    numInQueue--;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::HighestLevelBelow
+//	Return the highest non-empty level strictly less than "level",
+//	or -1 if there is none.  HighestLevelBelow(NumPriorityLevels)
+//	is the highest non-empty level in the queue.
+//----------------------------------------------------------------------
+
+int
+RunQueue::HighestLevelBelow(int level)
+{
+    int word;
+    unsigned int bits;
+
+    if (level <= 0) {
+        return -1;
+    }
+    level--;                            // highest level we may return
+    word = level / 32;
+    bits = levelMap[word];
+    if (level % 32 != 31) {             // mask off levels above "level"
+        bits &= (1u << (level % 32 + 1)) - 1;
+    }
+    if (bits != 0) {
+        return word * 32 + HighestBit(bits);
+    }
+    bits = summaryMap & ((1u << word) - 1);   // lower words only
+    if (bits == 0) {
+        return -1;
+    }
+    word = HighestBit(bits);
+    return word * 32 + HighestBit(levelMap[word]);
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Front
+//	Return the thread that RemoveFront would return, or NULL if
+//	the queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+RunQueue::Front()
+{
+    int level = HighestLevel();
+
+    if (level < 0) {
+        return NULL;
+    }
+    return buckets[level].Front();
+}
+
+//----------------------------------------------------------------------
+// RunQueue::RemoveFront
+//	Remove the oldest thread at the highest non-empty level, and
+//	return it.  Return NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+RunQueue::RemoveFront()
+{
+    Thread *thread = Front();
+
+    if (thread != NULL) {
+        Remove(thread);
+    }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// RunQueue::Apply
+//	Apply "func" to every queued thread, highest level first.
+//	"func" must not add or remove threads.
+//----------------------------------------------------------------------
+
+void
+RunQueue::Apply(void (*func)(Thread *))
+{
+    for (int level = NumPriorityLevels - 1; level >= 0; level--) {
+        buckets[level].Apply(func);
+    }
+}
+
+//----------------------------------------------------------------------
+// RunQueue::SanityCheck
+//	Check that the bitmaps agree with the buckets, and that the
+//	thread count is right.
+//----------------------------------------------------------------------
+
+void
+RunQueue::SanityCheck()
+{
+    int numFound = 0;
+
+    for (int level = 0; level < NumPriorityLevels; level++) {
+        bool marked = (levelMap[level / 32] & (1 << (level % 32))) != 0;
+        ASSERT(marked == !buckets[level].IsEmpty());
+        buckets[level].SanityCheck();
+        for (Thread *t = buckets[level].Front(); t != NULL;
+             t = ReadyList::Next(t)) {
+            ASSERT(t->readyLevel == level);
+            numFound++;
+        }
+    }
+    for (int i = 0; i < LevelWords; i++) {
+        bool marked = (summaryMap & (1 << i)) != 0;
+        ASSERT(marked == (levelMap[i] != 0));
+    }
+    ASSERT(numFound == numInQueue);
+}
+
+//----------------------------------------------------------------------
+// AgingWheel::AgingWheel
+//	Initialize an empty timing wheel.  One turn of the wheel spans
+//	a little more than "period" ticks, so that a deadline "period"
+//	ticks away never lands in the slot the clock is currently in.
+//
+//	"period" is the usual distance from now to a deadline.
+//	"numSlots" is how many slots to divide it into.
+//----------------------------------------------------------------------
+
+AgingWheel::AgingWheel(int period, int nSlots)
+{
+    ASSERT(period > 0 && nSlots > 1);
+    numSlots = nSlots;
+    slotTicks = max(1, divRoundUp(period, numSlots - 1));
+    slots = new AgingList[numSlots];
+    cursor = 0;
+    numInWheel = 0;
+}
+
+//----------------------------------------------------------------------
+// AgingWheel::~AgingWheel
+//	De-allocate the wheel.  The threads on it are not touched.
+//----------------------------------------------------------------------
+
+AgingWheel::~AgingWheel()
+{
+    delete [] slots;
+}
+
+//----------------------------------------------------------------------
+// AgingWheel::Insert
+//	Put "thread" on the wheel, to be returned by RemoveExpired once
+//	the clock reaches "deadline".
+//----------------------------------------------------------------------
+
+void
+AgingWheel::Insert(Thread *thread, int deadline)
+{
+    int slot;
+
+    ASSERT(!IsInWheel(thread));
+    ASSERT(deadline >= 0);
+
+    if (numInWheel == 0) {      // nothing to expire before this one
+        cursor = deadline / slotTicks;
+    } else {
+        cursor = min(cursor, deadline / slotTicks);
+    }
+    slot = (deadline / slotTicks) % numSlots;
+    thread->agingDeadline = deadline;
+    slots[slot].Prepend(thread);
+    numInWheel++;
+}
+
+//----------------------------------------------------------------------
+// AgingWheel::Remove
+//	Take "thread" off the wheel before its deadline.
+//----------------------------------------------------------------------
+
+void
+AgingWheel::Remove(Thread *thread)
+{
+    int slot;
+
+    ASSERT(IsInWheel(thread));
+    slot = (thread->agingDeadline / slotTicks) % numSlots;
+    slots[slot].Remove(thread);
+    thread->agingDeadline = -1;
+    numInWheel--;
+}
+
+//----------------------------------------------------------------------
+// AgingWheel::RemoveExpired
+//	Return a thread whose deadline has passed, taking it off the
+//	wheel, or NULL if there are none.  Call repeatedly to collect
+//	all the expired threads.
+//
+//	Only the slots between the cursor and "now" are looked at.  A
+//	slot is left behind for good once the clock has moved past it
+//	and it holds nothing but threads for later turns of the wheel.
+//
+//	"now" is the current time; it must not go backwards.
+//----------------------------------------------------------------------
+
+Thread *
+AgingWheel::RemoveExpired(int now)
+{
+    int nowSlot = now / slotTicks;
+
+    if (numInWheel == 0) {
+        return NULL;
+    }
+    // every slot gets looked at within one turn of the wheel
+    cursor = max(cursor, nowSlot - numSlots + 1);
+
+    for (; cursor <= nowSlot; cursor++) {
+        for (Thread *t = slots[cursor % numSlots].Front(); t != NULL;
+             t = AgingList::Next(t)) {
+            if (t->agingDeadline <= now) {
+                Remove(t);
+                return t;
+            }
+        }
+        if (cursor == nowSlot) {        // rest of this slot isn't due yet
+            break;
+        }
+    }
+    return NULL;
+}
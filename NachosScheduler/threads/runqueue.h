@@ -0,0 +1,106 @@
+// runqueue.h
+//	Data structures for a priority-indexed queue of ready threads.
+//
+//	The queue keeps one FIFO bucket per priority level, and a
+//	bitmap recording which buckets are non-empty.  A second, one-word
+//	summary bitmap records which words of the level bitmap have any
+//	bits set, so that finding the highest non-empty level is two
+//	"find highest bit" operations, independent of how many threads
+//	are queued.
+//
+//	Each bucket is a ReadyList, linked through the Thread itself
+//	(see dlist.h), so enqueue and dequeue never allocate, and
+//	removing an arbitrary thread is constant time.
+//
+//	Within one level, threads come out in the order they were
+//	put in, which matches a SortedList with equal keys.
+//
+//	An AgingWheel is a timing wheel of threads waiting for a
+//	deadline, used to find the ready threads that are due for an
+//	aging boost without looking at the ones that aren't.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RUNQUEUE_H
+#define RUNQUEUE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "thread.h"
+
+// Number of words in the level bitmap.  The summary bitmap has one
+// bit per word, so this can't be more than 32.
+const int LevelWords = divRoundUp(NumPriorityLevels, 32);
+
+class RunQueue {
+  public:
+    RunQueue(char *queueName);		// initialize an empty run queue
+    ~RunQueue();			// de-allocate the run queue
+
+    void Insert(Thread *thread);	// put thread at the back of the
+					// bucket for its priority
+    void Append(Thread *thread);	// Insert, and note it in the
+					// scheduler trace
+    Thread *RemoveFront();		// take the oldest thread off the
+					// highest non-empty level
+    void Remove(Thread *thread);	// take a specific thread off
+					// the queue
+    Thread *Front();			// highest priority thread, without
+					// removing it
+
+    bool IsEmpty() { return (numInQueue == 0); }
+    int NumInQueue() { return numInQueue; }
+    bool IsInQueue(Thread *thread) { return (thread->readyLevel >= 0); }
+    int HighestLevel() { return HighestLevelBelow(NumPriorityLevels); }
+					// highest non-empty level, or -1
+    int HighestLevelBelow(int level);	// highest non-empty level less
+					// than "level", or -1
+
+    void Apply(void (*func)(Thread *));	// apply func to every thread,
+					// in the order they would run
+    void SanityCheck();			// has the queue been corrupted?
+
+  private:
+    char *name;				// for the scheduler trace
+    ReadyList buckets[NumPriorityLevels];	// the threads at each level
+    unsigned int levelMap[LevelWords];	// bit set if bucket non-empty
+    unsigned int summaryMap;		// bit set if levelMap word non-zero
+    int numInQueue;			// total number of queued threads
+};
+
+// The following class defines a timing wheel of threads.  Each thread
+// is filed in the slot covering its deadline; RemoveExpired only looks
+// at the slots the clock has reached since it was last called.
+//
+// Deadlines may be any distance in the future: a slot can hold threads
+// from several turns of the wheel, and each is checked against its own
+// deadline before it is returned.
+
+class AgingWheel {
+  public:
+    AgingWheel(int period, int numSlots);
+				// initialize a wheel covering "period"
+				// ticks with "numSlots" slots
+    ~AgingWheel();		// de-allocate the wheel
+
+    void Insert(Thread *thread, int deadline);
+				// file thread to expire at "deadline"
+    void Remove(Thread *thread);	// take thread off the wheel
+    Thread *RemoveExpired(int now);	// remove and return a thread whose
+				// deadline is <= now, or NULL if none
+
+    bool IsInWheel(Thread *thread) { return (thread->agingDeadline >= 0); }
+    bool IsEmpty() { return (numInWheel == 0); }
+
+  private:
+    int slotTicks;		// ticks covered by one slot
+    int numSlots;		// number of slots in the wheel
+    AgingList *slots;		// the threads in each slot
+    int cursor;			// absolute slot number of the oldest slot
+				// that may still hold expired threads
+    int numInWheel;		// number of threads on the wheel
+};
+
+#endif // RUNQUEUE_H
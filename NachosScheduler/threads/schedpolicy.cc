@@ -0,0 +1,963 @@
+// schedpolicy.cc
+//	Routines for the multilevel, feedback and fair-share scheduling
+//	policies.
+//	The simpler policies are defined entirely in schedpolicy.h.
+//
+//	These routines are called by the Scheduler, with interrupts
+//	already disabled.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "schedpolicy.h"
+#include "main.h"
+
+int AgingTicks = 1500;
+int PriorityAging = 10;
+int PriSchdThreshold = 60;
+int SJFSchdThreshold = 100;
+
+//----------------------------------------------------------------------
+// WatchTier
+// 	Register kernel->stats->waitTime[queue], as "wait." and the
+//	queue's name.  The registry ignores it if it has it already.
+//----------------------------------------------------------------------
+
+void
+WatchTier(TraceQueue queue)
+{
+    char name[32];
+
+    sprintf(name, "wait.%s", traceQueueNames[queue]);
+    kernel->registry->AddHistogram(name, &kernel->stats->waitTime[queue]);
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::MultiLevelPolicy
+// 	Initialize the three ready queues.  Initially, no ready threads.
+//----------------------------------------------------------------------
+
+MultiLevelPolicy::MultiLevelPolicy()
+{
+    readyRRList = new ReadyList;
+    readyPriorityList = new RunQueue("Priority");
+    readySJFList = new ReadyList;
+    agingWheel = new AgingWheel(AgingTicks, AGING_WHEEL_SLOTS);
+    WatchTier(TraceSJFQueue);
+    WatchTier(TraceRRQueue);
+    WatchTier(TracePriorityQueue);
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::~MultiLevelPolicy
+// 	De-allocate the ready queues.
+//----------------------------------------------------------------------
+
+MultiLevelPolicy::~MultiLevelPolicy()
+{
+    delete readyRRList;
+    delete readyPriorityList;
+    delete readySJFList;
+    delete agingWheel;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Enqueue
+// 	Put a ready thread on the queue for its tier.  Threads in the
+//	priority tier also start waiting for their aging boost.
+//----------------------------------------------------------------------
+
+TraceQueue
+MultiLevelPolicy::Enqueue(Thread *thread)
+{
+    switch (TierOf(thread->getPriority())) {
+      case SJFTier:
+        readySJFList->Insert(thread, Thread::compare_by_burst);
+        return TraceSJFQueue;
+      case RRTier:
+        readyRRList->Append(thread);
+        return TraceRRQueue;
+      case PriorityTier:
+      default:
+        readyPriorityList->Insert(thread);
+        agingWheel->Insert(thread, kernel->stats->totalTicks + AgingTicks);
+        return TracePriorityQueue;
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::PickNext
+// 	Age the priority tier, then take the first thread from the
+//	highest non-empty tier.  Return NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+MultiLevelPolicy::PickNext()
+{
+    Thread *nextThread = NULL;
+
+    aging();
+
+    if (!readySJFList->IsEmpty()) {
+        nextThread = readySJFList->RemoveFront();
+    } else if (!readyRRList->IsEmpty()) {
+        nextThread = readyRRList->RemoveFront();
+    } else if (!readyPriorityList->IsEmpty()) {
+        nextThread = readyPriorityList->RemoveFront();
+        agingWheel->Remove(nextThread);
+    }
+    return nextThread;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Switch
+// 	Update the burst prediction of the thread leaving the CPU,
+//	and note when the burst of the next thread starts.  How the
+//	prediction is made is up to kernel->predictor.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::Switch(Thread *oldThread, Thread *nextThread)
+{
+    if (oldThread != NULL) {
+        // old thread burst time
+        kernel->predictor->BurstDone(oldThread,
+                kernel->stats->totalTicks - oldThread->getStartBurst());
+    }
+    if (nextThread != NULL) {
+        // set up the individual start time of burst
+        nextThread->setStartBurstTime(kernel->stats->totalTicks);
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Preempts
+// 	Return TRUE if "thread", just made ready, should take the CPU
+//	from "running" right away: it is in a higher tier, or in the
+//	SJF tier with a shorter predicted burst than running has left,
+//	or in the priority tier with a higher priority.
+//----------------------------------------------------------------------
+
+bool
+MultiLevelPolicy::Preempts(Thread *thread, Thread *running)
+{
+    ReadyTier tier = TierOf(thread->getPriority());
+    ReadyTier runningTier = TierOf(running->getPriority());
+    double remaining;
+
+    if (tier != runningTier) {
+        return (tier < runningTier);
+    }
+    switch (tier) {
+      case SJFTier:
+        remaining = running->getBurstTime()
+                    - (kernel->stats->totalTicks - running->getStartBurst());
+        return (thread->getBurstTime() < remaining);
+      case PriorityTier:
+        return (thread->getPriority() > running->getPriority());
+      default:
+        return FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Quantum
+// 	Return the time slice of "running", which depends on its tier:
+//	SJF threads get at least TimerTicks, and longer if their bursts
+//	are longer, since they would only be put back near the front
+//	anyway; RR threads get at most TimerTicks, and less if their
+//	bursts are shorter; the priority tier gets TimerTicks, which is
+//	what its aging is tuned for.
+//----------------------------------------------------------------------
+
+int
+MultiLevelPolicy::Quantum(Thread *running)
+{
+    switch (TierOf(running->getPriority())) {
+      case SJFTier:
+        return AdaptiveQuantum(running, TimerTicks, QUANTUM_MAX);
+      case RRTier:
+        return AdaptiveQuantum(running, QUANTUM_MIN, TimerTicks);
+      case PriorityTier:
+      default:
+        return TimerTicks;
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::TierOf
+// 	Return the ready queue used by threads at "priority".
+//----------------------------------------------------------------------
+
+ReadyTier
+MultiLevelPolicy::TierOf(int priority)
+{
+    if (priority >= SJFSchdThreshold) {
+        return SJFTier;
+    } else if (priority >= PriSchdThreshold) {
+        return RRTier;
+    }
+    return PriorityTier;
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::PriorityChanged
+// 	Called, through the Scheduler, by Thread::setPriority whenever a
+//	thread's priority changes.  If the thread is on a ready queue and the new priority
+//	belongs to a different tier, take it off its old queue and make
+//	it ready again, so it goes on the right one.  A thread that stays
+//	in the priority tier is just re-filed at its new level.
+//
+//	Threads that are not ready pick their queue the next time
+//	ReadyToRun is called on them.
+//
+//	"thread" is the thread whose priority changed.
+//	"oldPriority" is its priority before the change.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::PriorityChanged(Thread *thread, int oldPriority)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (thread->getStatus() != READY) {
+        return;
+    }
+    ReadyTier from = TierOf(oldPriority);
+    ReadyTier to = TierOf(thread->getPriority());
+
+    switch (from) {
+      case SJFTier:
+        if (to == from || !ReadyList::IsLinked(thread)) {
+            return;
+        }
+        readySJFList->Remove(thread);
+        break;
+      case RRTier:
+        if (to == from || !ReadyList::IsLinked(thread)) {
+            return;
+        }
+        readyRRList->Remove(thread);
+        break;
+      case PriorityTier:
+        if (!readyPriorityList->IsInQueue(thread)) {
+            return;
+        }
+        readyPriorityList->Remove(thread);
+        if (to == from) {       // same queue, keep the aging deadline
+            readyPriorityList->Insert(thread);
+            return;
+        }
+        if (agingWheel->IsInWheel(thread)) {
+            agingWheel->Remove(thread);
+        }
+        break;
+    }
+    kernel->scheduler->ReadyToRun(thread);
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::aging
+// 	Raise the priority of every thread that has waited on the
+//	priority queue for AgingTicks or more.  setPriority re-files
+//	the thread, moving it to the RR queue if it crosses
+//	PriSchdThreshold.
+//
+//	Each thread on the priority queue is also on the aging wheel,
+//	filed by the tick at which it next gets a boost, so only the
+//	threads that are actually due are touched here.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::aging ()
+{
+    int now = kernel->stats->totalTicks;
+    Thread *thread;
+
+    while ((thread = agingWheel->RemoveExpired(now)) != NULL) {
+        thread->setStartReadyTime(now);
+        thread->setPriority(PriorityAging + thread->getBasePriority());
+        if (readyPriorityList->IsInQueue(thread)) {     // still waiting here
+            agingWheel->Insert(thread, now + AgingTicks);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// MultiLevelPolicy::Print
+// 	Print the threads on the priority queue.
+//----------------------------------------------------------------------
+
+void
+MultiLevelPolicy::Print()
+{
+    readyPriorityList->Apply(ThreadPrint);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::CFSPolicy
+// 	Initialize an empty ready tree, and the weight of each priority
+//	level: CFS_NICE_0_WEIGHT at the default priority of 75, doubling
+//	every 10 levels above it and halving every 10 below.
+//----------------------------------------------------------------------
+
+CFSPolicy::CFSPolicy()
+{
+    const double step = 1.0717734625;	// 2 to the power 1/10
+
+    readyTree = new RBTree<Thread *>(Thread::compare_by_vruntime);
+    minVRuntime = 0;
+    readyWeight = 0;
+    runStart = 0;
+
+    weight[75] = CFS_NICE_0_WEIGHT;
+    for (int p = 76; p < NumPriorityLevels; p++) {
+        weight[p] = weight[p - 1] * step;
+    }
+    for (int p = 74; p >= 0; p--) {
+        weight[p] = weight[p + 1] / step;
+    }
+    WatchTier(TraceCFSQueue);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::~CFSPolicy
+// 	De-allocate the ready tree.
+//----------------------------------------------------------------------
+
+CFSPolicy::~CFSPolicy()
+{
+    delete readyTree;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Charge
+// 	Add the time "thread" has run since runStart to its virtual
+//	runtime, at the weight for "priority".  "thread" must be the
+//	running thread, and must not be in the ready tree, since its
+//	key changes.
+//----------------------------------------------------------------------
+
+void
+CFSPolicy::Charge(Thread *thread, int priority)
+{
+    int now = kernel->stats->totalTicks;
+
+    thread->setVRuntime(thread->getVRuntime() +
+                (now - runStart) * CFS_NICE_0_WEIGHT / weight[priority]);
+    runStart = now;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Enqueue
+// 	Put a ready thread in the tree.  If it is the running thread
+//	giving up the CPU, charge it first.  A thread that has been away
+//	(new, or blocked) is moved up to just behind the other ready
+//	threads, if it is further back than that.
+//----------------------------------------------------------------------
+
+TraceQueue
+CFSPolicy::Enqueue(Thread *thread)
+{
+    double floor = minVRuntime - CFS_LATENCY / 2;
+
+    if (thread == kernel->currentThread) {
+        Charge(thread, thread->getPriority());
+    }
+    if (thread->getVRuntime() < floor) {
+        thread->setVRuntime(floor);
+    }
+    readyTree->Insert(thread);
+    readyWeight += weight[thread->getPriority()];
+    return TraceCFSQueue;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Preempts
+// 	Return TRUE if "thread", just made ready, has been charged more
+//	than CFS_MIN_GRANULARITY (at the default weight) less than
+//	"running", counting what running has used since it was last
+//	charged.
+//----------------------------------------------------------------------
+
+bool
+CFSPolicy::Preempts(Thread *thread, Thread *running)
+{
+    double used = (kernel->stats->totalTicks - runStart)
+                  * CFS_NICE_0_WEIGHT / weight[running->getPriority()];
+
+    return (running->getVRuntime() + used - thread->getVRuntime()
+            > CFS_MIN_GRANULARITY);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::PickNext
+// 	Take the thread with the least virtual runtime out of the tree.
+//	Return NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+CFSPolicy::PickNext()
+{
+    Thread *thread;
+
+    if (readyTree->IsEmpty()) {
+        return NULL;
+    }
+    thread = readyTree->RemoveFirst();
+    readyWeight -= weight[thread->getPriority()];
+    minVRuntime = max(minVRuntime, thread->getVRuntime());
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Tick
+// 	Preempt the running thread once it has run for its share of
+//	CFS_LATENCY (but at least CFS_MIN_GRANULARITY) since it was
+//	last charged, if anyone else is waiting.
+//----------------------------------------------------------------------
+
+bool
+CFSPolicy::Tick(Thread *running)
+{
+    if (readyTree->IsEmpty()) {
+        return FALSE;
+    }
+    return (kernel->stats->totalTicks - runStart >= SliceOf(running));
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::SliceOf
+// 	Return the share of CFS_LATENCY "running" gets, given the
+//	threads now ready, but at least CFS_MIN_GRANULARITY.
+//----------------------------------------------------------------------
+
+double
+CFSPolicy::SliceOf(Thread *running)
+{
+    double w = weight[running->getPriority()];
+
+    return max(CFS_LATENCY * w / (readyWeight + w),
+               (double) CFS_MIN_GRANULARITY);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Quantum
+// 	Return how long "running" has left of its slice.  If no one is
+//	waiting, there's nothing to share, so just check back after the
+//	usual TimerTicks.
+//----------------------------------------------------------------------
+
+int
+CFSPolicy::Quantum(Thread *running)
+{
+    int left;
+
+    if (readyTree->IsEmpty()) {
+        return TimerTicks;
+    }
+    left = (int) (SliceOf(running) - (kernel->stats->totalTicks - runStart));
+    return max(left, 1);
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::Switch
+// 	The old thread has already been charged (by Enqueue or Block);
+//	start the clock for the next one.
+//----------------------------------------------------------------------
+
+void
+CFSPolicy::Switch(Thread *oldThread, Thread *nextThread)
+{
+    runStart = kernel->stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// CFSPolicy::PriorityChanged
+// 	A new priority means a new weight.  The running thread is
+//	charged at its old weight up to now; a ready thread keeps its
+//	place in the tree, but counts differently towards readyWeight.
+//----------------------------------------------------------------------
+
+void
+CFSPolicy::PriorityChanged(Thread *thread, int oldPriority)
+{
+    if (thread == kernel->currentThread) {
+        Charge(thread, oldPriority);
+    } else if (thread->getStatus() == READY && readyTree->IsInTree(thread)) {
+        readyWeight += weight[thread->getPriority()] - weight[oldPriority];
+    }
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::LotteryPolicy
+// 	Initialize an empty ready list.
+//----------------------------------------------------------------------
+
+LotteryPolicy::LotteryPolicy()
+{
+    readyList = new ReadyList;
+    totalTickets = 0;
+    WatchTier(TraceLotteryQueue);
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::~LotteryPolicy
+// 	De-allocate the ready list.
+//----------------------------------------------------------------------
+
+LotteryPolicy::~LotteryPolicy()
+{
+    delete readyList;
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::Enqueue
+// 	Put a ready thread on the list, and its tickets in the draw.
+//----------------------------------------------------------------------
+
+TraceQueue
+LotteryPolicy::Enqueue(Thread *thread)
+{
+    readyList->Append(thread);
+    totalTickets += TicketsOf(thread->getPriority());
+    return TraceLotteryQueue;
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::PickNext
+// 	Draw a ticket, and take the thread holding it off the list.
+//	Return NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+LotteryPolicy::PickNext()
+{
+    DListIterator<Thread, &Thread::readyLink> iter(readyList);
+    int winner;
+
+    if (readyList->IsEmpty()) {
+        return NULL;
+    }
+    winner = kernel->replay->Random(ReplayLottery) % totalTickets;
+    for (; !iter.IsDone(); iter.Next()) {
+        winner -= TicketsOf(iter.Item()->getPriority());
+        if (winner < 0) {
+            break;
+        }
+    }
+    ASSERT(!iter.IsDone());
+
+    Thread *thread = iter.Item();
+    readyList->Remove(thread);
+    totalTickets -= TicketsOf(thread->getPriority());
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// LotteryPolicy::PriorityChanged
+// 	A ready thread's tickets change with its priority.
+//----------------------------------------------------------------------
+
+void
+LotteryPolicy::PriorityChanged(Thread *thread, int oldPriority)
+{
+    if (thread->getStatus() == READY && ReadyList::IsLinked(thread)) {
+        totalTickets += TicketsOf(thread->getPriority())
+                        - TicketsOf(oldPriority);
+    }
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::StridePolicy
+// 	Initialize an empty ready heap.
+//----------------------------------------------------------------------
+
+StridePolicy::StridePolicy()
+{
+    readyHeap = new Heap<Thread *>(Thread::compare_by_vruntime);
+    globalPass = 0;
+    runStart = 0;
+    WatchTier(TraceStrideQueue);
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::~StridePolicy
+// 	De-allocate the ready heap.
+//----------------------------------------------------------------------
+
+StridePolicy::~StridePolicy()
+{
+    delete readyHeap;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::Charge
+// 	Advance the pass of "thread" by its stride, at the tickets for
+//	"priority", for every tick since runStart.  "thread" must be the
+//	running thread, and must not be in the heap, since its key
+//	changes.
+//----------------------------------------------------------------------
+
+void
+StridePolicy::Charge(Thread *thread, int priority)
+{
+    int now = kernel->stats->totalTicks;
+
+    thread->setVRuntime(thread->getVRuntime() +
+                (double) (now - runStart) * STRIDE_ONE / TicketsOf(priority));
+    runStart = now;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::Enqueue
+// 	Put a ready thread in the heap.  If it is the running thread
+//	giving up the CPU, charge it first; if it has been away, bring
+//	its pass up to globalPass.
+//----------------------------------------------------------------------
+
+TraceQueue
+StridePolicy::Enqueue(Thread *thread)
+{
+    if (thread == kernel->currentThread) {
+        Charge(thread, thread->getPriority());
+    }
+    if (thread->getVRuntime() < globalPass) {
+        thread->setVRuntime(globalPass);
+    }
+    readyHeap->Insert(thread);
+    return TraceStrideQueue;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::PickNext
+// 	Take the thread with the lowest pass out of the heap.  Return
+//	NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+StridePolicy::PickNext()
+{
+    Thread *thread;
+
+    if (readyHeap->IsEmpty()) {
+        return NULL;
+    }
+    thread = readyHeap->RemoveMin();
+    globalPass = max(globalPass, thread->getVRuntime());
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::Switch
+// 	The old thread has already been charged (by Enqueue or Block);
+//	start the clock for the next one.
+//----------------------------------------------------------------------
+
+void
+StridePolicy::Switch(Thread *oldThread, Thread *nextThread)
+{
+    runStart = kernel->stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// StridePolicy::PriorityChanged
+// 	The running thread is charged at its old tickets up to now.
+//	A ready thread keeps its pass; only its stride from now on
+//	changes.
+//----------------------------------------------------------------------
+
+void
+StridePolicy::PriorityChanged(Thread *thread, int oldPriority)
+{
+    if (thread == kernel->currentThread) {
+        Charge(thread, oldPriority);
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::MLFQPolicy
+// 	Initialize an empty queue for each level.
+//----------------------------------------------------------------------
+
+MLFQPolicy::MLFQPolicy()
+{
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        readyList[i] = new ReadyList;
+        runTicks[i] = 0;
+        readyArea[i] = 0;
+        numDemoted[i] = numPromoted[i] = 0;
+        WatchTier((TraceQueue) (TraceMLFQ0Queue + i));
+    }
+    lastBoost = lastSample = 0;
+    sliceStart = 0;
+    runLevel = 0;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::~MLFQPolicy
+// 	De-allocate the queues.
+//----------------------------------------------------------------------
+
+MLFQPolicy::~MLFQPolicy()
+{
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        delete readyList[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Sample
+// 	Add the time since lastSample, times the number of threads
+//	ready at each level, to readyArea.  Called before any queue
+//	changes length.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Sample()
+{
+    int now = kernel->stats->totalTicks;
+
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        readyArea[i] += (double) readyList[i]->NumInList() * (now - lastSample);
+    }
+    lastSample = now;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::LevelOf
+// 	Return the level of "thread".  A thread that has not been on a
+//	ready queue since the last boost was due is put back at the top
+//	first; the ready ones are moved by Boost.
+//----------------------------------------------------------------------
+
+int
+MLFQPolicy::LevelOf(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+
+    if (thread->getLevel() > 0
+            && thread->getLevelTime() < now - now % MLFQ_BOOST_TICKS) {
+        thread->setLevel(0, now);
+    }
+    return thread->getLevel();
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Boost
+// 	If a multiple of MLFQ_BOOST_TICKS has gone by since the last
+//	boost, move every ready thread to the end of the top queue,
+//	lower levels last.  Each level's queue is moved as a whole.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Boost()
+{
+    int now = kernel->stats->totalTicks;
+    int due = now - now % MLFQ_BOOST_TICKS;
+
+    if (lastBoost >= due) {
+        return;
+    }
+    lastBoost = due;
+    Sample();
+    for (int i = 1; i < MLFQ_LEVELS; i++) {
+        for (Thread *t = readyList[i]->Front(); t != NULL;
+             t = ReadyList::Next(t)) {
+            t->setLevel(0, now);
+        }
+        readyList[0]->Splice(readyList[i]);
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Charge
+// 	Count the running thread's CPU time since sliceStart against
+//	runLevel.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Charge(int now)
+{
+    runTicks[runLevel] += now - sliceStart;
+    sliceStart = now;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Enqueue
+// 	Put a ready thread at the end of the queue for its level.
+//----------------------------------------------------------------------
+
+TraceQueue
+MLFQPolicy::Enqueue(Thread *thread)
+{
+    int level;
+
+    Boost();
+    level = LevelOf(thread);
+    Sample();
+    readyList[level]->Append(thread);
+    return (TraceQueue) (TraceMLFQ0Queue + level);
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::PickNext
+// 	Take the first thread from the highest non-empty level.  Return
+//	NULL if no thread is ready.
+//----------------------------------------------------------------------
+
+Thread *
+MLFQPolicy::PickNext()
+{
+    Boost();
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        if (!readyList[i]->IsEmpty()) {
+            Sample();
+            return readyList[i]->RemoveFront();
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Tick
+// 	A timer interrupt arrived.  If "running" has used up its
+//	quantum, move it down a level and preempt it; it starts a fresh,
+//	longer quantum there, even if nothing else is ready.  Otherwise
+//	preempt it only if a thread is waiting at a higher level.
+//----------------------------------------------------------------------
+
+bool
+MLFQPolicy::Tick(Thread *running)
+{
+    int now = kernel->stats->totalTicks;
+    int level;
+
+    Boost();
+    level = LevelOf(running);
+    if (now - sliceStart >= QuantumOf(level)) {
+        Charge(now);
+        if (level < MLFQ_LEVELS - 1) {
+            level++;
+            numDemoted[level]++;
+            running->setLevel(level, now);
+        }
+        runLevel = level;
+        return TRUE;
+    }
+    for (int i = 0; i < level; i++) {
+        if (!readyList[i]->IsEmpty()) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Quantum
+// 	Return how long "running" has left of its quantum, or a whole
+//	new one if it has used it up and is carrying on.
+//----------------------------------------------------------------------
+
+int
+MLFQPolicy::Quantum(Thread *running)
+{
+    int quantum = QuantumOf(LevelOf(running));
+    int left = quantum - (kernel->stats->totalTicks - sliceStart);
+
+    return (left > 0) ? left : quantum;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Block
+// 	"thread" is giving up the CPU to wait.  If it did so before
+//	using up its quantum, it's behaving interactively: move it up a
+//	level.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Block(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+    int level = LevelOf(thread);
+
+    if (level > 0 && now - sliceStart < QuantumOf(level)) {
+        level--;
+        numPromoted[level]++;
+        thread->setLevel(level, now);
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Switch
+// 	Charge the old thread for its quantum, and start one for the
+//	next thread.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Switch(Thread *oldThread, Thread *nextThread)
+{
+    int now = kernel->stats->totalTicks;
+
+    if (oldThread != NULL) {
+        Charge(now);
+    }
+    sliceStart = now;
+    if (nextThread != NULL) {
+        runLevel = LevelOf(nextThread);
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::NumReady
+// 	Return the number of ready threads, at all levels.
+//----------------------------------------------------------------------
+
+int
+MLFQPolicy::NumReady()
+{
+    int n = 0;
+
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        n += readyList[i]->NumInList();
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::Print
+// 	Print the ready threads, top level first.
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::Print()
+{
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        cout << "Level " << i << ": ";
+        readyList[i]->Apply(ThreadPrint);
+        cout << "\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// MLFQPolicy::PrintStats
+// 	Print, for each level, the CPU time used there, the average
+//	number of threads ready there, and how many threads moved to it
+//	from the level below (promoted) or above (demoted).
+//----------------------------------------------------------------------
+
+void
+MLFQPolicy::PrintStats()
+{
+    Sample();
+    for (int i = 0; i < MLFQ_LEVELS; i++) {
+        cout << "    Level " << i << " (quantum " << QuantumOf(i) << "): ran "
+             << runTicks[i] << " ticks, "
+             << (lastSample > 0 ? readyArea[i] / lastSample : 0)
+             << " ready on average, " << numPromoted[i] << " promoted, "
+             << numDemoted[i] << " demoted\n";
+    }
+}
@@ -0,0 +1,391 @@
+// schedpolicy.h
+//	Scheduling policies that can be plugged into the Scheduler.
+//
+//	The Scheduler looks after thread status, the scheduler trace and
+//	the context switch itself; the policy decides which ready thread
+//	runs next.  Every policy provides the same set of hooks:
+//
+//	    Enqueue(thread)	-- thread is ready to run; return the
+//				   TraceQueue it went on
+//	    PickNext()		-- remove and return the thread to run next,
+//				   or NULL if none is ready
+//	    Tick(running)	-- a timer interrupt arrived while "running"
+//				   was on the CPU; return TRUE to preempt it
+//	    Quantum(running)	-- how many ticks "running" may have before
+//				   the next timer interrupt; asked when it is
+//				   dispatched and after each Tick
+//	    Block(thread)	-- thread is giving up the CPU to wait
+//	    Wake(thread)	-- blocked thread is about to be made ready
+//				   (called just before Enqueue)
+//	    Preempts(thread, running)
+//				-- thread was just made ready; return TRUE
+//				   if it should take the CPU from running
+//				   (only asked with -preempt)
+//	    Switch(old, next)	-- the CPU is being handed from old to next;
+//				   either is NULL if the CPU was or is
+//				   going to be idle
+//	    PriorityChanged(thread, oldPriority)
+//				-- thread's priority was changed
+//	    NumReady()		-- how many threads are ready
+//	    Print()		-- print the ready threads, for debugging
+//	    PrintStats()	-- print what the policy kept count of,
+//				   when Nachos halts
+//
+//	The policy is chosen when Nachos is built, by adding one of
+//	-DPOLICY_FIFO, -DPOLICY_RR, -DPOLICY_CFS, -DPOLICY_LOTTERY,
+//	-DPOLICY_STRIDE or -DPOLICY_MLFQ to DEFINES in the Makefile; with
+//	none of them, the multilevel SJF/RR/priority policy is used.
+//	SchedulerPolicy names the chosen class, and the Scheduler calls it
+//	directly, so there are no virtual functions on the dispatch path.
+//	Each CPU has its own instance, which is that CPU's run queue.
+//
+//	Each policy registers, as it is created, the wait time histogram
+//	of each TraceQueue it puts threads on (see statsregistry.h).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDPOLICY_H
+#define SCHEDPOLICY_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+#include "runqueue.h"
+#include "rbtree.h"
+#include "heap.h"
+#include "schedtrace.h"
+
+// The multilevel policy's tuning: these can be changed without a
+// rebuild, by a "-cf" configuration file (see Kernel::ReadConfig).
+extern int AgingTicks;		// a waiting thread is aged this often (1500)
+extern int PriorityAging;	// by this much priority (10)
+extern int PriSchdThreshold;	// lowest priority of the RR tier (60)
+extern int SJFSchdThreshold;	// and of the SJF tier (100)
+
+#define AGING_WHEEL_SLOTS   32
+
+#define CFS_LATENCY         4000	// every ready thread should run
+					// once per this many ticks
+#define CFS_MIN_GRANULARITY 500		// shortest slice worth switching for
+#define CFS_NICE_0_WEIGHT   1024	// weight of a priority 75 thread
+
+#define QUANTUM_MIN         100		// shortest time slice
+#define QUANTUM_MAX         (4 * TimerTicks)	// longest time slice
+#define QUANTUM_SCALE       1.25	// an adaptive slice is this many
+					// times the predicted burst
+
+#define STRIDE_ONE          1000	// pass added per tick, for one ticket
+
+#define MLFQ_LEVELS         3		// must match the TraceMLFQ queues
+#define MLFQ_QUANTUM        TimerTicks	// quantum of the top level; each
+					// level down gets twice as long
+#define MLFQ_BOOST_TICKS    10000	// everyone goes back to the top
+					// this often
+
+// Register the histogram of how long threads waited on "queue", to be
+// sampled over time.  Every CPU's policy registers the same ones.
+
+void WatchTier(TraceQueue queue);
+
+// Return a time slice for "thread" that fits its predicted burst
+// (see predictor.h), so that most bursts end within one slice, but
+// between "shortest" and "longest".
+
+inline int
+AdaptiveQuantum(Thread *thread, int shortest, int longest)
+{
+    int quantum = (int) (QUANTUM_SCALE * thread->getBurstTime());
+
+    return min(max(quantum, shortest), longest);
+}
+
+// The following class defines first-come first-served scheduling.
+// Threads run until they block or finish; nothing preempts them.
+
+class FIFOPolicy {
+  public:
+    FIFOPolicy(TraceQueue queueID = TraceFIFOQueue) {
+	readyList = new ReadyList;
+	queue = queueID;
+	WatchTier(queue);
+    }
+    ~FIFOPolicy() { delete readyList; }
+
+    TraceQueue Enqueue(Thread *thread) {
+	readyList->Append(thread);
+	return queue;
+    }
+    Thread *PickNext() {
+	return readyList->IsEmpty() ? NULL : readyList->RemoveFront();
+    }
+    bool Tick(Thread *running) { return FALSE; }
+    int Quantum(Thread *running) { return TimerTicks; }
+    void Block(Thread *thread) {}
+    void Wake(Thread *thread) {}
+    bool Preempts(Thread *thread, Thread *running) { return FALSE; }
+    void Switch(Thread *oldThread, Thread *nextThread) {}
+    void PriorityChanged(Thread *thread, int oldPriority) {}
+    int NumReady() { return readyList->NumInList(); }
+    void Print() { readyList->Apply(ThreadPrint); }
+    void PrintStats() {}
+
+  protected:
+    ReadyList *readyList;	// threads in the order they became ready
+    TraceQueue queue;		// what the trace calls readyList
+};
+
+// The following class defines round robin scheduling: FIFO order, but
+// the running thread goes to the back of the queue on every timer
+// interrupt.
+
+class RRPolicy : public FIFOPolicy {
+  public:
+    RRPolicy() : FIFOPolicy(TraceRRQueue) {}
+    bool Tick(Thread *running) { return TRUE; }
+};
+
+// The ready queue a thread goes on is decided by its priority.
+enum ReadyTier { SJFTier, RRTier, PriorityTier };
+
+// The following class defines the multilevel policy:
+//	priority >= SJFSchdThreshold: shortest predicted burst first
+//	priority >= PriSchdThreshold: round robin
+//	otherwise: highest priority first, with aging
+// A tier is only looked at when the tiers above it are empty.
+// Time slices are longer in the SJF tier and shorter in the RR tier,
+// and adapt to each thread's predicted burst.
+//
+// With -preempt, a thread made ready in a higher tier than the running
+// thread takes the CPU at once.  Within the SJF tier it does so if its
+// predicted burst is shorter than what is left of the running thread's
+// (shortest remaining time first), and within the priority tier if its
+// priority is higher.
+
+class MultiLevelPolicy {
+  public:
+    MultiLevelPolicy();
+    ~MultiLevelPolicy();
+
+    TraceQueue Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool Tick(Thread *running) { return TRUE; }
+    int Quantum(Thread *running);
+    void Block(Thread *thread) {}
+    void Wake(Thread *thread) {}
+    bool Preempts(Thread *thread, Thread *running);
+    void Switch(Thread *oldThread, Thread *nextThread);
+    void PriorityChanged(Thread *thread, int oldPriority);
+    int NumReady() {
+	return readyRRList->NumInList() + readyPriorityList->NumInQueue()
+		+ readySJFList->NumInList();
+    }
+    void Print();
+    void PrintStats() {}
+
+    static ReadyTier TierOf(int priority);
+				// which queue a thread at "priority" uses
+
+  private:
+    ReadyList *readyRRList;
+    RunQueue *readyPriorityList;	// indexed by priority, so queueing
+					// and picking are constant time
+    ReadyList *readySJFList;	// by predicted burst
+
+    AgingWheel *agingWheel;	// aging deadlines of the threads on
+				// readyPriorityList
+    void aging();
+};
+
+// The following class defines a fair-share policy, after Linux's CFS.
+// Each thread is charged for the CPU time it uses, scaled down by a
+// weight that grows with its priority (x2 for every 10 levels), and
+// the ready thread that has been charged least runs next.  Ready
+// threads are kept in a red-black tree ordered by this "virtual
+// runtime", so picking and queueing take O(log n) time.
+//
+// A thread is preempted once it has had its share of CFS_LATENCY, so
+// every ready thread gets the CPU within about CFS_LATENCY ticks.
+// Threads that slept are placed no more than half a CFS_LATENCY
+// behind the least-charged ready thread, so they can't hoard credit.
+// With -preempt, a thread that wakes up more than CFS_MIN_GRANULARITY
+// behind the running thread takes the CPU at once.
+
+class CFSPolicy {
+  public:
+    CFSPolicy();
+    ~CFSPolicy();
+
+    TraceQueue Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool Tick(Thread *running);
+    int Quantum(Thread *running);
+    void Block(Thread *thread) { Charge(thread, thread->getPriority()); }
+    void Wake(Thread *thread) {}
+    bool Preempts(Thread *thread, Thread *running);
+    void Switch(Thread *oldThread, Thread *nextThread);
+    void PriorityChanged(Thread *thread, int oldPriority);
+    int NumReady() { return readyTree->NumInTree(); }
+    void Print() { readyTree->Apply(ThreadPrint); }
+    void PrintStats() {}
+
+  private:
+    RBTree<Thread *> *readyTree;	// ready threads, by vruntime
+    double minVRuntime;		// never decreases; where sleepers
+				// are placed
+    double readyWeight;		// total weight of the ready threads
+    int runStart;		// when the running thread was last charged
+    double weight[NumPriorityLevels];
+				// weight of each priority level
+
+    void Charge(Thread *thread, int priority);
+				// charge the running thread for the
+				// time since runStart
+    double SliceOf(Thread *running);	// running's share of CFS_LATENCY
+};
+
+// Under the proportional-share policies, a thread at priority p (as
+// given with -ep) holds p + 1 tickets, so even priority 0 gets a share.
+
+inline int TicketsOf(int priority) { return priority + 1; }
+
+// The following class defines lottery scheduling.  On every time
+// slice a ticket is drawn at random from those held by the ready
+// threads, and its holder runs, so over time each thread gets CPU in
+// proportion to its tickets.  Picking is linear in the number of
+// ready threads.
+
+class LotteryPolicy {
+  public:
+    LotteryPolicy();
+    ~LotteryPolicy();
+
+    TraceQueue Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool Tick(Thread *running) { return TRUE; }
+    int Quantum(Thread *running) { return TimerTicks; }
+    void Block(Thread *thread) {}
+    void Wake(Thread *thread) {}
+    bool Preempts(Thread *thread, Thread *running) { return FALSE; }
+    void Switch(Thread *oldThread, Thread *nextThread) {}
+    void PriorityChanged(Thread *thread, int oldPriority);
+    int NumReady() { return readyList->NumInList(); }
+    void Print() { readyList->Apply(ThreadPrint); }
+    void PrintStats() {}
+
+  private:
+    ReadyList *readyList;
+    int totalTickets;		// held by the threads on readyList
+};
+
+// The following class defines stride scheduling, the deterministic
+// version of lottery scheduling.  Each thread has a "pass", which goes
+// up by STRIDE_ONE / tickets for every tick it runs, and the ready
+// thread with the lowest pass runs next.  Ready threads are kept in a
+// min-heap on pass (in the vruntime field), so picking and queueing
+// take O(log n) time.
+//
+// A thread that was away (new, or blocked) starts again from the pass
+// of the last thread picked, so it can't save up CPU time.
+
+class StridePolicy {
+  public:
+    StridePolicy();
+    ~StridePolicy();
+
+    TraceQueue Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool Tick(Thread *running) { return !readyHeap->IsEmpty(); }
+    int Quantum(Thread *running) { return TimerTicks; }
+    void Block(Thread *thread) { Charge(thread, thread->getPriority()); }
+    void Wake(Thread *thread) {}
+    bool Preempts(Thread *thread, Thread *running) { return FALSE; }
+    void Switch(Thread *oldThread, Thread *nextThread);
+    void PriorityChanged(Thread *thread, int oldPriority);
+    int NumReady() { return readyHeap->NumInHeap(); }
+    void Print() { readyHeap->Apply(ThreadPrint); }
+    void PrintStats() {}
+
+  private:
+    Heap<Thread *> *readyHeap;	// ready threads, by pass
+    double globalPass;		// pass of the last thread picked
+    int runStart;		// when the running thread was last charged
+
+    void Charge(Thread *thread, int priority);
+				// advance the running thread's pass for
+				// the time since runStart
+};
+
+// The following class defines a multi-level feedback queue.  Every
+// thread starts at the top level, 0.  One that uses up the quantum of
+// its level moves down a level, where the quantum is twice as long;
+// one that blocks before using it up moves up a level.  Every
+// MLFQ_BOOST_TICKS all threads go back to the top, so CPU-bound ones
+// don't starve.  The highest non-empty level runs first (round robin
+// within a level), and a thread made ready above the running thread
+// takes the CPU at the next timer interrupt, or at once with -preempt.
+//
+// Priorities set with -ep are not used.  At halt, each level's CPU
+// time, average number of ready threads and moves are printed.
+
+class MLFQPolicy {
+  public:
+    MLFQPolicy();
+    ~MLFQPolicy();
+
+    TraceQueue Enqueue(Thread *thread);
+    Thread *PickNext();
+    bool Tick(Thread *running);
+    int Quantum(Thread *running);
+    void Block(Thread *thread);
+    void Wake(Thread *thread) {}
+    bool Preempts(Thread *thread, Thread *running) {
+	return (LevelOf(thread) < LevelOf(running));
+    }
+    void Switch(Thread *oldThread, Thread *nextThread);
+    void PriorityChanged(Thread *thread, int oldPriority) {}
+    int NumReady();
+    void Print();
+    void PrintStats();
+
+    static int QuantumOf(int level) { return MLFQ_QUANTUM << level; }
+
+  private:
+    ReadyList *readyList[MLFQ_LEVELS];
+    int lastBoost;		// time of the last boost done
+    int sliceStart;		// when the running thread's quantum began
+    int runLevel;		// level the running thread is charged to
+
+    // per-level statistics
+    int runTicks[MLFQ_LEVELS];	// CPU time used at each level
+    double readyArea[MLFQ_LEVELS];	// ready threads x ticks
+    int lastSample;		// when readyArea was brought up to date
+    int numDemoted[MLFQ_LEVELS];	// moves down to each level
+    int numPromoted[MLFQ_LEVELS];	// moves up to each level
+
+    int LevelOf(Thread *thread);    // thread's level, after any boost
+    void Boost();		// if a boost is due, move every ready
+				// thread to the top
+    void Sample();		// bring readyArea up to date
+    void Charge(int now);	// charge the running thread's quantum
+				// so far to runLevel
+};
+
+#if defined(POLICY_FIFO)
+typedef FIFOPolicy SchedulerPolicy;
+#elif defined(POLICY_RR)
+typedef RRPolicy SchedulerPolicy;
+#elif defined(POLICY_CFS)
+typedef CFSPolicy SchedulerPolicy;
+#elif defined(POLICY_LOTTERY)
+typedef LotteryPolicy SchedulerPolicy;
+#elif defined(POLICY_STRIDE)
+typedef StridePolicy SchedulerPolicy;
+#elif defined(POLICY_MLFQ)
+typedef MLFQPolicy SchedulerPolicy;
+#else
+typedef MultiLevelPolicy SchedulerPolicy;
+#endif
+
+#endif // SCHEDPOLICY_H
@@ -0,0 +1,94 @@
+// schedtrace.cc
+//	Routines to record the scheduler trace, either by printing it
+//	or by buffering it in binary for tracedump.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "schedtrace.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// SchedTrace::SchedTrace
+// 	Initialize the trace.  If we are writing a file, create it and
+//	put the magic number at the front.
+//
+//	"traceFile" is the file to write, or NULL to print each record
+//	as it is made.
+//----------------------------------------------------------------------
+
+SchedTrace::SchedTrace(char *traceFile)
+{
+    numRecords = 0;
+    if (traceFile == NULL) {
+        fd = -1;
+        ring = NULL;
+    } else {
+        int magic = TraceMagic;
+
+        fd = OpenForWrite(traceFile);
+        WriteFile(fd, (char *) &magic, sizeof(magic));
+        ring = new TraceRecord[TraceRingSize];
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::~SchedTrace
+// 	Nachos is halting; write out whatever is still buffered.
+//----------------------------------------------------------------------
+
+SchedTrace::~SchedTrace()
+{
+    if (fd >= 0) {
+        Dump();
+        Close(fd);
+        delete [] ring;
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::Record
+// 	Note that something happened to a thread, now.
+//
+//	"event" is what happened.
+//	"threadID" is the thread it happened to.
+//	"where" is the ready queue for TraceReady, the CPU for
+//		TraceRunning.
+//----------------------------------------------------------------------
+
+void
+SchedTrace::Record(TraceEvent event, int threadID, int where)
+{
+    TraceRecord record;
+
+    record.tick = kernel->stats->totalTicks;
+    record.threadID = threadID;
+    record.event = event;
+    record.where = where;
+
+    if (fd < 0) {
+        TracePrint(record);
+        return;
+    }
+    ring[numRecords++] = record;
+    if (numRecords == TraceRingSize) {
+        Dump();
+    }
+}
+
+//----------------------------------------------------------------------
+// SchedTrace::Dump
+// 	Write the buffered records to the trace file and empty the
+//	buffer.  Does nothing if we are printing the trace instead.
+//----------------------------------------------------------------------
+
+void
+SchedTrace::Dump()
+{
+    if (fd >= 0 && numRecords > 0) {
+        WriteFile(fd, (char *) ring, numRecords * sizeof(TraceRecord));
+        numRecords = 0;
+    }
+}
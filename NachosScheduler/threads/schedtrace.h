@@ -0,0 +1,117 @@
+// schedtrace.h
+//	Data structures for the scheduler trace: one record each time a
+//	thread is created, made ready, dispatched, put to sleep or
+//	finishes.
+//
+//	By default each record is printed as soon as it is made, in the
+//	format the result-*.out files expect:
+//
+//	    Thread 1	ProcessNew	0
+//	    Tick 10 Thread 1 move to RR queue
+//	    Thread 1	ProcessReady	10
+//	    Thread 1	ProcessRunning	30
+//	    Thread 1	ProcessSleep	52
+//	    Thread 1	ProcessFinish	900
+//
+//	Formatting all that with iostreams is most of what Nachos spends
+//	its time on in a long run, so with "-tr <file>" the records are
+//	instead kept, twelve bytes each, in a ring in memory, and written
+//	out in binary whenever the ring fills up, on SchedTrace::Dump,
+//	and at halt.  tracedump (threads/tracedump.cc, "make tracedump")
+//	turns the file back into the text above, or into Chrome trace
+//	JSON for chrome://tracing.
+//
+//	Priority and burst time changes are still printed directly.
+//
+//	This header is shared with tracedump, so it must not depend on
+//	the rest of Nachos.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDTRACE_H
+#define SCHEDTRACE_H
+
+#include "copyright.h"
+#include "sysdep.h"
+
+const int TraceRingSize = 4096;		// records buffered before a dump
+const int TraceMagic = 0x4e545232;	// "NTR2", at the start of the file
+
+enum TraceEvent { TraceNew, TraceReady, TraceRunning, TraceSleep,
+                  TraceFinish };
+
+// The ready queue a TraceReady record went to.
+enum TraceQueue { TraceSJFQueue, TraceRRQueue, TracePriorityQueue,
+                  TraceFIFOQueue, TraceCFSQueue, TraceLotteryQueue,
+                  TraceStrideQueue, TraceMLFQ0Queue, TraceMLFQ1Queue,
+                  TraceMLFQ2Queue, NumTraceQueues };
+
+static const char *traceQueueNames[NumTraceQueues] =
+    { "SJF", "RR", "Priority", "FIFO", "CFS", "Lottery", "Stride",
+      "MLFQ0", "MLFQ1", "MLFQ2" };
+
+// One trace record, as it appears in the binary file.
+
+class TraceRecord {
+  public:
+    int tick;			// stats->totalTicks when it happened
+    int threadID;		// an int, since a replayed job list
+				// can run more than 32767 threads
+    unsigned char event;	// a TraceEvent
+    unsigned char where;	// TraceReady: the TraceQueue;
+				// TraceRunning: the CPU; otherwise 0
+};
+
+// Print "record" the way Nachos used to print it as it happened.
+
+static inline void
+TracePrint(const TraceRecord &record)
+{
+    switch (record.event) {
+      case TraceNew:
+        cout << "Thread " << record.threadID << "\tProcessNew\t"
+             << record.tick << endl;
+        break;
+      case TraceReady:
+        cout << "Tick " << record.tick << " Thread " << record.threadID
+             << " move to " << traceQueueNames[record.where] << " queue"
+             << endl;
+        cout << "Thread " << record.threadID << "\tProcessReady\t"
+             << record.tick << endl;
+        break;
+      case TraceRunning:
+        cout << "Thread " << record.threadID << "\tProcessRunning\t"
+             << record.tick << endl;
+        break;
+      case TraceSleep:
+        cout << "Thread " << record.threadID << "\tProcessSleep\t"
+             << record.tick << endl;
+        break;
+      case TraceFinish:
+        cout << "Thread " << record.threadID << "\tProcessFinish\t"
+             << record.tick << endl;
+        break;
+    }
+}
+
+// The following class collects the trace while Nachos runs.
+
+class SchedTrace {
+  public:
+    SchedTrace(char *traceFile);	// print as we go if traceFile is
+					// NULL, otherwise write it there
+    ~SchedTrace();			// dump what's left
+
+    void Record(TraceEvent event, int threadID, int where = 0);
+					// something happened to a thread
+    void Dump();			// write out the buffered records
+
+  private:
+    int fd;			// trace file, -1 if printing
+    TraceRecord *ring;		// buffered records, if writing a file
+    int numRecords;		// how many are buffered
+};
+
+#endif // SCHEDTRACE_H
@@ -4,15 +4,17 @@
 //
 // 	These routines assume that interrupts are already disabled.
 //	If interrupts are disabled, we can assume mutual exclusion
-//	(since we are on a uniprocessor).
+//	(since we are on a uniprocessor, or on simulated CPUs that
+//	only change hands while interrupts are enabled).
 //
 // 	NOTE: We can't use Locks to provide mutual exclusion here, since
 // 	if we needed to wait for a lock, and the lock was busy, we would 
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	The choice of which ready thread runs next is left to the
+//	scheduling policy selected at build time; see schedpolicy.h.
+//	Each CPU has its own copy of the policy, as its run queue.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -23,30 +25,118 @@
 #include "scheduler.h"
 #include "main.h"
 
+const int DestroyBatch = 4;	// finished threads deleted per dispatch;
+				// the rest wait for the next one, or for
+				// the CPU to go idle
+
+int AffinityTicks = 1000;
+int MigrationTicks = 250;
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
-// 	Initialize the list of ready but not running threads.
-//	Initially, no ready threads.
+// 	Initialize the dispatcher.  The ready threads are kept in
+//	the run queues of the CPUs, which the kernel creates.
+//
+//	"preemptive" is TRUE if a thread that is made ready should
+//	take the CPU from the running thread straight away, when the
+//	policy says it should, instead of at the next time slice.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(bool preemptive, bool dynamicTicks)
 { 
-    readyRRList = new List<Thread *>("RR");
-    readyPriorityList = new SortedList<Thread *>("Priority", Thread::compare_by_priority);
-    readySJFList = new SortedList<Thread *>("SJF", Thread::compare_by_burst);
+    preempt = preemptive;
+    tickless = dynamicTicks;
     toBeDestroyed = NULL;
+    numToBeDestroyed = 0;
 } 
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the dispatcher.
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler()
 { 
-    delete readyRRList; 
-    delete readyPriorityList;
-    delete readySJFList;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CPUOf
+// 	Return the CPU whose run queue "thread" belongs on: the one it
+//	is queued on or last ran on, or the current CPU for a thread
+//	that has never been scheduled.
+//----------------------------------------------------------------------
+
+CPU *
+Scheduler::CPUOf(Thread *thread)
+{
+    if (thread->getCPU() < 0) {
+        return kernel->currentCPU;
+    }
+    return kernel->cpus[thread->getCPU()];
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Load
+// 	Return about how long "thread" would wait for "cpu", if queued
+//	there now: a time slice for each thread already ready, and
+//	what the running thread is predicted to have left of its burst,
+//	at most one slice.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Load(CPU *cpu, Thread *thread)
+{
+    Thread *running = cpu->currentThread;
+    int load = cpu->readyQueue->NumReady() * TimerTicks;
+
+    if (running != NULL && running != thread) {
+        int now = (cpu == kernel->currentCPU) ? kernel->stats->totalTicks
+                                              : cpu->clock;
+        int left = (int) running->getBurstTime()
+                       - (now - running->getStartBurst());
+
+        load += (left < 0) ? 0 : (left > TimerTicks) ? TimerTicks : left;
+    }
+    return load;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Place
+// 	Return the CPU whose run queue a thread that is waking up (or
+//	is new) should go on: the one it would wait least for, unless
+//	that saves it less than the cost of moving away from the CPU
+//	it last ran on.  See scheduler.h.
+//----------------------------------------------------------------------
+
+CPU *
+Scheduler::Place(Thread *thread)
+{
+    ThreadStats *threadStats = thread->getSchedStats();
+    CPU *last = CPUOf(thread);
+    CPU *best = last;
+    int bestLoad = Load(last, thread);
+    int cost = 0;
+    int age;
+
+    if (threadStats->lastCPU >= 0) {
+        age = kernel->stats->totalTicks - threadStats->lastRan;
+        if (age < AffinityTicks) {
+            cost = MigrationTicks * (AffinityTicks - age) / AffinityTicks;
+        }
+    }
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        CPU *cpu = kernel->cpus[i];
+        int load = Load(cpu, thread);
+
+        if (cpu != last && load + cost < bestLoad) {
+            best = cpu;
+            bestLoad = load + cost;
+        }
+    }
+    if (best != last) {
+        DEBUG(dbgThread, "Placing " << thread->getName() << " on CPU " << best->getID() << " rather than CPU " << last->getID() << ", at a cost of " << cost);
+    }
+    return best;
 }
 
 //----------------------------------------------------------------------
@@ -60,80 +150,181 @@ Scheduler::~Scheduler()
 void
 Scheduler::ReadyToRun (Thread *thread)
 {
+    CPU *cpu;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
     
+    if (kernel->numCPUs > 1 && (thread->getStatus() == BLOCKED
+                                || thread->getStatus() == JUST_CREATED)) {
+        cpu = Place(thread);
+    } else {
+        cpu = CPUOf(thread);
+    }
+    if (thread->getStatus() == BLOCKED) {
+        cpu->readyQueue->Wake(thread);
+    }
+    if (thread->getStatus() != READY) {	// not just moving queues
+        thread->getSchedStats()->readySince = kernel->stats->totalTicks;
+    }
     thread->setStatus(READY); 
     thread->setStartReadyTime(kernel->stats->totalTicks);
+    thread->setCPU(cpu->getID());
 
-    cout << "Tick " << kernel->stats->totalTicks << " Thread " << thread->getID() << " ";
+    TraceQueue queue = cpu->readyQueue->Enqueue(thread);
 
-    int pri = thread->getPriority();
-    if (pri >= SJF_SCHD_THRESHHOLD) {
-        readySJFList->Append(thread);
-    } else if (pri >= PRI_SCHD_THRESHHOLD) {
-        readyRRList->Append(thread);
-    } else {
-        readyPriorityList->Append(thread);
+    thread->getSchedStats()->tier = queue;
+    kernel->trace->Record(TraceReady, thread->getID(), queue);
+
+    // Only the CPU being simulated can be preempted; the others
+    // will see the thread at their next time slice.
+    Thread *running = cpu->currentThread;
+    if (preempt && cpu == kernel->currentCPU && running != NULL
+            && running != thread && running->getStatus() == RUNNING
+            && cpu->readyQueue->Preempts(thread, running)) {
+        kernel->interrupt->Preempt();
+    }
+
+    // With dynamic ticks, the running thread only gets a time slice
+    // once someone is waiting.  Other CPUs start theirs when they
+    // are next simulated.
+    if (tickless && cpu == kernel->currentCPU && running != NULL
+            && running != thread && running->getStatus() == RUNNING
+            && !cpu->alarm->IsSlicing()) {
+        SetTimer(cpu);
     }
-    cout << "Thread " <<  thread->getID() << "\tProcessReady\t" << kernel->stats->totalTicks << endl;
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Dispatched
+// 	"thread" has just been given a CPU.  Count how long it waited
+//	for it, in the histogram of the ready queue it waited on, and
+//	how long it took to get a CPU the first time; and whether it
+//	moved here from another CPU, with a TLB that may still have
+//	been warm.
+//----------------------------------------------------------------------
+
 void
-Scheduler::aging (List<Thread *>* readylist)
+Scheduler::Dispatched(Thread *thread)
 {
-    SortedList<Thread *>* list = dynamic_cast<SortedList<Thread *>*>(readylist);
-    ListIterator<Thread *> *iter = new ListIterator<Thread *>((List<Thread *>*) list);
-    for (; !iter->IsDone(); iter->Next()) {
-        Thread* thread = iter->Item();
-        int clocks_interval = kernel->stats->totalTicks - thread->getStartReadyTime();
-        if (clocks_interval >= AGING_TICKS) {
-            thread->setPriority(PRIORITY_AGING + thread->getPriority());
-            thread->setStartReadyTime(kernel->stats->totalTicks);
-            list->Remove(thread);
-            list->Insert(thread);
+    ThreadStats *threadStats = thread->getSchedStats();
+    CPU *cpu = kernel->cpus[thread->getCPU()];
+    int now = kernel->stats->totalTicks;
+    int waited = now - threadStats->readySince;
+
+    threadStats->migrated = threadStats->lastCPU >= 0
+                              && threadStats->lastCPU != cpu->getID();
+    if (threadStats->migrated) {
+        cpu->numMigrations++;
+        if (now - threadStats->lastRan < AffinityTicks) {
+            cpu->numHotMigrations++;
         }
     }
-    processMoving();
+    threadStats->tlbMisses = (cpu->tlb == NULL) ? 0 : cpu->tlb->NumMisses();
+
+    threadStats->totalWait += waited;
+    threadStats->numSwitches++;
+    if (threadStats->firstRun < 0) {
+        threadStats->firstRun = now;
+    }
+    if (threadStats->tier >= 0) {
+        kernel->stats->waitTime[threadStats->tier].Add(waited);
+    }
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Departed
+// 	"thread" is giving up the current CPU.  Remember that it ran
+//	here, and until when, for Place; and count the TLB misses it
+//	took, to show what migrating costs.
+//----------------------------------------------------------------------
+
 void
-Scheduler::processMoving ()
+Scheduler::Departed(Thread *thread)
 {
-    ListIterator<Thread *>* iterRR  = new ListIterator<Thread *>((List<Thread *>*) readyRRList);
-    ListIterator<Thread *> *iterPri = new ListIterator<Thread *>((List<Thread *>*) readyPriorityList);
-    ListIterator<Thread *> *iterSJF = new ListIterator<Thread *>((List<Thread *>*) readySJFList);
-    
-    for (; !iterSJF->IsDone(); iterSJF->Next()) {
-        Thread* thread = iterSJF->Item();
-        if (thread->getPriority() < SJF_SCHD_THRESHHOLD) {
-            readySJFList->Remove(thread);
-            ReadyToRun(thread);
-        }
+    ThreadStats *threadStats = thread->getSchedStats();
+    CPU *cpu = kernel->currentCPU;
+    int misses = (cpu->tlb == NULL) ? 0
+                   : cpu->tlb->NumMisses() - threadStats->tlbMisses;
+
+    threadStats->lastCPU = cpu->getID();
+    threadStats->lastRan = kernel->stats->totalTicks;
+    if (threadStats->migrated) {
+        cpu->migratedMisses += misses;
+        cpu->migratedRuns++;
+    } else {
+        cpu->stayedMisses += misses;
+        cpu->stayedRuns++;
     }
+}
 
-    for (; !iterRR->IsDone(); iterRR->Next()) {
-        Thread* thread = iterRR->Item();
-        if (thread->getPriority() < PRI_SCHD_THRESHHOLD
-                || thread->getPriority() >= SJF_SCHD_THRESHHOLD) {
-            readyRRList->Remove(thread);
-            ReadyToRun(thread);
-        }
+//----------------------------------------------------------------------
+// Scheduler::PriorityChanged
+// 	Called by Thread::setPriority whenever a thread's priority
+//	changes, so the policy can move it if it is ready.
+//
+//	"thread" is the thread whose priority changed.
+//	"oldPriority" is its priority before the change.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PriorityChanged(Thread *thread, int oldPriority)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    CPUOf(thread)->readyQueue->PriorityChanged(thread, oldPriority);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Tick
+// 	Called on each timer interrupt while a thread is running.
+//	Return TRUE if the policy wants the running thread preempted.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::Tick()
+{
+    return kernel->currentCPU->readyQueue->Tick(kernel->currentThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SetTimer
+// 	Program the timer of "cpu", which must be the CPU being
+//	simulated, to interrupt when the policy says its running
+//	thread's time slice ends.
+//
+//	With dynamic ticks, if no other thread is waiting for the CPU,
+//	there is nothing to switch to, so the timer is stopped instead;
+//	ReadyToRun starts it again once someone is waiting.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SetTimer(CPU *cpu)
+{
+    if (tickless && cpu->readyQueue->NumReady() == 0) {
+        cpu->alarm->Stop();
+    } else {
+        cpu->alarm->SetQuantum(cpu->readyQueue->Quantum(cpu->currentThread));
     }
+}
 
-    for (; !iterPri->IsDone(); iterPri->Next()) {
-        Thread* thread = iterPri->Item();
-        if (thread->getPriority() >= PRI_SCHD_THRESHHOLD) {
-            readyPriorityList->Remove(thread);
-            ReadyToRun(thread);
-        }
-    } 
+//----------------------------------------------------------------------
+// Scheduler::Block
+// 	Called when the current thread is about to sleep waiting for
+//	something (not when it is finishing).
+//----------------------------------------------------------------------
+
+void
+Scheduler::Block(Thread *thread)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    kernel->currentCPU->readyQueue->Block(thread);
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
-//	If there are no ready threads, return NULL.
+//	If there are no ready threads, return NULL.  If there are
+//	none on this CPU's queue, try to steal one from another CPU.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -141,19 +332,47 @@ Scheduler::processMoving ()
 Thread *
 Scheduler::FindNextToRun ()
 {
+    Thread *thread;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
-    Thread * nextThread = NULL;
 
-    aging(readyPriorityList);
+    thread = kernel->currentCPU->readyQueue->PickNext();
+    if (thread == NULL && kernel->numCPUs > 1) {
+        thread = Steal();
+    }
+    return thread;
+}
 
-    if (!readySJFList->IsEmpty()) {
-        nextThread = readySJFList->RemoveFront();
-    } else if (!readyRRList->IsEmpty()) {
-        nextThread = readyRRList->RemoveFront();
-    } else if (!readyPriorityList->IsEmpty()) {
-        nextThread = readyPriorityList->RemoveFront();
+//----------------------------------------------------------------------
+// Scheduler::Steal
+// 	Take the thread that the CPU with the most ready threads would
+//	run next, and move it to the current CPU.  Return NULL if every
+//	run queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::Steal()
+{
+    CPU *busiest = NULL;
+    CPU *cpu;
+    Thread *thread;
+
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        cpu = kernel->cpus[i];
+        if (cpu->readyQueue->NumReady() > 0 && (busiest == NULL
+              || cpu->readyQueue->NumReady() > busiest->readyQueue->NumReady())) {
+            busiest = cpu;
+        }
+    }
+    if (busiest == NULL) {
+        return NULL;
     }
-    return nextThread;
+
+    thread = busiest->readyQueue->PickNext();
+    thread->setCPU(kernel->currentCPU->getID());
+    kernel->currentCPU->numSteals++;
+    DEBUG(dbgThread, "CPU " << kernel->currentCPU->getID() << " steals " << thread->getName() << " from CPU " << busiest->getID());
+    return thread;
 }
 
 //----------------------------------------------------------------------
@@ -183,27 +402,27 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
     if (finishing) {	// mark that we need to delete current thread
-        ASSERT(toBeDestroyed == NULL);
-        toBeDestroyed = oldThread;
+        Reap(oldThread);
     }
 
     if (oldThread->space != NULL) {	// if this thread is a user program,
-        oldThread->SaveUserState(); 	// save the user's CPU registers
-        oldThread->space->SaveState();
-    }
+        oldThread->space->SaveState();	// its registers stay in the CPU
+    }					// until someone else needs them
 
     oldThread->CheckOverflow();		    // check if the old thread
                                             // had an undetected stack overflow
 
-    // old thread burst time
-    double predicted = 0.5 * (kernel->stats->totalTicks - oldThread->getStartBurst() + oldThread->getBurstTime());
-    oldThread->setBurstTime(predicted);
-    // set up the individual start time of burst
-    nextThread->setStartBurstTime(kernel->stats->totalTicks);
+    kernel->currentCPU->readyQueue->Switch(oldThread, nextThread);
+    Departed(oldThread);
 
     kernel->currentThread = nextThread;  // switch to the next thread
+    kernel->currentCPU->currentThread = nextThread;
+    SetTimer(kernel->currentCPU);
+    nextThread->setCPU(kernel->currentCPU->getID());
     nextThread->setStatus(RUNNING);      // nextThread is now running
-    cout << "Thread " << kernel->currentThread->getID() << "\tProcessRunning\t" << kernel->stats->totalTicks << endl;
+    kernel->trace->Record(TraceRunning, nextThread->getID(),
+                          kernel->currentCPU->getID());
+    Dispatched(nextThread);
 
     DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
 
@@ -212,7 +431,10 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     // a bit to figure out what happens after this, both from the point
     // of view of the thread and from the perspective of the "outside world".
 
-    SWITCH(oldThread, nextThread);
+    {
+        HostPhase phase(HostSwitch);
+        SWITCH(oldThread, nextThread);
+    }
 
     // we're back, running oldThread
 
@@ -226,26 +448,59 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     // and needs to be cleaned up
 
     if (oldThread->space != NULL) {	    // if there is an address space
-        oldThread->RestoreUserState();     // to restore, do it.
+        kernel->currentCPU->LoadUserState(oldThread);  // to restore, do it.
         oldThread->space->RestoreState();
     }
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Reap
+// 	Put a finishing thread on the list of threads to be destroyed.
+//	Note we cannot delete the thread now (for example, in
+//	Thread::Finish()), because we are still running on its stack!
+//
+//	"thread" is the thread that is finishing.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Reap(Thread *thread)
+{
+    thread->reapNext = toBeDestroyed;
+    toBeDestroyed = thread;
+    numToBeDestroyed++;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Destroy
+// 	Delete up to "howMany" of the threads that have finished.  Their
+//	objects and stacks go back to the pools in Thread, for the next
+//	threads to be forked.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Destroy(int howMany)
+{
+    while (toBeDestroyed != NULL && howMany-- > 0) {
+        Thread *thread = toBeDestroyed;
+
+        toBeDestroyed = thread->reapNext;
+        numToBeDestroyed--;
+        delete thread;
+    }
+}
+
 //----------------------------------------------------------------------
 // Scheduler::CheckToBeDestroyed
-// 	If the old thread gave up the processor because it was finishing,
-// 	we need to delete its carcass.  Note we cannot delete the thread
-// 	before now (for example, in Thread::Finish()), because up to this
-// 	point, we were still running on the old thread's stack!
+// 	Called by a thread as soon as it gets the processor, when no
+//	finished thread can still be on its stack.  Delete a few of
+//	them, so that a burst of threads finishing doesn't hold up
+//	whoever runs next; the idle loop gets the rest.
 //----------------------------------------------------------------------
 
 void
 Scheduler::CheckToBeDestroyed()
 {
-    if (toBeDestroyed != NULL) {
-        delete toBeDestroyed;
-        toBeDestroyed = NULL;
-    }
+    Destroy(DestroyBatch);
 }
 
 //----------------------------------------------------------------------
@@ -257,7 +512,194 @@ void
 Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyPriorityList->Apply(ThreadPrint);
-    cout << endl;
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        if (kernel->numCPUs > 1) {
+            cout << "CPU " << i << ": ";
+        }
+        kernel->cpus[i]->readyQueue->Print();
+        cout << endl;
+    }
 }
 
+
+
+//----------------------------------------------------------------------
+// Scheduler::IdleCPU
+// 	Called when the current thread is giving up its CPU and there
+//	is nothing for the CPU to run.  On a multiprocessor, if another
+//	CPU has work to do, leave this one idle and go on simulating
+//	that one.
+//
+//	Returns FALSE at once if no other CPU can run, so the caller
+//	should wait for an interrupt.  Otherwise returns TRUE, once
+//	the current thread has been made ready and picked up again
+//	by some CPU -- unless it was finishing, in which case this
+//	never returns.
+//
+//	"finishing" is set if the current thread is to be deleted
+//		once we're no longer running on its stack
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IdleCPU(bool finishing)
+{
+    Thread *oldThread = kernel->currentThread;
+    CPU *cpu = kernel->currentCPU;
+    CPU *next;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    Destroy(numToBeDestroyed);		// nothing better to do
+    if (tickless) {			// nothing to slice; Idle can go
+        cpu->alarm->Stop();		// straight to the next event
+    }
+    if (kernel->numCPUs == 1) {
+        return FALSE;
+    }
+    cpu->currentThread = NULL;		// this CPU is idle now
+    next = NextCPU();
+    if (next == NULL) {			// so is everyone else
+        cpu->currentThread = oldThread;
+        return FALSE;
+    }
+
+    if (finishing) {
+        Reap(oldThread);
+    } else if (oldThread->space != NULL) {
+        oldThread->space->SaveState();
+    }
+    oldThread->CheckOverflow();
+    cpu->readyQueue->Switch(oldThread, NULL);
+    Departed(oldThread);
+
+    SwitchCPU(next);
+
+    // we're back, running oldThread on whichever CPU picked it up
+    ASSERT(kernel->currentThread == oldThread);
+    if (oldThread->space != NULL) {
+        kernel->currentCPU->LoadUserState(oldThread);
+        oldThread->space->RestoreState();
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Balance
+// 	Called after every tick on a multiprocessor, to keep the CPUs
+//	in step: go on simulating the CPU NextCPU picks.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Balance()
+{
+    CPU *next = NextCPU();
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    if (next != NULL && next != kernel->currentCPU) {
+        SwitchCPU(next);
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NextCPU
+// 	Return the CPU to simulate next.  An idle CPU comes first if
+//	there is a ready thread anywhere, so that it can steal it;
+//	otherwise, the busy CPU with the earliest clock, staying on the
+//	current CPU if it is one of them.  Return NULL if every CPU is
+//	idle and there is nothing to steal.
+//----------------------------------------------------------------------
+
+CPU *
+Scheduler::NextCPU()
+{
+    bool anyReady = FALSE;
+    CPU *best = NULL;
+    int bestClock = 0;
+
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        if (kernel->cpus[i]->readyQueue->NumReady() > 0) {
+            anyReady = TRUE;
+        }
+    }
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        CPU *cpu = kernel->cpus[i];
+        int clock;
+
+        if (cpu->IsIdle()) {
+            if (anyReady) {
+                return cpu;
+            }
+            continue;
+        }
+        clock = (cpu == kernel->currentCPU) ? kernel->stats->totalTicks
+                                            : cpu->clock;
+        if (best == NULL || clock < bestClock
+              || (clock == bestClock && cpu == kernel->currentCPU)) {
+            best = cpu;
+            bestClock = clock;
+        }
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchCPU
+// 	Stop simulating the current CPU and start simulating "to".
+//	The state of the current CPU is saved, and its thread (if it
+//	still has one) stays RUNNING, parked here until this CPU is
+//	switched back to.
+//
+//	If "to" is idle, it is given a thread first -- the next on its
+//	own queue, or one stolen from another -- and its clock starts
+//	from now.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCPU(CPU *to)
+{
+    CPU *from = kernel->currentCPU;
+    Thread *oldThread = kernel->currentThread;
+    Thread *nextThread;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(to != from);
+
+    from->SaveState();
+    if (to->IsIdle()) {
+        to->clock = from->clock;
+    }
+    kernel->currentCPU = to;
+    to->RestoreState();
+
+    if (to->IsIdle()) {			// wake it up with something to do
+        nextThread = FindNextToRun();
+        ASSERT(nextThread != NULL);
+        kernel->interrupt->setStatus(SystemMode);
+        to->readyQueue->Switch(NULL, nextThread);
+        to->currentThread = nextThread;
+        SetTimer(to);
+        nextThread->setCPU(to->getID());
+        nextThread->setStatus(RUNNING);
+        kernel->trace->Record(TraceRunning, nextThread->getID(), to->getID());
+        Dispatched(nextThread);
+    } else if (tickless && !to->alarm->IsSlicing()
+                && to->readyQueue->NumReady() > 0) {
+        SetTimer(to);			// someone queued up meanwhile
+    }
+    nextThread = to->currentThread;
+    ASSERT(nextThread != oldThread);
+    kernel->currentThread = nextThread;
+
+    DEBUG(dbgThread, "Switching from CPU " << from->getID() << " to CPU " << to->getID());
+
+    {
+        HostPhase phase(HostSwitch);
+        SWITCH(oldThread, nextThread);
+    }
+
+    // we're back, running oldThread
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+
+    CheckToBeDestroyed();
+}
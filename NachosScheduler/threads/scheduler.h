@@ -12,19 +12,39 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "schedpolicy.h"
+
+class CPU;
+
+extern int AffinityTicks;	// how long a CPU's TLB is thought to
+				// stay warm for a thread (1000)
+extern int MigrationTicks;	// what leaving a warm TLB costs (250)
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
-
-#define AGING_TICKS         1500
-#define PRIORITY_AGING      10
-#define PRI_SCHD_THRESHHOLD 60
-#define SJF_SCHD_THRESHHOLD 100
+// Which ready thread to run next is up to the SchedulerPolicy.
+//
+// Each CPU has its own run queue (see cpu.h).  A thread goes back on
+// the queue of the CPU it last ran on; a CPU whose queue is empty
+// steals from the longest queue.
+//
+// A thread that wakes up, or is new, is placed where it will wait the
+// least -- unless it ran lately on another CPU, whose TLB still holds
+// its translations.  Going elsewhere would cost it refilling them:
+// up to MigrationTicks, for a thread that has only just stopped,
+// down to nothing once it has been off the CPU for AffinityTicks.
+// It stays on its old CPU unless that CPU's queue is longer, in
+// ticks of waiting, by more than that cost.
 
 class Scheduler {
   public:
-    Scheduler();		// Initialize list of ready threads 
+    Scheduler(bool preemptive, bool dynamicTicks);
+				// Initialize list of ready threads;
+				// if preemptive, a thread made ready
+				// may take the CPU at once; with
+				// dynamicTicks, the timer only runs
+				// when there's someone to switch to
     ~Scheduler();		// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	
@@ -34,24 +54,49 @@ class Scheduler {
 				// list, if any, and return thread.
     void Run(Thread* nextThread, bool finishing);
     				// Cause nextThread to start running
-    void CheckToBeDestroyed();  // Check if thread that had been
-    				// running needs to be deleted
+    void CheckToBeDestroyed();  // Delete a few of the threads that
+    				// have finished running
+    void PriorityChanged(Thread* thread, int oldPriority);
+    				// Let the policy move a ready thread
+				// whose priority changed
+    bool Tick();		// Timer interrupt; TRUE if the running
+				// thread should be preempted
+    void SetTimer(CPU *cpu);	// program cpu's timer for the end of
+				// its running thread's time slice
+    void Block(Thread* thread);	// Thread is about to wait
+    bool IdleCPU(bool finishing);	// Leave the current CPU idle, and
+				// go on simulating another one
+    void Balance();		// Go on simulating whichever CPU
+				// should run next
     void Print();		// Print contents of ready list
     
     // SelfTest for scheduler is implemented in class Thread
     
   private:
-    List<Thread *> *readyRRList;  // queue of threads that are ready to run,
-				// but not running
-    List<Thread *> *readyPriorityList;
-
-    List<Thread *> *readySJFList;
+    bool preempt;		// ask the policy about preempting
+				// whenever a thread is made ready
+    bool tickless;		// stop the timer when it isn't needed
+    Thread *toBeDestroyed;	// finished threads, to be destroyed
+    				// once nobody is using their stacks
+    int numToBeDestroyed;
 
-    Thread *toBeDestroyed;	// finishing thread to be destroyed
-    				// by the next thread that runs
-    void aging(List<Thread *>* list);
+    void Reap(Thread *thread);	// thread has finished with its stack
+    void Destroy(int howMany);	// delete up to howMany finished threads
 
-    void processMoving();
+    CPU *CPUOf(Thread *thread);	// whose run queue thread belongs on
+    CPU *Place(Thread *thread);	// whose run queue a waking thread
+				// should go on
+    int Load(CPU *cpu, Thread *thread);
+				// how long thread would wait there
+    Thread *Steal();		// take a thread from the longest queue
+    CPU *NextCPU();		// CPU to simulate next, or NULL
+    void SwitchCPU(CPU *to);	// simulate "to" instead of the
+				// current CPU
+    void Dispatched(Thread *thread);	// thread got a CPU; update its
+					// waiting time statistics
+    void Departed(Thread *thread);	// thread is leaving the current
+					// CPU; note where it ran, and
+					// the TLB misses it took there
 };
 
 #endif // SCHEDULER_H
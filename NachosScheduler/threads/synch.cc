@@ -16,17 +16,15 @@
 // re-set the interrupt state back to its original value (whether
 // that be disabled or enabled).
 //
-// Once we'e implemented one set of higher level atomic operations,
-// we can implement others using that implementation.  We illustrate
-// this by implementing locks and condition variables on top of 
-// semaphores, instead of directly enabling and disabling interrupts.
+// Locks, condition variables and reader-writer locks all keep their
+// own queues of waiting threads, the way semaphores do, rather than
+// being built on semaphores: a lock's holder can then be lent its
+// waiters' priorities (see Thread::Inherit), and waiting on a
+// condition needn't allocate a semaphore each time.  Making sure a
+// waiter doesn't miss a signal is explained under Condition::Wait.
 //
-// Locks are implemented using a semaphore to keep track of
-// whether the lock is held or not -- a semaphore value of 0 means
-// the lock is busy; a semaphore value of 1 means the lock is free.
-//
-// The implementation of condition variables using semaphores is
-// a bit trickier, as explained below under Condition::Wait.
+// With "-lp", each of them also keeps a SynchProfile of how long
+// threads wait for it (see synchprofile.h).
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -36,6 +34,30 @@
 #include "synch.h"
 #include "main.h"
 
+//----------------------------------------------------------------------
+// RemoveHighest
+// 	Take the highest priority thread off a queue of waiting threads,
+//	the one that has waited longest if several share that priority.
+//	Priorities can change while threads wait, so the queue is kept
+//	in arrival order and searched; taking the one found off it is
+//	constant time, since the queue is linked through the threads.
+//----------------------------------------------------------------------
+
+static Thread *
+RemoveHighest(WaitQueue *queue)
+{
+    Thread *highest = queue->Front();
+
+    for (Thread *t = WaitQueue::Next(highest); t != NULL;
+         t = WaitQueue::Next(t)) {
+        if (t->getPriority() > highest->getPriority()) {
+            highest = t;
+        }
+    }
+    queue->Remove(highest);
+    return highest;
+}
+
 //----------------------------------------------------------------------
 // Semaphore::Semaphore
 // 	Initialize a semaphore, so that it can be used for synchronization.
@@ -48,7 +70,12 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
+    queue = new WaitQueue;
+    profile = NULL;
+    if (kernel->synchProfiler != NULL) {
+        profile = kernel->synchProfiler->Register("Semaphore", name,
+                                                  queue, FALSE);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -59,6 +86,9 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 
 Semaphore::~Semaphore()
 {
+    if (profile != NULL) {
+        profile->Gone();
+    }
     delete queue;
 }
 
@@ -80,12 +110,18 @@ Semaphore::P()
     
     // disable interrupts
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	
+    int since = kernel->stats->totalTicks;
+    bool waited = FALSE;
     
     while (value == 0) { 		// semaphore not available
 	queue->Append(currentThread);	// so go to sleep
 	currentThread->Sleep(FALSE);
+	waited = TRUE;
     } 
     value--; 			// semaphore available, consume its value
+    if (profile != NULL) {
+        profile->Acquired(since, waited);
+    }
    
     // re-enable interrupts
     (void) interrupt->SetLevel(oldLevel);	
@@ -108,7 +144,7 @@ Semaphore::V()
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	
     
     if (!queue->IsEmpty()) {  // make thread ready.
-	kernel->scheduler->ReadyToRun(queue->RemoveFront());
+	kernel->scheduler->ReadyToRun(RemoveHighest(queue));
     }
     value++;
     
@@ -158,8 +194,14 @@ Semaphore::SelfTest()
 Lock::Lock(char* debugName)
 {
     name = debugName;
-    semaphore = new Semaphore("lock", 1);  // initially, unlocked
+    queue = new WaitQueue;
     lockHolder = NULL;
+    nextHeld = NULL;
+    profile = NULL;
+    if (kernel->synchProfiler != NULL) {
+        profile = kernel->synchProfiler->Register("Lock", name, queue,
+                                                  TRUE);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -168,28 +210,49 @@ Lock::Lock(char* debugName)
 //----------------------------------------------------------------------
 Lock::~Lock()
 {
-    delete semaphore;
+    ASSERT(queue->IsEmpty());
+    if (profile != NULL) {
+        profile->Gone();
+    }
+    delete queue;
 }
 
 //----------------------------------------------------------------------
 // Lock::Acquire
 //	Atomically wait until the lock is free, then set it to busy.
-//	Equivalent to Semaphore::P(), with the semaphore value of 0
-//	equal to busy, and semaphore value of 1 equal to free.
+//	While waiting, the holder runs at our priority if it's lower.
 //----------------------------------------------------------------------
 
 void Lock::Acquire()
 {
-    semaphore->P();
-    lockHolder = kernel->currentThread;
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int since = kernel->stats->totalTicks;
+    bool waited = FALSE;
+
+    while (lockHolder != NULL) {	// lock busy, so go to sleep
+        currentThread->setWaitingFor(this);
+        lockHolder->Inherit(currentThread->getPriority());
+        queue->Append(currentThread);
+        currentThread->Sleep(FALSE);
+        waited = TRUE;
+    }
+    currentThread->setWaitingFor(NULL);
+    lockHolder = currentThread;
+    currentThread->LockAcquired(this);
+    if (profile != NULL) {
+        profile->Acquired(since, waited);
+    }
+
+    (void) interrupt->SetLevel(oldLevel);
 }
 
 //----------------------------------------------------------------------
 // Lock::Release
-//	Atomically set lock to be free, waking up a thread waiting
-//	for the lock, if any.
-//	Equivalent to Semaphore::V(), with the semaphore value of 0
-//	equal to busy, and semaphore value of 1 equal to free.
+//	Atomically set lock to be free, waking up the highest priority
+//	thread waiting for the lock, if any.  We give back any priority
+//	its waiters lent us.
 //
 //	By convention, only the thread that acquired the lock
 // 	may release it.
@@ -197,9 +260,74 @@ void Lock::Acquire()
 
 void Lock::Release()
 {
+    Interrupt *interrupt = kernel->interrupt;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
     ASSERT(IsHeldByCurrentThread());
+    if (profile != NULL) {
+        profile->Released();
+    }
     lockHolder = NULL;
-    semaphore->V();
+    kernel->currentThread->LockReleased(this);
+    if (!queue->IsEmpty()) {
+        kernel->scheduler->ReadyToRun(RemoveHighest(queue));
+    }
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Lock::AddWaiter
+// 	Put "thread", which is asleep, on the queue of threads waiting
+//	for the lock, as though it had called Acquire.  When it is woken
+//	up, it must call Acquire itself.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void Lock::AddWaiter(Thread *thread)
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(thread->getStatus() == BLOCKED && lockHolder != NULL);
+    thread->setWaitingFor(this);
+    lockHolder->Inherit(thread->getPriority());
+    queue->Append(thread);
+}
+
+//----------------------------------------------------------------------
+// Lock::AddWaiters
+// 	Move every thread on "threads", all asleep, onto the queue of
+//	threads waiting for the lock, as AddWaiter does one.  They keep
+//	their order, and the queue is moved in one go.
+//----------------------------------------------------------------------
+
+void Lock::AddWaiters(WaitQueue *threads)
+{
+    int priority = -1;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    ASSERT(lockHolder != NULL);
+    for (Thread *t = threads->Front(); t != NULL; t = WaitQueue::Next(t)) {
+        ASSERT(t->getStatus() == BLOCKED);
+        t->setWaitingFor(this);
+        priority = max(priority, t->getPriority());
+    }
+    lockHolder->Inherit(priority);
+    queue->Splice(threads);
+}
+
+//----------------------------------------------------------------------
+// Lock::WaiterPriority
+// 	Return the priority of the highest priority thread waiting for
+//	the lock, or -1 if nobody is waiting.
+//----------------------------------------------------------------------
+
+int Lock::WaiterPriority()
+{
+    int priority = -1;
+
+    for (Thread *t = queue->Front(); t != NULL; t = WaitQueue::Next(t)) {
+        priority = max(priority, t->getPriority());
+    }
+    return priority;
 }
 
 //----------------------------------------------------------------------
@@ -213,7 +341,12 @@ void Lock::Release()
 Condition::Condition(char* debugName)
 {
     name = debugName;
-    waitQueue = new List<Semaphore *>;
+    waitQueue = new WaitQueue;
+    profile = NULL;
+    if (kernel->synchProfiler != NULL) {
+        profile = kernel->synchProfiler->Register("Condition", name,
+                                                  waitQueue, FALSE);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -223,17 +356,24 @@ Condition::Condition(char* debugName)
 
 Condition::~Condition()
 {
+    ASSERT(waitQueue->IsEmpty());
+    if (profile != NULL) {
+        profile->Gone();
+    }
     delete waitQueue;
 }
 
 //----------------------------------------------------------------------
 // Condition::Wait
 // 	Atomically release monitor lock and go to sleep.
-//	Our implementation uses semaphores to implement this, by
-//	allocating a semaphore for each waiting thread.  The signaller
-//	will V() this semaphore, so there is no chance the waiter
-//	will miss the signal, even though the lock is released before
-//	calling P().
+//	The waiting thread goes on waitQueue itself; interrupts stay
+//	off from then until we are asleep, so there is no chance the
+//	waiter will miss the signal, even though the lock is released
+//	before we sleep.
+//
+//	By the time we are woken, the signaller has moved us onto the
+//	lock's queue (see Signal), so the lock is most likely ours to
+//	take straight away.
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	waiter must re-acquire the monitor lock when waking up.
@@ -243,21 +383,34 @@ Condition::~Condition()
 
 void Condition::Wait(Lock* conditionLock) 
 {
-     Semaphore *waiter;
-    
-     ASSERT(conditionLock->IsHeldByCurrentThread());
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+
+    int since = kernel->stats->totalTicks;
+
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    waitQueue->Append(currentThread);
+    conditionLock->Release();
+    currentThread->Sleep(FALSE);
+    (void) interrupt->SetLevel(oldLevel);
 
-     waiter = new Semaphore("condition", 0);
-     waitQueue->Append(waiter);
-     conditionLock->Release();
-     waiter->P();
-     conditionLock->Acquire();
-     delete waiter;
+    conditionLock->Acquire();
+    if (profile != NULL) {
+        profile->Acquired(since, TRUE);	// until we have the lock back
+    }
 }
 
 //----------------------------------------------------------------------
 // Condition::Signal
-// 	Wake up a thread waiting on this condition, if any.
+// 	Wake up a thread waiting on this condition, if any: the one
+//	with the highest priority, or that has waited longest among
+//	those with the same priority.
+//
+//	Since we hold the lock, the waiter couldn't get it if it ran
+//	now; so rather than making it ready, we move it onto the lock's
+//	queue, to be woken when we release the lock ("wait morphing").
 //
 //	Note: we assume Mesa-style semantics, which means that the
 //	signaller doesn't give up control immediately to the thread
@@ -272,26 +425,316 @@ void Condition::Wait(Lock* conditionLock)
 
 void Condition::Signal(Lock* conditionLock)
 {
-    Semaphore *waiter;
-    
     ASSERT(conditionLock->IsHeldByCurrentThread());
     
     if (!waitQueue->IsEmpty()) {
-        waiter = waitQueue->RemoveFront();
-	waiter->V();
+        IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+        conditionLock->AddWaiter(RemoveHighest(waitQueue));
+        (void) kernel->interrupt->SetLevel(oldLevel);
     }
 }
 
 //----------------------------------------------------------------------
 // Condition::Broadcast
-// 	Wake up all threads waiting on this condition, if any.
+// 	Wake up all threads waiting on this condition, if any.  They
+//	all move onto the lock's queue, so they get the lock one at a
+//	time, instead of all waking up to fight over it.  The lock takes
+//	the highest priority waiter first, so they are moved as they
+//	are, all at once, rather than one Signal at a time.
 //
 //	"conditionLock" -- lock protecting the use of this condition
 //----------------------------------------------------------------------
 
 void Condition::Broadcast(Lock* conditionLock) 
 {
-    while (!waitQueue->IsEmpty()) {
-        Signal(conditionLock);
+    ASSERT(conditionLock->IsHeldByCurrentThread());
+
+    if (!waitQueue->IsEmpty()) {
+        IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+
+        conditionLock->AddWaiters(waitQueue);
+        (void) kernel->interrupt->SetLevel(oldLevel);
+    }
+}
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock, so that it can be used for
+//	synchronization.  Initially, nobody holds it.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"lockMode" decides who goes first when both readers and
+//		writers are waiting; see synch.h.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName, RWLockMode lockMode)
+{
+    name = debugName;
+    mode = lockMode;
+    readers = 0;
+    writer = NULL;
+    readQueue = new WaitQueue;
+    writeQueue = new WaitQueue;
+    numReads = readersSum = maxReaders = readWaitTicks = 0;
+    numWrites = writeWaitTicks = maxWriteWait = 0;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	Deallocate a reader-writer lock.  Nobody may still be waiting.
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(readQueue->IsEmpty() && writeQueue->IsEmpty());
+    delete readQueue;
+    delete writeQueue;
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+// 	Wait until a reader may hold the lock, then hold it.  Unless
+//	readers have preference, a reader waits behind any waiting
+//	writer, as well as for the writer holding the lock.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireRead()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int since = kernel->stats->totalTicks;
+
+    if (writer != NULL
+          || (mode != RWReaderPreference && !writeQueue->IsEmpty())) {
+        readQueue->Append(currentThread);
+        currentThread->Sleep(FALSE);	// GrantReaders lets us in
+    } else {
+        readers++;
+        CountReader();
+    }
+    readWaitTicks += kernel->stats->totalTicks - since;
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+// 	Let go of the lock.  The last reader out hands it to the first
+//	waiting writer, if there is one.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseRead()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(readers > 0 && writer == NULL);
+    readers--;
+    if (readers == 0 && !writeQueue->IsEmpty()) {
+        GrantWriter();
+    }
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+// 	Wait until nobody holds the lock, then hold it alone.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireWrite()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    Thread *currentThread = kernel->currentThread;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int since = kernel->stats->totalTicks;
+    int waited;
+
+    if (writer != NULL || readers > 0) {
+        writeQueue->Append(currentThread);
+        currentThread->Sleep(FALSE);	// GrantWriter lets us in
+    } else {
+        writer = currentThread;
+    }
+    ASSERT(writer == currentThread);
+    waited = kernel->stats->totalTicks - since;
+    numWrites++;
+    writeWaitTicks += waited;
+    maxWriteWait = max(maxWriteWait, waited);
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+// 	Let go of the lock, handing it to the waiting readers or to the
+//	first waiting writer, depending on the mode.
+//
+//	By convention, only the writer holding the lock may release it.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseWrite()
+{
+    Interrupt *interrupt = kernel->interrupt;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(IsWriteHeldByCurrentThread());
+    writer = NULL;
+    if (mode == RWWriterPreference) {
+        if (!writeQueue->IsEmpty()) {
+            GrantWriter();
+        } else {
+            GrantReaders();
+        }
+    } else {				// a read phase, if anyone wants one
+        if (!readQueue->IsEmpty()) {
+            GrantReaders();
+        } else if (!writeQueue->IsEmpty()) {
+            GrantWriter();
+        }
+    }
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWLock::GrantReaders
+// 	Hand the lock to every waiting reader at once.
+//----------------------------------------------------------------------
+
+void
+RWLock::GrantReaders()
+{
+    while (!readQueue->IsEmpty()) {
+        Thread *thread = readQueue->RemoveFront();
+
+        readers++;
+        CountReader();
+        kernel->scheduler->ReadyToRun(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// RWLock::GrantWriter
+// 	Hand the lock to the writer that has waited longest.
+//----------------------------------------------------------------------
+
+void
+RWLock::GrantWriter()
+{
+    ASSERT(readers == 0 && writer == NULL);
+    writer = writeQueue->RemoveFront();
+    kernel->scheduler->ReadyToRun(writer);
+}
+
+//----------------------------------------------------------------------
+// RWLock::CountReader
+// 	Note that a reader was let in, and how many hold the lock now.
+//----------------------------------------------------------------------
+
+void
+RWLock::CountReader()
+{
+    numReads++;
+    readersSum += readers;
+    maxReaders = max(maxReaders, readers);
+}
+
+//----------------------------------------------------------------------
+// RWLock::Print
+// 	Print how many readers held the lock together, and how long
+//	readers and writers waited for it.
+//----------------------------------------------------------------------
+
+void
+RWLock::Print()
+{
+    static char *modeNames[] = { "reader preference",
+                                 "writer preference", "phase-fair" };
+
+    cout << "RWLock " << name << " (" << modeNames[mode] << "): "
+         << numReads << " reads";
+    if (numReads > 0) {
+        cout << " (" << (double) readersSum / numReads
+             << " readers on average, " << maxReaders << " at most;"
+             << " waited " << (double) readWaitTicks / numReads
+             << " ticks on average)";
+    }
+    cout << ", " << numWrites << " writes";
+    if (numWrites > 0) {
+        cout << " (waited " << (double) writeWaitTicks / numWrites
+             << " ticks on average, " << maxWriteWait << " at most)";
+    }
+    cout << "\n";
+}
+
+//----------------------------------------------------------------------
+// RWLock::SelfTest, RWLockReader, RWLockWriter
+// 	Test the reader-writer lock, with readers checking that nobody
+//	writes while they read, and writers incrementing a value that
+//	only they may touch.  Everyone yields inside and outside the
+//	lock, so the threads interleave.
+//----------------------------------------------------------------------
+
+static RWLock *rwTestLock;
+static Semaphore *rwTestDone;
+static int rwTestValue;
+const int RWTestRounds = 3;
+
+static void
+RWLockReader(int which)
+{
+    for (int i = 0; i < RWTestRounds; i++) {
+        rwTestLock->AcquireRead();
+        int value = rwTestValue;
+        kernel->currentThread->Yield();
+        ASSERT(value == rwTestValue);	// no writer got in
+        rwTestLock->ReleaseRead();
+        kernel->currentThread->Yield();
+    }
+    rwTestDone->V();
+}
+
+static void
+RWLockWriter(int which)
+{
+    for (int i = 0; i < RWTestRounds; i++) {
+        rwTestLock->AcquireWrite();
+        int value = rwTestValue;
+        kernel->currentThread->Yield();
+        rwTestValue = value + 1;	// lost if another writer got in
+        rwTestLock->ReleaseWrite();
+        kernel->currentThread->Yield();
+    }
+    rwTestDone->V();
+}
+
+void
+RWLock::SelfTest()
+{
+    const int numReaders = 3, numWriters = 2;
+
+    rwTestLock = this;
+    rwTestValue = 0;
+    rwTestDone = new Semaphore("rwlock test", 0);
+    for (int i = 0; i < numReaders; i++) {
+        Thread *t = new Thread("reader", 1);
+        t->Fork((VoidFunctionPtr) RWLockReader, (void *) i);
+    }
+    for (int i = 0; i < numWriters; i++) {
+        Thread *t = new Thread("writer", 1);
+        t->Fork((VoidFunctionPtr) RWLockWriter, (void *) i);
+    }
+    for (int i = 0; i < numReaders + numWriters; i++) {
+        rwTestDone->P();
     }
+    ASSERT(rwTestValue == numWriters * RWTestRounds);
+    ASSERT(readers == 0 && writer == NULL);
+    delete rwTestDone;
 }
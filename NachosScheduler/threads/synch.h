@@ -21,6 +21,7 @@
 #include "thread.h"
 #include "list.h"
 #include "main.h"
+#include "synchprofile.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -50,8 +51,9 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List<Thread *> *queue;     
+    WaitQueue *queue;     
 		  	// threads waiting in P() for the value to be > 0
+    SynchProfile *profile;	// contention, if profiling (-lp)
    };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -65,6 +67,14 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// To keep a low priority thread holding a lock from holding up a
+// higher priority one waiting for it, the holder inherits the
+// priority of the highest priority waiter (moving to that waiter's
+// ready queue tier if need be) until it releases the lock; and if the
+// holder is waiting for another lock in turn, so does that lock's
+// holder.  Waiters are woken in priority order; so are threads
+// waiting on a semaphore.
 
 class Lock {
   public:
@@ -79,13 +89,24 @@ class Lock {
     		return lockHolder == kernel->currentThread; }
     				// return true if the current thread 
 				// holds this lock.
+    Thread *getHolder() { return lockHolder; }
+    int WaiterPriority();	// priority of the highest priority
+				// waiter, or -1 if there are none
     
     // Note: SelfTest routine provided by SynchList
     
   private:
     char *name;			// debugging assist
     Thread *lockHolder;		// thread currently holding lock
-    Semaphore *semaphore;	// we use a semaphore to implement lock
+    WaitQueue *queue;	// threads waiting in Acquire()
+    Lock *nextHeld;		// next lock held by lockHolder
+    SynchProfile *profile;	// contention, if profiling (-lp)
+    friend class Thread;
+
+    void AddWaiter(Thread *thread);	// make a thread waiting on a
+					// condition wait for us instead
+    void AddWaiters(WaitQueue *threads);	// or all of them
+    friend class Condition;
 };
 
 // The following class defines a "condition variable".  A condition
@@ -139,6 +160,78 @@ class Condition {
 
   private:
     char* name;
-    List<Semaphore *> *waitQueue;	// list of waiting threads
+    WaitQueue *waitQueue;	// list of waiting threads
+    SynchProfile *profile;	// time spent waiting, if profiling (-lp)
+};
+
+// The following class defines a "reader-writer lock".  Any number of
+// readers may hold the lock at once, or a single writer:
+//
+//	AcquireRead -- wait until no writer holds the lock, then hold it
+//		along with any other readers
+//
+//	AcquireWrite -- wait until nobody holds the lock, then hold it
+//		alone
+//
+//	ReleaseRead, ReleaseWrite -- let go of it, waking up whoever
+//		should have it next
+//
+// Who goes next when readers and writers are both waiting depends on
+// the lock's mode:
+//
+//	RWReaderPreference -- readers get in whenever no writer holds
+//		the lock, even past waiting writers; writers may starve
+//
+//	RWWriterPreference -- once a writer is waiting, new readers
+//		wait behind it, and a writer hands the lock on to the next
+//		writer before any reader; readers may starve
+//
+//	RWPhaseFair -- new readers wait behind a waiting writer, but
+//		when a writer lets go, every reader waiting lets in at once;
+//		read and write phases alternate, so nobody starves
+//
+// The lock is handed directly to the thread(s) woken up, so a thread
+// that has been woken holds the lock when it returns, and can't be
+// overtaken by another thread arriving meanwhile.
+
+enum RWLockMode { RWReaderPreference, RWWriterPreference, RWPhaseFair };
+
+class RWLock {
+  public:
+    RWLock(char* debugName, RWLockMode lockMode = RWPhaseFair);
+				// initialize lock to be free
+    ~RWLock();			// deallocate lock
+    char* getName() { return name; }	// debugging assist
+
+    void AcquireRead();		// hold the lock shared with other readers
+    void ReleaseRead();
+    void AcquireWrite();	// hold the lock alone
+    void ReleaseWrite();
+    bool IsWriteHeldByCurrentThread() {
+		return writer == kernel->currentThread; }
+
+    void Print();		// print reader concurrency and wait times
+    void SelfTest();		// test whether the lock is working
+
+  private:
+    char* name;
+    RWLockMode mode;
+    int readers;		// readers holding the lock
+    Thread *writer;		// writer holding it, or NULL
+    WaitQueue *readQueue;	// threads waiting in AcquireRead
+    WaitQueue *writeQueue;	// threads waiting in AcquireWrite
+
+    int numReads;		// times the lock was granted to a reader
+    int readersSum;		// sum, over those, of readers holding it
+    int maxReaders;		// most readers holding it at once
+    int readWaitTicks;		// total time readers waited
+    int numWrites;		// times the lock was granted to a writer
+    int writeWaitTicks;		// total time writers waited
+    int maxWriteWait;		// longest a writer waited
+
+    void GrantReaders();	// let in every waiting reader
+    void GrantWriter();		// let in the first waiting writer
+    void CountReader();		// a reader was let in
 };
+
 #endif // SYNCH_H
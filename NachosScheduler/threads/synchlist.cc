@@ -80,6 +80,68 @@ SynchList<T>::RemoveFront()
     return item;
 }
 
+//----------------------------------------------------------------------
+// WakeWaiters
+//	Wake up as many threads waiting on "condition" as there are
+//	new items (or new free slots) for them -- one Signal for one
+//	item, otherwise one Broadcast for the lot.
+//----------------------------------------------------------------------
+
+static void
+WakeWaiters(Condition *condition, Lock *lock, int howMany)
+{
+    if (howMany == 1) {
+        condition->Signal(lock);
+    } else if (howMany > 1) {
+        condition->Broadcast(lock);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchList<T>::AppendBatch
+//      Append "count" items to the end of the list, with one lock
+//	acquisition, and wake up whoever is waiting for them.
+//
+//	"items" is an array of the things to put on the list.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SynchList<T>::AppendBatch(T *items, int count)
+{
+    lock->Acquire();
+    for (int i = 0; i < count; i++) {
+        list->Append(items[i]);
+    }
+    WakeWaiters(listEmpty, lock, count);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchList<T>::RemoveBatch
+//      Remove up to "maxCount" items from the beginning of the list,
+//	with one lock acquisition.  Wait if the list is empty.
+// Returns:
+//	How many items were put in "items".
+//----------------------------------------------------------------------
+
+template <class T>
+int
+SynchList<T>::RemoveBatch(T *items, int maxCount)
+{
+    int count = 0;
+
+    ASSERT(maxCount > 0);
+    lock->Acquire();
+    while (list->IsEmpty())
+	listEmpty->Wait(lock);
+    while (count < maxCount && !list->IsEmpty()) {
+        items[count++] = list->RemoveFront();
+    }
+    lock->Release();
+    return count;
+}
+
 //----------------------------------------------------------------------
 // SynchList<T>::Apply
 //      Apply function to every item on a list.
@@ -128,3 +190,213 @@ SynchList<T>::SelfTest(T val)
     }
     delete selfTestPing;
 }
+
+//----------------------------------------------------------------------
+// SynchRing<T>::SynchRing
+//	Allocate and initialize a synchronized ring, empty to start with.
+//
+//	"ringSize" is the most items the ring can hold.
+//----------------------------------------------------------------------
+
+template <class T>
+SynchRing<T>::SynchRing(int ringSize)
+{
+    ASSERT(ringSize > 0);
+    ring = new T[ringSize];
+    size = ringSize;
+    first = 0;
+    numItems = 0;
+    lock = new Lock("ring lock");
+    ringEmpty = new Condition("ring empty cond");
+    ringFull = new Condition("ring full cond");
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::~SynchRing
+//	De-allocate the ring.
+//----------------------------------------------------------------------
+
+template <class T>
+SynchRing<T>::~SynchRing()
+{
+    delete ringFull;
+    delete ringEmpty;
+    delete lock;
+    delete [] ring;
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::Put
+//	Copy as many of "count" items into the ring as fit.  The lock
+//	must be held.  Return how many were copied.
+//----------------------------------------------------------------------
+
+template <class T>
+int
+SynchRing<T>::Put(T *items, int count)
+{
+    int n = min(count, size - numItems);
+
+    for (int i = 0; i < n; i++) {
+        ring[(first + numItems) % size] = items[i];
+        numItems++;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::Take
+//	Copy up to "maxCount" items out of the ring, oldest first.  The
+//	lock must be held.  Return how many were copied.
+//----------------------------------------------------------------------
+
+template <class T>
+int
+SynchRing<T>::Take(T *items, int maxCount)
+{
+    int n = min(maxCount, numItems);
+
+    for (int i = 0; i < n; i++) {
+        items[i] = ring[first];
+        first = (first + 1) % size;
+        numItems--;
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::AppendBatch
+//	Append "count" items to the ring, waiting for room whenever it
+//	is full.  Consumers are woken once for each time we had to wait,
+//	rather than once per item.
+//
+//	"items" is an array of the things to put in the ring.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SynchRing<T>::AppendBatch(T *items, int count)
+{
+    int done = 0;
+
+    lock->Acquire();
+    while (done < count) {
+        int n;
+
+	while (numItems == size)
+	    ringFull->Wait(lock);	// wait until there is room
+        n = Put(items + done, count - done);
+        done += n;
+        WakeWaiters(ringEmpty, lock, n);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::RemoveBatch
+//	Remove up to "maxCount" items from the ring, waiting if it is
+//	empty, and wake up producers waiting for the room.
+// Returns:
+//	How many items were put in "items".
+//----------------------------------------------------------------------
+
+template <class T>
+int
+SynchRing<T>::RemoveBatch(T *items, int maxCount)
+{
+    int n;
+
+    ASSERT(maxCount > 0);
+    lock->Acquire();
+    while (numItems == 0)
+	ringEmpty->Wait(lock);		// wait until ring isn't empty
+    n = Take(items, maxCount);
+    WakeWaiters(ringFull, lock, n);
+    lock->Release();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::Append
+//	Append an "item" to the ring, waiting if it is full.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SynchRing<T>::Append(T item)
+{
+    AppendBatch(&item, 1);
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::RemoveFront
+//	Remove the oldest item from the ring, waiting if it is empty.
+// Returns:
+//	The removed item.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+SynchRing<T>::RemoveFront()
+{
+    T item;
+
+    (void) RemoveBatch(&item, 1);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// SynchRing<T>::SelfTest, SelfTestHelper
+//	Test whether the SynchRing implementation is working, by having
+//	two threads ping-pong values between them using two rings.  The
+//	rings are small, so batches wrap around and fill them up.
+//----------------------------------------------------------------------
+
+const int RingTestRounds = 10;
+const int RingTestItems = 3 * RingTestRounds / 2;	// items echoed
+
+template <class T>
+void
+SynchRing<T>::SelfTestHelper (void* data)
+{
+    SynchRing<T>* _this = (SynchRing<T>*)data;
+    T items[2];
+
+    for (int echoed = 0; echoed < RingTestItems; ) {
+        int n = _this->selfTestPing->RemoveBatch(items, 2);
+
+        _this->AppendBatch(items, n);
+        echoed += n;
+    }
+}
+
+template <class T>
+void
+SynchRing<T>::SelfTest(T val)
+{
+    Thread *helper = new Thread("ping", 1);
+    T items[2];
+
+    ASSERT(numItems == 0 && size >= 2);
+    selfTestPing = new SynchRing<T>(3);
+    helper->Fork(SynchRing<T>::SelfTestHelper, this);
+    for (int i = 0; i < RingTestRounds; i++) {
+        if (i % 2 == 0) {
+            items[0] = items[1] = val;
+            selfTestPing->AppendBatch(items, 2);
+            for (int got = 0; got < 2; ) {
+                int n = this->RemoveBatch(items, 2 - got);
+
+                for (int j = 0; j < n; j++) {
+                    ASSERT(val == items[j]);
+                }
+                got += n;
+            }
+        } else {
+            selfTestPing->Append(val);
+            ASSERT(val == this->RemoveFront());
+        }
+    }
+    ASSERT(numItems == 0);
+    delete selfTestPing;
+}
@@ -19,6 +19,9 @@
 //	1. Threads trying to remove an item from a list will
 //	wait until the list has an element on it.
 //	2. One thread at a time can access list data structures
+//
+// AppendBatch and RemoveBatch move many items for one lock acquisition
+// and one wakeup.
 
 template <class T>
 class SynchList {
@@ -32,6 +35,13 @@ class SynchList {
     T RemoveFront();		// remove the first item from the front of
 				// the list, waiting if the list is empty
 
+    void AppendBatch(T *items, int count);
+				// append "count" items at once
+    int RemoveBatch(T *items, int maxCount);
+				// remove up to "maxCount" items, waiting
+				// until there is at least one; return
+				// how many were removed
+
     void Apply(void (*f)(T)); // apply function to all elements in list
 
     void SelfTest(T value);	// test the SynchList implementation
@@ -46,6 +56,55 @@ class SynchList {
     static void SelfTestHelper(void* data);
 };
 
+// The following class defines a bounded "synchronized ring": the same
+// interface as SynchList, but the items are kept in a fixed-size
+// circular array rather than a list, so putting an item allocates
+// nothing, and a thread trying to append to a full ring waits until
+// there is room -- a producer can't get arbitrarily far ahead of the
+// consumers.
+
+template <class T>
+class SynchRing {
+  public:
+    SynchRing(int size);	// initialize a ring holding up to "size"
+				// items
+    ~SynchRing();		// de-allocate the ring
+
+    void Append(T item);	// append item, waiting if the ring is
+				// full
+    T RemoveFront();		// remove the first item, waiting if the
+				// ring is empty
+
+    void AppendBatch(T *items, int count);
+				// append "count" items, waiting for room
+				// as needed
+    int RemoveBatch(T *items, int maxCount);
+				// remove up to "maxCount" items, waiting
+				// until there is at least one; return
+				// how many were removed
+
+    int NumInRing() { return numItems; }
+    int Size() { return size; }
+
+    void SelfTest(T value);	// test the SynchRing implementation
+
+  private:
+    T *ring;			// the items, from ring[first] around
+    int size;			// how many items fit
+    int first;			// index of the oldest item
+    int numItems;		// how many items are in the ring
+    Lock *lock;			// enforce mutual exclusive access
+    Condition *ringEmpty;	// wait in Remove if the ring is empty
+    Condition *ringFull;	// wait in Append if the ring is full
+
+    int Put(T *items, int count);	// copy in what fits
+    int Take(T *items, int maxCount);	// copy out what's there
+
+    // these are only to assist SelfTest()
+    SynchRing<T> *selfTestPing;
+    static void SelfTestHelper(void* data);
+};
+
 #include "synchlist.cc"
 
 #endif // SYNCHLIST_H
@@ -0,0 +1,254 @@
+// synchprofile.cc
+//	Routines to record and report how semaphores, locks and
+//	condition variables are contended.  See synchprofile.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchprofile.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// SynchProfile::SynchProfile
+// 	Start an empty profile.
+//
+//	"objectKind" is what's being profiled, for the report.
+//	"debugName" is its name; we keep a copy.
+//	"waitQueue" is the queue threads wait on.
+//	"isOwned" is whether it has a holder, as a lock does.
+//----------------------------------------------------------------------
+
+SynchProfile::SynchProfile(char *objectKind, char *debugName,
+                           WaitQueue *waitQueue, bool isOwned)
+{
+    if (debugName == NULL) {
+        debugName = "(no name)";
+    }
+    kind = objectKind;
+    name = new char[strlen(debugName) + 1];
+    strcpy(name, debugName);
+    waiters = waitQueue;
+    owned = isOwned;
+    numAcquires = numContended = 0;
+    totalWait = maxWait = 0;
+    maxWaiterID = holderID = -1;
+    heldSince = 0;
+    numReleases = totalHold = maxHold = 0;
+}
+
+SynchProfile::~SynchProfile()
+{
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Acquired
+// 	Count a P, Acquire or Wait by the current thread that has just
+//	finished.
+//
+//	"since" is stats->totalTicks when it was called.
+//	"waited" is whether the thread had to sleep.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Acquired(int since, bool waited)
+{
+    int now = kernel->stats->totalTicks;
+
+    numAcquires++;
+    if (waited) {
+        numContended++;
+        totalWait += now - since;
+        if (now - since > maxWait || maxWaiterID == -1) {
+            maxWait = now - since;
+            maxWaiterID = kernel->currentThread->getID();
+        }
+    }
+    holderID = kernel->currentThread->getID();
+    heldSince = now;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Released
+// 	Count how long the lock was held, now that it is released.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Released()
+{
+    int held = kernel->stats->totalTicks - heldSince;
+
+    numReleases++;
+    totalHold += held;
+    maxHold = max(maxHold, held);
+    holderID = -1;
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Gone
+// 	The object is being deleted; keep what we know about it.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Gone()
+{
+    waiters = NULL;
+    if (owned) {
+        holderID = -1;
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchProfile::Print
+// 	Print the profile, on two lines.
+//----------------------------------------------------------------------
+
+void
+SynchProfile::Print()
+{
+    cout << kind << " " << name << (waiters == NULL ? " (deleted)" : "")
+         << ": " << numAcquires << " taken, " << numContended
+         << " contended, wait " << totalWait << " total, " << maxWait
+         << " max";
+    if (maxWaiterID != -1) {
+        cout << " (thread " << maxWaiterID << ")";
+    }
+    if (numReleases > 0) {
+        cout << ", hold " << totalHold << " total, " << maxHold << " max";
+    }
+    cout << "\n    " << (owned ? "held by " : "last taken by ");
+    if (holderID == -1) {
+        cout << "nobody";
+    } else {
+        cout << "thread " << holderID;
+    }
+    if (waiters != NULL && !waiters->IsEmpty()) {
+        cout << "; waiting:";
+        for (Thread *t = waiters->Front(); t != NULL;
+             t = WaitQueue::Next(t)) {
+            cout << " " << t->getID();
+        }
+    }
+    cout << "\n";
+}
+
+//----------------------------------------------------------------------
+// NumWaiting, TotalWait
+// 	Return how many threads are waiting on profiled objects now, and
+//	how many ticks they have spent waiting in all; the gauges
+//	registered for the profiler.
+//----------------------------------------------------------------------
+
+int
+SynchProfiler::NumWaiting(void *profiler)
+{
+    ListIterator<SynchProfile *> iter(((SynchProfiler *) profiler)->profiles);
+    int count = 0;
+
+    for (; !iter.IsDone(); iter.Next()) {
+        if (iter.Item()->waiters != NULL) {
+            count += iter.Item()->waiters->NumInList();
+        }
+    }
+    return count;
+}
+
+int
+SynchProfiler::TotalWait(void *profiler)
+{
+    ListIterator<SynchProfile *> iter(((SynchProfiler *) profiler)->profiles);
+    int total = 0;
+
+    for (; !iter.IsDone(); iter.Next()) {
+        total += iter.Item()->totalWait;
+    }
+    return total;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::SynchProfiler
+// 	Start with no profiles, and register the gauges for them.
+//----------------------------------------------------------------------
+
+SynchProfiler::SynchProfiler()
+{
+    profiles = new List<SynchProfile *>;
+    numProfiles = 0;
+    kernel->registry->AddGauge("synch.waiting", NumWaiting, (void *) this);
+    kernel->registry->AddGauge("synch.waitTicks", TotalWait, (void *) this);
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::~SynchProfiler
+// 	Delete the profiles.  Nothing may use them afterwards, so this
+//	is done after everything else at halt.
+//----------------------------------------------------------------------
+
+SynchProfiler::~SynchProfiler()
+{
+    while (!profiles->IsEmpty()) {
+        delete profiles->RemoveFront();
+    }
+    delete profiles;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Register
+// 	Return a new profile, for a semaphore, lock or condition being
+//	constructed.  See SynchProfile::SynchProfile for the arguments.
+//----------------------------------------------------------------------
+
+SynchProfile *
+SynchProfiler::Register(char *objectKind, char *debugName,
+                        WaitQueue *waitQueue, bool isOwned)
+{
+    SynchProfile *profile =
+        new SynchProfile(objectKind, debugName, waitQueue, isOwned);
+
+    profiles->Insert(profile);
+    numProfiles++;
+    return profile;
+}
+
+//----------------------------------------------------------------------
+// SynchProfiler::Print
+// 	Print every profile that was used, longest total wait first
+//	(most contended first among those that waited equally long).
+//----------------------------------------------------------------------
+
+void
+SynchProfiler::Print()
+{
+    SynchProfile **sorted = new SynchProfile *[numProfiles];
+    int numUsed = 0;
+
+    for (ListIterator<SynchProfile *> iter(profiles); !iter.IsDone();
+         iter.Next()) {
+        SynchProfile *p = iter.Item();
+        int i;
+
+        if (p->numAcquires == 0) {
+            continue;
+        }
+        for (i = numUsed; i > 0; i--) {		// insertion sort
+            SynchProfile *q = sorted[i - 1];
+
+            if (q->totalWait > p->totalWait ||
+                  (q->totalWait == p->totalWait &&
+                   q->numContended >= p->numContended)) {
+                break;
+            }
+            sorted[i] = q;
+        }
+        sorted[i] = p;
+        numUsed++;
+    }
+
+    cout << "Synchronization profile, longest total wait first:\n";
+    for (int i = 0; i < numUsed; i++) {
+        sorted[i]->Print();
+    }
+    delete [] sorted;
+}
@@ -0,0 +1,87 @@
+// synchprofile.h
+//	Data structures to find out which semaphores, locks and condition
+//	variables threads spend their time waiting for.
+//
+//	With "-lp", every one of them created from then on gets a
+//	SynchProfile, recording how often it was taken and how often
+//	that meant waiting, how long in total and at most (in
+//	kernel->stats->totalTicks), how long locks were held, and which
+//	threads had it and were waiting for it.  At halt the profiles
+//	are printed, the one waited for longest first.  A profile
+//	outlives its semaphore, lock or condition, so those deleted
+//	before halt are still reported.
+//
+//	Without "-lp", nothing is recorded.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHPROFILE_H
+#define SYNCHPROFILE_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+
+// The profile of one semaphore, lock or condition.
+
+class SynchProfile {
+  public:
+    SynchProfile(char *objectKind, char *debugName,
+                 WaitQueue *waitQueue, bool isOwned);
+    ~SynchProfile();
+
+    void Acquired(int since, bool waited);
+				// the current thread has finished P,
+				// Acquire or Wait, which it started at
+				// tick "since"
+    void Released();		// the current thread released a lock
+    void Gone();		// the object has been deleted
+
+    void Print();
+
+  private:
+    char *kind;			// "Semaphore", "Lock" or "Condition"
+    char *name;			// a copy of the object's debugName
+    WaitQueue *waiters;	// the object's queue, or NULL once
+				// it is deleted
+    bool owned;			// locks have a holder; for the others,
+				// report who took it last
+    int numAcquires;		// P, Acquire or Wait calls finished
+    int numContended;		// ... of which had to wait
+    int totalWait;		// ticks spent waiting
+    int maxWait;		// longest wait
+    int maxWaiterID;		// the thread that waited longest
+    int holderID;		// who holds it (or took it last), or -1
+    int heldSince;		// when the holder got it
+    int numReleases;		// releases, for locks
+    int totalHold;		// ticks locks were held
+    int maxHold;		// longest a lock was held
+    friend class SynchProfiler;
+};
+
+// All the profiles.
+
+class SynchProfiler {
+  public:
+    SynchProfiler();
+    ~SynchProfiler();		// delete the profiles
+
+    SynchProfile *Register(char *objectKind, char *debugName,
+                           WaitQueue *waitQueue, bool isOwned);
+				// a new profile, for an object being
+				// constructed
+    void Print();		// print the ones that were used,
+				// longest total wait first
+
+  private:
+    List<SynchProfile *> *profiles;
+    int numProfiles;
+
+    static int NumWaiting(void *profiler);
+    static int TotalWait(void *profiler);
+				// the gauges, for the registry
+};
+
+#endif // SYNCHPROFILE_H
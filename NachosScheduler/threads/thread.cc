@@ -37,37 +37,61 @@ Thread::Thread(char* threadName, int threadID)
 {
     ID = threadID;
     name = threadName;
-    pri = 75;
+    pri = basePri = 75;
     startBurstTime = kernel->stats->totalTicks;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
-    cout << "Thread " << ID << "\tProcessNew\t" << kernel->stats->totalTicks << endl;
+    schedStats = new ThreadStats(ID, name, kernel->stats->totalTicks);
+    kernel->trace->Record(TraceNew, ID);
     for (int i = 0; i < MachineStateSize; i++) {
         machineState[i] = NULL;		// not strictly necessary, since
                                         // new thread ignores contents 
                                         // of machine registers
     }
     space = NULL;
+    joinRecord = NULL;
+    profile = NULL;
+    betweenInstructions = FALSE;
+    readyLevel = -1;
+    agingDeadline = -1;
+    reapNext = NULL;
+    locksHeld = waitingFor = NULL;
+    burstTime = 0;
+    vruntime = 0;
+    level = levelTime = 0;
+    cpuID = -1;
 }
 
 Thread::Thread(char* threadName, int threadID, int priority)
 {
     ID = threadID;
     name = threadName;
-    pri = priority;
+    pri = basePri = priority;
     //startBurstTime = kernel->stats->totalTicks;
     startBurstTime = 0;
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
-    cout << "Thread " << ID << "\tProcessNew\t" << kernel->stats->totalTicks << endl;
+    schedStats = new ThreadStats(ID, name, kernel->stats->totalTicks);
+    kernel->trace->Record(TraceNew, ID);
     for (int i = 0; i < MachineStateSize; i++) {
         machineState[i] = NULL;		// not strictly necessary, since
                                         // new thread ignores contents 
                                         // of machine registers
     }
     space = NULL;
+    joinRecord = NULL;
+    profile = NULL;
+    betweenInstructions = FALSE;
+    readyLevel = -1;
+    agingDeadline = -1;
+    reapNext = NULL;
+    locksHeld = waitingFor = NULL;
+    burstTime = 0;
+    vruntime = 0;
+    level = levelTime = 0;
+    cpuID = -1;
 }
 
 //----------------------------------------------------------------------
@@ -86,24 +110,169 @@ Thread::~Thread()
 {
     DEBUG(dbgThread, "Deleting thread: " << name);
     ASSERT(this != kernel->currentThread);
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        if (kernel->cpus[i]->userThread == this) {
+            kernel->cpus[i]->userThread = NULL;	// registers are garbage
+        }
+    }
+    if (kernel->threads->Lookup(ID) == this) {
+        kernel->threads->Remove(ID);	// someone else can have the ID
+    }
     if (stack != NULL)
-        DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+        stackPool->Put((char *) stack);
+    delete space;			// and its page frames
+    delete schedStats;
 }
 
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+// 	Thread objects are carved out of slabs of ThreadsPerSlab, and a
+//	deleted one is reused by the next "new Thread".
+//----------------------------------------------------------------------
+
+ObjectPool *Thread::threadPool = NULL;
+StackPool *Thread::stackPool = NULL;
+
+void *
+Thread::operator new(size_t size)
+{
+    ASSERT(size == sizeof(Thread));
+    if (threadPool == NULL) {
+        threadPool = new ObjectPool(sizeof(Thread), ThreadsPerSlab);
+    }
+    return threadPool->Alloc();
+}
+
+void
+Thread::operator delete(void *thread)
+{
+    threadPool->Free(thread);
+}
+
+//----------------------------------------------------------------------
+// Thread::setPriority
+// 	Change the thread's priority.  If the thread is on a ready
+//	queue, the scheduler moves it to the queue for its new tier
+//	right away.  May be called with interrupts on or off.
+//
+//	While threads that the thread holds a lock for are waiting,
+//	it keeps running at the highest of their priorities, if that
+//	is higher than the one given here.
+//
+//	Returns FALSE, leaving the priority unchanged, if "priority" is
+//	out of range.
+//----------------------------------------------------------------------
+
 bool
 Thread::setPriority(int priority)
 {
-    if(priority >= 150 || priority < 0) return false;
+    if(priority >= NumPriorityLevels || priority < 0) return false;
+    IntStatus oldLevel = kernel->interrupt->SetLevel(IntOff);
+    basePri = priority;
+    ChangePriority(max(priority, InheritedPriority()));
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Thread::ChangePriority
+// 	Set the priority the scheduler goes by, and let it move the
+//	thread if it is ready.  If the thread is itself waiting for a
+//	lock, the holder of that lock inherits the new priority too.
+//	Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Thread::ChangePriority(int priority)
+{
+    int oldPriority = pri;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
     pri = priority;
     cout<< "Tick " << kernel->stats->totalTicks << " Thread " << ID << " changes its priority to " << pri << endl;
-    return true;
+    kernel->scheduler->PriorityChanged(this, oldPriority);
+    if (waitingFor != NULL && waitingFor->getHolder() != NULL) {
+        waitingFor->getHolder()->Inherit(pri);
+    }
+}
+
+//----------------------------------------------------------------------
+// Thread::Inherit
+// 	A thread with "priority" is waiting for a lock this thread
+//	holds; run at that priority, if it's higher, until the lock
+//	is released, so that threads in between can't hold up the
+//	waiter indefinitely.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Thread::Inherit(int priority)
+{
+    if (priority > pri) {
+        ChangePriority(priority);
+    }
+}
+
+//----------------------------------------------------------------------
+// Thread::InheritedPriority
+// 	Return the highest priority of any thread waiting for one of
+//	the locks this thread holds, or -1 if none are waited for.
+//----------------------------------------------------------------------
+
+int
+Thread::InheritedPriority()
+{
+    int priority = -1;
+
+    for (Lock *lock = locksHeld; lock != NULL; lock = lock->nextHeld) {
+        priority = max(priority, lock->WaiterPriority());
+    }
+    return priority;
+}
+
+//----------------------------------------------------------------------
+// Thread::LockAcquired
+// 	The thread now holds "lock".  Any threads still waiting for it
+//	lend it their priority.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Thread::LockAcquired(Lock *lock)
+{
+    lock->nextHeld = locksHeld;
+    locksHeld = lock;
+    Inherit(lock->WaiterPriority());
+}
+
+//----------------------------------------------------------------------
+// Thread::LockReleased
+// 	The thread has released "lock".  Drop back to the priority it
+//	would have without that lock's waiters.  Interrupts must be off.
+//----------------------------------------------------------------------
+
+void
+Thread::LockReleased(Lock *lock)
+{
+    Lock **link = &locksHeld;
+    int priority;
+
+    while (*link != lock) {
+        ASSERT(*link != NULL);
+        link = &(*link)->nextHeld;
+    }
+    *link = lock->nextHeld;
+    lock->nextHeld = NULL;
+
+    priority = max(basePri, InheritedPriority());
+    if (priority != pri) {
+        ChangePriority(priority);
+    }
 }
 
 void
 Thread::setBurstTime(double burst)
 {
     burstTime = burst;
-    cout << "Tick " << kernel->stats->totalTicks << " Thread " << kernel->currentThread->getID() << " change its burst time to " << burst << endl;  
+    cout << "Tick " << kernel->stats->totalTicks << " Thread " << ID << " change its burst time to " << burst << endl;  
 }
 
 //----------------------------------------------------------------------
@@ -185,6 +354,7 @@ Thread::Begin ()
 {
     ASSERT(this == kernel->currentThread);
     DEBUG(dbgThread, "Beginning thread: " << name);
+    hostActivity = HostKernel;		// it got here from SWITCH
 
     kernel->scheduler->CheckToBeDestroyed();
     kernel->interrupt->Enable();
@@ -212,7 +382,21 @@ Thread::Finish ()
     ASSERT(this == kernel->currentThread);
 
     DEBUG(dbgThread, "Finishing thread: " << name);
-    cout << "Thread " << kernel->currentThread->getID() << "\tProcessFinish\t" << kernel->stats->totalTicks << endl;
+    kernel->trace->Record(TraceFinish, ID);
+    kernel->predictor->ThreadDone(this);
+    if (profile != NULL) {
+        kernel->profiler->Finish(profile);	// written and deleted
+        profile = NULL;
+    }
+    schedStats->finished = kernel->stats->totalTicks;
+    if (space != NULL) {			// and how it used memory
+        space->Finished(schedStats);
+    }
+    kernel->stats->ThreadFinished(schedStats);
+    if (joinRecord != NULL) {			// wake whoever started us,
+        joinRecord->Exited();			// if it is joining us
+        joinRecord = NULL;
+    }
     Sleep(TRUE);				// invokes SWITCH
     // not reached
 }
@@ -266,7 +450,8 @@ Thread::Yield ()
 //	we have no thread to run.  "Interrupt::Idle" is called
 //	to signify that we should idle the CPU until the next I/O interrupt
 //	occurs (the only thing that could cause a thread to become
-//	ready to run).
+//	ready to run).  On a multiprocessor, this CPU is left idle
+//	instead, if any other CPU has work to do.
 //
 //	NOTE: we assume interrupts are already disabled, because it
 //	is called from the synchronization routines which must
@@ -283,12 +468,18 @@ Thread::Sleep (bool finishing)
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
     DEBUG(dbgThread, "Sleeping thread: " << name);
-    cout << "Thread " << kernel->currentThread->getID() << "\tProcessSleep\t" << kernel->stats->totalTicks << endl;
+    kernel->trace->Record(TraceSleep, ID);
 
+    if (!finishing) {
+        kernel->scheduler->Block(this);
+    }
     status = BLOCKED;
 
     //cout << "debug Thread::Sleep " << name << "wait for Idle\n";
     while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL) {
+        if (kernel->scheduler->IdleCPU(finishing)) {
+            return;		// another CPU has picked us up again
+        }
         kernel->interrupt->Idle();	// no one to run, wait for an interrupt
     }
     // returns when it's time for us to run
@@ -346,7 +537,10 @@ PLabelToAddr(void *plabel)
     void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    if (stackPool == NULL) {
+        stackPool = new StackPool(StackSize * sizeof(int), MaxFreeStacks);
+    }
+    stack = (int *) stackPool->Get();	// guard pages already set up
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
@@ -406,7 +600,8 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 
 //----------------------------------------------------------------------
 // Thread::SaveUserState
-//	Save the CPU state of a user program on a context switch.
+//	Save the CPU state of a user program, when another user program
+//	needs the CPU's registers (see CPU::LoadUserState).
 //
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
@@ -422,7 +617,8 @@ Thread::SaveUserState()
 
 //----------------------------------------------------------------------
 // Thread::RestoreUserState
-//	Restore the CPU state of a user program on a context switch.
+//	Restore the CPU state of a user program, when a context switch
+//	finds some other program's registers in the CPU.
 //
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
@@ -30,6 +30,9 @@
 //	We must first allocate a data structure for it: "t = new Thread".
 //	Only then can we do the fork: "t->fork(f, arg)".
 //
+//	Thread objects and their stacks are recycled (see pool.h), so
+//	creating and destroying threads by the thousand stays cheap.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -42,6 +45,11 @@
 #include "sysdep.h"
 #include "machine.h"
 #include "addrspace.h"
+#include "predictor.h"
+#include "stats.h"
+#include "pool.h"
+#include "profile.h"
+#include "dlist.h"
 
 // CPU register state to be saved on context switch.  
 // The x86 needs to save only a few registers, 
@@ -57,6 +65,13 @@
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 const int StackSize = (8 * 1024);	// in words
 
+const int ThreadsPerSlab = 64;		// Thread objects allocated at once
+const int MaxFreeStacks = 64;		// finished threads' stacks kept
+					// for new threads
+
+// Priorities run from 0 to NumPriorityLevels-1; see Thread::setPriority.
+const int NumPriorityLevels = 150;
+
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, ZOMBIE };
@@ -73,6 +88,8 @@ enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, ZOMBIE };
 //  Some threads also belong to a user address space; threads
 //  that only run in the kernel have a NULL address space.
 
+class Lock;
+
 class Thread {
     private:
         // NOTE: DO NOT CHANGE the order of these first two members.
@@ -87,6 +104,10 @@ class Thread {
         // NOTE -- thread being deleted
         // must not be running when delete 
         // is called
+        static void *operator new(size_t size);
+        static void operator delete(void *thread);
+        // Threads come from, and go back to,
+        // threadPool
 
         // basic thread operations
 
@@ -106,13 +127,29 @@ class Thread {
 
         int     getID() { return (ID); }
         int     getPriority() { return (pri); }
+        int     getBasePriority() { return (basePri); }
         int     getStartReadyTime() { return (startReadyTime); }
         int     getStartBurst() { return (startBurstTime); }
         double  getBurstTime() { return (burstTime); }
+        double  getVRuntime() { return (vruntime); }
+        int     getLevel() { return (level); }
+        int     getLevelTime() { return (levelTime); }
+        int     getCPU() { return (cpuID); }
+        BurstHistory *getBurstHistory() { return (&burstHistory); }
+        ThreadStats *getSchedStats() { return (schedStats); }
         bool setPriority(int priority);
+        void Inherit(int priority);	// a thread waiting for a lock we
+					// hold has this priority
+        void LockAcquired(Lock *lock);	// we now hold lock
+        void LockReleased(Lock *lock);	// we no longer do; give back
+					// what its waiters lent us
+        void setWaitingFor(Lock *lock) { waitingFor = lock; }
         void setStartReadyTime(int timeclocks) { startReadyTime = timeclocks; }
         void setBurstTime(double burst);
         void setStartBurstTime(int burstStart) { startBurstTime = burstStart; }
+        void setVRuntime(double v) { vruntime = v; }
+        void setLevel(int l, int when) { level = l; levelTime = when; }
+        void setCPU(int cpu) { cpuID = cpu; }
         void Print() { cout << name << "(" << pri << ")"; }
         void SelfTest();		// test whether thread impl is working
 
@@ -125,10 +162,27 @@ class Thread {
         ThreadStatus status;	// ready, running or blocked
         char*  name;
         int    ID;
-        int    pri;
+        int    pri;		// priority the scheduler goes by
+        int    basePri;		// priority given by setPriority; pri
+				// may be higher, lent by threads
+				// waiting for locks this one holds
+        Lock  *locksHeld;	// locks held, most recent first
+        Lock  *waitingFor;	// lock being waited for, or NULL
         int    startReadyTime;
         int    startBurstTime;
         double burstTime;
+        double vruntime;	// weighted CPU time, for CFSPolicy;
+				// the pass, for StridePolicy
+        int    level;		// feedback level, for MLFQPolicy
+        int    levelTime;	// when it was put at that level
+        int    cpuID;		// CPU whose run queue the thread is on,
+				// or that it last ran on; -1 if none
+        BurstHistory burstHistory;	// its past bursts, for the predictor
+        ThreadStats *schedStats;	// its waiting and response times
+        void ChangePriority(int priority);
+				// set pri, and tell the scheduler
+        int InheritedPriority();	// highest priority of a thread
+					// waiting for one of our locks
         void StackAllocate(VoidFunctionPtr func, void *arg);
         // Allocate a stack for thread.
         // Used internally by Fork()
@@ -137,7 +191,30 @@ class Thread {
         // one for its state while executing user code, one for its state 
         // while executing kernel code.
 
-        int userRegisters[NumTotalRegs];	// user-level CPU register state
+        int userRegisters[NumTotalRegs];	// user-level CPU register state,
+					// unless it was left in a CPU's
+					// register set (see cpu.h)
+        friend class CPU;
+        friend class CheckpointWriter;	// save and restore them
+        friend class CheckpointReader;
+
+        static ObjectPool *threadPool;	// recycled Thread objects
+        static StackPool *stackPool;	// recycled stacks, guard pages
+					// and all
+
+        // The RunQueue bucket the thread was filed under, -1 if none.
+        int    readyLevel;
+        friend class RunQueue;
+
+        // When the AgingWheel is to boost the thread; -1 if it isn't
+        // waiting for an aging boost.
+        int    agingDeadline;
+        friend class AgingWheel;
+
+        // Link used by the Scheduler while the thread, having
+        // finished, waits to be deleted.
+        Thread *reapNext;
+        friend class Scheduler;
 
     public:
 
@@ -148,13 +225,42 @@ class Thread {
             return t1->getBurstTime() > t2->getBurstTime() ? 1 : -1;
         }
 
+        // Total order, as RBTree needs: ties on vruntime go by ID.
+        static int compare_by_vruntime(Thread* t1, Thread* t2) {
+            if (t1->getVRuntime() != t2->getVRuntime())
+                return t1->getVRuntime() > t2->getVRuntime() ? 1 : -1;
+            if (t1->getID() != t2->getID())
+                return t1->getID() > t2->getID() ? 1 : -1;
+            return (t1 == t2) ? 0 : (t1 > t2 ? 1 : -1);
+        }
+
         void SaveUserState();		// save user-level register state
 
         void RestoreUserState();		// restore user-level register state
 
         AddrSpace *space;			// User code this thread is running.
+        JoinRecord *joinRecord;			// if its program was started by
+						// another, what it hands back
+						// to that one, or NULL
+        ProgramProfile *profile;		// what it has executed (-pp),
+						// or NULL
+        bool betweenInstructions;		// it was interrupted between
+						// two instructions of its
+						// program (see checkpoint.h)
+
+        // Links that put the thread on queues (see dlist.h), without
+        // allocating, and take it off from anywhere in them at once.
+        DLink<Thread> readyLink;		// on a ready queue
+        DLink<Thread> agingLink;		// on the AgingWheel
+        DLink<Thread> waitLink;			// waiting for a semaphore,
+						// lock or condition
 };
 
+// Queues of threads, linked through the Thread.
+typedef DList<Thread, &Thread::readyLink> ReadyList;
+typedef DList<Thread, &Thread::agingLink> AgingList;
+typedef DList<Thread, &Thread::waitLink> WaitQueue;
+
 
 // external function, dummy routine whose sole job is to call Thread::Print
 extern void ThreadPrint(Thread *thread);	 
@@ -0,0 +1,131 @@
+// threadtable.cc
+//	Routines to keep track of the threads by ID.  See threadtable.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "threadtable.h"
+
+// A reserved ID, waiting for its thread to be entered.
+#define Reserved ((Thread *) 1)
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize an empty table, with every slot free.
+//
+//	"initialSize" is how many slots to start with.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable(int initialSize)
+{
+    ASSERT(initialSize > 0);
+    slots = NULL;
+    numSlots = 0;
+    firstFree = -1;
+    numThreads = 0;
+    Grow(initialSize);
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the table.  The threads themselves are not deleted.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    delete [] slots;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Make room for "newSize" threads, and put the new slots on the
+//	free list, lowest ID first.  Only done when no slot is free.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Grow(int newSize)
+{
+    ThreadSlot *bigger = new ThreadSlot[newSize];
+
+    ASSERT(firstFree == -1 && newSize > numSlots);
+
+    for (int i = 0; i < numSlots; i++) {
+        bigger[i] = slots[i];
+    }
+    for (int i = newSize - 1; i >= numSlots; i--) {
+        bigger[i].thread = NULL;
+        bigger[i].nextFree = firstFree;
+        firstFree = i;
+    }
+    delete [] slots;
+    slots = bigger;
+    numSlots = newSize;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::NewID
+// 	Take an ID off the free list, growing the table if there are
+//	none, and keep it for the thread about to be created with it.
+//----------------------------------------------------------------------
+
+int
+ThreadTable::NewID()
+{
+    int id;
+
+    if (firstFree == -1) {
+        Grow(2 * numSlots);
+    }
+    id = firstFree;
+    firstFree = slots[id].nextFree;
+    slots[id].thread = Reserved;
+    numThreads++;
+    return id;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Enter
+// 	Record the thread that was given "id".
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Enter(int id, Thread *thread)
+{
+    ASSERT(id >= 0 && id < numSlots && slots[id].thread == Reserved);
+    ASSERT(thread != NULL);
+    slots[id].thread = thread;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Free the slot of a thread that is being deleted, so that the
+//	next new thread can have its ID.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Remove(int id)
+{
+    ASSERT(id >= 0 && id < numSlots && slots[id].thread != NULL);
+    slots[id].thread = NULL;
+    slots[id].nextFree = firstFree;
+    firstFree = id;
+    numThreads--;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Lookup
+// 	Return the thread with "id", or NULL if there isn't one (or it
+//	hasn't been entered yet).
+//----------------------------------------------------------------------
+
+Thread *
+ThreadTable::Lookup(int id)
+{
+    if (id < 0 || id >= numSlots || slots[id].thread == Reserved) {
+        return NULL;
+    }
+    return slots[id].thread;
+}
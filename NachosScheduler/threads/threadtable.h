@@ -0,0 +1,64 @@
+// threadtable.h
+//	Data structures to find a thread from its ID.
+//
+//	The table is an array of slots indexed by thread ID, doubled
+//	whenever it fills up, so there's no limit on how many threads a
+//	run can start, and looking one up is constant time.  A free slot
+//	holds the ID of the next free slot; when a thread is deleted its
+//	ID goes on the front of that list, and the next thread to be
+//	created gets it, so the table only grows as big as the most
+//	threads alive at once.
+//
+//	An ID is only reused once its thread has been deleted, so a
+//	thread found in the table is always still there to be looked at.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+// One slot of the table: the thread with that ID, or, if there
+// isn't one, the next free ID.
+
+class ThreadSlot {
+  public:
+    Thread *thread;		// NULL if the slot is free
+    int nextFree;		// next free slot, -1 if this is the last
+};
+
+// The following class defines the thread table.
+
+class ThreadTable {
+  public:
+    ThreadTable(int initialSize);	// an empty table, with room for
+					// "initialSize" threads to start
+    ~ThreadTable();
+
+    int NewID();			// reserve an unused ID
+    void Enter(int id, Thread *thread);	// thread has the ID from NewID
+    void Remove(int id);		// the thread with this ID is
+					// gone; the ID may be reused
+    Thread *Lookup(int id);		// the thread with this ID, or NULL
+
+    int NumThreads() { return numThreads; }
+					// how many IDs are in use
+    int Size() { return numSlots; }	// one more than the highest ID
+
+  private:
+    ThreadSlot *slots;
+    int numSlots;
+    int firstFree;			// free slots, most recently freed
+					// first; -1 if none
+    int numThreads;
+
+    void Grow(int newSize);		// add slots, up to "newSize"
+};
+
+#endif // THREADTABLE_H
@@ -0,0 +1,159 @@
+// tracedump.cc
+//	Program to turn a binary scheduler trace, written by
+//	"nachos -tr <file>", back into text.
+//
+//	Usage: tracedump [-json] <trace file>
+//
+//	Without -json, prints the trace lines exactly as Nachos would
+//	have printed them without -tr.  With -json, prints the trace in
+//	the Chrome trace event format, for chrome://tracing: each CPU
+//	is a process, each Nachos thread a thread, the time a thread has
+//	a CPU is a "running" slice, and the other events are instants.
+//	Ticks are shown as microseconds.
+//
+//	This runs on the host, outside of Nachos; see schedtrace.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "utility.h"
+#include "schedtrace.h"
+
+static const char *eventNames[] =
+    { "ProcessNew", "ProcessReady", "ProcessRunning", "ProcessSleep",
+      "ProcessFinish" };
+
+static int *runningOn = NULL;		// CPU each thread is running on,
+					// for -json; -1 if none
+static int numThreads = 0;		// how many runningOn has room for
+
+//----------------------------------------------------------------------
+// RunningOn
+// 	Return where runningOn keeps thread "id", making room for it
+//	if it is the highest ID seen so far.
+//----------------------------------------------------------------------
+
+static int &
+RunningOn(int id)
+{
+    if (id >= numThreads) {
+        int size = max(2 * numThreads, id + 1024);
+        int *bigger = new int[size];
+
+        for (int i = 0; i < size; i++) {
+            bigger[i] = (i < numThreads) ? runningOn[i] : -1;
+        }
+        delete [] runningOn;
+        runningOn = bigger;
+        numThreads = size;
+    }
+    return runningOn[id];
+}
+
+//----------------------------------------------------------------------
+// JSONEvent
+// 	Print one Chrome trace event.  Every event but the first is
+//	preceded by a comma.
+//----------------------------------------------------------------------
+
+static void
+JSONEvent(const char *name, const char *phase, int cpu, const TraceRecord &r,
+          const char *args)
+{
+    static bool first = TRUE;
+
+    if (!first) {
+        cout << ",\n";
+    }
+    first = FALSE;
+    cout << "{\"name\":\"" << name << "\",\"ph\":\"" << phase << "\","
+         << "\"pid\":" << cpu << ",\"tid\":" << r.threadID << ","
+         << "\"ts\":" << r.tick;
+    if (phase[0] == 'i') {
+        cout << ",\"s\":\"t\"";
+    }
+    if (args != NULL) {
+        cout << ",\"args\":" << args;
+    }
+    cout << "}";
+}
+
+//----------------------------------------------------------------------
+// JSONPrint
+// 	Print the Chrome trace events for one record.  A thread stops
+//	running when it is made ready, sleeps or finishes.
+//----------------------------------------------------------------------
+
+static void
+JSONPrint(const TraceRecord &r)
+{
+    int cpu = RunningOn(r.threadID);
+
+    if (r.event == TraceRunning) {
+        RunningOn(r.threadID) = r.where;
+        JSONEvent("running", "B", r.where, r, NULL);
+        return;
+    }
+    if (cpu >= 0) {
+        JSONEvent("running", "E", cpu, r, NULL);
+        RunningOn(r.threadID) = -1;
+    } else {
+        cpu = 0;
+    }
+    if (r.event == TraceReady) {
+        char args[32];
+
+        sprintf(args, "{\"queue\":\"%s\"}", traceQueueNames[r.where]);
+        JSONEvent(eventNames[r.event], "i", cpu, r, args);
+    } else {
+        JSONEvent(eventNames[r.event], "i", cpu, r, NULL);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    bool json = FALSE;
+    FILE *fp;
+    int magic;
+    TraceRecord record;
+
+    if (argc == 3 && strcmp(argv[1], "-json") == 0) {
+        json = TRUE;
+    } else if (argc != 2) {
+        cerr << "Usage: tracedump [-json] <trace file>\n";
+        exit(1);
+    }
+    if ((fp = fopen(argv[argc - 1], "rb")) == NULL) {
+        cerr << "tracedump: can't open " << argv[argc - 1] << "\n";
+        exit(1);
+    }
+    if (fread(&magic, sizeof(magic), 1, fp) != 1 || magic != TraceMagic) {
+        cerr << "tracedump: " << argv[argc - 1] << " is not a Nachos trace\n";
+        exit(1);
+    }
+
+    if (json) {
+        cout << "{\"traceEvents\":[\n";
+    }
+    while (fread(&record, sizeof(record), 1, fp) == 1) {
+        if (record.event > TraceFinish || record.threadID < 0
+                || (record.event == TraceReady
+                    && record.where >= NumTraceQueues)) {
+            cerr << "tracedump: bad record at tick " << record.tick << "\n";
+            exit(1);
+        }
+        if (json) {
+            JSONPrint(record);
+        } else {
+            TracePrint(record);
+        }
+    }
+    if (json) {
+        cout << "\n]}\n";
+    }
+    fclose(fp);
+    return 0;
+}
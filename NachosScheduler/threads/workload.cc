@@ -0,0 +1,197 @@
+// workload.cc
+//	Routines to replay a job list, starting each job at the tick
+//	it arrives.  See workload.h for the format of the list.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "workload.h"
+#include "main.h"
+
+const int InitialLineSize = 128;	// grown as long lines turn up
+
+//----------------------------------------------------------------------
+// JobName::JobName
+// 	Keep a copy of "jobName", in front of "nextName".
+//----------------------------------------------------------------------
+
+JobName::JobName(char *jobName, JobName *nextName)
+{
+    name = new char[strlen(jobName) + 1];
+    strcpy(name, jobName);
+    next = nextName;
+}
+
+//----------------------------------------------------------------------
+// Workload::Workload
+// 	Open the job list, read the first job, and schedule an
+//	interrupt for when it arrives.
+//
+//	"jobFile" is the UNIX file holding the job list.
+//----------------------------------------------------------------------
+
+Workload::Workload(char *jobFile)
+{
+    line = new char[InitialLineSize];
+    lineSize = InitialLineSize;
+    lineNumber = 0;
+    names = NULL;
+    numReleased = 0;
+    haveJob = FALSE;
+
+    file.open(jobFile, ios::in);
+    if (!file) {
+        cout << "Fail to open file " << jobFile << endl;
+        return;
+    }
+    ReadJob();
+    WaitForJob();
+}
+
+//----------------------------------------------------------------------
+// Workload::~Workload
+// 	Close the job list, and free the names of the jobs.
+//----------------------------------------------------------------------
+
+Workload::~Workload()
+{
+    while (names != NULL) {
+        JobName *next = names->next;
+
+        delete names;
+        names = next;
+    }
+    delete [] line;
+    if (file.is_open()) {
+        file.close();
+    }
+}
+
+//----------------------------------------------------------------------
+// Workload::ReadLine
+// 	Read the next line of the job list into "line", without the
+//	newline, doubling the buffer as needed.  Return FALSE if there
+//	are no more lines.
+//----------------------------------------------------------------------
+
+bool
+Workload::ReadLine()
+{
+    int length = 0;
+    char ch;
+
+    if (!file.get(ch)) {
+        return FALSE;
+    }
+    while (ch != '\n') {
+        if (length + 1 == lineSize) {
+            char *bigger = new char[2 * lineSize];
+
+            memcpy(bigger, line, length);
+            delete [] line;
+            line = bigger;
+            lineSize *= 2;
+        }
+        if (ch != '\r') {
+            line[length++] = ch;
+        }
+        if (!file.get(ch)) {
+            break;
+        }
+    }
+    line[length] = '\0';
+    lineNumber++;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Workload::Intern
+// 	Return a copy of "name" that lasts until Nachos halts.  Each
+//	executable is only copied once, however many jobs run it.
+//----------------------------------------------------------------------
+
+char *
+Workload::Intern(char *name)
+{
+    for (JobName *n = names; n != NULL; n = n->next) {
+        if (strcmp(n->name, name) == 0) {
+            return n->name;
+        }
+    }
+    names = new JobName(name, names);
+    return names->name;
+}
+
+//----------------------------------------------------------------------
+// Workload::ReadJob
+// 	Read lines until one describes a job, and keep it as the next
+//	job.  Lines that can't be parsed are reported and skipped.  At
+//	the end of the list, there is no next job.
+//----------------------------------------------------------------------
+
+void
+Workload::ReadJob()
+{
+    char *field;
+
+    haveJob = FALSE;
+    while (ReadLine()) {
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        if (lineNumber == 1 && strchr(line, ',') == NULL) {
+            continue;			// old-style job count
+        }
+        if ((field = strtok(line, ",")) == NULL) {
+            continue;
+        }
+        arrival = atoi(field);
+        if ((field = strtok(NULL, ",")) == NULL) {
+            cout << "JobList line " << lineNumber << ": no executable\n";
+            continue;
+        }
+        jobName = Intern(field);
+        field = strtok(NULL, ",");
+        jobPriority = (field != NULL) ? atoi(field) : 75;
+        field = (field != NULL) ? strtok(NULL, ",") : NULL;
+        jobBurst = (field != NULL) ? atof(field) : -1;
+        haveJob = TRUE;
+        return;
+    }
+}
+
+//----------------------------------------------------------------------
+// Workload::WaitForJob
+// 	Schedule an interrupt for when the next job arrives, if there
+//	is one.  A job that should have arrived already is due a tick
+//	from now.
+//----------------------------------------------------------------------
+
+void
+Workload::WaitForJob()
+{
+    if (haveJob) {
+        int fromNow = arrival - kernel->stats->totalTicks;
+
+        kernel->interrupt->Schedule(this, max(fromNow, 1), JobArrivalInt);
+    }
+}
+
+//----------------------------------------------------------------------
+// Workload::CallBack
+// 	Interrupt handler for job arrivals.  Start the job that is due,
+//	and any others arriving by now, then wait for the next one.
+//----------------------------------------------------------------------
+
+void
+Workload::CallBack()
+{
+    while (haveJob && arrival <= kernel->stats->totalTicks) {
+        kernel->Exec(jobName, jobPriority, jobBurst);
+        numReleased++;
+        ReadJob();
+    }
+    WaitForJob();
+}
@@ -0,0 +1,80 @@
+// workload.h
+//	Data structures to replay a list of jobs, each started with
+//	Kernel::Exec at the tick it arrives.  This is what "--test" runs.
+//
+//	The job list is a text file, one job per line:
+//
+//	    <arrival tick>,<executable>[,<priority>[,<expected burst>]]
+//
+//	The priority defaults to 75, as with -e; the expected burst, if
+//	given, is the job's first SJF burst prediction.  Blank lines and
+//	lines starting with '#' are skipped, as is a first line holding
+//	just a count, which older job lists start with.  Lines may be
+//	any length, and jobs should be listed in order of arrival; one
+//	that arrives late is started as soon as it is read.
+//
+//	The list is read as the simulation goes: only the next job to
+//	arrive is kept in memory, waiting for an interrupt scheduled at
+//	its arrival tick.  Each job's turnaround is printed with the
+//	other per-thread statistics when Nachos halts.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <fstream>
+#include "copyright.h"
+#include "sysdep.h"
+#include "callback.h"
+
+// One executable name, kept for as long as the threads running it
+// (and their statistics) may refer to it.
+
+class JobName {
+  public:
+    JobName(char *jobName, JobName *nextName);
+    ~JobName() { delete [] name; }
+
+    char *name;
+    JobName *next;
+};
+
+// The following class feeds a job list to the kernel.
+
+class Workload : public CallBackObj {
+  public:
+    Workload(char *jobFile);	// open the list, and wait for its
+				// first job
+    ~Workload();
+
+    int NumReleased() { return numReleased; }
+				// jobs started so far
+
+  private:
+    ifstream file;		// the job list
+    char *line;			// the line being parsed
+    int lineSize;		// room for this many chars in line
+    int lineNumber;
+    JobName *names;		// every executable seen so far
+
+    bool haveJob;		// is the next job below valid?
+    int arrival;		// when it arrives
+    char *jobName;		// what it runs
+    int jobPriority;		// at what priority
+    double jobBurst;		// expected burst, or -1 if not given
+    int numReleased;
+
+    bool ReadLine();		// read the next line into "line";
+				// FALSE at end of file
+    void ReadJob();		// read up to the next job, if any
+    void WaitForJob();		// schedule the next job's arrival
+    char *Intern(char *name);	// a lasting copy of "name"
+
+    void CallBack();		// a job has arrived: start it, and all
+				// the others that arrive at the same time
+};
+
+#endif // WORKLOAD_H
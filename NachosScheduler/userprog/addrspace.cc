@@ -20,41 +20,125 @@
 #include "addrspace.h"
 #include "machine.h"
 #include "noff.h"
-static int checker[NumPhysPages];
+#include "frames.h"
+#include "pager.h"
+#include "list.h"
+#include "execcache.h"
+#include "synch.h"
+#include "syscallring.h"
+#include "syscall.h"
+#include "pipe.h"
+
+static int nextASID = 1;		// 0 is for no address space
+
 //----------------------------------------------------------------------
-// SwapHeader
-// 	Do little endian to big endian conversion on the bytes in the 
-//	object file header, in case the file was generated on a little
-//	endian machine, and we're now running on a big endian machine.
+// SharedImage
+// 	The frames address spaces running the same program can share,
+//	instead of each reading the program in again: for each page that
+//	holds code or initialized data, the frame with the page in it as
+//	it was when the program started, or -1.  A frame is only here
+//	while it is unchanged; a page written to in place is taken out.
+//
+//	A frame is kept back for each of those pages that isn't in memory,
+//	for whichever address space touches it first to read it into.
 //----------------------------------------------------------------------
 
-static void 
-SwapHeader (NoffHeader *noffH)
+class SharedImage {
+  public:
+    SharedImage(char *fileName, int pages);
+    ~SharedImage();
+
+    char *name;				// the program's file
+    int numPages;
+    int *frames;			// the frame of each page, or -1
+    int users;				// address spaces running it
+    int numReserved;			// frames kept back for the -1s
+};
+
+static List<SharedImage *> *images = NULL;	// the programs running
+
+SharedImage::SharedImage(char *fileName, int pages)
 {
-    noffH->noffMagic = WordToHost(noffH->noffMagic);
-    noffH->code.size = WordToHost(noffH->code.size);
-    noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
-    noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
-#ifdef RDATA
-    noffH->readonlyData.size = WordToHost(noffH->readonlyData.size);
-    noffH->readonlyData.virtualAddr = 
-           WordToHost(noffH->readonlyData.virtualAddr);
-    noffH->readonlyData.inFileAddr = 
-           WordToHost(noffH->readonlyData.inFileAddr);
-#endif 
-    noffH->initData.size = WordToHost(noffH->initData.size);
-    noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
-    noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
-    noffH->uninitData.size = WordToHost(noffH->uninitData.size);
-    noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
-    noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    numPages = pages;
+    frames = new int[numPages];
+    for (int i = 0; i < numPages; i++) {
+	frames[i] = -1;
+    }
+    users = 0;
+    numReserved = 0;
+}
+
+SharedImage::~SharedImage()
+{
+    delete [] name;
+    delete [] frames;
+}
+
+//----------------------------------------------------------------------
+// FindImage
+// 	Return the shared frames of program "fileName", of "numPages"
+//	pages, if any address space is running it, or NULL.
+//----------------------------------------------------------------------
+
+static SharedImage *
+FindImage(char *fileName, int numPages)
+{
+    if (images == NULL) {
+	return NULL;
+    }
+    for (ListIterator<SharedImage *> iter(images); !iter.IsDone();
+	 iter.Next()) {
+	SharedImage *image = iter.Item();
+
+	if (strcmp(image->name, fileName) == 0 && image->numPages == numPages) {
+	    return image;
+	}
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// Overlap
+// 	Return how many bytes of "segment" of a program are in the page
+//	starting at virtual address "pageStart".
+//----------------------------------------------------------------------
+
+static int
+Overlap(Segment *segment, int pageStart)
+{
+    int start = max(segment->virtualAddr, pageStart);
+    int end = min(segment->virtualAddr + segment->size, pageStart + PageSize);
+
+    return (start < end) ? end - start : 0;
+}
+
+//----------------------------------------------------------------------
+// KindOf
+// 	Return whether page "virtualPage" of the program described by
+//	"noffH" can be shared by address spaces running it: read-only,
+//	if the page holds nothing but code (or read-only data);
+//	copy-on-write, if it holds initialized data as well, or some
+//	uninitialized data or stack; and not at all, if it holds nothing
+//	but those, which start out as zeros anyway.
+//----------------------------------------------------------------------
+
+static PageKind
+KindOf(NoffHeader *noffH, int virtualPage)
+{
+    int pageStart = virtualPage * PageSize;
+    int readOnly = Overlap(&noffH->code, pageStart);
 
 #ifdef RDATA
-    DEBUG(dbgAddr, "code = " << noffH->code.size <<  
-                   " readonly = " << noffH->readonlyData.size <<
-                   " init = " << noffH->initData.size <<
-                   " uninit = " << noffH->uninitData.size << "\n");
+    readOnly += Overlap(&noffH->readonlyData, pageStart);
 #endif
+    if (readOnly == PageSize) {
+	return SharedPage;
+    } else if (readOnly + Overlap(&noffH->initData, pageStart) > 0) {
+	return CopyOnWritePage;
+    }
+    return PrivatePage;
 }
 
 //----------------------------------------------------------------------
@@ -79,16 +163,103 @@ AddrSpace::AddrSpace()
     
     // zero out the entire address space
   //  bzero(kernel->machine->mainMemory, MemorySize);
+    pageTable = NULL;			// until Load
+    numPages = 0;
+    asid = nextASID++;
+    program = NULL;
+    swapSlots = NULL;
+    copyOnWrite = NULL;
+    image = NULL;
+    history = NULL;
+    pagerUse = sampleUse = NULL;
+    numResident = peakResident = numFaults = 0;
+    workingSet = peakWorkingSet = totalWorkingSet = numSamples = 0;
+    for (int i = 0; i < MaxOpenFiles; i++) {
+        openFiles[i] = NULL;
+        pipeEnds[i] = NULL;
+    }
+    children = NULL;
+    ring = NULL;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.
+// 	Dealloate an address space, and give its page frames back (and
+//	those kept back for pages it never touched), and with demand
+//	paging, its room in the swap area.  A frame shared with another
+//	address space stays as it is, for that one.  The files and pipe
+//	ends its program left open are closed, and the programs it
+//	started and didn't join are forgotten, as is its ring of system
+//	calls.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
-   delete pageTable;
+   delete ring;
+   CloseFiles();
+   while (children != NULL) {
+       JoinRecord *child = children;
+
+       children = child->next;
+       child->Release();
+   }
+   for (unsigned int i = 0; i < numPages; i++) {
+       if (pageTable[i].valid) {
+           int frame = pageTable[i].physicalPage;
+           bool last = (kernel->frames->References(frame) == 1);
+
+           if (copyOnWrite[i]) {		// won't need copying now
+               kernel->frames->Unreserve(1);
+           }
+           if (last) {					// its code is gone
+               kernel->machine->InvalidateDecoded(frame * PageSize, PageSize);
+           }
+           if (kernel->pager != NULL) {
+               kernel->pager->FreeFrame(frame);
+           } else {
+               kernel->frames->Free(frame);
+           }
+           if (last && image != NULL && image->frames[i] == frame) {
+               bool reserved = kernel->frames->Reserve(1);
+
+               ASSERT(reserved);		// it was just freed
+               image->frames[i] = -1;		// not in memory now
+               image->numReserved++;
+           }
+       } else if (kernel->pager == NULL
+                    && (!pageTable[i].readOnly || copyOnWrite[i])) {
+           kernel->frames->Unreserve(1);	// never touched
+       }
+       if (swapSlots != NULL && swapSlots[i] >= 0) {
+           kernel->pager->FreeSlot(swapSlots[i]);
+       }
+   }
+   if (swapSlots != NULL) {
+       kernel->pager->Unreserve(numPages);
+       delete [] swapSlots;
+   }
+   if (image != NULL && --image->users == 0) {
+       kernel->frames->Unreserve(image->numReserved);
+       images->Remove(image);
+       delete image;
+   }
+   delete [] copyOnWrite;
+   delete [] history;
+   delete [] pagerUse;
+   delete [] sampleUse;
+   if (program != NULL) {
+       kernel->execCache->Release(program);
+   }
+   kernel->machine->FlushTranslations();	// it may have been cached
+   if (kernel->machine->pageTable == pageTable) {
+       kernel->machine->pageTable = NULL;	// don't mistake a new one
+   }						// at the same address for it
+   for (int i = 0; i < kernel->numCPUs; i++) {	// or be in a TLB
+       if (kernel->cpus[i]->tlb != NULL) {
+           kernel->cpus[i]->tlb->Purge(asid);
+       }
+   }
+   delete [] pageTable;
 }
 
 
@@ -96,8 +267,20 @@ AddrSpace::~AddrSpace()
 // AddrSpace::Load
 // 	Load a user program into memory from a file.
 //
-//	Assumes that the page table has been initialized, and that
-//	the object code file is in NOFF format.
+//	Assumes that the object code file is in NOFF format.  The file is
+//	read through kernel->execCache, and only if it hasn't been read
+//	before.  The page table is built here, with a frame for each page
+//	kept back in kernel->frames; if there aren't enough free, nothing
+//	is loaded.  The pages aren't filled yet, but the first time each
+//	is touched (see PageIn), so a program only waits for the pages it
+//	uses.  With demand paging, not even the frames are kept back (see
+//	LoadOnDemand).
+//
+//	Address spaces running the same program share the pages of its
+//	code and initialized data (see KindOf): a frame is kept back for
+//	each of those the first time the program is loaded, and one for
+//	each copy-on-write page by each address space, for when it is
+//	written to.
 //
 //	"fileName" is the file containing the object code to load into memory
 //----------------------------------------------------------------------
@@ -105,7 +288,7 @@ AddrSpace::~AddrSpace()
 bool 
 AddrSpace::Load(char *fileName) 
 {
-    OpenFile *executable = kernel->fileSystem->Open(fileName);
+    Executable *executable = kernel->execCache->Get(fileName);
     NoffHeader noffH;
     unsigned int size;
 
@@ -113,12 +296,7 @@ AddrSpace::Load(char *fileName)
 	cerr << "Unable to open file " << fileName << "\n";
 	return FALSE;
     }
-
-    executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) && 
-		(WordToHost(noffH.noffMagic) == NOFFMAGIC))
-    	SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
+    noffH = executable->noffH;
 
 #ifdef RDATA
 // how big is address space?
@@ -133,61 +311,185 @@ AddrSpace::Load(char *fileName)
 						// to leave room for the stack
 #endif
     numPages = divRoundUp(size, PageSize);
+    size = numPages * PageSize;
+    program = executable;
+    this->noffH = noffH;
+
+    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
+    DEBUG(dbgAddr, "code " << noffH.code.virtualAddr << ", " << noffH.code.size
+          << "; data " << noffH.initData.virtualAddr << ", "
+          << noffH.initData.size);
+
+    if (kernel->pager != NULL) {	// the pages are read in as they
+	return LoadOnDemand(fileName);	// are used
+    }
+
+    image = FindImage(fileName, numPages);
+    int numOwn = 0;			// frames to keep back for us
+    int numShared = 0;			// and for the pages we share
+    for (unsigned int i = 0; i < numPages; i++) {
+	PageKind kind = KindOf(&noffH, i);
+
+	if (kind != SharedPage) {
+	    numOwn++;
+	}
+	if (kind != PrivatePage && image == NULL) {
+	    numShared++;
+	}
+    }
+    if (numOwn + numShared > kernel->frames->NumFree()) {
+	cerr << "Not enough memory for " << fileName << ": "
+	     << numOwn + numShared << " pages, " << kernel->frames->NumFree()
+	     << " free\n";
+	numPages = 0;			// check we're not trying to run
+	image = NULL;			// anything too big -- at least
+	kernel->execCache->Release(executable);	// until we have
+	program = NULL;				// virtual memory
+	return FALSE;
+    }
+    kernel->frames->Reserve(numOwn + numShared);
+    if (image == NULL) {
+	if (images == NULL) {
+	    images = new List<SharedImage *>;
+	}
+	image = new SharedImage(fileName, numPages);
+	image->numReserved = numShared;
+	images->Insert(image);
+    }
+    image->users++;
+
 pageTable=new TranslationEntry[numPages];
-for(unsigned int i=0,j=0;i<numPages;i++){
+copyOnWrite = new bool[numPages];
+InitUsage();
+for(unsigned int i=0;i<numPages;i++){
+        PageKind kind = KindOf(&noffH, i);
+
         pageTable[i].virtualPage=i;
-        while(checker[j]!=0){
-                j++;
-        }
-        checker[j]=1;
-        pageTable[i].physicalPage=j;
-        pageTable[i].valid = TRUE;
         pageTable[i].use = FALSE;
         pageTable[i].dirty = FALSE;
-        pageTable[i].readOnly = FALSE;
+        pageTable[i].readOnly = (kind != PrivatePage);
+        copyOnWrite[i] = (kind == CopyOnWritePage);
+        if (kind != PrivatePage && image->frames[i] >= 0) {
+            pageTable[i].physicalPage = image->frames[i];
+            pageTable[i].valid = TRUE;
+            kernel->frames->Share(image->frames[i]);
+            CountResident(1);
+        } else {
+            pageTable[i].physicalPage = 0;	// until PageIn
+            pageTable[i].valid = FALSE;
+        }
+}
+    return TRUE;			// success
 }
-int entry_code_num=noffH.code.virtualAddr/PageSize;
-int entry_data_num=noffH.initData.virtualAddr/PageSize;
-int offset_code=noffH.code.virtualAddr%PageSize;
-int offset_data=noffH.initData.virtualAddr%PageSize;
-    size = numPages * PageSize;
 
-    ASSERT(numPages <= NumPhysPages);		// check we're not trying
-						// to run anything too big --
-						// at least until we have
-						// virtual memory
+//----------------------------------------------------------------------
+// AddrSpace::PageIn
+// 	Called by ExceptionHandler the first time a user program touches
+//	the page holding "virtAddr", without demand paging.  Give the
+//	page one of the frames Load kept back, and copy in the code and
+//	data in it, or zeros; whatever else the frame held before is
+//	forgotten.  If another address space running the program has
+//	read the page in since we were loaded, share its frame instead.
+//	The frame a copy-on-write page keeps back is for its copy either
+//	way, so a page we share is read into one of the program's.
+//	Return FALSE if the page isn't in the address space, or is in
+//	memory already, so the fault is a real one.
+//----------------------------------------------------------------------
 
-    DEBUG(dbgAddr, "Initializing address space: " << numPages << ", " << size);
+bool
+AddrSpace::PageIn(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationEntry *entry;
+    PageKind kind;
 
-// then, copy in the code and data segments into memory
-// Note: this code assumes that virtual address = physical address
-    if (noffH.code.size > 0) {
-        DEBUG(dbgAddr, "Initializing code segment.");
-	DEBUG(dbgAddr, noffH.code.virtualAddr << ", " << noffH.code.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[pageTable[entry_code_num].physicalPage*PageSize+offset_code]), 
-			noffH.code.size, noffH.code.inFileAddr);
+    if (vpn >= numPages || pageTable[vpn].valid) {
+        return FALSE;
     }
-    if (noffH.initData.size > 0) {
-        DEBUG(dbgAddr, "Initializing data segment.");
-	DEBUG(dbgAddr, noffH.initData.virtualAddr << ", " << noffH.initData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[pageTable[entry_data_num].physicalPage*PageSize+offset_code]),
-			noffH.initData.size, noffH.initData.inFileAddr);
+    entry = &pageTable[vpn];
+    kind = KindOf(&noffH, vpn);
+    kernel->stats->numPageFaults++;
+    numFaults++;
+    if (kind != PrivatePage && image->frames[vpn] >= 0) {
+        entry->physicalPage = image->frames[vpn];
+        kernel->frames->Share(entry->physicalPage);
+    } else {
+        int frame;
+
+        if (kind != PrivatePage) {
+            image->numReserved--;
+        }
+        kernel->frames->Unreserve(1);
+        frame = kernel->frames->Allocate();
+        ASSERT(frame >= 0);
+        kernel->machine->InvalidateDecoded(frame * PageSize, PageSize);
+        FillPage(vpn, &kernel->machine->mainMemory[frame * PageSize]);
+        entry->physicalPage = frame;
+        if (kind != PrivatePage) {
+            image->frames[vpn] = frame;
+        }
+        DEBUG(dbgAddr, "Page " << vpn << " in from file to frame " << frame);
     }
+    entry->valid = TRUE;
+    CountResident(1);
+    return TRUE;
+}
 
-#ifdef RDATA
-    if (noffH.readonlyData.size > 0) {
-        DEBUG(dbgAddr, "Initializing read only data segment.");
-	DEBUG(dbgAddr, noffH.readonlyData.virtualAddr << ", " << noffH.readonlyData.size);
-        executable->ReadAt(
-		&(kernel->machine->mainMemory[noffH.code.virtualAddr]),
-			noffH.readonlyData.size, noffH.readonlyData.inFileAddr);
+//----------------------------------------------------------------------
+// AddrSpace::LoadOnDemand
+// 	Finish loading a program with demand paging: make every page
+//	invalid, so that it is read in by the pager the first time it is
+//	used, from the program kept by kernel->execCache.  Fail if
+//	the swap area hasn't room for the whole program.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::LoadOnDemand(char *fileName)
+{
+    if (!kernel->pager->Reserve(numPages)) {
+	cerr << "Not enough swap space for " << fileName << ": " << numPages
+	     << " pages\n";
+	numPages = 0;
+	kernel->execCache->Release(program);
+	program = NULL;
+	return FALSE;
     }
-#endif
+    pageTable = new TranslationEntry[numPages];
+    swapSlots = new int[numPages];
+    copyOnWrite = new bool[numPages];
+    for (unsigned int i = 0; i < numPages; i++) {
+	pageTable[i].virtualPage = i;
+	pageTable[i].physicalPage = 0;
+	pageTable[i].valid = FALSE;
+	pageTable[i].use = FALSE;
+	pageTable[i].dirty = FALSE;
+	pageTable[i].readOnly = FALSE;
+	swapSlots[i] = -1;		// not written out yet
+	copyOnWrite[i] = FALSE;		// nor shared
+    }
+    InitUsage();
+    return TRUE;
+}
 
-    delete executable;			// close file
-    return TRUE;			// success
+//----------------------------------------------------------------------
+// AddrSpace::FillPage
+// 	Set "frame" to what page "virtualPage" holds when the program
+//	starts: the code and initialized data in it, as read from the
+//	program's file, and zeros everywhere else (the uninitialized data
+//	and the stack).
+//----------------------------------------------------------------------
+
+void
+AddrSpace::FillPage(int virtualPage, char *frame)
+{
+    int pageStart = virtualPage * PageSize;
+
+    bzero(frame, PageSize);
+    program->ReadSegment(&noffH.code, pageStart, frame);
+    program->ReadSegment(&noffH.initData, pageStart, frame);
+#ifdef RDATA
+    program->ReadSegment(&noffH.readonlyData, pageStart, frame);
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -204,10 +506,17 @@ AddrSpace::Execute(char* fileName)
 {
 
     kernel->currentThread->space = this;
+    kernel->currentCPU->LoadUserState(kernel->currentThread);
+					// make room for our registers
 
     this->InitRegisters();		// set the initial register values
     this->RestoreState();		// load page table register
 
+    if (kernel->profiler != NULL) {	// count what it executes
+	kernel->currentThread->profile = kernel->profiler->Start(
+		kernel->currentThread->getID(), fileName, numPages * PageSize);
+    }
+
     kernel->machine->Run();		// jump to the user progam
 
     ASSERTNOTREACHED();			// machine->Run never returns;
@@ -215,6 +524,88 @@ AddrSpace::Execute(char* fileName)
 					// by doing the syscall "exit"
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::Checkpoint
+// 	Write what a checkpoint needs to know of this address space to
+//	"fd": the number of pages, the page table, and which pages are
+//	copy-on-write.  The pages themselves are saved with the rest of
+//	main memory, so any not touched yet are read in first; a restored
+//	address space has no program to read them from.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Checkpoint(int fd)
+{
+    for (unsigned int i = 0; i < numPages; i++) {
+        if (!pageTable[i].valid) {
+            PageIn(i * PageSize);
+        }
+    }
+    WriteFile(fd, (char *) &numPages, sizeof(numPages));
+    WriteFile(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+    WriteFile(fd, (char *) copyOnWrite, numPages * sizeof(bool));
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Restore
+// 	Read back what Checkpoint wrote, instead of loading a program,
+//	and take the page frames it uses from kernel->frames, or share
+//	them with the address spaces restored before us that use them
+//	too.  Their contents come back with the rest of main memory.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Restore(int fd)
+{
+    Read(fd, (char *) &numPages, sizeof(numPages));
+    ASSERT(numPages <= (unsigned) NumPhysPages);
+    pageTable = new TranslationEntry[numPages];
+    copyOnWrite = new bool[numPages];
+    Read(fd, (char *) pageTable, numPages * sizeof(TranslationEntry));
+    Read(fd, (char *) copyOnWrite, numPages * sizeof(bool));
+    InitUsage();
+    for (unsigned int i = 0; i < numPages; i++) {
+        int frame = pageTable[i].physicalPage;
+
+        ASSERT(frame < NumPhysPages);
+        if (kernel->frames->References(frame) == 0) {
+            kernel->frames->Take(frame);
+        } else {
+            kernel->frames->Share(frame);
+        }
+        if (copyOnWrite[i]) {
+            bool reserved = kernel->frames->Reserve(1);
+
+            ASSERT(reserved);		// it was, when we were saved
+        }
+    }
+    CountResident(numPages);		// Checkpoint read them all in
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Resume
+// 	Run a program restored from a checkpoint, using the current
+//	thread.  Its registers are in the thread, where the checkpoint
+//	put them, rather than set up by InitRegisters.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Resume()
+{
+    kernel->currentThread->space = this;
+    kernel->currentCPU->LoadUserState(kernel->currentThread);
+    this->RestoreState();
+
+    if (kernel->profiler != NULL) {	// count what it executes from here
+	kernel->currentThread->profile = kernel->profiler->Start(
+		kernel->currentThread->getID(),
+		kernel->currentThread->getName(), numPages * PageSize);
+    }
+
+    kernel->machine->Run();
+    ASSERTNOTREACHED();
+}
+
 
 //----------------------------------------------------------------------
 // AddrSpace::InitRegisters
@@ -268,15 +659,519 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, unless
+//	it's already using ours, and to forget the translations it has
+//	cached from the last one.  With a TLB, just tell it which address
+//	space is running; the TLB is refilled from our page table
+//	(see RefillTLB).
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState() 
 {
-    kernel->machine->pageTable = pageTable;
-    kernel->machine->pageTableSize = numPages;
+    if (kernel->machine->tlb != NULL) {
+        kernel->machine->tlb->Switch(asid);
+    } else if (kernel->machine->pageTable != pageTable
+          || kernel->machine->pageTableSize != numPages) {
+        kernel->machine->pageTable = pageTable;
+        kernel->machine->pageTableSize = numPages;
+        kernel->machine->FlushTranslations();
+    }
+}
+
+
+//----------------------------------------------------------------------
+// AddrSpace::RefillTLB
+// 	Load the translation of the page holding "virtAddr" into the
+//	TLB, after a user instruction missed it.  Return FALSE if the
+//	page is not in this address space, so the miss is a real fault.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::RefillTLB(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+
+    if (vpn >= numPages || !pageTable[vpn].valid) {
+        return FALSE;
+    }
+    kernel->machine->tlb->Load(&pageTable[vpn]);
+    return TRUE;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::CopyOnWrite
+// 	A user instruction wrote to the read-only page holding
+//	"virtAddr".  If it is a copy-on-write page, make it writable:
+//	in place, if no other address space is using its frame any more,
+//	and otherwise in a copy of it, in the frame kept back for it when
+//	we were loaded.  Return FALSE if the page is really read-only (or
+//	not in the address space), so the write is an error.
+//----------------------------------------------------------------------
+
+bool
+AddrSpace::CopyOnWrite(int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationEntry *entry;
+    int frame;
+
+    if (vpn >= numPages || !copyOnWrite[vpn]) {
+        return FALSE;
+    }
+    entry = &pageTable[vpn];
+    for (int i = 0; i < kernel->numCPUs; i++) {	// the TLBs have it
+        if (kernel->cpus[i]->tlb != NULL) {	// read-only
+            kernel->cpus[i]->tlb->Invalidate(entry);
+        }
+    }
+    frame = entry->physicalPage;
+    if (kernel->frames->References(frame) == 1) {
+        if (image != NULL && image->frames[vpn] == frame) {
+            image->frames[vpn] = -1;		// it won't be as it was, so
+            image->numReserved++;		// the frame we kept back is
+        } else {				// for reading it in again
+            kernel->frames->Unreserve(1);
+        }
+    } else {
+        int copy;
+
+        kernel->frames->Unreserve(1);
+        copy = kernel->frames->Allocate();
+        ASSERT(copy >= 0);
+        kernel->machine->InvalidateDecoded(copy * PageSize, PageSize);
+        bcopy(&kernel->machine->mainMemory[frame * PageSize],
+              &kernel->machine->mainMemory[copy * PageSize], PageSize);
+        kernel->frames->Free(frame);
+        entry->physicalPage = copy;
+        kernel->stats->numPagesCopied++;
+        DEBUG(dbgAddr, "Copied page " << vpn << " from frame " << frame
+              << " to frame " << copy);
+    }
+    copyOnWrite[vpn] = FALSE;
+    entry->readOnly = FALSE;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InitUsage
+// 	Start counting how the pages are used, once the page table has
+//	been built: none has been used yet.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::InitUsage()
+{
+    history = new unsigned char[numPages];
+    pagerUse = new bool[numPages];
+    sampleUse = new bool[numPages];
+    for (unsigned int i = 0; i < numPages; i++) {
+        history[i] = 0;
+        pagerUse[i] = sampleUse[i] = FALSE;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CountResident
+// 	"change" more of our pages are in memory (or fewer, if it is
+//	negative).
+//----------------------------------------------------------------------
+
+void
+AddrSpace::CountResident(int change)
+{
+    numResident += change;
+    ASSERT(numResident >= 0 && numResident <= (int) numPages);
+    peakResident = max(peakResident, numResident);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::SampleWorkingSet
+// 	Called on a timer interrupt while we are running.  Shift whether
+//	each page was used since the last sample into its history, and
+//	clear its use bit, after copying those the TLBs have back to the
+//	page table; the pages used in any of the last 8 samples are the
+//	working set.
+//
+//	The pager looks at the same use bits, and clears them when it
+//	pleases (see Pager::Victim and Pager::Tick).  So that neither
+//	misses a use the other cleared, a bit one of them clears is
+//	kept for the other: in "pagerUse" by this, and in "sampleUse"
+//	by the pager.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::SampleWorkingSet()
+{
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        if (kernel->cpus[i]->tlb != NULL) {
+            kernel->cpus[i]->tlb->WriteBack();
+        }
+    }
+    workingSet = 0;
+    for (unsigned int i = 0; i < numPages; i++) {
+        bool used = pageTable[i].use || sampleUse[i];
+
+        if (pageTable[i].use) {
+            pagerUse[i] = TRUE;
+            pageTable[i].use = FALSE;
+        }
+        sampleUse[i] = FALSE;
+        history[i] = (history[i] >> 1) | (used ? 0x80 : 0);
+        if (history[i] != 0) {
+            workingSet++;
+        }
+    }
+    peakWorkingSet = max(peakWorkingSet, workingSet);
+    totalWorkingSet += workingSet;
+    numSamples++;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Finished
+// 	The thread running us is finishing: put our counts in its
+//	statistics, "record", to be printed at halt -- unless no program
+//	was ever loaded into us.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Finished(ThreadStats *record)
+{
+    if (numPages == 0) {		// nothing was loaded
+        return;
+    }
+    DEBUG(dbgAddr, "Address space of " << numPages << " pages: "
+          << numResident << " in memory, at most " << peakResident << ", "
+          << numFaults << " faults, working set " << workingSet
+          << ", at most " << peakWorkingSet);
+    record->numPages = numPages;
+    record->numFaults = numFaults;
+    record->peakResident = peakResident;
+    record->peakWorkingSet = peakWorkingSet;
+    record->totalWorkingSet = totalWorkingSet;
+    record->numSamples = numSamples;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Attach
+// 	Give "file", just opened by our program, the lowest descriptor
+//	that is free, and return it; or -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::Attach(OpenFile *file)
+{
+    for (int id = ConsoleOutput + 1; id < MaxOpenFiles; id++) {
+        if (openFiles[id] == NULL && pipeEnds[id] == NULL) {
+            openFiles[id] = file;
+            return id;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FileFor
+// 	Return the file our program has open as descriptor "id", or NULL
+//	if it has none (the console isn't in the table).
+//----------------------------------------------------------------------
+
+OpenFile *
+AddrSpace::FileFor(int id)
+{
+    if (id < 0 || id >= MaxOpenFiles) {
+        return NULL;
+    }
+    return openFiles[id];
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Detach
+// 	Free descriptor "id", and return the file that was open as it,
+//	for the caller to close; or NULL if there was none.
+//----------------------------------------------------------------------
+
+OpenFile *
+AddrSpace::Detach(int id)
+{
+    OpenFile *file = FileFor(id);
+
+    if (file != NULL) {
+        openFiles[id] = NULL;
+    }
+    return file;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::CloseFiles
+// 	Close every file, and pipe end, our program still has open: it
+//	is exiting.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::CloseFiles()
+{
+    for (int id = 0; id < MaxOpenFiles; id++) {
+        delete Detach(id);
+        delete DetachPipe(id);
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AttachPipe
+// 	Give "end", of a pipe our program just made, the lowest
+//	descriptor that is free, and return it; or -1 if there is none.
+//----------------------------------------------------------------------
+
+int
+AddrSpace::AttachPipe(PipeEnd *end)
+{
+    for (int id = ConsoleOutput + 1; id < MaxOpenFiles; id++) {
+        if (openFiles[id] == NULL && pipeEnds[id] == NULL) {
+            pipeEnds[id] = end;
+            return id;
+        }
+    }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PipeFor
+// 	Return the pipe end our program has open as descriptor "id", or
+//	NULL if it has none.
+//----------------------------------------------------------------------
+
+PipeEnd *
+AddrSpace::PipeFor(int id)
+{
+    if (id < 0 || id >= MaxOpenFiles) {
+        return NULL;
+    }
+    return pipeEnds[id];
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::DetachPipe
+// 	Free descriptor "id", and return the pipe end that was open as
+//	it, for the caller to close; or NULL if there was none.
+//----------------------------------------------------------------------
+
+PipeEnd *
+AddrSpace::DetachPipe(int id)
+{
+    PipeEnd *end = PipeFor(id);
+
+    if (end != NULL) {
+        pipeEnds[id] = NULL;
+    }
+    return end;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::InheritPipes
+// 	Our program was just started by the one running in "parent":
+//	give it an end of each pipe that one has, open as the same
+//	descriptor.  We have no descriptors of our own yet.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::InheritPipes(AddrSpace *parent)
+{
+    for (int id = 0; id < MaxOpenFiles; id++) {
+        PipeEnd *end = parent->pipeEnds[id];
+
+        ASSERT(openFiles[id] == NULL && pipeEnds[id] == NULL);
+        if (end != NULL) {
+            pipeEnds[id] = new PipeEnd(end->pipe, end->writing);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AddChild
+// 	Our program has started another, with record "child": keep it,
+//	for when our program joins it.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::AddChild(JoinRecord *child)
+{
+    child->next = children;
+    children = child;
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::TakeChild
+// 	Take the record of the program our program started as thread
+//	"id" out of our list, and return it, for the caller to join it;
+//	or NULL if there's none: only a program's parent can join it,
+//	and only once.
+//----------------------------------------------------------------------
+
+JoinRecord *
+AddrSpace::TakeChild(int id)
+{
+    for (JoinRecord **p = &children; *p != NULL; p = &(*p)->next) {
+        if ((*p)->id == id) {
+            JoinRecord *child = *p;
+
+            *p = child->next;
+            return child;
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// JoinRecord::JoinRecord
+// 	Initialize the record of a program being started by another: it
+//	hasn't exited, and both it and its parent have the record.
+//----------------------------------------------------------------------
+
+JoinRecord::JoinRecord()
+{
+    id = -1;				// until Kernel::Exec
+    status = -1;			// unless it calls Exit
+    exited = new Semaphore("exited", 0);
+    next = NULL;
+    refs = 2;
+}
+
+//----------------------------------------------------------------------
+// JoinRecord::~JoinRecord
+// 	De-allocate the record, once neither has it.
+//----------------------------------------------------------------------
+
+JoinRecord::~JoinRecord()
+{
+    delete exited;
+}
+
+//----------------------------------------------------------------------
+// JoinRecord::Exited
+// 	Called by the thread running the program as it finishes: wake
+//	the parent, if it is joining it, or let it go straight on when
+//	it does.  The thread is done with the record.
+//----------------------------------------------------------------------
+
+void
+JoinRecord::Exited()
+{
+    exited->V();
+    Release();
+}
+
+//----------------------------------------------------------------------
+// JoinRecord::Release
+// 	The program, or its parent, is done with the record; delete it
+//	if the other is too.
+//----------------------------------------------------------------------
+
+void
+JoinRecord::Release()
+{
+    ASSERT(refs > 0);
+    if (--refs == 0) {
+        delete this;
+    }
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Pin
+// 	Return where in main memory our bytes from "virtAddr" on are, so
+//	that a system call can read or write a file straight into or out
+//	of them, and set "length" to how many of the "numBytes" wanted
+//	are there: those in the pages that are in consecutive frames, up
+//	to MaxPinnedPages of them.  Each page is translated once, read
+//	in first if it isn't in memory, and given its own frame if it is
+//	copy-on-write and "writing" (the call writes into it); with
+//	demand paging, its frame is pinned, so that the page stays there
+//	while the call waits for the disk, until Unpin.  Only the first
+//	page is read in, or copied: a thread with frames pinned may not
+//	wait for another (see Pager::Evict), so the span ends before a
+//	page that needs one, and the next Pin starts there.
+//
+//	Return NULL if "virtAddr" isn't in the address space, or if
+//	"writing" and it is in a page of code.
+//----------------------------------------------------------------------
+
+char *
+AddrSpace::Pin(int virtAddr, int numBytes, bool writing, int *length)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    int offset = (unsigned) virtAddr % PageSize;
+    int firstFrame = -1;
+    int numPinned = 0;
+
+    *length = 0;
+    for (; numPinned < MaxPinnedPages && *length < numBytes; vpn++) {
+        TranslationEntry *entry;
+
+        if (vpn >= numPages) {
+            break;
+        }
+        entry = &pageTable[vpn];
+        if (numPinned > 0 && (!entry->valid
+                              || (writing && entry->readOnly))) {
+            break;			// it needs a frame
+        }
+        while (!entry->valid) {		// with demand paging, it may
+            if (kernel->pager != NULL) {	// have gone again by the
+                (void) kernel->pager->PageFault(this, vpn * PageSize);
+            } else {			// time the fault returns
+                (void) PageIn(vpn * PageSize);
+            }
+        }
+        if (writing && entry->readOnly && !CopyOnWrite(vpn * PageSize)) {
+            break;
+        }
+        if (numPinned > 0
+              && entry->physicalPage != firstFrame + numPinned) {
+            break;			// the span ends here
+        }
+        if (numPinned == 0) {
+            firstFrame = entry->physicalPage;
+        }
+        if (kernel->pager != NULL) {
+            kernel->pager->Pin(entry->physicalPage);
+        }
+        entry->use = TRUE;
+        if (writing) {
+            entry->dirty = TRUE;
+            kernel->machine->InvalidateDecoded(entry->physicalPage * PageSize,
+                                               PageSize);
+        }
+        numPinned++;
+        *length += min(PageSize - offset, numBytes - *length);
+        offset = 0;
+    }
+    if (numPinned == 0) {
+        return NULL;
+    }
+    return &kernel->machine->mainMemory[firstFrame * PageSize
+                                        + (unsigned) virtAddr % PageSize];
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Unpin
+// 	A system call is done with the "length" bytes at "span", which
+//	Pin returned: with demand paging, their frames can be taken away
+//	from their pages again.
+//----------------------------------------------------------------------
+
+void
+AddrSpace::Unpin(char *span, int length)
+{
+    int first, last;
+
+    if (kernel->pager == NULL || length <= 0) {
+        return;
+    }
+    first = (span - kernel->machine->mainMemory) / PageSize;
+    last = (span + length - 1 - kernel->machine->mainMemory) / PageSize;
+    for (int frame = first; frame <= last; frame++) {
+        kernel->pager->Unpin(frame);
+    }
+}
 
 //----------------------------------------------------------------------
 // AddrSpace::Translate
@@ -320,7 +1215,7 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
 
     *paddr = pfn*PageSize + offset;
 
-    ASSERT((*paddr < MemorySize));
+    ASSERT((*paddr < (unsigned) MemorySize));
 
     //cerr << " -- AddrSpace::Translate(): vaddr: " << vaddr <<
     //  ", paddr: " << *paddr << "\n";
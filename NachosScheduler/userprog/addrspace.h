@@ -6,6 +6,31 @@
 //	The user level CPU state is saved and restored in the thread
 //	executing the user program (see thread.h).
 //
+//	Address spaces running the same program share frames: a page
+//	that holds only code is read-only, and one frame serves them
+//	all; a page with data in it is copy-on-write -- read-only, and
+//	shared, until one of them writes to it, when it gets a copy of
+//	its own (see CopyOnWrite).
+//
+//	Each address space counts its page faults and the pages it has
+//	in memory, and estimates its working set: on every timer
+//	interrupt while it runs, the use bits of its pages are sampled
+//	(and cleared), and the pages used in the last 8 samples are its
+//	working set.  The counts go in the thread's statistics when it
+//	finishes, to be printed at halt.
+//
+//	Each address space has a table of the files its program has open
+//	(see SysOpen): a file's descriptor is where it is in the table.
+//	Descriptors 0 and 1 are the console (ConsoleInput and
+//	ConsoleOutput), and are never in it.  A system call reading or
+//	writing a file does so straight into or out of the program's
+//	pages, a span of frames at a time (see Pin).
+//
+//	A program can start others (see SysExec), and wait for them to
+//	exit (see SysJoin): each it starts has a JoinRecord, kept by the
+//	address space of the one that started it until it joins it, and
+//	by the thread running it until it finishes.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -15,8 +40,44 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "noff.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define MaxOpenFiles		16	// descriptors, the console's among them
+#define MaxPinnedPages		8	// the most pages Pin gives at once
+
+class SharedImage;
+class Executable;
+class ThreadStats;
+class Semaphore;
+class PipeEnd;
+class SyscallRing;
+
+// What a program started by another hands back to it when it exits:
+// how it exited, and a semaphore for the other to wait on.  Whichever
+// of the two is done with it last deletes it.
+
+class JoinRecord {
+  public:
+    JoinRecord();			// not exited yet
+    ~JoinRecord();
+
+    void Exited();			// called by the thread, finishing
+    void Release();			// one of the two is done with it
+
+    int id;				// the thread's ID
+    int status;				// what it gave Exit, or -1
+    Semaphore *exited;			// V'd when it finishes
+    JoinRecord *next;			// the next child of the same parent
+
+  private:
+    int refs;				// of the two, who still has it
+};
+
+// Whether a page is shared with other address spaces running the same
+// program.
+
+enum PageKind { PrivatePage, SharedPage, CopyOnWritePage };
 
 class AddrSpace {
   public:
@@ -31,9 +92,60 @@ class AddrSpace {
 					// assumes the program has already
                                         // been loaded
 
+    void Checkpoint(int fd);		// write the page table to a file
+    void Restore(int fd);		// read one back, and take its frames
+    void Resume();			// run a restored program, from the
+					// registers its thread was given
+
     void SaveState();			// Save/restore address space-specific
     void RestoreState();		// info on a context switch 
 
+    bool RefillTLB(int virtAddr);	// load the translation of
+					// "virtAddr" into the TLB
+    bool CopyOnWrite(int virtAddr);	// give the page holding "virtAddr"
+					// a frame of its own, to write to
+    bool PageIn(int virtAddr);		// read it in, the first time it is
+					// touched
+
+    void SampleWorkingSet();		// on a timer interrupt, note which
+					// pages were used since the last one
+    void Finished(ThreadStats *record);	// put our counts in the statistics
+					// of the thread that ran us
+
+    int Attach(OpenFile *file);		// give an open file a descriptor;
+					// -1 if none is free
+    OpenFile *FileFor(int id);		// the file open as "id", or NULL
+    OpenFile *Detach(int id);		// take it out of the table, and
+					// return it, or NULL
+    void CloseFiles();			// close every file, and pipe end,
+					// still open
+    int AttachPipe(PipeEnd *end);	// give a pipe end a descriptor;
+					// -1 if none is free
+    PipeEnd *PipeFor(int id);		// the pipe end open as "id", or NULL
+    PipeEnd *DetachPipe(int id);	// take it out of the table
+    void InheritPipes(AddrSpace *parent);	// have the pipe ends
+					// "parent" has, as the same
+					// descriptors
+
+    SyscallRing *Ring() { return ring; }
+					// our program's ring of system
+					// calls, or NULL
+    void SetRing(SyscallRing *newRing) { ring = newRing; }
+
+    void AddChild(JoinRecord *child);	// our program started another
+    JoinRecord *TakeChild(int id);	// the record of the one with thread
+					// "id", for joining it; NULL if it
+					// isn't one of ours, or was joined
+
+    char *Pin(int virtAddr, int numBytes, bool writing, int *length);
+					// the span of main memory holding
+					// our bytes from "virtAddr" on, as
+					// many of "numBytes" as are in
+					// consecutive frames, kept there
+					// until Unpin; NULL if "virtAddr"
+					// isn't ours (to write, if "writing")
+    void Unpin(char *span, int length);	// done with it
+
     // Translate virtual address _vaddr_
     // to physical address _paddr_. _mode_
     // is 0 for Read, 1 for Write.
@@ -44,9 +156,52 @@ class AddrSpace {
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    int asid;				// tags our translations in the TLB
+
+    Executable *program;		// the program, to read pages in from
+    NoffHeader noffH;			// (see execcache.h), and where its
+					// segments are
+    int *swapSlots;			// where in the swap area each page
+					// was last written, or -1
+    bool *copyOnWrite;			// which pages are read-only only
+					// until they are written
+    SharedImage *image;			// the frames we share with others
+					// running the same program, or NULL
+
+    unsigned char *history;		// per page, whether it was used at
+					// each of the last 8 samples, the
+					// latest in the top bit
+    bool *pagerUse;			// use bits SampleWorkingSet cleared
+					// before the pager saw them
+    bool *sampleUse;			// and those the pager cleared before
+					// SampleWorkingSet saw them
+    int numResident;			// pages in memory now ...
+    int peakResident;			// ... and at most
+    int numFaults;			// page faults taken
+    int workingSet;			// pages in the last sample ...
+    int peakWorkingSet;			// ... the most in any ...
+    int totalWorkingSet;		// ... their sum ...
+    int numSamples;			// ... and how many samples
+
+    OpenFile *openFiles[MaxOpenFiles];	// the files open, by descriptor
+    PipeEnd *pipeEnds[MaxOpenFiles];	// and the pipe ends: a descriptor
+					// is one or the other
+    JoinRecord *children;		// started by our program, not
+					// yet joined
+    SyscallRing *ring;			// see syscallring.h
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
+    bool LoadOnDemand(char *fileName);	// Load, with demand paging
+    void FillPage(int virtualPage, char *frame);
+					// read a page in from the program's
+					// file
+    void InitUsage();			// start counting, once the page
+					// table is built
+    void CountResident(int change);	// pages have come into memory, or
+					// gone from it
+
+    friend class Pager;
 
 };
 
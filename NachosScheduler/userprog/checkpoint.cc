@@ -0,0 +1,281 @@
+// checkpoint.cc
+//	Routines to write the user programs to a checkpoint file, and
+//	to start them again from one.  See checkpoint.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "checkpoint.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// ResumeProgram
+// 	The body of a restored thread: go back to running its program.
+//----------------------------------------------------------------------
+
+static void
+ResumeProgram(Thread *thread)
+{
+    thread->space->Resume();
+}
+
+//----------------------------------------------------------------------
+// CheckpointWriter::CheckpointWriter
+// 	Arrange to write a checkpoint.
+//
+//	"fileName" is the file to write it to.
+//	"when" is the earliest tick to take it at.
+//----------------------------------------------------------------------
+
+CheckpointWriter::CheckpointWriter(char *fileName, int when)
+{
+    file = fileName;
+    tick = when;
+    done = FALSE;
+}
+
+//----------------------------------------------------------------------
+// CheckpointWriter::Quiescent
+// 	Return TRUE if the running thread, which is between two
+//	instructions of its program, and whatever is ready to run are
+//	all there is, and all of them are user programs interrupted
+//	between two instructions.  A thread in the middle of a system
+//	call, waiting for a device or a lock, or a thread of the kernel's
+//	own, has state a checkpoint can't hold.
+//----------------------------------------------------------------------
+
+bool
+CheckpointWriter::Quiescent()
+{
+    ThreadTable *threads = kernel->threads;
+    int numReady = 0;
+
+    for (int id = 0; id < threads->Size(); id++) {
+        Thread *thread = threads->Lookup(id);
+
+        if (thread == NULL || thread == kernel->currentThread) {
+            continue;
+        }
+        if (thread->getStatus() != READY || !thread->betweenInstructions) {
+            return FALSE;
+        }
+        numReady++;
+    }
+    return (numReady == kernel->currentCPU->readyQueue->NumReady());
+}
+
+//----------------------------------------------------------------------
+// CheckpointWriter::Poll
+// 	Called by Machine::Run after each interrupt, between two user
+//	instructions.  If it's time for the checkpoint, and it can be
+//	taken, write it: the header, each program (the running one first,
+//	then the rest in the order they became ready), and main memory.
+//----------------------------------------------------------------------
+
+void
+CheckpointWriter::Poll()
+{
+    Statistics *stats = kernel->stats;
+    CheckpointHeader header;
+    Thread **order;
+    int numThreads = 0;
+    int fd;
+
+    if (done || stats->totalTicks < tick || !Quiescent()) {
+        return;
+    }
+    ASSERT(kernel->currentCPU->userThread == kernel->currentThread);
+					// its registers are in the Machine
+    order = new Thread *[kernel->threads->NumThreads()];
+    order[numThreads++] = kernel->currentThread;
+    for (int id = 0; id < kernel->threads->Size(); id++) {
+        Thread *thread = kernel->threads->Lookup(id);
+        int i;
+
+        if (thread == NULL || thread == kernel->currentThread) {
+            continue;
+        }
+        for (i = numThreads; i > 1 && order[i - 1]->getStartReadyTime()
+                                  > thread->getStartReadyTime(); i--) {
+            order[i] = order[i - 1];
+        }
+        order[i] = thread;
+        numThreads++;
+    }
+
+    header.magic = CheckpointMagic;
+    header.memorySize = MemorySize;
+    header.pageSize = PageSize;
+    header.numThreads = numThreads;
+    header.memoryOffset = 0;		// filled in below
+    header.totalTicks = stats->totalTicks;
+    header.idleTicks = stats->idleTicks;
+    header.systemTicks = stats->systemTicks;
+    header.userTicks = stats->userTicks;
+
+    fd = OpenForWrite(file);
+    WriteFile(fd, (char *) &header, sizeof(header));
+    for (int i = 0; i < numThreads; i++) {
+        Write(order[i], fd);
+    }
+    header.memoryOffset = divRoundUp(Tell(fd), CheckpointAlign)
+                              * CheckpointAlign;
+    Lseek(fd, header.memoryOffset, 0);
+    WriteFile(fd, kernel->machine->mainMemory, MemorySize);
+    Lseek(fd, 0, 0);
+    WriteFile(fd, (char *) &header, sizeof(header));
+    Close(fd);
+    delete [] order;
+
+    cout << "Checkpoint of " << numThreads << " programs written to "
+         << file << " at tick " << stats->totalTicks << "\n";
+    done = TRUE;
+}
+
+//----------------------------------------------------------------------
+// CheckpointWriter::Write
+// 	Write out one program: its thread, its registers, and its page
+//	table.
+//----------------------------------------------------------------------
+
+void
+CheckpointWriter::Write(Thread *thread, int fd)
+{
+    CheckpointThread saved;
+    ThreadStats *threadStats = thread->getSchedStats();
+
+    saved.id = thread->getID();
+    strncpy(saved.name, thread->getName(), CheckpointNameSize - 1);
+    saved.name[CheckpointNameSize - 1] = '\0';
+    saved.priority = thread->getBasePriority();
+    saved.burstTime = thread->getBurstTime();
+    saved.vruntime = thread->getVRuntime();
+    saved.level = thread->getLevel();
+    saved.levelTime = thread->getLevelTime();
+    saved.startReadyTime = thread->getStartReadyTime();
+    saved.created = threadStats->created;
+    saved.firstRun = threadStats->firstRun;
+    saved.totalWait = threadStats->totalWait;
+    saved.numSwitches = threadStats->numSwitches;
+    for (int i = 0; i < NumTotalRegs; i++) {
+        saved.registers[i] = (thread == kernel->currentThread)
+                                 ? kernel->machine->ReadRegister(i)
+                                 : thread->userRegisters[i];
+    }
+    WriteFile(fd, (char *) &saved, sizeof(saved));
+    thread->space->Checkpoint(fd);
+}
+
+//----------------------------------------------------------------------
+// CheckpointReader::CheckpointReader
+// 	Open a checkpoint, and check that this Nachos can run it.
+//----------------------------------------------------------------------
+
+CheckpointReader::CheckpointReader(char *fileName)
+{
+    fd = OpenForReadWrite(fileName, TRUE);
+    Read(fd, (char *) &header, sizeof(header));
+    ASSERT(header.magic == CheckpointMagic);
+    ASSERT(header.memorySize == MemorySize);	// same machine
+    ASSERT(header.pageSize == PageSize);
+}
+
+//----------------------------------------------------------------------
+// CheckpointReader::~CheckpointReader
+// 	Close the checkpoint.
+//----------------------------------------------------------------------
+
+CheckpointReader::~CheckpointReader()
+{
+    Close(fd);
+}
+
+//----------------------------------------------------------------------
+// CheckpointReader::RestoreTime
+// 	Start the clock at the tick the checkpoint was taken, with the
+//	ticks it had counted.  Done as soon as the statistics exist, so
+//	that the timer and the devices start from there.
+//----------------------------------------------------------------------
+
+void
+CheckpointReader::RestoreTime(Statistics *stats)
+{
+    stats->totalTicks = header.totalTicks;
+    stats->idleTicks = header.idleTicks;
+    stats->systemTicks = header.systemTicks;
+    stats->userTicks = header.userTicks;
+}
+
+//----------------------------------------------------------------------
+// CheckpointReader::RestorePrograms
+// 	Bring back main memory and each program in the checkpoint, and
+//	make them ready to run, in the order they were saved in.  Called
+//	by the main thread before it starts any other.
+//
+//	Each thread gets the ID it had.  The IDs are handed out lowest
+//	first, so the ones between are taken too, and given back when
+//	all the programs are in the table.
+//----------------------------------------------------------------------
+
+void
+CheckpointReader::RestorePrograms()
+{
+    CheckpointThread *saved = new CheckpointThread[header.numThreads];
+    Thread **restored = new Thread *[header.numThreads];
+    int *ids = new int[header.numThreads];
+    List<int> skipped;
+    int i, j;
+
+    for (i = 0; i < header.numThreads; i++) {
+        char *name = new char[CheckpointNameSize];	// kept, as a
+							// thread's name is
+        Read(fd, (char *) &saved[i], sizeof(CheckpointThread));
+        strcpy(name, saved[i].name);
+        restored[i] = new Thread(name, saved[i].id, saved[i].priority);
+        restored[i]->space = new AddrSpace();
+        restored[i]->space->Restore(fd);
+        for (j = i; j > 0 && ids[j - 1] > saved[i].id; j--) {
+            ids[j] = ids[j - 1];
+        }
+        ids[j] = saved[i].id;
+    }
+    kernel->machine->LoadMemory(fd, header.memoryOffset);
+
+    for (i = 0; i < header.numThreads; i++) {	// smallest ID first
+        int id;
+
+        while ((id = kernel->threads->NewID()) < ids[i]) {
+            skipped.Prepend(id);		// highest first
+        }
+        ASSERT(id == ids[i]);
+    }
+    for (i = 0; i < header.numThreads; i++) {
+        Thread *thread = restored[i];
+        ThreadStats *threadStats = thread->getSchedStats();
+
+        threadStats->created = saved[i].created;
+        threadStats->firstRun = saved[i].firstRun;
+        threadStats->totalWait = saved[i].totalWait;
+        threadStats->numSwitches = saved[i].numSwitches;
+        for (j = 0; j < NumTotalRegs; j++) {
+            thread->userRegisters[j] = saved[i].registers[j];
+        }
+        kernel->threads->Enter(saved[i].id, thread);
+        kernel->predictor->ThreadStart(thread);
+        thread->setBurstTime(saved[i].burstTime);
+        thread->setVRuntime(saved[i].vruntime);
+        thread->setLevel(saved[i].level, saved[i].levelTime);
+        cout << "Thread " << saved[i].id << "\t" << thread->getName()
+             << "\t\t(restored, Pri: " << saved[i].priority << ")\n";
+        thread->Fork((VoidFunctionPtr) &ResumeProgram, (void *) thread);
+        thread->setStartReadyTime(saved[i].startReadyTime);
+    }
+    while (!skipped.IsEmpty()) {		// lowest ends up first
+        kernel->threads->Remove(skipped.RemoveFront());
+    }
+    delete [] saved;
+    delete [] restored;
+    delete [] ids;
+}
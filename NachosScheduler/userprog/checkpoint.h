@@ -0,0 +1,119 @@
+// checkpoint.h
+//	Data structures to save the user programs running on Nachos
+//	to a file, and to start a later run from that file instead of
+//	from the beginning.
+//
+//	"-ckpt <file> <tick>" writes a checkpoint at the first moment,
+//	at or after <tick>, that it can be done: when every thread is
+//	a user program that was interrupted between two instructions
+//	(in Machine::Run), so that its user registers and its address
+//	space are all there is to it.  Until then -- while a program is
+//	in a system call, or waiting for the console, say -- it is
+//	retried after each interrupt.  The run goes on afterwards.
+//
+//	"-restore <file>" starts the run at the tick the checkpoint was
+//	taken: main memory is mapped from the file (see
+//	Machine::LoadMemory), and each program gets back its thread ID,
+//	registers, page table and scheduling state, and is made ready
+//	again, in the order it would next have run.  Programs given with
+//	-e start after them, as usual.
+//
+//	What the kernel was doing for itself is not saved: -K tests,
+//	jobs of a --test workload yet to arrive, the random numbers -rs
+//	would have drawn, a thread's burst history and the rest of its
+//	time slice.  So the programs go on exactly where they were, but
+//	the schedule from there may differ from the one the first run
+//	followed.  Checkpoints are for a uniprocessor only.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "copyright.h"
+#include "machine.h"
+#include "stats.h"
+
+const int CheckpointMagic = 0x4e434b33;	// "NCK3", at the start of the file
+const int CheckpointNameSize = 64;	// room for a program name
+const int CheckpointAlign = 65536;	// main memory starts at a multiple
+					// of this, so any host can map it
+
+// The start of a checkpoint file.
+
+class CheckpointHeader {
+  public:
+    int magic;
+    int memorySize;		// MemorySize when it was written
+    int pageSize;		// and PageSize
+    int numThreads;		// CheckpointThreads that follow
+    int memoryOffset;		// where main memory is in the file
+    int totalTicks;		// the statistics at the time
+    int idleTicks;
+    int systemTicks;
+    int userTicks;
+};
+
+// One user program, as it appears in the file: the thread running
+// it, followed by its page table (see AddrSpace::Checkpoint).
+
+class CheckpointThread {
+  public:
+    int id;
+    char name[CheckpointNameSize];
+    int priority;		// given by setPriority
+    double burstTime;		// the scheduler's ...
+    double vruntime;
+    int level;
+    int levelTime;
+    int startReadyTime;		// ... state for it
+    int created;		// from its ThreadStats
+    int firstRun;
+    int totalWait;
+    int numSwitches;
+    int registers[NumTotalRegs];
+};
+
+class Thread;
+
+// The following class writes a checkpoint, once it can (-ckpt).
+
+class CheckpointWriter {
+  public:
+    CheckpointWriter(char *fileName, int when);
+				// take a checkpoint at tick "when"
+    void Poll();		// called between user instructions;
+				// takes it, if the time has come and
+				// nothing is in the way
+
+  private:
+    char *file;
+    int tick;			// when to take it
+    bool done;			// it's been taken
+
+    bool Quiescent();		// could we take it now?
+    void Write(Thread *thread, int fd);
+				// save one program
+};
+
+// The following class starts a run from a checkpoint (-restore).
+
+class CheckpointReader {
+  public:
+    CheckpointReader(char *fileName);	// open the file
+    ~CheckpointReader();		// close it
+
+    void RestoreTime(Statistics *stats);
+				// set the clock to the checkpoint's;
+				// before anything schedules interrupts
+    void RestorePrograms();	// bring back memory and the programs,
+				// ready to run
+
+  private:
+    int fd;
+    CheckpointHeader header;
+};
+
+#endif // CHECKPOINT_H
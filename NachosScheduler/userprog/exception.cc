@@ -4,8 +4,13 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel: Halt, Exit, Exec, Join, PrintInt, PutString,
+//	Sleep, Nice, Add, the file operations Create, Open, Read, Write,
+//	Close and Pipe, and RingSetup and RingEnter, to make calls from a
+//	ring in the program's memory (see syscallring.h).  Each is looked
+//	up in a table, by its code (see RegisterSyscalls), which also
+//	counts how often it is called, and what it costs; the counts are
+//	printed at halt.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +19,7 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Any other system call core dumps.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -23,8 +27,283 @@
 
 #include "copyright.h"
 #include "main.h"
-#include "syscall.h"
-#include "ksyscall.h"
+#include "ksyscall.h"		// first: syscall.h's ConsoleInput would
+#include "syscall.h"		// hide console.h's
+#include "pager.h"
+
+// A system call's handler: given the arguments, from r4 to r6, return
+// the result, to go in r2.
+
+typedef int (*SyscallHandler)(int arg1, int arg2, int arg3);
+
+// A system call, and what it has cost so far.
+
+class SyscallEntry {
+  public:
+    const char *name;		// NULL if there is no such call
+    SyscallHandler handler;
+    bool ringable;		// can it be made from a ring?
+    int numCalls;		// calls so far ...
+    int numRingCalls;		// ... how many made from a ring ...
+    int ticks;			// ... the simulated time they took ...
+    double hostTime;		// ... and the host's, in seconds
+};
+
+const int NumSyscallCodes = SC_Nice + 1;	// the highest code, and one
+
+static SyscallEntry syscalls[NumSyscallCodes];
+static bool registered = FALSE;		// until RegisterSyscalls
+
+static int DoHalt(int, int, int)
+{
+    DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
+    SysHalt();
+    ASSERTNOTREACHED();
+    return 0;
+}
+
+static int DoExit(int status, int, int)
+{
+    DEBUG(dbgAddr, "Program exit\n");
+    SysExit(status);
+    ASSERTNOTREACHED();
+    return 0;
+}
+
+static int DoExec(int name, int, int) { return SysExec(name); }
+
+static int DoJoin(int id, int, int) { return SysJoin(id); }
+
+static int DoPrintInt(int number, int, int)
+{
+    SysPrintInt(number);
+    return 0;
+}
+
+static int DoPutString(int string, int, int)
+{
+    SysPutString(string);
+    return 0;
+}
+
+static int DoSleep(int ticks, int, int)
+{
+    SysSleep(ticks);
+    return 0;
+}
+
+static int DoNice(int priority, int, int)
+{
+    int burst;
+
+    SysNice(priority);
+    burst = kernel->stats->totalTicks - kernel->currentThread->getStartBurst();
+    kernel->currentThread->setStartBurstTime(kernel->stats->totalTicks);
+    kernel->predictor->BurstDone(kernel->currentThread, burst);
+    return 0;
+}
+
+static int DoAdd(int op1, int op2, int)
+{
+    int result = SysAdd(op1, op2);
+
+    DEBUG(dbgSys, "Add " << op1 << " + " << op2 << " returning with "
+          << result << "\n");
+    return result;
+}
+
+static int DoCreate(int name, int, int) { return SysCreate(name); }
+
+static int DoOpen(int name, int, int) { return SysOpen(name); }
+
+static int DoRead(int buffer, int size, int id)
+{
+    return SysRead(buffer, size, id);
+}
+
+static int DoWrite(int buffer, int size, int id)
+{
+    return SysWrite(buffer, size, id);
+}
+
+static int DoClose(int id, int, int) { return SysClose(id); }
+
+static int DoPipe(int ids, int, int) { return SysPipe(ids); }
+
+static int DoRingSetup(int ring, int flags, int)
+{
+    return SysRingSetup(ring, flags);
+}
+
+static int DoRingEnter(int minResults, int, int)
+{
+    return SysRingEnter(minResults);
+}
+
+//----------------------------------------------------------------------
+// Register
+// 	Put the system call with code "code" in the table; "ringable" if
+//	a program may make it from a ring, as it only acts on files,
+//	pipes and the console, not on the thread calling it.
+//----------------------------------------------------------------------
+
+static void
+Register(int code, const char *name, SyscallHandler handler, bool ringable)
+{
+    ASSERT(code >= 0 && code < NumSyscallCodes);
+    syscalls[code].name = name;
+    syscalls[code].handler = handler;
+    syscalls[code].ringable = ringable;
+    syscalls[code].numCalls = syscalls[code].numRingCalls = 0;
+    syscalls[code].ticks = 0;
+    syscalls[code].hostTime = 0.0;
+}
+
+//----------------------------------------------------------------------
+// RegisterSyscalls
+// 	Fill in the table of the system calls there are, the first time
+//	one is made.  To add one, give it a code in syscall.h, a stub in
+//	test/start.S, and a handler here.
+//----------------------------------------------------------------------
+
+static void
+RegisterSyscalls()
+{
+    for (int code = 0; code < NumSyscallCodes; code++) {
+        syscalls[code].name = NULL;
+    }
+    Register(SC_Halt, "Halt", DoHalt, FALSE);
+    Register(SC_Exit, "Exit", DoExit, FALSE);
+    Register(SC_Exec, "Exec", DoExec, FALSE);
+    Register(SC_Join, "Join", DoJoin, FALSE);
+    Register(SC_Create, "Create", DoCreate, TRUE);
+    Register(SC_Open, "Open", DoOpen, TRUE);
+    Register(SC_Read, "Read", DoRead, TRUE);
+    Register(SC_Write, "Write", DoWrite, TRUE);
+    Register(SC_Close, "Close", DoClose, TRUE);
+    Register(SC_Pipe, "Pipe", DoPipe, TRUE);
+    Register(SC_RingSetup, "RingSetup", DoRingSetup, FALSE);
+    Register(SC_RingEnter, "RingEnter", DoRingEnter, FALSE);
+    Register(SC_PutString, "PutString", DoPutString, TRUE);
+    Register(SC_Sleep, "Sleep", DoSleep, FALSE);
+    Register(SC_Add, "Add", DoAdd, TRUE);
+    Register(SC_PrintInt, "PrintInt", DoPrintInt, TRUE);
+    Register(SC_Nice, "Nice", DoNice, FALSE);
+    registered = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Call
+// 	Call the handler of a system call, and count the call, and what
+//	it cost.
+//----------------------------------------------------------------------
+
+static int
+Call(SyscallEntry *entry, int arg1, int arg2, int arg3)
+{
+    int startTicks = kernel->stats->totalTicks;
+    double startTime = HostTime();
+    int result;
+
+    entry->numCalls++;			// before: Halt and Exit don't return
+    result = (*entry->handler)(arg1, arg2, arg3);
+    entry->ticks += kernel->stats->totalTicks - startTicks;
+    entry->hostTime += HostTime() - startTime;
+    return result;
+}
+
+//----------------------------------------------------------------------
+// Syscall
+// 	Make the system call the user program asked for, with code
+//	"type": call its handler, put the result in r2, and move the
+//	program counter on past the syscall instruction (or else the
+//	same call is made again, for ever).  Count the call, and what it
+//	cost.  Return FALSE if there is no such call.
+//----------------------------------------------------------------------
+
+static bool
+Syscall(int type)
+{
+    Machine *machine = kernel->machine;
+    int result;
+
+    if (!registered) {
+        RegisterSyscalls();
+    }
+    if (type < 0 || type >= NumSyscallCodes
+          || syscalls[type].name == NULL) {
+        return FALSE;
+    }
+    result = Call(&syscalls[type], machine->ReadRegister(4),
+                  machine->ReadRegister(5), machine->ReadRegister(6));
+
+    machine->WriteRegister(2, result);
+    machine->WriteRegister(PrevPCReg, machine->ReadRegister(PCReg));
+    machine->WriteRegister(PCReg, machine->ReadRegister(PCReg) + 4);
+    machine->WriteRegister(NextPCReg, machine->ReadRegister(PCReg) + 4);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RingSyscall
+// 	Make the system call with code "code", for a request in a ring
+//	(see SyscallRing::Take), and return its result; ENOSYS if there
+//	is no such call, or it can't be made from a ring.
+//----------------------------------------------------------------------
+
+int
+RingSyscall(int code, int arg1, int arg2, int arg3)
+{
+    if (!registered) {
+        RegisterSyscalls();
+    }
+    if (code < 0 || code >= NumSyscallCodes
+          || syscalls[code].name == NULL || !syscalls[code].ringable) {
+        return ENOSYS;
+    }
+    syscalls[code].numRingCalls++;
+    return Call(&syscalls[code], arg1, arg2, arg3);
+}
+
+//----------------------------------------------------------------------
+// PrintSyscalls
+// 	Print, when Nachos halts, how often each system call was made,
+//	the simulated time the calls took (including the time waiting
+//	for a device, or for other threads), and the host's; and how many
+//	of the calls were made from a ring.
+//----------------------------------------------------------------------
+
+void
+PrintSyscalls()
+{
+    bool any = FALSE;
+
+    if (!registered) {
+        return;				// no user program made one
+    }
+    for (int code = 0; code < NumSyscallCodes; code++) {
+        SyscallEntry *entry = &syscalls[code];
+        char host[32];
+
+        if (entry->name == NULL || entry->numCalls == 0) {
+            continue;
+        }
+        if (!any) {
+            cout << "System calls:\n";
+            any = TRUE;
+        }
+        sprintf(host, "%.6f", entry->hostTime);
+        cout << "    " << entry->name << ": " << entry->numCalls
+             << " calls, " << entry->ticks << " ticks ("
+             << entry->ticks / entry->numCalls << " each), " << host
+             << " s on the host";
+        if (entry->numRingCalls > 0) {
+            cout << ", " << entry->numRingCalls << " from a ring";
+        }
+        cout << "\n";
+    }
+}
+
 //----------------------------------------------------------------------
 // ExceptionHandler
 // 	Entry point into the Nachos kernel.  Called when a user program
@@ -41,9 +320,6 @@
 //
 //	The result of the system call, if any, must be put back into r2. 
 //
-// If you are handling a system call, don't forget to increment the pc
-// before returning. (Or else you'll loop making the same system call forever!)
-//
 //	"which" is the kind of exception.  The list of possible exceptions 
 //	is in machine.h.
 //----------------------------------------------------------------------
@@ -52,73 +328,40 @@
 ExceptionHandler(ExceptionType which)
 {
     int type = kernel->machine->ReadRegister(2);
-    int val;
-    int status, exit, threadID, programID;
     DEBUG(dbgSys, "Received Exception " << which << " type: " << type << "\n");
     switch (which) {
         case SyscallException:
-            switch(type) {
-                case SC_Halt:
-                    DEBUG(dbgSys, "Shutdown, initiated by user program.\n");
-                    SysHalt();
-                    ASSERTNOTREACHED();
-                    break;
-                case SC_PrintInt:
-                    val=kernel->machine->ReadRegister(4);
-                    SysPrintInt(val);
-                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-                    return;
-                    ASSERTNOTREACHED();
-                    break;
-                case SC_Nice:
-                    val=kernel->machine->ReadRegister(4);
-                    SysNice(val);
-                    
-                    double predicted;
-                    predicted = kernel->currentThread->getBurstTime() * 0.5 + (kernel->stats->totalTicks - kernel->currentThread->getStartBurst()) * 0.5;
-                    kernel->currentThread->setStartBurstTime(kernel->stats->totalTicks);
-                    kernel->currentThread->setBurstTime(predicted);
-
-                    kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-                    kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-                    return;
-                    ASSERTNOTREACHED();
-                    break;
-                case SC_Add:
-                    DEBUG(dbgSys, "Add " << kernel->machine->ReadRegister(4) << " + " << kernel->machine->ReadRegister(5) << "\n");
-                    /* Process SysAdd Systemcall*/
-                    int result;
-                    result = SysAdd(/* int op1 */(int)kernel->machine->ReadRegister(4),
-                                    /* int op2 */(int)kernel->machine->ReadRegister(5));
-                    DEBUG(dbgSys, "Add returning with " << result << "\n");
-                    /* Prepare Result */
-                    kernel->machine->WriteRegister(2, (int)result);	
-                    /* Modify return point */
-                    {
-                        /* set previous programm counter (debugging only)*/
-                        kernel->machine->WriteRegister(PrevPCReg, kernel->machine->ReadRegister(PCReg));
-
-                        /* set programm counter to next instruction (all Instructions are 4 byte wide)*/
-                        kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
-
-                        /* set next programm counter for brach execution */
-                        kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
-                    }
-                    cout << "result is " << result << "\n";	
-                    return;	
-                    ASSERTNOTREACHED();
-                    break;
-                case SC_Exit:
-                    DEBUG(dbgAddr, "Program exit\n");
-                    val=kernel->machine->ReadRegister(4);
-                    cout << "return value:" << val << endl;
-                    kernel->currentThread->Finish();
-                    break;
-                default:
-                    cerr << "Unexpected system call " << type << "\n";
-                    break;
+            if (Syscall(type)) {
+                return;
+            }
+            cerr << "Unexpected system call " << type << "\n";
+            break;
+        case PageFaultException:
+            if (kernel->machine->tlb != NULL
+                  && kernel->currentThread->space->RefillTLB(
+                        kernel->machine->ReadRegister(BadVAddrReg))) {
+                return;		// a TLB miss: run the instruction again
+            }
+            if (kernel->pager != NULL
+                  && kernel->pager->PageFault(kernel->currentThread->space,
+                        kernel->machine->ReadRegister(BadVAddrReg))) {
+                return;		// paged in: run it again
+            }
+            if (kernel->pager == NULL
+                  && kernel->currentThread->space->PageIn(
+                        kernel->machine->ReadRegister(BadVAddrReg))) {
+                return;		// touched for the first time: the same
+            }
+            cerr << "Unexpected page fault at "
+                 << kernel->machine->ReadRegister(BadVAddrReg) << "\n";
+            break;
+        case ReadOnlyException:
+            if (kernel->currentThread->space->CopyOnWrite(
+                    kernel->machine->ReadRegister(BadVAddrReg))) {
+                return;		// its own copy now: run it again
             }
+            cerr << "Write to read-only page at "
+                 << kernel->machine->ReadRegister(BadVAddrReg) << "\n";
             break;
         default:
             cerr << "Unexpected user mode exception " << (int)which << "\n";
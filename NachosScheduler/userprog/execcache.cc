@@ -0,0 +1,277 @@
+// execcache.cc
+//	Routines to keep the user programs Nachos has run in memory.
+//	See execcache.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "execcache.h"
+#include "main.h"
+#include "filesys.h"
+#include "machine.h"
+
+//----------------------------------------------------------------------
+// SwapHeader
+// 	Do little endian to big endian conversion on the bytes in the
+//	object file header, in case the file was generated on a little
+//	endian machine, and we're now running on a big endian machine.
+//	A little endian host never needs to, so it isn't compiled there.
+//----------------------------------------------------------------------
+
+#ifdef HOST_IS_BIG_ENDIAN
+static void
+SwapHeader (NoffHeader *noffH)
+{
+    noffH->noffMagic = WordToHost(noffH->noffMagic);
+    noffH->code.size = WordToHost(noffH->code.size);
+    noffH->code.virtualAddr = WordToHost(noffH->code.virtualAddr);
+    noffH->code.inFileAddr = WordToHost(noffH->code.inFileAddr);
+#ifdef RDATA
+    noffH->readonlyData.size = WordToHost(noffH->readonlyData.size);
+    noffH->readonlyData.virtualAddr =
+           WordToHost(noffH->readonlyData.virtualAddr);
+    noffH->readonlyData.inFileAddr =
+           WordToHost(noffH->readonlyData.inFileAddr);
+#endif
+    noffH->initData.size = WordToHost(noffH->initData.size);
+    noffH->initData.virtualAddr = WordToHost(noffH->initData.virtualAddr);
+    noffH->initData.inFileAddr = WordToHost(noffH->initData.inFileAddr);
+    noffH->uninitData.size = WordToHost(noffH->uninitData.size);
+    noffH->uninitData.virtualAddr = WordToHost(noffH->uninitData.virtualAddr);
+    noffH->uninitData.inFileAddr = WordToHost(noffH->uninitData.inFileAddr);
+
+#ifdef RDATA
+    DEBUG(dbgAddr, "code = " << noffH->code.size <<
+                   " readonly = " << noffH->readonlyData.size <<
+                   " init = " << noffH->initData.size <<
+                   " uninit = " << noffH->uninitData.size << "\n");
+#endif
+}
+#endif // HOST_IS_BIG_ENDIAN
+
+//----------------------------------------------------------------------
+// Executable::Executable
+// 	Initialize a program read from "fileName", last changed at
+//	"modified" when it was "length" bytes long.  The header and the
+//	contents are filled in by ExecCache::Read.
+//----------------------------------------------------------------------
+
+Executable::Executable(char *fileName, long modified, int length)
+{
+    name = new char[strlen(fileName) + 1];
+    strcpy(name, fileName);
+    this->modified = modified;
+    this->length = length;
+    contents = NULL;
+    size = 0;
+    users = 0;
+    cached = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Executable::~Executable
+// 	De-allocate a program no one is running.
+//----------------------------------------------------------------------
+
+Executable::~Executable()
+{
+    delete [] name;
+    delete [] contents;
+}
+
+//----------------------------------------------------------------------
+// Executable::ReadSegment
+// 	Copy the part of "segment" of the program that is in the page
+//	starting at virtual address "pageStart" into "frame".
+//----------------------------------------------------------------------
+
+void
+Executable::ReadSegment(Segment *segment, int pageStart, char *frame)
+{
+    int start = max(segment->virtualAddr, pageStart);
+    int end = min(segment->virtualAddr + segment->size, pageStart + PageSize);
+
+    if (start < end) {
+	ASSERT(segment->inFileAddr + (end - segment->virtualAddr) <= size);
+	bcopy(&contents[segment->inFileAddr + (start - segment->virtualAddr)],
+	      &frame[start - pageStart], end - start);
+    }
+}
+
+//----------------------------------------------------------------------
+// ExecCache::ExecCache
+// 	Initialize an empty cache, to keep "budget" bytes of programs.
+//----------------------------------------------------------------------
+
+ExecCache::ExecCache(int budget)
+{
+    programs = new List<Executable *>;
+    this->budget = budget;
+    size = 0;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::~ExecCache
+// 	De-allocate the cache, and the programs in it.  Those still
+//	being run go with their address spaces.
+//----------------------------------------------------------------------
+
+ExecCache::~ExecCache()
+{
+    while (!programs->IsEmpty()) {
+	Executable *program = programs->RemoveFront();
+
+	if (program->users == 0) {
+	    delete program;
+	} else {
+	    program->cached = FALSE;
+	}
+    }
+    delete programs;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Get
+// 	Return the program in "fileName", for an address space to run,
+//	from the cache if it's there and the file hasn't changed since,
+//	and otherwise from the file.  Return NULL if there is no such
+//	file.  The address space must Release it when it is done.
+//----------------------------------------------------------------------
+
+Executable *
+ExecCache::Get(char *fileName)
+{
+    Executable *found = NULL;
+    OpenFile *file = NULL;
+    long modified = 0;
+    int length;
+
+#ifdef FILESYS_STUB
+    if (!StatFile(fileName, &modified, &length)) {
+	return NULL;
+    }
+#else
+    if ((file = kernel->fileSystem->Open(fileName)) == NULL) {
+	return NULL;
+    }
+    length = file->Length();
+#endif
+    for (ListIterator<Executable *> iter(programs); !iter.IsDone();
+	 iter.Next()) {
+	if (strcmp(iter.Item()->name, fileName) == 0) {
+	    found = iter.Item();
+	    break;
+	}
+    }
+    if (found != NULL
+	  && (found->modified != modified || found->length != length)) {
+	DEBUG(dbgAddr, "Program " << fileName << " changed; reading it again");
+	programs->Remove(found);	// a new one is going in
+	size -= found->size;
+	found->cached = FALSE;
+	if (found->users == 0) {
+	    delete found;
+	}
+	found = NULL;
+    }
+
+    if (found != NULL) {
+	programs->Remove(found);	// the most recent now
+	kernel->stats->numExecsCached++;
+    } else {
+	if (file == NULL && (file = kernel->fileSystem->Open(fileName)) == NULL) {
+	    return NULL;
+	}
+	found = Read(file, fileName, modified, length);
+	size += found->size;
+	kernel->stats->numExecsRead++;
+    }
+    programs->Prepend(found);
+    found->users++;
+    delete file;
+    Trim();
+    return found;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Read
+// 	Read the program in "file", "fileName", from it: its header, and
+//	the bytes up to the end of the last segment in the file.
+//----------------------------------------------------------------------
+
+Executable *
+ExecCache::Read(OpenFile *file, char *fileName, long modified, int length)
+{
+    Executable *program = new Executable(fileName, modified, length);
+    NoffHeader *noffH = &program->noffH;
+    int end;
+
+    file->ReadAt((char *) noffH, sizeof(NoffHeader), 0);
+#ifdef HOST_IS_BIG_ENDIAN
+    if ((noffH->noffMagic != NOFFMAGIC) &&
+		(WordToHost(noffH->noffMagic) == NOFFMAGIC))
+    	SwapHeader(noffH);
+#endif
+    ASSERT(noffH->noffMagic == NOFFMAGIC);
+
+    end = noffH->code.inFileAddr + noffH->code.size;
+    end = max(end, noffH->initData.inFileAddr + noffH->initData.size);
+#ifdef RDATA
+    end = max(end, noffH->readonlyData.inFileAddr + noffH->readonlyData.size);
+#endif
+    program->size = end;
+    program->contents = new char[end];
+    file->ReadAt(program->contents, end, 0);
+    DEBUG(dbgAddr, "Read program " << fileName << ", " << end << " bytes");
+    return program;
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Release
+// 	An address space running "program" is done with it.  It stays
+//	in the cache, for the next to run it, if it fits in the budget.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Release(Executable *program)
+{
+    ASSERT(program->users > 0);
+    program->users--;
+    if (!program->cached) {
+	if (program->users == 0) {
+	    delete program;
+	}
+    } else {
+	Trim();
+    }
+}
+
+//----------------------------------------------------------------------
+// ExecCache::Trim
+// 	Drop the least recently used programs no one is running, until
+//	those kept fit in the budget.
+//----------------------------------------------------------------------
+
+void
+ExecCache::Trim()
+{
+    while (size > budget) {
+	Executable *victim = NULL;
+
+	for (ListIterator<Executable *> iter(programs); !iter.IsDone();
+	     iter.Next()) {
+	    if (iter.Item()->users == 0) {
+		victim = iter.Item();	// the last one, in the end
+	    }
+	}
+	if (victim == NULL) {		// all in use
+	    return;
+	}
+	DEBUG(dbgAddr, "Dropping program " << victim->name << " from the cache");
+	programs->Remove(victim);
+	size -= victim->size;
+	delete victim;
+    }
+}
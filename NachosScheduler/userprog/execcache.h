@@ -0,0 +1,82 @@
+// execcache.h
+//	Data structures to keep the user programs Nachos has run in
+//	memory, so that running one again doesn't read it from its file.
+//
+//	A program is kept as the parsed NOFF header, and the bytes of its
+//	file the segments are read from.  AddrSpace::Load gets a program
+//	from the cache (kernel->execCache), and each page is filled from
+//	it as it is touched, until the address space is deleted and gives
+//	it back.  A program is looked up by its file's name and whether
+//	the file has changed since it was read: its modification time and
+//	length, with the stub file system, and its length with the Nachos
+//	one, which keeps no times.
+//
+//	Programs no address space is using stay cached until the cache
+//	holds more than its budget, "-xc <kilobytes>" (256 by default);
+//	then the least recently used are dropped.  With a budget of 0,
+//	only the programs running are kept.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EXECCACHE_H
+#define EXECCACHE_H
+
+#include "copyright.h"
+#include "noff.h"
+#include "list.h"
+
+class OpenFile;
+
+const int DefaultExecCacheSize = 256 * 1024;	// bytes of programs to keep
+
+// A user program, read in from its file.
+
+class Executable {
+  public:
+    Executable(char *fileName, long modified, int length);
+    ~Executable();
+
+    NoffHeader noffH;		// where its segments are in the file
+    char *contents;		// the file, up to the end of the last one
+    int size;			// bytes in "contents"
+
+    void ReadSegment(Segment *segment, int pageStart, char *frame);
+				// copy what is in a page of a segment
+
+  private:
+    char *name;			// the program's file
+    long modified;		// when it was last changed, or 0
+    int length;			// and how long it was then
+    int users;			// address spaces running it
+    bool cached;		// FALSE once dropped from the cache
+
+    friend class ExecCache;
+};
+
+// The following class keeps the programs.
+
+class ExecCache {
+  public:
+    ExecCache(int budget);	// an empty cache of "budget" bytes
+    ~ExecCache();
+
+    Executable *Get(char *fileName);
+				// the program in "fileName", read in if
+				// need be; NULL if there isn't one
+    void Release(Executable *program);
+				// an address space is done with it
+
+  private:
+    List<Executable *> *programs;	// the most recently used first
+    int budget;			// bytes of programs to keep
+    int size;			// bytes of programs kept
+
+    Executable *Read(OpenFile *file, char *fileName, long modified,
+		     int length);
+				// read a program from its file
+    void Trim();		// drop what is over the budget
+};
+
+#endif // EXECCACHE_H
@@ -0,0 +1,155 @@
+// frames.cc
+//	Routines to allocate and free the page frames of main memory.
+//	See frames.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "frames.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// FrameAllocator::FrameAllocator
+// 	Initialize the frame allocator, with every frame free.
+//
+//	"frames" is the number of page frames in main memory.
+//----------------------------------------------------------------------
+
+FrameAllocator::FrameAllocator(int frames)
+{
+    numFrames = numFree = frames;
+    numReserved = 0;
+    inUse = new Bitmap(numFrames);
+    refs = new int[numFrames];
+    for (int i = 0; i < numFrames; i++) {
+        refs[i] = 0;
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::~FrameAllocator
+// 	De-allocate the frame allocator.
+//----------------------------------------------------------------------
+
+FrameAllocator::~FrameAllocator()
+{
+    delete inUse;
+    delete [] refs;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Taken
+// 	One more frame is in use; count it.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Taken()
+{
+    Statistics *stats = kernel->stats;
+
+    numFree--;
+    stats->numFramesAllocated++;
+    if (numFrames - numFree > stats->maxFramesInUse) {
+        stats->maxFramesInUse = numFrames - numFree;
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Allocate
+// 	Return the number of a free frame, and mark it as in use.  The
+//	lowest numbered free frame is chosen.  Return -1 if every frame
+//	is taken, or reserved.
+//
+//	The frame still holds whatever its last owner left in it.
+//----------------------------------------------------------------------
+
+int
+FrameAllocator::Allocate()
+{
+    int frame = -1;
+
+    if (NumFree() > 0) {
+        frame = inUse->FindAndSet();
+        Taken();
+        refs[frame] = 1;
+    }
+    DEBUG(dbgAddr, "Allocated frame " << frame << ", " << numFree << " free");
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Take
+// 	Mark "frame", which must be free, as in use; for an address
+//	space whose frames were chosen for it (see AddrSpace::Restore).
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Take(int frame)
+{
+    ASSERT(!inUse->Test(frame));
+    inUse->Mark(frame);
+    Taken();
+    refs[frame] = 1;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Share
+// 	Another address space is using "frame", which is in use already.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Share(int frame)
+{
+    ASSERT(inUse->Test(frame));
+    refs[frame]++;
+    kernel->stats->numFramesShared++;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Free
+// 	An address space is done with "frame", which must be in use; if
+//	it was the last one using it, the frame is free again.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Free(int frame)
+{
+    ASSERT(inUse->Test(frame) && refs[frame] > 0);
+    if (--refs[frame] == 0) {
+        inUse->Clear(frame);
+        numFree++;
+        kernel->stats->numFramesFreed++;
+    }
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Reserve
+// 	Keep "count" free frames from being allocated, so that they are
+//	there when they are needed.  Return FALSE, and reserve none, if
+//	there aren't that many.
+//----------------------------------------------------------------------
+
+bool
+FrameAllocator::Reserve(int count)
+{
+    if (count > NumFree()) {
+        return FALSE;
+    }
+    numReserved += count;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// FrameAllocator::Unreserve
+// 	Let "count" reserved frames be allocated again; to allocate one
+//	of them, say.
+//----------------------------------------------------------------------
+
+void
+FrameAllocator::Unreserve(int count)
+{
+    numReserved -= count;
+    ASSERT(numReserved >= 0);
+}
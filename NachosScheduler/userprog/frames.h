@@ -0,0 +1,61 @@
+// frames.h
+//	Data structures to keep track of which physical page frames
+//	of main memory are in use by some address space, and which
+//	are free.
+//
+//	There is one of these for the whole machine (kernel->frames).
+//	An address space takes its frames from it when a program is
+//	loaded, and gives them back when the address space is deleted,
+//	so that any number of programs can run one after another, as
+//	long as those running at the same time fit in memory.
+//
+//	A frame can be shared by several address spaces (see
+//	AddrSpace::Load); it is counted, and only free again when the
+//	last of them gives it back.  Frames can also be reserved, for
+//	the copies copy-on-write pages may need: a reserved frame isn't
+//	handed out until the reservation is given back.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FRAMES_H
+#define FRAMES_H
+
+#include "copyright.h"
+#include "bitmap.h"
+
+// The following class allocates the page frames of main memory.
+
+class FrameAllocator {
+  public:
+    FrameAllocator(int frames);	// "frames" frames, all free
+    ~FrameAllocator();
+
+    int Allocate();			// return a free frame, now in use,
+					// or -1 if there are none
+    void Take(int frame);		// mark a particular, free, frame
+					// as in use
+    void Share(int frame);		// one more user for a frame in use
+    void Free(int frame);		// give a frame back
+
+    int References(int frame) { return refs[frame]; }
+					// how many are using it
+    int NumFree() { return numFree - numReserved; }
+					// how many could be allocated
+
+    bool Reserve(int count);		// keep "count" free frames back;
+					// FALSE if there aren't that many
+    void Unreserve(int count);		// let them be allocated again
+
+  private:
+    Bitmap *inUse;			// a bit per frame, set if taken
+    int *refs;				// users of each frame
+    int numFrames;
+    int numFree;
+    int numReserved;			// of the free ones
+
+    void Taken();			// account for one more frame in use
+};
+
+#endif // FRAMES_H
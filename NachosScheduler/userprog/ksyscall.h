@@ -12,11 +12,26 @@
 #define __USERPROG_KSYSCALL_H__ 
 
 #include "kernel.h"
+#include "synchdisk.h"
+#include "synchconsole.h"
+#include "addrspace.h"
+#include "pipe.h"
+#include "syscallring.h"
+#include "syscall.h"
+
+const int MaxNameLength = 64;		// of a file a user program names,
+					// without the '\0'
+#ifndef FILESYS_STUB
+const int CreatedFileSize = 32 * SectorSize;	// a file Create makes:
+					// the Nachos file system's can't grow
+#endif
 
 
 
 void SysHalt()
 {
+    kernel->synchConsoleOut->Flush();	// and the display
+    kernel->synchDisk->Flush();		// what the disk hasn't got yet
     kernel->interrupt->Halt();
 }
 
@@ -36,4 +51,427 @@ void SysNice(int priority)
     kernel->interrupt->Nice(priority);
 }
 
+/*
+ * Block until "ticks" from now, on the alarm of the CPU we are on.
+ */
+void SysSleep(int ticks)
+{
+    DEBUG(dbgSys, "Sleep " << ticks);
+    kernel->currentCPU->alarm->WaitUntil(ticks);
+}
+
+/*
+ * Copy the name at "nameAddr" in user memory into "name", which has
+ * room for MaxNameLength characters, and the '\0'.  Return 1, or
+ * else EFAULT, if it isn't all in the address space, or ENAMETOOLONG.
+ */
+int CopyInName(int nameAddr, char *name)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int done = 0;
+
+    while (done <= MaxNameLength) {
+        int length;
+        char *span = space->Pin(nameAddr + done, MaxNameLength + 1 - done,
+                                FALSE, &length);
+
+        if (span == NULL) {
+            return EFAULT;
+        }
+        bcopy(span, &name[done], length);
+        space->Unpin(span, length);
+        if (memchr(&name[done], '\0', length) != NULL) {
+            return 1;
+        }
+        done += length;
+    }
+    return ENAMETOOLONG;
+}
+
+/*
+ * This user program is done: close its files, and hand "status" back
+ * to the program that started it, if any.
+ */
+void SysExit(int status)
+{
+    Thread *thread = kernel->currentThread;
+
+    cout << "return value:" << status << endl;
+    if (thread->space->Ring() != NULL) {	// the ring's kernel thread
+        thread->space->Ring()->Stop();	// may be using our files
+    }
+    thread->space->CloseFiles();
+    if (thread->joinRecord != NULL) {
+        thread->joinRecord->status = status;
+    }
+    thread->Finish();
+}
+
+/*
+ * Start the program in the file named at "nameAddr", at the current
+ * thread's priority, and return its thread's ID, for SysJoin.
+ */
+SpaceId SysExec(int nameAddr)
+{
+    char name[MaxNameLength + 1];
+    int result = CopyInName(nameAddr, name);
+    AddrSpace *space = kernel->currentThread->space;
+    OpenFile *executable;
+    JoinRecord *child;
+    char *threadName;
+    SpaceId id;
+
+    if (result < 0) {
+        return result;
+    }
+    if ((executable = kernel->fileSystem->Open(name)) == NULL) {
+        return ENOENT;
+    }
+    delete executable;
+    threadName = new char[strlen(name) + 1];	// kept: the thread's
+    strcpy(threadName, name);			// statistics print it at halt
+    child = new JoinRecord;
+    id = kernel->Exec(threadName, kernel->currentThread->getBasePriority(),
+                      -1, child);
+    space->AddChild(child);
+    DEBUG(dbgSys, "Exec " << name << " as " << id);
+    return id;
+}
+
+/*
+ * Wait until the program started as "id" by this one has exited, and
+ * return what it gave Exit.  If it has already, return at once.
+ */
+int SysJoin(SpaceId id)
+{
+    JoinRecord *child = kernel->currentThread->space->TakeChild(id);
+    int status;
+
+    if (child == NULL) {
+        return ECHILD;
+    }
+    child->exited->P();
+    status = child->status;
+    child->Release();
+    DEBUG(dbgSys, "Joined " << id << ", status " << status);
+    return status;
+}
+
+/*
+ * Create the file named at "nameAddr".  With the Nachos file system,
+ * it is CreatedFileSize bytes long, of zeros.
+ */
+int SysCreate(int nameAddr)
+{
+    char name[MaxNameLength + 1];
+    int result = CopyInName(nameAddr, name);
+
+    if (result < 0) {
+        return result;
+    }
+    DEBUG(dbgSys, "Create " << name);
+#ifdef FILESYS_STUB
+    if (!kernel->fileSystem->Create(name)) {
+        return EACCES;
+    }
+#else
+    if (!kernel->fileSystem->Create(name, CreatedFileSize)) {
+        OpenFile *file = kernel->fileSystem->Open(name);
+
+        if (file == NULL) {
+            return ENOSPC;
+        }
+        delete file;
+        return EEXIST;
+    }
+#endif
+    return 1;
+}
+
+/*
+ * Open the file named at "nameAddr", and return its descriptor.
+ */
+OpenFileId SysOpen(int nameAddr)
+{
+    char name[MaxNameLength + 1];
+    int result = CopyInName(nameAddr, name);
+    OpenFile *file;
+    OpenFileId id;
+
+    if (result < 0) {
+        return result;
+    }
+    if ((file = kernel->fileSystem->Open(name)) == NULL) {
+        return ENOENT;
+    }
+    if ((id = kernel->currentThread->space->Attach(file)) < 0) {
+        delete file;
+        return EMFILE;
+    }
+    DEBUG(dbgSys, "Open " << name << " as " << id);
+    return id;
+}
+
+/*
+ * Read up to "size" characters typed at the console into "buffer":
+ * wait for the first, and stop after a newline, or at the end of the
+ * input.  They go straight into the frames "buffer" is in, a line of
+ * a batch at a time (see SynchConsoleInput::GetLine).
+ */
+int ReadConsole(int buffer, int size)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int done = 0;
+
+    while (done < size) {
+        int length, numRead;
+        bool lineDone;
+        char *span = space->Pin(buffer + done, size - done, TRUE, &length);
+
+        if (span == NULL) {
+            return (done > 0) ? done : EFAULT;
+        }
+        numRead = kernel->synchConsoleIn->GetLine(span, length);
+        lineDone = numRead < length || span[numRead - 1] == '\n';
+        space->Unpin(span, length);
+        done += numRead;
+        if (lineDone) {
+            break;
+        }
+    }
+    return done;
+}
+
+/*
+ * Read up to "size" bytes from the file open as "id" into "buffer",
+ * and return how many there were.  They go straight from the file
+ * system into the frames of the pages "buffer" is in, a span of
+ * consecutive frames at a time (see AddrSpace::Pin).
+ */
+int SysRead(int buffer, int size, OpenFileId id)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    OpenFile *file;
+    PipeEnd *end;
+    int done = 0;
+
+    if (size < 0) {
+        return EINVAL;
+    }
+    if (id == ConsoleInput) {
+        return ReadConsole(buffer, size);
+    }
+    if ((end = space->PipeFor(id)) != NULL) {
+        return end->writing ? EBADF : end->pipe->Read(space, buffer, size);
+    }
+    if ((file = space->FileFor(id)) == NULL) {
+        return EBADF;
+    }
+    while (done < size) {
+        int length, numRead;
+        char *span = space->Pin(buffer + done, size - done, TRUE, &length);
+
+        if (span == NULL) {
+            return (done > 0) ? done : EFAULT;
+        }
+        numRead = file->Read(span, length);
+        space->Unpin(span, length);
+        done += numRead;
+        if (numRead < length) {		// the end of the file
+            break;
+        }
+    }
+    return done;
+}
+
+/*
+ * Write "size" bytes from "buffer" to the file open as "id", or to
+ * the console, and return how many were written: as with SysRead,
+ * straight out of the frames they are in.
+ */
+int SysWrite(int buffer, int size, OpenFileId id)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    OpenFile *file = NULL;
+    PipeEnd *end;
+    int done = 0;
+
+    if (size < 0) {
+        return EINVAL;
+    }
+    if ((end = space->PipeFor(id)) != NULL) {
+        return end->writing ? end->pipe->Write(space, buffer, size) : EBADF;
+    }
+    if (id != ConsoleOutput && (file = space->FileFor(id)) == NULL) {
+        return EBADF;
+    }
+    while (done < size) {
+        int length, numWritten;
+        char *span = space->Pin(buffer + done, size - done, FALSE, &length);
+
+        if (span == NULL) {
+            return (done > 0) ? done : EFAULT;
+        }
+        if (file == NULL) {
+            kernel->synchConsoleOut->PutString(span, length);
+            numWritten = length;
+        } else {
+            numWritten = file->Write(span, length);
+        }
+        space->Unpin(span, length);
+        done += numWritten;
+        if (numWritten < length) {	// the end of a file that can't grow
+            break;
+        }
+    }
+    return done;
+}
+
+/*
+ * Write the string at "stringAddr" in user memory, up to its '\0', to
+ * the console: a span of the frames it is in at a time, each in one
+ * write (see SynchConsoleOutput::PutString).
+ */
+int SysPutString(int stringAddr)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int done = 0;
+
+    for (;;) {
+        int pinned, length;
+        char *span = space->Pin(stringAddr + done, MaxPinnedPages * PageSize,
+                                FALSE, &pinned);
+        char *end;
+
+        if (span == NULL) {
+            return EFAULT;
+        }
+        end = (char *) memchr(span, '\0', pinned);
+        length = (end != NULL) ? end - span : pinned;
+        if (length > 0) {
+            kernel->synchConsoleOut->PutString(span, length);
+        }
+        space->Unpin(span, pinned);
+        done += length;
+        if (end != NULL) {
+            return done;
+        }
+    }
+}
+
+/*
+ * Close the file, or the pipe end, open as "id".
+ */
+int SysClose(OpenFileId id)
+{
+    OpenFile *file = kernel->currentThread->space->Detach(id);
+    PipeEnd *end = kernel->currentThread->space->DetachPipe(id);
+
+    if (end != NULL) {
+        DEBUG(dbgSys, "Close pipe " << id);
+        delete end;
+        return 1;
+    }
+    if (file == NULL) {
+        return EBADF;
+    }
+    DEBUG(dbgSys, "Close " << id);
+    delete file;
+    return 1;
+}
+
+/*
+ * Make a pipe, with a descriptor for each end, and put them at
+ * "idsAddr" in user memory: the read end's, then the write end's.
+ */
+int SysPipe(int idsAddr)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    PipeBuffer *pipe;
+    PipeEnd *reader, *writer;
+    int ids[2];
+
+    if (idsAddr % sizeof(int) != 0) {
+        return EFAULT;
+    }
+    pipe = new PipeBuffer;
+    reader = new PipeEnd(pipe, FALSE);
+    writer = new PipeEnd(pipe, TRUE);
+    ids[0] = space->AttachPipe(reader);
+    ids[1] = (ids[0] < 0) ? -1 : space->AttachPipe(writer);
+    if (ids[1] < 0) {
+        if (ids[0] >= 0) {
+            (void) space->DetachPipe(ids[0]);
+        }
+        delete reader;
+        delete writer;			// and the pipe with them
+        return EMFILE;
+    }
+    for (int i = 0; i < 2; i++) {
+        int length;
+        char *span = space->Pin(idsAddr + i * sizeof(int), sizeof(int),
+                                TRUE, &length);
+
+        if (span == NULL) {
+            delete space->DetachPipe(ids[0]);
+            delete space->DetachPipe(ids[1]);
+            return EFAULT;
+        }
+        *(unsigned int *) span = WordToMachine((unsigned int) ids[i]);
+        space->Unpin(span, length);
+    }
+    DEBUG(dbgSys, "Pipe " << ids[0] << " to " << ids[1]);
+    return 1;
+}
+
+/*
+ * Have the kernel make the calls queued in the ring at "ringAddr"
+ * from now on (see syscallring.h); with RingPoll in "flags", a kernel
+ * thread.  Return 0, or else EBUSY if the program has a ring already,
+ * EINVAL if "ringAddr" isn't word aligned or "flags" makes no sense,
+ * or EFAULT if the ring isn't all in the address space.
+ */
+int SysRingSetup(int ringAddr, int flags)
+{
+    AddrSpace *space = kernel->currentThread->space;
+    int done = 0;
+
+    if (space->Ring() != NULL) {
+        return EBUSY;
+    }
+    if (ringAddr % sizeof(int) != 0 || (flags & ~RingPoll) != 0) {
+        return EINVAL;
+    }
+    while (done < (int) sizeof(CallRing)) {
+        int length;
+        char *span = space->Pin(ringAddr + done, sizeof(CallRing) - done,
+                                TRUE, &length);
+
+        if (span == NULL) {
+            return EFAULT;
+        }
+        space->Unpin(span, length);
+        done += length;
+    }
+    space->SetRing(new SyscallRing(space, ringAddr,
+                                   (flags & RingPoll) != 0));
+    DEBUG(dbgSys, "Ring at " << ringAddr << ((flags & RingPoll) ? ", polled" : ""));
+    return 0;
+}
+
+/*
+ * Make the calls queued in the program's ring, and wait for at least
+ * "minResults" results (see SyscallRing::Enter).  Return how many
+ * results there are to take, or EINVAL if the program has no ring.
+ */
+int SysRingEnter(int minResults)
+{
+    SyscallRing *ring = kernel->currentThread->space->Ring();
+
+    if (ring == NULL) {
+        return EINVAL;
+    }
+    return ring->Enter(minResults);
+}
+
 #endif /* ! __USERPROG_KSYSCALL_H__ */
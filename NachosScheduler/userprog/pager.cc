@@ -0,0 +1,475 @@
+// pager.cc
+//	Routines to handle page faults with demand paging, and to move
+//	pages between main memory and the swap area.  See pager.h.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pager.h"
+#include "main.h"
+#include "synch.h"
+#include "synchdisk.h"
+#include "addrspace.h"
+#include "frames.h"
+
+static const char *policyNames[] = { "fifo", "clock", "enhanced", "aging" };
+
+//----------------------------------------------------------------------
+// Pager::Pager
+// 	Initialize the pager, with no pages in memory or in the swap
+//	area.  A page must fit in a disk sector.
+//
+//	"replacement" is how to pick the page to take a frame from.
+//----------------------------------------------------------------------
+
+Pager::Pager(PagePolicy replacement)
+{
+    ASSERT(PageSize == SectorSize);
+    policy = replacement;
+    lock = new Lock("pager");
+    unpinned = new Condition("frame unpinned");
+    slots = new Bitmap(NumSwapSectors);
+    numUnreserved = NumSwapSectors;
+    coreMap = new CoreMapEntry[NumPhysPages];
+    for (int i = 0; i < NumPhysPages; i++) {
+        coreMap[i].space = NULL;
+        coreMap[i].virtualPage = -1;
+        coreMap[i].age = 0;
+        coreMap[i].pinned = 0;
+    }
+    loaded = new List<int>;
+    buffer = new char[PageSize];
+    hand = 0;
+    numEvictions = numWriteBacks = 0;
+}
+
+//----------------------------------------------------------------------
+// Pager::~Pager
+// 	De-allocate the pager.
+//----------------------------------------------------------------------
+
+Pager::~Pager()
+{
+    delete lock;
+    delete unpinned;
+    delete slots;
+    delete [] coreMap;
+    delete loaded;
+    delete [] buffer;
+}
+
+//----------------------------------------------------------------------
+// Pager::Reserve
+// 	Keep room in the swap area for a program of "numPages" pages,
+//	so that each of its pages can be written out, if need be.
+//	Return FALSE if there isn't room left.
+//----------------------------------------------------------------------
+
+bool
+Pager::Reserve(int numPages)
+{
+    if (numPages > numUnreserved) {
+        return FALSE;
+    }
+    numUnreserved -= numPages;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pager::Unreserve
+// 	A program of "numPages" pages is done with the swap area.
+//----------------------------------------------------------------------
+
+void
+Pager::Unreserve(int numPages)
+{
+    numUnreserved += numPages;
+    ASSERT(numUnreserved <= NumSwapSectors);
+}
+
+//----------------------------------------------------------------------
+// Pager::PageFault
+// 	Called by ExceptionHandler when a user program references a
+//	page of "space" that isn't in memory.  Find the page a frame,
+//	taking one from another page if none is free, and read the page
+//	into it: from the swap area if it was written there, and from the
+//	program's file otherwise.  Then the instruction can be run again.
+//
+//	The current thread waits while the disk is read or written.
+//	Return FALSE if "virtAddr" isn't in the address space at all.
+//----------------------------------------------------------------------
+
+bool
+Pager::PageFault(AddrSpace *space, int virtAddr)
+{
+    unsigned int vpn = (unsigned) virtAddr / PageSize;
+    TranslationEntry *entry;
+    int frame;
+
+    if (vpn >= space->numPages) {
+        return FALSE;
+    }
+    entry = &space->pageTable[vpn];
+    lock->Acquire();
+    if (!entry->valid) {
+        kernel->stats->numPageFaults++;
+        space->numFaults++;
+        if ((frame = kernel->frames->Allocate()) < 0) {
+            frame = Evict();
+        }
+        coreMap[frame].space = space;
+        coreMap[frame].virtualPage = vpn;
+        coreMap[frame].age = 0x80;	// as good as just used
+        coreMap[frame].pinned = 0;
+        kernel->machine->InvalidateDecoded(frame * PageSize, PageSize);
+        if (space->swapSlots[vpn] >= 0) {
+            DEBUG(dbgAddr, "Page " << vpn << " in from swap slot "
+                  << space->swapSlots[vpn] << " to frame " << frame);
+            kernel->synchDisk->ReadSector(FirstSwapSector
+                                              + space->swapSlots[vpn],
+                                          &kernel->machine->mainMemory[
+                                              frame * PageSize]);
+        } else {
+            DEBUG(dbgAddr, "Page " << vpn << " in from file to frame "
+                  << frame);
+            space->FillPage(vpn, &kernel->machine->mainMemory[
+                                     frame * PageSize]);
+        }
+        entry->physicalPage = frame;
+        entry->use = FALSE;
+        entry->dirty = FALSE;
+        entry->valid = TRUE;
+        space->pagerUse[vpn] = FALSE;
+        space->CountResident(1);
+        loaded->Insert(frame);
+    }
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Pager::EntryFor
+// 	Return the page table entry of the page in "frame", or NULL if
+//	the frame holds none.
+//----------------------------------------------------------------------
+
+TranslationEntry *
+Pager::EntryFor(int frame)
+{
+    CoreMapEntry *owner = &coreMap[frame];
+
+    if (owner->space == NULL) {
+        return NULL;
+    }
+    return &owner->space->pageTable[owner->virtualPage];
+}
+
+//----------------------------------------------------------------------
+// Pager::Takeable
+// 	Return whether the frame can be taken away from the page in it:
+//	it holds one, and no system call has it pinned.
+//----------------------------------------------------------------------
+
+bool
+Pager::Takeable(int frame)
+{
+    return coreMap[frame].space != NULL && coreMap[frame].pinned == 0;
+}
+
+//----------------------------------------------------------------------
+// Pager::Used
+// 	Return whether the page in "frame" has been used since the pager
+//	last cleared its use bit -- including if AddrSpace::
+//	SampleWorkingSet cleared it since.
+//----------------------------------------------------------------------
+
+bool
+Pager::Used(int frame)
+{
+    CoreMapEntry *owner = &coreMap[frame];
+
+    return owner->space->pageTable[owner->virtualPage].use
+               || owner->space->pagerUse[owner->virtualPage];
+}
+
+//----------------------------------------------------------------------
+// Pager::ClearUse
+// 	Clear the use bit of the page in "frame", keeping it for the
+//	working set sample if that hasn't seen it yet.
+//----------------------------------------------------------------------
+
+void
+Pager::ClearUse(int frame)
+{
+    CoreMapEntry *owner = &coreMap[frame];
+    TranslationEntry *entry = &owner->space->pageTable[owner->virtualPage];
+
+    if (entry->use) {
+        owner->space->sampleUse[owner->virtualPage] = TRUE;
+        entry->use = FALSE;
+    }
+    owner->space->pagerUse[owner->virtualPage] = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Pager::CollectBits
+// 	Copy the use and dirty bits the TLBs have set back to the page
+//	tables, so that they are all in one place for the policy to look
+//	at (and to clear).
+//----------------------------------------------------------------------
+
+void
+Pager::CollectBits()
+{
+    for (int i = 0; i < kernel->numCPUs; i++) {
+        if (kernel->cpus[i]->tlb != NULL) {
+            kernel->cpus[i]->tlb->WriteBack();
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Pager::Victim
+// 	Return the frame to take away from its page, by the replacement
+//	policy.  Every frame holds a page, or one would have been free;
+//	those pinned are passed over (there are only a few).
+//----------------------------------------------------------------------
+
+int
+Pager::Victim()
+{
+    TranslationEntry *entry;
+    int victim;
+
+    switch (policy) {
+      case PageFIFO: {
+        ListIterator<int> iter(loaded);
+
+        for (; !iter.IsDone(); iter.Next()) {
+            if (coreMap[iter.Item()].pinned == 0) {
+                return iter.Item();
+            }
+        }
+        break;
+      }
+
+      case PageClock:
+        CollectBits();
+        for (;;) {			// round at most twice
+            victim = hand;
+            hand = (hand + 1) % NumPhysPages;
+            if (Takeable(victim)) {
+                if (!Used(victim)) {
+                    return victim;
+                }
+                ClearUse(victim);	// a second chance
+            }
+        }
+
+      case PageEnhancedClock:
+        CollectBits();
+        for (;;) {			// round at most four times
+            for (int i = 0; i < NumPhysPages; i++) {	// unused, clean
+                victim = (hand + i) % NumPhysPages;
+                entry = EntryFor(victim);
+                if (Takeable(victim) && !Used(victim) && !entry->dirty) {
+                    hand = (victim + 1) % NumPhysPages;
+                    return victim;
+                }
+            }
+            for (int i = 0; i < NumPhysPages; i++) {	// unused, dirty
+                victim = (hand + i) % NumPhysPages;
+                if (Takeable(victim) && !Used(victim)) {
+                    hand = (victim + 1) % NumPhysPages;
+                    return victim;
+                }
+                if (Takeable(victim)) {
+                    ClearUse(victim);	// next time round, it's unused
+                }
+            }
+        }
+
+      case PageAging:
+        victim = -1;
+        for (int i = 0; i < NumPhysPages; i++) {	// the lowest age,
+            int frame = (hand + i) % NumPhysPages;	// starting after
+							// the last one
+            if (Takeable(frame)
+                  && (victim < 0 || coreMap[frame].age < coreMap[victim].age)) {
+                victim = frame;
+            }
+        }
+        ASSERT(victim >= 0);
+        hand = (victim + 1) % NumPhysPages;
+        return victim;
+    }
+    ASSERTNOTREACHED();
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Pager::Tick
+// 	Called on every timer interrupt.  With PageAging, shift each
+//	page's use bit into its age, and clear it.
+//----------------------------------------------------------------------
+
+void
+Pager::Tick()
+{
+    if (policy != PageAging) {
+        return;
+    }
+    CollectBits();
+    for (int frame = 0; frame < NumPhysPages; frame++) {
+        if (EntryFor(frame) != NULL) {
+            coreMap[frame].age = (coreMap[frame].age >> 1)
+                                     | (Used(frame) ? 0x80 : 0);
+            ClearUse(frame);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Pager::Evict
+// 	No frame is free: take one away from the page in it, as the
+//	replacement policy says, and return it.  If the page was changed
+//	since it was read in, write it to the swap area first; if not,
+//	a copy of it is already there, or in the program's file.
+//
+//	Everything about the page's address space is settled before the
+//	disk is written, since the address space may be deleted while
+//	the current thread waits.
+//
+//	If every frame is pinned, wait until one isn't: the system calls
+//	pinning them are waiting for a device, not for a frame (see
+//	AddrSpace::Pin).
+//----------------------------------------------------------------------
+
+int
+Pager::Evict()
+{
+    int frame;
+    AddrSpace *space;
+    int vpn;
+    TranslationEntry *entry;
+
+    for (;;) {
+        for (frame = 0; frame < NumPhysPages && !Takeable(frame); frame++) {
+        }
+        if (frame < NumPhysPages) {
+            break;
+        }
+        DEBUG(dbgAddr, "Every frame is pinned; waiting");
+        unpinned->Wait(lock);
+    }
+    frame = Victim();
+    space = coreMap[frame].space;
+    vpn = coreMap[frame].virtualPage;
+    entry = &space->pageTable[vpn];
+
+    loaded->Remove(frame);
+    for (int i = 0; i < kernel->numCPUs; i++) {	// its use and dirty
+        if (kernel->cpus[i]->tlb != NULL) {	// bits may be there
+            kernel->cpus[i]->tlb->Invalidate(entry);
+        }
+    }
+    entry->valid = FALSE;
+    space->CountResident(-1);
+    coreMap[frame].space = NULL;
+    numEvictions++;
+    if (entry->dirty) {
+        int slot = space->swapSlots[vpn];
+
+        if (slot < 0) {
+            slot = slots->FindAndSet();
+            ASSERT(slot >= 0);		// Reserve saw to that
+            space->swapSlots[vpn] = slot;
+        }
+        DEBUG(dbgAddr, "Page " << vpn << " out from frame " << frame
+              << " to swap slot " << slot);
+        bcopy(&kernel->machine->mainMemory[frame * PageSize], buffer, PageSize);
+        kernel->stats->numPageOuts++;
+        numWriteBacks++;
+        kernel->synchDisk->WriteSector(FirstSwapSector + slot, buffer);
+    }
+    return frame;
+}
+
+//----------------------------------------------------------------------
+// Pager::FreeFrame
+// 	The address space of the page in "frame" is being deleted; give
+//	the frame back.
+//----------------------------------------------------------------------
+
+void
+Pager::FreeFrame(int frame)
+{
+    loaded->Remove(frame);
+    coreMap[frame].space = NULL;
+    kernel->frames->Free(frame);
+}
+
+//----------------------------------------------------------------------
+// Pager::FreeSlot
+// 	The address space of the page in swap slot "slot" is being
+//	deleted; the slot can hold another page.
+//----------------------------------------------------------------------
+
+void
+Pager::FreeSlot(int slot)
+{
+    slots->Clear(slot);
+}
+
+//----------------------------------------------------------------------
+// Pager::Pin
+// 	A system call is about to read or write "frame" while it waits
+//	for the disk: don't take it away from its page until it is done.
+//----------------------------------------------------------------------
+
+void
+Pager::Pin(int frame)
+{
+    ASSERT(coreMap[frame].space != NULL);
+    coreMap[frame].pinned++;
+}
+
+//----------------------------------------------------------------------
+// Pager::Unpin
+// 	The system call is done with "frame".  A fault may be waiting
+//	for it.
+//----------------------------------------------------------------------
+
+void
+Pager::Unpin(int frame)
+{
+    ASSERT(coreMap[frame].pinned > 0);
+    if (--coreMap[frame].pinned == 0) {
+        lock->Acquire();
+        unpinned->Broadcast(lock);
+        lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// Pager::Print
+// 	Print how the replacement policy did, when Nachos halts: the
+//	page faults per thousand user instructions, and the pages taken
+//	out of memory, and written out, to make room.
+//----------------------------------------------------------------------
+
+void
+Pager::Print()
+{
+    Statistics *stats = kernel->stats;
+    char rate[32];
+
+    sprintf(rate, "%.2f", (stats->userTicks > 0)
+                      ? 1000.0 * stats->numPageFaults / stats->userTicks : 0.0);
+    cout << "Page replacement (" << policyNames[policy] << "): "
+         << stats->numPageFaults << " faults, " << rate
+         << " per 1000 instructions; " << numEvictions << " evictions, "
+         << numWriteBacks << " written back\n";
+}
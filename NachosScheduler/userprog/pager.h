@@ -0,0 +1,125 @@
+// pager.h
+//	Data structures for demand paging user programs (-vm).
+//
+//	With demand paging, AddrSpace::Load reads only the program's
+//	header, and every page of the address space starts out invalid.
+//	The first reference to a page is a page fault; the pager finds
+//	the page a frame and fills it: from the swap area, if the page
+//	has been written there, and otherwise from the program's file
+//	(its code and initialized data), or with zeros (its uninitialized
+//	data and its stack).
+//
+//	When no frame is free, a page is taken away from a program: which
+//	one is up to the replacement policy, "-vm <policy>":
+//
+//	"fifo" -- the one that has been in memory longest (the default)
+//	"clock" -- the next one, going round the frames, whose use bit
+//		is clear; the use bits passed over are cleared
+//	"enhanced" -- the same, but a page neither used nor changed is
+//		taken before one that was changed (and so must be
+//		written out), and that before one that was used
+//	"aging" -- the one used least recently, as far as can be told
+//		from a counter per frame: on every timer interrupt, each
+//		counter is shifted right, with the page's use bit going
+//		into the top, and the use bit is cleared
+//
+//	The use and dirty bits come from the page table, after those in
+//	the TLBs have been copied back to it.  If it was changed since it
+//	was last read in, it is first written to the swap area, a sector
+//	per page, where it stays until its address space is deleted; if
+//	not, it can be read in again from wherever it came from.  A
+//	program is only run if the swap area has room for all of its
+//	pages (see Reserve), so there is always somewhere to write one.
+//
+//	The swap area is the last NumSwapSectors sectors of the disk
+//	(see synchdisk.h), read and written through kernel->synchDisk, so
+//	the thread that faulted waits for the disk, and others run in the
+//	meantime.  Only one fault is handled at a time.
+//
+//	A frame a system call is reading or writing the file system into
+//	or out of is pinned (see AddrSpace::Pin): its page isn't taken
+//	away from it while the call waits for the disk.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PAGER_H
+#define PAGER_H
+
+#include "copyright.h"
+#include "bitmap.h"
+#include "list.h"
+
+class AddrSpace;
+class Lock;
+class Condition;
+class TranslationEntry;
+
+// Which page to take a frame from.
+
+enum PagePolicy { PageFIFO, PageClock, PageEnhancedClock, PageAging };
+
+// What a frame holds: which page of which address space.
+
+class CoreMapEntry {
+  public:
+    AddrSpace *space;		// NULL if the frame holds no page
+    int virtualPage;
+    unsigned char age;		// for PageAging: the use bits sampled,
+				// the latest in the top bit
+    int pinned;			// system calls using it; while any are,
+				// its page stays
+};
+
+// The following class handles page faults, and keeps track of the
+// swap area.
+
+class Pager {
+  public:
+    Pager(PagePolicy replacement);	// an empty swap area
+    ~Pager();
+
+    bool Reserve(int numPages);	// keep room in the swap area for
+				// "numPages" more; FALSE if there isn't
+    void Unreserve(int numPages);	// give it back
+
+    bool PageFault(AddrSpace *space, int virtAddr);
+				// bring the page holding "virtAddr" into
+				// memory; FALSE if there is no such page
+    void FreeFrame(int frame);	// a page of an address space being
+				// deleted no longer needs its frame
+    void FreeSlot(int slot);	// or its copy in the swap area
+    void Pin(int frame);	// keep the page in "frame" there ...
+    void Unpin(int frame);	// ... until this
+
+    void Tick();		// a timer interrupt; age the pages
+    void Print();		// how well the policy did
+
+  private:
+    PagePolicy policy;
+    Lock *lock;			// one fault at a time
+    Condition *unpinned;	// signalled when a frame stops being
+				// pinned
+    Bitmap *slots;		// which swap sectors hold a page
+    int numUnreserved;		// slots no program has reserved
+    CoreMapEntry *coreMap;	// what each frame holds
+    List<int> *loaded;		// frames holding a page, in the order
+				// they were filled
+    char *buffer;		// a page on its way to the swap area
+    int hand;			// where the clock goes round from
+    int numEvictions;		// pages taken out of memory ...
+    int numWriteBacks;		// ... of which were written out
+
+    int Evict();		// free a frame, and return it
+    int Victim();		// the frame to take, by the policy
+    TranslationEntry *EntryFor(int frame);
+				// the page table entry of its page
+    bool Takeable(int frame);	// it holds a page, not pinned
+    bool Used(int frame);	// whether its page was used lately
+    void ClearUse(int frame);	// and start over
+    void CollectBits();		// copy the TLBs' use and dirty bits
+				// to the page tables
+};
+
+#endif // PAGER_H
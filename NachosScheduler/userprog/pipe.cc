@@ -0,0 +1,206 @@
+// pipe.cc
+//	Routines to move bytes through a pipe, from one user program's
+//	address space to another's.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "main.h"
+#include "pipe.h"
+#include "addrspace.h"
+#include "syscall.h"
+#include "synch.h"
+
+//----------------------------------------------------------------------
+// PipeBuffer::PipeBuffer
+// 	Initialize an empty pipe; its ends are made next.
+//----------------------------------------------------------------------
+
+PipeBuffer::PipeBuffer()
+{
+    first = count = 0;
+    numReaders = numWriters = 0;
+    lock = new Lock("pipe");
+    notEmpty = new Condition("pipe not empty");
+    notFull = new Condition("pipe not full");
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::~PipeBuffer
+// 	De-allocate a pipe, once it has no ends: nobody can be waiting.
+//----------------------------------------------------------------------
+
+PipeBuffer::~PipeBuffer()
+{
+    if (count > 0) {
+        DEBUG(dbgSys, count << " bytes of a pipe never read");
+    }
+    delete lock;
+    delete notEmpty;
+    delete notFull;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Read
+// 	Wait until there are bytes in the pipe, or no write ends, then
+//	copy as many of them as there are, up to "size", into "space"
+//	at "virtAddr", and return how many.  Return 0 once every write
+//	end is closed and the pipe is empty, or EFAULT if "virtAddr"
+//	isn't ours to write.
+//
+//	Each piece is copied from the ring straight into the frame it
+//	goes to: as many bytes as are in consecutive frames, and in a
+//	run of the ring, at a time.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Read(AddrSpace *space, int virtAddr, int size)
+{
+    int done = 0;
+    bool fault = FALSE;
+
+    lock->Acquire();
+    while (count == 0 && numWriters > 0) {
+        notEmpty->Wait(lock);
+    }
+    while (done < size && count > 0) {
+        int length;
+        int wanted = min(size - done, min(count, PipeSize - first));
+        char *span = space->Pin(virtAddr + done, wanted, TRUE, &length);
+
+        if (span == NULL) {
+            fault = TRUE;
+            break;
+        }
+        bcopy(buffer + first, span, length);
+        space->Unpin(span, length);
+        first = (first + length) % PipeSize;
+        count -= length;
+        done += length;
+    }
+    if (done > 0) {
+        notFull->Broadcast(lock);
+    }
+    lock->Release();
+    return (fault && done == 0) ? EFAULT : done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Write
+// 	Copy "size" bytes from "space" at "virtAddr" into the pipe,
+//	waiting for room as they go, and return how many.  Stop early if
+//	every read end is closed -- returning EPIPE, if nothing was
+//	written -- or at a byte that isn't ours (EFAULT, if it is the
+//	first).
+//
+//	As with Read, the bytes are copied from the frames they are in
+//	straight into the ring.
+//----------------------------------------------------------------------
+
+int
+PipeBuffer::Write(AddrSpace *space, int virtAddr, int size)
+{
+    int done = 0;
+    int error = 0;
+
+    lock->Acquire();
+    while (done < size) {
+        int length, end, wanted;
+        char *span;
+
+        while (count == PipeSize && numReaders > 0) {
+            notFull->Wait(lock);
+        }
+        if (numReaders == 0) {
+            error = EPIPE;
+            break;
+        }
+        end = (first + count) % PipeSize;
+        wanted = min(size - done, min(PipeSize - count, PipeSize - end));
+        span = space->Pin(virtAddr + done, wanted, FALSE, &length);
+        if (span == NULL) {
+            error = EFAULT;
+            break;
+        }
+        bcopy(span, buffer + end, length);
+        space->Unpin(span, length);
+        count += length;
+        done += length;
+        notEmpty->Broadcast(lock);
+    }
+    lock->Release();
+    return (error != 0 && done == 0) ? error : done;
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Opened
+// 	Count another end, for reading or "writing".
+//----------------------------------------------------------------------
+
+void
+PipeBuffer::Opened(bool writing)
+{
+    lock->Acquire();
+    if (writing) {
+        numWriters++;
+    } else {
+        numReaders++;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// PipeBuffer::Closed
+// 	An end, for reading or "writing", is closed.  If it was the last
+//	of its kind, those waiting for the other kind -- readers for
+//	bytes, or writers for room -- wait no more.  Return TRUE if it
+//	was the last end of all: the caller deletes the pipe.
+//----------------------------------------------------------------------
+
+bool
+PipeBuffer::Closed(bool writing)
+{
+    bool last;
+
+    lock->Acquire();
+    if (writing) {
+        ASSERT(numWriters > 0);
+        if (--numWriters == 0) {
+            notEmpty->Broadcast(lock);
+        }
+    } else {
+        ASSERT(numReaders > 0);
+        if (--numReaders == 0) {
+            notFull->Broadcast(lock);
+        }
+    }
+    last = (numReaders == 0 && numWriters == 0);
+    lock->Release();
+    return last;
+}
+
+//----------------------------------------------------------------------
+// PipeEnd::PipeEnd
+// 	Make another end of "toPipe", for reading or writing.
+//----------------------------------------------------------------------
+
+PipeEnd::PipeEnd(PipeBuffer *toPipe, bool forWriting)
+{
+    pipe = toPipe;
+    writing = forWriting;
+    pipe->Opened(writing);
+}
+
+//----------------------------------------------------------------------
+// PipeEnd::~PipeEnd
+// 	Close an end of a pipe, and the pipe, if it was the last.
+//----------------------------------------------------------------------
+
+PipeEnd::~PipeEnd()
+{
+    if (pipe->Closed(writing)) {
+        delete pipe;
+    }
+}
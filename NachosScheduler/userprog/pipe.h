@@ -0,0 +1,81 @@
+// pipe.h
+//	Data structures for pipes: a channel of bytes from one user
+//	program to another, made by the Pipe system call.
+//
+//	A pipe is a ring of PipeSize bytes in the kernel.  Pipe gives the
+//	program that makes it a descriptor for each end (see
+//	AddrSpace::AttachPipe), which Read, Write and Close take as they
+//	do a file's; a program it Execs has the same ends, as the same
+//	descriptors, so that a parent can start a producer and a consumer
+//	joined by one.
+//
+//	Bytes go straight from the frames the writer's buffer is in into
+//	the ring, and from the ring into the reader's (see AddrSpace::Pin),
+//	as much as there is room for, or there is, at a time.  A read
+//	waits until there is something in the ring, and returns what it
+//	could get then, or 0 once every write end is closed; a write
+//	waits until all of it is in the ring, and stops, with EPIPE if it
+//	wrote nothing, once every read end is.
+//
+//	Bytes are always copied: the ring is too small for a page of a
+//	writer's to be handed to the reader in place.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class AddrSpace;
+class Lock;
+class Condition;
+
+const int PipeSize = 512;		// bytes a pipe holds
+
+// The following class defines a pipe: its ring, and the ends it has.
+// It is deleted when the last of its ends is.
+
+class PipeBuffer {
+  public:
+    PipeBuffer();		// empty, with no ends yet
+    ~PipeBuffer();
+
+    int Read(AddrSpace *space, int virtAddr, int size);
+    int Write(AddrSpace *space, int virtAddr, int size);
+				// move bytes between the ring and "space",
+				// from "virtAddr" on, and return how many,
+				// or an error (see syscall.h)
+
+  private:
+    char buffer[PipeSize];	// the ring
+    int first;			// where the oldest byte is
+    int count;			// how many bytes are in it
+    int numReaders;		// read ends open
+    int numWriters;		// and write ends
+    Lock *lock;			// for all of the above
+    Condition *notEmpty;	// signalled when bytes are put in
+    Condition *notFull;		// and when they are taken out
+
+    void Opened(bool writing);	// an end was made
+    bool Closed(bool writing);	// or deleted: TRUE if it was the last
+
+    friend class PipeEnd;
+};
+
+// One end of a pipe, as a descriptor of a program's.
+
+class PipeEnd {
+  public:
+    PipeEnd(PipeBuffer *toPipe, bool forWriting);
+				// another end of "toPipe"
+    ~PipeEnd();			// close it
+
+    PipeBuffer *pipe;
+    bool writing;		// the write end, not the read end
+};
+
+#endif // PIPE_H
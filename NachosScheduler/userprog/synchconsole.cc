@@ -39,24 +39,90 @@ SynchConsoleInput::~SynchConsoleInput()
 //----------------------------------------------------------------------
 // SynchConsoleInput::GetChar
 //      Read a character typed at the keyboard, waiting if necessary.
+//	Return EOF at the end of the input.
 //----------------------------------------------------------------------
 
 char
 SynchConsoleInput::GetChar()
 {
     char ch;
+    int numRead;
 
     lock->Acquire();
-    waitFor->P();	// wait for EOF or a char to be available.
-    ch = consoleInput->GetChar();
+    numRead = Take(&ch, 1);
     lock->Release();
-    return ch;
+    return (numRead == 0) ? EOF : ch;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::GetString
+//      Read up to "length" characters typed at the keyboard into
+//	"into": as many as have arrived, waiting only if none have.
+//	Return how many were read, 0 at the end of the input.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::GetString(char *into, int length)
+{
+    int numRead;
+
+    lock->Acquire();
+    numRead = Take(into, length);
+    lock->Release();
+    return numRead;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::GetLine
+//      Read up to "length" characters typed at the keyboard into
+//	"into", up to and including a newline, waiting for more as often
+//	as need be.  Return how many were read; fewer than "length" only
+//	at a newline, or at the end of the input.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::GetLine(char *into, int length)
+{
+    int done = 0;
+
+    lock->Acquire();
+    while (done < length && (done == 0 || into[done - 1] != '\n')) {
+        if (Take(&into[done], 1) == 0) {	// the end
+            break;
+        }
+        done++;
+    }
+    lock->Release();
+    return done;
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleInput::Take
+//      Take up to "length" of the characters that have arrived, or, if
+//	none have, ask for more and wait for them.  Return how many were
+//	taken, 0 at the end of the input.  The lock is held.
+//
+//	Each poll of the keyboard calls back once, so there is one V
+//	for every P.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::Take(char *into, int length)
+{
+    int taken;
+
+    while ((taken = consoleInput->GetString(into, length)) == 0
+             && !consoleInput->AtEnd()) {
+        consoleInput->Poll();
+        waitFor->P();	// wait for EOF or chars to be available.
+    }
+    return taken;
 }
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
-//      Interrupt handler called when keystroke is hit; wake up
-//	anyone waiting.
+//      Interrupt handler called when keystrokes have arrived, or the
+//	input has ended; wake up whoever is waiting.
 //----------------------------------------------------------------------
 
 void
@@ -78,6 +144,7 @@ SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
     consoleOutput = new ConsoleOutput(outputFile, this);
     lock = new Lock("console out");
     waitFor = new Semaphore("console out", 0);
+    lineLength = 0;
 }
 
 //----------------------------------------------------------------------
@@ -94,26 +161,89 @@ SynchConsoleOutput::~SynchConsoleOutput()
 
 //----------------------------------------------------------------------
 // SynchConsoleOutput::PutChar
-//      Write a character to the console display, waiting if necessary.
+//      Write a character to the console display, waiting if necessary:
+//	put it in the line, and write the line if it is a newline, or if
+//	the line is full.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleOutput::PutChar(char ch)
 {
     lock->Acquire();
-    consoleOutput->PutChar(ch);
-    waitFor->P();
+    line[lineLength++] = ch;
+    if (ch == '\n' || lineLength == ConsoleLineSize) {
+        Send();
+    }
     lock->Release();
 }
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutInt
+//      Write a number, and a newline, to the console display.
+//----------------------------------------------------------------------
+
 void
 SynchConsoleOutput::PutInt(int number)
+{
+    char temp[16];
+
+    sprintf(temp, "%d\n", number);
+    PutString(temp, strlen(temp));
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutString
+//      Write "length" characters from "data" to the console display,
+//	after what PutChar held back: in one write, if they fit in the
+//	line with it, and otherwise in two.  Wait until they are written.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::PutString(char *data, int length)
 {
     lock->Acquire();
-    consoleOutput->PutInt(number);
-    waitFor->P();
+    if (lineLength + length <= ConsoleLineSize) {
+        bcopy(data, &line[lineLength], length);
+        lineLength += length;
+        Send();
+    } else {
+        Send();
+        consoleOutput->PutString(data, length);
+        waitFor->P();
+    }
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::Flush
+//      Write what PutChar has held back, if anything: before Nachos
+//	halts, or when whoever was writing is done.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::Flush()
+{
+    lock->Acquire();
+    Send();
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::Send
+//      Write the line, if there is anything in it, and wait until it
+//	is written.  The lock is held.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::Send()
+{
+    if (lineLength > 0) {
+        consoleOutput->PutString(line, lineLength);
+        waitFor->P();
+        lineLength = 0;
+    }
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleOutput::CallBack
 //      Interrupt handler called when it's safe to send the next 
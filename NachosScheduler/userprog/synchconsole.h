@@ -17,24 +17,44 @@
 #include "console.h"
 #include "synch.h"
 
+const int ConsoleLineSize = 128;	// characters PutChar holds back
+
 // The following two classes define synchronized input and output to
 // a console device
 
+// Input comes from the keyboard a batch at a time (see console.h), and
+// a reader waits once for each batch, not for each character: GetString
+// takes as much of what has arrived as it wants, and GetLine as much
+// as it needs to get to a newline.
+
 class SynchConsoleInput : public CallBackObj {
   public:
     SynchConsoleInput(char *inputFile); // Initialize the console device
     ~SynchConsoleInput();		// Deallocate console device
 
     char GetChar();		// Read a character, waiting if necessary
+    int GetString(char *into, int length);
+				// Read up to "length" characters; wait
+				// for the first, but no more
+    int GetLine(char *into, int length);
+				// Read up to "length" characters,
+				// stopping after a newline
     
   private:
     ConsoleInput *consoleInput;	// the hardware keyboard
     Lock *lock;			// only one reader at a time
     Semaphore *waitFor;		// wait for callBack
 
-    void CallBack();		// called when a keystroke is available
+    int Take(char *into, int length);
+				// take what has arrived; lock held
+    void CallBack();		// called when keystrokes are available
 };
 
+// Output is line-buffered: PutChar only puts a character in the line,
+// which goes to the display, in one write, at the newline (or when the
+// line is full, or at Flush).  PutString and PutInt send the line, with
+// what they write, and wait for the one interrupt for all of it.
+
 class SynchConsoleOutput : public CallBackObj {
   public:
     SynchConsoleOutput(char *outputFile); // Initialize the console device
@@ -42,11 +62,17 @@ class SynchConsoleOutput : public CallBackObj {
 
     void PutChar(char ch);	// Write a character, waiting if necessary
     void PutInt(int number);
+    void PutString(char *data, int length);
+				// Write "length" characters at once
+    void Flush();		// Write what PutChar has held back
   private:
     ConsoleOutput *consoleOutput;// the hardware display
     Lock *lock;			// only one writer at a time
     Semaphore *waitFor;		// wait for callBack
+    char line[ConsoleLineSize];	// what PutChar hasn't written yet
+    int lineLength;
 
+    void Send();		// write the line, and wait; lock held
     void CallBack();		// called when more data can be written
 };
 
@@ -34,6 +34,11 @@
 #define SC_ExecV	13
 #define SC_ThreadExit   14
 #define SC_ThreadJoin   15
+#define SC_PutString    16
+#define SC_Sleep        17
+#define SC_Pipe         18
+#define SC_RingSetup    19
+#define SC_RingEnter    20
 #define SC_Add		42
 #define SC_PrintInt     77
 #define SC_Nice         88
@@ -70,6 +75,17 @@ void PrintInt(int number);
  */
 void Nice(int priority);
 
+/*
+ * Output the string "s", up to its '\0', onto the console, in one
+ * write: this is quicker than Write on ConsoleOutput a piece at a time
+ */
+void PutString(char *s);
+
+/*
+ * Wait, without running, until "ticks" of simulated time from now
+ */
+void Sleep(int ticks);
+
 /* Address space control operations: Exit, Exec, Execv, and Join */
 
 /* This user program is done (status = 0 means exited normally). */
@@ -156,6 +172,73 @@ int Seek(int position, OpenFileId id);
  */
 int Close(OpenFileId id);
 
+/* Make a pipe, and put an OpenFileId for reading it in ids[0], and one
+ * for writing it in ids[1]; Read, Write and Close take them as they do
+ * a file's.  A program this one Execs has the same ends.
+ * Return 1 on success, negative error code on failure
+ */
+int Pipe(OpenFileId *ids);
+
+
+/* A ring of system calls, in the program's own memory: a program that
+ * makes many calls can queue them here, and have the kernel make a
+ * batch of them for one trap, with RingEnter -- or with RingPoll,
+ * none at all, while a kernel thread watches the ring.
+ *
+ * The four counts only go up; request n is in requests[n % RingSize],
+ * and its result in results[n % RingSize].  The program fills in a
+ * request, and only then adds one to "submitted"; it takes a result,
+ * and then adds one to "reaped".  The kernel does the same with
+ * "taken" and "completed", and never takes a request that it would
+ * have no room for the result of.  Only calls that act on files,
+ * pipes or the console -- Create, Open, Read, Write, Close, Pipe,
+ * PutString, PrintInt and Add -- can be made from a ring; any other
+ * code gets the result ENOSYS.
+ */
+
+#define RingSize	16	/* requests, and results, a ring holds */
+
+#define RingPoll	1	/* RingSetup: a kernel thread takes them */
+#define RingAsleep	1	/* flags: and it is asleep, so after
+				 * submitting (or reaping, if the results
+				 * were full), call RingEnter to wake it */
+
+typedef struct {
+    int code;			/* SC_Read, SC_Write, ... */
+    int arg1, arg2, arg3;	/* its arguments */
+    int tag;			/* anything; handed back with the result */
+} RingRequest;
+
+typedef struct {
+    int tag;
+    int result;			/* what the call returned */
+} RingResult;
+
+typedef struct {
+    int submitted;		/* requests put in, by the program, */
+    int taken;			/* and taken out, by the kernel */
+    int completed;		/* results put in, by the kernel, */
+    int reaped;			/* and taken out, by the program */
+    int flags;			/* set by the kernel: RingAsleep */
+    RingRequest requests[RingSize];
+    RingResult results[RingSize];
+} CallRing;
+
+/* Have the kernel make the calls queued in "ring" from now on; with
+ * "flags" RingPoll, without being asked.  A program has one ring at
+ * most, which it must have zeroed.
+ * Return 0 on success, negative error code on failure
+ */
+int RingSetup(CallRing *ring, int flags);
+
+/* Make the calls queued in the ring, as many as there is room for the
+ * results of -- or, with RingPoll, wake the kernel thread if it is
+ * asleep -- and wait until at least "minResults" results are there to
+ * be taken, or every request queued is done.
+ * Return how many results there are to take
+ */
+int RingEnter(int minResults);
+
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
  * threads to run within a user program. 
@@ -0,0 +1,303 @@
+// syscallring.cc
+//	Routines for the kernel's side of a program's ring of system
+//	calls.  See syscallring.h, and CallRing in syscall.h.
+//
+//	The ring is read and written a word at a time, through the
+//	address space (see AddrSpace::Pin), as the program laid it out.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "syscallring.h"
+#include "addrspace.h"
+#include "main.h"
+#include "syscall.h"
+
+// Where each of CallRing's fields is, in words from its start.
+
+const int SubmittedWord = 0;
+const int TakenWord = 1;
+const int CompletedWord = 2;
+const int ReapedWord = 3;
+const int FlagsWord = 4;
+const int RequestWords = 5;		// in a RingRequest: code, the three
+					// arguments, and the tag
+const int FirstRequestWord = 5;
+const int FirstResultWord = FirstRequestWord + RingSize * RequestWords;
+
+//----------------------------------------------------------------------
+// SyscallRing::SyscallRing
+// 	Take over the ring at "ringAddr" in "ringSpace", empty, and start
+//	the kernel thread, if "polled".  SysRingSetup has checked the
+//	ring is all in the address space.
+//----------------------------------------------------------------------
+
+SyscallRing::SyscallRing(AddrSpace *ringSpace, int ringAddr, bool polled)
+{
+    space = ringSpace;
+    address = ringAddr;
+    taken = completed = 0;
+    broken = FALSE;
+    lock = new Lock("syscall ring");
+    requested = new Condition("ring requested");
+    posted = new Condition("ring posted");
+    stopped = new Condition("ring stopped");
+    asleep = waiting = stopping = FALSE;
+    for (int i = TakenWord; i <= FlagsWord; i++) {
+        (void) WriteWord(i, 0);
+    }
+    poller = NULL;
+    if (polled) {
+        poller = new Thread("ring poller", kernel->threads->NewID());
+        poller->Fork((VoidFunctionPtr) &SyscallRing::PollRing, (void *) this);
+    }
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::~SyscallRing
+// 	Deallocate the kernel's side of the ring; the kernel thread has
+//	stopped by now (see Stop).
+//----------------------------------------------------------------------
+
+SyscallRing::~SyscallRing()
+{
+    ASSERT(poller == NULL);
+    delete lock;
+    delete requested;
+    delete posted;
+    delete stopped;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::Enter
+// 	The program called RingEnter.  Make the calls queued, or have
+//	the kernel thread make them; then wait until there are at least
+//	"minResults" results to take, or every request is done, and
+//	return how many results there are.
+//----------------------------------------------------------------------
+
+int
+SyscallRing::Enter(int minResults)
+{
+    int submitted, reaped;
+
+    if (poller == NULL) {
+        (void) Take();
+    } else {
+        lock->Acquire();
+        if (asleep) {
+            requested->Signal(lock);
+        }
+        while (!broken && ReadWord(SubmittedWord, &submitted)
+                 && ReadWord(ReapedWord, &reaped)
+                 && submitted != completed
+                 && completed - reaped < minResults
+                 && completed - reaped < RingSize) {
+            waiting = TRUE;
+            posted->Wait(lock);
+        }
+        waiting = FALSE;
+        lock->Release();
+    }
+    if (broken || !ReadWord(ReapedWord, &reaped)) {
+        return EFAULT;
+    }
+    return completed - reaped;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::Stop
+// 	The program is exiting.  Wait until the kernel thread, if there
+//	is one, is done with its address space; it finishes.
+//----------------------------------------------------------------------
+
+void
+SyscallRing::Stop()
+{
+    lock->Acquire();
+    stopping = TRUE;
+    if (asleep) {
+        requested->Signal(lock);
+    }
+    while (poller != NULL) {
+        stopped->Wait(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::Take
+// 	Make the calls queued in the ring, one after another, each as
+//	soon as there is room for its result, and put the results in.
+//	Return how many were made.  If the counts the program keeps
+//	make no sense, or the ring isn't in its memory any more, the
+//	ring is broken, and no more are taken.
+//----------------------------------------------------------------------
+
+int
+SyscallRing::Take()
+{
+    int numTaken = 0;
+
+    while (!broken) {
+        int submitted, reaped, result;
+        int request[RequestWords];
+        int first, slot;
+        bool ok;
+
+        if (!ReadWord(SubmittedWord, &submitted)
+              || !ReadWord(ReapedWord, &reaped)
+              || submitted - taken < 0 || submitted - taken > RingSize
+              || completed - reaped < 0 || completed - reaped > RingSize) {
+            broken = TRUE;
+            DEBUG(dbgSys, "Ring at " << address << " broken");
+            break;
+        }
+        if (submitted == taken || completed - reaped == RingSize) {
+            break;			// nothing to do, or no room
+        }
+        first = FirstRequestWord + (taken % RingSize) * RequestWords;
+        ok = TRUE;
+        for (int i = 0; i < RequestWords && ok; i++) {
+            ok = ReadWord(first + i, &request[i]);
+        }
+        if (!ok || !WriteWord(TakenWord, ++taken)) {
+            broken = TRUE;
+            break;
+        }
+
+        DEBUG(dbgSys, "Ring call " << request[0] << ", tag " << request[4]);
+        result = RingSyscall(request[0], request[1], request[2], request[3]);
+
+        slot = FirstResultWord + (completed % RingSize) * 2;
+        if (!WriteWord(slot, request[4]) || !WriteWord(slot + 1, result)
+              || !WriteWord(CompletedWord, ++completed)) {
+            broken = TRUE;
+            break;
+        }
+        numTaken++;
+        if (poller != NULL) {		// the program may be waiting
+            lock->Acquire();
+            if (waiting) {
+                posted->Signal(lock);
+            }
+            lock->Release();
+        }
+    }
+    return numTaken;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::Pending
+// 	Return TRUE if the program has queued requests not yet taken,
+//	and taken enough results that there is room for another.
+//----------------------------------------------------------------------
+
+bool
+SyscallRing::Pending()
+{
+    int submitted, reaped;
+
+    return !broken && ReadWord(SubmittedWord, &submitted)
+           && ReadWord(ReapedWord, &reaped)
+           && submitted != taken && completed - reaped < RingSize;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::ReadWord, WriteWord
+// 	Read or write the "index"th word of the ring, in the program's
+//	memory.  Return FALSE if it isn't there.
+//----------------------------------------------------------------------
+
+bool
+SyscallRing::ReadWord(int index, int *value)
+{
+    int length;
+    char *span = space->Pin(address + index * sizeof(int), sizeof(int),
+                            FALSE, &length);
+
+    if (span == NULL) {
+        return FALSE;
+    }
+    *value = (int) WordToHost(*(unsigned int *) span);
+    space->Unpin(span, length);
+    return TRUE;
+}
+
+bool
+SyscallRing::WriteWord(int index, int value)
+{
+    int length;
+    char *span = space->Pin(address + index * sizeof(int), sizeof(int),
+                            TRUE, &length);
+
+    if (span == NULL) {
+        return FALSE;
+    }
+    *(unsigned int *) span = WordToMachine((unsigned int) value);
+    space->Unpin(span, length);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::PollRing
+// 	The kernel thread starts here.
+//----------------------------------------------------------------------
+
+void
+SyscallRing::PollRing(SyscallRing *ring)
+{
+    ring->Poll();
+}
+
+//----------------------------------------------------------------------
+// SyscallRing::Poll
+// 	Make the calls queued, as the program's thread would, every
+//	RingPollTicks; after RingIdlePolls times in a row with nothing
+//	to do, set RingAsleep, and wait for RingEnter.  Finish once the
+//	program is exiting.
+//----------------------------------------------------------------------
+
+void
+SyscallRing::Poll()
+{
+    Thread *thread = kernel->currentThread;
+    int numIdle = 0;
+
+    lock->Acquire();
+    while (!stopping) {
+        int numTaken;
+
+        lock->Release();
+        thread->space = space;		// the calls act on the program's
+        numTaken = Take();		// files, and memory
+        thread->space = NULL;
+        lock->Acquire();
+        if (waiting && broken) {
+            posted->Signal(lock);
+        }
+        if (stopping || numTaken > 0) {
+            numIdle = 0;
+            continue;
+        }
+        if (++numIdle < RingIdlePolls) {
+            lock->Release();
+            kernel->currentCPU->alarm->WaitUntil(RingPollTicks);
+            lock->Acquire();
+            continue;
+        }
+        asleep = TRUE;			// the program must wake us;
+        (void) WriteWord(FlagsWord, RingAsleep);
+        if (!Pending()) {		// unless it queued more already
+            requested->Wait(lock);
+        }
+        asleep = FALSE;
+        (void) WriteWord(FlagsWord, 0);
+        numIdle = 0;
+    }
+    poller = NULL;
+    stopped->Signal(lock);
+    lock->Release();
+}
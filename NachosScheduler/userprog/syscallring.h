@@ -0,0 +1,74 @@
+// syscallring.h
+//	Data structures for the kernel's side of a program's ring of
+//	system calls (see CallRing, in syscall.h): requests the program
+//	queues in its own memory, for the kernel to make in a batch.
+//
+//	With RingEnter, the program's thread makes every call queued
+//	for one trap, instead of one trap each.  With RingPoll, a kernel
+//	thread makes them, without being asked: every RingPollTicks it
+//	looks at the ring, and after RingIdlePolls looks that find
+//	nothing, it says so in the ring's flags and sleeps until the
+//	program's next RingEnter.  It makes the calls as though it were
+//	the program's thread, in the program's address space.
+//
+//	The counts the kernel puts in the ring ("taken", "completed")
+//	are kept here too; the ones the program puts there are only
+//	read, and a ring whose counts make no sense is not used.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYSCALLRING_H
+#define SYSCALLRING_H
+
+#include "copyright.h"
+#include "synch.h"
+
+class AddrSpace;
+
+const int RingPollTicks = 100;	// how often the kernel thread looks
+const int RingIdlePolls = 8;	// looks that find nothing before it
+				// goes to sleep
+
+// The following class defines the kernel's side of a program's ring.
+
+class SyscallRing {
+  public:
+    SyscallRing(AddrSpace *ringSpace, int ringAddr, bool polled);
+				// the ring at "ringAddr" in "ringSpace",
+				// which has been checked; start the
+				// kernel thread, if "polled"
+    ~SyscallRing();
+
+    int Enter(int minResults);	// RingEnter
+    void Stop();		// the program is exiting: wait for the
+				// kernel thread to be done with it
+
+  private:
+    AddrSpace *space;		// the program's address space,
+    int address;		// and where the ring is in it
+    int taken;			// requests taken out of the ring,
+    int completed;		// and results put in
+    bool broken;		// the ring stopped making sense
+
+    Thread *poller;		// the kernel thread, or NULL
+    Lock *lock;			// for the following:
+    Condition *requested;	// the kernel thread waits here, asleep,
+    Condition *posted;		// the program for results, and
+    Condition *stopped;		// for the kernel thread to finish
+    bool asleep;		// the kernel thread is waiting
+    bool waiting;		// the program is waiting
+    bool stopping;		// the program is exiting
+
+    int Take();			// make the calls queued; return how many
+    bool Pending();		// are there requests it can take?
+    bool ReadWord(int index, int *value);
+    bool WriteWord(int index, int value);
+				// the "index"th word of the ring
+
+    void Poll();		// what the kernel thread does
+    static void PollRing(SyscallRing *ring);
+};
+
+#endif // SYSCALLRING_H
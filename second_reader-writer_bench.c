@@ -0,0 +1,408 @@
+/* compiler arguments -pthread -lrt -std=gnu99 -O2 */
+/*
+ * Benchmark for reader-writer locking on host threads.
+ *
+ * Runs the writer-preference ("second readers-writers") algorithm of
+ * second_reader-writer_mutex.c and second_reader-writer_semaphore.c,
+ * built on pthread mutexes and on POSIX semaphores, and pthread_rwlock,
+ * for a fixed time each, and reports per role (reader, writer) the
+ * throughput and the time taken to acquire the lock.
+ *
+ * usage: second_reader-writer_bench [options]
+ *     -r N       reader threads (4)
+ *     -w N       writer threads (2)
+ *     -m N       mixed threads, choosing each operation by -x (0)
+ *     -x R:W     read:write ratio for mixed threads (9:1)
+ *     -c usec    read critical section length (20)
+ *     -C usec    write critical section length (20)
+ *     -z usec    work between operations, outside the lock (20)
+ *     -d sec     how long to run each variant (2)
+ *     -v list    variants to run: mutex,semaphore,rwlock (all)
+ *
+ * Critical sections and the work between them spin on the clock, so
+ * that their lengths are exact.  Readers check that no writer is
+ * inside while they are, and writers that nobody else is; violations
+ * are reported.
+ *
+ * Note the mutex variant, like second_reader-writer_mutex.c, unlocks
+ * mutexes from threads other than the one that locked them, which
+ * works with Linux's default mutexes but isn't portable.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#define MAX_THREADS 256
+#define NSEC        1000000000L
+
+enum role { READER, WRITER, NUM_ROLES };
+static const char *role_names[NUM_ROLES] = { "reader", "writer" };
+
+/* ---- the locks being compared ---- */
+
+struct rw_variant {
+    const char *name;
+    void (*init)(void);
+    void (*read_lock)(void);
+    void (*read_unlock)(void);
+    void (*write_lock)(void);
+    void (*write_unlock)(void);
+    void (*destroy)(void);
+};
+
+/*
+ * The writer-preference algorithm, over any binary semaphore: "r" is
+ * held while writers are waiting, to keep new readers out; "w" is
+ * held by the writer inside, or by the readers as a group.
+ */
+struct second_rw {
+    int readercount, writercount;
+    void *rdcnt, *wrcnt, *mutex, *r, *w;
+    void (*wait)(void *);
+    void (*signal)(void *);
+};
+
+static struct second_rw srw;
+
+static void second_write_lock(void)
+{
+    srw.wait(srw.wrcnt);
+    srw.writercount++;
+    if (srw.writercount == 1)
+        srw.wait(srw.r);
+    srw.signal(srw.wrcnt);
+
+    srw.wait(srw.w);
+}
+
+static void second_write_unlock(void)
+{
+    srw.signal(srw.w);
+
+    srw.wait(srw.wrcnt);
+    srw.writercount--;
+    if (srw.writercount == 0)
+        srw.signal(srw.r);
+    srw.signal(srw.wrcnt);
+}
+
+static void second_read_lock(void)
+{
+    srw.wait(srw.mutex);
+        srw.wait(srw.r);
+            srw.wait(srw.rdcnt);
+            srw.readercount++;
+            if (srw.readercount == 1)
+                srw.wait(srw.w);
+            srw.signal(srw.rdcnt);
+        srw.signal(srw.r);
+    srw.signal(srw.mutex);
+}
+
+static void second_read_unlock(void)
+{
+    srw.wait(srw.rdcnt);
+    srw.readercount--;
+    if (srw.readercount == 0)
+        srw.signal(srw.w);
+    srw.signal(srw.rdcnt);
+}
+
+/* with pthread mutexes, as second_reader-writer_mutex.c */
+
+static pthread_mutex_t mutexes[5];
+
+static void mutex_wait(void *m)   { pthread_mutex_lock(m); }
+static void mutex_signal(void *m) { pthread_mutex_unlock(m); }
+
+static void mutex_init(void)
+{
+    for (int i = 0; i < 5; i++)
+        pthread_mutex_init(&mutexes[i], NULL);
+    srw = (struct second_rw) { 0, 0, &mutexes[0], &mutexes[1], &mutexes[2],
+                               &mutexes[3], &mutexes[4],
+                               mutex_wait, mutex_signal };
+}
+
+static void mutex_destroy(void)
+{
+    for (int i = 0; i < 5; i++)
+        pthread_mutex_destroy(&mutexes[i]);
+}
+
+/* with POSIX semaphores, as second_reader-writer_semaphore.c */
+
+static sem_t sems[5];
+
+static void sem_wait_(void *s)   { while (sem_wait(s) != 0) ; }
+static void sem_signal_(void *s) { sem_post(s); }
+
+static void semaphore_init(void)
+{
+    for (int i = 0; i < 5; i++)
+        sem_init(&sems[i], 0, 1);
+    srw = (struct second_rw) { 0, 0, &sems[0], &sems[1], &sems[2],
+                               &sems[3], &sems[4],
+                               sem_wait_, sem_signal_ };
+}
+
+static void semaphore_destroy(void)
+{
+    for (int i = 0; i < 5; i++)
+        sem_destroy(&sems[i]);
+}
+
+/* pthread_rwlock, preferring writers like the others */
+
+static pthread_rwlock_t rwlock;
+
+static void rwlock_init(void)
+{
+    pthread_rwlockattr_t attr;
+
+    pthread_rwlockattr_init(&attr);
+#ifdef PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP
+    pthread_rwlockattr_setkind_np(&attr,
+                                  PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&rwlock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+
+static void rwlock_read_lock(void)    { pthread_rwlock_rdlock(&rwlock); }
+static void rwlock_write_lock(void)   { pthread_rwlock_wrlock(&rwlock); }
+static void rwlock_unlock(void)       { pthread_rwlock_unlock(&rwlock); }
+static void rwlock_destroy(void)      { pthread_rwlock_destroy(&rwlock); }
+
+static struct rw_variant variants[] = {
+    { "mutex", mutex_init, second_read_lock, second_read_unlock,
+      second_write_lock, second_write_unlock, mutex_destroy },
+    { "semaphore", semaphore_init, second_read_lock, second_read_unlock,
+      second_write_lock, second_write_unlock, semaphore_destroy },
+    { "rwlock", rwlock_init, rwlock_read_lock, rwlock_unlock,
+      rwlock_write_lock, rwlock_unlock, rwlock_destroy },
+};
+#define NUM_VARIANTS (int) (sizeof(variants) / sizeof(variants[0]))
+
+/* ---- the workload ---- */
+
+struct config {
+    int readers, writers, mixed;
+    int read_ratio, write_ratio;
+    long read_ns, write_ns, think_ns;
+    int seconds;
+};
+
+static struct config cfg = { 4, 2, 0, 9, 1, 20000, 20000, 20000, 2 };
+
+/* acquisition latencies of one thread, in nanoseconds */
+struct samples {
+    long *ns;
+    long count, size;
+};
+
+struct worker {
+    pthread_t thread;
+    int mixed;                  /* choose each operation by ratio? */
+    enum role role;             /* otherwise, always this */
+    unsigned int seed;
+    struct rw_variant *variant;
+    struct samples lat[NUM_ROLES];
+};
+
+static volatile int stop;
+static int inside_readers, inside_writers;      /* for the checks */
+static long violations;
+
+static long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NSEC + ts.tv_nsec;
+}
+
+static void spin(long ns)
+{
+    long until = now_ns() + ns;
+
+    while (now_ns() < until)
+        ;
+}
+
+static void record(struct samples *s, long ns)
+{
+    if (s->count == s->size) {
+        s->size = s->size ? 2 * s->size : 4096;
+        s->ns = realloc(s->ns, s->size * sizeof(long));
+        if (s->ns == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    s->ns[s->count++] = ns;
+}
+
+static void *work(void *arg)
+{
+    struct worker *me = arg;
+    struct rw_variant *v = me->variant;
+
+    while (!__atomic_load_n(&stop, __ATOMIC_RELAXED)) {
+        enum role role = me->role;
+        long start;
+
+        if (me->mixed)
+            role = (rand_r(&me->seed) % (cfg.read_ratio + cfg.write_ratio)
+                    < cfg.read_ratio) ? READER : WRITER;
+
+        start = now_ns();
+        if (role == READER) {
+            v->read_lock();
+            record(&me->lat[READER], now_ns() - start);
+            __atomic_add_fetch(&inside_readers, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&inside_writers, __ATOMIC_SEQ_CST) != 0)
+                __atomic_add_fetch(&violations, 1, __ATOMIC_RELAXED);
+            spin(cfg.read_ns);
+            __atomic_sub_fetch(&inside_readers, 1, __ATOMIC_SEQ_CST);
+            v->read_unlock();
+        } else {
+            v->write_lock();
+            record(&me->lat[WRITER], now_ns() - start);
+            if (__atomic_add_fetch(&inside_writers, 1, __ATOMIC_SEQ_CST) != 1
+                  || __atomic_load_n(&inside_readers, __ATOMIC_SEQ_CST) != 0)
+                __atomic_add_fetch(&violations, 1, __ATOMIC_RELAXED);
+            spin(cfg.write_ns);
+            __atomic_sub_fetch(&inside_writers, 1, __ATOMIC_SEQ_CST);
+            v->write_unlock();
+        }
+        spin(cfg.think_ns);
+    }
+    return NULL;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *) a, y = *(const long *) b;
+
+    return (x > y) - (x < y);
+}
+
+static double percentile(long *sorted, long n, double p)
+{
+    long i = (long) (p * (n - 1) + 0.5);
+
+    return sorted[i] / 1000.0;
+}
+
+static void run(struct rw_variant *v)
+{
+    static struct worker workers[MAX_THREADS];
+    int n = cfg.readers + cfg.writers + cfg.mixed;
+    long elapsed;
+
+    stop = 0;
+    violations = 0;
+    v->init();
+    for (int i = 0; i < n; i++) {
+        struct worker *w = &workers[i];
+
+        memset(w, 0, sizeof(*w));
+        w->variant = v;
+        w->seed = i + 1;
+        w->mixed = (i >= cfg.readers + cfg.writers);
+        w->role = (i < cfg.readers) ? READER : WRITER;
+    }
+    elapsed = now_ns();
+    for (int i = 0; i < n; i++)
+        pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+    sleep(cfg.seconds);
+    __atomic_store_n(&stop, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < n; i++)
+        pthread_join(workers[i].thread, NULL);
+    elapsed = now_ns() - elapsed;
+    v->destroy();
+
+    for (int r = 0; r < NUM_ROLES; r++) {
+        long total = 0, k = 0, *all;
+
+        for (int i = 0; i < n; i++)
+            total += workers[i].lat[r].count;
+        if (total == 0)
+            continue;
+        all = malloc(total * sizeof(long));
+        for (int i = 0; i < n; i++) {
+            memcpy(all + k, workers[i].lat[r].ns,
+                   workers[i].lat[r].count * sizeof(long));
+            k += workers[i].lat[r].count;
+        }
+        qsort(all, total, sizeof(long), compare_long);
+        printf("%-10s %-7s %10.0f ops/s   acquire us: p50 %9.1f  p99 %9.1f"
+               "  max %9.1f\n", v->name, role_names[r],
+               total / ((double) elapsed / NSEC),
+               percentile(all, total, 0.50), percentile(all, total, 0.99),
+               all[total - 1] / 1000.0);
+        free(all);
+    }
+    if (violations != 0)
+        printf("%-10s %ld times, a reader and a writer, or two writers, "
+               "were inside together!\n", v->name, violations);
+    for (int i = 0; i < n; i++)
+        for (int r = 0; r < NUM_ROLES; r++)
+            free(workers[i].lat[r].ns);
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-r readers] [-w writers] [-m mixed] "
+            "[-x read:write] [-c read-usec] [-C write-usec] "
+            "[-z think-usec] [-d seconds] [-v mutex,semaphore,rwlock]\n",
+            prog);
+    exit(1);
+}
+
+int main (int argc, char *argv[])
+{
+    char *which = "mutex,semaphore,rwlock";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:w:m:x:c:C:z:d:v:")) != -1) {
+        switch (opt) {
+        case 'r': cfg.readers = atoi(optarg); break;
+        case 'w': cfg.writers = atoi(optarg); break;
+        case 'm': cfg.mixed = atoi(optarg); break;
+        case 'x':
+            if (sscanf(optarg, "%d:%d", &cfg.read_ratio, &cfg.write_ratio) != 2
+                  || cfg.read_ratio < 0 || cfg.write_ratio < 0
+                  || cfg.read_ratio + cfg.write_ratio == 0)
+                usage(argv[0]);
+            break;
+        case 'c': cfg.read_ns = atol(optarg) * 1000; break;
+        case 'C': cfg.write_ns = atol(optarg) * 1000; break;
+        case 'z': cfg.think_ns = atol(optarg) * 1000; break;
+        case 'd': cfg.seconds = atoi(optarg); break;
+        case 'v': which = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+    if (cfg.readers < 0 || cfg.writers < 0 || cfg.mixed < 0
+          || cfg.readers + cfg.writers + cfg.mixed == 0
+          || cfg.readers + cfg.writers + cfg.mixed > MAX_THREADS
+          || cfg.seconds <= 0)
+        usage(argv[0]);
+
+    printf("%d readers, %d writers, %d mixed (%d:%d); critical sections "
+           "%ld/%ld us, think %ld us, %d s each\n",
+           cfg.readers, cfg.writers, cfg.mixed, cfg.read_ratio,
+           cfg.write_ratio, cfg.read_ns / 1000, cfg.write_ns / 1000,
+           cfg.think_ns / 1000, cfg.seconds);
+    for (int i = 0; i < NUM_VARIANTS; i++)
+        if (strstr(which, variants[i].name) != NULL)
+            run(&variants[i]);
+    return 0;
+}